@@ -139,6 +139,30 @@ struct ServiceList
    */
   char *config;
 
+  /**
+   * Quoted path to the resolved binary; computed on the first start
+   * and reused across restarts.  NULL until the first start.
+   */
+  char *quoted_binary;
+
+  /**
+   * Command-line prefix (i.e. valgrind) for the service; cached
+   * together with @e quoted_binary.
+   */
+  char *loprefix;
+
+  /**
+   * Expanded option string for the service; cached together with
+   * @e quoted_binary.
+   */
+  char *options;
+
+  /**
+   * Was DEBUG logging requested for this service?  Cached together
+   * with @e quoted_binary.
+   */
+  int use_debug;
+
   /**
    * Client to notify upon kill completion (waitpid), NULL
    * if we should simply restart the process.
@@ -418,14 +442,12 @@ start_process (struct ServiceList *sl,
   char *optpos;
   char *optend;
   const char *next;
-  int use_debug;
   char b;
   char *val;
   struct ServiceListeningInfo *sli;
   SOCKTYPE *lsocks;
   unsigned int ls;
   char *binary;
-  char *quotedbinary;
 
   /* calculate listen socket list */
   lsocks = NULL;
@@ -446,78 +468,86 @@ start_process (struct ServiceList *sl,
   GNUNET_array_append (lsocks, ls, -1);
 #endif
 
-  /* obtain configuration */
-  if (GNUNET_OK !=
-      GNUNET_CONFIGURATION_get_value_string (cfg, sl->name, "PREFIX",
-					     &loprefix))
-    loprefix = GNUNET_strdup (prefix_command);
-  if (GNUNET_OK !=
-      GNUNET_CONFIGURATION_get_value_string (cfg, sl->name, "OPTIONS",
-					     &options))
+  /* obtain configuration; done only on the first start since the
+     configuration cannot change while ARM is running, so restarts
+     can reuse the cached values */
+  if (NULL == sl->quoted_binary)
     {
-      options = GNUNET_strdup (final_option);
-      if (NULL == strstr (options, "%"))
+      if (GNUNET_OK !=
+	  GNUNET_CONFIGURATION_get_value_string (cfg, sl->name, "PREFIX",
+						 &loprefix))
+	loprefix = GNUNET_strdup (prefix_command);
+      sl->loprefix = loprefix;
+      if (GNUNET_OK !=
+	  GNUNET_CONFIGURATION_get_value_string (cfg, sl->name, "OPTIONS",
+						 &options))
 	{
-	  /* replace '{}' with service name */
-	  while (NULL != (optpos = strstr (options, "{}")))
-	    {
-	      optpos[0] = '%';
-	      optpos[1] = 's';
-	      GNUNET_asprintf (&optpos, options, sl->name);
-	      GNUNET_free (options);
-	      options = optpos;
-	    }
-	  /* replace '$PATH' with value associated with "PATH" */
-	  while (NULL != (optpos = strstr (options, "$")))
+	  options = GNUNET_strdup (final_option);
+	  if (NULL == strstr (options, "%"))
 	    {
-	      optend = optpos + 1;
-	      while (isupper ((unsigned char) *optend))
-		optend++;
-	      b = *optend;
-	      if ('\0' == b)
-		next = "";
-	      else
-		next = optend + 1;
-	      *optend = '\0';
-	      if (GNUNET_OK !=
-		  GNUNET_CONFIGURATION_get_value_string (cfg, "PATHS",
-							 optpos + 1, &val))
-		val = GNUNET_strdup ("");
-	      *optpos = '\0';
-	      GNUNET_asprintf (&optpos, "%s%s%c%s", options, val, b, next);
-	      GNUNET_free (options);
-	      GNUNET_free (val);
-	      options = optpos;
+	      /* replace '{}' with service name */
+	      while (NULL != (optpos = strstr (options, "{}")))
+		{
+		  optpos[0] = '%';
+		  optpos[1] = 's';
+		  GNUNET_asprintf (&optpos, options, sl->name);
+		  GNUNET_free (options);
+		  options = optpos;
+		}
+	      /* replace '$PATH' with value associated with "PATH" */
+	      while (NULL != (optpos = strstr (options, "$")))
+		{
+		  optend = optpos + 1;
+		  while (isupper ((unsigned char) *optend))
+		    optend++;
+		  b = *optend;
+		  if ('\0' == b)
+		    next = "";
+		  else
+		    next = optend + 1;
+		  *optend = '\0';
+		  if (GNUNET_OK !=
+		      GNUNET_CONFIGURATION_get_value_string (cfg, "PATHS",
+							     optpos + 1, &val))
+		    val = GNUNET_strdup ("");
+		  *optpos = '\0';
+		  GNUNET_asprintf (&optpos, "%s%s%c%s", options, val, b, next);
+		  GNUNET_free (options);
+		  GNUNET_free (val);
+		  options = optpos;
+		}
 	    }
 	}
+      sl->options = options;
+      sl->use_debug = GNUNET_CONFIGURATION_get_value_yesno (cfg, sl->name,
+							    "DEBUG");
+      binary = GNUNET_OS_get_libexec_binary_path (sl->binary);
+      GNUNET_asprintf (&sl->quoted_binary,
+		       "\"%s\"",
+		       binary);
+      GNUNET_free (binary);
     }
-  use_debug = GNUNET_CONFIGURATION_get_value_yesno (cfg, sl->name, "DEBUG");
 
   /* actually start process */
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
 	      "Starting service `%s' using binary `%s' and configuration `%s'\n",
 	      sl->name, sl->binary, sl->config);
-  binary = GNUNET_OS_get_libexec_binary_path (sl->binary);
-  GNUNET_asprintf (&quotedbinary,
-		   "\"%s\"",
-		   binary);
-
   GNUNET_assert (NULL == sl->proc);
-  if (GNUNET_YES == use_debug)
+  if (GNUNET_YES == sl->use_debug)
   {
     if (NULL == sl->config)
       sl->proc =
 	GNUNET_OS_start_process_s (sl->pipe_control,
                                    GNUNET_OS_INHERIT_STD_OUT_AND_ERR,
-                                   lsocks, loprefix, quotedbinary, "-L",
-                                   "DEBUG", options, NULL);
+                                   lsocks, sl->loprefix, sl->quoted_binary,
+                                   "-L", "DEBUG", sl->options, NULL);
     else
       sl->proc =
           GNUNET_OS_start_process_s (sl->pipe_control,
                                      GNUNET_OS_INHERIT_STD_OUT_AND_ERR,
-                                     lsocks, loprefix, quotedbinary, "-c",
-                                     sl->config, "-L",
-                                     "DEBUG", options, NULL);
+                                     lsocks, sl->loprefix, sl->quoted_binary,
+                                     "-c", sl->config, "-L",
+                                     "DEBUG", sl->options, NULL);
   }
   else
   {
@@ -525,17 +555,15 @@ start_process (struct ServiceList *sl,
       sl->proc =
           GNUNET_OS_start_process_s (sl->pipe_control,
                                      GNUNET_OS_INHERIT_STD_OUT_AND_ERR,
-                                     lsocks, loprefix, quotedbinary,
-                                     options, NULL);
+                                     lsocks, sl->loprefix, sl->quoted_binary,
+                                     sl->options, NULL);
     else
       sl->proc =
           GNUNET_OS_start_process_s (sl->pipe_control,
                                      GNUNET_OS_INHERIT_STD_OUT_AND_ERR,
-                                     lsocks, loprefix, quotedbinary, "-c",
-                                     sl->config, options, NULL);
+                                     lsocks, sl->loprefix, sl->quoted_binary,
+                                     "-c", sl->config, sl->options, NULL);
   }
-  GNUNET_free (binary);
-  GNUNET_free (quotedbinary);
   if (sl->proc == NULL)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
@@ -557,8 +585,6 @@ start_process (struct ServiceList *sl,
       signal_result (client, sl->name, request_id, GNUNET_ARM_RESULT_STARTING);
   }
   /* clean up */
-  GNUNET_free (loprefix);
-  GNUNET_free (options);
   GNUNET_array_grow (lsocks, ls, 0);
 }
 
@@ -738,6 +764,9 @@ free_service (struct ServiceList *sl)
   GNUNET_assert (NULL == sl->listen_head);
   GNUNET_free_non_null (sl->config);
   GNUNET_free_non_null (sl->binary);
+  GNUNET_free_non_null (sl->quoted_binary);
+  GNUNET_free_non_null (sl->loprefix);
+  GNUNET_free_non_null (sl->options);
   GNUNET_free (sl->name);
   GNUNET_free (sl);
 }
@@ -33,6 +33,14 @@
 
 #define LOG(kind,...) GNUNET_log_from (kind, "ats-normalization",__VA_ARGS__)
 
+/**
+ * How many property updates we perform at most before rescanning the
+ * full address set for the exact property ranges.  The range is grown
+ * incrementally in O(1) per update; the periodic scan is only needed
+ * so that the range can shrink again once extreme values disappear.
+ */
+#define RANGE_RESCAN_FREQUENCY 256
+
 
 /**
  * Range information for normalization of quality properties.
@@ -56,6 +64,12 @@ struct PropertyRange
  */
 static struct PropertyRange property_range;
 
+/**
+ * Number of updates the current #property_range was grown
+ * incrementally without an exact recomputation.
+ */
+static unsigned int range_update_count;
+
 
 /**
  * Add the value from @a atsi to the running average of the
@@ -246,10 +260,24 @@ GAS_normalization_update_property (struct ATS_Address *address)
   update_avg (prop->utilization_in,
               &address->norm_utilization_out);
 
-  init_range (&range);
-  GNUNET_CONTAINER_multipeermap_iterate (GSA_addresses,
-                                         &find_min_max_it,
-                                         &range);
+  if (range_update_count++ >= RANGE_RESCAN_FREQUENCY)
+  {
+    /* periodically recompute the exact range, so that it can
+       shrink again after extreme values have disappeared */
+    range_update_count = 0;
+    init_range (&range);
+    GNUNET_CONTAINER_multipeermap_iterate (GSA_addresses,
+                                           &find_min_max_it,
+                                           &range);
+  }
+  else
+  {
+    /* grow the known range to cover the new values in O(1) */
+    range = property_range;
+    find_min_max_it (&range,
+                     &address->peer,
+                     address);
+  }
   if (0 != memcmp (&range,
                    &property_range,
                    sizeof (struct PropertyRange)))
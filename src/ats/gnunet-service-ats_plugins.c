@@ -50,6 +50,17 @@ static struct GNUNET_ATS_PluginEnvironment env;
  */
 static char *plugin;
 
+/**
+ * Task to release the solver lock at the end of the
+ * current scheduler pass, batching event bursts.
+ */
+static struct GNUNET_SCHEDULER_Task *unlock_task;
+
+/**
+ * Number of unlock operations we have deferred to the #unlock_task.
+ */
+static unsigned int pending_unlocks;
+
 
 /**
  * The preference changed for a peer, update solver.
@@ -463,6 +474,16 @@ GAS_plugin_init (const struct GNUNET_CONFIGURATION_Handle *cfg)
 void
 GAS_plugin_done ()
 {
+  if (NULL != unlock_task)
+  {
+    GNUNET_SCHEDULER_cancel (unlock_task);
+    unlock_task = NULL;
+  }
+  while (0 < pending_unlocks)
+  {
+    pending_unlocks--;
+    sf->s_bulk_stop (sf->cls);
+  }
   GNUNET_PLUGIN_unload (plugin,
                         sf);
   sf = NULL;
@@ -526,6 +547,27 @@ GAS_plugin_notify_feedback (struct GNUNET_SERVER_Client *application,
 }
 
 
+/**
+ * Task run at the end of the current scheduler pass to
+ * release all deferred solver unlocks in one go, so that a
+ * burst of transport events results in a single solver run.
+ *
+ * @param cls NULL
+ * @param tc scheduler context
+ */
+static void
+unlock_solver_task (void *cls,
+                    const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  unlock_task = NULL;
+  while (0 < pending_unlocks)
+  {
+    pending_unlocks--;
+    sf->s_bulk_stop (sf->cls);
+  }
+}
+
+
 /**
  * Stop instant solving, there are many state updates
  * happening in bulk right now.
@@ -533,17 +575,30 @@ GAS_plugin_notify_feedback (struct GNUNET_SERVER_Client *application,
 void
 GAS_plugin_solver_lock ()
 {
+  if (0 < pending_unlocks)
+  {
+    /* the solver is still locked from an earlier update in
+       this event burst; consume one of the deferred unlocks
+       instead of locking again */
+    pending_unlocks--;
+    return;
+  }
   sf->s_bulk_start (sf->cls);
 }
 
 
 /**
  * Resume instant solving, we are done with the bulk state updates.
+ * The actual unlock is deferred to the end of the current scheduler
+ * pass, so that bursts of updates are solved only once.
  */
 void
 GAS_plugin_solver_unlock ()
 {
-  sf->s_bulk_stop (sf->cls);
+  pending_unlocks++;
+  if (NULL == unlock_task)
+    unlock_task = GNUNET_SCHEDULER_add_now (&unlock_solver_task,
+                                            NULL);
 }
 
 
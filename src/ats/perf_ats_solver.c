@@ -32,7 +32,6 @@
 #include "gnunet-service-ats_preferences.h"
 #include "gnunet_ats_service.h"
 #include "gnunet_ats_plugin.h"
-#include "test_ats_api_common.h"
 
 #define DEFAULT_UPDATE_PERCENTAGE       20
 #define DEFAULT_PEERS_START     10
@@ -46,6 +45,12 @@
  */
 struct GNUNET_STATISTICS_Handle *GSA_stats;
 
+/**
+ * Hashmap with all addresses, used by the normalization code
+ * we link against in place of the full service.
+ */
+struct GNUNET_CONTAINER_MultiPeerMap *GSA_addresses;
+
 /**
  * Handle for ATS address component
  */
@@ -313,6 +318,69 @@ static struct PerfHandle ph;
 static int ret;
 
 
+/**
+ * The preference changed for a peer, update solver.
+ * Glue normally provided by gnunet-service-ats_plugins.c,
+ * here forwarding directly to the solver under test.
+ *
+ * @param peer the peer
+ * @param kind the ATS kind
+ * @param pref_rel the new relative preference value
+ */
+void
+GAS_plugin_notify_preference_changed (const struct GNUNET_PeerIdentity *peer,
+                                      enum GNUNET_ATS_PreferenceKind kind,
+                                      double pref_rel)
+{
+  if (NULL == ph.sf)
+    return;
+  ph.sf->s_pref (ph.sf->cls,
+                 peer,
+                 kind,
+                 pref_rel);
+}
+
+
+/**
+ * The relative value for a property changed.
+ *
+ * @param address the address for which a property changed
+ */
+void
+GAS_plugin_notify_property_changed (struct ATS_Address *address)
+{
+  if (NULL == ph.sf)
+    return;
+  ph.sf->s_address_update_property (ph.sf->cls,
+                                    address);
+}
+
+
+/**
+ * Stop instant solving, there are many state updates
+ * happening in bulk right now.
+ */
+void
+GAS_plugin_solver_lock ()
+{
+  if (NULL == ph.sf)
+    return;
+  ph.sf->s_bulk_start (ph.sf->cls);
+}
+
+
+/**
+ * Resume instant solving, we are done with the bulk state updates.
+ */
+void
+GAS_plugin_solver_unlock ()
+{
+  if (NULL == ph.sf)
+    return;
+  ph.sf->s_bulk_stop (ph.sf->cls);
+}
+
+
 /**
  * Do shutdown
  */
@@ -359,40 +427,30 @@ static void
 perf_update_address (struct ATS_Address *cur)
 {
   int r_type;
-  int abs_val;
-  double rel_val;
+  unsigned int val;
 
   r_type = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, 2);
   switch (r_type)
   {
   case 0:
-    abs_val = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, 100);
-    rel_val = (100 + (double) abs_val) / 100;
-
+    val = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, 100);
     GNUNET_log(GNUNET_ERROR_TYPE_INFO,
-        "Updating peer `%s' address %p type %s abs val %u rel val %.3f\n",
-        GNUNET_i2s (&cur->peer), cur,
-        "GNUNET_ATS_QUALITY_NET_DELAY",
-        abs_val, rel_val);
-    ph.sf->s_address_update_property (ph.sf->cls, cur,
-        GNUNET_ATS_QUALITY_NET_DELAY,
-        abs_val, rel_val);
+        "Updating peer `%s' address %p: delay %u ms\n",
+        GNUNET_i2s (&cur->peer), cur, val);
+    cur->properties.delay = GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MILLISECONDS,
+                                                           val);
     break;
   case 1:
-    abs_val = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, 10);
-    rel_val = (100 + (double) abs_val) / 100;
-
+    val = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, 10);
     GNUNET_log(GNUNET_ERROR_TYPE_INFO,
-        "Updating peer `%s' address %p type %s abs val %u rel val %.3f\n",
-        GNUNET_i2s (&cur->peer), cur, "GNUNET_ATS_QUALITY_NET_DISTANCE",
-        abs_val, rel_val);
-    ph.sf->s_address_update_property (ph.sf->cls, cur,
-        GNUNET_ATS_QUALITY_NET_DISTANCE,
-        abs_val, rel_val);
+        "Updating peer `%s' address %p: distance %u\n",
+        GNUNET_i2s (&cur->peer), cur, val);
+    cur->properties.distance = val;
     break;
   default:
-    break;
+    return;
   }
+  GAS_normalization_update_property (cur);
 }
 
 
@@ -427,23 +485,18 @@ perf_address_initial_update (void *dead,
     struct GNUNET_CONTAINER_MultiPeerMap * addresses,
     struct ATS_Address *address)
 {
-  double delay;
-  double distance;
-  uint32_t random = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, 100);
-  delay = (100 + (double) random) / 100;
-  ph.sf->s_address_update_property (ph.sf->cls,
-                                    address, GNUNET_ATS_QUALITY_NET_DELAY,
-      100,  delay);
-
-  random = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, 100);
-  distance = (100 + (double) random) / 100;
+  uint32_t delay;
+  uint32_t distance;
 
-  ph.sf->s_address_update_property (ph.sf->cls, address,
-                                    GNUNET_ATS_QUALITY_NET_DISTANCE,
-                                    10, distance);
+  delay = 10 + GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, 100);
+  distance = 1 + GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, 10);
+  address->properties.delay = GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MILLISECONDS,
+                                                             delay);
+  address->properties.distance = distance;
+  GAS_normalization_update_property (address);
 
   GNUNET_log(GNUNET_ERROR_TYPE_INFO,
-             "Initial update address %p : %.2f  %.2f\n",
+             "Initial update address %p: delay %u ms, distance %u\n",
              address, delay, distance);
 }
 
@@ -526,6 +579,47 @@ perf_update_all_addresses (unsigned int cp, unsigned int ca, unsigned int percen
   }
 }
 
+/**
+ * Create an #ATS_Address the way the service would, with the
+ * normalization history initialized to 'undefined'.
+ *
+ * @param peer peer
+ * @param plugin_name plugin
+ * @param plugin_addr address
+ * @param plugin_addr_len address length
+ * @param session_id session identifier
+ * @return the ATS_Address
+ */
+static struct ATS_Address *
+create_address (const struct GNUNET_PeerIdentity *peer,
+                const char *plugin_name,
+                const void *plugin_addr,
+                size_t plugin_addr_len,
+                uint32_t session_id)
+{
+  struct ATS_Address *aa;
+  unsigned int c;
+
+  aa = GNUNET_malloc (sizeof (struct ATS_Address) + plugin_addr_len);
+  aa->peer = *peer;
+  aa->addr_len = plugin_addr_len;
+  aa->addr = &aa[1];
+  memcpy (&aa[1],
+          plugin_addr,
+          plugin_addr_len);
+  aa->plugin = GNUNET_strdup (plugin_name);
+  aa->session_id = session_id;
+  for (c = 0; c < GAS_normalization_queue_length; c++)
+  {
+    aa->norm_delay.atsi_abs[c] = UINT64_MAX;
+    aa->norm_distance.atsi_abs[c] = UINT64_MAX;
+    aa->norm_utilization_in.atsi_abs[c] = UINT64_MAX;
+    aa->norm_utilization_out.atsi_abs[c] = UINT64_MAX;
+  }
+  return aa;
+}
+
+
 /**
  * Create an address for a peer
  *
@@ -1070,7 +1164,7 @@ do_delete_address (void *cls,
                                                        pid,
                                                        cur));
   ph.sf->s_del (ph.sf->cls, cur);
-  GNUNET_free_non_null (cur->atsi);
+  GNUNET_free (cur->plugin);
   GNUNET_free (cur);
   return GNUNET_OK;
 }
@@ -1119,10 +1213,7 @@ perf_run_iteration (void)
       /* fprintf (stderr, "Network: %u `%s'\n",
        * mod_net , GNUNET_ATS_print_network_type(mod_net)); */
 
-      cur_addr->atsi = GNUNET_new (struct GNUNET_ATS_Information);
-      cur_addr->atsi_count = 1;
-      cur_addr->atsi[0].type = htonl (GNUNET_ATS_NETWORK_TYPE);
-      cur_addr->atsi[0].value = htonl (net);
+      cur_addr->properties.scope = net;
       ph.sf->s_add (ph.sf->cls, cur_addr, net);
 
       ph.current_a = ca + 1;
@@ -1201,6 +1292,89 @@ perf_run_iteration (void)
 }
 
 
+/**
+ * Load quota value for the given network @a type and @a direction
+ * from the configuration @a cfg.
+ *
+ * @param cfg configuration to parse
+ * @param type network type to parse for
+ * @param direction traffic direction to parse for
+ * @return quota to apply
+ */
+static unsigned long long
+load_quota (const struct GNUNET_CONFIGURATION_Handle *cfg,
+            enum GNUNET_ATS_Network_Type type,
+            const char *direction)
+{
+  char *entry;
+  char *quota_str;
+  unsigned long long ret;
+
+  GNUNET_asprintf (&entry,
+                   "%s_QUOTA_%s",
+                   GNUNET_ATS_print_network_type (type),
+                   direction);
+  ret = GNUNET_ATS_DefaultBandwidth;
+  if (GNUNET_OK ==
+      GNUNET_CONFIGURATION_get_value_string (cfg,
+                                             "ats",
+                                             entry,
+                                             &quota_str))
+  {
+    if (0 == strcmp (quota_str,
+                     GNUNET_ATS_MaxBandwidthString))
+      ret = GNUNET_ATS_MaxBandwidth;
+    else if ( (GNUNET_OK !=
+               GNUNET_STRINGS_fancy_size_to_bytes (quota_str,
+                                                   &ret)) &&
+              (1 != sscanf (quota_str,
+                            "%llu",
+                            &ret)) )
+    {
+      GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                  "Could not load %s quota for network `%s': `%s'\n",
+                  direction,
+                  GNUNET_ATS_print_network_type (type),
+                  quota_str);
+      ret = GNUNET_ATS_DefaultBandwidth;
+    }
+    GNUNET_free (quota_str);
+  }
+  GNUNET_free (entry);
+  return ret;
+}
+
+
+/**
+ * Load quotas for networks from configuration
+ *
+ * @param cfg configuration handle
+ * @param out_dest where to write outbound quotas
+ * @param in_dest where to write inbound quotas
+ * @param dest_length length of inbound and outbound arrays
+ * @return number of networks loaded
+ */
+static unsigned int
+load_quotas (const struct GNUNET_CONFIGURATION_Handle *cfg,
+             unsigned long long *out_dest,
+             unsigned long long *in_dest,
+             int dest_length)
+{
+  unsigned int c;
+
+  for (c = 0; (c < GNUNET_ATS_NetworkTypeCount) && (c < dest_length); c++)
+  {
+    out_dest[c] = load_quota (cfg,
+                              c,
+                              "out");
+    in_dest[c] = load_quota (cfg,
+                             c,
+                             "in");
+  }
+  return c;
+}
+
+
 static void
 run (void *cls, char * const *args, const char *cfgfile,
     const struct GNUNET_CONFIGURATION_Handle *cfg)
@@ -1302,8 +1476,10 @@ run (void *cls, char * const *args, const char *cfgfile,
   /* Load solver */
   ph.env.cfg = solver_cfg;
   ph.stat = GNUNET_STATISTICS_create ("ats", cfg);
+  GSA_stats = ph.stat;
   ph.env.stats = ph.stat;
   ph.addresses = GNUNET_CONTAINER_multipeermap_create (128, GNUNET_NO);
+  GSA_addresses = ph.addresses;
   ph.env.addresses = ph.addresses;
   ph.env.bandwidth_changed_cb = bandwidth_changed_cb;
   ph.env.get_connectivity = &get_connectivity_cb;
@@ -42,6 +42,13 @@
 #define MLP_MAX_EXEC_DURATION   GNUNET_TIME_relative_multiply(GNUNET_TIME_UNIT_SECONDS, 10)
 #define MLP_MAX_ITERATIONS      4096
 
+/**
+ * How long to wait for further address change events before
+ * running the automatic solve; a burst of events within this
+ * window triggers a single solve.
+ */
+#define MLP_DEFAULT_BATCH_DELAY GNUNET_TIME_relative_multiply(GNUNET_TIME_UNIT_MILLISECONDS, 100)
+
 #define MLP_DEFAULT_D 1.0
 #define MLP_DEFAULT_R 1.0
 #define MLP_DEFAULT_U 1.0
@@ -297,6 +304,17 @@ struct GAS_MLP_Handle
    */
   int opt_mlp_auto_solve;
 
+  /**
+   * Task batching automatic solves; NULL if no solve is pending.
+   */
+  struct GNUNET_SCHEDULER_Task *solve_task;
+
+  /**
+   * How long do we wait for further changes before running a
+   * pending automatic solve?
+   */
+  struct GNUNET_TIME_Relative solve_batch_delay;
+
   /**
    * Write all MILP problems to a MPS file
    */
@@ -466,6 +484,10 @@ struct MLP_information
  *      * MLP_MAX_ITERATIONS:
  *        Maximum number of iterations for a MLP solution process (default:
  *        1024)
+ *      * MLP_BATCH_DELAY:
+ *        How long to wait for further address change events before running
+ *        an automatic solve, so event bursts are covered by a single solve
+ *        (default: 100 ms)
  *      * MLP_MIN_CONNECTIONS:
  *        Minimum number of desired connections (default: 4)
  *      * MLP_MIN_BANDWIDTH:
@@ -1562,6 +1584,12 @@ GAS_mlp_solve_problem (void *solver)
       mlp->stat_bulk_requests++;
       return GNUNET_NO;
     }
+  if (NULL != mlp->solve_task)
+    {
+      /* we are solving now, batched solve no longer needed */
+      GNUNET_SCHEDULER_cancel (mlp->solve_task);
+      mlp->solve_task = NULL;
+    }
   notify(mlp, GAS_OP_SOLVE_START, GAS_STAT_SUCCESS,
       (GNUNET_YES == mlp->stat_mlp_prob_changed) ? GAS_INFO_FULL : GAS_INFO_UPDATED);
   start_total = GNUNET_TIME_absolute_get();
@@ -1840,6 +1868,42 @@ GAS_mlp_solve_problem (void *solver)
     return GNUNET_SYSERR;
 }
 
+
+/**
+ * Task running a batched automatic solve.
+ *
+ * @param cls the MLP Handle
+ * @param tc scheduler context (unused)
+ */
+static void
+mlp_solve_task (void *cls,
+                const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct GAS_MLP_Handle *mlp = cls;
+
+  mlp->solve_task = NULL;
+  GAS_mlp_solve_problem (mlp);
+}
+
+
+/**
+ * Request an automatic solve of the problem.  The solve is
+ * deferred by the batching delay, so a burst of address change
+ * events results in a single solve covering all of them.
+ *
+ * @param mlp the MLP Handle
+ */
+static void
+mlp_schedule_solve (struct GAS_MLP_Handle *mlp)
+{
+  if (NULL != mlp->solve_task)
+    return;
+  mlp->solve_task = GNUNET_SCHEDULER_add_delayed (mlp->solve_batch_delay,
+                                                  &mlp_solve_task,
+                                                  mlp);
+}
+
+
 /**
  * Add a single address to the solve
  *
@@ -1887,7 +1951,7 @@ GAS_mlp_address_add (void *solver,
   /* Problem size changed: new address for peer with pending request */
   mlp->stat_mlp_prob_changed = GNUNET_YES;
   if (GNUNET_YES == mlp->opt_mlp_auto_solve)
-    GAS_mlp_solve_problem (solver);
+    mlp_schedule_solve (mlp);
 }
 
 
@@ -1946,7 +2010,7 @@ GAS_mlp_address_property_changed (void *solver,
   {
     mlp->stat_mlp_prob_updated = GNUNET_YES;
     if (GNUNET_YES == mlp->opt_mlp_auto_solve)
-      GAS_mlp_solve_problem (solver);
+      mlp_schedule_solve (mlp);
   }
 
 }
@@ -2124,7 +2188,7 @@ GAS_mlp_address_delete (void *solver,
   mlp->stat_mlp_prob_changed = GNUNET_YES;
   if (GNUNET_YES == mlp->opt_mlp_auto_solve)
   {
-    GAS_mlp_solve_problem (solver);
+    mlp_schedule_solve (mlp);
   }
   if (GNUNET_YES == was_active)
   {
@@ -2209,7 +2273,7 @@ GAS_mlp_stop_get_preferred_address (void *solver,
     mlp->stat_mlp_prob_changed = GNUNET_YES;
     if (GNUNET_YES == mlp->opt_mlp_auto_solve)
     {
-      GAS_mlp_solve_problem (solver);
+      mlp_schedule_solve (mlp);
     }
   }
 }
@@ -2264,7 +2328,7 @@ GAS_mlp_address_change_preference (void *solver,
     /* Problem size changed: new address for peer with pending request */
     mlp->stat_mlp_prob_updated = GNUNET_YES;
     if (GNUNET_YES == mlp->opt_mlp_auto_solve)
-      GAS_mlp_solve_problem (solver);
+      mlp_schedule_solve (mlp);
   }
 }
 
@@ -2324,6 +2388,11 @@ libgnunet_plugin_ats_mlp_done (void *cls)
 
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Shutting down mlp solver\n");
+  if (NULL != mlp->solve_task)
+  {
+    GNUNET_SCHEDULER_cancel (mlp->solve_task);
+    mlp->solve_task = NULL;
+  }
   mlp_delete_problem (mlp);
   GNUNET_CONTAINER_multipeermap_iterate (mlp->requested_peers,
 					 &mlp_free_peers,
@@ -2554,6 +2623,13 @@ libgnunet_plugin_ats_mlp_init (void *cls)
     max_iterations = MLP_MAX_ITERATIONS;
   }
 
+  /* Get batching window for automatic solves */
+  if (GNUNET_OK != GNUNET_CONFIGURATION_get_value_time(env->cfg, "ats",
+      "MLP_BATCH_DELAY", &mlp->solve_batch_delay))
+  {
+    mlp->solve_batch_delay = MLP_DEFAULT_BATCH_DELAY;
+  }
+
   /* Get diversity coefficient from configuration */
   mlp->pv.co_D = MLP_DEFAULT_D;
   if (GNUNET_SYSERR != GNUNET_CONFIGURATION_get_value_float (env->cfg, "ats",
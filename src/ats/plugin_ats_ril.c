@@ -316,6 +316,27 @@ struct RIL_Peer_Agent
    */
   uint32_t bw_out;
 
+  /**
+   * Cached RBF feature block for the address in use; only recomputed
+   * when the inputs it was calculated from have changed
+   */
+  double *rbf_cache;
+
+  /**
+   * Inbound bandwidth the cached RBF feature block was calculated for
+   */
+  uint32_t rbf_cache_bw_in;
+
+  /**
+   * Outbound bandwidth the cached RBF feature block was calculated for
+   */
+  uint32_t rbf_cache_bw_out;
+
+  /**
+   * Maximum bandwidth the cached RBF feature block was calculated for
+   */
+  unsigned long long rbf_cache_max_bw;
+
   /**
    * Flag whether a suggestion has to be issued
    */
@@ -907,30 +928,50 @@ envi_get_state (struct GAS_RIL_Handle *solver, struct RIL_Peer_Agent *agent)
   int m;
   int i;
   int k;
+  int rbf_size;
   unsigned long long max_bw;
 
   state = GNUNET_malloc (sizeof(double) * agent->m);
 
   max_bw = ril_get_max_bw((struct RIL_Scope *) agent->address_inuse->solver_information);
 
-  y[0] = (double) agent->bw_out;
-  y[1] = (double) agent->bw_in;
-
-  m = agent_address_get_index (agent, agent->address_inuse) * (solver->parameters.rbf_divisor+1) * (solver->parameters.rbf_divisor+1);
-  for (i = 0; i <= solver->parameters.rbf_divisor; i++)
+  rbf_size = (solver->parameters.rbf_divisor+1) * (solver->parameters.rbf_divisor+1);
+  if ( (NULL == agent->rbf_cache)
+      || (agent->rbf_cache_bw_in != agent->bw_in)
+      || (agent->rbf_cache_bw_out != agent->bw_out)
+      || (agent->rbf_cache_max_bw != max_bw) )
   {
-    for (k = 0; k <= solver->parameters.rbf_divisor; k++)
+    /* inputs changed, recompute the feature block */
+    if (NULL == agent->rbf_cache)
+      agent->rbf_cache = GNUNET_malloc (sizeof(double) * rbf_size);
+
+    y[0] = (double) agent->bw_out;
+    y[1] = (double) agent->bw_in;
+
+    m = 0;
+    for (i = 0; i <= solver->parameters.rbf_divisor; i++)
     {
-      x[0] = (double) i * (double) max_bw / (double) solver->parameters.rbf_divisor;
-      x[1] = (double) k * (double) max_bw / (double) solver->parameters.rbf_divisor;
-      d[0] = x[0]-y[0];
-      d[1] = x[1]-y[1];
-      sigma = (((double) max_bw / ((double) solver->parameters.rbf_divisor + 1)) * 0.5);
-      f = exp(-((d[0]*d[0] + d[1]*d[1]) / (2 * sigma * sigma)));
-      state[m++] = f;
+      for (k = 0; k <= solver->parameters.rbf_divisor; k++)
+      {
+        x[0] = (double) i * (double) max_bw / (double) solver->parameters.rbf_divisor;
+        x[1] = (double) k * (double) max_bw / (double) solver->parameters.rbf_divisor;
+        d[0] = x[0]-y[0];
+        d[1] = x[1]-y[1];
+        sigma = (((double) max_bw / ((double) solver->parameters.rbf_divisor + 1)) * 0.5);
+        f = exp(-((d[0]*d[0] + d[1]*d[1]) / (2 * sigma * sigma)));
+        agent->rbf_cache[m++] = f;
+      }
     }
+    agent->rbf_cache_bw_in = agent->bw_in;
+    agent->rbf_cache_bw_out = agent->bw_out;
+    agent->rbf_cache_max_bw = max_bw;
   }
 
+  m = agent_address_get_index (agent, agent->address_inuse) * rbf_size;
+  memcpy (&state[m],
+          agent->rbf_cache,
+          sizeof(double) * rbf_size);
+
   return state;
 }
 
@@ -1690,119 +1731,47 @@ ril_calculate_discount (struct GAS_RIL_Handle *solver)
 }
 
 /**
- * Count the number of active agents/connections in a network scope
+ * Retrieves the state of the network scopes, so that their attributes are up-
+ * to-date.  All bandwidth sums and agent counts are aggregated in a single
+ * pass over the agent list, instead of one pass per scope and attribute.
  *
  * @param solver the solver handle
- * @param scope the network scope in question
- * @return the number of allocated connections
  */
-static int
-ril_network_count_active_agents (struct GAS_RIL_Handle *solver, struct RIL_Scope *scope)
-{
-  int c = 0;
-  struct RIL_Peer_Agent *cur_agent;
-
-  for (cur_agent = solver->agents_head; NULL != cur_agent; cur_agent = cur_agent->next)
-  {
-    if (cur_agent->is_active && cur_agent->address_inuse && (cur_agent->address_inuse->solver_information == scope))
-    {
-      c++;
-    }
-  }
-  return c;
-}
-
-/**
- * Calculates how much bandwidth is assigned in sum in a network scope, either
- * in the inbound or in the outbound direction.
- *
- * @param solver the solver handle
- * @param type the type of the network scope in question
- * @param direction_in GNUNET_YES if the inbound direction should be summed up,
- *   otherwise the outbound direction will be summed up
- * @return the sum of the assigned bandwidths
- */
-static unsigned long long
-ril_network_get_assigned (struct GAS_RIL_Handle *solver, enum GNUNET_ATS_Network_Type type, int direction_in)
+static void
+ril_networks_update_state (struct GAS_RIL_Handle *solver)
 {
   struct RIL_Peer_Agent *cur;
   struct RIL_Scope *net;
-  unsigned long long sum = 0;
+  int c;
 
-  for (cur = solver->agents_head; NULL != cur; cur = cur->next)
+  for (c = 0; c < solver->networks_count; c++)
   {
-    if (cur->is_active && cur->address_inuse)
-    {
-      net = cur->address_inuse->solver_information;
-      if (net->type == type)
-      {
-        if (direction_in)
-          sum += cur->bw_in;
-        else
-          sum += cur->bw_out;
-      }
-    }
+    net = &solver->network_entries[c];
+    net->bw_in_assigned = 0;
+    net->bw_in_utilized = 0;
+    net->bw_out_assigned = 0;
+    net->bw_out_utilized = 0;
+    net->active_agent_count = 0;
   }
 
-  return sum;
-}
-
-/**
- * Calculates how much bandwidth is actually utilized in sum in a network scope,
- * either in the inbound or in the outbound direction.
- *
- * @param solver the solver handle
- * @param type the type of the network scope in question
- * @param direction_in GNUNET_YES if the inbound direction should be summed up,
- *   otherwise the outbound direction will be summed up
- * @return the sum of the utilized bandwidths (in bytes/second)
- */
-static unsigned long long
-ril_network_get_utilized (struct GAS_RIL_Handle *solver, enum GNUNET_ATS_Network_Type type, int direction_in)
-{
-  struct RIL_Peer_Agent *cur;
-  struct RIL_Scope *net;
-  unsigned long long sum = 0;
-
   for (cur = solver->agents_head; NULL != cur; cur = cur->next)
   {
     if (cur->is_active && cur->address_inuse)
     {
       net = cur->address_inuse->solver_information;
-      if (net->type == type)
-      {
-        if (direction_in)
-          sum += cur->address_inuse->norm_utilization_in.norm;
-        else
-          sum += cur->address_inuse->norm_utilization_out.norm;
-      }
+      net->bw_in_assigned += cur->bw_in;
+      net->bw_in_utilized += cur->address_inuse->norm_utilization_in.norm;
+      net->bw_out_assigned += cur->bw_out;
+      net->bw_out_utilized += cur->address_inuse->norm_utilization_out.norm;
+      net->active_agent_count++;
     }
   }
 
-  return sum;
-}
-
-/**
- * Retrieves the state of the network scope, so that its attributes are up-to-
- * date.
- *
- * @param solver the solver handle
- */
-static void
-ril_networks_update_state (struct GAS_RIL_Handle *solver)
-{
-  int c;
-  struct RIL_Scope *net;
-
+  /* the welfare measures need the agent counts computed above */
   for (c = 0; c < solver->networks_count; c++)
   {
     net = &solver->network_entries[c];
-    net->bw_in_assigned = ril_network_get_assigned(solver, net->type, GNUNET_YES);
-    net->bw_in_utilized = ril_network_get_utilized(solver, net->type, GNUNET_YES);
-    net->bw_out_assigned = ril_network_get_assigned(solver, net->type, GNUNET_NO);
-    net->bw_out_utilized = ril_network_get_utilized(solver, net->type, GNUNET_NO);
-    net->active_agent_count = ril_network_count_active_agents(solver, net);
-    net->social_welfare = ril_network_get_social_welfare(solver, net);
+    net->social_welfare = ril_network_get_social_welfare (solver, net);
   }
 }
 
@@ -1865,6 +1834,7 @@ static void
 ril_step (struct GAS_RIL_Handle *solver)
 {
   struct RIL_Peer_Agent *cur;
+  struct GNUNET_TIME_Relative time_since_last;
 
   if (GNUNET_YES == solver->bulk_lock)
   {
@@ -1872,6 +1842,19 @@ ril_step (struct GAS_RIL_Handle *solver)
     return;
   }
 
+  if ((0 < solver->step_count) && (!solver->simulate))
+  {
+    /* coalesce event bursts: if the minimum step interval has not passed
+     * yet, leave the changed state to the already scheduled next step
+     * instead of performing a full step per event */
+    time_since_last = GNUNET_TIME_absolute_get_duration (solver->step_time_last);
+    if (time_since_last.rel_value_us < solver->parameters.step_time_min.rel_value_us)
+    {
+      ril_step_schedule_next (solver);
+      return;
+    }
+  }
+
   ril_inform (solver, GAS_OP_SOLVE_START, GAS_STAT_SUCCESS);
 
   LOG(GNUNET_ERROR_TYPE_DEBUG, "    RIL step number %d\n", solver->step_count);
@@ -1970,6 +1953,7 @@ agent_init (void *s, const struct GNUNET_PeerIdentity *peer)
     agent->E[i] = (double *) GNUNET_malloc (sizeof (double) * agent->m);
   }
   agent_w_init(agent);
+  agent->rbf_cache = NULL;
   agent->eligibility_reset = GNUNET_NO;
   agent->a_old = RIL_ACTION_INVALID;
   agent->s_old = GNUNET_malloc (sizeof (double) * agent->m);
@@ -1999,6 +1983,7 @@ agent_die (struct GAS_RIL_Handle *solver, struct RIL_Peer_Agent *agent)
   GNUNET_free_non_null(agent->W);
   GNUNET_free_non_null(agent->E);
   GNUNET_free_non_null(agent->s_old);
+  GNUNET_free_non_null(agent->rbf_cache);
   GNUNET_free(agent);
 }
 
@@ -30,6 +30,12 @@
 #include "gnunet_block_lib.h"
 #include "gnunet_block_plugin.h"
 
+/**
+ * Number of slots in the per-context cache of blocks that already
+ * passed cryptographic validation.  Must be a power of two.
+ */
+#define VALIDATION_CACHE_SIZE 256
+
 
 /**
  * Handle for a plugin.
@@ -67,6 +73,14 @@ struct GNUNET_BLOCK_Context
    * Our configuration.
    */
   const struct GNUNET_CONFIGURATION_Handle *cfg;
+
+  /**
+   * Direct-mapped cache with the hashes of blocks that recently
+   * passed a plugin's cryptographic checks.  Only used for plugins
+   * that set @e crypto_cacheable; colliding entries simply evict
+   * each other.
+   */
+  struct GNUNET_HashCode val_cache[VALIDATION_CACHE_SIZE];
 };
 
 
@@ -220,19 +234,48 @@ GNUNET_BLOCK_evaluate (struct GNUNET_BLOCK_Context *ctx,
                        size_t reply_block_size)
 {
   struct GNUNET_BLOCK_PluginFunctions *plugin = find_plugin (ctx, type);
+  enum GNUNET_BLOCK_EvaluationResult ret;
+  struct GNUNET_HashCode chash;
+  unsigned int slot;
+  int check_cache;
 
   if (plugin == NULL)
     return GNUNET_BLOCK_EVALUATION_TYPE_NOT_SUPPORTED;
-  return plugin->evaluate (plugin->cls,
-                           type,
-                           eo,
-                           query,
-                           bf,
-                           bf_mutator,
-                           xquery,
-                           xquery_size,
-                           reply_block,
-                           reply_block_size);
+  check_cache = ( (GNUNET_YES == plugin->crypto_cacheable) &&
+		  (NULL != reply_block) &&
+		  (0 == (eo & GNUNET_BLOCK_EO_LOCAL_SKIP_CRYPTO)) );
+  slot = 0;
+  if (check_cache)
+  {
+    GNUNET_CRYPTO_hash (reply_block,
+			reply_block_size,
+			&chash);
+    slot = chash.bits[0] & (VALIDATION_CACHE_SIZE - 1);
+    if (0 == memcmp (&chash,
+		     &ctx->val_cache[slot],
+		     sizeof (struct GNUNET_HashCode)))
+    {
+      /* identical bytes passed the crypto checks before */
+      eo |= GNUNET_BLOCK_EO_LOCAL_SKIP_CRYPTO;
+      check_cache = GNUNET_NO;
+    }
+  }
+  ret = plugin->evaluate (plugin->cls,
+			  type,
+			  eo,
+			  query,
+			  bf,
+			  bf_mutator,
+			  xquery,
+			  xquery_size,
+			  reply_block,
+			  reply_block_size);
+  if ( (check_cache) &&
+       ( (GNUNET_BLOCK_EVALUATION_OK_MORE == ret) ||
+	 (GNUNET_BLOCK_EVALUATION_OK_LAST == ret) ||
+	 (GNUNET_BLOCK_EVALUATION_OK_DUPLICATE == ret) ) )
+    ctx->val_cache[slot] = chash;
+  return ret;
 }
 
 
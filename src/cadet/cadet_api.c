@@ -294,9 +294,10 @@ struct GNUNET_CADET_Channel
   enum GNUNET_CADET_ChannelOption options;
 
     /**
-     * Are we allowed to send to the service?
+     * How many messages are we allowed to send to the service?
+     * (window credits, one granted per local ACK)
      */
-  int allow_send;
+  unsigned int allow_send;
 
 };
 
@@ -373,7 +374,7 @@ message_ready_size (struct GNUNET_CADET_Handle *h)
   for (th = h->th_head; NULL != th; th = th->next)
   {
     ch = th->channel;
-    if (GNUNET_NO == th_is_payload (th) || GNUNET_YES == ch->allow_send)
+    if (GNUNET_NO == th_is_payload (th) || 0 < ch->allow_send)
       return th->size;
   }
   return 0;
@@ -432,7 +433,7 @@ create_channel (struct GNUNET_CADET_Handle *h, CADET_ChannelNumber chid)
   {
     ch->chid = chid;
   }
-  ch->allow_send = GNUNET_NO;
+  ch->allow_send = 0;
   return ch;
 }
 
@@ -766,7 +767,7 @@ process_channel_created (struct GNUNET_CADET_Handle *h,
     void *ctx;
 
     ch = create_channel (h, chid);
-    ch->allow_send = GNUNET_NO;
+    ch->allow_send = 0;
     ch->peer = GNUNET_PEER_intern (&msg->peer);
     ch->cadet = h;
     ch->chid = chid;
@@ -912,7 +913,7 @@ process_ack (struct GNUNET_CADET_Handle *h,
     return;
   }
   LOG (GNUNET_ERROR_TYPE_DEBUG, "  on channel %X!\n", ch->chid);
-  ch->allow_send = GNUNET_YES;
+  ch->allow_send++;
   if (NULL == h->th && 0 < ch->packet_size)
   {
     LOG (GNUNET_ERROR_TYPE_DEBUG, "  tmt rdy was NULL, requesting!\n");
@@ -1364,7 +1365,7 @@ send_callback (void *cls, size_t size, void *buf)
 
       LOG (GNUNET_ERROR_TYPE_DEBUG, "#  payload, %u bytes on %X (%p)\n",
            th->size, ch->chid, ch);
-      if (GNUNET_NO == ch->allow_send)
+      if (0 == ch->allow_send)
       {
         /* This channel is not ready to transmit yet, Try the next message */
         next = th->next;
@@ -1386,7 +1387,7 @@ send_callback (void *cls, size_t size, void *buf)
         dmsg->id = htonl (ch->chid);
         LOG (GNUNET_ERROR_TYPE_DEBUG, "#  sending, type %s\n",
              GC_m2s (ntohs (mh->type)));
-        ch->allow_send = GNUNET_NO;
+        ch->allow_send--;
       }
       else
       {
@@ -1650,7 +1651,7 @@ GNUNET_CADET_channel_create (struct GNUNET_CADET_Handle *h,
   msg.port = htonl (port);
   msg.peer = *peer;
   msg.opt = htonl (options);
-  ch->allow_send = GNUNET_NO;
+  ch->allow_send = 0;
   send_packet (h, &msg.header, ch);
   return ch;
 }
@@ -1750,7 +1751,7 @@ GNUNET_CADET_notify_transmit_ready (struct GNUNET_CADET_Channel *channel, int co
   GNUNET_assert (GNUNET_CONSTANTS_MAX_CADET_MESSAGE_SIZE >= notify_size);
   LOG (GNUNET_ERROR_TYPE_DEBUG, "CADET NOTIFY TRANSMIT READY\n");
   LOG (GNUNET_ERROR_TYPE_DEBUG, "    on channel %X\n", channel->chid);
-  LOG (GNUNET_ERROR_TYPE_DEBUG, "    allow_send %d\n", channel->allow_send);
+  LOG (GNUNET_ERROR_TYPE_DEBUG, "    allow_send %u\n", channel->allow_send);
   if (channel->chid >= GNUNET_CADET_LOCAL_CHANNEL_ID_SERV)
     LOG (GNUNET_ERROR_TYPE_DEBUG, "    to origin\n");
   else
@@ -1769,7 +1770,7 @@ GNUNET_CADET_notify_transmit_ready (struct GNUNET_CADET_Channel *channel, int co
   add_to_queue (channel->cadet, th);
   if (NULL != channel->cadet->th)
     return th;
-  if (GNUNET_NO == channel->allow_send)
+  if (0 == channel->allow_send)
     return th;
   LOG (GNUNET_ERROR_TYPE_DEBUG, "    call client notify tmt rdy\n");
   channel->cadet->th =
@@ -31,6 +31,7 @@
 
 #define PING 1
 #define PONG 2
+#define BULK 3
 
 
 /**
@@ -38,6 +39,11 @@
  */
 #define PING_PERIOD 500
 
+/**
+ * Size of a bulk data message, including the header.
+ */
+#define BULK_SIZE 1024
+
 /**
  * How long until we give up on connecting the peers?
  */
@@ -149,11 +155,21 @@ struct CadetPeer
    */
   struct GNUNET_SCHEDULER_Task * ping_task;
 
+  /**
+   * Pending bulk transmission (only non-NULL while requested).
+   */
+  struct GNUNET_CADET_TransmitHandle *bulk_th;
+
   float mean[number_rounds];
   float var[number_rounds];
   unsigned int pongs[number_rounds];
   unsigned int pings[number_rounds];
 
+  /**
+   * Payload bytes delivered to the destination, per round.
+   */
+  unsigned long long bulk_bytes[number_rounds];
+
 };
 
 /**
@@ -231,6 +247,11 @@ static unsigned int current_round;
  */
 static int do_warmup;
 
+/**
+ * Stream bulk data on the channels, to measure throughput?
+ */
+static int do_bulk;
+
 /**
  * Warmup progress.
  */
@@ -288,14 +309,19 @@ get_index (struct CadetPeer *peer)
 
 /**
  * Show the results of the test (banwidth acheived) and log them to GAUGER
+ *
+ * Also emit machine-readable "PERF:" lines, one per peer and round,
+ * for consumption by regression-tracking scripts.
  */
 static void
 show_end_data (void)
 {
   struct CadetPeer *peer;
+  double seconds;
   unsigned int i;
   unsigned int j;
 
+  seconds = round_time.rel_value_us / 1000000.0;
   for (i = 0; i < number_rounds; i++)
   {
     for (j = 0; j < peers_pinging; j++)
@@ -305,6 +331,16 @@ show_end_data (void)
                "ROUND %3u PEER %3u: %10.2f / %10.2f, PINGS: %3u, PONGS: %3u\n",
                i, j, peer->mean[i], sqrt (peer->var[i] / (peer->pongs[i] - 1)),
                peer->pings[i], peer->pongs[i]);
+      FPRINTF (stdout,
+               "PERF: mode=latency round=%u peer=%u mean_us=%.2f stddev_us=%.2f"
+               " pings=%u pongs=%u\n",
+               i, j, peer->mean[i], sqrt (peer->var[i] / (peer->pongs[i] - 1)),
+               peer->pings[i], peer->pongs[i]);
+      if (GNUNET_YES == do_bulk)
+        FPRINTF (stdout,
+                 "PERF: mode=throughput round=%u peer=%u bytes=%llu bps=%.2f\n",
+                 i, j, peer->bulk_bytes[i],
+                 8.0 * peer->bulk_bytes[i] / seconds);
     }
   }
 }
@@ -687,6 +723,40 @@ tmt_rdy_ping (void *cls, size_t size, void *buf)
 }
 
 
+/**
+ * Transmit bulk data callback: fill the buffer and immediately
+ * request the next transmission, to keep the channel saturated.
+ *
+ * @param cls Closure (peer).
+ * @param size Size of the buffer we have.
+ * @param buf Buffer to copy data to.
+ */
+static size_t
+tmt_rdy_bulk (void *cls, size_t size, void *buf)
+{
+  struct CadetPeer *peer = (struct CadetPeer *) cls;
+  struct CadetPingMessage *msg = buf;
+
+  peer->bulk_th = NULL;
+  if (size < BULK_SIZE || NULL == buf)
+  {
+    GNUNET_break (GNUNET_YES == test_finished);
+    return 0;
+  }
+  msg->header.size = htons (BULK_SIZE);
+  msg->header.type = htons (BULK);
+  msg->counter = htonl (peer->data_sent++);
+  msg->round_number = htonl (current_round);
+  msg->timestamp = GNUNET_TIME_absolute_hton (GNUNET_TIME_absolute_get ());
+  if (GNUNET_NO == test_finished && NULL != peer->ch)
+    peer->bulk_th =
+        GNUNET_CADET_notify_transmit_ready (peer->ch, GNUNET_NO,
+                                            GNUNET_TIME_UNIT_FOREVER_REL,
+                                            BULK_SIZE, &tmt_rdy_bulk, peer);
+  return BULK_SIZE;
+}
+
+
 /**
  * Function is called whenever a PING message is received.
  *
@@ -758,12 +828,48 @@ pong_handler (void *cls, struct GNUNET_CADET_Channel *channel,
 }
 
 
+/**
+ * Function is called whenever a BULK message is received.
+ *
+ * @param cls closure (peer #, set from GNUNET_CADET_connect)
+ * @param channel connection to the other end
+ * @param channel_ctx place to store local state associated with the channel
+ * @param message the actual message
+ * @return GNUNET_OK to keep the connection open,
+ *         GNUNET_SYSERR to close it (signal serious error)
+ */
+int
+bulk_handler (void *cls, struct GNUNET_CADET_Channel *channel,
+              void **channel_ctx,
+              const struct GNUNET_MessageHeader *message)
+{
+  long n = (long) cls;
+  struct CadetPeer *source;
+  const struct CadetPingMessage *msg;
+  unsigned int r;
+
+  GNUNET_CADET_receive_done (channel);
+  msg = (const struct CadetPingMessage *) message;
+  r = ntohl (msg->round_number);
+  source = peers[n].incoming;
+  if ( (NULL == source) || (number_rounds <= r) )
+  {
+    GNUNET_break (0);
+    return GNUNET_OK;
+  }
+  source->bulk_bytes[r] += ntohs (message->size);
+
+  return GNUNET_OK;
+}
+
+
 /**
  * Handlers, for diverse services
  */
 static struct GNUNET_CADET_MessageHandler handlers[] = {
   {&ping_handler, PING, sizeof (struct CadetPingMessage)},
   {&pong_handler, PONG, sizeof (struct CadetPingMessage)},
+  {&bulk_handler, BULK, sizeof (struct CadetPingMessage)},
   {NULL, 0, 0}
 };
 
@@ -896,6 +1002,12 @@ start_test (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
                 i, get_index (peers[i].dest), peers[i].ch);
     peers[i].ping_task = GNUNET_SCHEDULER_add_delayed (delay_ms_rnd (2000),
                                                        &ping, &peers[i]);
+    if (GNUNET_YES == do_bulk)
+      peers[i].bulk_th =
+          GNUNET_CADET_notify_transmit_ready (peers[i].ch, GNUNET_NO,
+                                              GNUNET_TIME_UNIT_FOREVER_REL,
+                                              BULK_SIZE,
+                                              &tmt_rdy_bulk, &peers[i]);
   }
   peers_running = peers_total;
   if (NULL != disconnect_task)
@@ -1043,8 +1155,9 @@ main (int argc, char *argv[])
 
   if (4 > argc)
   {
-    fprintf (stderr, "usage: %s ROUND_TIME PEERS PINGS [DO_WARMUP]\n", argv[0]);
-    fprintf (stderr, "example: %s 30s 16 1 Y\n", argv[0]);
+    fprintf (stderr, "usage: %s ROUND_TIME PEERS PINGS [DO_WARMUP [DO_BULK]]\n",
+             argv[0]);
+    fprintf (stderr, "example: %s 30s 16 1 Y Y\n", argv[0]);
     return 1;
   }
 
@@ -1072,6 +1185,7 @@ main (int argc, char *argv[])
   }
 
   do_warmup = (5 > argc || argv[4][0] != 'N');
+  do_bulk = (6 <= argc && argv[5][0] == 'Y');
 
   ids = GNUNET_CONTAINER_multipeermap_create (2 * peers_total, GNUNET_YES);
   GNUNET_assert (NULL != ids);
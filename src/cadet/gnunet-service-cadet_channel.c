@@ -39,6 +39,13 @@
                                     GNUNET_TIME_UNIT_MILLISECONDS, 250)
 #define CADET_RETRANSMIT_MARGIN  4
 
+/**
+ * Maximum number of messages a client may have in flight towards the
+ * service on one channel (local window).  Each local ACK grants one
+ * credit, so bulk senders do not stall on a round trip per message.
+ */
+#define CADET_CLIENT_WINDOW_SIZE 8
+
 
 /**
  * All the states a connection can be in.
@@ -177,9 +184,9 @@ struct CadetChannelReliability
   int                               client_ready;
 
   /**
-   * Can the client send data to us?
+   * How many messages can the client still send to us? (window credits)
    */
-  int                               client_allowed;
+  unsigned int                      client_allowed;
 
     /**
      * Task to resend/poll in case no ACK is received.
@@ -192,9 +199,22 @@ struct CadetChannelReliability
   struct GNUNET_TIME_Relative       retry_timer;
 
     /**
-     * How long does it usually take to get an ACK.
+     * How long does it usually take to get an ACK. (Smoothed RTT)
      */
   struct GNUNET_TIME_Relative       expected_delay;
+
+    /**
+     * Variation of the ACK delay, used together with @e expected_delay
+     * to compute the retransmission timeout (RFC 6298 style).
+     */
+  struct GNUNET_TIME_Relative       delay_var;
+
+    /**
+     * MID of the last message we fast-retransmitted because a
+     * DATA_ACK reported later messages as received; used to avoid
+     * retransmitting the same copy once per incoming ACK.
+     */
+  uint32_t                          last_fast_retransmit_mid;
 };
 
 
@@ -461,6 +481,7 @@ add_destination (struct CadetChannel *ch, struct CadetClient *c)
   ch->dest_rel->ch = ch;
   ch->dest_rel->expected_delay.rel_value_us = 0;
   ch->dest_rel->retry_timer = CADET_RETRANSMIT_TIME;
+  ch->dest_rel->last_fast_retransmit_mid = (uint32_t) -1;
 
   ch->dest = c;
 }
@@ -661,9 +682,7 @@ send_client_buffered_data (struct CadetChannel *ch,
 
 
 /**
- * Allow a client to send more data.
- *
- * In case the client was already allowed to send data, do nothing.
+ * Grant a client one more window credit (send one local ACK).
  *
  * @param ch Channel.
  * @param fwd Is this a FWD ACK? (FWD ACKs are sent to root)
@@ -689,12 +708,7 @@ send_client_ack (struct CadetChannel *ch, int fwd)
     return;
   }
 
-  if (GNUNET_YES == rel->client_allowed)
-  {
-    LOG (GNUNET_ERROR_TYPE_DEBUG, "  already allowed\n");
-    return;
-  }
-  rel->client_allowed = GNUNET_YES;
+  rel->client_allowed++;
 
   GML_send_ack (c, fwd ? ch->lid_root : ch->lid_dest);
 }
@@ -717,6 +731,22 @@ send_client_nack (struct CadetChannel *ch)
 }
 
 
+/**
+ * Compute the retransmission timeout from the smoothed ACK delay and
+ * its variation, as in RFC 6298: srtt + 4 * rttvar.
+ *
+ * @param rel Reliability data with the delay estimates.
+ * @return Timeout to use before retransmitting.
+ */
+static struct GNUNET_TIME_Relative
+channel_rto (const struct CadetChannelReliability *rel)
+{
+  return GNUNET_TIME_relative_add (rel->expected_delay,
+                                   GNUNET_TIME_relative_multiply (rel->delay_var,
+                                                                  4));
+}
+
+
 /**
  * We haven't received an ACK after a certain time: restransmit the message.
  *
@@ -821,15 +851,12 @@ ch_message_sent (void *cls,
       rel = copy->rel;
       if (NULL == rel->retry_task)
       {
-        LOG (GNUNET_ERROR_TYPE_DEBUG, "  scheduling retry in %d * %s\n",
-             CADET_RETRANSMIT_MARGIN,
+        LOG (GNUNET_ERROR_TYPE_DEBUG, "  scheduling retry, srtt %s\n",
              GNUNET_STRINGS_relative_time_to_string (rel->expected_delay,
                                                      GNUNET_YES));
         if (0 != rel->expected_delay.rel_value_us)
         {
-          rel->retry_timer =
-              GNUNET_TIME_relative_multiply (rel->expected_delay,
-                                             CADET_RETRANSMIT_MARGIN);
+          rel->retry_timer = channel_rto (rel);
         }
         else
         {
@@ -1115,11 +1142,22 @@ rel_message_free (struct CadetReliableMessage *copy, int update_time)
   LOG (GNUNET_ERROR_TYPE_DEBUG, "Freeing %u\n", copy->mid);
   if (GNUNET_YES == update_time)
   {
+    uint64_t err;
+
     time = GNUNET_TIME_absolute_get_duration (copy->timestamp);
     if (0 == rel->expected_delay.rel_value_us)
+    {
       rel->expected_delay = time;
+      rel->delay_var.rel_value_us = time.rel_value_us / 2;
+    }
     else
     {
+      err = (time.rel_value_us > rel->expected_delay.rel_value_us)
+        ? time.rel_value_us - rel->expected_delay.rel_value_us
+        : rel->expected_delay.rel_value_us - time.rel_value_us;
+      rel->delay_var.rel_value_us *= 3;
+      rel->delay_var.rel_value_us += err;
+      rel->delay_var.rel_value_us /= 4;
       rel->expected_delay.rel_value_us *= 7;
       rel->expected_delay.rel_value_us += time.rel_value_us;
       rel->expected_delay.rel_value_us /= 8;
@@ -1129,7 +1167,7 @@ rel_message_free (struct CadetReliableMessage *copy, int update_time)
     LOG (GNUNET_ERROR_TYPE_DEBUG, "  new delay    %12s\n",
          GNUNET_STRINGS_relative_time_to_string (rel->expected_delay,
                                                  GNUNET_NO));
-    rel->retry_timer = rel->expected_delay;
+    rel->retry_timer = channel_rto (rel);
   }
   else
   {
@@ -1460,7 +1498,7 @@ GCCH_get_buffer (struct CadetChannel *ch, int fwd)
  * @param ch Channel.
  * @param fwd Is query about FWD traffic? (Request root status).
  *
- * @return #GNUNET_YES if client is allowed to send us data.
+ * @return Number of messages the client is still allowed to send us.
  */
 int
 GCCH_get_allowed (struct CadetChannel *ch, int fwd)
@@ -1634,7 +1672,14 @@ GCCH_allow_client (struct CadetChannel *ch, int fwd)
   }
 
   LOG (GNUNET_ERROR_TYPE_DEBUG, " buffer space %u, allowing\n", buffer);
-  send_client_ack (ch, fwd);
+  rel = fwd ? ch->root_rel : ch->dest_rel;
+  if (NULL == rel)
+  {
+    GNUNET_break (GNUNET_NO != ch->destroy);
+    return;
+  }
+  while (rel->client_allowed < GNUNET_MIN (buffer, CADET_CLIENT_WINDOW_SIZE))
+    send_client_ack (ch, fwd);
 }
 
 
@@ -1769,13 +1814,13 @@ GCCH_handle_local_data (struct CadetChannel *ch,
 
   rel = fwd ? ch->root_rel : ch->dest_rel;
 
-  if (GNUNET_NO == rel->client_allowed)
+  if (0 == rel->client_allowed)
   {
     GNUNET_break_op (0);
     return GNUNET_SYSERR;
   }
 
-  rel->client_allowed = GNUNET_NO;
+  rel->client_allowed--;
 
   /* Ok, everything is correct, send the message. */
   payload = (struct GNUNET_CADET_Data *) cbuf;
@@ -1896,6 +1941,7 @@ GCCH_handle_local_create (struct CadetClient *c,
   ch->root_rel->ch = ch;
   ch->root_rel->retry_timer = CADET_RETRANSMIT_TIME;
   ch->root_rel->expected_delay.rel_value_us = 0;
+  ch->root_rel->last_fast_retransmit_mid = (uint32_t) -1;
 
   LOG (GNUNET_ERROR_TYPE_DEBUG, "CREATED CHANNEL %s\n", GCCH_2s (ch));
 
@@ -2107,6 +2153,27 @@ GCCH_handle_data_ack (struct CadetChannel *ch,
   /* ACK client if needed and possible */
   GCCH_allow_client (ch, fwd);
 
+  /* Fast retransmit: the bitfield shows the receiver already holds
+   * messages beyond the first pending one, so that one is most
+   * likely lost; resend it now instead of waiting for the timer.
+   * Do this at most once per MID. */
+  if ( (0 != msg->futures) &&
+       (NULL != rel->head_sent) &&
+       (NULL == rel->head_sent->chq) &&
+       (ack + 1 == rel->head_sent->mid) &&
+       (rel->last_fast_retransmit_mid != rel->head_sent->mid) )
+  {
+    struct GNUNET_CADET_Data *payload;
+
+    copy = rel->head_sent;
+    rel->last_fast_retransmit_mid = copy->mid;
+    payload = (struct GNUNET_CADET_Data *) &copy[1];
+    LOG (GNUNET_ERROR_TYPE_DEBUG, "FAST RETRANSMIT MID %u\n", copy->mid);
+    GCCH_send_prebuilt_message (&payload->header, ch, fwd, copy);
+    GNUNET_STATISTICS_update (stats, "# data retransmitted fast", 1,
+                              GNUNET_NO);
+  }
+
   /* If some message was free'd, update the retransmission delay */
   if (GNUNET_YES == work)
   {
@@ -2119,8 +2186,8 @@ GCCH_handle_data_ack (struct CadetChannel *ch,
         struct GNUNET_TIME_Absolute new_target;
         struct GNUNET_TIME_Relative delay;
 
-        delay = GNUNET_TIME_relative_multiply (rel->retry_timer,
-                                               CADET_RETRANSMIT_MARGIN);
+        /* retry_timer is already the full RTO (srtt + 4 * rttvar) */
+        delay = rel->retry_timer;
         new_target = GNUNET_TIME_absolute_add (rel->head_sent->timestamp,
                                                delay);
         delay = GNUNET_TIME_absolute_get_remaining (new_target);
@@ -100,7 +100,7 @@ GCCH_get_buffer (struct CadetChannel *ch, int fwd);
  * @param ch Channel.
  * @param fwd Is query about FWD traffic? (Request root status).
  *
- * @return #GNUNET_YES if client is allowed to send us data.
+ * @return Number of messages the client is still allowed to send us.
  */
 int
 GCCH_get_allowed (struct CadetChannel *ch, int fwd);
@@ -321,6 +321,14 @@ static unsigned long long max_connections;
  */
 static unsigned long long max_msgs_queue;
 
+/**
+ * Per-connection in-flight message budget; 0 means derive it from
+ * #max_msgs_queue / #max_connections as before.  Raising it allows a
+ * single connection to keep more messages in flight per hop, which
+ * long paths need to avoid draining the window every round trip.
+ */
+static unsigned long long max_msgs_connection;
+
 /**
  * How often to send path keepalives. Paths timeout after 4 missed.
  */
@@ -444,7 +452,10 @@ fc_init (struct CadetFlowControl *fc)
   fc->poll_task = NULL;
   fc->poll_time = GNUNET_TIME_UNIT_SECONDS;
   fc->queue_n = 0;
-  fc->queue_max = (max_msgs_queue / max_connections) + 1;
+  if (0 != max_msgs_connection)
+    fc->queue_max = max_msgs_connection;
+  else
+    fc->queue_max = (max_msgs_queue / max_connections) + 1;
 }
 
 
@@ -544,11 +555,16 @@ send_ack (struct CadetConnection *c, unsigned int buffer, int fwd, int force)
   LOG (GNUNET_ERROR_TYPE_DEBUG, "connection send %s ack on %s\n",
        GC_f2s (fwd), GCC_2s (c));
 
-  /* Check if we need to transmit the ACK. */
+  /* Check if we need to transmit the ACK.  Refresh the sender's
+   * credit once it has used up half its window instead of waiting
+   * until it is almost exhausted; otherwise every window's worth of
+   * traffic on a long path ends in a stall until the ACK crawls
+   * back. */
   delta = prev_fc->last_ack_sent - prev_fc->last_pid_recv;
-  if (3 < delta && buffer < delta && GNUNET_NO == force)
+  if ((int) GNUNET_MAX (3, prev_fc->queue_max / 2) < delta &&
+      buffer < delta && GNUNET_NO == force)
   {
-    LOG (GNUNET_ERROR_TYPE_DEBUG, "Not sending ACK, buffer > 3\n");
+    LOG (GNUNET_ERROR_TYPE_DEBUG, "Not sending ACK, credit left > half window\n");
     LOG (GNUNET_ERROR_TYPE_DEBUG,
          "  last pid recv: %u, last ack sent: %u\n",
          prev_fc->last_pid_recv, prev_fc->last_ack_sent);
@@ -2954,6 +2970,13 @@ GCC_init (const struct GNUNET_CONFIGURATION_Handle *c)
     return;
   }
 
+  /* Optional: fixed in-flight budget per connection. */
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (c, "CADET",
+                                             "MAX_MSGS_CONNECTION",
+                                             &max_msgs_connection))
+    max_msgs_connection = 0;
+
   if (GNUNET_OK !=
       GNUNET_CONFIGURATION_get_value_time (c, "CADET", "REFRESH_CONNECTION_TIME",
                                            &refresh_connection_time))
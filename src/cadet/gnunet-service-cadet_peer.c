@@ -39,6 +39,14 @@
 #define LOG(level, ...) GNUNET_log_from (level,"cadet-p2p",__VA_ARGS__)
 #define LOG2(level, ...) GNUNET_log_from_nocheck(level,"cadet-p2p",__VA_ARGS__)
 
+/**
+ * How many alternative paths do we keep per peer, at most.  Paths are
+ * kept sorted by length, so when the limit is exceeded we drop the
+ * longest path that is not bound to a connection.  This bounds the
+ * cost of path selection and of duplicate detection on insertion.
+ */
+#define MAX_PATHS_PER_PEER 32
+
 
 /******************************************************************************/
 /********************************   STRUCTS  **********************************/
@@ -968,6 +976,9 @@ peer_get_best_path (const struct CadetPeer *peer)
   best_p = NULL;
   for (p = peer->path_head; NULL != p; p = p->next)
   {
+    if (p->length >= best_cost)
+      break; /* Paths are sorted by length and cost >= length:
+                no later path can beat the current best. */
     if (GNUNET_NO == path_is_valid (p))
       continue; /* Don't use invalid paths. */
     if (GNUNET_YES == GCT_is_path_used (peer->tunnel, p))
@@ -983,6 +994,48 @@ peer_get_best_path (const struct CadetPeer *peer)
 }
 
 
+/**
+ * Enforce the per-peer path limit: if we store more than
+ * #MAX_PATHS_PER_PEER paths towards @a peer, drop the longest one
+ * that is not bound to a connection or otherwise in use.
+ *
+ * @param peer Peer whose path list to prune.
+ * @param keep Path that must not be dropped (just added, the caller
+ *             still holds a reference to it).
+ */
+static void
+peer_prune_paths (struct CadetPeer *peer,
+                  const struct CadetPeerPath *keep)
+{
+  struct CadetPeerPath *iter;
+  unsigned int count;
+
+  count = 0;
+  for (iter = peer->path_head; NULL != iter; iter = iter->next)
+    count++;
+  if (MAX_PATHS_PER_PEER >= count)
+    return;
+  for (iter = peer->path_tail; NULL != iter; iter = iter->prev)
+  {
+    if (keep == iter)
+      continue;
+    if (NULL != iter->c)
+      continue; /* Bound to a connection. */
+    if (NULL != iter->path_delete)
+      continue; /* Already scheduled for destruction. */
+    if (NULL != peer->tunnel
+        && GNUNET_YES == GCT_is_path_used (peer->tunnel, iter))
+      continue;
+    LOG (GNUNET_ERROR_TYPE_DEBUG,
+         "  path limit reached, dropping %p (%u)\n",
+         iter, iter->length);
+    GNUNET_CONTAINER_DLL_remove (peer->path_head, peer->path_tail, iter);
+    path_destroy (iter);
+    return;
+  }
+}
+
+
 /**
  * Is this queue element sendable?
  *
@@ -2214,6 +2267,7 @@ GCP_add_path (struct CadetPeer *peer,
   LOG (GNUNET_ERROR_TYPE_DEBUG, "  added last\n");
 
 finish:
+  peer_prune_paths (peer, path);
   if (NULL != peer->tunnel
       && CONNECTIONS_PER_TUNNEL > GCT_count_connections (peer->tunnel)
       && 2 < path->length) /* Direct paths are handled by core_connect */
@@ -894,6 +894,96 @@ new_ephemeral (struct CadetTunnel *t)
 }
 
 
+/**
+ * Number of authentication keys we keep ready for reuse.  The
+ * authentication key only depends on the (rarely changing) tunnel
+ * key and the message IV (always zero for Axolotl traffic), so
+ * re-deriving it with the full KDF for every single message is
+ * wasted work on the relay hot path.
+ */
+#define HMAC_KEY_CACHE_SIZE 64
+
+/**
+ * Cached authentication key for a (tunnel key, IV) pair.
+ */
+struct HmacKeyCacheEntry
+{
+  /**
+   * Tunnel key the authentication key was derived from.
+   */
+  struct GNUNET_CRYPTO_SymmetricSessionKey key;
+
+  /**
+   * IV the authentication key was derived with.
+   */
+  uint32_t iv;
+
+  /**
+   * Is this slot in use?
+   */
+  int valid;
+
+  /**
+   * The derived authentication key.
+   */
+  struct GNUNET_CRYPTO_AuthKey auth_key;
+};
+
+/**
+ * Cache of authentication keys, filled round-robin.
+ */
+static struct HmacKeyCacheEntry hmac_key_cache[HMAC_KEY_CACHE_SIZE];
+
+/**
+ * Next slot in #hmac_key_cache to overwrite.
+ */
+static unsigned int hmac_key_cache_off;
+
+
+/**
+ * Get the authentication key for the given tunnel key and IV,
+ * deriving (and caching) it if we do not have it yet.
+ *
+ * @param key Tunnel key to derive the authentication key from.
+ * @param iv Initialization vector for the message.
+ * @param auth_key[out] Set to the authentication key.
+ */
+static void
+t_hmac_key (const struct GNUNET_CRYPTO_SymmetricSessionKey *key,
+            uint32_t iv,
+            struct GNUNET_CRYPTO_AuthKey *auth_key)
+{
+  static const char ctx[] = "cadet authentication key";
+  struct HmacKeyCacheEntry *hce;
+  unsigned int i;
+
+  for (i = 0; i < HMAC_KEY_CACHE_SIZE; i++)
+  {
+    hce = &hmac_key_cache[i];
+    if ( (GNUNET_YES == hce->valid) &&
+         (iv == hce->iv) &&
+         (0 == memcmp (key,
+                       &hce->key,
+                       sizeof (struct GNUNET_CRYPTO_SymmetricSessionKey))) )
+    {
+      *auth_key = hce->auth_key;
+      return;
+    }
+  }
+  GNUNET_CRYPTO_hmac_derive_key (auth_key, key,
+                                 &iv, sizeof (iv),
+                                 key, sizeof (*key),
+                                 ctx, sizeof (ctx),
+                                 NULL);
+  hce = &hmac_key_cache[hmac_key_cache_off];
+  hmac_key_cache_off = (hmac_key_cache_off + 1) % HMAC_KEY_CACHE_SIZE;
+  hce->key = *key;
+  hce->iv = iv;
+  hce->auth_key = *auth_key;
+  hce->valid = GNUNET_YES;
+}
+
+
 /**
  * Calculate HMAC.
  *
@@ -908,7 +998,6 @@ t_hmac (const void *plaintext, size_t size,
         uint32_t iv, const struct GNUNET_CRYPTO_SymmetricSessionKey *key,
         struct GNUNET_CADET_Hash *hmac)
 {
-  static const char ctx[] = "cadet authentication key";
   struct GNUNET_CRYPTO_AuthKey auth_key;
   struct GNUNET_HashCode hash;
 
@@ -916,11 +1005,7 @@ t_hmac (const void *plaintext, size_t size,
   LOG (GNUNET_ERROR_TYPE_INFO, "  HMAC %u bytes with key %s\n", size,
        GNUNET_i2s ((struct GNUNET_PeerIdentity *) key));
 #endif
-  GNUNET_CRYPTO_hmac_derive_key (&auth_key, key,
-                                 &iv, sizeof (iv),
-                                 key, sizeof (*key),
-                                 ctx, sizeof (ctx),
-                                 NULL);
+  t_hmac_key (key, iv, &auth_key);
   /* Two step: CADET_Hash is only 256 bits, HashCode is 512. */
   GNUNET_CRYPTO_hmac (&auth_key, plaintext, size, &hash);
   memcpy (hmac, &hash, sizeof (*hmac));
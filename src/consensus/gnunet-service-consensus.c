@@ -743,7 +743,7 @@ diff_insert (struct DiffEntry *diff,
   struct DiffElementInfo *di;
   struct GNUNET_HashCode hash;
 
-  GNUNET_assert ( (1 == weight) || (-1 == weight));
+  GNUNET_assert (0 != weight);
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "diff_insert with element size %u\n",
@@ -769,7 +769,10 @@ diff_insert (struct DiffEntry *diff,
                                                       GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST));
   }
 
-  di->weight = weight;
+  /* Weights accumulate, so composing a diff that adds an
+     element with one that removes it again yields weight
+     zero, i.e. no net change. */
+  di->weight += weight;
 }
 
 
@@ -1335,14 +1338,16 @@ diff_compose (struct DiffEntry *diff_1,
   iter = GNUNET_CONTAINER_multihashmap_iterator_create (diff_1->changes);
   while (GNUNET_YES == GNUNET_CONTAINER_multihashmap_iterator_next (iter, NULL, (const void **) &di))
   {
-    diff_insert (diff_new, di->weight, di->element);
+    if (0 != di->weight)
+      diff_insert (diff_new, di->weight, di->element);
   }
   GNUNET_CONTAINER_multihashmap_iterator_destroy (iter);
 
   iter = GNUNET_CONTAINER_multihashmap_iterator_create (diff_2->changes);
   while (GNUNET_YES == GNUNET_CONTAINER_multihashmap_iterator_next (iter, NULL, (const void **) &di))
   {
-    diff_insert (diff_new, di->weight, di->element);
+    if (0 != di->weight)
+      diff_insert (diff_new, di->weight, di->element);
   }
   GNUNET_CONTAINER_multihashmap_iterator_destroy (iter);
 
@@ -31,6 +31,73 @@
 #include "gnunet_gns_service.h"
 #include "conversation.h"
 
+/**
+ * How long do we cache a resolved phone record before forcing a
+ * fresh GNS lookup for the next call to the same address?
+ */
+#define PHONE_RECORD_CACHE_TTL GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 10)
+
+/**
+ * Maximum number of entries kept in the phone record cache.
+ */
+#define PHONE_RECORD_CACHE_SIZE 16
+
+
+/**
+ * Cached result of a GNS phone record lookup, so that calls to
+ * recently-dialed addresses can skip the GNS resolution.
+ */
+struct CachedPhoneRecord
+{
+
+  /**
+   * Kept in a DLL, most recently used first.
+   */
+  struct CachedPhoneRecord *prev;
+
+  /**
+   * Kept in a DLL, most recently used first.
+   */
+  struct CachedPhoneRecord *next;
+
+  /**
+   * Zone the lookup was performed in.
+   */
+  struct GNUNET_CRYPTO_EcdsaPublicKey zone;
+
+  /**
+   * GNS address the lookup was performed for.
+   */
+  char *callee;
+
+  /**
+   * The resolved phone record.
+   */
+  struct GNUNET_CONVERSATION_PhoneRecord phone_record;
+
+  /**
+   * When does this cache entry expire?
+   */
+  struct GNUNET_TIME_Absolute expiry;
+
+};
+
+
+/**
+ * Head of cached phone records, most recently used first.
+ */
+static struct CachedPhoneRecord *cache_head;
+
+/**
+ * Tail of cached phone records, least recently used last.
+ */
+static struct CachedPhoneRecord *cache_tail;
+
+/**
+ * Number of entries in the phone record cache.
+ */
+static unsigned int cache_size;
+
 
 /**
  * Possible states of the phone.
@@ -145,6 +212,11 @@ struct GNUNET_CONVERSATION_Call
    */
   struct GNUNET_CONVERSATION_PhoneRecord phone_record;
 
+  /**
+   * Task scheduled to ring the phone using a cached phone record (or NULL).
+   */
+  struct GNUNET_SCHEDULER_Task *ring_task;
+
   /**
    * State machine for the call.
    */
@@ -162,6 +234,91 @@ static void
 reconnect_call (struct GNUNET_CONVERSATION_Call *call);
 
 
+/**
+ * Look up a phone record in the cache, dropping expired entries
+ * encountered on the way.
+ *
+ * @param zone zone the lookup would be performed in
+ * @param callee GNS address of the callee
+ * @return cached phone record, or NULL if not cached or expired
+ */
+static const struct GNUNET_CONVERSATION_PhoneRecord *
+phone_record_cache_get (const struct GNUNET_CRYPTO_EcdsaPublicKey *zone,
+                        const char *callee)
+{
+  struct CachedPhoneRecord *entry;
+  struct CachedPhoneRecord *next;
+
+  for (entry = cache_head; NULL != entry; entry = next)
+  {
+    next = entry->next;
+    if (0 == GNUNET_TIME_absolute_get_remaining (entry->expiry).rel_value_us)
+    {
+      GNUNET_CONTAINER_DLL_remove (cache_head, cache_tail, entry);
+      GNUNET_free (entry->callee);
+      GNUNET_free (entry);
+      cache_size--;
+      continue;
+    }
+    if ( (0 == memcmp (zone, &entry->zone, sizeof (*zone))) &&
+         (0 == strcmp (callee, entry->callee)) )
+    {
+      GNUNET_CONTAINER_DLL_remove (cache_head, cache_tail, entry);
+      GNUNET_CONTAINER_DLL_insert (cache_head, cache_tail, entry);
+      return &entry->phone_record;
+    }
+  }
+  return NULL;
+}
+
+
+/**
+ * Add a resolved phone record to the cache, updating any existing entry
+ * for the same address and evicting the least recently used entry if the
+ * cache is full.
+ *
+ * @param zone zone the lookup was performed in
+ * @param callee GNS address of the callee
+ * @param phone_record the resolved phone record
+ * @param expiry when the cache entry should expire
+ */
+static void
+phone_record_cache_put (const struct GNUNET_CRYPTO_EcdsaPublicKey *zone,
+                        const char *callee,
+                        const struct GNUNET_CONVERSATION_PhoneRecord *phone_record,
+                        struct GNUNET_TIME_Absolute expiry)
+{
+  struct CachedPhoneRecord *entry;
+
+  for (entry = cache_head; NULL != entry; entry = entry->next)
+    if ( (0 == memcmp (zone, &entry->zone, sizeof (*zone))) &&
+         (0 == strcmp (callee, entry->callee)) )
+      break;
+  if (NULL == entry)
+  {
+    if (PHONE_RECORD_CACHE_SIZE == cache_size)
+    {
+      entry = cache_tail;
+      GNUNET_CONTAINER_DLL_remove (cache_head, cache_tail, entry);
+      GNUNET_free (entry->callee);
+      GNUNET_free (entry);
+      cache_size--;
+    }
+    entry = GNUNET_new (struct CachedPhoneRecord);
+    entry->zone = *zone;
+    entry->callee = GNUNET_strdup (callee);
+    cache_size++;
+  }
+  else
+  {
+    GNUNET_CONTAINER_DLL_remove (cache_head, cache_tail, entry);
+  }
+  entry->phone_record = *phone_record;
+  entry->expiry = expiry;
+  GNUNET_CONTAINER_DLL_insert (cache_head, cache_tail, entry);
+}
+
+
 /**
  * Process recorded audio data.
  *
@@ -420,6 +577,9 @@ handle_gns_response (void *cls,
   uint32_t i;
   struct GNUNET_MQ_Envelope *e;
   struct ClientCallMessage *ccm;
+  struct GNUNET_CRYPTO_EcdsaPublicKey my_zone;
+  struct GNUNET_TIME_Absolute expiry;
+  struct GNUNET_TIME_Absolute rd_expiry;
 
   GNUNET_break (NULL != call->gns_lookup);
   GNUNET_break (CS_LOOKUP == call->state);
@@ -436,6 +596,16 @@ handle_gns_response (void *cls,
       memcpy (&call->phone_record,
               rd[i].data,
               rd[i].data_size);
+      expiry = GNUNET_TIME_relative_to_absolute (PHONE_RECORD_CACHE_TTL);
+      if (0 == (rd[i].flags & GNUNET_GNSRECORD_RF_RELATIVE_EXPIRATION))
+      {
+        rd_expiry.abs_value_us = rd[i].expiration_time;
+        expiry = GNUNET_TIME_absolute_min (expiry, rd_expiry);
+      }
+      GNUNET_IDENTITY_ego_get_public_key (call->zone_id,
+                                          &my_zone);
+      phone_record_cache_put (&my_zone, call->callee,
+                              &call->phone_record, expiry);
       e = GNUNET_MQ_msg (ccm, GNUNET_MESSAGE_TYPE_CONVERSATION_CS_PHONE_CALL);
       ccm->line = call->phone_record.line;
       ccm->target = call->phone_record.peer;
@@ -507,6 +677,32 @@ reconnect_call (struct GNUNET_CONVERSATION_Call *call)
 }
 
 
+/**
+ * Task to ring the phone of the callee using a phone record served from
+ * the cache, skipping the GNS resolution.
+ *
+ * @param cls closure with the `struct GNUNET_CONVERSATION_Call`
+ * @param tc unused
+ */
+static void
+ring_from_cache (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct GNUNET_CONVERSATION_Call *call = cls;
+  struct GNUNET_MQ_Envelope *e;
+  struct ClientCallMessage *ccm;
+
+  call->ring_task = NULL;
+  e = GNUNET_MQ_msg (ccm, GNUNET_MESSAGE_TYPE_CONVERSATION_CS_PHONE_CALL);
+  ccm->line = call->phone_record.line;
+  ccm->target = call->phone_record.peer;
+  ccm->caller_id = *GNUNET_IDENTITY_ego_get_private_key (call->caller_id);
+  GNUNET_MQ_send (call->mq, e);
+  call->state = CS_RINGING;
+  call->event_handler (call->event_handler_cls,
+                       GNUNET_CONVERSATION_EC_CALL_RINGING);
+}
+
+
 /**
  * Call the phone of another user.
  *
@@ -554,6 +750,7 @@ GNUNET_CONVERSATION_call_start (const struct GNUNET_CONFIGURATION_Handle *cfg,
   };
   struct GNUNET_CRYPTO_EcdsaPublicKey my_zone;
   struct GNUNET_CONVERSATION_Call *call;
+  const struct GNUNET_CONVERSATION_PhoneRecord *cached;
 
   call = GNUNET_new (struct GNUNET_CONVERSATION_Call);
   call->client = GNUNET_CLIENT_connect ("conversation", cfg);
@@ -584,6 +781,13 @@ GNUNET_CONVERSATION_call_start (const struct GNUNET_CONFIGURATION_Handle *cfg,
   call->state = CS_LOOKUP;
   GNUNET_IDENTITY_ego_get_public_key (call->zone_id,
                                       &my_zone);
+  cached = phone_record_cache_get (&my_zone, call->callee);
+  if (NULL != cached)
+  {
+    call->phone_record = *cached;
+    call->ring_task = GNUNET_SCHEDULER_add_now (&ring_from_cache, call);
+    return call;
+  }
   call->gns_lookup = GNUNET_GNS_lookup (call->gns,
                                         call->callee,
                                         &my_zone,
@@ -624,6 +828,11 @@ GNUNET_CONVERSATION_call_stop (struct GNUNET_CONVERSATION_Call *call)
     GNUNET_CLIENT_disconnect (call->client);
     call->client = NULL;
   }
+  if (NULL != call->ring_task)
+  {
+    GNUNET_SCHEDULER_cancel (call->ring_task);
+    call->ring_task = NULL;
+  }
   if (NULL != call->gns_lookup)
   {
     GNUNET_GNS_lookup_cancel (call->gns_lookup);
@@ -52,6 +52,18 @@
 /* 120ms at 48000 */
 #define MAX_FRAME_SIZE (960 * 6)
 
+/**
+ * Playback buffer (jitter buffer) target in ms; the server keeps
+ * about this much audio queued to absorb network jitter.
+ */
+#define BUFFER_TARGET_MS 60
+
+/**
+ * How much audio (in ms) must accumulate before playback (re)starts;
+ * this is the time we have to ride out a burst of late frames.
+ */
+#define BUFFER_PREBUF_MS 40
+
 /**
  * Pulseaudio specification. May change in the future.
  */
@@ -61,6 +73,12 @@ static pa_sample_spec sample_spec = {
   .channels = CHANNELS
 };
 
+/**
+ * Pulseaudio buffer attributes; sized at connect time to act as
+ * our jitter buffer.
+ */
+static pa_buffer_attr buffer_attr;
+
 #ifdef DEBUG_DUMP_DECODED_OGG
 static int dump_to_stdout;
 #endif
@@ -348,6 +366,7 @@ ogg_demux_and_decode ()
   static int stream_init;
   int64_t page_granule = 0;
   ogg_packet op;
+  int pret;
   static int has_opus_stream;
   static int has_tags_packet;
   static int32_t opus_serialno;
@@ -380,8 +399,33 @@ ogg_demux_and_decode ()
                 "Reading page that ends at %" PRId64 "\n",
                 page_granule);
     /*Extract all available packets*/
-    while (1 == ogg_stream_packetout (&os, &op))
+    while (0 != (pret = ogg_stream_packetout (&os, &op)))
     {
+      if (-1 == pret)
+      {
+        /*Hole in the data: at least one page was lost in transit.
+          Let the decoder conceal the missing frame instead of
+          just skipping ahead, then resync to the next packet.*/
+        GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                    "Hole in audio stream, applying loss concealment
+");
+        if ( (NULL != dec) &&
+             (NULL != pcm_buffer) )
+        {
+          int ret;
+
+          ret = opus_decode_float (dec,
+                                   NULL, 0,
+                                   pcm_buffer,
+                                   MAX_FRAME_SIZE, 0);
+          if (0 < ret)
+          {
+            frame_size = ret;
+            link_out += audio_write (frame_size);
+          }
+        }
+        continue;
+      }
       /*OggOpus streams are identified by a magic string in the initial
         stream header.*/
       if (op.b_o_s && op.bytes >= 8 && !memcmp (op.packet, "OpusHead", 8))
@@ -636,9 +680,18 @@ context_state_callback (pa_context *c,
     pa_stream_set_write_callback (stream_out,
 				  &stream_write_callback,
 				  NULL);
+    /* ask the server to buffer enough audio to absorb network
+       jitter, but not so much that voice latency suffers */
+    buffer_attr.maxlength = (uint32_t) -1;
+    buffer_attr.tlength = pa_usec_to_bytes (BUFFER_TARGET_MS * PA_USEC_PER_MSEC,
+					    &sample_spec);
+    buffer_attr.prebuf = pa_usec_to_bytes (BUFFER_PREBUF_MS * PA_USEC_PER_MSEC,
+					   &sample_spec);
+    buffer_attr.minreq = (uint32_t) -1;
+    buffer_attr.fragsize = (uint32_t) -1;
     if ((p =
 	 pa_stream_connect_playback (stream_out, NULL,
-				     NULL,
+				     &buffer_attr,
 				     PA_STREAM_ADJUST_LATENCY | PA_STREAM_INTERPOLATE_TIMING | PA_STREAM_AUTO_TIMING_UPDATE,
 				     NULL,  NULL)) < 0)
     {
@@ -531,7 +531,9 @@ transmit_message (void *cls,
   struct PeerRecord *pr;
   struct SendMessage *sm;
   const struct GNUNET_MessageHeader *hdr;
+  char *cbuf = buf;
   uint16_t msize;
+  size_t tsize;
   size_t ret;
 
   GNUNET_assert (h->reconnect_task == NULL);
@@ -543,108 +545,113 @@ transmit_message (void *cls,
     reconnect_later (h);
     return 0;
   }
-  /* first check for control messages */
-  if (NULL != (cm = h->control_pending_head))
+  /* Pack as many pending messages as fit into the buffer, so that
+     one wakeup of the service can process a whole batch.  Control
+     messages have priority over 'ready' P2P messages; note that
+     writing a SEND may queue new SEND_REQUEST control messages. */
+  tsize = 0;
+  while (1)
   {
-    hdr = (const struct GNUNET_MessageHeader *) &cm[1];
-    msize = ntohs (hdr->size);
-    if (size < msize)
+    if (NULL != (cm = h->control_pending_head))
     {
-      trigger_next_request (h, GNUNET_NO);
-      return 0;
+      hdr = (const struct GNUNET_MessageHeader *) &cm[1];
+      msize = ntohs (hdr->size);
+      if (size - tsize < msize)
+        break;
+      LOG (GNUNET_ERROR_TYPE_DEBUG,
+           "Transmitting control message with %u bytes of type %u to core.\n",
+           (unsigned int) msize,
+           (unsigned int) ntohs (hdr->type));
+      memcpy (&cbuf[tsize], hdr, msize);
+      tsize += msize;
+      GNUNET_CONTAINER_DLL_remove (h->control_pending_head,
+                                   h->control_pending_tail, cm);
+      if (NULL != cm->th)
+        cm->th->cm = NULL;
+      if (NULL != cm->cont)
+        cm->cont (cm->cont_cls, GNUNET_OK);
+      GNUNET_free (cm);
+      continue;
     }
+    /* now check for 'ready' P2P messages */
+    if (NULL == (pr = h->ready_peer_head))
+      break;
+    GNUNET_assert (NULL != pr->th.peer);
+    th = &pr->th;
+    if (size - tsize < th->msize + sizeof (struct SendMessage))
+      break;
+    GNUNET_CONTAINER_DLL_remove (h->ready_peer_head,
+                                 h->ready_peer_tail,
+                                 pr);
+    th->peer = NULL;
     LOG (GNUNET_ERROR_TYPE_DEBUG,
-         "Transmitting control message with %u bytes of type %u to core.\n",
-         (unsigned int) msize,
-         (unsigned int) ntohs (hdr->type));
-    memcpy (buf, hdr, msize);
-    GNUNET_CONTAINER_DLL_remove (h->control_pending_head,
-                                 h->control_pending_tail, cm);
-    if (NULL != cm->th)
-      cm->th->cm = NULL;
-    if (NULL != cm->cont)
-      cm->cont (cm->cont_cls, GNUNET_OK);
-    GNUNET_free (cm);
-    trigger_next_request (h, GNUNET_NO);
-    return msize;
-  }
-  /* now check for 'ready' P2P messages */
-  if (NULL == (pr = h->ready_peer_head))
-    return 0;
-  GNUNET_assert (NULL != pr->th.peer);
-  th = &pr->th;
-  if (size < th->msize + sizeof (struct SendMessage))
-  {
-    trigger_next_request (h, GNUNET_NO);
-    return 0;
-  }
-  GNUNET_CONTAINER_DLL_remove (h->ready_peer_head,
-                               h->ready_peer_tail,
-                               pr);
-  th->peer = NULL;
-  LOG (GNUNET_ERROR_TYPE_DEBUG,
-       "Transmitting SEND request to `%s' with %u bytes.\n",
-       GNUNET_i2s (&pr->peer),
-       (unsigned int) th->msize);
-  sm = (struct SendMessage *) buf;
-  sm->header.type = htons (GNUNET_MESSAGE_TYPE_CORE_SEND);
-  sm->priority = htonl ((uint32_t) th->priority);
-  sm->deadline = GNUNET_TIME_absolute_hton (th->deadline);
-  sm->peer = pr->peer;
-  sm->cork = htonl ((uint32_t) th->cork);
-  sm->reserved = htonl (0);
-  ret =
-    th->get_message (th->get_message_cls,
-		     size - sizeof (struct SendMessage),
-                     &sm[1]);
-  delay = GNUNET_TIME_absolute_get_duration (th->request_time);
-  overdue = GNUNET_TIME_absolute_get_duration (th->deadline);
-  if (overdue.rel_value_us > GNUNET_CONSTANTS_LATENCY_WARN.rel_value_us)
-    LOG (GNUNET_ERROR_TYPE_WARNING,
-         "Transmitting overdue %u bytes to `%s' at priority %u with %s delay%s\n",
-         ret,
-         GNUNET_i2s (&pr->peer),
-         (unsigned int) th->priority,
-         GNUNET_STRINGS_relative_time_to_string (delay,
-                                                 GNUNET_YES),
-         (th->cork) ? " (corked)" : "");
-  else
-    LOG (GNUNET_ERROR_TYPE_DEBUG,
-         "Transmitting %u bytes to `%s' at priority %u with %s delay%s\n",
-         ret,
+         "Transmitting SEND request to `%s' with %u bytes.\n",
          GNUNET_i2s (&pr->peer),
-         (unsigned int) th->priority,
-         GNUNET_STRINGS_relative_time_to_string (delay,
-                                                 GNUNET_YES),
-         (th->cork) ? " (corked)" : "");
-  if ( (0 == ret) &&
-       (GNUNET_CORE_PRIO_BACKGROUND == th->priority) )
-  {
-    /* client decided to send nothing; as the priority was
-       BACKGROUND, we can just not send anything to core.
-       For higher-priority messages, we must give an
-       empty message to CORE so that it knows that this
-       message is no longer pending. */
+         (unsigned int) th->msize);
+    sm = (struct SendMessage *) &cbuf[tsize];
+    sm->header.type = htons (GNUNET_MESSAGE_TYPE_CORE_SEND);
+    sm->priority = htonl ((uint32_t) th->priority);
+    sm->deadline = GNUNET_TIME_absolute_hton (th->deadline);
+    sm->peer = pr->peer;
+    sm->cork = htonl ((uint32_t) th->cork);
+    sm->reserved = htonl (0);
+    ret =
+      th->get_message (th->get_message_cls,
+                       size - tsize - sizeof (struct SendMessage),
+                       &sm[1]);
+    delay = GNUNET_TIME_absolute_get_duration (th->request_time);
+    overdue = GNUNET_TIME_absolute_get_duration (th->deadline);
+    if (overdue.rel_value_us > GNUNET_CONSTANTS_LATENCY_WARN.rel_value_us)
+      LOG (GNUNET_ERROR_TYPE_WARNING,
+           "Transmitting overdue %u bytes to `%s' at priority %u with %s delay%s\n",
+           ret,
+           GNUNET_i2s (&pr->peer),
+           (unsigned int) th->priority,
+           GNUNET_STRINGS_relative_time_to_string (delay,
+                                                   GNUNET_YES),
+           (th->cork) ? " (corked)" : "");
+    else
+      LOG (GNUNET_ERROR_TYPE_DEBUG,
+           "Transmitting %u bytes to `%s' at priority %u with %s delay%s\n",
+           ret,
+           GNUNET_i2s (&pr->peer),
+           (unsigned int) th->priority,
+           GNUNET_STRINGS_relative_time_to_string (delay,
+                                                   GNUNET_YES),
+           (th->cork) ? " (corked)" : "");
+    if ( (0 == ret) &&
+         (GNUNET_CORE_PRIO_BACKGROUND == th->priority) )
+    {
+      /* client decided to send nothing; as the priority was
+         BACKGROUND, we can just not send anything to core.
+         For higher-priority messages, we must give an
+         empty message to CORE so that it knows that this
+         message is no longer pending. */
+      LOG (GNUNET_ERROR_TYPE_DEBUG,
+	   "Size of clients message to peer %s is 0!\n",
+	   GNUNET_i2s (&pr->peer));
+      request_next_transmission (pr);
+      continue;
+    }
     LOG (GNUNET_ERROR_TYPE_DEBUG,
-	 "Size of clients message to peer %s is 0!\n",
-	 GNUNET_i2s (&pr->peer));
-    request_next_transmission (pr);
-    return 0;
-  }
-  LOG (GNUNET_ERROR_TYPE_DEBUG,
-       "Produced SEND message to core with %u bytes payload\n",
-       (unsigned int) ret);
-  if (ret + sizeof (struct SendMessage) >= GNUNET_SERVER_MAX_MESSAGE_SIZE)
-  {
-    GNUNET_break (0);
+         "Produced SEND message to core with %u bytes payload\n",
+         (unsigned int) ret);
+    if (ret + sizeof (struct SendMessage) >= GNUNET_SERVER_MAX_MESSAGE_SIZE)
+    {
+      GNUNET_break (0);
+      request_next_transmission (pr);
+      continue;
+    }
+    ret += sizeof (struct SendMessage);
+    sm->header.size = htons (ret);
+    tsize += ret;
+    GNUNET_assert (tsize <= size);
     request_next_transmission (pr);
-    return 0;
   }
-  ret += sizeof (struct SendMessage);
-  sm->header.size = htons (ret);
-  GNUNET_assert (ret <= size);
-  request_next_transmission (pr);
-  return ret;
+  if ( (NULL != h->control_pending_head) ||
+       (NULL != h->ready_peer_head) )
+    trigger_next_request (h, GNUNET_NO);
+  return tsize;
 }
 
 
@@ -658,7 +665,9 @@ static void
 trigger_next_request (struct GNUNET_CORE_Handle *h,
                       int ignore_currently_down)
 {
-  uint16_t msize;
+  struct ControlMessage *cm;
+  struct PeerRecord *pr;
+  size_t msize;
 
   if ( (GNUNET_YES == h->currently_down) &&
        (GNUNET_NO == ignore_currently_down) )
@@ -673,19 +682,21 @@ trigger_next_request (struct GNUNET_CORE_Handle *h,
          "Request pending, not processing queue\n");
     return;
   }
-  if (NULL != h->control_pending_head)
-    msize =
-        ntohs (((struct GNUNET_MessageHeader *) &h->
-                control_pending_head[1])->size);
-  else if (h->ready_peer_head != NULL)
-    msize =
-      h->ready_peer_head->th.msize + sizeof (struct SendMessage);
-  else
+  /* Request enough buffer for everything that is pending, so a
+     single wakeup can transmit the whole batch. */
+  msize = 0;
+  for (cm = h->control_pending_head; NULL != cm; cm = cm->next)
+    msize += ntohs (((struct GNUNET_MessageHeader *) &cm[1])->size);
+  for (pr = h->ready_peer_head; NULL != pr; pr = pr->next)
+    msize += pr->th.msize + sizeof (struct SendMessage);
+  if (0 == msize)
   {
     LOG (GNUNET_ERROR_TYPE_DEBUG,
          "Request queue empty, not processing queue\n");
     return;                     /* no pending message */
   }
+  msize = GNUNET_MIN (msize,
+                      GNUNET_SERVER_MAX_MESSAGE_SIZE - 1);
   h->cth =
       GNUNET_CLIENT_notify_transmit_ready (h->client, msize,
                                            GNUNET_TIME_UNIT_FOREVER_REL,
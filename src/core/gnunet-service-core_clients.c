@@ -70,6 +70,12 @@ struct GSC_Client
    */
   const uint16_t *types;
 
+  /**
+   * Bitset over @e types for constant-time interest tests;
+   * NULL if @e tcnt is zero.
+   */
+  struct GSC_TypeMap *tmap;
+
   /**
    * Map of peer identities to active transmission requests of this
    * client to the peer (of type `struct GSC_ClientActiveRequest`).
@@ -197,14 +203,9 @@ GSC_CLIENTS_send_to_client (struct GNUNET_SERVER_Client *client,
 static int
 type_match (uint16_t type, struct GSC_Client *c)
 {
-  unsigned int i;
-
   if (c->tcnt == 0)
     return GNUNET_YES;          /* peer without handlers matches ALL */
-  for (i = 0; i < c->tcnt; i++)
-    if (type == c->types[i])
-      return GNUNET_YES;
-  return GNUNET_NO;
+  return GSC_TYPEMAP_test_match (c->tmap, &type, 1);
 }
 
 
@@ -312,6 +313,10 @@ handle_client_init (void *cls,
   wtypes = (uint16_t *) & c[1];
   for (i = 0; i < c->tcnt; i++)
     wtypes[i] = ntohs (types[i]);
+  if (0 < c->tcnt)
+    c->tmap = GSC_TYPEMAP_extend (NULL,
+                                  wtypes,
+                                  c->tcnt);
   GSC_TYPEMAP_add (wtypes, c->tcnt);
   GNUNET_CONTAINER_DLL_insert (client_head, client_tail, c);
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
@@ -662,6 +667,8 @@ handle_client_disconnect (void *cls,
   GNUNET_CONTAINER_multipeermap_destroy (c->connectmap);
   c->connectmap = NULL;
   GSC_TYPEMAP_remove (c->types, c->tcnt);
+  if (NULL != c->tmap)
+    GSC_TYPEMAP_destroy (c->tmap);
   GNUNET_free (c);
 
   /* recalculate 'all_client_options' */
@@ -65,6 +65,23 @@
  */
 #define MAX_MESSAGE_AGE GNUNET_TIME_UNIT_DAYS
 
+/**
+ * How many ECDH results do we cache?  A reconnecting peer usually
+ * presents the same ephemeral key as before, so remembering recent
+ * results lets us skip the expensive ECDH operation during reconnect
+ * storms.  The cache is flushed whenever our own ephemeral key
+ * changes.
+ */
+#define ECDH_CACHE_SIZE 128
+
+/**
+ * How many connections do we process per task invocation when we
+ * re-derive session keys after changing our ephemeral key?  Chunking
+ * the work keeps a rekey over many connections from blocking message
+ * processing for the combined duration of all ECDH operations.
+ */
+#define REKEY_BATCH_SIZE 16
+
 
 
 GNUNET_NETWORK_STRUCT_BEGIN
@@ -379,6 +396,141 @@ static struct GNUNET_SCHEDULER_Task *rekey_task;
  */
 static struct GNUNET_SERVER_NotificationContext *nc;
 
+/**
+ * Cached result of an ECDH operation against our current ephemeral
+ * key, in a DLL ordered by recency of use.
+ */
+struct EcdhCacheEntry
+{
+  /**
+   * Kept in a DLL, most recently used first.
+   */
+  struct EcdhCacheEntry *next;
+
+  /**
+   * Kept in a DLL.
+   */
+  struct EcdhCacheEntry *prev;
+
+  /**
+   * Ephemeral public key of the other peer the result is for.
+   */
+  struct GNUNET_CRYPTO_EcdhePublicKey other_key;
+
+  /**
+   * The derived key material.
+   */
+  struct GNUNET_HashCode key_material;
+};
+
+/**
+ * Head of ECDH result cache DLL (most recently used first).
+ */
+static struct EcdhCacheEntry *ecdh_cache_head;
+
+/**
+ * Tail of ECDH result cache DLL (least recently used last).
+ */
+static struct EcdhCacheEntry *ecdh_cache_tail;
+
+/**
+ * Number of entries in the ECDH result cache.
+ */
+static unsigned int ecdh_cache_size;
+
+/**
+ * Next connection to process in the current chunked rekey pass,
+ * NULL if no pass is in progress.
+ */
+static struct GSC_KeyExchangeInfo *rekey_pos;
+
+/**
+ * Task processing the next chunk of connections during a rekey.
+ */
+static struct GNUNET_SCHEDULER_Task *rekey_batch_task;
+
+
+/**
+ * Discard all cached ECDH results; needed whenever our own
+ * ephemeral key changes.
+ */
+static void
+flush_ecdh_cache ()
+{
+  struct EcdhCacheEntry *ece;
+
+  while (NULL != (ece = ecdh_cache_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (ecdh_cache_head,
+                                 ecdh_cache_tail,
+                                 ece);
+    memset (ece, 0, sizeof (struct EcdhCacheEntry));
+    GNUNET_free (ece);
+  }
+  ecdh_cache_size = 0;
+}
+
+
+/**
+ * Compute the shared key material for our current ephemeral key and
+ * the given public key of the other peer, using a cached result if
+ * we have one.
+ *
+ * @param other_key ephemeral public key of the other peer
+ * @param key_material[out] set to the derived key material
+ * @return #GNUNET_OK on success, #GNUNET_SYSERR if ECDH failed
+ */
+static int
+cached_ecdh (const struct GNUNET_CRYPTO_EcdhePublicKey *other_key,
+             struct GNUNET_HashCode *key_material)
+{
+  struct EcdhCacheEntry *ece;
+
+  for (ece = ecdh_cache_head; NULL != ece; ece = ece->next)
+    if (0 == memcmp (other_key,
+                     &ece->other_key,
+                     sizeof (struct GNUNET_CRYPTO_EcdhePublicKey)))
+    {
+      GNUNET_STATISTICS_update (GSC_stats,
+                                gettext_noop ("# ECDH operations avoided via cache"),
+                                1, GNUNET_NO);
+      *key_material = ece->key_material;
+      /* move to front for LRU */
+      GNUNET_CONTAINER_DLL_remove (ecdh_cache_head,
+                                   ecdh_cache_tail,
+                                   ece);
+      GNUNET_CONTAINER_DLL_insert (ecdh_cache_head,
+                                   ecdh_cache_tail,
+                                   ece);
+      return GNUNET_OK;
+    }
+  if (GNUNET_OK !=
+      GNUNET_CRYPTO_ecc_ecdh (my_ephemeral_key,
+                              other_key,
+                              key_material))
+    return GNUNET_SYSERR;
+  if (ecdh_cache_size >= ECDH_CACHE_SIZE)
+  {
+    ece = ecdh_cache_tail;
+    GNUNET_CONTAINER_DLL_remove (ecdh_cache_head,
+                                 ecdh_cache_tail,
+                                 ece);
+    memset (ece, 0, sizeof (struct EcdhCacheEntry));
+    ecdh_cache_size--;
+  }
+  else
+  {
+    ece = GNUNET_new (struct EcdhCacheEntry);
+  }
+  ece->other_key = *other_key;
+  ece->key_material = *key_material;
+  GNUNET_CONTAINER_DLL_insert (ecdh_cache_head,
+                               ecdh_cache_tail,
+                               ece);
+  ecdh_cache_size++;
+  return GNUNET_OK;
+}
+
 
 /**
  * Inform the given monitor about the KX state of
@@ -778,6 +930,8 @@ GSC_KX_stop (struct GSC_KeyExchangeInfo *kx)
   }
   kx->status = GNUNET_CORE_KX_PEER_DISCONNECT;
   monitor_notify_all (kx);
+  if (rekey_pos == kx)
+    rekey_pos = kx->next;
   GNUNET_CONTAINER_DLL_remove (kx_head,
 			       kx_tail,
 			       kx);
@@ -814,9 +968,8 @@ derive_session_keys (struct GSC_KeyExchangeInfo *kx)
   struct GNUNET_HashCode key_material;
 
   if (GNUNET_OK !=
-      GNUNET_CRYPTO_ecc_ecdh (my_ephemeral_key,
-			      &kx->other_ephemeral_key,
-			      &key_material))
+      cached_ecdh (&kx->other_ephemeral_key,
+                   &key_material))
   {
     GNUNET_break (0);
     return;
@@ -1695,29 +1848,27 @@ sign_ephemeral_key ()
 
 
 /**
- * Task run to trigger rekeying.
+ * Task processing the next #REKEY_BATCH_SIZE connections of the
+ * current rekey pass, re-scheduling itself until #rekey_pos has
+ * reached the end of the connection list.
  *
  * @param cls closure, NULL
  * @param tc scheduler context
  */
 static void
-do_rekey (void *cls,
-	  const struct GNUNET_SCHEDULER_TaskContext *tc)
+rekey_batch (void *cls,
+             const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
   struct GSC_KeyExchangeInfo *pos;
+  unsigned int i;
 
-  rekey_task = GNUNET_SCHEDULER_add_delayed (REKEY_FREQUENCY,
-					     &do_rekey,
-					     NULL);
-  if (NULL != my_ephemeral_key)
-    GNUNET_free (my_ephemeral_key);
-  GNUNET_log (GNUNET_ERROR_TYPE_INFO,
-              "Rekeying\n");
-  my_ephemeral_key = GNUNET_CRYPTO_ecdhe_key_create ();
-  GNUNET_assert (NULL != my_ephemeral_key);
-  sign_ephemeral_key ();
-  for (pos = kx_head; NULL != pos; pos = pos->next)
+  rekey_batch_task = NULL;
+  i = 0;
+  while ( (NULL != (pos = rekey_pos)) &&
+          (i < REKEY_BATCH_SIZE) )
   {
+    rekey_pos = pos->next;
+    i++;
     if (GNUNET_CORE_KX_STATE_UP == pos->status)
     {
       pos->status = GNUNET_CORE_KX_STATE_REKEY_SENT;
@@ -1732,6 +1883,38 @@ do_rekey (void *cls,
     monitor_notify_all (pos);
     send_key (pos);
   }
+  if (NULL != rekey_pos)
+    rekey_batch_task = GNUNET_SCHEDULER_add_now (&rekey_batch,
+                                                 NULL);
+}
+
+
+/**
+ * Task run to trigger rekeying.
+ *
+ * @param cls closure, NULL
+ * @param tc scheduler context
+ */
+static void
+do_rekey (void *cls,
+	  const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  rekey_task = GNUNET_SCHEDULER_add_delayed (REKEY_FREQUENCY,
+					     &do_rekey,
+					     NULL);
+  if (NULL != my_ephemeral_key)
+    GNUNET_free (my_ephemeral_key);
+  GNUNET_log (GNUNET_ERROR_TYPE_INFO,
+              "Rekeying\n");
+  my_ephemeral_key = GNUNET_CRYPTO_ecdhe_key_create ();
+  GNUNET_assert (NULL != my_ephemeral_key);
+  flush_ecdh_cache ();
+  sign_ephemeral_key ();
+  rekey_pos = kx_head;
+  if ( (NULL != rekey_pos) &&
+       (NULL == rekey_batch_task) )
+    rekey_batch_task = GNUNET_SCHEDULER_add_now (&rekey_batch,
+                                                 NULL);
 }
 
 
@@ -1779,6 +1962,13 @@ GSC_KX_done ()
     GNUNET_SCHEDULER_cancel (rekey_task);
     rekey_task = NULL;
   }
+  if (NULL != rekey_batch_task)
+  {
+    GNUNET_SCHEDULER_cancel (rekey_batch_task);
+    rekey_batch_task = NULL;
+  }
+  rekey_pos = NULL;
+  flush_ecdh_cache ();
   if (NULL != my_ephemeral_key)
   {
     GNUNET_free (my_ephemeral_key);
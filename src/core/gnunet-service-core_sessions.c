@@ -102,6 +102,13 @@ struct Session
    */
   struct GSC_ClientActiveRequest *active_client_request_tail;
 
+  /**
+   * Number of queued requests in @e active_client_request_head that
+   * have not been solicited yet, per priority level.  Lets us find
+   * the highest pending priority without walking the request list.
+   */
+  unsigned int unsolicited_requests[GNUNET_CORE_PRIO_CRITICAL_CONTROL + 1];
+
   /**
    * Head of list of messages ready for encryption.
    */
@@ -201,6 +208,40 @@ find_session (const struct GNUNET_PeerIdentity *peer)
 }
 
 
+/**
+ * Clamp a client-supplied priority to the bucket range we track.
+ *
+ * @param priority priority to clamp
+ * @return index into the per-priority request counters
+ */
+static unsigned int
+priority_bucket (enum GNUNET_CORE_Priority priority)
+{
+  return GNUNET_MIN ((unsigned int) priority,
+                     (unsigned int) GNUNET_CORE_PRIO_CRITICAL_CONTROL);
+}
+
+
+/**
+ * Determine the highest priority among the queued requests that
+ * have not been solicited yet.
+ *
+ * @param session session to inspect
+ * @return highest pending priority, #GNUNET_CORE_PRIO_BACKGROUND
+ *         if there are no unsolicited requests
+ */
+static enum GNUNET_CORE_Priority
+max_unsolicited_priority (const struct Session *session)
+{
+  unsigned int i;
+
+  for (i = GNUNET_CORE_PRIO_CRITICAL_CONTROL + 1; i > 0; i--)
+    if (0 < session->unsolicited_requests[i - 1])
+      return (enum GNUNET_CORE_Priority) (i - 1);
+  return GNUNET_CORE_PRIO_BACKGROUND;
+}
+
+
 /**
  * End the session with the given peer (we are no longer
  * connected).
@@ -503,6 +544,8 @@ GSC_SESSIONS_queue_request (struct GSC_ClientActiveRequest *car)
   GNUNET_CONTAINER_DLL_insert (session->active_client_request_head,
                                session->active_client_request_tail,
                                car);
+  if (GNUNET_NO == car->was_solicited)
+    session->unsolicited_requests[priority_bucket (car->priority)]++;
   try_transmission (session);
 }
 
@@ -528,6 +571,11 @@ GSC_SESSIONS_dequeue_request (struct GSC_ClientActiveRequest *car)
   GNUNET_CONTAINER_DLL_remove (session->active_client_request_head,
                                session->active_client_request_tail,
                                car);
+  if (GNUNET_NO == car->was_solicited)
+  {
+    GNUNET_assert (0 < session->unsolicited_requests[priority_bucket (car->priority)]);
+    session->unsolicited_requests[priority_bucket (car->priority)]--;
+  }
   /* dequeueing of 'high' priority messages may unblock
      transmission for lower-priority messages, so we also
      need to try in this case. */
@@ -552,13 +600,7 @@ solicit_messages (struct Session *session,
   enum GNUNET_CORE_Priority pmax;
 
   so_size = msize;
-  pmax = GNUNET_CORE_PRIO_BACKGROUND;
-  for (car = session->active_client_request_head; NULL != car; car = car->next)
-  {
-    if (GNUNET_YES == car->was_solicited)
-      continue;
-    pmax = GNUNET_MAX (pmax, car->priority);
-  }
+  pmax = max_unsolicited_priority (session);
   nxt = session->active_client_request_head;
   while (NULL != (car = nxt))
   {
@@ -571,6 +613,8 @@ solicit_messages (struct Session *session,
     if (GNUNET_YES == car->was_solicited)
       continue;
     car->was_solicited = GNUNET_YES;
+    GNUNET_assert (0 < session->unsolicited_requests[priority_bucket (car->priority)]);
+    session->unsolicited_requests[priority_bucket (car->priority)]--;
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                 "Soliciting message with priority %u\n",
                 car->priority);
@@ -618,7 +662,6 @@ try_transmission (struct Session *session)
   struct GNUNET_TIME_Absolute min_deadline;
   enum GNUNET_CORE_Priority maxp;
   enum GNUNET_CORE_Priority maxpc;
-  struct GSC_ClientActiveRequest *car;
   int excess;
 
   if (GNUNET_YES != session->ready_to_transmit)
@@ -670,13 +713,8 @@ try_transmission (struct Session *session)
       maxpc = GNUNET_CORE_PRIO_BACKGROUND;
     else
       maxpc = GNUNET_CORE_PRIO_BEST_EFFORT;
-    for (car = session->active_client_request_head; NULL != car; car = car->next)
-    {
-      if (GNUNET_YES == car->was_solicited)
-        continue;
-      maxpc = GNUNET_MAX (maxpc,
-                          car->priority);
-    }
+    maxpc = GNUNET_MAX (maxpc,
+                        max_unsolicited_priority (session));
     if (maxpc > maxp)
     {
       /* we have messages waiting for solicitation that have a higher
@@ -62,6 +62,22 @@ static struct GNUNET_HashCode my_tm_hash;
  */
 static int hash_current;
 
+/**
+ * Generation of our type map; incremented whenever the map changes.
+ */
+static unsigned int my_tm_generation;
+
+/**
+ * Cached (compressed) type map message, computed on demand;
+ * NULL if it has not been computed for the current generation.
+ */
+static struct GNUNET_MessageHeader *my_tm_msg;
+
+/**
+ * Generation #my_tm_msg was computed for.
+ */
+static unsigned int my_tm_msg_generation;
+
 
 /**
  * Our type map changed, recompute its hash.
@@ -70,6 +86,7 @@ static void
 rehash_typemap ()
 {
   hash_current = GNUNET_NO;
+  my_tm_generation++;
 }
 
 
@@ -110,7 +127,9 @@ GSC_TYPEMAP_check_hash (const struct GNUNET_HashCode *hc)
 
 
 /**
- * Compute a type map message for this peer.
+ * Compute a type map message for this peer.  As the (re-)compression
+ * of the map is expensive and sessions periodically refresh their
+ * type map transmissions, we cache the result until the map changes.
  *
  * @return this peers current type map message.
  */
@@ -120,7 +139,16 @@ GSC_TYPEMAP_compute_type_map_message ()
   char *tmp;
   uLongf dlen;
   struct GNUNET_MessageHeader *hdr;
+  uint16_t size;
 
+  if ( (NULL != my_tm_msg) &&
+       (my_tm_msg_generation == my_tm_generation) )
+  {
+    size = ntohs (my_tm_msg->size);
+    hdr = GNUNET_malloc (size);
+    memcpy (hdr, my_tm_msg, size);
+    return hdr;
+  }
 #ifdef compressBound
   dlen = compressBound (sizeof (my_type_map));
 #else
@@ -144,7 +172,12 @@ GSC_TYPEMAP_compute_type_map_message ()
     /* compression worked, use compressed map */
     hdr->type = htons (GNUNET_MESSAGE_TYPE_CORE_COMPRESSED_TYPE_MAP);
   }
-  hdr->size = htons ((uint16_t) dlen + sizeof (struct GNUNET_MessageHeader));
+  size = (uint16_t) dlen + sizeof (struct GNUNET_MessageHeader);
+  hdr->size = htons (size);
+  GNUNET_free_non_null (my_tm_msg);
+  my_tm_msg = GNUNET_malloc (size);
+  memcpy (my_tm_msg, hdr, size);
+  my_tm_msg_generation = my_tm_generation;
   return hdr;
 }
 
@@ -366,7 +399,11 @@ GSC_TYPEMAP_init ()
 void
 GSC_TYPEMAP_done ()
 {
-  /* nothing to do */
+  if (NULL != my_tm_msg)
+  {
+    GNUNET_free (my_tm_msg);
+    my_tm_msg = NULL;
+  }
 }
 
 /* end of gnunet-service-core_typemap.c */
@@ -119,6 +119,26 @@ run (void *cls, char *const *args, const char *cfgfile,
     GAUGER (gstr, "Time to GET item from datacache",
             GNUNET_TIME_absolute_get_duration (start).rel_value_us / 1000LL / found,
             "ms/item");
+  /* The cache is at quota now, so each further PUT must evict;
+     this measures insertion under eviction load. */
+  start = GNUNET_TIME_absolute_get ();
+  for (i = 0; i < ITERATIONS; i++)
+  {
+    if (0 == i % (ITERATIONS / 80))
+      FPRINTF (stderr, "%s",  ".");
+    GNUNET_CRYPTO_hash (&k, sizeof (struct GNUNET_HashCode), &n);
+    ASSERT (GNUNET_OK ==
+            GNUNET_DATACACHE_put (h, &k, sizeof (struct GNUNET_HashCode),
+                                  (const char *) &n, 1 + i % 16, exp,
+				  0, NULL));
+    k = n;
+  }
+  FPRINTF (stderr, "%s",  "\n");
+  FPRINTF (stdout, "Stored %u items with eviction in %s\n", ITERATIONS,
+	   GNUNET_STRINGS_relative_time_to_string (GNUNET_TIME_absolute_get_duration (start), GNUNET_YES));
+  GAUGER (gstr, "Time to PUT item in datacache under eviction",
+          GNUNET_TIME_absolute_get_duration (start).rel_value_us / 1000LL / ITERATIONS,
+          "ms/item");
   GNUNET_DATACACHE_destroy (h);
   ASSERT (ok == 0);
   return;
@@ -451,7 +451,10 @@ libgnunet_plugin_datacache_heap_init (void *cls)
   struct Plugin *plugin;
 
   plugin = GNUNET_new (struct Plugin);
-  plugin->map = GNUNET_CONTAINER_multihashmap_create (1024,  /* FIXME: base on quota! */
+  /* size the map for the quota (assuming ~4k per entry), so that a
+     full cache does not pay for repeated rehashing as it grows */
+  plugin->map = GNUNET_CONTAINER_multihashmap_create (GNUNET_MAX (1024,
+                                                                  env->quota / 4096),
 						      GNUNET_YES);
   plugin->heap = GNUNET_CONTAINER_heap_create (GNUNET_CONTAINER_HEAP_ORDER_MIN);
   plugin->env = env;
@@ -59,6 +59,23 @@ struct Plugin
    */
   char *fn;
 
+  /**
+   * Prepared statement for #sqlite_plugin_put().
+   */
+  sqlite3_stmt *insert_stmt;
+
+  /**
+   * Prepared statement for finding the oldest entry
+   * in #sqlite_plugin_del().
+   */
+  sqlite3_stmt *del_select_stmt;
+
+  /**
+   * Prepared statement for removing an entry by ROWID
+   * in #sqlite_plugin_del().
+   */
+  sqlite3_stmt *del_stmt;
+
   /**
    * Number of key-value pairs in the database.
    */
@@ -143,16 +160,18 @@ sqlite_plugin_put (void *cls,
   dval = (int64_t) discard_time.abs_value_us;
   if (dval < 0)
     dval = INT64_MAX;
-  if (sq_prepare
-      (plugin->dbh,
-       "INSERT INTO ds090 (type, expire, key, value, path) VALUES (?, ?, ?, ?, ?)",
-       &stmt) != SQLITE_OK)
+  if ( (NULL == plugin->insert_stmt) &&
+       (SQLITE_OK !=
+        sq_prepare (plugin->dbh,
+                    "INSERT INTO ds090 (type, expire, key, value, path) VALUES (?, ?, ?, ?, ?)",
+                    &plugin->insert_stmt)) )
   {
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                 "sq_prepare");
     return -1;
   }
+  stmt = plugin->insert_stmt;
   if ((SQLITE_OK != sqlite3_bind_int (stmt, 1, type)) ||
       (SQLITE_OK != sqlite3_bind_int64 (stmt, 2, dval)) ||
       (SQLITE_OK !=
@@ -170,7 +189,7 @@ sqlite_plugin_put (void *cls,
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                 "sqlite3_bind_xxx");
-    sqlite3_finalize (stmt);
+    (void) sqlite3_reset (stmt);
     return -1;
   }
   if (SQLITE_DONE != sqlite3_step (stmt))
@@ -178,14 +197,14 @@ sqlite_plugin_put (void *cls,
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                 "sqlite3_step");
-    sqlite3_finalize (stmt);
+    (void) sqlite3_reset (stmt);
     return -1;
   }
   plugin->num_items++;
-  if (SQLITE_OK != sqlite3_finalize (stmt))
+  if (SQLITE_OK != sqlite3_reset (stmt))
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
-                "sqlite3_finalize");
+                "sqlite3_reset");
   return size + OVERHEAD;
 }
 
@@ -362,53 +381,52 @@ sqlite_plugin_del (void *cls)
 
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Processing DEL\n");
-  stmt = NULL;
-  dstmt = NULL;
-  if (SQLITE_OK !=
-      sq_prepare (plugin->dbh,
-                  "SELECT _ROWID_,key,value FROM ds090 ORDER BY expire ASC LIMIT 1",
-                  &stmt))
+  if ( (NULL == plugin->del_select_stmt) &&
+       (SQLITE_OK !=
+        sq_prepare (plugin->dbh,
+                    "SELECT _ROWID_,key,value FROM ds090 ORDER BY expire ASC LIMIT 1",
+                    &plugin->del_select_stmt)) )
   {
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                 "sq_prepare");
-    if (stmt != NULL)
-      (void) sqlite3_finalize (stmt);
     return GNUNET_SYSERR;
   }
+  stmt = plugin->del_select_stmt;
   if (SQLITE_ROW != sqlite3_step (stmt))
   {
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                 "sqlite3_step");
-    (void) sqlite3_finalize (stmt);
+    (void) sqlite3_reset (stmt);
     return GNUNET_SYSERR;
   }
   rowid = sqlite3_column_int64 (stmt, 0);
   GNUNET_assert (sqlite3_column_bytes (stmt, 1) == sizeof (struct GNUNET_HashCode));
   memcpy (&hc, sqlite3_column_blob (stmt, 1), sizeof (struct GNUNET_HashCode));
   dsize = sqlite3_column_bytes (stmt, 2);
-  if (SQLITE_OK != sqlite3_finalize (stmt))
+  if (SQLITE_OK != sqlite3_reset (stmt))
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
-                "sqlite3_step");
-  if (SQLITE_OK !=
-      sq_prepare (plugin->dbh,
-                  "DELETE FROM ds090 WHERE _ROWID_=?", &dstmt))
+                "sqlite3_reset");
+  if ( (NULL == plugin->del_stmt) &&
+       (SQLITE_OK !=
+        sq_prepare (plugin->dbh,
+                    "DELETE FROM ds090 WHERE _ROWID_=?",
+                    &plugin->del_stmt)) )
   {
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                 "sq_prepare");
-    if (stmt != NULL)
-      (void) sqlite3_finalize (stmt);
     return GNUNET_SYSERR;
   }
+  dstmt = plugin->del_stmt;
   if (SQLITE_OK != sqlite3_bind_int64 (dstmt, 1, rowid))
   {
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                 "sqlite3_bind");
-    (void) sqlite3_finalize (dstmt);
+    (void) sqlite3_reset (dstmt);
     return GNUNET_SYSERR;
   }
   if (SQLITE_DONE != sqlite3_step (dstmt))
@@ -416,17 +434,17 @@ sqlite_plugin_del (void *cls)
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                 "sqlite3_step");
-    (void) sqlite3_finalize (dstmt);
+    (void) sqlite3_reset (dstmt);
     return GNUNET_SYSERR;
   }
   plugin->num_items--;
   plugin->env->delete_notify (plugin->env->cls,
                               &hc,
                               dsize + OVERHEAD);
-  if (SQLITE_OK != sqlite3_finalize (dstmt))
+  if (SQLITE_OK != sqlite3_reset (dstmt))
     LOG_SQLITE (plugin->dbh,
                 GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
-                "sqlite3_finalize");
+                "sqlite3_reset");
   return GNUNET_OK;
 }
 
@@ -741,6 +759,12 @@ libgnunet_plugin_datacache_sqlite_done (void *cls)
                        plugin->fn);
   GNUNET_free_non_null (plugin->fn);
 #endif
+  if (NULL != plugin->insert_stmt)
+    (void) sqlite3_finalize (plugin->insert_stmt);
+  if (NULL != plugin->del_select_stmt)
+    (void) sqlite3_finalize (plugin->del_select_stmt);
+  if (NULL != plugin->del_stmt)
+    (void) sqlite3_finalize (plugin->del_stmt);
   result = sqlite3_close (plugin->dbh);
 #if SQLITE_VERSION_NUMBER >= 3007000
   if (SQLITE_BUSY == result)
@@ -187,6 +187,54 @@ struct UpdateMessage
 };
 
 
+/**
+ * Message from datastore client asking whether content with
+ * the given key and content hash is already present.  Sent
+ * before a PUT of a large block so that the data itself only
+ * has to be serialized and transmitted if it is actually new.
+ * The service answers with a StatusMessage: #GNUNET_NO if a
+ * matching entry was found (in which case priority and
+ * expiration have been merged as a duplicate PUT would have
+ * done), #GNUNET_YES if the content is not present and the
+ * client should transmit the full PUT.
+ */
+struct ProbeMessage
+{
+  /**
+   * Type is GNUNET_MESSAGE_TYPE_DATASTORE_PUT_PROBE.
+   */
+  struct GNUNET_MessageHeader header;
+
+  /**
+   * Type of the item (NBO), (actually an enum GNUNET_BLOCK_Type)
+   */
+  uint32_t type GNUNET_PACKED;
+
+  /**
+   * Priority of the item (NBO); added to the priority of an
+   * existing entry.
+   */
+  uint32_t priority GNUNET_PACKED;
+
+  /**
+   * Expiration time (NBO); an existing entry is extended to
+   * this time if it would expire earlier.
+   */
+  struct GNUNET_TIME_AbsoluteNBO expiration;
+
+  /**
+   * Key under which the item would be stored.
+   */
+  struct GNUNET_HashCode key;
+
+  /**
+   * Hash of the content.
+   */
+  struct GNUNET_HashCode vhash;
+
+};
+
+
 /**
  * Message transmitting content from or to the datastore
  * service.
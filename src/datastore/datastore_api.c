@@ -46,6 +46,25 @@
  */
 #define MAX_EXCESS_RESULTS 8
 
+/**
+ * Maximum number of requests that may be in transit to the service
+ * at the same time.  The service processes requests in order and the
+ * connection is a stream, so responses can be matched to requests
+ * first-in-first-out; keeping a window of requests in flight (instead
+ * of a single one) avoids paying a full IPC round-trip per operation.
+ * Each request in flight uses up one credit; the credit is returned
+ * when the response arrives.
+ */
+#define MAX_IN_FLIGHT 16
+
+/**
+ * Minimum size of a block for which we probe the service by (key,
+ * content hash) before transmitting the data (if PROBE_PUTS is
+ * enabled).  For smaller blocks the probe itself costs about as much
+ * as just sending the data.
+ */
+#define PROBE_SIZE_THRESHOLD 4096
+
 /**
  * Context for processing status messages.
  */
@@ -229,6 +248,12 @@ struct GNUNET_DATASTORE_Handle
    */
   unsigned int queue_size;
 
+  /**
+   * Number of requests that have been transmitted to the service
+   * and for which we have not yet received the response.
+   */
+  unsigned int in_flight;
+
   /**
    * Number of results we're receiving for the current query
    * after application stopped to care.  Used to determine when
@@ -242,9 +267,10 @@ struct GNUNET_DATASTORE_Handle
   int in_receive;
 
   /**
-   * We should ignore the next message(s) from the service.
+   * #GNUNET_YES if large PUTs should first probe the service by
+   * (key, content hash) and only transmit the data on a miss.
    */
-  unsigned int skip_next_messages;
+  int probe_puts;
 
 };
 
@@ -270,6 +296,8 @@ GNUNET_DATASTORE_connect (const struct GNUNET_CONFIGURATION_Handle *cfg)
   h->client = c;
   h->cfg = cfg;
   h->stats = GNUNET_STATISTICS_create ("datastore-api", cfg);
+  h->probe_puts =
+      GNUNET_CONFIGURATION_get_value_yesno (cfg, "DATASTORE", "PROBE_PUTS");
   return h;
 }
 
@@ -440,7 +468,8 @@ make_queue_entry (struct GNUNET_DATASTORE_Handle *h,
   c = 0;
   pos = h->queue_head;
   while ((pos != NULL) && (c < max_queue_size) &&
-         (pos->priority >= queue_priority))
+         ((GNUNET_YES == pos->was_transmitted) ||
+          (pos->priority >= queue_priority)))
   {
     c++;
     pos = pos->next;
@@ -467,11 +496,9 @@ make_queue_entry (struct GNUNET_DATASTORE_Handle *h,
   }
   else
   {
+    /* insert before 'pos'; transmitted requests were skipped
+     * above, so we never insert into the in-flight window */
     pos = pos->prev;
-    /* do not insert at HEAD if HEAD query was already
-     * transmitted and we are still receiving replies! */
-    if ((pos == NULL) && (h->queue_head->was_transmitted))
-      pos = h->queue_head;
   }
   c++;
 #if INSANE_STATISTICS
@@ -516,6 +543,31 @@ static void
 process_queue (struct GNUNET_DATASTORE_Handle *h);
 
 
+/**
+ * Handler used to discard the response to a request that
+ * was cancelled after it had been transmitted.  Keeping the
+ * cancelled entry around until its response arrives keeps the
+ * pipeline of in-flight requests and responses in sync.
+ *
+ * @param cls the `struct GNUNET_DATASTORE_Handle`
+ * @param msg message received, NULL on timeout or fatal error
+ */
+static void
+process_skip_message (void *cls,
+                      const struct GNUNET_MessageHeader *msg);
+
+
+/**
+ * Free a queue entry.  Removes the given entry from the
+ * queue and releases associated resources.  Does NOT
+ * call the callback.
+ *
+ * @param qe entry to free.
+ */
+static void
+free_queue_entry (struct GNUNET_DATASTORE_QueueEntry *qe);
+
+
 /**
  * Try reconnecting to the datastore service.
  *
@@ -553,6 +605,9 @@ try_reconnect (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
 static void
 do_disconnect (struct GNUNET_DATASTORE_Handle *h)
 {
+  struct GNUNET_DATASTORE_QueueEntry *qe;
+  struct GNUNET_DATASTORE_QueueEntry *next;
+
   if (NULL == h->client)
   {
     LOG (GNUNET_ERROR_TYPE_DEBUG,
@@ -560,8 +615,29 @@ do_disconnect (struct GNUNET_DATASTORE_Handle *h)
     return;
   }
   GNUNET_CLIENT_disconnect (h->client);
-  h->skip_next_messages = 0;
   h->client = NULL;
+  h->in_receive = GNUNET_NO;
+  /* responses for requests in flight will never arrive; cancelled
+   * entries can be freed, the others will be retransmitted after
+   * the reconnect */
+  next = h->queue_head;
+  while (NULL != (qe = next))
+  {
+    next = qe->next;
+    if (GNUNET_YES != qe->was_transmitted)
+      continue;
+    if (&process_skip_message == qe->response_proc)
+    {
+      free_queue_entry (qe);
+      continue;
+    }
+    qe->was_transmitted = GNUNET_NO;
+    qe->task =
+        GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_absolute_get_remaining
+                                      (qe->timeout),
+                                      &timeout_queue_entry, qe);
+  }
+  h->in_flight = 0;
   h->reconnect_task =
       GNUNET_SCHEDULER_add_delayed (h->retry_time, &try_reconnect, h);
 }
@@ -584,12 +660,6 @@ receive_cb (void *cls,
   h->in_receive = GNUNET_NO;
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Receiving reply from datastore\n");
-  if (h->skip_next_messages > 0)
-  {
-    h->skip_next_messages--;
-    process_queue (h);
-    return;
-  }
   if (NULL == (qe = h->queue_head))
   {
     GNUNET_break (0);
@@ -601,11 +671,13 @@ receive_cb (void *cls,
 
 
 /**
- * Transmit request from queue to datastore service.
+ * Transmit requests from the queue to the datastore service.  Fills
+ * the given buffer with as many consecutive untransmitted requests as
+ * fit (and as we have credits for).
  *
  * @param cls the `struct GNUNET_DATASTORE_Handle`
  * @param size number of bytes that can be copied to @a buf
- * @param buf where to copy the drop message
+ * @param buf where to copy the request messages
  * @return number of bytes written to @a buf
  */
 static size_t
@@ -618,8 +690,11 @@ transmit_request (void *cls,
   size_t msize;
 
   h->th = NULL;
-  if (NULL == (qe = h->queue_head))
-    return 0;                   /* no entry in queue */
+  qe = h->queue_head;
+  while ((NULL != qe) && (GNUNET_YES == qe->was_transmitted))
+    qe = qe->next;
+  if (NULL == qe)
+    return 0;                   /* no untransmitted entry in queue */
   if (NULL == buf)
   {
     LOG (GNUNET_ERROR_TYPE_DEBUG,
@@ -630,35 +705,41 @@ transmit_request (void *cls,
     do_disconnect (h);
     return 0;
   }
-  if (size < (msize = qe->message_size))
+  msize = 0;
+  while ((NULL != qe) && (h->in_flight < MAX_IN_FLIGHT) &&
+         (msize + qe->message_size <= size))
+  {
+    LOG (GNUNET_ERROR_TYPE_DEBUG,
+         "Transmitting %u byte request to DATASTORE\n",
+         qe->message_size);
+    memcpy (&((char *) buf)[msize], &qe[1], qe->message_size);
+    msize += qe->message_size;
+    qe->was_transmitted = GNUNET_YES;
+    GNUNET_SCHEDULER_cancel (qe->task);
+    qe->task = NULL;
+    h->in_flight++;
+    qe = qe->next;
+  }
+  if (0 == msize)
   {
     process_queue (h);
     return 0;
   }
-  LOG (GNUNET_ERROR_TYPE_DEBUG,
-       "Transmitting %u byte request to DATASTORE\n",
-       msize);
-  memcpy (buf, &qe[1], msize);
-  qe->was_transmitted = GNUNET_YES;
-  GNUNET_SCHEDULER_cancel (qe->task);
-  qe->task = NULL;
-  GNUNET_assert (GNUNET_NO == h->in_receive);
-  h->in_receive = GNUNET_YES;
-  GNUNET_CLIENT_receive (h->client,
-                         &receive_cb, h,
-                         GNUNET_TIME_absolute_get_remaining (qe->timeout));
 #if INSANE_STATISTICS
   GNUNET_STATISTICS_update (h->stats,
                             gettext_noop ("# bytes sent to datastore"), msize,
                             GNUNET_NO);
 #endif
+  process_queue (h);
   return msize;
 }
 
 
 /**
  * Process entries in the queue (or do nothing if we are already
- * doing so).
+ * doing so).  Starts receiving if responses are outstanding and
+ * transmits further requests while we have credits left in the
+ * in-flight window.
  *
  * @param h handle to the datastore
  */
@@ -666,20 +747,26 @@ static void
 process_queue (struct GNUNET_DATASTORE_Handle *h)
 {
   struct GNUNET_DATASTORE_QueueEntry *qe;
+  struct GNUNET_DATASTORE_QueueEntry *pos;
+  size_t msize;
+  unsigned int credits;
 
-  if (NULL == (qe = h->queue_head))
+  if (NULL == h->client)
   {
-    /* no entry in queue */
+    /* waiting for reconnect */
     LOG (GNUNET_ERROR_TYPE_DEBUG,
-         "Queue empty\n");
+         "Not connected\n");
     return;
   }
-  if (GNUNET_YES == qe->was_transmitted)
+  if ((GNUNET_NO == h->in_receive) && (h->in_flight > 0))
   {
-    /* waiting for replies */
-    LOG (GNUNET_ERROR_TYPE_DEBUG,
-         "Head request already transmitted\n");
-    return;
+    /* responses outstanding, wait for the next one; requests in
+     * flight are always at the head of the queue */
+    h->in_receive = GNUNET_YES;
+    GNUNET_CLIENT_receive (h->client,
+                           &receive_cb, h,
+                           GNUNET_TIME_absolute_get_remaining
+                           (h->queue_head->timeout));
   }
   if (NULL != h->th)
   {
@@ -688,27 +775,41 @@ process_queue (struct GNUNET_DATASTORE_Handle *h)
          "Pending transmission request\n");
     return;
   }
-  if (NULL == h->client)
+  if (h->in_flight >= MAX_IN_FLIGHT)
   {
-    /* waiting for reconnect */
+    /* no credits left, wait for responses */
     LOG (GNUNET_ERROR_TYPE_DEBUG,
-         "Not connected\n");
+         "In-flight window full\n");
     return;
   }
-  if (GNUNET_YES == h->in_receive)
+  qe = h->queue_head;
+  while ((NULL != qe) && (GNUNET_YES == qe->was_transmitted))
+    qe = qe->next;
+  if (NULL == qe)
   {
-    /* wait for response to previous query */
+    /* no untransmitted entry in queue */
+    LOG (GNUNET_ERROR_TYPE_DEBUG,
+         "Queue empty\n");
     return;
   }
+  /* ask for enough buffer space to transmit the whole window at once */
+  msize = 0;
+  credits = h->in_flight;
+  for (pos = qe; (NULL != pos) && (credits < MAX_IN_FLIGHT); pos = pos->next)
+  {
+    if (msize + pos->message_size >= GNUNET_SERVER_MAX_MESSAGE_SIZE)
+      break;
+    msize += pos->message_size;
+    credits++;
+  }
   LOG (GNUNET_ERROR_TYPE_DEBUG,
-       "Queueing %u byte request to DATASTORE\n",
-       qe->message_size);
+       "Queueing %u bytes of requests to DATASTORE\n",
+       msize);
   h->th
-    = GNUNET_CLIENT_notify_transmit_ready (h->client, qe->message_size,
+    = GNUNET_CLIENT_notify_transmit_ready (h->client, msize,
                                            GNUNET_TIME_absolute_get_remaining (qe->timeout),
                                            GNUNET_YES,
                                            &transmit_request, h);
-  GNUNET_assert (GNUNET_NO == h->in_receive);
   GNUNET_break (NULL != h->th);
 }
 
@@ -748,12 +849,42 @@ free_queue_entry (struct GNUNET_DATASTORE_QueueEntry *qe)
     GNUNET_SCHEDULER_cancel (qe->task);
     qe->task = NULL;
   }
+  if (GNUNET_YES == qe->was_transmitted)
+  {
+    /* return the credit used by this request */
+    GNUNET_assert (h->in_flight > 0);
+    h->in_flight--;
+  }
   h->queue_size--;
   qe->was_transmitted = GNUNET_SYSERR;  /* use-after-free warning */
   GNUNET_free (qe);
 }
 
 
+/**
+ * Handler used to discard the response to a request that
+ * was cancelled after it had been transmitted.
+ *
+ * @param cls the `struct GNUNET_DATASTORE_Handle`
+ * @param msg message received, NULL on timeout or fatal error
+ */
+static void
+process_skip_message (void *cls,
+                      const struct GNUNET_MessageHeader *msg)
+{
+  struct GNUNET_DATASTORE_Handle *h = cls;
+  struct GNUNET_DATASTORE_QueueEntry *qe;
+
+  qe = h->queue_head;
+  GNUNET_assert (NULL != qe);
+  free_queue_entry (qe);
+  if (NULL == msg)
+    do_disconnect (h);
+  else
+    process_queue (h);
+}
+
+
 /**
  * Type of a function to call when we receive a message
  * from the service.
@@ -838,6 +969,125 @@ process_status_message (void *cls,
 }
 
 
+/**
+ * Handler for the response to a PUT probe.  If the content was
+ * already present, the service has merged priority and expiration
+ * and we are done without ever transmitting the data; otherwise
+ * the `struct DataMessage` kept behind the probe in the queue
+ * entry is scheduled for transmission.
+ *
+ * @param cls the `struct GNUNET_DATASTORE_Handle`
+ * @param msg message received, NULL on timeout or fatal error
+ */
+static void
+process_probe_status_message (void *cls,
+                              const struct GNUNET_MessageHeader *msg)
+{
+  struct GNUNET_DATASTORE_Handle *h = cls;
+  struct GNUNET_DATASTORE_QueueEntry *qe;
+  struct GNUNET_DATASTORE_QueueEntry *pos;
+  struct StatusContext rc;
+  const struct StatusMessage *sm;
+  struct DataMessage *dm;
+  const char *emsg;
+  size_t msize;
+  int32_t status;
+  int was_transmitted;
+
+  if (NULL == (qe = h->queue_head))
+  {
+    GNUNET_break (0);
+    do_disconnect (h);
+    return;
+  }
+  rc = qe->qc.sc;
+  if (NULL == msg)
+  {
+    was_transmitted = qe->was_transmitted;
+    free_queue_entry (qe);
+    if (was_transmitted == GNUNET_YES)
+      do_disconnect (h);
+    else
+      process_queue (h);
+    if (NULL != rc.cont)
+      rc.cont (rc.cont_cls, GNUNET_SYSERR,
+	       GNUNET_TIME_UNIT_ZERO_ABS,
+               _("Failed to receive status response from database."));
+    return;
+  }
+  GNUNET_assert (GNUNET_YES == qe->was_transmitted);
+  if ((ntohs (msg->size) < sizeof (struct StatusMessage)) ||
+      (ntohs (msg->type) != GNUNET_MESSAGE_TYPE_DATASTORE_STATUS))
+  {
+    GNUNET_break (0);
+    free_queue_entry (qe);
+    h->retry_time = GNUNET_TIME_UNIT_ZERO;
+    do_disconnect (h);
+    if (rc.cont != NULL)
+      rc.cont (rc.cont_cls, GNUNET_SYSERR,
+	       GNUNET_TIME_UNIT_ZERO_ABS,
+               _("Error reading response from datastore service"));
+    return;
+  }
+  sm = (const struct StatusMessage *) msg;
+  status = ntohl (sm->status);
+  h->retry_time = GNUNET_TIME_UNIT_ZERO;
+  if (GNUNET_YES == status)
+  {
+    /* content not present; transmit the data we kept behind the probe */
+    LOG (GNUNET_ERROR_TYPE_DEBUG,
+	 "Probe missed, transmitting data\n");
+    dm = (struct DataMessage *) &((struct ProbeMessage *) &qe[1])[1];
+    msize = ntohs (dm->header.size);
+    memmove (&qe[1], dm, msize);
+    qe->message_size = msize;
+    qe->was_transmitted = GNUNET_NO;
+    qe->response_proc = &process_status_message;
+    GNUNET_assert (h->in_flight > 0);
+    h->in_flight--;
+    qe->task =
+        GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_absolute_get_remaining
+                                      (qe->timeout),
+                                      &timeout_queue_entry, qe);
+    /* move behind the requests that are still in flight */
+    GNUNET_CONTAINER_DLL_remove (h->queue_head, h->queue_tail, qe);
+    pos = h->queue_head;
+    while ((NULL != pos) && (GNUNET_YES == pos->was_transmitted))
+      pos = pos->next;
+    if (NULL == pos)
+      pos = h->queue_tail;      /* append at the tail */
+    else
+      pos = pos->prev;
+    GNUNET_CONTAINER_DLL_insert_after (h->queue_head, h->queue_tail, pos, qe);
+    process_queue (h);
+    return;
+  }
+  /* content was already present; the service has handled the
+   * request exactly like a duplicate PUT */
+  emsg = NULL;
+  if (ntohs (msg->size) > sizeof (struct StatusMessage))
+  {
+    emsg = (const char *) &sm[1];
+    if (emsg[ntohs (msg->size) - sizeof (struct StatusMessage) - 1] != '\0')
+    {
+      GNUNET_break (0);
+      emsg = _("Invalid error message received from datastore service");
+    }
+  }
+  LOG (GNUNET_ERROR_TYPE_DEBUG,
+       "Probe hit, not transmitting data\n");
+  GNUNET_STATISTICS_update (h->stats,
+                            gettext_noop ("# PUTs skipped due to probe"), 1,
+                            GNUNET_NO);
+  free_queue_entry (qe);
+  process_queue (h);
+  if (rc.cont != NULL)
+    rc.cont (rc.cont_cls, status,
+	     GNUNET_TIME_absolute_ntoh (sm->min_expiration),
+	     emsg);
+}
+
+
 /**
  * Store an item in the datastore.  If the item is already present,
  * the priorities are summed up and the higher expiration time and
@@ -895,20 +1145,55 @@ GNUNET_DATASTORE_put (struct GNUNET_DATASTORE_Handle *h,
   GNUNET_assert (msize < GNUNET_SERVER_MAX_MESSAGE_SIZE);
   qc.sc.cont = cont;
   qc.sc.cont_cls = cont_cls;
-  qe = make_queue_entry (h,
-                         msize,
-                         queue_priority,
-                         max_queue_size,
-                         timeout,
-                         &process_status_message, &qc);
-  if (qe == NULL)
+  if ((GNUNET_YES == h->probe_puts) && (size >= PROBE_SIZE_THRESHOLD))
   {
-    LOG (GNUNET_ERROR_TYPE_DEBUG, "Could not create queue entry for PUT\n");
-    return NULL;
+    /* two-phase put: transmit a small probe first and keep the
+     * data behind it in the queue entry; it is only sent if the
+     * service does not already have the content */
+    struct ProbeMessage *pm;
+
+    qe = make_queue_entry (h,
+                           sizeof (struct ProbeMessage) + msize,
+                           queue_priority,
+                           max_queue_size,
+                           timeout,
+                           &process_probe_status_message, &qc);
+    if (qe == NULL)
+    {
+      LOG (GNUNET_ERROR_TYPE_DEBUG, "Could not create queue entry for PUT\n");
+      return NULL;
+    }
+    qe->message_size = sizeof (struct ProbeMessage);
+    pm = (struct ProbeMessage *) &qe[1];
+    pm->header.type = htons (GNUNET_MESSAGE_TYPE_DATASTORE_PUT_PROBE);
+    pm->header.size = htons (sizeof (struct ProbeMessage));
+    pm->type = htonl (type);
+    pm->priority = htonl (priority);
+    pm->expiration = GNUNET_TIME_absolute_hton (expiration);
+    pm->key = *key;
+    GNUNET_CRYPTO_hash (data, size, &pm->vhash);
+    GNUNET_STATISTICS_update (h->stats,
+                              gettext_noop ("# PUT probes executed"),
+                              1, GNUNET_NO);
+    dm = (struct DataMessage *) &pm[1];
+  }
+  else
+  {
+    qe = make_queue_entry (h,
+                           msize,
+                           queue_priority,
+                           max_queue_size,
+                           timeout,
+                           &process_status_message, &qc);
+    if (qe == NULL)
+    {
+      LOG (GNUNET_ERROR_TYPE_DEBUG, "Could not create queue entry for PUT\n");
+      return NULL;
+    }
+    dm = (struct DataMessage *) &qe[1];
   }
   GNUNET_STATISTICS_update (h->stats, gettext_noop ("# PUT requests executed"),
                             1, GNUNET_NO);
-  dm = (struct DataMessage *) &qe[1];
   dm->header.type = htons (GNUNET_MESSAGE_TYPE_DATASTORE_PUT);
   dm->header.size = htons (msize);
   dm->rid = htonl (rid);
@@ -1501,8 +1786,12 @@ GNUNET_DATASTORE_cancel (struct GNUNET_DATASTORE_QueueEntry *qe)
        qe->was_transmitted, h->queue_head == qe);
   if (GNUNET_YES == qe->was_transmitted)
   {
-    free_queue_entry (qe);
-    h->skip_next_messages++;
+    /* the request is in flight; keep the entry around to discard
+     * the response when it arrives, so that the matching of
+     * responses to in-flight requests stays in sync */
+    qe->response_proc = &process_skip_message;
+    qe->qc.sc.cont = NULL;
+    qe->qc.sc.cont_cls = NULL;
     return;
   }
   free_queue_entry (qe);
@@ -26,6 +26,79 @@
 #include "platform.h"
 #include "gnunet_util_lib.h"
 #include "gnunet_datastore_service.h"
+#include "datastore.h"
+
+/**
+ * How many PUT operations do we keep in flight when importing?
+ * Should be at least as large as the in-flight window of the
+ * datastore API so that the import is I/O-bound and not
+ * round-trip-bound.
+ */
+#define IMPORT_WINDOW_SIZE 16
+
+
+GNUNET_NETWORK_STRUCT_BEGIN
+
+/**
+ * Header of a datum in the export stream, immediately
+ * followed by the data itself (length-prefixed by 'size').
+ */
+struct DataRecord
+{
+  /**
+   * Number of bytes of data following this header, in network byte order.
+   */
+  uint32_t size GNUNET_PACKED;
+
+  /**
+   * Type of the datum, in network byte order.
+   */
+  uint32_t type GNUNET_PACKED;
+
+  /**
+   * Priority of the datum, in network byte order.
+   */
+  uint32_t priority GNUNET_PACKED;
+
+  /**
+   * Anonymity level of the datum, in network byte order.
+   */
+  uint32_t anonymity GNUNET_PACKED;
+
+  /**
+   * Expiration time of the datum.
+   */
+  struct GNUNET_TIME_AbsoluteNBO expiration;
+
+  /**
+   * Key under which the datum is stored.
+   */
+  struct GNUNET_HashCode key;
+};
+
+GNUNET_NETWORK_STRUCT_END
+
+
+/**
+ * Entry tracking a pending PUT during import.
+ */
+struct ImportEntry
+{
+  /**
+   * Kept in a doubly-linked list.
+   */
+  struct ImportEntry *next;
+
+  /**
+   * Kept in a doubly-linked list.
+   */
+  struct ImportEntry *prev;
+
+  /**
+   * Queue entry of the PUT operation.
+   */
+  struct GNUNET_DATASTORE_QueueEntry *qe;
+};
 
 
 /**
@@ -33,6 +106,26 @@
  */
 static char *alternative_cfg;
 
+/**
+ * Set to GNUNET_YES if we should export the datastore.
+ */
+static int do_export;
+
+/**
+ * Set to GNUNET_YES if we should import into the datastore.
+ */
+static int do_import;
+
+/**
+ * Name of the file to export to / import from.
+ */
+static char *file_name;
+
+/**
+ * Handle for the export/import file.
+ */
+static struct GNUNET_DISK_FileHandle *file_handle;
+
 /**
  * Global return value.
  */
@@ -48,6 +141,26 @@ static uint64_t offset;
  */
 static uint64_t first_uid;
 
+/**
+ * Number of records processed so far.
+ */
+static uint64_t record_count;
+
+/**
+ * Set to GNUNET_YES once we have read the entire import file.
+ */
+static int import_eof;
+
+/**
+ * Head of the list of pending PUTs during import.
+ */
+static struct ImportEntry *imp_head;
+
+/**
+ * Tail of the list of pending PUTs during import.
+ */
+static struct ImportEntry *imp_tail;
+
 /**
  * Configuration for the source database.
  */
@@ -73,11 +186,24 @@ static void
 do_shutdown (void *cls,
 	     const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
+  struct ImportEntry *ie;
+
   if (NULL != qe)
     GNUNET_DATASTORE_cancel (qe);
-  GNUNET_DATASTORE_disconnect (db_src, GNUNET_NO);
-  GNUNET_DATASTORE_disconnect (db_dst, GNUNET_NO);
-  GNUNET_CONFIGURATION_destroy (scfg);
+  while (NULL != (ie = imp_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (imp_head, imp_tail, ie);
+    GNUNET_DATASTORE_cancel (ie->qe);
+    GNUNET_free (ie);
+  }
+  if (NULL != db_src)
+    GNUNET_DATASTORE_disconnect (db_src, GNUNET_NO);
+  if (NULL != db_dst)
+    GNUNET_DATASTORE_disconnect (db_dst, GNUNET_NO);
+  if (NULL != scfg)
+    GNUNET_CONFIGURATION_destroy (scfg);
+  if (NULL != file_handle)
+    GNUNET_DISK_file_close (file_handle);
 }
 
 
@@ -179,6 +305,223 @@ do_get ()
 }
 
 
+/**
+ * Perform next GET operation for the export.
+ */
+static void
+export_next (void);
+
+
+/**
+ * Process a datum that was stored in the datastore
+ * by writing it to the export file.
+ *
+ * @param cls closure
+ * @param key key for the content
+ * @param size number of bytes in data
+ * @param data content stored
+ * @param type type of the content
+ * @param priority priority of the content
+ * @param anonymity anonymity-level for the content
+ * @param expiration expiration time for the content
+ * @param uid unique identifier for the datum;
+ *        maybe 0 if no unique identifier is available
+ */
+static void
+export_record (void *cls,
+	       const struct GNUNET_HashCode *key,
+	       size_t size, const void *data,
+	       enum GNUNET_BLOCK_Type type,
+	       uint32_t priority,
+	       uint32_t anonymity,
+	       struct GNUNET_TIME_Absolute expiration,
+	       uint64_t uid)
+{
+  struct DataRecord rec;
+
+  qe = NULL;
+  if ( (NULL == key) ||
+       ( (0 != offset) &&
+	 (uid == first_uid) ) )
+  {
+    /* datastore empty or iteration wrapped around: we are done */
+    fprintf (stdout,
+	     _("Exported %llu records\n"),
+	     (unsigned long long) record_count);
+    GNUNET_SCHEDULER_shutdown ();
+    return;
+  }
+  if (0 == offset)
+    first_uid = uid;
+  rec.size = htonl ((uint32_t) size);
+  rec.type = htonl (type);
+  rec.priority = htonl (priority);
+  rec.anonymity = htonl (anonymity);
+  rec.expiration = GNUNET_TIME_absolute_hton (expiration);
+  rec.key = *key;
+  if ( (sizeof (rec) !=
+	GNUNET_DISK_file_write (file_handle, &rec, sizeof (rec))) ||
+       (size !=
+	GNUNET_DISK_file_write (file_handle, data, size)) )
+  {
+    fprintf (stderr,
+	     _("Failed to write to file `%s': %s\n"),
+	     file_name,
+	     STRERROR (errno));
+    ret = 1;
+    GNUNET_SCHEDULER_shutdown ();
+    return;
+  }
+  record_count++;
+  offset++;
+  export_next ();
+}
+
+
+/**
+ * Perform next GET operation for the export.
+ */
+static void
+export_next ()
+{
+  qe = GNUNET_DATASTORE_get_key (db_src,
+				 offset,
+				 NULL, GNUNET_BLOCK_TYPE_ANY,
+				 0, 1,
+				 GNUNET_TIME_UNIT_FOREVER_REL,
+				 &export_record, NULL);
+}
+
+
+/**
+ * Read records from the import file and put them into the
+ * datastore until the in-flight window is full.
+ */
+static void
+import_next (void);
+
+
+/**
+ * Continuation called to notify client about the result of a
+ * PUT during import; reads further records to keep the window
+ * of pending operations full.
+ *
+ * @param cls the `struct ImportEntry` of the completed PUT
+ * @param success #GNUNET_SYSERR on failure
+ * @param min_expiration minimum expiration time required for content to be stored
+ * @param msg NULL on success, otherwise an error message
+ */
+static void
+import_finish (void *cls,
+	       int32_t success,
+	       struct GNUNET_TIME_Absolute min_expiration,
+	       const char *msg)
+{
+  struct ImportEntry *ie = cls;
+
+  GNUNET_CONTAINER_DLL_remove (imp_head, imp_tail, ie);
+  GNUNET_free (ie);
+  if (GNUNET_SYSERR == success)
+  {
+    fprintf (stderr,
+	     _("Failed to store item: %s, aborting\n"),
+	     msg);
+    ret = 1;
+    GNUNET_SCHEDULER_shutdown ();
+    return;
+  }
+  record_count++;
+  import_next ();
+}
+
+
+/**
+ * Read records from the import file and put them into the
+ * datastore until the in-flight window is full.
+ */
+static void
+import_next ()
+{
+  struct ImportEntry *ie;
+  struct GNUNET_DATASTORE_QueueEntry *pqe;
+  struct DataRecord rec;
+  char *data;
+  ssize_t len;
+  uint32_t size;
+  unsigned int pending;
+
+  pending = 0;
+  for (ie = imp_head; NULL != ie; ie = ie->next)
+    pending++;
+  while ( (GNUNET_NO == import_eof) &&
+	  (pending < IMPORT_WINDOW_SIZE) )
+  {
+    len = GNUNET_DISK_file_read (file_handle, &rec, sizeof (rec));
+    if (0 == len)
+    {
+      import_eof = GNUNET_YES;
+      break;
+    }
+    if (sizeof (rec) != len)
+    {
+      fprintf (stderr,
+	       _("Short read from file `%s', aborting\n"),
+	       file_name);
+      ret = 1;
+      GNUNET_SCHEDULER_shutdown ();
+      return;
+    }
+    size = ntohl (rec.size);
+    if ( (0 == size) ||
+	 (size + sizeof (struct DataMessage) >= GNUNET_SERVER_MAX_MESSAGE_SIZE) )
+    {
+      fprintf (stderr,
+	       _("Invalid record size %u in file `%s', aborting\n"),
+	       (unsigned int) size,
+	       file_name);
+      ret = 1;
+      GNUNET_SCHEDULER_shutdown ();
+      return;
+    }
+    data = GNUNET_malloc (size);
+    if (size != GNUNET_DISK_file_read (file_handle, data, size))
+    {
+      fprintf (stderr,
+	       _("Short read from file `%s', aborting\n"),
+	       file_name);
+      GNUNET_free (data);
+      ret = 1;
+      GNUNET_SCHEDULER_shutdown ();
+      return;
+    }
+    ie = GNUNET_new (struct ImportEntry);
+    GNUNET_CONTAINER_DLL_insert_tail (imp_head, imp_tail, ie);
+    pqe = GNUNET_DATASTORE_put (db_dst, 0,
+				&rec.key, size, data,
+				(enum GNUNET_BLOCK_Type) ntohl (rec.type),
+				ntohl (rec.priority),
+				ntohl (rec.anonymity),
+				0 /* FIXME: replication is lost... */,
+				GNUNET_TIME_absolute_ntoh (rec.expiration),
+				0, IMPORT_WINDOW_SIZE,
+				GNUNET_TIME_UNIT_FOREVER_REL,
+				&import_finish, ie);
+    GNUNET_free (data);
+    if (NULL == pqe)
+      return;                   /* queue full, 'import_finish' already ran */
+    ie->qe = pqe;
+    pending++;
+  }
+  if ( (GNUNET_YES == import_eof) &&
+       (NULL == imp_head) )
+  {
+    fprintf (stdout,
+	     _("Imported %llu records\n"),
+	     (unsigned long long) record_count);
+    GNUNET_SCHEDULER_shutdown ();
+  }
+}
+
 
 /**
  * Main function that will be run by the scheduler.
@@ -192,6 +535,75 @@ static void
 run (void *cls, char *const *args, const char *cfgfile,
      const struct GNUNET_CONFIGURATION_Handle *cfg)
 {
+  if (GNUNET_YES == do_export)
+  {
+    if (NULL == file_name)
+    {
+      fprintf (stderr,
+	       _("The `--export' option requires `--file'\n"));
+      ret = 1;
+      return;
+    }
+    db_src = GNUNET_DATASTORE_connect (cfg);
+    if (NULL == db_src)
+    {
+      ret = 1;
+      return;
+    }
+    file_handle = GNUNET_DISK_file_open (file_name,
+					 GNUNET_DISK_OPEN_WRITE |
+					 GNUNET_DISK_OPEN_CREATE |
+					 GNUNET_DISK_OPEN_TRUNCATE,
+					 GNUNET_DISK_PERM_USER_READ |
+					 GNUNET_DISK_PERM_USER_WRITE);
+    if (NULL == file_handle)
+    {
+      fprintf (stderr,
+	       _("Failed to open file `%s'\n"),
+	       file_name);
+      GNUNET_DATASTORE_disconnect (db_src, GNUNET_NO);
+      db_src = NULL;
+      ret = 1;
+      return;
+    }
+    GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_UNIT_FOREVER_REL,
+				  &do_shutdown, NULL);
+    export_next ();
+    return;
+  }
+  if (GNUNET_YES == do_import)
+  {
+    if (NULL == file_name)
+    {
+      fprintf (stderr,
+	       _("The `--import' option requires `--file'\n"));
+      ret = 1;
+      return;
+    }
+    db_dst = GNUNET_DATASTORE_connect (cfg);
+    if (NULL == db_dst)
+    {
+      ret = 1;
+      return;
+    }
+    file_handle = GNUNET_DISK_file_open (file_name,
+					 GNUNET_DISK_OPEN_READ,
+					 GNUNET_DISK_PERM_NONE);
+    if (NULL == file_handle)
+    {
+      fprintf (stderr,
+	       _("Failed to open file `%s'\n"),
+	       file_name);
+      GNUNET_DATASTORE_disconnect (db_dst, GNUNET_NO);
+      db_dst = NULL;
+      ret = 1;
+      return;
+    }
+    GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_UNIT_FOREVER_REL,
+				  &do_shutdown, NULL);
+    import_next ();
+    return;
+  }
   if (NULL == alternative_cfg)
     return; /* nothing to be done */
   if (0 == strcmp (cfgfile, alternative_cfg))
@@ -207,6 +619,7 @@ run (void *cls, char *const *args, const char *cfgfile,
 				 alternative_cfg))
   {
     GNUNET_CONFIGURATION_destroy (scfg);
+    scfg = NULL;
     ret = 1;
     return;
   }
@@ -214,6 +627,7 @@ run (void *cls, char *const *args, const char *cfgfile,
   if (NULL == db_src)
   {
     GNUNET_CONFIGURATION_destroy (scfg);
+    scfg = NULL;
     ret = 1;
     return;
   }
@@ -221,7 +635,9 @@ run (void *cls, char *const *args, const char *cfgfile,
   if (NULL == db_dst)
   {
     GNUNET_DATASTORE_disconnect (db_src, GNUNET_NO);
+    db_src = NULL;
     GNUNET_CONFIGURATION_destroy (scfg);
+    scfg = NULL;
     ret = 1;
     return;
   }
@@ -245,6 +661,15 @@ main (int argc, char *const *argv)
     { 's', "sourcecfg", "FILENAME",
       gettext_noop ("specifies the configuration to use to access an alternative datastore; will merge that datastore into our current datastore"),
       1, &GNUNET_GETOPT_set_filename, &alternative_cfg },
+    { 'e', "export", NULL,
+      gettext_noop ("export the datastore to the file given with --file"),
+      0, &GNUNET_GETOPT_set_one, &do_export },
+    { 'i', "import", NULL,
+      gettext_noop ("import an exported datastore from the file given with --file"),
+      0, &GNUNET_GETOPT_set_one, &do_import },
+    { 'f', "file", "FILENAME",
+      gettext_noop ("file to export to / import from"),
+      1, &GNUNET_GETOPT_set_filename, &file_name },
     GNUNET_GETOPT_OPTION_END
   };
   if (GNUNET_OK != GNUNET_STRINGS_get_utf8_args (argc, argv, &argc, &argv))
@@ -48,6 +48,23 @@
  */
 #define MIN_EXPIRE_DELAY GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS, 1)
 
+/**
+ * How many expired entries do we process at most per invocation of
+ * the expiration sweeper?  Default for the EXPIRE_BATCH_SIZE option;
+ * raising it makes quota/expiration reclaim more aggressive at the
+ * cost of longer stalls of the (single-threaded) service per sweep.
+ */
+#define DEFAULT_EXPIRE_BATCH_SIZE 64
+
+/**
+ * UID reported for results served from the write-behind buffer,
+ * which have no database UID yet.  Database UIDs are row IDs and
+ * never take this value, so clients using the UID to detect that
+ * their result iteration wrapped around cannot mistake a buffered
+ * entry for a repeated database row (or vice versa).
+ */
+#define BUFFERED_ENTRY_UID UINT64_MAX
+
 /**
  * Name under which we store current space consumption.
  */
@@ -125,6 +142,26 @@ struct ReservationList
 };
 
 
+/**
+ * Entry in the write-behind buffer.  The PUT has already been
+ * acknowledged to the client; the entry still needs to be flushed
+ * to the plugin.
+ */
+struct BufferEntry
+{
+  /**
+   * Kept in a doubly-linked list (in flush order).
+   */
+  struct BufferEntry *next;
+
+  /**
+   * Kept in a doubly-linked list (in flush order).
+   */
+  struct BufferEntry *prev;
+
+  /* followed by the 'struct DataMessage' */
+};
+
 
 /**
  * Our datastore plugin (NULL if not available).
@@ -141,6 +178,39 @@ static struct ReservationList *reservations;
  */
 static struct GNUNET_CONTAINER_BloomFilter *filter;
 
+/**
+ * Head of the write-behind buffer (in flush order).
+ */
+static struct BufferEntry *buffer_head;
+
+/**
+ * Tail of the write-behind buffer (in flush order).
+ */
+static struct BufferEntry *buffer_tail;
+
+/**
+ * Map from keys to the respective `struct BufferEntry` values for
+ * read-through; NULL if the write-behind buffer is disabled.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap *buffer_map;
+
+/**
+ * Number of bytes (including overheads) currently held in the
+ * write-behind buffer.
+ */
+static unsigned long long buffer_used;
+
+/**
+ * Maximum number of bytes the write-behind buffer may hold;
+ * zero if the buffer is disabled.
+ */
+static unsigned long long buffer_quota;
+
+/**
+ * Task that flushes the write-behind buffer to the plugin.
+ */
+static struct GNUNET_SCHEDULER_Task *buffer_flush_task;
+
 /**
  * Name of our plugin.
  */
@@ -296,6 +366,12 @@ static struct GNUNET_STATISTICS_GetHandle *stat_get;
  */
 static struct GNUNET_SERVER_Handle *server;
 
+/**
+ * Maximum number of expired entries to process per sweep;
+ * set from the EXPIRE_BATCH_SIZE option.
+ */
+static unsigned long long expire_batch_size;
+
 /**
  * Task that is used to remove expired entries from
  * the datastore.  This task will schedule itself
@@ -310,12 +386,25 @@ delete_expired (void *cls,
                 const struct GNUNET_SCHEDULER_TaskContext *tc);
 
 
+/**
+ * Manage available disk space by running tasks
+ * that will delete content if necessary.
+ *
+ * @param need number of bytes of content that were
+ *        placed into the DB (and possibly need to be deleted
+ *        if we are above quota)
+ */
+static void
+manage_space (unsigned long long need);
+
+
 /**
  * Iterate over the expired items stored in the datastore.
- * Delete all expired items; once we have processed all
- * expired items, re-schedule the "delete_expired" task.
+ * Delete the item if it has expired; otherwise tell the
+ * sweeper that it is done for this round.
  *
- * @param cls not used
+ * @param cls pointer to an `int` to set to #GNUNET_YES once
+ *        there is nothing (more) to expire
  * @param key key for the content
  * @param size number of bytes in data
  * @param data content stored
@@ -341,24 +430,19 @@ expired_processor (void *cls,
                    struct GNUNET_TIME_Absolute expiration,
                    uint64_t uid)
 {
+  int *done = cls;
   struct GNUNET_TIME_Absolute now;
 
   if (key == NULL)
   {
-    expired_kill_task =
-        GNUNET_SCHEDULER_add_delayed_with_priority (MAX_EXPIRE_DELAY,
-						    GNUNET_SCHEDULER_PRIORITY_IDLE,
-						    &delete_expired, NULL);
+    *done = GNUNET_YES;
     return GNUNET_SYSERR;
   }
   now = GNUNET_TIME_absolute_get ();
   if (expiration.abs_value_us > now.abs_value_us)
   {
     /* finished processing */
-    expired_kill_task =
-        GNUNET_SCHEDULER_add_delayed_with_priority (MAX_EXPIRE_DELAY,
-						    GNUNET_SCHEDULER_PRIORITY_IDLE,
-						    &delete_expired, NULL);
+    *done = GNUNET_YES;
     return GNUNET_SYSERR;
   }
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
@@ -373,19 +457,17 @@ expired_processor (void *cls,
                             size,
                             GNUNET_YES);
   GNUNET_CONTAINER_bloomfilter_remove (filter, key);
-  expired_kill_task =
-      GNUNET_SCHEDULER_add_delayed_with_priority (MIN_EXPIRE_DELAY,
-						  GNUNET_SCHEDULER_PRIORITY_IDLE,
-						  &delete_expired, NULL);
   return GNUNET_NO;
 }
 
 
 /**
- * Task that is used to remove expired entries from
- * the datastore.  This task will schedule itself
- * again automatically to always delete all expired
- * content quickly.
+ * Task that is used to remove expired entries from the datastore.
+ * Deletes up to EXPIRE_BATCH_SIZE expired entries per invocation
+ * (so that the plugin can group the deletes into few transactions)
+ * and also reclaims space if we are over quota; reschedules itself
+ * quickly while there may be more to do and slowly once we are
+ * caught up.
  *
  * @param cls not used
  * @param tc task context
@@ -393,8 +475,37 @@ expired_processor (void *cls,
 static void
 delete_expired (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
+  unsigned long long cnt;
+  unsigned long long excess;
+  int done;
+
   expired_kill_task = NULL;
-  plugin->api->get_expiration (plugin->api->cls, &expired_processor, NULL);
+  done = GNUNET_NO;
+  for (cnt = 0; (GNUNET_NO == done) && (cnt < expire_batch_size); cnt++)
+    plugin->api->get_expiration (plugin->api->cls,
+                                 &expired_processor,
+                                 &done);
+  if (quota - reserved - cache_size < payload)
+  {
+    /* over quota (i.e. after a crawl or a quota reduction); reclaim
+     * a bounded amount of space per round so that we do not block
+     * the service for too long at a time */
+    excess = payload - (quota - reserved - cache_size);
+    manage_space (GNUNET_MIN (excess,
+                              expire_batch_size *
+                              GNUNET_SERVER_MAX_MESSAGE_SIZE));
+    done = GNUNET_NO;
+  }
+  GNUNET_STATISTICS_update (stats,
+                            gettext_noop ("# expiration sweep rounds"),
+                            1,
+                            GNUNET_NO);
+  expired_kill_task =
+      GNUNET_SCHEDULER_add_delayed_with_priority ((GNUNET_YES == done)
+                                                  ? MAX_EXPIRE_DELAY
+                                                  : MIN_EXPIRE_DELAY,
+						  GNUNET_SCHEDULER_PRIORITY_IDLE,
+						  &delete_expired, NULL);
 }
 
 
@@ -989,6 +1100,350 @@ check_present (void *cls,
 }
 
 
+/**
+ * Closure for matching against the write-behind buffer.
+ */
+struct BufferMatchContext
+{
+  /**
+   * Message we are trying to match (or NULL).
+   */
+  const struct DataMessage *dm;
+
+  /**
+   * Type to match, 0 for any.
+   */
+  uint32_t type;
+
+  /**
+   * Set to the matching entry, if any.
+   */
+  struct BufferEntry *match;
+};
+
+
+/**
+ * Iterator looking for a buffered entry with the same type and
+ * content as the message in the closure.
+ *
+ * @param cls the `struct BufferMatchContext`
+ * @param key key of the buffered entry
+ * @param value the `struct BufferEntry`
+ * @return #GNUNET_NO if we found a match, #GNUNET_YES to continue
+ */
+static int
+buffer_find_duplicate (void *cls,
+                       const struct GNUNET_HashCode *key,
+                       void *value)
+{
+  struct BufferMatchContext *bmc = cls;
+  struct BufferEntry *be = value;
+  const struct DataMessage *bdm = (const struct DataMessage *) &be[1];
+
+  if ((bdm->type == bmc->dm->type) &&
+      (bdm->size == bmc->dm->size) &&
+      (0 == memcmp (&bdm[1], &bmc->dm[1], ntohl (bdm->size))))
+  {
+    bmc->match = be;
+    return GNUNET_NO;
+  }
+  return GNUNET_YES;
+}
+
+
+/**
+ * Iterator looking for a buffered entry of the desired type
+ * (for read-through on GET).
+ *
+ * @param cls the `struct BufferMatchContext`
+ * @param key key of the buffered entry
+ * @param value the `struct BufferEntry`
+ * @return #GNUNET_NO if we found a match, #GNUNET_YES to continue
+ */
+static int
+buffer_find_type (void *cls,
+                  const struct GNUNET_HashCode *key,
+                  void *value)
+{
+  struct BufferMatchContext *bmc = cls;
+  struct BufferEntry *be = value;
+  const struct DataMessage *bdm = (const struct DataMessage *) &be[1];
+
+  if ((0 == bmc->type) || (bmc->type == ntohl (bdm->type)))
+  {
+    bmc->match = be;
+    return GNUNET_NO;
+  }
+  return GNUNET_YES;
+}
+
+
+/**
+ * Remove the given entry from the write-behind buffer
+ * (and release the space it used).
+ *
+ * @param be entry to remove, freed by this function
+ */
+static void
+buffer_remove (struct BufferEntry *be)
+{
+  const struct DataMessage *dm = (const struct DataMessage *) &be[1];
+
+  GNUNET_CONTAINER_DLL_remove (buffer_head, buffer_tail, be);
+  GNUNET_assert (GNUNET_YES ==
+                 GNUNET_CONTAINER_multihashmap_remove (buffer_map,
+                                                       &dm->key,
+                                                       be));
+  buffer_used -= ntohl (dm->size) + GNUNET_DATASTORE_ENTRY_OVERHEAD;
+  GNUNET_free (be);
+}
+
+
+/**
+ * Continuation called by the plugin after a buffered put
+ * was flushed.  The client was already told that the put
+ * succeeded, so all that is left is our internal bookkeeping.
+ *
+ * @param cls closure (NULL)
+ * @param key key for the item stored
+ * @param size size of the item stored
+ * @param status #GNUNET_OK or #GNUNET_SYSERR
+ * @param msg error message on error
+ */
+static void
+flush_put_continuation (void *cls,
+                        const struct GNUNET_HashCode *key,
+                        uint32_t size,
+                        int status,
+                        const char *msg)
+{
+  if (GNUNET_OK != status)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
+                _("Failed to flush %u bytes under key `%s' to database: %s\n"),
+                size, GNUNET_h2s (key),
+                NULL != msg ? msg : "");
+    return;
+  }
+  GNUNET_STATISTICS_update (stats,
+                            gettext_noop ("# bytes stored"),
+                            size,
+                            GNUNET_YES);
+  GNUNET_CONTAINER_bloomfilter_add (filter, key);
+  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+              "Successfully flushed %u bytes under key `%s'\n",
+              size, GNUNET_h2s (key));
+  if (quota - reserved - cache_size < payload)
+    manage_space (size + GNUNET_DATASTORE_ENTRY_OVERHEAD);
+}
+
+
+/**
+ * Hand a buffered entry to the plugin and free it.
+ *
+ * @param be entry to store, freed by this function
+ */
+static void
+execute_buffered_put (struct BufferEntry *be)
+{
+  const struct DataMessage *dm = (const struct DataMessage *) &be[1];
+
+  plugin->api->put (plugin->api->cls, &dm->key, ntohl (dm->size), &dm[1],
+                    ntohl (dm->type), ntohl (dm->priority),
+                    ntohl (dm->anonymity), ntohl (dm->replication),
+                    GNUNET_TIME_absolute_ntoh (dm->expiration),
+                    &flush_put_continuation, NULL);
+  GNUNET_free (be);
+}
+
+
+static void
+flush_update_continuation (void *cls,
+                           int status,
+                           const char *msg)
+{
+  /* client was answered long ago, nothing to do */
+}
+
+
+/**
+ * Function that will check if a buffered entry is already
+ * present in the database and if not stores it (mirrors
+ * #check_present() for the write-behind path).
+ *
+ * @param cls closure, the `struct BufferEntry`
+ * @param key key for the content
+ * @param size number of bytes in data
+ * @param data content stored
+ * @param type type of the content
+ * @param priority priority of the content
+ * @param anonymity anonymity-level for the content
+ * @param expiration expiration time for the content
+ * @param uid unique identifier for the datum;
+ *        maybe 0 if no unique identifier is available
+ * @return #GNUNET_OK usually
+ */
+static int
+flush_check_present (void *cls,
+                     const struct GNUNET_HashCode *key,
+                     uint32_t size,
+                     const void *data,
+                     enum GNUNET_BLOCK_Type type,
+                     uint32_t priority,
+                     uint32_t anonymity,
+                     struct GNUNET_TIME_Absolute expiration,
+                     uint64_t uid)
+{
+  struct BufferEntry *be = cls;
+  const struct DataMessage *dm = (const struct DataMessage *) &be[1];
+
+  if (NULL == key)
+  {
+    execute_buffered_put (be);
+    return GNUNET_OK;
+  }
+  if ((GNUNET_BLOCK_TYPE_FS_DBLOCK == type) ||
+      (GNUNET_BLOCK_TYPE_FS_IBLOCK == type) || ((size == ntohl (dm->size)) &&
+                                                (0 ==
+                                                 memcmp (&dm[1], data, size))))
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "Buffered result already present in datastore\n");
+    if ((ntohl (dm->priority) > 0) ||
+        (GNUNET_TIME_absolute_ntoh (dm->expiration).abs_value_us >
+         expiration.abs_value_us))
+      plugin->api->update (plugin->api->cls,
+                           uid,
+                           (int32_t) ntohl (dm->priority),
+                           GNUNET_TIME_absolute_ntoh (dm->expiration),
+                           &flush_update_continuation,
+                           NULL);
+    GNUNET_free (be);
+  }
+  else
+  {
+    execute_buffered_put (be);
+  }
+  return GNUNET_OK;
+}
+
+
+/**
+ * Task that flushes the oldest entry of the write-behind buffer
+ * to the plugin.  Runs at idle priority so that incoming requests
+ * are served first; reschedules itself while the buffer is
+ * non-empty.  Writing one entry per invocation keeps latencies
+ * low while the plugin's own transaction batching still gets
+ * a steady stream of puts to group.
+ *
+ * @param cls not used
+ * @param tc task context
+ */
+static void
+flush_buffer (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct BufferEntry *be;
+  const struct DataMessage *dm;
+  struct GNUNET_HashCode vhash;
+  uint32_t size;
+
+  buffer_flush_task = NULL;
+  be = buffer_head;
+  if (NULL == be)
+    return;
+  dm = (const struct DataMessage *) &be[1];
+  size = ntohl (dm->size);
+  GNUNET_CONTAINER_DLL_remove (buffer_head, buffer_tail, be);
+  GNUNET_assert (GNUNET_YES ==
+                 GNUNET_CONTAINER_multihashmap_remove (buffer_map,
+                                                       &dm->key,
+                                                       be));
+  buffer_used -= size + GNUNET_DATASTORE_ENTRY_OVERHEAD;
+  if (NULL != buffer_head)
+    buffer_flush_task =
+        GNUNET_SCHEDULER_add_with_priority (GNUNET_SCHEDULER_PRIORITY_IDLE,
+                                            &flush_buffer, NULL);
+  if (GNUNET_YES == GNUNET_CONTAINER_bloomfilter_test (filter, &dm->key))
+  {
+    /* may be a duplicate, check database first (as handle_put would) */
+    GNUNET_CRYPTO_hash (&dm[1], size, &vhash);
+    plugin->api->get_key (plugin->api->cls,
+                          0,
+                          &dm->key,
+                          &vhash,
+                          ntohl (dm->type),
+                          &flush_check_present,
+                          be);
+    return;
+  }
+  execute_buffered_put (be);
+}
+
+
+/**
+ * Add the given message to the write-behind buffer and
+ * acknowledge it right away.  If an entry with the same key,
+ * type and content is already buffered, coalesce the two
+ * instead of buffering a second copy.
+ *
+ * @param client client to acknowledge to
+ * @param dm message with the data to store
+ * @return #GNUNET_YES if the message was buffered (or coalesced),
+ *         #GNUNET_NO if the buffer is full and the caller should
+ *         store synchronously
+ */
+static int
+buffer_put (struct GNUNET_SERVER_Client *client,
+            const struct DataMessage *dm)
+{
+  struct BufferMatchContext bmc;
+  struct BufferEntry *be;
+  struct DataMessage *bdm;
+  uint32_t size;
+
+  size = ntohl (dm->size);
+  bmc.dm = dm;
+  bmc.match = NULL;
+  GNUNET_CONTAINER_multihashmap_get_multiple (buffer_map,
+                                              &dm->key,
+                                              &buffer_find_duplicate,
+                                              &bmc);
+  if (NULL != bmc.match)
+  {
+    /* coalesce: merge the metadata, keep one copy of the data */
+    bdm = (struct DataMessage *) &bmc.match[1];
+    bdm->priority = htonl (ntohl (bdm->priority) + ntohl (dm->priority));
+    bdm->replication =
+        htonl (GNUNET_MAX (ntohl (bdm->replication),
+                           ntohl (dm->replication)));
+    bdm->expiration =
+        GNUNET_TIME_absolute_hton (GNUNET_TIME_absolute_max
+                                   (GNUNET_TIME_absolute_ntoh (bdm->expiration),
+                                    GNUNET_TIME_absolute_ntoh (dm->expiration)));
+    transmit_status (client, GNUNET_NO, NULL);
+    return GNUNET_YES;
+  }
+  if (buffer_used + size + GNUNET_DATASTORE_ENTRY_OVERHEAD > buffer_quota)
+    return GNUNET_NO;
+  be = GNUNET_malloc (sizeof (struct BufferEntry) + size +
+                      sizeof (struct DataMessage));
+  memcpy (&be[1], dm, size + sizeof (struct DataMessage));
+  GNUNET_CONTAINER_DLL_insert_tail (buffer_head, buffer_tail, be);
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_multihashmap_put (buffer_map,
+                                                    &dm->key,
+                                                    be,
+                                                    GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
+  buffer_used += size + GNUNET_DATASTORE_ENTRY_OVERHEAD;
+  if (NULL == buffer_flush_task)
+    buffer_flush_task =
+        GNUNET_SCHEDULER_add_with_priority (GNUNET_SCHEDULER_PRIORITY_IDLE,
+                                            &flush_buffer, NULL);
+  transmit_status (client, GNUNET_OK, NULL);
+  return GNUNET_YES;
+}
+
+
 /**
  * Handle PUT-message.
  *
@@ -1037,6 +1492,8 @@ handle_put (void *cls, struct GNUNET_SERVER_Client *client,
                              GNUNET_NO);
     }
   }
+  if ((NULL != buffer_map) && (GNUNET_YES == buffer_put (client, dm)))
+    return;
   if (GNUNET_YES == GNUNET_CONTAINER_bloomfilter_test (filter, &dm->key))
   {
     GNUNET_CRYPTO_hash (&dm[1], size, &vhash);
@@ -1058,6 +1515,151 @@ handle_put (void *cls, struct GNUNET_SERVER_Client *client,
 }
 
 
+/**
+ * Context for a PUT_PROBE operation.
+ */
+struct ProbeContext
+{
+  /**
+   * Client to notify once we know whether the content is present.
+   */
+  struct GNUNET_SERVER_Client *client;
+
+  /**
+   * Priority to add to an existing entry.
+   */
+  uint32_t priority;
+
+  /**
+   * Expiration time to extend an existing entry to.
+   */
+  struct GNUNET_TIME_Absolute expiration;
+
+};
+
+
+static void
+probe_update_continuation (void *cls,
+			   int status,
+			   const char *msg)
+{
+  struct GNUNET_SERVER_Client *client = cls;
+
+  transmit_status (client, GNUNET_NO, NULL);
+  GNUNET_SERVER_client_drop (client);
+}
+
+
+/**
+ * Function called with the result of the datum lookup for a
+ * PUT_PROBE.  If a matching entry exists, merges priority and
+ * expiration the way a duplicate PUT would and tells the client
+ * that the content is already present (#GNUNET_NO); otherwise
+ * asks the client to transmit the full PUT (#GNUNET_YES).
+ *
+ * @param cls the `struct ProbeContext`
+ * @param key key for the content, NULL if no entry matched
+ * @param size number of bytes in data
+ * @param data content stored
+ * @param type type of the content
+ * @param priority priority of the content
+ * @param anonymity anonymity-level for the content
+ * @param expiration expiration time for the content
+ * @param uid unique identifier for the datum
+ * @return #GNUNET_OK (continue iteration)
+ */
+static int
+probe_present (void *cls,
+	       const struct GNUNET_HashCode *key,
+	       uint32_t size,
+	       const void *data,
+	       enum GNUNET_BLOCK_Type type,
+	       uint32_t priority,
+	       uint32_t anonymity,
+	       struct GNUNET_TIME_Absolute expiration,
+	       uint64_t uid)
+{
+  struct ProbeContext *pc = cls;
+
+  if (NULL == key)
+  {
+    transmit_status (pc->client, GNUNET_YES, NULL);
+    GNUNET_SERVER_client_drop (pc->client);
+    GNUNET_free (pc);
+    return GNUNET_OK;
+  }
+  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+              "Probed content already present in datastore\n");
+  GNUNET_STATISTICS_update (stats,
+                            gettext_noop ("# PUT probes detecting duplicate"),
+                            1,
+                            GNUNET_NO);
+  if ((pc->priority > 0) ||
+      (pc->expiration.abs_value_us > expiration.abs_value_us))
+    plugin->api->update (plugin->api->cls,
+			 uid,
+                         (int32_t) pc->priority,
+                         pc->expiration,
+                         &probe_update_continuation,
+			 pc->client);
+  else
+  {
+    transmit_status (pc->client, GNUNET_NO, NULL);
+    GNUNET_SERVER_client_drop (pc->client);
+  }
+  GNUNET_free (pc);
+  return GNUNET_OK;
+}
+
+
+/**
+ * Handle PUT_PROBE-message.
+ *
+ * @param cls closure
+ * @param client identification of the client
+ * @param message the actual message
+ */
+static void
+handle_put_probe (void *cls, struct GNUNET_SERVER_Client *client,
+                  const struct GNUNET_MessageHeader *message)
+{
+  const struct ProbeMessage *pm = (const struct ProbeMessage *) message;
+  struct ProbeContext *pc;
+
+  if (0 == ntohl (pm->type))
+  {
+    GNUNET_break (0);
+    GNUNET_SERVER_receive_done (client, GNUNET_SYSERR);
+    return;
+  }
+  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+              "Processing `%s' request for `%s' of type %u\n", "PUT_PROBE",
+              GNUNET_h2s (&pm->key), ntohl (pm->type));
+  GNUNET_STATISTICS_update (stats,
+                            gettext_noop ("# PUT probe requests received"),
+                            1,
+                            GNUNET_NO);
+  if (GNUNET_YES != GNUNET_CONTAINER_bloomfilter_test (filter, &pm->key))
+  {
+    /* content certainly not present, ask client for the data */
+    transmit_status (client, GNUNET_YES, NULL);
+    return;
+  }
+  pc = GNUNET_new (struct ProbeContext);
+  pc->client = client;
+  pc->priority = ntohl (pm->priority);
+  pc->expiration = GNUNET_TIME_absolute_ntoh (pm->expiration);
+  GNUNET_SERVER_client_keep (client);
+  plugin->api->get_key (plugin->api->cls,
+			0,
+			&pm->key,
+			&pm->vhash,
+                        ntohl (pm->type),
+			&probe_present,
+			pc);
+}
+
+
 /**
  * Handle GET-message.
  *
@@ -1089,6 +1691,33 @@ handle_get (void *cls, struct GNUNET_SERVER_Client *client,
                             1,
                             GNUNET_NO);
   GNUNET_SERVER_client_keep (client);
+  if ((NULL != buffer_map) && (size == sizeof (struct GetMessage)) &&
+      (0 == GNUNET_ntohll (msg->offset)))
+  {
+    /* read-through: serve from the write-behind buffer if possible;
+       only for offset zero, as the buffered entry is not part of the
+       database's result enumeration that other offsets index into */
+    struct BufferMatchContext bmc;
+    const struct DataMessage *bdm;
+
+    bmc.dm = NULL;
+    bmc.type = ntohl (msg->type);
+    bmc.match = NULL;
+    GNUNET_CONTAINER_multihashmap_get_multiple (buffer_map,
+                                                &msg->key,
+                                                &buffer_find_type,
+                                                &bmc);
+    if (NULL != bmc.match)
+    {
+      bdm = (const struct DataMessage *) &bmc.match[1];
+      transmit_item (client, &bdm->key, ntohl (bdm->size), &bdm[1],
+                     ntohl (bdm->type), ntohl (bdm->priority),
+                     ntohl (bdm->anonymity),
+                     GNUNET_TIME_absolute_ntoh (bdm->expiration),
+                     BUFFERED_ENTRY_UID);
+      return;
+    }
+  }
   if ((size == sizeof (struct GetMessage)) &&
       (GNUNET_YES != GNUNET_CONTAINER_bloomfilter_test (filter, &msg->key)))
   {
@@ -1276,6 +1905,27 @@ handle_remove (void *cls, struct GNUNET_SERVER_Client *client,
               GNUNET_h2s (&dm->key), ntohl (dm->type));
   GNUNET_STATISTICS_update (stats, gettext_noop ("# REMOVE requests received"),
                             1, GNUNET_NO);
+  if (NULL != buffer_map)
+  {
+    /* the item may still be in the write-behind buffer */
+    struct BufferMatchContext bmc;
+
+    bmc.dm = dm;
+    bmc.match = NULL;
+    GNUNET_CONTAINER_multihashmap_get_multiple (buffer_map,
+                                                &dm->key,
+                                                &buffer_find_duplicate,
+                                                &bmc);
+    if (NULL != bmc.match)
+    {
+      GNUNET_STATISTICS_update (stats,
+                                gettext_noop ("# bytes removed (explicit request)"),
+                                ntohl (dm->size), GNUNET_YES);
+      buffer_remove (bmc.match);
+      transmit_status (client, GNUNET_OK, NULL);
+      return;
+    }
+  }
   GNUNET_SERVER_client_keep (client);
   GNUNET_CRYPTO_hash (&dm[1], ntohl (dm->size), &vhash);
   plugin->api->get_key (plugin->api->cls, 0, &dm->key, &vhash,
@@ -1423,6 +2073,8 @@ static const struct GNUNET_SERVER_MessageHandler handlers[] = {
    GNUNET_MESSAGE_TYPE_DATASTORE_RELEASE_RESERVE,
    sizeof (struct ReleaseReserveMessage)},
   {&handle_put, NULL, GNUNET_MESSAGE_TYPE_DATASTORE_PUT, 0},
+  {&handle_put_probe, NULL, GNUNET_MESSAGE_TYPE_DATASTORE_PUT_PROBE,
+   sizeof (struct ProbeMessage)},
   {&handle_update, NULL, GNUNET_MESSAGE_TYPE_DATASTORE_UPDATE,
    sizeof (struct UpdateMessage)},
   {&handle_get, NULL, GNUNET_MESSAGE_TYPE_DATASTORE_GET, 0},
@@ -1539,6 +2191,7 @@ cleaning_task (void *cls,
                const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
   struct TransmitCallbackContext *tcc;
+  struct BufferEntry *be;
 
   cleaning_done = GNUNET_YES;
   while (NULL != (tcc = tcc_head))
@@ -1557,6 +2210,25 @@ cleaning_task (void *cls,
     GNUNET_SCHEDULER_cancel (expired_kill_task);
     expired_kill_task = NULL;
   }
+  if (NULL != buffer_flush_task)
+  {
+    GNUNET_SCHEDULER_cancel (buffer_flush_task);
+    buffer_flush_task = NULL;
+  }
+  while (NULL != (be = buffer_head))
+  {
+    /* drain the write-behind buffer before we lose the plugin */
+    GNUNET_CONTAINER_DLL_remove (buffer_head, buffer_tail, be);
+    if ((NULL != plugin) && (GNUNET_YES != do_drop))
+      execute_buffered_put (be);
+    else
+      GNUNET_free (be);
+  }
+  if (NULL != buffer_map)
+  {
+    GNUNET_CONTAINER_multihashmap_destroy (buffer_map);
+    buffer_map = NULL;
+  }
   if (GNUNET_YES == do_drop)
     plugin->api->drop (plugin->api->cls);
   if (NULL != plugin)
@@ -1680,6 +2352,23 @@ run (void *cls,
   cache_size = quota / 8;       /* Or should we make this an option? */
   GNUNET_STATISTICS_set (stats, gettext_noop ("# cache size"), cache_size,
                          GNUNET_NO);
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_size (cfg, "DATASTORE",
+                                           "WRITE_BEHIND_BUFFER",
+                                           &buffer_quota))
+    buffer_quota = 0;           /* write-behind disabled by default */
+  if (buffer_quota > 0)
+    buffer_map =
+        GNUNET_CONTAINER_multihashmap_create (GNUNET_MAX (16,
+                                                          buffer_quota / 4096),
+                                              GNUNET_YES);
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (cfg, "DATASTORE",
+                                             "EXPIRE_BATCH_SIZE",
+                                             &expire_batch_size))
+    expire_batch_size = DEFAULT_EXPIRE_BATCH_SIZE;
+  if (0 == expire_batch_size)
+    expire_batch_size = 1;
   if (quota / (32 * 1024LL) > (1 << 31))
     bf_size = (1 << 31);          /* absolute limit: ~2 GB, beyond that BF just won't help anyway */
   else
@@ -0,0 +1,700 @@
+/*
+     This file is part of GNUnet.
+     Copyright (C) 2015 Christian Grothoff (and other contributing authors)
+
+     GNUnet is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published
+     by the Free Software Foundation; either version 3, or (at your
+     option) any later version.
+
+     GNUnet is distributed in the hope that it will be useful, but
+     WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+     General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with GNUnet; see the file COPYING.  If not, write to the
+     Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+     Boston, MA 02110-1301, USA.
+*/
+/*
+ * @file datastore/perf_mixed_datastore.c
+ * @brief Profile database plugins under a mixed workload: an
+ *        ingestion phase followed by interleaved puts, key lookups
+ *        with skewed ("zipf"-like) key popularity and expiration
+ *        deletes, the way a node ingesting content while serving
+ *        FS readers would use the datastore.  The workload is
+ *        driven by a seeded deterministic PRNG so that runs
+ *        against different backends are directly comparable;
+ *        results are emitted as CSV (throughput and latency
+ *        percentiles per phase) on stdout.
+ * @author Christian Grothoff
+ */
+
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "gnunet_protocols.h"
+#include "gnunet_datastore_plugin.h"
+#include "gnunet_testing_lib.h"
+
+/**
+ * Default seed for the workload PRNG; override with the
+ * PERF_DATASTORE_SEED environment variable to generate a
+ * different (but again reproducible) workload.
+ */
+#define DEFAULT_SEED 42
+
+/**
+ * Number of entries inserted during the ingestion phase.  Kept
+ * small so that "make check" remains fast; scale up with the
+ * PERF_DATASTORE_SCALE environment variable for real comparisons.
+ */
+#define WARMUP_OPS 1024
+
+/**
+ * Number of operations in the mixed phase (per unit of scale).
+ */
+#define MIXED_OPS 2048
+
+/**
+ * Percentage of mixed-phase operations that are puts.
+ */
+#define MIXED_PUT_PCT 40
+
+/**
+ * Percentage of mixed-phase operations that are key lookups;
+ * the remainder are expiration deletes.
+ */
+#define MIXED_GET_PCT 50
+
+static char category[256];
+
+static const char *plugin_name;
+
+static int ok;
+
+enum RunPhase
+{
+  RP_ERROR = 0,
+  RP_WARMUP,
+  RP_MIXED,
+  RP_DRAIN,
+  RP_DONE
+};
+
+
+struct CpsRunContext
+{
+  const struct GNUNET_CONFIGURATION_Handle *cfg;
+  struct GNUNET_DATASTORE_PluginFunctions *api;
+  enum RunPhase phase;
+
+  /**
+   * Start time of the current phase.
+   */
+  struct GNUNET_TIME_Absolute phase_start;
+
+  /**
+   * Start time of the operation in flight.
+   */
+  struct GNUNET_TIME_Absolute op_start;
+
+  /**
+   * Latency samples (in microseconds) for the current phase.
+   */
+  uint64_t *samples;
+
+  /**
+   * Number of samples collected in the current phase.
+   */
+  unsigned int num_samples;
+
+  /**
+   * Number of operations executed in the current phase.
+   */
+  unsigned int cnt;
+
+  /**
+   * Number of operations to execute in the current phase.
+   */
+  unsigned int limit;
+
+  /**
+   * Number of keys inserted so far (keys are derived from their
+   * index, so this is all we need to look any of them up).
+   */
+  unsigned int num_keys;
+
+  /**
+   * Number of lookups that found nothing.
+   */
+  unsigned int misses;
+};
+
+/**
+ * State of the deterministic workload PRNG (xorshift64*).
+ */
+static uint64_t prng_state;
+
+/**
+ * Seed used for the current run (also used for key derivation).
+ */
+static uint64_t seed;
+
+/**
+ * Scale factor for the operation counts.
+ */
+static unsigned int scale = 1;
+
+
+/**
+ * Get the next value from the deterministic workload PRNG.
+ *
+ * @return pseudo-random 64-bit value
+ */
+static uint64_t
+prng_next ()
+{
+  prng_state ^= prng_state >> 12;
+  prng_state ^= prng_state << 25;
+  prng_state ^= prng_state >> 27;
+  return prng_state * UINT64_C (2685821657736338717);
+}
+
+
+/**
+ * Derive the key with the given index.  Keys are a function of
+ * the seed and the index only, so lookups do not need to store
+ * the keys that were put.
+ *
+ * @param idx index of the key
+ * @param key set to the derived key
+ */
+static void
+make_key (unsigned int idx,
+	  struct GNUNET_HashCode *key)
+{
+  uint64_t buf[2];
+
+  buf[0] = seed;
+  buf[1] = idx;
+  GNUNET_CRYPTO_hash (buf, sizeof (buf), key);
+}
+
+
+/**
+ * Pick a key index with skewed popularity: bucket b (of
+ * exponentially decreasing size) is chosen with probability
+ * 2^-(b+1), so a few keys receive most of the lookups, roughly
+ * like a zipf-distributed request stream.
+ *
+ * @param num_keys number of keys to pick from
+ * @return index in [0, num_keys)
+ */
+static unsigned int
+zipf_pick (unsigned int num_keys)
+{
+  uint64_t r = prng_next ();
+  unsigned int b;
+  unsigned int lo;
+  unsigned int hi;
+
+  b = 0;
+  while ((0 != (r & 1)) && (b < 14))
+  {
+    b++;
+    r >>= 1;
+  }
+  hi = num_keys >> b;
+  lo = num_keys >> (b + 1);
+  if (hi <= lo)
+  {
+    lo = 0;
+    hi = 1;
+  }
+  return lo + (unsigned int) (prng_next () % (hi - lo));
+}
+
+
+/**
+ * Comparator for sorting latency samples.
+ */
+static int
+cmp_samples (const void *a,
+	     const void *b)
+{
+  const uint64_t *va = a;
+  const uint64_t *vb = b;
+
+  if (*va < *vb)
+    return -1;
+  if (*va > *vb)
+    return 1;
+  return 0;
+}
+
+
+/**
+ * Report the results of the phase that just completed as a CSV
+ * row and reset the sample buffer for the next phase.
+ *
+ * @param crc the run context
+ * @param phase_name name of the completed phase
+ */
+static void
+report_phase (struct CpsRunContext *crc,
+	      const char *phase_name)
+{
+  struct GNUNET_TIME_Relative dur;
+  double seconds;
+  uint64_t p50;
+  uint64_t p95;
+  uint64_t p99;
+
+  dur = GNUNET_TIME_absolute_get_duration (crc->phase_start);
+  seconds = ((double) dur.rel_value_us) / 1000LL / 1000LL;
+  qsort (crc->samples, crc->num_samples, sizeof (uint64_t), &cmp_samples);
+  p50 = (crc->num_samples > 0) ? crc->samples[crc->num_samples / 2] : 0;
+  p95 = (crc->num_samples > 0) ? crc->samples[crc->num_samples * 95 / 100] : 0;
+  p99 = (crc->num_samples > 0) ? crc->samples[crc->num_samples * 99 / 100] : 0;
+  printf ("%s,%s,%u,%.3f,%.0f,%llu,%llu,%llu\n",
+	  plugin_name,
+	  phase_name,
+	  crc->num_samples,
+	  seconds,
+	  (seconds > 0) ? crc->num_samples / seconds : 0.0,
+	  (unsigned long long) p50,
+	  (unsigned long long) p95,
+	  (unsigned long long) p99);
+  crc->num_samples = 0;
+  crc->cnt = 0;
+  crc->phase_start = GNUNET_TIME_absolute_get ();
+}
+
+
+/**
+ * Record the latency of the operation in flight.
+ *
+ * @param crc the run context
+ */
+static void
+record_sample (struct CpsRunContext *crc)
+{
+  crc->samples[crc->num_samples++] =
+      GNUNET_TIME_absolute_get_duration (crc->op_start).rel_value_us;
+}
+
+
+/**
+ * Function called by plugins to notify us about a
+ * change in their disk utilization.
+ *
+ * @param cls closure (NULL)
+ * @param delta change in disk utilization,
+ *        0 for "reset to empty"
+ */
+static void
+disk_utilization_change_cb (void *cls, int delta)
+{
+}
+
+
+static void
+test (void *cls,
+      const struct GNUNET_SCHEDULER_TaskContext *tc);
+
+
+/**
+ * Put continuation.
+ *
+ * @param cls closure
+ * @param key key for the item stored
+ * @param size size of the item stored
+ * @param status #GNUNET_OK or #GNUNET_SYSERR
+ * @param msg error message on error
+ */
+static void
+put_continuation (void *cls,
+		  const struct GNUNET_HashCode *key,
+                  uint32_t size,
+		  int status,
+		  const char *msg)
+{
+  struct CpsRunContext *crc = cls;
+
+  if (GNUNET_OK != status)
+    FPRINTF (stderr, "ERROR: `%s'\n", msg);
+  record_sample (crc);
+  GNUNET_SCHEDULER_add_now (&test, crc);
+}
+
+
+/**
+ * Store the entry with the next key index.
+ *
+ * @param crc the run context
+ */
+static void
+do_put (struct CpsRunContext *crc)
+{
+  static char value[65536];
+  struct GNUNET_HashCode key;
+  size_t size;
+  unsigned int idx;
+
+  idx = crc->num_keys++;
+  make_key (idx, &key);
+  /* most content is 32k, some is smaller */
+  size = 32 * 1024;
+  if (0 == (prng_next () % 16))
+    size = 8 + (prng_next () % (32 * 1024));
+  size = size - (size & 7);     /* always multiple of 8 */
+  memset (value, (int) (idx % 256), size);
+  crc->op_start = GNUNET_TIME_absolute_get ();
+  crc->api->put (crc->api->cls,
+		 &key,
+		 size,
+		 value,
+		 1 + idx % 4 /* type */,
+		 (uint32_t) (prng_next () % 100) /* priority */,
+		 idx % 4 /* anonymity */,
+		 0 /* replication */,
+		 GNUNET_TIME_relative_to_absolute
+		 (GNUNET_TIME_relative_multiply
+		  (GNUNET_TIME_UNIT_SECONDS,
+		   60 + (prng_next () % 3600))),
+		 &put_continuation,
+		 crc);
+}
+
+
+/**
+ * Process a lookup result.
+ *
+ * @param cls the run context
+ * @param key key of the result, NULL if nothing matched
+ * @param size number of bytes in @a data
+ * @param data the stored value
+ * @param type type of the value
+ * @param priority priority of the value
+ * @param anonymity anonymity level of the value
+ * @param expiration expiration time of the value
+ * @param uid unique identifier of the value
+ * @return #GNUNET_OK (keep the value)
+ */
+static int
+lookup_proc (void *cls, const struct GNUNET_HashCode *key, uint32_t size,
+	     const void *data, enum GNUNET_BLOCK_Type type, uint32_t priority,
+	     uint32_t anonymity, struct GNUNET_TIME_Absolute expiration,
+	     uint64_t uid)
+{
+  struct CpsRunContext *crc = cls;
+
+  if (NULL == key)
+    crc->misses++;
+  record_sample (crc);
+  GNUNET_SCHEDULER_add_now (&test, crc);
+  return GNUNET_OK;
+}
+
+
+/**
+ * Look up a key with skewed popularity.
+ *
+ * @param crc the run context
+ */
+static void
+do_get (struct CpsRunContext *crc)
+{
+  struct GNUNET_HashCode key;
+
+  make_key (zipf_pick (crc->num_keys), &key);
+  crc->op_start = GNUNET_TIME_absolute_get ();
+  crc->api->get_key (crc->api->cls,
+		     0,
+		     &key,
+		     NULL,
+		     GNUNET_BLOCK_TYPE_ANY,
+		     &lookup_proc,
+		     crc);
+}
+
+
+/**
+ * Process (and delete) the entry closest to expiration.
+ *
+ * @param cls the run context
+ * @param key key of the entry, NULL if the datastore is empty
+ * @param size number of bytes in @a data
+ * @param data the stored value
+ * @param type type of the value
+ * @param priority priority of the value
+ * @param anonymity anonymity level of the value
+ * @param expiration expiration time of the value
+ * @param uid unique identifier of the value
+ * @return #GNUNET_NO (delete the value)
+ */
+static int
+expire_proc (void *cls, const struct GNUNET_HashCode *key, uint32_t size,
+	     const void *data, enum GNUNET_BLOCK_Type type, uint32_t priority,
+	     uint32_t anonymity, struct GNUNET_TIME_Absolute expiration,
+	     uint64_t uid)
+{
+  struct CpsRunContext *crc = cls;
+
+  record_sample (crc);
+  if (NULL == key)
+  {
+    /* datastore empty, finish the phase early */
+    crc->cnt = crc->limit;
+    GNUNET_SCHEDULER_add_now (&test, crc);
+    return GNUNET_OK;
+  }
+  GNUNET_SCHEDULER_add_now (&test, crc);
+  return GNUNET_NO;
+}
+
+
+/**
+ * Delete the entry closest to expiration.
+ *
+ * @param crc the run context
+ */
+static void
+do_expire (struct CpsRunContext *crc)
+{
+  crc->op_start = GNUNET_TIME_absolute_get ();
+  crc->api->get_expiration (crc->api->cls,
+			    &expire_proc,
+			    crc);
+}
+
+
+/**
+ * Function called when the service shuts
+ * down.  Unloads our datastore plugin.
+ *
+ * @param api api to unload
+ * @param cfg configuration to use
+ */
+static void
+unload_plugin (struct GNUNET_DATASTORE_PluginFunctions *api,
+               const struct GNUNET_CONFIGURATION_Handle *cfg)
+{
+  char *name;
+  char *libname;
+
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_string (cfg, "DATASTORE", "DATABASE",
+                                             &name))
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                _("No `%s' specified for `%s' in configuration!\n"), "DATABASE",
+                "DATASTORE");
+    return;
+  }
+  GNUNET_asprintf (&libname, "libgnunet_plugin_datastore_%s", name);
+  GNUNET_break (NULL == GNUNET_PLUGIN_unload (libname, api));
+  GNUNET_free (libname);
+  GNUNET_free (name);
+}
+
+
+/**
+ * Last task run during shutdown.  Unloads the plugin.
+ */
+static void
+cleaning_task (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct CpsRunContext *crc = cls;
+
+  unload_plugin (crc->api, crc->cfg);
+  GNUNET_free (crc->samples);
+  GNUNET_free (crc);
+}
+
+
+static void
+test (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct CpsRunContext *crc = cls;
+  uint64_t r;
+
+  if (0 != (tc->reason & GNUNET_SCHEDULER_REASON_SHUTDOWN))
+  {
+    GNUNET_break (0);
+    crc->phase = RP_ERROR;
+  }
+  switch (crc->phase)
+  {
+  case RP_ERROR:
+    GNUNET_break (0);
+    crc->api->drop (crc->api->cls);
+    ok = 1;
+    GNUNET_SCHEDULER_add_with_priority (GNUNET_SCHEDULER_PRIORITY_IDLE,
+                                        &cleaning_task, crc);
+    break;
+  case RP_WARMUP:
+    if (crc->cnt++ == crc->limit)
+    {
+      report_phase (crc, "warmup");
+      crc->phase = RP_MIXED;
+      crc->limit = MIXED_OPS * scale;
+      GNUNET_SCHEDULER_add_now (&test, crc);
+      break;
+    }
+    do_put (crc);
+    break;
+  case RP_MIXED:
+    if (crc->cnt++ == crc->limit)
+    {
+      report_phase (crc, "mixed");
+      crc->phase = RP_DRAIN;
+      crc->limit = crc->num_keys;
+      GNUNET_SCHEDULER_add_now (&test, crc);
+      break;
+    }
+    r = prng_next () % 100;
+    if (r < MIXED_PUT_PCT)
+      do_put (crc);
+    else if (r < MIXED_PUT_PCT + MIXED_GET_PCT)
+      do_get (crc);
+    else
+      do_expire (crc);
+    break;
+  case RP_DRAIN:
+    if (crc->cnt++ >= crc->limit)
+    {
+      report_phase (crc, "drain");
+      crc->phase = RP_DONE;
+      GNUNET_SCHEDULER_add_now (&test, crc);
+      break;
+    }
+    do_expire (crc);
+    break;
+  case RP_DONE:
+    crc->api->drop (crc->api->cls);
+    ok = 0;
+    GNUNET_SCHEDULER_add_with_priority (GNUNET_SCHEDULER_PRIORITY_IDLE,
+                                        &cleaning_task, crc);
+    break;
+  }
+}
+
+
+/**
+ * Load the datastore plugin.
+ */
+static struct GNUNET_DATASTORE_PluginFunctions *
+load_plugin (const struct GNUNET_CONFIGURATION_Handle *cfg)
+{
+  static struct GNUNET_DATASTORE_PluginEnvironment env;
+  struct GNUNET_DATASTORE_PluginFunctions *ret;
+  char *name;
+  char *libname;
+
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_string (cfg, "DATASTORE", "DATABASE",
+                                             &name))
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                _("No `%s' specified for `%s' in configuration!\n"), "DATABASE",
+                "DATASTORE");
+    return NULL;
+  }
+  env.cfg = cfg;
+  env.duc = &disk_utilization_change_cb;
+  env.cls = NULL;
+  GNUNET_log (GNUNET_ERROR_TYPE_INFO, _("Loading `%s' datastore plugin\n"),
+              name);
+  GNUNET_asprintf (&libname, "libgnunet_plugin_datastore_%s", name);
+  if (NULL == (ret = GNUNET_PLUGIN_load (libname, &env)))
+  {
+    FPRINTF (stderr, "Failed to load plugin `%s'!\n", name);
+    GNUNET_free (name);
+    GNUNET_free (libname);
+    return NULL;
+  }
+  GNUNET_free (libname);
+  GNUNET_free (name);
+  return ret;
+}
+
+
+static void
+run (void *cls, char *const *args, const char *cfgfile,
+     const struct GNUNET_CONFIGURATION_Handle *c)
+{
+  struct GNUNET_DATASTORE_PluginFunctions *api;
+  struct CpsRunContext *crc;
+  unsigned int max_samples;
+
+  if (NULL == c)
+  {
+    GNUNET_break (0);
+    return;
+  }
+  api = load_plugin (c);
+  if (api == NULL)
+  {
+    FPRINTF (stderr,
+             "%s", "Could not initialize plugin, assuming database not configured. Test not run!\n");
+    return;
+  }
+  crc = GNUNET_new (struct CpsRunContext);
+  crc->api = api;
+  crc->cfg = c;
+  crc->phase = RP_WARMUP;
+  crc->limit = WARMUP_OPS * scale;
+  /* the drain phase processes at most one op per key ever inserted */
+  max_samples = (WARMUP_OPS + MIXED_OPS) * scale + 1;
+  crc->samples = GNUNET_malloc (max_samples * sizeof (uint64_t));
+  crc->phase_start = GNUNET_TIME_absolute_get ();
+  printf ("plugin,phase,ops,seconds,ops_per_sec,lat_p50_us,lat_p95_us,lat_p99_us\n");
+  ok = 2;
+  GNUNET_SCHEDULER_add_now (&test, crc);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  char dir_name[128];
+  char cfg_name[128];
+  const char *env;
+  char *const xargv[] = {
+    "perf-mixed-datastore",
+    "-c",
+    cfg_name,
+    NULL
+  };
+  struct GNUNET_GETOPT_CommandLineOption options[] = {
+    GNUNET_GETOPT_OPTION_END
+  };
+
+  seed = DEFAULT_SEED;
+  if (NULL != (env = getenv ("PERF_DATASTORE_SEED")))
+    seed = strtoull (env, NULL, 10);
+  if (NULL != (env = getenv ("PERF_DATASTORE_SCALE")))
+    scale = GNUNET_MAX (1, atoi (env));
+  prng_state = seed | 1;        /* xorshift state must not be zero */
+  plugin_name = GNUNET_TESTING_get_testname_from_underscore (argv[0]);
+  GNUNET_snprintf (dir_name, sizeof (dir_name), "/tmp/perf-gnunet-datastore-%s",
+                   plugin_name);
+  GNUNET_DISK_directory_remove (dir_name);
+  GNUNET_log_setup ("perf-mixed-datastore",
+                    "WARNING",
+                    NULL);
+  GNUNET_snprintf (category, sizeof (category), "DATASTORE-%s", plugin_name);
+  GNUNET_snprintf (cfg_name, sizeof (cfg_name),
+                   "perf_plugin_datastore_data_%s.conf", plugin_name);
+  GNUNET_PROGRAM_run ((sizeof (xargv) / sizeof (char *)) - 1, xargv,
+                      "perf-mixed-datastore", "nohelp", options, &run, NULL);
+  if (ok != 0)
+    FPRINTF (stderr, "Missed some testcases: %u\n", ok);
+  GNUNET_DISK_directory_remove (dir_name);
+
+  return ok;
+}
+
+/* end of perf_mixed_datastore.c */
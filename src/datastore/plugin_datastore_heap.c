@@ -42,6 +42,13 @@ struct Value
    */
   struct GNUNET_HashCode key;
 
+  /**
+   * Hash of the value's data; queries that specify a vhash are
+   * answered by comparing against this field instead of re-hashing
+   * the payload of every candidate.
+   */
+  struct GNUNET_HashCode vhash;
+
   /**
    * Pointer to the value's data (allocated at the end of this struct).
    */
@@ -226,6 +233,7 @@ heap_plugin_put (void *cls,
 
   value = GNUNET_malloc (sizeof (struct Value) + size);
   value->key = *key;
+  GNUNET_CRYPTO_hash (data, size, &value->vhash);
   value->data = &value[1];
   value->expire_heap = GNUNET_CONTAINER_heap_insert (plugin->by_expiration,
 						     value,
@@ -365,17 +373,13 @@ static int
 match (const struct GetContext *gc,
        struct Value *value)
 {
-  struct GNUNET_HashCode vh;
-
   if ( (gc->type != GNUNET_BLOCK_TYPE_ANY) &&
        (gc->type != value->type) )
     return GNUNET_NO;
-  if (NULL != gc->vhash)
-  {
-    GNUNET_CRYPTO_hash (&value[1], value->size, &vh);
-    if (0 != memcmp (&vh, gc->vhash, sizeof (struct GNUNET_HashCode)))
-      return GNUNET_NO;
-  }
+  if ( (NULL != gc->vhash) &&
+       (0 != memcmp (&value->vhash, gc->vhash,
+		     sizeof (struct GNUNET_HashCode))) )
+    return GNUNET_NO;
   return GNUNET_YES;
 }
 
@@ -474,9 +478,14 @@ heap_plugin_get_key (void *cls, uint64_t offset,
   gc.proc_cls = proc_cls;
   if (NULL == key)
   {
-    GNUNET_CONTAINER_multihashmap_iterate (plugin->keyvalue,
-					   &count_iterator,
-					   &gc);
+    if ( (GNUNET_BLOCK_TYPE_ANY == type) &&
+	 (NULL == vhash) )
+      /* no filtering, so every value matches; skip the counting pass */
+      gc.offset = GNUNET_CONTAINER_multihashmap_size (plugin->keyvalue);
+    else
+      GNUNET_CONTAINER_multihashmap_iterate (plugin->keyvalue,
+					     &count_iterator,
+					     &gc);
     if (0 == gc.offset)
     {
       proc (proc_cls,
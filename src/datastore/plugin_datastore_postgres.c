@@ -57,6 +57,19 @@ struct Plugin
    */
   PGconn *dbh;
 
+  /**
+   * Cached result of "SELECT MAX(repl)", maintained on put and
+   * invalidated on delete/decrement; avoids querying the maximum
+   * replication level on every replication-based select.  Only
+   * valid if @e max_repl_valid is #GNUNET_YES.
+   */
+  uint32_t max_repl;
+
+  /**
+   * #GNUNET_YES if @e max_repl is current.
+   */
+  int max_repl_valid;
+
 };
 
 
@@ -75,6 +88,21 @@ init_connection (struct Plugin *plugin)
   if (NULL == plugin->dbh)
     return GNUNET_SYSERR;
 
+  /* Do not wait for the WAL flush on every commit; this removes the
+     per-block fsync from the put path at the cost of possibly losing
+     the last few blocks if the server crashes (which matches what the
+     sqlite backend does with synchronous=OFF) */
+  ret = PQexec (plugin->dbh, "SET synchronous_commit TO OFF");
+  if (GNUNET_OK !=
+      GNUNET_POSTGRES_check_result (plugin->dbh, ret, PGRES_COMMAND_OK,
+                                    "SET", "synchronous_commit"))
+  {
+    PQfinish (plugin->dbh);
+    plugin->dbh = NULL;
+    return GNUNET_SYSERR;
+  }
+  PQclear (ret);
+
   ret =
       PQexec (plugin->dbh,
               "CREATE TABLE gn090 (" "  repl INTEGER NOT NULL DEFAULT 0,"
@@ -161,29 +189,36 @@ init_connection (struct Plugin *plugin)
     return GNUNET_SYSERR;
   }
   PQclear (ret);
+  /* The OFFSET of the get statements is computed modulo the number of
+     matching rows in a subquery so that picking a random result costs
+     us a single round trip to the server */
   if ((GNUNET_OK !=
        GNUNET_POSTGRES_prepare (plugin->dbh, "getvt",
                    "SELECT type, prio, anonLevel, expire, hash, value, oid FROM gn090 "
                    "WHERE hash=$1 AND vhash=$2 AND type=$3 "
-                   "ORDER BY oid ASC LIMIT 1 OFFSET $4", 4)) ||
+                   "ORDER BY oid ASC LIMIT 1 OFFSET ($4 % GREATEST(1, "
+                   "(SELECT COUNT(*) FROM gn090 WHERE hash=$1 AND vhash=$2 AND type=$3)))", 4)) ||
       (GNUNET_OK !=
        GNUNET_POSTGRES_prepare (plugin->dbh, "gett",
                    "SELECT type, prio, anonLevel, expire, hash, value, oid FROM gn090 "
                    "WHERE hash=$1 AND type=$2 "
-                   "ORDER BY oid ASC LIMIT 1 OFFSET $3", 3)) ||
+                   "ORDER BY oid ASC LIMIT 1 OFFSET ($3 % GREATEST(1, "
+                   "(SELECT COUNT(*) FROM gn090 WHERE hash=$1 AND type=$2)))", 3)) ||
       (GNUNET_OK !=
        GNUNET_POSTGRES_prepare (plugin->dbh, "getv",
                    "SELECT type, prio, anonLevel, expire, hash, value, oid FROM gn090 "
                    "WHERE hash=$1 AND vhash=$2 "
-                   "ORDER BY oid ASC LIMIT 1 OFFSET $3", 3)) ||
+                   "ORDER BY oid ASC LIMIT 1 OFFSET ($3 % GREATEST(1, "
+                   "(SELECT COUNT(*) FROM gn090 WHERE hash=$1 AND vhash=$2)))", 3)) ||
       (GNUNET_OK !=
        GNUNET_POSTGRES_prepare (plugin->dbh, "get",
                    "SELECT type, prio, anonLevel, expire, hash, value, oid FROM gn090 "
-                   "WHERE hash=$1 " "ORDER BY oid ASC LIMIT 1 OFFSET $2", 2)) ||
+                   "WHERE hash=$1 " "ORDER BY oid ASC LIMIT 1 OFFSET ($2 % GREATEST(1, "
+                   "(SELECT COUNT(*) FROM gn090 WHERE hash=$1)))", 2)) ||
       (GNUNET_OK !=
        GNUNET_POSTGRES_prepare (plugin->dbh, "put",
                    "INSERT INTO gn090 (repl, type, prio, anonLevel, expire, rvalue, hash, vhash, value) "
-                   "VALUES ($1, $2, $3, $4, $5, RANDOM(), $6, $7, $8)", 9)) ||
+                   "VALUES ($1, $2, $3, $4, $5, CAST (RANDOM() * 9223372036854775807 AS BIGINT), $6, $7, $8)", 9)) ||
       (GNUNET_OK !=
        GNUNET_POSTGRES_prepare (plugin->dbh, "update",
                    "UPDATE gn090 SET prio = prio + $1, expire = CASE WHEN expire < $2 THEN $2 ELSE expire END "
@@ -204,10 +239,15 @@ init_connection (struct Plugin *plugin)
                    "(SELECT type, prio, anonLevel, expire, hash, value, oid FROM gn090 "
                    "ORDER BY prio ASC LIMIT 1) " "ORDER BY expire ASC LIMIT 1",
                    1)) ||
+      (GNUNET_OK !=
+       GNUNET_POSTGRES_prepare (plugin->dbh, "maxrepl",
+                   "SELECT MAX(repl) FROM gn090", 0)) ||
       (GNUNET_OK !=
        GNUNET_POSTGRES_prepare (plugin->dbh, "select_replication_order",
                    "SELECT type, prio, anonLevel, expire, hash, value, oid FROM gn090 "
-                   "ORDER BY repl DESC,RANDOM() LIMIT 1", 0)) ||
+                   "WHERE repl=$2 AND (rvalue>=$1 OR NOT EXISTS "
+                   "(SELECT 1 FROM gn090 WHERE repl=$2 AND rvalue>=$1 LIMIT 1)) "
+                   "ORDER BY rvalue ASC LIMIT 1", 2)) ||
       (GNUNET_OK !=
        GNUNET_POSTGRES_prepare (plugin->dbh, "delrow", "DELETE FROM gn090 " "WHERE oid=$1", 1)) ||
       (GNUNET_OK !=
@@ -333,6 +373,9 @@ postgres_plugin_put (void *cls, const struct GNUNET_HashCode * key, uint32_t siz
   }
   PQclear (ret);
   plugin->env->duc (plugin->env->cls, size + GNUNET_DATASTORE_ENTRY_OVERHEAD);
+  if ((GNUNET_YES == plugin->max_repl_valid) &&
+      (replication > plugin->max_repl))
+    plugin->max_repl = replication;
   GNUNET_log_from (GNUNET_ERROR_TYPE_DEBUG, "datastore-postgres",
                    "Stored %u bytes in database\n", (unsigned int) size);
   cont (cont_cls, key, size, GNUNET_OK, NULL);
@@ -402,6 +445,7 @@ process_result (struct Plugin *plugin, PluginDatumProcessor proc,
     GNUNET_break (0);
     PQclear (res);
     GNUNET_POSTGRES_delete_by_rowid (plugin->dbh, "delrow", rowid);
+    plugin->max_repl_valid = GNUNET_NO;
     proc (proc_cls, NULL, 0, NULL, 0, 0, 0, GNUNET_TIME_UNIT_ZERO_ABS, 0);
     return;
   }
@@ -427,6 +471,9 @@ process_result (struct Plugin *plugin, PluginDatumProcessor proc,
                 "Processor asked for item %u to be removed.\n", rowid);
     if (GNUNET_OK == GNUNET_POSTGRES_delete_by_rowid (plugin->dbh, "delrow", rowid))
     {
+      /* the deleted row may have been the last one at the maximum
+         replication level */
+      plugin->max_repl_valid = GNUNET_NO;
       GNUNET_log_from (GNUNET_ERROR_TYPE_DEBUG, "datastore-postgres",
                        "Deleting %u bytes from database\n",
                        (unsigned int) size);
@@ -466,20 +513,22 @@ postgres_plugin_get_key (void *cls, uint64_t offset,
                          void *proc_cls)
 {
   struct Plugin *plugin = cls;
-  const int paramFormats[] = { 1, 1, 1, 1, 1 };
+  const int paramFormats[] = { 1, 1, 1, 1 };
   int paramLengths[4];
   const char *paramValues[4];
   int nparams;
   const char *pname;
   PGresult *ret;
-  uint64_t total;
   uint64_t blimit_off;
   uint32_t btype;
 
   GNUNET_assert (key != NULL);
+  /* the modulo is computed by the server; truncate the offset to a
+     non-negative int8 value */
+  blimit_off = GNUNET_htonll (offset & INT64_MAX);
+  btype = htonl (type);
   paramValues[0] = (const char *) key;
   paramLengths[0] = sizeof (struct GNUNET_HashCode);
-  btype = htonl (type);
   if (type != 0)
   {
     if (vhash != NULL)
@@ -492,10 +541,6 @@ postgres_plugin_get_key (void *cls, uint64_t offset,
       paramLengths[3] = sizeof (blimit_off);
       nparams = 4;
       pname = "getvt";
-      ret =
-          PQexecParams (plugin->dbh,
-                        "SELECT count(*) FROM gn090 WHERE hash=$1 AND vhash=$2 AND type=$3",
-                        3, NULL, paramValues, paramLengths, paramFormats, 1);
     }
     else
     {
@@ -505,10 +550,6 @@ postgres_plugin_get_key (void *cls, uint64_t offset,
       paramLengths[2] = sizeof (blimit_off);
       nparams = 3;
       pname = "gett";
-      ret =
-          PQexecParams (plugin->dbh,
-                        "SELECT count(*) FROM gn090 WHERE hash=$1 AND type=$2",
-                        2, NULL, paramValues, paramLengths, paramFormats, 1);
     }
   }
   else
@@ -521,10 +562,6 @@ postgres_plugin_get_key (void *cls, uint64_t offset,
       paramLengths[2] = sizeof (blimit_off);
       nparams = 3;
       pname = "getv";
-      ret =
-          PQexecParams (plugin->dbh,
-                        "SELECT count(*) FROM gn090 WHERE hash=$1 AND vhash=$2",
-                        2, NULL, paramValues, paramLengths, paramFormats, 1);
     }
     else
     {
@@ -532,33 +569,8 @@ postgres_plugin_get_key (void *cls, uint64_t offset,
       paramLengths[1] = sizeof (blimit_off);
       nparams = 2;
       pname = "get";
-      ret =
-          PQexecParams (plugin->dbh, "SELECT count(*) FROM gn090 WHERE hash=$1",
-                        1, NULL, paramValues, paramLengths, paramFormats, 1);
     }
   }
-  if (GNUNET_OK !=
-      GNUNET_POSTGRES_check_result (plugin->dbh, ret, PGRES_TUPLES_OK, "PQexecParams", pname))
-  {
-    proc (proc_cls, NULL, 0, NULL, 0, 0, 0, GNUNET_TIME_UNIT_ZERO_ABS, 0);
-    return;
-  }
-  if ((PQntuples (ret) != 1) || (PQnfields (ret) != 1) ||
-      (PQgetlength (ret, 0, 0) != sizeof (unsigned long long)))
-  {
-    GNUNET_break (0);
-    PQclear (ret);
-    proc (proc_cls, NULL, 0, NULL, 0, 0, 0, GNUNET_TIME_UNIT_ZERO_ABS, 0);
-    return;
-  }
-  total = GNUNET_ntohll (*(const unsigned long long *) PQgetvalue (ret, 0, 0));
-  PQclear (ret);
-  if (total == 0)
-  {
-    proc (proc_cls, NULL, 0, NULL, 0, 0, 0, GNUNET_TIME_UNIT_ZERO_ABS, 0);
-    return;
-  }
-  blimit_off = GNUNET_htonll (offset % total);
   ret =
       PQexecPrepared (plugin->dbh, pname, nparams, paramValues, paramLengths,
                       paramFormats, 1);
@@ -699,14 +711,61 @@ postgres_plugin_get_replication (void *cls, PluginDatumProcessor proc,
   struct Plugin *plugin = cls;
   struct ReplCtx rc;
   PGresult *ret;
+  uint64_t brvalue;
+  uint32_t brepl;
+  const char *paramValues[] = {
+    (const char *) &brvalue,
+    (const char *) &brepl
+  };
+  int paramLengths[] = {
+    sizeof (brvalue),
+    sizeof (brepl)
+  };
+  const int paramFormats[] = { 1, 1 };
 
   rc.plugin = plugin;
   rc.proc = proc;
   rc.proc_cls = proc_cls;
+  /* Determine the highest replication counter first and then pick a
+     random row among those via rvalue; sorting the whole table with
+     'ORDER BY repl DESC,RANDOM()' does not scale to large stores */
+  if (GNUNET_YES != plugin->max_repl_valid)
+  {
+    ret = PQexecPrepared (plugin->dbh, "maxrepl", 0, NULL, NULL, NULL, 1);
+    if (GNUNET_OK !=
+        GNUNET_POSTGRES_check_result (plugin->dbh, ret, PGRES_TUPLES_OK,
+                                      "PQexecPrepared", "maxrepl"))
+    {
+      proc (proc_cls, NULL, 0, NULL, 0, 0, 0, GNUNET_TIME_UNIT_ZERO_ABS, 0);
+      return;
+    }
+    if ((1 != PQntuples (ret)) ||
+        (sizeof (uint32_t) != PQgetlength (ret, 0, 0)))
+    {
+      /* database must be empty (MAX is NULL) */
+      PQclear (ret);
+      proc (proc_cls, NULL, 0, NULL, 0, 0, 0, GNUNET_TIME_UNIT_ZERO_ABS, 0);
+      return;
+    }
+    plugin->max_repl =
+        ntohl (*(const uint32_t *) PQgetvalue (ret, 0, 0));
+    plugin->max_repl_valid = GNUNET_YES;
+    PQclear (ret);
+  }
+  brepl = htonl (plugin->max_repl);
+  brvalue =
+      GNUNET_htonll (GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_WEAK,
+                                               INT64_MAX));
   ret =
-      PQexecPrepared (plugin->dbh, "select_replication_order", 0, NULL, NULL,
-                      NULL, 1);
+      PQexecPrepared (plugin->dbh, "select_replication_order", 2, paramValues,
+                      paramLengths, paramFormats, 1);
   process_result (plugin, &repl_proc, &rc, ret, __FILE__, __LINE__);
+  if (plugin->max_repl > 0)
+  {
+    /* we may just have decremented the last row at the maximum
+       replication level */
+    plugin->max_repl_valid = GNUNET_NO;
+  }
 }
 
 
@@ -48,6 +48,21 @@
  */
 #define BUSY_TIMEOUT_MS 250
 
+/**
+ * How many PUT operations do we group into a single transaction at
+ * most before forcing a commit?  Each transaction costs us a sync of
+ * the journal, so grouping blocks is essential for publishing
+ * throughput.
+ */
+#define MAX_TRANSACTION_PUTS 128
+
+/**
+ * How long do we leave a transaction open at most before committing
+ * it?  Bounds how much recently stored content may be lost if we
+ * crash.
+ */
+#define TRANSACTION_COMMIT_DELAY GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MILLISECONDS, 250)
+
 
 /**
  * Log an error message at log-level 'level' that indicates
@@ -126,6 +141,35 @@ struct Plugin
    */
   sqlite3_stmt *insertContent;
 
+  /**
+   * Task scheduled to commit the currently open transaction.
+   */
+  struct GNUNET_SCHEDULER_Task *transaction_task;
+
+  /**
+   * Number of PUT operations performed in the currently open
+   * transaction.
+   */
+  unsigned int transaction_puts;
+
+  /**
+   * #GNUNET_YES if we have an explicit transaction open.
+   */
+  int transaction_open;
+
+  /**
+   * Cached result of "SELECT MAX(repl)", maintained on put and
+   * invalidated on delete/decrement; avoids querying the maximum
+   * replication level on every replication-based select.  Only
+   * valid if @e max_repl_valid is #GNUNET_YES.
+   */
+  uint32_t max_repl;
+
+  /**
+   * #GNUNET_YES if @e max_repl is current.
+   */
+  int max_repl_valid;
+
   /**
    * Should the database be dropped on shutdown?
    */
@@ -171,9 +215,12 @@ create_indices (sqlite3 * dbh)
   if ((SQLITE_OK !=
        sqlite3_exec (dbh, "CREATE INDEX IF NOT EXISTS idx_hash ON gn090 (hash)",
                      NULL, NULL, NULL)) ||
+      (SQLITE_OK !=
+       sqlite3_exec (dbh, "DROP INDEX IF EXISTS idx_hash_vhash",
+                     NULL, NULL, NULL)) ||
       (SQLITE_OK !=
        sqlite3_exec (dbh,
-                     "CREATE INDEX IF NOT EXISTS idx_hash_vhash ON gn090 (hash,vhash)",
+                     "CREATE INDEX IF NOT EXISTS idx_hash_type_vhash ON gn090 (hash,type,vhash)",
                      NULL, NULL, NULL)) ||
       (SQLITE_OK !=
        sqlite3_exec (dbh,
@@ -282,6 +329,17 @@ database_setup (const struct GNUNET_CONFIGURATION_Handle *cfg,
   CHECK (SQLITE_OK ==
          sqlite3_exec (plugin->dbh, "PRAGMA page_size=4092", NULL, NULL,
                        ENULL));
+#if SQLITE_VERSION_NUMBER >= 3007000
+  CHECK (SQLITE_OK ==
+         sqlite3_exec (plugin->dbh, "PRAGMA journal_mode=WAL", NULL, NULL,
+                       ENULL));
+#endif
+#if SQLITE_VERSION_NUMBER >= 3007017
+  /* map up to 256 MB of the database for reads to avoid read() copies */
+  CHECK (SQLITE_OK ==
+         sqlite3_exec (plugin->dbh, "PRAGMA mmap_size=268435456", NULL, NULL,
+                       ENULL));
+#endif
 
   CHECK (SQLITE_OK == sqlite3_busy_timeout (plugin->dbh, BUSY_TIMEOUT_MS));
 
@@ -364,11 +422,83 @@ database_setup (const struct GNUNET_CONFIGURATION_Handle *cfg,
     LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR, "precompiling");
     return GNUNET_SYSERR;
   }
+  plugin->max_repl_valid = GNUNET_NO;
 
   return GNUNET_OK;
 }
 
 
+/**
+ * Commit the currently open transaction (if any) and cancel the
+ * pending commit task.
+ *
+ * @param plugin the plugin context (state for this module)
+ */
+static void
+transaction_commit (struct Plugin *plugin)
+{
+  if (NULL != plugin->transaction_task)
+  {
+    GNUNET_SCHEDULER_cancel (plugin->transaction_task);
+    plugin->transaction_task = NULL;
+  }
+  if (GNUNET_YES != plugin->transaction_open)
+    return;
+  plugin->transaction_open = GNUNET_NO;
+  plugin->transaction_puts = 0;
+  if (SQLITE_OK !=
+      sqlite3_exec (plugin->dbh, "COMMIT TRANSACTION", NULL, NULL, NULL))
+    LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+                "sqlite3_exec");
+}
+
+
+/**
+ * Task run once the transaction commit delay has expired.  Commits
+ * the open transaction.
+ *
+ * @param cls the plugin context (state for this module)
+ * @param tc scheduler task context
+ */
+static void
+transaction_commit_task (void *cls,
+                         const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct Plugin *plugin = cls;
+
+  plugin->transaction_task = NULL;
+  transaction_commit (plugin);
+}
+
+
+/**
+ * Open a transaction if we do not have one open yet and schedule the
+ * task that will eventually commit it.  Grouping many PUT operations
+ * into one transaction avoids paying the journaling overhead for
+ * each individual block.
+ *
+ * @param plugin the plugin context (state for this module)
+ */
+static void
+transaction_begin (struct Plugin *plugin)
+{
+  if (GNUNET_YES == plugin->transaction_open)
+    return;
+  if (SQLITE_OK !=
+      sqlite3_exec (plugin->dbh, "BEGIN TRANSACTION", NULL, NULL, NULL))
+  {
+    LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+                "sqlite3_exec");
+    return;
+  }
+  plugin->transaction_open = GNUNET_YES;
+  GNUNET_assert (NULL == plugin->transaction_task);
+  plugin->transaction_task =
+      GNUNET_SCHEDULER_add_delayed (TRANSACTION_COMMIT_DELAY,
+                                    &transaction_commit_task, plugin);
+}
+
+
 /**
  * Shutdown database connection and associate data
  * structures.
@@ -384,6 +514,7 @@ database_shutdown (struct Plugin *plugin)
   sqlite3_stmt *stmt;
 #endif
 
+  transaction_commit (plugin);
   if (plugin->delRow != NULL)
     sqlite3_finalize (plugin->delRow);
   if (plugin->updPrio != NULL)
@@ -430,7 +561,9 @@ database_shutdown (struct Plugin *plugin)
 
 /**
  * Delete the database entry with the given
- * row identifier.
+ * row identifier.  Like puts, deletes are grouped into the
+ * deferred-commit transaction so that batched expiration sweeps
+ * do not pay for one fsync per row.
  *
  * @param plugin the plugin context (state for this module)
  * @param rid the ID of the row to delete
@@ -439,6 +572,7 @@ static int
 delete_by_rowid (struct Plugin *plugin,
                  unsigned long long rid)
 {
+  transaction_begin (plugin);
   if (SQLITE_OK != sqlite3_bind_int64 (plugin->delRow, 1, rid))
   {
     LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
@@ -462,6 +596,12 @@ delete_by_rowid (struct Plugin *plugin,
   if (SQLITE_OK != sqlite3_reset (plugin->delRow))
     LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                 "sqlite3_reset");
+  /* the deleted row may have been the last one at the maximum
+     replication level */
+  plugin->max_repl_valid = GNUNET_NO;
+  plugin->transaction_puts++;
+  if (plugin->transaction_puts >= MAX_TRANSACTION_PUTS)
+    transaction_commit (plugin);
   return GNUNET_OK;
 }
 
@@ -516,6 +656,7 @@ sqlite_plugin_put (void *cls,
 							   GNUNET_YES),
                    GNUNET_STRINGS_absolute_time_to_string (expiration));
   GNUNET_CRYPTO_hash (data, size, &vhash);
+  transaction_begin (plugin);
   stmt = plugin->insertContent;
   rvalue = GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_WEAK, UINT64_MAX);
   if ((SQLITE_OK != sqlite3_bind_int (stmt, 1, replication)) ||
@@ -550,6 +691,12 @@ sqlite_plugin_put (void *cls,
     GNUNET_log_from (GNUNET_ERROR_TYPE_DEBUG, "sqlite",
                      "Stored new entry (%u bytes)\n",
                      size + GNUNET_DATASTORE_ENTRY_OVERHEAD);
+    plugin->transaction_puts++;
+    if (plugin->transaction_puts >= MAX_TRANSACTION_PUTS)
+      transaction_commit (plugin);
+    if ((GNUNET_YES == plugin->max_repl_valid) &&
+        (replication > plugin->max_repl))
+      plugin->max_repl = replication;
     ret = GNUNET_OK;
     break;
   case SQLITE_BUSY:
@@ -1003,21 +1150,26 @@ sqlite_plugin_get_replication (void *cls, PluginDatumProcessor proc,
   rc.have_uid = GNUNET_NO;
   rc.proc = proc;
   rc.proc_cls = proc_cls;
-  stmt = plugin->maxRepl;
-  if (SQLITE_ROW != sqlite3_step (stmt))
+  if (GNUNET_YES != plugin->max_repl_valid)
   {
+    stmt = plugin->maxRepl;
+    if (SQLITE_ROW != sqlite3_step (stmt))
+    {
+      if (SQLITE_OK != sqlite3_reset (stmt))
+        LOG_SQLITE (plugin,
+                    GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+                    "sqlite3_reset");
+      /* DB empty */
+      proc (proc_cls, NULL, 0, NULL, 0, 0, 0, GNUNET_TIME_UNIT_ZERO_ABS, 0);
+      return;
+    }
+    plugin->max_repl = sqlite3_column_int (stmt, 0);
+    plugin->max_repl_valid = GNUNET_YES;
     if (SQLITE_OK != sqlite3_reset (stmt))
-      LOG_SQLITE (plugin,
-                  GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+      LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                   "sqlite3_reset");
-    /* DB empty */
-    proc (proc_cls, NULL, 0, NULL, 0, 0, 0, GNUNET_TIME_UNIT_ZERO_ABS, 0);
-    return;
   }
-  repl = sqlite3_column_int (stmt, 0);
-  if (SQLITE_OK != sqlite3_reset (stmt))
-    LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
-                "sqlite3_reset");
+  repl = plugin->max_repl;
   stmt = plugin->selRepl;
   rvalue = GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_WEAK, UINT64_MAX);
   if (SQLITE_OK != sqlite3_bind_int64 (stmt, 1, rvalue))
@@ -1064,6 +1216,12 @@ sqlite_plugin_get_replication (void *cls, PluginDatumProcessor proc,
       LOG_SQLITE (plugin,
                   GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                   "sqlite3_reset");
+    if (repl > 0)
+    {
+      /* we may just have decremented the last row at the maximum
+         replication level */
+      plugin->max_repl_valid = GNUNET_NO;
+    }
   }
 }
 
@@ -1186,6 +1344,8 @@ sqlite_plugin_estimate_size (void *cls, unsigned long long *estimate)
     *estimate = 0;
     return;
   }
+  /* VACUUM can not run within a transaction */
+  transaction_commit (plugin);
   CHECK (SQLITE_OK == sqlite3_exec (plugin->dbh, "VACUUM", NULL, NULL, ENULL));
   CHECK (SQLITE_OK ==
          sqlite3_exec (plugin->dbh, "PRAGMA auto_vacuum=INCREMENTAL", NULL,
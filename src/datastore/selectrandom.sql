@@ -1,9 +1,23 @@
-select *
-from (select random() as v from (values(1))) t1,
-     (select max(repl) as m from data) t2,
-     (select * from data
-      where repl=t2.m and
-            rnd>=t.v
-      order by rnd
-      limit 1)
+-- How the plugins select the next block for replication/migration.
+--
+-- Sorting the whole table ("ORDER BY repl DESC, RANDOM()", as sketched
+-- here originally) degrades to a full scan as the table grows.  Instead
+-- all backends keep an index on (repl, rvalue) -- rvalue is a random
+-- value assigned on insert -- and pick a random starting point on the
+-- rvalue ladder among the rows with the highest replication level,
+-- wrapping around if no row has a larger rvalue:
 
+select type,prio,anonLevel,expire,hash,value,_ROWID_
+  from gn090 indexed by idx_repl_rvalue
+ where repl=?2
+   and (rvalue>=?1
+        or not exists (select 1 from gn090 indexed by idx_repl_rvalue
+                        where repl=?2 and rvalue>=?1 limit 1))
+ order by rvalue asc
+ limit 1
+
+-- ?1 is a fresh random 64-bit value, ?2 is MAX(repl).  The maximum
+-- replication level is cached by the plugins and maintained on put
+-- (raise) and delete/decrement (invalidate), so in the common case
+-- (steady-state migration with repl=0 content) each call is a single
+-- index seek.
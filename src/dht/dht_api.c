@@ -582,7 +582,8 @@ transmit_pending (void *cls,
 static void
 process_pending_messages (struct GNUNET_DHT_Handle *handle)
 {
-  struct PendingMessage *head;
+  struct PendingMessage *pm;
+  size_t tsize;
 
   if (NULL == handle->client)
   {
@@ -593,11 +594,18 @@ process_pending_messages (struct GNUNET_DHT_Handle *handle)
   }
   if (NULL != handle->th)
     return;
-  if (NULL == (head = handle->pending_head))
+  if (NULL == handle->pending_head)
     return;
+  /* Request buffer space for all pending messages, so that a batch of
+     requests (i.e. a zone publisher's PUTs) goes out in one wakeup. */
+  tsize = 0;
+  for (pm = handle->pending_head; NULL != pm; pm = pm->next)
+    tsize += ntohs (pm->msg->size);
+  tsize = GNUNET_MIN (tsize,
+                      GNUNET_SERVER_MAX_MESSAGE_SIZE - 1);
   handle->th =
       GNUNET_CLIENT_notify_transmit_ready (handle->client,
-                                           ntohs (head->msg->size),
+                                           tsize,
                                            GNUNET_TIME_UNIT_FOREVER_REL,
                                            GNUNET_YES, &transmit_pending,
                                            handle);
@@ -624,8 +632,9 @@ transmit_pending (void *cls,
 {
   struct GNUNET_DHT_Handle *handle = cls;
   struct PendingMessage *head;
+  char *cbuf = buf;
   size_t tsize;
-
+  uint16_t msize;
 
   handle->th = NULL;
   if (NULL == buf)
@@ -635,28 +644,29 @@ transmit_pending (void *cls,
     do_disconnect (handle);
     return 0;
   }
-  if (NULL == (head = handle->pending_head))
-    return 0;
-
-  tsize = ntohs (head->msg->size);
-  if (size < tsize)
+  /* Pack as many pending messages as fit into the buffer. */
+  tsize = 0;
+  while (NULL != (head = handle->pending_head))
   {
-    process_pending_messages (handle);
-    return 0;
-  }
-  memcpy (buf, head->msg, tsize);
-  GNUNET_CONTAINER_DLL_remove (handle->pending_head, handle->pending_tail,
-                               head);
-  head->in_pending_queue = GNUNET_NO;
-  if (NULL != head->cont)
-  {
-    head->cont (head->cont_cls, NULL);
-    head->cont = NULL;
-    head->cont_cls = NULL;
+    msize = ntohs (head->msg->size);
+    if (size - tsize < msize)
+      break;
+    memcpy (&cbuf[tsize], head->msg, msize);
+    tsize += msize;
+    GNUNET_CONTAINER_DLL_remove (handle->pending_head, handle->pending_tail,
+                                 head);
+    head->in_pending_queue = GNUNET_NO;
+    if (NULL != head->cont)
+    {
+      head->cont (head->cont_cls, NULL);
+      head->cont = NULL;
+      head->cont_cls = NULL;
+    }
+    if (GNUNET_YES == head->free_on_send)
+      GNUNET_free (head);
   }
-  if (GNUNET_YES == head->free_on_send)
-    GNUNET_free (head);
-  process_pending_messages (handle);
+  if (NULL != handle->pending_head)
+    process_pending_messages (handle);
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Forwarded request of %u bytes to DHT service\n", (unsigned int) tsize);
   if (GNUNET_NO == handle->in_receive)
@@ -949,6 +949,9 @@ send_reply_to_client (void *cls, size_t size, void *buf)
 static void
 process_pending_messages (struct ClientList *client)
 {
+  struct PendingMessage *pm;
+  size_t msize;
+
   if ((client->pending_head == NULL) || (client->transmit_handle != NULL))
   {
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
@@ -958,13 +961,19 @@ process_pending_messages (struct ClientList *client)
                 NULL ? "no more messages" : "request already pending");
     return;
   }
+  /* ask for a buffer covering all pending messages, so that
+     #send_reply_to_client() can batch them into one frame */
+  msize = 0;
+  for (pm = client->pending_head; NULL != pm; pm = pm->next)
+    msize += ntohs (pm->msg->size);
+  msize = GNUNET_MIN (msize,
+                      GNUNET_SERVER_MAX_MESSAGE_SIZE - 1);
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Asking for transmission of %u bytes to client %p\n",
-              ntohs (client->pending_head->msg->size), client->client_handle);
+              (unsigned int) msize, client->client_handle);
   client->transmit_handle =
       GNUNET_SERVER_notify_transmit_ready (client->client_handle,
-                                           ntohs (client->pending_head->
-                                                  msg->size),
+                                           msize,
                                            GNUNET_TIME_UNIT_FOREVER_REL,
                                            &send_reply_to_client, client);
 }
@@ -1246,21 +1255,21 @@ GDS_CLIENTS_process_get (uint32_t options,
   struct ClientMonitorRecord *m;
   struct ClientList **cl;
   unsigned int cl_size;
+  struct PendingMessage *pm;
+  struct GNUNET_DHT_MonitorGetMessage *mmsg;
+  struct GNUNET_PeerIdentity *msg_path;
+  size_t msize;
+  unsigned int i;
 
   cl = NULL;
   cl_size = 0;
   for (m = monitor_head; NULL != m; m = m->next)
   {
-    if ((GNUNET_BLOCK_TYPE_ANY == m->type || m->type == type) &&
+    if ((0 != m->get) &&
+        (GNUNET_BLOCK_TYPE_ANY == m->type || m->type == type) &&
         (NULL == m->key ||
          memcmp (key, m->key, sizeof(struct GNUNET_HashCode)) == 0))
     {
-      struct PendingMessage *pm;
-      struct GNUNET_DHT_MonitorGetMessage *mmsg;
-      struct GNUNET_PeerIdentity *msg_path;
-      size_t msize;
-      unsigned int i;
-
       /* Don't send duplicates */
       for (i = 0; i < cl_size; i++)
         if (cl[i] == m->client)
@@ -1268,29 +1277,41 @@ GDS_CLIENTS_process_get (uint32_t options,
       if (i < cl_size)
         continue;
       GNUNET_array_append (cl, cl_size, m->client);
-
-      msize = path_length * sizeof (struct GNUNET_PeerIdentity);
-      msize += sizeof (struct GNUNET_DHT_MonitorGetMessage);
-      msize += sizeof (struct PendingMessage);
-      pm = GNUNET_malloc (msize);
-      mmsg = (struct GNUNET_DHT_MonitorGetMessage *) &pm[1];
-      pm->msg = &mmsg->header;
-      mmsg->header.size = htons (msize - sizeof (struct PendingMessage));
-      mmsg->header.type = htons (GNUNET_MESSAGE_TYPE_DHT_MONITOR_GET);
-      mmsg->options = htonl(options);
-      mmsg->type = htonl(type);
-      mmsg->hop_count = htonl(hop_count);
-      mmsg->desired_replication_level = htonl(desired_replication_level);
-      mmsg->get_path_length = htonl(path_length);
-      memcpy (&mmsg->key, key, sizeof (struct GNUNET_HashCode));
-      msg_path = (struct GNUNET_PeerIdentity *) &mmsg[1];
-      if (path_length > 0)
-        memcpy (msg_path, path,
-                path_length * sizeof (struct GNUNET_PeerIdentity));
-      add_pending_message (m->client, pm);
     }
   }
-  GNUNET_free_non_null (cl);
+  if (0 == cl_size)
+    return;
+
+  /* serialize once, copy for each additional client */
+  msize = path_length * sizeof (struct GNUNET_PeerIdentity);
+  msize += sizeof (struct GNUNET_DHT_MonitorGetMessage);
+  msize += sizeof (struct PendingMessage);
+  pm = GNUNET_malloc (msize);
+  mmsg = (struct GNUNET_DHT_MonitorGetMessage *) &pm[1];
+  pm->msg = &mmsg->header;
+  mmsg->header.size = htons (msize - sizeof (struct PendingMessage));
+  mmsg->header.type = htons (GNUNET_MESSAGE_TYPE_DHT_MONITOR_GET);
+  mmsg->options = htonl(options);
+  mmsg->type = htonl(type);
+  mmsg->hop_count = htonl(hop_count);
+  mmsg->desired_replication_level = htonl(desired_replication_level);
+  mmsg->get_path_length = htonl(path_length);
+  memcpy (&mmsg->key, key, sizeof (struct GNUNET_HashCode));
+  msg_path = (struct GNUNET_PeerIdentity *) &mmsg[1];
+  if (path_length > 0)
+    memcpy (msg_path, path,
+            path_length * sizeof (struct GNUNET_PeerIdentity));
+  for (i = 1; i < cl_size; i++)
+  {
+    struct PendingMessage *pmc;
+
+    pmc = GNUNET_malloc (msize);
+    memcpy (pmc, pm, msize);
+    pmc->msg = (struct GNUNET_MessageHeader *) &pmc[1];
+    add_pending_message (cl[i], pmc);
+  }
+  add_pending_message (cl[0], pm);
+  GNUNET_free (cl);
 }
 
 
@@ -1322,21 +1343,21 @@ GDS_CLIENTS_process_get_resp (enum GNUNET_BLOCK_Type type,
   struct ClientMonitorRecord *m;
   struct ClientList **cl;
   unsigned int cl_size;
+  struct PendingMessage *pm;
+  struct GNUNET_DHT_MonitorGetRespMessage *mmsg;
+  struct GNUNET_PeerIdentity *path;
+  size_t msize;
+  unsigned int i;
 
   cl = NULL;
   cl_size = 0;
   for (m = monitor_head; NULL != m; m = m->next)
   {
-    if ((GNUNET_BLOCK_TYPE_ANY == m->type || m->type == type) &&
+    if ((0 != m->get_resp) &&
+        (GNUNET_BLOCK_TYPE_ANY == m->type || m->type == type) &&
         (NULL == m->key ||
          memcmp (key, m->key, sizeof(struct GNUNET_HashCode)) == 0))
     {
-      struct PendingMessage *pm;
-      struct GNUNET_DHT_MonitorGetRespMessage *mmsg;
-      struct GNUNET_PeerIdentity *path;
-      size_t msize;
-      unsigned int i;
-
       /* Don't send duplicates */
       for (i = 0; i < cl_size; i++)
         if (cl[i] == m->client)
@@ -1344,38 +1365,50 @@ GDS_CLIENTS_process_get_resp (enum GNUNET_BLOCK_Type type,
       if (i < cl_size)
         continue;
       GNUNET_array_append (cl, cl_size, m->client);
-
-      msize = size;
-      msize += (get_path_length + put_path_length)
-               * sizeof (struct GNUNET_PeerIdentity);
-      msize += sizeof (struct GNUNET_DHT_MonitorGetRespMessage);
-      msize += sizeof (struct PendingMessage);
-      pm = GNUNET_malloc (msize);
-      mmsg = (struct GNUNET_DHT_MonitorGetRespMessage *) &pm[1];
-      pm->msg = (struct GNUNET_MessageHeader *) mmsg;
-      mmsg->header.size = htons (msize - sizeof (struct PendingMessage));
-      mmsg->header.type = htons (GNUNET_MESSAGE_TYPE_DHT_MONITOR_GET_RESP);
-      mmsg->type = htonl(type);
-      mmsg->put_path_length = htonl(put_path_length);
-      mmsg->get_path_length = htonl(get_path_length);
-      path = (struct GNUNET_PeerIdentity *) &mmsg[1];
-      if (put_path_length > 0)
-      {
-        memcpy (path, put_path,
-                put_path_length * sizeof (struct GNUNET_PeerIdentity));
-        path = &path[put_path_length];
-      }
-      if (get_path_length > 0)
-        memcpy (path, get_path,
-                get_path_length * sizeof (struct GNUNET_PeerIdentity));
-      mmsg->expiration_time = GNUNET_TIME_absolute_hton(exp);
-      memcpy (&mmsg->key, key, sizeof (struct GNUNET_HashCode));
-      if (size > 0)
-        memcpy (&path[get_path_length], data, size);
-      add_pending_message (m->client, pm);
     }
   }
-  GNUNET_free_non_null (cl);
+  if (0 == cl_size)
+    return;
+
+  /* serialize once, copy for each additional client */
+  msize = size;
+  msize += (get_path_length + put_path_length)
+           * sizeof (struct GNUNET_PeerIdentity);
+  msize += sizeof (struct GNUNET_DHT_MonitorGetRespMessage);
+  msize += sizeof (struct PendingMessage);
+  pm = GNUNET_malloc (msize);
+  mmsg = (struct GNUNET_DHT_MonitorGetRespMessage *) &pm[1];
+  pm->msg = (struct GNUNET_MessageHeader *) mmsg;
+  mmsg->header.size = htons (msize - sizeof (struct PendingMessage));
+  mmsg->header.type = htons (GNUNET_MESSAGE_TYPE_DHT_MONITOR_GET_RESP);
+  mmsg->type = htonl(type);
+  mmsg->put_path_length = htonl(put_path_length);
+  mmsg->get_path_length = htonl(get_path_length);
+  path = (struct GNUNET_PeerIdentity *) &mmsg[1];
+  if (put_path_length > 0)
+  {
+    memcpy (path, put_path,
+            put_path_length * sizeof (struct GNUNET_PeerIdentity));
+    path = &path[put_path_length];
+  }
+  if (get_path_length > 0)
+    memcpy (path, get_path,
+            get_path_length * sizeof (struct GNUNET_PeerIdentity));
+  mmsg->expiration_time = GNUNET_TIME_absolute_hton(exp);
+  memcpy (&mmsg->key, key, sizeof (struct GNUNET_HashCode));
+  if (size > 0)
+    memcpy (&path[get_path_length], data, size);
+  for (i = 1; i < cl_size; i++)
+  {
+    struct PendingMessage *pmc;
+
+    pmc = GNUNET_malloc (msize);
+    memcpy (pmc, pm, msize);
+    pmc->msg = (struct GNUNET_MessageHeader *) &pmc[1];
+    add_pending_message (cl[i], pmc);
+  }
+  add_pending_message (cl[0], pm);
+  GNUNET_free (cl);
 }
 
 
@@ -1409,21 +1442,21 @@ GDS_CLIENTS_process_put (uint32_t options,
   struct ClientMonitorRecord *m;
   struct ClientList **cl;
   unsigned int cl_size;
+  struct PendingMessage *pm;
+  struct GNUNET_DHT_MonitorPutMessage *mmsg;
+  struct GNUNET_PeerIdentity *msg_path;
+  size_t msize;
+  unsigned int i;
 
   cl = NULL;
   cl_size = 0;
   for (m = monitor_head; NULL != m; m = m->next)
   {
-    if ((GNUNET_BLOCK_TYPE_ANY == m->type || m->type == type) &&
+    if ((0 != m->put) &&
+        (GNUNET_BLOCK_TYPE_ANY == m->type || m->type == type) &&
         (NULL == m->key ||
          memcmp (key, m->key, sizeof(struct GNUNET_HashCode)) == 0))
     {
-      struct PendingMessage *pm;
-      struct GNUNET_DHT_MonitorPutMessage *mmsg;
-      struct GNUNET_PeerIdentity *msg_path;
-      size_t msize;
-      unsigned int i;
-
       /* Don't send duplicates */
       for (i = 0; i < cl_size; i++)
         if (cl[i] == m->client)
@@ -1431,35 +1464,47 @@ GDS_CLIENTS_process_put (uint32_t options,
       if (i < cl_size)
         continue;
       GNUNET_array_append (cl, cl_size, m->client);
-
-      msize = size;
-      msize += path_length * sizeof (struct GNUNET_PeerIdentity);
-      msize += sizeof (struct GNUNET_DHT_MonitorPutMessage);
-      msize += sizeof (struct PendingMessage);
-      pm = GNUNET_malloc (msize);
-      mmsg = (struct GNUNET_DHT_MonitorPutMessage *) &pm[1];
-      pm->msg = (struct GNUNET_MessageHeader *) mmsg;
-      mmsg->header.size = htons (msize - sizeof (struct PendingMessage));
-      mmsg->header.type = htons (GNUNET_MESSAGE_TYPE_DHT_MONITOR_PUT);
-      mmsg->options = htonl(options);
-      mmsg->type = htonl(type);
-      mmsg->hop_count = htonl(hop_count);
-      mmsg->desired_replication_level = htonl(desired_replication_level);
-      mmsg->put_path_length = htonl(path_length);
-      msg_path = (struct GNUNET_PeerIdentity *) &mmsg[1];
-      if (path_length > 0)
-      {
-        memcpy (msg_path, path,
-                path_length * sizeof (struct GNUNET_PeerIdentity));
-      }
-      mmsg->expiration_time = GNUNET_TIME_absolute_hton(exp);
-      memcpy (&mmsg->key, key, sizeof (struct GNUNET_HashCode));
-      if (size > 0)
-        memcpy (&msg_path[path_length], data, size);
-      add_pending_message (m->client, pm);
     }
   }
-  GNUNET_free_non_null (cl);
+  if (0 == cl_size)
+    return;
+
+  /* serialize once, copy for each additional client */
+  msize = size;
+  msize += path_length * sizeof (struct GNUNET_PeerIdentity);
+  msize += sizeof (struct GNUNET_DHT_MonitorPutMessage);
+  msize += sizeof (struct PendingMessage);
+  pm = GNUNET_malloc (msize);
+  mmsg = (struct GNUNET_DHT_MonitorPutMessage *) &pm[1];
+  pm->msg = (struct GNUNET_MessageHeader *) mmsg;
+  mmsg->header.size = htons (msize - sizeof (struct PendingMessage));
+  mmsg->header.type = htons (GNUNET_MESSAGE_TYPE_DHT_MONITOR_PUT);
+  mmsg->options = htonl(options);
+  mmsg->type = htonl(type);
+  mmsg->hop_count = htonl(hop_count);
+  mmsg->desired_replication_level = htonl(desired_replication_level);
+  mmsg->put_path_length = htonl(path_length);
+  msg_path = (struct GNUNET_PeerIdentity *) &mmsg[1];
+  if (path_length > 0)
+  {
+    memcpy (msg_path, path,
+            path_length * sizeof (struct GNUNET_PeerIdentity));
+  }
+  mmsg->expiration_time = GNUNET_TIME_absolute_hton(exp);
+  memcpy (&mmsg->key, key, sizeof (struct GNUNET_HashCode));
+  if (size > 0)
+    memcpy (&msg_path[path_length], data, size);
+  for (i = 1; i < cl_size; i++)
+  {
+    struct PendingMessage *pmc;
+
+    pmc = GNUNET_malloc (msize);
+    memcpy (pmc, pm, msize);
+    pmc->msg = (struct GNUNET_MessageHeader *) &pmc[1];
+    add_pending_message (cl[i], pmc);
+  }
+  add_pending_message (cl[0], pm);
+  GNUNET_free (cl);
 }
 
 
@@ -330,6 +330,13 @@ struct PeerInfo
    */
   struct GNUNET_PeerIdentity id;
 
+  /**
+   * Hash of the peer's identity; used for routing decisions.  Cached
+   * here so that peer selection does not have to recompute it for
+   * every candidate of every routed message.
+   */
+  struct GNUNET_HashCode phash;
+
 #if 0
   /**
    * What is the average latency for replies received?
@@ -806,6 +813,7 @@ handle_core_connect (void *cls,
   ret->distance = distance;
 #endif
   ret->id = *peer;
+  ret->phash = phash;
   GNUNET_CONTAINER_DLL_insert_tail (k_buckets[peer_bucket].head,
                                     k_buckets[peer_bucket].tail,
                                     ret);
@@ -910,6 +918,29 @@ handle_core_disconnect (void *cls,
 }
 
 
+/**
+ * Compute how many bytes of transmission capacity to request from
+ * core for a peer's queue.  Covers all pending messages (capped at
+ * what core accepts per request), so that #core_transmit_notify()
+ * can batch them into a single transmission.
+ *
+ * @param peer peer whose queue to measure
+ * @return number of bytes to request from core
+ */
+static size_t
+get_queue_size (struct PeerInfo *peer)
+{
+  struct P2PPendingMessage *pos;
+  size_t msize;
+
+  msize = 0;
+  for (pos = peer->head; NULL != pos; pos = pos->next)
+    msize += ntohs (pos->msg->size);
+  return GNUNET_MIN (msize,
+                     GNUNET_CONSTANTS_MAX_ENCRYPTED_MESSAGE_SIZE);
+}
+
+
 /**
  * Called when core is ready to send a message we asked for
  * out to the destination.
@@ -955,7 +986,7 @@ core_transmit_notify (void *cls,
                                            GNUNET_CORE_PRIO_BEST_EFFORT,
                                            GNUNET_TIME_absolute_get_remaining
                                            (pending->timeout), &peer->id,
-                                           ntohs (pending->msg->size),
+                                           get_queue_size (peer),
                                            &core_transmit_notify, peer);
     GNUNET_break (NULL != peer->th);
     return 0;
@@ -978,16 +1009,13 @@ core_transmit_notify (void *cls,
   }
   if (NULL != (pending = peer->head))
   {
-    /* technically redundant, but easier to read and
-       avoids bogus gcc warning... */
-    msize = ntohs (pending->msg->size);
     peer->th =
       GNUNET_CORE_notify_transmit_ready (core_api,
 					 GNUNET_NO,
 					 GNUNET_CORE_PRIO_BEST_EFFORT,
 					 GNUNET_TIME_absolute_get_remaining (pending->timeout),
 					 &peer->id,
-					 msize,
+					 get_queue_size (peer),
 					 &core_transmit_notify,
 					 peer);
     GNUNET_break (NULL != peer->th);
@@ -1020,7 +1048,7 @@ process_peer_queue (struct PeerInfo *peer)
                                          GNUNET_TIME_absolute_get_remaining
                                          (pending->timeout),
                                          &peer->id,
-                                         ntohs (pending->msg->size),
+                                         get_queue_size (peer),
                                          &core_transmit_notify,
                                          peer);
   GNUNET_break (NULL != peer->th);
@@ -1155,7 +1183,6 @@ am_closest_peer (const struct GNUNET_HashCode *key,
   int bucket_num;
   int count;
   struct PeerInfo *pos;
-  struct GNUNET_HashCode phash;
 
   if (0 == memcmp (&my_identity_hash, key, sizeof (struct GNUNET_HashCode)))
     return GNUNET_YES;
@@ -1166,17 +1193,14 @@ am_closest_peer (const struct GNUNET_HashCode *key,
   count = 0;
   while ((NULL != pos) && (count < bucket_size))
   {
-    GNUNET_CRYPTO_hash (&pos->id,
-			sizeof (struct GNUNET_PeerIdentity),
-			&phash);
     if ((NULL != bloom) &&
         (GNUNET_YES ==
-         GNUNET_CONTAINER_bloomfilter_test (bloom, &phash)))
+         GNUNET_CONTAINER_bloomfilter_test (bloom, &pos->phash)))
     {
       pos = pos->next;
       continue;                 /* Skip already checked entries */
     }
-    other_bits = GNUNET_CRYPTO_hash_matching_bits (&phash, key);
+    other_bits = GNUNET_CRYPTO_hash_matching_bits (&pos->phash, key);
     if (other_bits > bits)
       return GNUNET_NO;
     if (other_bits == bits)     /* We match the same number of bits */
@@ -1217,7 +1241,6 @@ select_peer (const struct GNUNET_HashCode *key,
   unsigned int dist;
   unsigned int smallest_distance;
   struct PeerInfo *chosen;
-  struct GNUNET_HashCode phash;
 
   if (hops >= GDS_NSE_get ())
   {
@@ -1230,14 +1253,11 @@ select_peer (const struct GNUNET_HashCode *key,
       count = 0;
       while ((pos != NULL) && (count < bucket_size))
       {
-	GNUNET_CRYPTO_hash (&pos->id,
-			    sizeof (struct GNUNET_PeerIdentity),
-			    &phash);
         if ((bloom == NULL) ||
             (GNUNET_NO ==
-             GNUNET_CONTAINER_bloomfilter_test (bloom, &phash)))
+             GNUNET_CONTAINER_bloomfilter_test (bloom, &pos->phash)))
         {
-          dist = get_distance (key, &phash);
+          dist = get_distance (key, &pos->phash);
           if (dist < smallest_distance)
           {
             chosen = pos;
@@ -1253,7 +1273,7 @@ select_peer (const struct GNUNET_HashCode *key,
                                     gettext_noop
                                     ("# Peers excluded from routing due to Bloomfilter"),
                                     1, GNUNET_NO);
-          dist = get_distance (key, &phash);
+          dist = get_distance (key, &pos->phash);
           if (dist < smallest_distance)
           {
             chosen = NULL;
@@ -1279,12 +1299,9 @@ select_peer (const struct GNUNET_HashCode *key,
     pos = k_buckets[bc].head;
     while ((pos != NULL) && (count < bucket_size))
     {
-      GNUNET_CRYPTO_hash (&pos->id,
-			  sizeof (struct GNUNET_PeerIdentity),
-			  &phash);
       if ((bloom != NULL) &&
           (GNUNET_YES ==
-           GNUNET_CONTAINER_bloomfilter_test (bloom, &phash)))
+           GNUNET_CONTAINER_bloomfilter_test (bloom, &pos->phash)))
       {
         GNUNET_STATISTICS_update (GDS_stats,
                                   gettext_noop
@@ -1314,12 +1331,9 @@ select_peer (const struct GNUNET_HashCode *key,
   {
     for (pos = k_buckets[bc].head; ((pos != NULL) && (count < bucket_size)); pos = pos->next)
     {
-      GNUNET_CRYPTO_hash (&pos->id,
-			  sizeof (struct GNUNET_PeerIdentity),
-			  &phash);
       if ((bloom != NULL) &&
           (GNUNET_YES ==
-           GNUNET_CONTAINER_bloomfilter_test (bloom, &phash)))
+           GNUNET_CONTAINER_bloomfilter_test (bloom, &pos->phash)))
       {
         continue;               /* Ignore bloomfiltered peers */
       }
@@ -1355,7 +1369,6 @@ get_target_peers (const struct GNUNET_HashCode *key,
   unsigned int off;
   struct PeerInfo **rtargets;
   struct PeerInfo *nxt;
-  struct GNUNET_HashCode nhash;
 
   GNUNET_assert (NULL != bloom);
   ret = get_forward_count (hop_count, target_replication);
@@ -1371,13 +1384,10 @@ get_target_peers (const struct GNUNET_HashCode *key,
     if (NULL == nxt)
       break;
     rtargets[off] = nxt;
-    GNUNET_CRYPTO_hash (&nxt->id,
-			sizeof (struct GNUNET_PeerIdentity),
-			&nhash);
     GNUNET_break (GNUNET_NO ==
                   GNUNET_CONTAINER_bloomfilter_test (bloom,
-                                                     &nhash));
-    GNUNET_CONTAINER_bloomfilter_add (bloom, &nhash);
+                                                     &nxt->phash));
+    GNUNET_CONTAINER_bloomfilter_add (bloom, &nxt->phash);
   }
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Selected %u/%u peers at hop %u for %s (target was %u)\n",
@@ -1442,7 +1452,6 @@ GDS_NEIGHBOURS_handle_put (enum GNUNET_BLOCK_Type type,
   size_t msize;
   struct PeerPutMessage *ppm;
   struct GNUNET_PeerIdentity *pp;
-  struct GNUNET_HashCode thash;
   unsigned int skip_count;
 
   GNUNET_assert (NULL != bf);
@@ -1481,6 +1490,26 @@ GDS_NEIGHBOURS_handle_put (enum GNUNET_BLOCK_Type type,
                             gettext_noop
                             ("# PUT messages queued for transmission"),
                             target_count, GNUNET_NO);
+  /* The message is identical for all targets, so serialize it only
+     once and give each target queue a copy. */
+  ppm = GNUNET_malloc (msize);
+  ppm->header.size = htons (msize);
+  ppm->header.type = htons (GNUNET_MESSAGE_TYPE_DHT_P2P_PUT);
+  ppm->options = htonl (options);
+  ppm->type = htonl (type);
+  ppm->hop_count = htonl (hop_count + 1);
+  ppm->desired_replication_level = htonl (desired_replication_level);
+  ppm->put_path_length = htonl (put_path_length);
+  ppm->expiration_time = GNUNET_TIME_absolute_hton (expiration_time);
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_bloomfilter_get_raw_data (bf,
+                                                            ppm->bloomfilter,
+                                                            DHT_BLOOM_SIZE));
+  ppm->key = *key;
+  pp = (struct GNUNET_PeerIdentity *) &ppm[1];
+  memcpy (pp, put_path,
+          sizeof (struct GNUNET_PeerIdentity) * put_path_length);
+  memcpy (&pp[put_path_length], data, data_size);
   skip_count = 0;
   for (i = 0; i < target_count; i++)
   {
@@ -1497,38 +1526,19 @@ GDS_NEIGHBOURS_handle_put (enum GNUNET_BLOCK_Type type,
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                 "Routing PUT for %s after %u hops to %s\n", GNUNET_h2s (key),
                 (unsigned int) hop_count, GNUNET_i2s (&target->id));
+    GNUNET_break (GNUNET_YES ==
+                  GNUNET_CONTAINER_bloomfilter_test (bf,
+                                                     &target->phash));
     pending = GNUNET_malloc (sizeof (struct P2PPendingMessage) + msize);
     pending->importance = 0;    /* FIXME */
     pending->timeout = expiration_time;
-    ppm = (struct PeerPutMessage *) &pending[1];
-    pending->msg = &ppm->header;
-    ppm->header.size = htons (msize);
-    ppm->header.type = htons (GNUNET_MESSAGE_TYPE_DHT_P2P_PUT);
-    ppm->options = htonl (options);
-    ppm->type = htonl (type);
-    ppm->hop_count = htonl (hop_count + 1);
-    ppm->desired_replication_level = htonl (desired_replication_level);
-    ppm->put_path_length = htonl (put_path_length);
-    ppm->expiration_time = GNUNET_TIME_absolute_hton (expiration_time);
-    GNUNET_CRYPTO_hash (&target->id,
-			sizeof (struct GNUNET_PeerIdentity),
-			&thash);
-    GNUNET_break (GNUNET_YES ==
-                  GNUNET_CONTAINER_bloomfilter_test (bf,
-                                                     &thash));
-    GNUNET_assert (GNUNET_OK ==
-                   GNUNET_CONTAINER_bloomfilter_get_raw_data (bf,
-                                                              ppm->bloomfilter,
-                                                              DHT_BLOOM_SIZE));
-    ppm->key = *key;
-    pp = (struct GNUNET_PeerIdentity *) &ppm[1];
-    memcpy (pp, put_path,
-            sizeof (struct GNUNET_PeerIdentity) * put_path_length);
-    memcpy (&pp[put_path_length], data, data_size);
+    pending->msg = (struct GNUNET_MessageHeader *) &pending[1];
+    memcpy (&pending[1], ppm, msize);
     GNUNET_CONTAINER_DLL_insert_tail (target->head, target->tail, pending);
     target->pending_count++;
     process_peer_queue (target);
   }
+  GNUNET_free (ppm);
   GNUNET_free (targets);
   return (skip_count < target_count) ? GNUNET_OK : GNUNET_NO;
 }
@@ -1571,7 +1581,6 @@ GDS_NEIGHBOURS_handle_get (enum GNUNET_BLOCK_Type type,
   struct PeerGetMessage *pgm;
   char *xq;
   size_t reply_bf_size;
-  struct GNUNET_HashCode thash;
   unsigned int skip_count;
 
   GNUNET_assert (NULL != peer_bf);
@@ -1634,12 +1643,9 @@ GDS_NEIGHBOURS_handle_get (enum GNUNET_BLOCK_Type type,
     pgm->desired_replication_level = htonl (desired_replication_level);
     pgm->xquery_size = htonl (xquery_size);
     pgm->bf_mutator = reply_bf_mutator;
-    GNUNET_CRYPTO_hash (&target->id,
-			sizeof (struct GNUNET_PeerIdentity),
-			&thash);
     GNUNET_break (GNUNET_YES ==
                   GNUNET_CONTAINER_bloomfilter_test (peer_bf,
-                                                     &thash));
+                                                     &target->phash));
     GNUNET_assert (GNUNET_OK ==
                    GNUNET_CONTAINER_bloomfilter_get_raw_data (peer_bf,
                                                               pgm->bloomfilter,
@@ -1966,7 +1972,6 @@ handle_find_peer (const struct GNUNET_PeerIdentity *sender,
   struct PeerBucket *bucket;
   struct PeerInfo *peer;
   unsigned int choice;
-  struct GNUNET_HashCode phash;
   struct GNUNET_HashCode mhash;
   const struct GNUNET_HELLO_Message *hello;
 
@@ -2028,8 +2033,7 @@ handle_find_peer (const struct GNUNET_PeerIdentity *sender,
       return;                   /* no non-masked peer available */
     if (peer == NULL)
       peer = bucket->head;
-    GNUNET_CRYPTO_hash (&peer->id, sizeof (struct GNUNET_PeerIdentity), &phash);
-    GNUNET_BLOCK_mingle_hash (&phash, bf_mutator, &mhash);
+    GNUNET_BLOCK_mingle_hash (&peer->phash, bf_mutator, &mhash);
     hello = GDS_HELLO_get (&peer->id);
   }
   while ((hello == NULL) ||
@@ -2171,6 +2175,26 @@ handle_dht_p2p_get (void *cls,
                                     &reply_bf, get->bf_mutator);
     }
   }
+  else if (GNUNET_YES == cache_results)
+  {
+    /* We are not responsible for the key, but passing replies are
+       stored in the datacache (CACHE_RESULTS); answering repeated
+       popular queries from memory saves the whole forward path. */
+    eval =
+        GDS_DATACACHE_handle_get (&get->key, type, xquery, xquery_size,
+                                  &reply_bf, get->bf_mutator);
+    if ( (GNUNET_BLOCK_EVALUATION_OK_MORE == eval) ||
+         (GNUNET_BLOCK_EVALUATION_OK_LAST == eval) )
+      GNUNET_STATISTICS_update (GDS_stats,
+                                gettext_noop
+                                ("# Routed GETs answered from result cache"),
+                                1, GNUNET_NO);
+    else
+      GNUNET_STATISTICS_update (GDS_stats,
+                                gettext_noop
+                                ("# Routed GETs not found in result cache"),
+                                1, GNUNET_NO);
+  }
   else
   {
     GNUNET_STATISTICS_update (GDS_stats,
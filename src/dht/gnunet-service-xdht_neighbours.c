@@ -2845,22 +2845,21 @@ is_new_trail_unique (struct FingerInfo *existing_finger,
 
     /* New trail and existing trail length are not same. */
     if (current_trail->trail_length != trail_length)
-    {
-      return GNUNET_YES;
-    }
+      continue;
 
     trail_element = current_trail->trail_head;
     for (j = 0; j < current_trail->trail_length; j++)
     {
       if (0 != GNUNET_CRYPTO_cmp_peer_identity (&new_trail[j],
                                                 &trail_element->peer))
-      {
-        return GNUNET_YES;
-      }
+        break;
       trail_element = trail_element->next;
     }
+    /* All the peers of this trail matched the new one. */
+    if (j == current_trail->trail_length)
+      return GNUNET_NO;
   }
-  return GNUNET_NO;
+  return GNUNET_YES;
 }
 
 /**
@@ -2881,6 +2880,9 @@ add_new_trail (struct FingerInfo *existing_finger,
 {
   struct FriendInfo *friend;
   struct Trail *trail;
+  struct GNUNET_PeerIdentity *next_hop;
+  const struct GNUNET_PeerIdentity *first_hop;
+  const struct GNUNET_PeerIdentity *new_first_hop;
   unsigned int i;
   int free_slot = -1;
 
@@ -2888,6 +2890,44 @@ add_new_trail (struct FingerInfo *existing_finger,
                                         new_trail_length))
     return;
 
+  /* Trail compaction: a trail entering the network over the same first
+     hop as an existing trail adds no link-disjointness.  Keep only the
+     shorter of the two; tear down the new one if it is not shorter. */
+  if (0 == new_trail_length)
+    new_first_hop = &existing_finger->finger_identity;
+  else
+    new_first_hop = &new_trail[0];
+  for (i = 0; i < existing_finger->trails_count; i++)
+  {
+    trail = &existing_finger->trail_list[i];
+    if (GNUNET_NO == trail->is_present)
+      continue;
+    if (0 == trail->trail_length)
+      first_hop = &existing_finger->finger_identity;
+    else
+      first_hop = &trail->trail_head->peer;
+    if ((0 == GNUNET_CRYPTO_cmp_peer_identity (first_hop, new_first_hop)) &&
+        (trail->trail_length <= new_trail_length))
+    {
+      struct GNUNET_PeerIdentity nh;
+
+      next_hop = GDS_ROUTING_get_next_hop (new_trail_id,
+                                           GDS_ROUTING_SRC_TO_DEST);
+      if (NULL != next_hop)
+      {
+        /* Copy before the removal frees the routing entry. */
+        nh = *next_hop;
+        GDS_ROUTING_remove_trail (new_trail_id);
+        GDS_NEIGHBOURS_send_trail_teardown (&new_trail_id,
+                                            GDS_ROUTING_SRC_TO_DEST,
+                                            &nh);
+      }
+      else
+        GDS_ROUTING_remove_trail (new_trail_id);
+      return;
+    }
+  }
+
   for (i = 0; i < existing_finger->trails_count; i++)
   {
     if (GNUNET_NO == existing_finger->trail_list[i].is_present)
@@ -74,6 +74,36 @@ struct RoutingTrail
  */
 static struct GNUNET_CONTAINER_MultiHashMap *routing_table;
 
+/**
+ * Index of the trails by the peers adjacent to us on them (next_hop
+ * and prev_hop), so that cleaning up after a disconnected friend does
+ * not require scanning the whole routing table.  Maintained
+ * incrementally by #GDS_ROUTING_add() and the removal functions.
+ */
+static struct GNUNET_CONTAINER_MultiPeerMap *hop_index;
+
+
+/**
+ * Remove a trail from the hop index, under both of its adjacent
+ * peers.
+ *
+ * @param trail Trail to remove.
+ */
+static void
+hop_index_remove (struct RoutingTrail *trail)
+{
+  GNUNET_assert (GNUNET_YES ==
+                 GNUNET_CONTAINER_multipeermap_remove (hop_index,
+                                                       &trail->next_hop,
+                                                       trail));
+  if (0 != GNUNET_CRYPTO_cmp_peer_identity (&trail->next_hop,
+                                            &trail->prev_hop))
+    GNUNET_assert (GNUNET_YES ==
+                   GNUNET_CONTAINER_multipeermap_remove (hop_index,
+                                                         &trail->prev_hop,
+                                                         trail));
+}
+
 /**
  * Update the prev. hop of the trail. Call made by trail compression where
  * if you are the first friend now in the trail then you need to update
@@ -172,6 +202,7 @@ GDS_ROUTING_remove_trail (const struct GNUNET_HashCode remove_trail_id)
                                                           &remove_trail_id,
                                                           remove_entry))
   {
+    hop_index_remove (remove_entry);
     GNUNET_free (remove_entry);
     return GNUNET_YES;
   }
@@ -181,21 +212,18 @@ GDS_ROUTING_remove_trail (const struct GNUNET_HashCode remove_trail_id)
 
 
 /**
- * Iterate over routing table and remove entries with value as part of any trail.
+ * Remove a trail adjacent to a disconnected peer, sending a trail
+ * teardown message in the direction of the hop which is still
+ * connected.
  *
- * @param cls closure
- * @param key current public key
- * @param value value in the hash map
- * @return #GNUNET_YES if we should continue to iterate,
- *         #GNUNET_NO if not.
+ * @param remove_trail Trail to remove.
+ * @param disconnected_peer Peer that got disconnected.
  */
-static int remove_matching_trails (void *cls,
-                                   const struct GNUNET_HashCode *key,
-                                   void *value)
+static void
+remove_matching_trail (struct RoutingTrail *remove_trail,
+                       const struct GNUNET_PeerIdentity *disconnected_peer)
 {
-  struct RoutingTrail *remove_trail = value;
-  struct GNUNET_PeerIdentity *disconnected_peer = cls;
-  struct GNUNET_HashCode trail_id = *key;
+  struct GNUNET_HashCode trail_id = remove_trail->trail_id;
   struct GNUNET_PeerIdentity my_identity;
 
   /* If disconnected_peer is next_hop, then send a trail teardown message through
@@ -233,7 +261,45 @@ static int remove_matching_trails (void *cls,
                    GNUNET_CONTAINER_multihashmap_remove (routing_table,
                                                          &trail_id,
                                                          remove_trail));
+  hop_index_remove (remove_trail);
   GNUNET_free (remove_trail);
+}
+
+
+/**
+ * Closure for #collect_matching_trails().
+ */
+struct TrailCollection
+{
+  /**
+   * Array with the trails found under the peer's key.
+   */
+  struct RoutingTrail **trails;
+
+  /**
+   * Number of entries in @e trails.
+   */
+  unsigned int count;
+};
+
+
+/**
+ * Collect the trails indexed under a peer into a closure-provided
+ * array, so they can be removed after the index iteration is done.
+ *
+ * @param cls the `struct TrailCollection`
+ * @param key peer the trails are indexed under
+ * @param value the `struct RoutingTrail`
+ * @return #GNUNET_YES to continue to iterate
+ */
+static int
+collect_matching_trails (void *cls,
+                         const struct GNUNET_PeerIdentity *key,
+                         void *value)
+{
+  struct TrailCollection *tc = cls;
+
+  tc->trails[tc->count++] = value;
   return GNUNET_YES;
 }
 
@@ -282,17 +348,31 @@ GDS_ROUTING_test_print (void)
 int
 GDS_ROUTING_remove_trail_by_peer (const struct GNUNET_PeerIdentity *peer)
 {
-  int ret;
-
+  struct TrailCollection tc;
+  unsigned int matches;
+  unsigned int i;
 
   /* No entries in my routing table. */
   if (0 == GNUNET_CONTAINER_multihashmap_size(routing_table))
     return GNUNET_YES;
 
-  ret = GNUNET_CONTAINER_multihashmap_iterate (routing_table,
-                                               &remove_matching_trails,
-                                               (void *)peer);
-  return ret;
+  /* Only look at the trails the peer is actually adjacent to us on,
+     instead of scanning the whole routing table. */
+  matches = GNUNET_CONTAINER_multipeermap_get_multiple (hop_index,
+                                                        peer,
+                                                        NULL, NULL);
+  if (0 == matches)
+    return GNUNET_YES;
+  tc.trails = GNUNET_malloc (matches * sizeof (struct RoutingTrail *));
+  tc.count = 0;
+  GNUNET_CONTAINER_multipeermap_get_multiple (hop_index,
+                                              peer,
+                                              &collect_matching_trails,
+                                              &tc);
+  for (i = 0; i < tc.count; i++)
+    remove_matching_trail (tc.trails[i], peer);
+  GNUNET_free (tc.trails);
+  return tc.count;
 }
 
 
@@ -311,17 +391,34 @@ GDS_ROUTING_add (struct GNUNET_HashCode new_trail_id,
                  struct GNUNET_PeerIdentity next_hop)
 {
   struct RoutingTrail *new_entry;
+  int ret;
 
   new_entry = GNUNET_new (struct RoutingTrail);
   new_entry->trail_id = new_trail_id;
   new_entry->next_hop = next_hop;
   new_entry->prev_hop = prev_hop;
 
-
-  return GNUNET_CONTAINER_multihashmap_put (routing_table,
-                                            &new_trail_id, new_entry,
-                                            GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY);
-
+  ret = GNUNET_CONTAINER_multihashmap_put (routing_table,
+                                           &new_trail_id, new_entry,
+                                           GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY);
+  if (GNUNET_OK != ret)
+  {
+    GNUNET_free (new_entry);
+    return ret;
+  }
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_multipeermap_put (hop_index,
+                                                    &new_entry->next_hop,
+                                                    new_entry,
+                                                    GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
+  if (0 != GNUNET_CRYPTO_cmp_peer_identity (&new_entry->next_hop,
+                                            &new_entry->prev_hop))
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multipeermap_put (hop_index,
+                                                      &new_entry->prev_hop,
+                                                      new_entry,
+                                                      GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
+  return ret;
 }
 
 
@@ -347,6 +444,8 @@ GDS_ROUTING_init (void)
 {
   routing_table = GNUNET_CONTAINER_multihashmap_create (ROUTING_TABLE_THRESHOLD * 4 / 3,
                                                         GNUNET_NO);
+  hop_index = GNUNET_CONTAINER_multipeermap_create (ROUTING_TABLE_THRESHOLD * 4 / 3,
+                                                    GNUNET_NO);
 }
 
 
@@ -358,6 +457,8 @@ GDS_ROUTING_done (void)
 {
   GNUNET_assert (0 == GNUNET_CONTAINER_multihashmap_size (routing_table));
   GNUNET_CONTAINER_multihashmap_destroy (routing_table);
+  GNUNET_assert (0 == GNUNET_CONTAINER_multipeermap_size (hop_index));
+  GNUNET_CONTAINER_multipeermap_destroy (hop_index);
 }
 
 /* end of gnunet-service-xdht_routing.c */
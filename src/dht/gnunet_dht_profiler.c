@@ -197,6 +197,11 @@ struct ActiveContext
    */
   struct GNUNET_SCHEDULER_Task * delay_task;
 
+  /**
+   * When did we start the currently running PUT or GET?
+   */
+  struct GNUNET_TIME_Absolute op_start_time;
+
   /**
    * The size of the @e put_data
    */
@@ -319,6 +324,28 @@ static uint64_t outgoing_bandwidth;
  */
 static uint64_t incoming_bandwidth;
 
+/**
+ * Total number of PUT and GET requests routed by all peers.
+ */
+static uint64_t total_routed_messages;
+
+/**
+ * When did we connect to the DHT services and start issuing operations?
+ */
+static struct GNUNET_TIME_Absolute prof_start_time;
+
+/**
+ * Latencies of the successful PUT operations.  Allocated for @e n_active
+ * entries; the first @e n_puts_ok of them are valid.
+ */
+static struct GNUNET_TIME_Relative *put_latencies;
+
+/**
+ * Latencies of the successful GET operations.  Allocated for @e n_active
+ * entries; the first @e n_gets_ok of them are valid.
+ */
+static struct GNUNET_TIME_Relative *get_latencies;
+
 /**
  * Average number of hops taken to do put.
  */
@@ -463,6 +490,8 @@ do_shutdown (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
     GNUNET_TESTBED_operation_done (bandwidth_stats_op);
   bandwidth_stats_op = NULL;
   GNUNET_free_non_null (a_ac);
+  GNUNET_free_non_null (put_latencies);
+  GNUNET_free_non_null (get_latencies);
 }
 
 
@@ -480,8 +509,15 @@ bandwidth_stats_cont (void *cls,
                       struct GNUNET_TESTBED_Operation *op,
                       const char *emsg)
 {
+  struct GNUNET_TIME_Relative duration;
+
+  duration = GNUNET_TIME_absolute_get_duration (prof_start_time);
   INFO ("# Outgoing bandwidth: %u\n", outgoing_bandwidth);
   INFO ("# Incoming bandwidth: %u\n", incoming_bandwidth);
+  if (0 != duration.rel_value_us)
+    INFO ("# Messages routed per second: %.2f\n",
+          ((double) total_routed_messages) * 1000.0 * 1000.0
+          / ((double) duration.rel_value_us));
   GNUNET_SCHEDULER_shutdown ();
 }
 
@@ -507,16 +543,74 @@ bandwidth_stats_iterator (void *cls,
 {
    static const char *s_sent = "# Bytes transmitted to other peers";
    static const char *s_recv = "# Bytes received from other peers";
+   static const char *s_put_routed = "# PUT requests routed";
+   static const char *s_get_routed = "# GET requests routed";
 
    if (0 == strncmp (s_sent, name, strlen (s_sent)))
      outgoing_bandwidth = outgoing_bandwidth + value;
    else if (0 == strncmp(s_recv, name, strlen (s_recv)))
      incoming_bandwidth = incoming_bandwidth + value;
+   else if (0 == strncmp(s_put_routed, name, strlen (s_put_routed)))
+     total_routed_messages = total_routed_messages + value;
+   else if (0 == strncmp(s_get_routed, name, strlen (s_get_routed)))
+     total_routed_messages = total_routed_messages + value;
 
     return GNUNET_OK;
 }
 
 
+/**
+ * Comparator for sorting latency samples in increasing order.
+ *
+ * @param a pointer to a `struct GNUNET_TIME_Relative`
+ * @param b pointer to a `struct GNUNET_TIME_Relative`
+ * @return -1, 0 or 1 depending on whether @a a is smaller, equal or larger
+ */
+static int
+compare_latencies (const void *a, const void *b)
+{
+  const struct GNUNET_TIME_Relative *l1 = a;
+  const struct GNUNET_TIME_Relative *l2 = b;
+
+  if (l1->rel_value_us < l2->rel_value_us)
+    return -1;
+  if (l1->rel_value_us > l2->rel_value_us)
+    return 1;
+  return 0;
+}
+
+
+/**
+ * Sort the given latency samples and print the 50th, 99th and 99.9th
+ * percentiles.
+ *
+ * @param desc name of the operation the samples were taken from
+ * @param latencies the latency samples; sorted as a side-effect
+ * @param cnt number of entries in @a latencies
+ */
+static void
+summarize_latencies (const char *desc,
+                     struct GNUNET_TIME_Relative *latencies,
+                     unsigned int cnt)
+{
+  static const char *p_desc[] = { "p50", "p99", "p99.9" };
+  static const unsigned int p_rank[] = { 500, 990, 999 };
+  unsigned int i;
+
+  if (0 == cnt)
+    return;
+  qsort (latencies, cnt, sizeof (struct GNUNET_TIME_Relative),
+         &compare_latencies);
+  for (i = 0; i < 3; i++)
+    INFO ("# %s latency %s: %s\n",
+          desc,
+          p_desc[i],
+          GNUNET_STRINGS_relative_time_to_string (latencies[(cnt - 1)
+                                                            * p_rank[i] / 1000],
+                                                  GNUNET_YES));
+}
+
+
 static void
 summarize ()
 {
@@ -528,6 +622,8 @@ summarize ()
   INFO ("# GETS failed: %u\n", n_gets_fail);
   INFO ("# average_put_path_length: %f\n", average_put_path_length);
   INFO ("# average_get_path_length: %f\n", average_get_path_length);
+  summarize_latencies ("PUT", put_latencies, n_puts_ok);
+  summarize_latencies ("GET", get_latencies, n_gets_ok);
 
   if (NULL == testbed_handles)
   {
@@ -609,6 +705,8 @@ get_iter (void *cls,
   GNUNET_assert (0 == memcmp (key, &get_ac->hash, sizeof (struct GNUNET_HashCode)));
   /* we found the data we are looking for */
   DEBUG ("We found a GET request; %u remaining\n", n_gets - (n_gets_fail + n_gets_ok)); //FIXME: It always prints 1.
+  get_latencies[n_gets_ok] =
+      GNUNET_TIME_absolute_get_duration (ac->op_start_time);
   n_gets_ok++;
   get_ac->nrefs--;
   GNUNET_DHT_get_stop (ac->dht_get);
@@ -658,6 +756,7 @@ delayed_get (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
   get_ac->nrefs++;
   ac->get_ac = get_ac;
   DEBUG ("GET_REQUEST_START key %s \n", GNUNET_h2s((struct GNUNET_HashCode *)ac->put_data));
+  ac->op_start_time = GNUNET_TIME_absolute_get ();
   ac->dht_get = GNUNET_DHT_get_start (ac->dht,
                                       GNUNET_BLOCK_TYPE_TEST,
                                       &get_ac->hash,
@@ -716,7 +815,11 @@ put_cont (void *cls, int success)
 
   ac->dht_put = NULL;
   if (success)
+  {
+    put_latencies[n_puts_ok] =
+        GNUNET_TIME_absolute_get_duration (ac->op_start_time);
     n_puts_ok++;
+  }
   else
     n_puts_fail++;
   GNUNET_assert (NULL != ctx);
@@ -745,6 +848,7 @@ delayed_put (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
                               ac->put_data, ac->put_data_size);
   GNUNET_CRYPTO_hash (ac->put_data, ac->put_data_size, &ac->hash);
   DEBUG ("PUT_REQUEST_START key %s \n", GNUNET_h2s((struct GNUNET_HashCode *)ac->put_data));
+  ac->op_start_time = GNUNET_TIME_absolute_get ();
   ac->dht_put = GNUNET_DHT_put (ac->dht, &ac->hash,
                                 replication,
                                 GNUNET_DHT_RO_RECORD_ROUTE,
@@ -878,6 +982,8 @@ start_profiling()
 
   DEBUG("GNUNET_TESTBED_service_connect \n");
   GNUNET_break (GNUNET_YES != in_shutdown);
+  if (0 == prof_start_time.abs_value_us)
+    prof_start_time = GNUNET_TIME_absolute_get ();
   for(i = 0; i < n_active; i++)
   {
     struct ActiveContext *ac = &a_ac[i];
@@ -1359,6 +1465,11 @@ test_run (void *cls,
   }
   n_active = ac_cnt;
   INFO ("Active peers: %u\n", n_active);
+  /* Each active peer makes at most one PUT and one GET */
+  put_latencies = GNUNET_malloc (n_active *
+                                 sizeof (struct GNUNET_TIME_Relative));
+  get_latencies = GNUNET_malloc (n_active *
+                                 sizeof (struct GNUNET_TIME_Relative));
 
   /* start DHT service on all peers */
   for (cnt = 0; cnt < num_peers; cnt++)
@@ -198,37 +198,84 @@ GNUNET_DNSPARSER_free_record (struct GNUNET_DNSPARSER_Record *r)
 
 
 /**
- * Parse name inside of a DNS query or record.
+ * Buffer for assembling a DNS name from its labels without
+ * allocating a fresh copy of the name for each label.
+ */
+struct NameBuilder
+{
+  /**
+   * Buffer holding the name assembled so far, 0-terminated.
+   */
+  char *buf;
+
+  /**
+   * Number of characters used in @e buf (excluding 0-termination).
+   */
+  size_t len;
+
+  /**
+   * Number of bytes allocated for @e buf.
+   */
+  size_t size;
+};
+
+
+/**
+ * Append @a data_len bytes from @a data to the name being
+ * assembled in @a nb, growing the buffer as needed.
+ *
+ * @param nb name builder to append to
+ * @param data bytes to append
+ * @param data_len number of bytes in @a data
+ */
+static void
+name_builder_append (struct NameBuilder *nb,
+		     const char *data,
+		     size_t data_len)
+{
+  if (nb->len + data_len + 1 > nb->size)
+  {
+    nb->size = 2 * (nb->len + data_len + 1);
+    nb->buf = GNUNET_realloc (nb->buf, nb->size);
+  }
+  memcpy (&nb->buf[nb->len], data, data_len);
+  nb->len += data_len;
+  nb->buf[nb->len] = '\0';
+}
+
+
+/**
+ * Parse name inside of a DNS query or record, appending the
+ * labels (each followed by a ".") to @a nb.
  *
  * @param udp_payload entire UDP payload
  * @param udp_payload_length length of @a udp_payload
  * @param off pointer to the offset of the name to parse in the udp_payload (to be
  *                    incremented by the size of the name)
+ * @param nb name builder to append the labels to
  * @param depth current depth of our recursion (to prevent stack overflow)
- * @return name as 0-terminated C string on success, NULL if the payload is malformed
+ * @return #GNUNET_OK on success, #GNUNET_SYSERR if the payload is malformed
  */
-static char *
-parse_name (const char *udp_payload,
-	    size_t udp_payload_length,
-	    size_t *off,
-	    unsigned int depth)
+static int
+parse_name_labels (const char *udp_payload,
+		   size_t udp_payload_length,
+		   size_t *off,
+		   struct NameBuilder *nb,
+		   unsigned int depth)
 {
   const uint8_t *input = (const uint8_t *) udp_payload;
-  char *ret;
-  char *tmp;
-  char *xstr;
+  char label[64];
   uint8_t len;
   size_t xoff;
   char *utf8;
   Idna_rc rc;
 
-  ret = GNUNET_strdup ("");
   while (1)
   {
     if (*off >= udp_payload_length)
     {
       GNUNET_break_op (0);
-      goto error;
+      return GNUNET_SYSERR;
     }
     len = input[*off];
     if (0 == len)
@@ -241,41 +288,37 @@ parse_name (const char *udp_payload,
       if (*off + 1 + len > udp_payload_length)
       {
 	GNUNET_break_op (0);
-	goto error;
+	return GNUNET_SYSERR;
       }
-      GNUNET_asprintf (&tmp,
-		       "%.*s",
-		       (int) len,
-		       &udp_payload[*off + 1]);
+      memcpy (label,
+	      &udp_payload[*off + 1],
+	      len);
+      label[len] = '\0';
       if (IDNA_SUCCESS !=
-	  (rc = idna_to_unicode_8z8z (tmp, &utf8, IDNA_ALLOW_UNASSIGNED)))
+	  (rc = idna_to_unicode_8z8z (label, &utf8, IDNA_ALLOW_UNASSIGNED)))
       {
 	GNUNET_log (GNUNET_ERROR_TYPE_INFO,
 		    _("Failed to convert DNS IDNA name `%s' to UTF-8: %s\n"),
-		    tmp,
+		    label,
 		    idna_strerror (rc));
-	GNUNET_free (tmp);
-	GNUNET_asprintf (&tmp,
-			 "%s%.*s.",
-			 ret,
-			 (int) len,
-			 &udp_payload[*off + 1]);
+	name_builder_append (nb,
+			     label,
+			     len);
       }
       else
       {
-	GNUNET_free (tmp);
-	GNUNET_asprintf (&tmp,
-			 "%s%s.",
-			 ret,
-			 utf8);
+	name_builder_append (nb,
+			     utf8,
+			     strlen (utf8));
 #if WINDOWS
 	idn_free (utf8);
 #else
 	free (utf8);
 #endif
       }
-      GNUNET_free (ret);
-      ret = tmp;
+      name_builder_append (nb,
+			   ".",
+			   1);
       *off += 1 + len;
     }
     else if ((64 | 128) == (len & (64 | 128)) )
@@ -283,35 +326,29 @@ parse_name (const char *udp_payload,
       if (depth > 32)
       {
 	GNUNET_break_op (0);
-	goto error; /* hard bound on stack to prevent "infinite" recursion, disallow! */
+	return GNUNET_SYSERR; /* hard bound on stack to prevent "infinite" recursion, disallow! */
       }
       /* pointer to string */
       if (*off + 1 > udp_payload_length)
       {
 	GNUNET_break_op (0);
-	goto error;
+	return GNUNET_SYSERR;
       }
       xoff = ((len - (64 | 128)) << 8) + input[*off+1];
-      xstr = parse_name (udp_payload,
-			 udp_payload_length,
-			 &xoff,
-			 depth + 1);
-      if (NULL == xstr)
+      if (GNUNET_OK !=
+	  parse_name_labels (udp_payload,
+			     udp_payload_length,
+			     &xoff,
+			     nb,
+			     depth + 1))
       {
 	GNUNET_break_op (0);
-	goto error;
+	return GNUNET_SYSERR;
       }
-      GNUNET_asprintf (&tmp,
-		       "%s%s.",
-		       ret,
-		       xstr);
-      GNUNET_free (ret);
-      GNUNET_free (xstr);
-      ret = tmp;
-      if (strlen (ret) > udp_payload_length)
+      if (nb->len > udp_payload_length)
       {
 	GNUNET_break_op (0);
-	goto error; /* we are looping (building an infinite string) */
+	return GNUNET_SYSERR; /* we are looping (building an infinite string) */
       }
       *off += 2;
       /* pointers always terminate names */
@@ -321,16 +358,48 @@ parse_name (const char *udp_payload,
     {
       /* neither pointer nor inline string, not supported... */
       GNUNET_break_op (0);
-      goto error;
+      return GNUNET_SYSERR;
     }
   }
-  if (0 < strlen(ret))
-    ret[strlen(ret)-1] = '\0'; /* eat tailing '.' */
-  return ret;
- error:
-  GNUNET_break_op (0);
-  GNUNET_free (ret);
-  return NULL;
+  return GNUNET_OK;
+}
+
+
+/**
+ * Parse name inside of a DNS query or record.
+ *
+ * @param udp_payload entire UDP payload
+ * @param udp_payload_length length of @a udp_payload
+ * @param off pointer to the offset of the name to parse in the udp_payload (to be
+ *                    incremented by the size of the name)
+ * @param depth current depth of our recursion (to prevent stack overflow)
+ * @return name as 0-terminated C string on success, NULL if the payload is malformed
+ */
+static char *
+parse_name (const char *udp_payload,
+	    size_t udp_payload_length,
+	    size_t *off,
+	    unsigned int depth)
+{
+  struct NameBuilder nb;
+
+  nb.len = 0;
+  nb.size = 64;
+  nb.buf = GNUNET_malloc (nb.size);
+  nb.buf[0] = '\0';
+  if (GNUNET_OK !=
+      parse_name_labels (udp_payload,
+			 udp_payload_length,
+			 off,
+			 &nb,
+			 depth))
+  {
+    GNUNET_free (nb.buf);
+    return NULL;
+  }
+  if (0 < nb.len)
+    nb.buf[nb.len - 1] = '\0'; /* eat tailing '.' */
+  return nb.buf;
 }
 
 
@@ -31,6 +31,13 @@
  */
 #define REQUEST_TIMEOUT GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS, 5)
 
+/**
+ * How long do we wait at least before retransmitting a DNS request?
+ * (UDP is lossy, so we retry with exponential backoff until
+ * #REQUEST_TIMEOUT expires.)
+ */
+#define DNS_RETRANSMIT_DELAY GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MILLISECONDS, 250)
+
 /**
  * How many DNS sockets do we open at most at the same time?
  * (technical socket maximum is this number x2 for IPv4+IPv6)
@@ -74,6 +81,22 @@ struct GNUNET_DNSSTUB_RequestSocket
    */
   struct GNUNET_TIME_Absolute timeout;
 
+  /**
+   * Copy of the request message, kept for retransmission.
+   * NULL if this slot is idle.
+   */
+  void *request;
+
+  /**
+   * Number of bytes in @e request.
+   */
+  size_t request_len;
+
+  /**
+   * How long do we wait before retransmitting this request?
+   */
+  struct GNUNET_TIME_Relative retry_freq;
+
   /**
    * Address we sent the DNS request to.
    */
@@ -107,6 +130,31 @@ struct GNUNET_DNSSTUB_Context
 
 
 
+/**
+ * We're done with the request in a `struct GNUNET_DNSSTUB_RequestSocket`,
+ * release its state but keep the sockets open for reuse by the next
+ * request that lands in this slot.
+ *
+ * @param rs request socket to release
+ */
+static void
+release_rs (struct GNUNET_DNSSTUB_RequestSocket *rs)
+{
+  if (NULL != rs->read_task)
+  {
+    GNUNET_SCHEDULER_cancel (rs->read_task);
+    rs->read_task = NULL;
+  }
+  if (NULL != rs->request)
+  {
+    GNUNET_free (rs->request);
+    rs->request = NULL;
+  }
+  rs->request_len = 0;
+  rs->rc = NULL;
+}
+
+
 /**
  * We're done with a `struct GNUNET_DNSSTUB_RequestSocket`, close it for now.
  *
@@ -115,6 +163,7 @@ struct GNUNET_DNSSTUB_Context
 static void
 cleanup_rs (struct GNUNET_DNSSTUB_RequestSocket *rs)
 {
+  release_rs (rs);
   if (NULL != rs->dnsout4)
   {
     GNUNET_NETWORK_socket_close (rs->dnsout4);
@@ -125,11 +174,6 @@ cleanup_rs (struct GNUNET_DNSSTUB_RequestSocket *rs)
     GNUNET_NETWORK_socket_close (rs->dnsout6);
     rs->dnsout6 = NULL;
   }
-  if (NULL != rs->read_task)
-  {
-    GNUNET_SCHEDULER_cancel (rs->read_task);
-    rs->read_task = NULL;
-  }
 }
 
 
@@ -209,35 +253,33 @@ get_request_socket (struct GNUNET_DNSSTUB_Context *ctx,
 
   rs = &ctx->sockets[GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_NONCE,
 					       DNS_SOCKET_MAX)];
+  release_rs (rs);
   rs->timeout = GNUNET_TIME_relative_to_absolute (REQUEST_TIMEOUT);
+  rs->retry_freq = DNS_RETRANSMIT_DELAY;
   switch (af)
   {
   case AF_INET:
     if (NULL == rs->dnsout4)
       rs->dnsout4 = open_socket (AF_INET);
+    if (NULL == rs->dnsout4)
+      return NULL;
     break;
   case AF_INET6:
     if (NULL == rs->dnsout6)
       rs->dnsout6 = open_socket (AF_INET6);
+    if (NULL == rs->dnsout6)
+      return NULL;
     break;
   default:
     return NULL;
   }
-  if (NULL != rs->read_task)
-  {
-    GNUNET_SCHEDULER_cancel (rs->read_task);
-    rs->read_task = NULL;
-  }
-  if ( (NULL == rs->dnsout4) &&
-       (NULL == rs->dnsout6) )
-    return NULL;
   rset = GNUNET_NETWORK_fdset_create ();
   if (NULL != rs->dnsout4)
     GNUNET_NETWORK_fdset_set (rset, rs->dnsout4);
   if (NULL != rs->dnsout6)
     GNUNET_NETWORK_fdset_set (rset, rs->dnsout6);
   rs->read_task = GNUNET_SCHEDULER_add_select (GNUNET_SCHEDULER_PRIORITY_DEFAULT,
-					       REQUEST_TIMEOUT,
+					       rs->retry_freq,
 					       rset,
 					       NULL,
 					       &read_response, rs);
@@ -246,6 +288,44 @@ get_request_socket (struct GNUNET_DNSSTUB_Context *ctx,
 }
 
 
+/**
+ * Transmit (or retransmit) the request stored in @a rs to the DNS
+ * server, using the socket matching the server's address family.
+ *
+ * @param rs request socket with the request and destination address
+ */
+static void
+transmit_query (struct GNUNET_DNSSTUB_RequestSocket *rs)
+{
+  struct GNUNET_NETWORK_Handle *dnsout;
+
+  if (AF_INET == rs->addr.ss_family)
+    dnsout = rs->dnsout4;
+  else
+    dnsout = rs->dnsout6;
+  if (NULL == dnsout)
+  {
+    GNUNET_break (0);
+    return;
+  }
+  if (GNUNET_SYSERR ==
+      GNUNET_NETWORK_socket_sendto (dnsout,
+				    rs->request,
+				    rs->request_len,
+				    (const struct sockaddr *) &rs->addr,
+				    rs->addrlen))
+    GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
+		_("Failed to send DNS request to %s\n"),
+		GNUNET_a2s ((const struct sockaddr *) &rs->addr,
+			    rs->addrlen));
+  else
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+		_("Sent DNS request to %s\n"),
+		GNUNET_a2s ((const struct sockaddr *) &rs->addr,
+			    rs->addrlen));
+}
+
+
 /**
  * Perform DNS resolution.
  *
@@ -268,36 +348,18 @@ GNUNET_DNSSTUB_resolve (struct GNUNET_DNSSTUB_Context *ctx,
 			void *rc_cls)
 {
   struct GNUNET_DNSSTUB_RequestSocket *rs;
-  struct GNUNET_NETWORK_Handle *ret;
-  int af;
 
-  af = sa->sa_family;
-  if (NULL == (rs = get_request_socket (ctx, af)))
+  if (NULL == (rs = get_request_socket (ctx, sa->sa_family)))
     return NULL;
-  if (NULL != rs->dnsout4)
-    ret = rs->dnsout4;
-  else
-    ret = rs->dnsout6;
-  GNUNET_assert (NULL != ret);
   memcpy (&rs->addr,
 	  sa,
 	  sa_len);
   rs->addrlen = sa_len;
   rs->rc = rc;
   rs->rc_cls = rc_cls;
-  if (GNUNET_SYSERR ==
-      GNUNET_NETWORK_socket_sendto (ret,
-				    request,
-				    request_len,
-				    sa,
-				    sa_len))
-    GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
-		_("Failed to send DNS request to %s\n"),
-		GNUNET_a2s (sa, sa_len));
-  else
-    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-		_("Sent DNS request to %s\n"),
-		GNUNET_a2s (sa, sa_len));
+  rs->request = GNUNET_memdup (request, request_len);
+  rs->request_len = request_len;
+  transmit_query (rs);
   return rs;
 }
 
@@ -324,7 +386,6 @@ GNUNET_DNSSTUB_resolve2 (struct GNUNET_DNSSTUB_Context *ctx,
   struct sockaddr_in6 v6;
   struct sockaddr *sa;
   socklen_t salen;
-  struct GNUNET_NETWORK_Handle *dnsout;
   struct GNUNET_DNSSTUB_RequestSocket *rs;
 
   memset (&v4, 0, sizeof (v4));
@@ -357,12 +418,6 @@ GNUNET_DNSSTUB_resolve2 (struct GNUNET_DNSSTUB_Context *ctx,
     return NULL;
   }
   if (NULL == (rs = get_request_socket (ctx, af)))
-    return NULL;
-  if (NULL != rs->dnsout4)
-    dnsout = rs->dnsout4;
-  else
-    dnsout = rs->dnsout6;
-  if (NULL == dnsout)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
 		_("Configured DNS exit `%s' is not working / valid.\n"),
@@ -375,17 +430,10 @@ GNUNET_DNSSTUB_resolve2 (struct GNUNET_DNSSTUB_Context *ctx,
   rs->addrlen = salen;
   rs->rc = rc;
   rs->rc_cls = rc_cls;
-  if (GNUNET_SYSERR ==
-      GNUNET_NETWORK_socket_sendto (dnsout,
-				    request,
-				    request_len, sa, salen))
-    GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
-		_("Failed to send DNS request to %s\n"),
-		GNUNET_a2s (sa, salen));
-  rs->timeout = GNUNET_TIME_relative_to_absolute (REQUEST_TIMEOUT);
-
+  rs->request = GNUNET_memdup (request, request_len);
+  rs->request_len = request_len;
+  transmit_query (rs);
   return rs;
-
 }
 
 
@@ -395,7 +443,8 @@ GNUNET_DNSSTUB_resolve2 (struct GNUNET_DNSSTUB_Context *ctx,
  *
  * @param rs request socket with callback details
  * @param dnsout socket to read from
- * @return #GNUNET_OK on success, #GNUNET_NO on drop, #GNUNET_SYSERR on IO-errors (closed socket)
+ * @return #GNUNET_OK if a datagram was consumed, #GNUNET_NO if nothing
+ *         (more) is ready to be read, #GNUNET_SYSERR on IO-errors (closed socket)
  */
 static int
 do_dns_read (struct GNUNET_DNSSTUB_RequestSocket *rs,
@@ -408,7 +457,8 @@ do_dns_read (struct GNUNET_DNSSTUB_RequestSocket *rs,
   int len;
 
 #ifndef MINGW
-  if (0 != ioctl (GNUNET_NETWORK_get_fd (dnsout), FIONREAD, &len))
+  if ( (0 != ioctl (GNUNET_NETWORK_get_fd (dnsout), FIONREAD, &len)) ||
+       (0 == len) )
   {
     /* conservative choice: */
     len = UINT16_MAX;
@@ -430,6 +480,8 @@ do_dns_read (struct GNUNET_DNSSTUB_RequestSocket *rs,
 					(struct sockaddr*) &addr, &addrlen);
     if (-1 == r)
     {
+      if ( (EAGAIN == errno) || (EWOULDBLOCK == errno) )
+	return GNUNET_NO; /* socket drained */
       GNUNET_log_strerror (GNUNET_ERROR_TYPE_ERROR, "recvfrom");
       GNUNET_NETWORK_socket_close (dnsout);
       return GNUNET_SYSERR;
@@ -439,7 +491,7 @@ do_dns_read (struct GNUNET_DNSSTUB_RequestSocket *rs,
       GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
 		  _("Received DNS response that is too small (%u bytes)"),
 		  r);
-      return GNUNET_NO;
+      return GNUNET_OK;
     }
     dns = (struct GNUNET_TUN_DnsHeader *) buf;
     if ( (addrlen != rs->addrlen) ||
@@ -450,7 +502,7 @@ do_dns_read (struct GNUNET_DNSSTUB_RequestSocket *rs,
     {
       GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
 		  "Request timeout or invalid sender address; ignoring reply\n");
-      return GNUNET_NO;
+      return GNUNET_OK;
     }
     if (NULL != rs->rc)
       rs->rc (rs->rc_cls,
@@ -474,24 +526,52 @@ read_response (void *cls,
 {
   struct GNUNET_DNSSTUB_RequestSocket *rs = cls;
   struct GNUNET_NETWORK_FDSet *rset;
+  int ret;
 
   rs->read_task = NULL;
-  if (0 == (tc->reason & GNUNET_SCHEDULER_REASON_READ_READY))
+  if (0 != (tc->reason & GNUNET_SCHEDULER_REASON_SHUTDOWN))
   {
-    /* timeout or shutdown */
     cleanup_rs (rs);
     return;
   }
-  /* read and process ready sockets */
-  if ((NULL != rs->dnsout4) &&
-      (GNUNET_NETWORK_fdset_isset (tc->read_ready, rs->dnsout4)) &&
-      (GNUNET_SYSERR == do_dns_read (rs, rs->dnsout4)))
-    rs->dnsout4 = NULL;
-  if ((NULL != rs->dnsout6) &&
-      (GNUNET_NETWORK_fdset_isset (tc->read_ready, rs->dnsout6)) &&
-      (GNUNET_SYSERR == do_dns_read (rs, rs->dnsout6)))
-    rs->dnsout6 = NULL;
-
+  if (0 == (tc->reason & GNUNET_SCHEDULER_REASON_READ_READY))
+  {
+    if ( (NULL == rs->rc) ||
+	 (0 == GNUNET_TIME_absolute_get_remaining (rs->timeout).rel_value_us) )
+    {
+      /* request completed or expired; keep the sockets for the next
+	 request that lands in this slot */
+      release_rs (rs);
+      return;
+    }
+    /* no reply yet, retransmit the request and back off */
+    transmit_query (rs);
+    rs->retry_freq = GNUNET_TIME_STD_BACKOFF (rs->retry_freq);
+  }
+  else
+  {
+    /* drain all replies that arrived in this wakeup from the ready sockets */
+    if ((NULL != rs->dnsout4) &&
+	(GNUNET_NETWORK_fdset_isset (tc->read_ready, rs->dnsout4)))
+    {
+      while (GNUNET_OK == (ret = do_dns_read (rs, rs->dnsout4))) ;
+      if (GNUNET_SYSERR == ret)
+	rs->dnsout4 = NULL;
+    }
+    if ((NULL != rs->dnsout6) &&
+	(GNUNET_NETWORK_fdset_isset (tc->read_ready, rs->dnsout6)))
+    {
+      while (GNUNET_OK == (ret = do_dns_read (rs, rs->dnsout6))) ;
+      if (GNUNET_SYSERR == ret)
+	rs->dnsout6 = NULL;
+    }
+  }
+  if ( (NULL == rs->dnsout4) &&
+       (NULL == rs->dnsout6) )
+  {
+    release_rs (rs);
+    return;
+  }
   /* re-schedule read task */
   rset = GNUNET_NETWORK_fdset_create ();
   if (NULL != rs->dnsout4)
@@ -499,7 +579,8 @@ read_response (void *cls,
   if (NULL != rs->dnsout6)
     GNUNET_NETWORK_fdset_set (rset, rs->dnsout6);
   rs->read_task = GNUNET_SCHEDULER_add_select (GNUNET_SCHEDULER_PRIORITY_DEFAULT,
-					       GNUNET_TIME_absolute_get_remaining (rs->timeout),
+					       GNUNET_TIME_relative_min (rs->retry_freq,
+									 GNUNET_TIME_absolute_get_remaining (rs->timeout)),
 					       rset,
 					       NULL,
 					       &read_response, rs);
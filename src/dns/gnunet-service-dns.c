@@ -143,6 +143,17 @@ struct ClientRecord
 struct RequestRecord
 {
 
+  /**
+   * Active requests are kept in a DLL, so that we do not have to
+   * walk the entire table when only a few requests are in flight.
+   */
+  struct RequestRecord *next;
+
+  /**
+   * Active requests are kept in a DLL.
+   */
+  struct RequestRecord *prev;
+
   /**
    * List of clients that still need to see this request (each entry
    * is set to NULL when the client is done).
@@ -193,6 +204,12 @@ struct RequestRecord
    */
   enum RequestPhase phase;
 
+  /**
+   * #GNUNET_YES if this record is currently in the DLL of
+   * active requests.
+   */
+  int in_use;
+
 };
 
 
@@ -241,6 +258,16 @@ static struct GNUNET_SERVER_NotificationContext *nc;
  */
 static struct RequestRecord requests[UINT16_MAX + 1];
 
+/**
+ * Head of DLL of active requests.
+ */
+static struct RequestRecord *active_head;
+
+/**
+ * Tail of DLL of active requests.
+ */
+static struct RequestRecord *active_tail;
+
 /**
  * Generator for unique request IDs.
  */
@@ -260,6 +287,13 @@ static struct GNUNET_DNSSTUB_Context *dnsstub;
 static void
 cleanup_rr (struct RequestRecord *rr)
 {
+  if (GNUNET_YES == rr->in_use)
+  {
+    GNUNET_CONTAINER_DLL_remove (active_head,
+				 active_tail,
+				 rr);
+    rr->in_use = GNUNET_NO;
+  }
   GNUNET_free_non_null (rr->payload);
   rr->payload = NULL;
   rr->payload_length = 0;
@@ -288,8 +322,8 @@ cleanup_task (void *cls GNUNET_UNUSED,
   }
   for (i=0;i<7;i++)
     GNUNET_free_non_null (helper_argv[i]);
-  for (i=0;i<=UINT16_MAX;i++)
-    cleanup_rr (&requests[i]);
+  while (NULL != active_head)
+    cleanup_rr (active_head);
   GNUNET_SERVER_notification_context_destroy (nc);
   nc = NULL;
   if (stats != NULL)
@@ -656,7 +690,7 @@ client_disconnect (void *cls, struct GNUNET_SERVER_Client *client)
 {
   struct ClientRecord *cr;
   struct RequestRecord *rr;
-  unsigned int i;
+  struct RequestRecord *nxt;
   unsigned int j;
 
   for (cr = clients_head; NULL != cr; cr = cr->next)
@@ -667,11 +701,13 @@ client_disconnect (void *cls, struct GNUNET_SERVER_Client *client)
       GNUNET_CONTAINER_DLL_remove (clients_head,
 				   clients_tail,
 				   cr);
-      for (i=0;i<UINT16_MAX;i++)
+      nxt = active_head;
+      while (NULL != (rr = nxt))
       {
-	rr = &requests[i];
+	/* 'next_phase' may finish 'rr' and remove it from the DLL */
+	nxt = rr->next;
 	if (0 == rr->client_wait_list_length)
-	  continue; /* not in use */
+	  continue; /* not waiting for clients */
 	for (j=0;j<rr->client_wait_list_length;j++)
 	{
 	  if (rr->client_wait_list[j] == cr)
@@ -958,6 +994,13 @@ process_helper_messages (void *cls GNUNET_UNUSED, void *client,
 		     0);
 
   /* setup new request */
+  if (GNUNET_YES != rr->in_use)
+  {
+    rr->in_use = GNUNET_YES;
+    GNUNET_CONTAINER_DLL_insert (active_head,
+				 active_tail,
+				 rr);
+  }
   rr->phase = RP_INIT;
   switch (ntohs (tun->proto))
   {
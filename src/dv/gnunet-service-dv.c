@@ -259,6 +259,18 @@ struct DirectNeighbor
    */
   struct Route *direct_route;
 
+  /**
+   * Head of the DLL of routes in #all_routes that use this neighbor
+   * as their next hop (index of routes by next hop; does not
+   * include the @e direct_route).
+   */
+  struct Route *route_head;
+
+  /**
+   * Tail of the DLL of routes that use this neighbor as next hop.
+   */
+  struct Route *route_tail;
+
   /**
    * Flag set within 'check_target_removed' to trigger full global route refresh.
    */
@@ -290,6 +302,17 @@ struct DirectNeighbor
 struct Route
 {
 
+  /**
+   * Kept in a DLL of all routes with the same @e next_hop, so that
+   * a neighbor disconnect only needs to visit the affected routes.
+   */
+  struct Route *next;
+
+  /**
+   * Kept in a DLL of all routes with the same @e next_hop.
+   */
+  struct Route *prev;
+
   /**
    * Which peer do we need to forward the message to?
    */
@@ -796,6 +819,35 @@ move_route (struct Route *route,
 }
 
 
+/**
+ * Add the route to the index of routes by next hop.
+ * The route's `next_hop` must be set.
+ *
+ * @param route route to link
+ */
+static void
+link_route (struct Route *route)
+{
+  GNUNET_CONTAINER_DLL_insert (route->next_hop->route_head,
+			       route->next_hop->route_tail,
+			       route);
+}
+
+
+/**
+ * Remove the route from the index of routes by next hop.
+ *
+ * @param route route to unlink
+ */
+static void
+unlink_route (struct Route *route)
+{
+  GNUNET_CONTAINER_DLL_remove (route->next_hop->route_head,
+			       route->next_hop->route_tail,
+			       route);
+}
+
+
 /**
  * Initialize this neighbors 'my_set' and when done give
  * it to the pending set operation for execution.
@@ -903,6 +955,7 @@ handle_direct_connect (struct DirectNeighbor *neighbor)
                                                          &neighbor->peer,
                                                          route));
     send_disconnect_to_plugin (&neighbor->peer);
+    unlink_route (route);
     release_route (route);
     GNUNET_free (route);
   }
@@ -1043,6 +1096,7 @@ add_new_route (struct Target *target,
   route = GNUNET_new (struct Route);
   route->next_hop = neighbor;
   route->target.peer = target->peer;
+  link_route (route);
   allocate_route (route, ntohl (target->distance) + 1);
   GNUNET_assert (GNUNET_YES ==
 		 GNUNET_CONTAINER_multipeermap_put (all_routes,
@@ -1087,7 +1141,9 @@ check_possible_route (void *cls,
     {
       /* via 'target' is cheaper than the existing route; switch to alternative route! */
       move_route (route, ntohl (target->distance) + 1);
+      unlink_route (route);
       route->next_hop = neighbor;
+      link_route (route);
       send_distance_change_to_plugin (&target->peer,
                                       ntohl (target->distance) + 1,
                                       neighbor->network);
@@ -1158,35 +1214,6 @@ schedule_refresh_routes ()
 }
 
 
-/**
- * Multipeermap iterator for freeing routes that go via a particular
- * neighbor that disconnected and is thus no longer available.
- *
- * @param cls the direct neighbor that is now unavailable
- * @param key key value stored under
- * @param value a `struct Route` that may or may not go via neighbor
- *
- * @return #GNUNET_YES to continue iteration, #GNUNET_NO to stop
- */
-static int
-cull_routes (void *cls,
-	     const struct GNUNET_PeerIdentity *key,
-	     void *value)
-{
-  struct DirectNeighbor *neighbor = cls;
-  struct Route *route = value;
-
-  if (route->next_hop != neighbor)
-    return GNUNET_YES; /* not affected */
-  GNUNET_assert (GNUNET_YES ==
-		 GNUNET_CONTAINER_multipeermap_remove (all_routes, key, value));
-  release_route (route);
-  send_disconnect_to_plugin (&route->target.peer);
-  GNUNET_free (route);
-  return GNUNET_YES;
-}
-
-
 /**
  * Handle the case that a direct connection to a peer is
  * disrupted.  Remove all routes via that peer and
@@ -1198,12 +1225,24 @@ cull_routes (void *cls,
 static void
 handle_direct_disconnect (struct DirectNeighbor *neighbor)
 {
+  struct Route *route;
+
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Culling routes via %s due to direct disconnect\n",
 	      GNUNET_i2s (&neighbor->peer));
-  GNUNET_CONTAINER_multipeermap_iterate (all_routes,
-					 &cull_routes,
-                                         neighbor);
+  /* only routes with this neighbor as next hop are affected, and
+     the index by next hop has exactly those */
+  while (NULL != (route = neighbor->route_head))
+  {
+    unlink_route (route);
+    GNUNET_assert (GNUNET_YES ==
+		   GNUNET_CONTAINER_multipeermap_remove (all_routes,
+							 &route->target.peer,
+							 route));
+    release_route (route);
+    send_disconnect_to_plugin (&route->target.peer);
+    GNUNET_free (route);
+  }
   if (NULL != neighbor->cth)
   {
     GNUNET_CORE_notify_transmit_ready_cancel (neighbor->cth);
@@ -1394,6 +1433,7 @@ check_target_removed (void *cls,
   GNUNET_assert (GNUNET_YES ==
                  GNUNET_CONTAINER_multipeermap_remove (all_routes, key, current_route));
   send_disconnect_to_plugin (&current_route->target.peer);
+  unlink_route (current_route);
   release_route (current_route);
   GNUNET_free (current_route);
   neighbor->target_removed = GNUNET_YES;
@@ -1438,6 +1478,7 @@ check_target_added (void *cls,
                                                                key,
                                                                current_route));
           send_disconnect_to_plugin (key);
+          unlink_route (current_route);
           release_route (current_route);
           GNUNET_free (current_route);
         }
@@ -1465,7 +1506,9 @@ check_target_added (void *cls,
        direct neighbor can use this to DoS our long routes */
 
     move_route (current_route, ntohl (target->distance) + 1);
+    unlink_route (current_route);
     current_route->next_hop = neighbor;
+    link_route (current_route);
     send_distance_change_to_plugin (&target->peer,
                                     ntohl (target->distance) + 1,
                                     neighbor->network);
@@ -1479,6 +1522,7 @@ check_target_added (void *cls,
   current_route = GNUNET_new (struct Route);
   current_route->next_hop = neighbor;
   current_route->target.peer = target->peer;
+  link_route (current_route);
   allocate_route (current_route, ntohl (target->distance) + 1);
   GNUNET_assert (GNUNET_YES ==
 		 GNUNET_CONTAINER_multipeermap_put (all_routes,
@@ -2051,6 +2095,7 @@ free_route (void *cls,
   GNUNET_break (0);
   GNUNET_assert (GNUNET_YES ==
 		 GNUNET_CONTAINER_multipeermap_remove (all_routes, key, value));
+  unlink_route (route);
   release_route (route);
   send_disconnect_to_plugin (&route->target.peer);
   GNUNET_free (route);
@@ -29,6 +29,15 @@
 #include "gnunet_util_lib.h"
 #include "gnunet_env_lib.h"
 
+/**
+ * Number of modifiers stored inline in the environment.
+ *
+ * Environments are typically built up and torn down for every transmitted
+ * message, so the first few modifiers are served from this inline pool
+ * instead of allocating each modifier separately.
+ */
+#define ENV_INLINE_MODIFIERS 8
+
 /**
  * Environment for a message.
  *
@@ -39,9 +48,38 @@ struct GNUNET_ENV_Environment
   struct GNUNET_ENV_Modifier *mod_head;
   struct GNUNET_ENV_Modifier *mod_tail;
   size_t mod_count;
+
+  /**
+   * Inline storage used for the first #ENV_INLINE_MODIFIERS modifiers.
+   */
+  struct GNUNET_ENV_Modifier mod_inline[ENV_INLINE_MODIFIERS];
+
+  /**
+   * Number of entries of @e mod_inline handed out so far.
+   */
+  size_t mod_inline_used;
 };
 
 
+/**
+ * Check if a modifier is part of the inline pool of the environment.
+ *
+ * @param env The environment.
+ * @param mod The modifier to check.
+ *
+ * @return #GNUNET_YES if @a mod is stored inline, #GNUNET_NO otherwise.
+ */
+static int
+env_mod_is_inline (const struct GNUNET_ENV_Environment *env,
+                   const struct GNUNET_ENV_Modifier *mod)
+{
+  return (mod >= env->mod_inline
+          && mod < env->mod_inline + ENV_INLINE_MODIFIERS)
+    ? GNUNET_YES
+    : GNUNET_NO;
+}
+
+
 /**
  * Create an environment.
  *
@@ -68,7 +106,11 @@ GNUNET_ENV_environment_add (struct GNUNET_ENV_Environment *env,
                             enum GNUNET_ENV_Operator oper, const char *name,
                             const void *value, size_t value_size)
 {
-  struct GNUNET_ENV_Modifier *mod = GNUNET_new (struct GNUNET_ENV_Modifier);
+  struct GNUNET_ENV_Modifier *mod;
+  if (env->mod_inline_used < ENV_INLINE_MODIFIERS)
+    mod = &env->mod_inline[env->mod_inline_used++];
+  else
+    mod = GNUNET_new (struct GNUNET_ENV_Modifier);
   mod->oper = oper;
   mod->name = name;
   mod->value = value;
@@ -135,7 +177,8 @@ GNUNET_ENV_environment_shift (struct GNUNET_ENV_Environment *env,
   *value_size = mod->value_size;
 
   GNUNET_CONTAINER_DLL_remove (env->mod_head, env->mod_tail, mod);
-  GNUNET_free (mod);
+  if (GNUNET_NO == env_mod_is_inline (env, mod))
+    GNUNET_free (mod);
   env->mod_count--;
 
   return GNUNET_YES;
@@ -184,11 +227,11 @@ GNUNET_ENV_environment_destroy (struct GNUNET_ENV_Environment *env)
   struct GNUNET_ENV_Modifier *mod, *prev = NULL;
   for (mod = env->mod_head; NULL != mod; mod = mod->next)
   {
-    if (NULL != prev)
+    if (NULL != prev && GNUNET_NO == env_mod_is_inline (env, prev))
       GNUNET_free (prev);
     prev = mod;
   }
-  if (NULL != prev)
+  if (NULL != prev && GNUNET_NO == env_mod_is_inline (env, prev))
     GNUNET_free (prev);
 
   GNUNET_free (env);
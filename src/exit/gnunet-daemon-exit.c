@@ -275,6 +275,14 @@ struct ChannelState
        * Primary redirection information for this connection.
        */
       struct RedirectInformation ri;
+
+      /**
+       * Cached partial checksum over the addresses of this flow;
+       * used to seed the per-packet checksum calculations so that
+       * we do not re-sum the constant pseudo header fields for
+       * every packet.
+       */
+      uint32_t flow_sum;
     } tcp_udp;
 
     struct
@@ -390,14 +398,12 @@ static struct GNUNET_CONTAINER_Heap *connections_heap;
 static unsigned long long max_connections;
 
 /**
- * This hashmaps saves interesting things about the configured UDP services
+ * This hashmap saves interesting things about the configured services;
+ * it is built once at configuration load and queried under a key
+ * derived from (protocol, descriptor, destination port), so TCP and
+ * UDP services share one table.
  */
-static struct GNUNET_CONTAINER_MultiHashMap *udp_services;
-
-/**
- * This hashmaps saves interesting things about the configured TCP services
- */
-static struct GNUNET_CONTAINER_MultiHashMap *tcp_services;
+static struct GNUNET_CONTAINER_MultiHashMap *services;
 
 /**
  * Array of all open DNS requests from channels.
@@ -730,26 +736,46 @@ get_redirect_state (int af,
 }
 
 
+/**
+ * Compute the key under which a service is stored in the service map.
+ * The protocol and destination port are folded into the descriptor so
+ * that one well-formed hash covers the full lookup tuple.
+ *
+ * @param proto IPPROTO_TCP or IPPROTO_UDP
+ * @param desc service descriptor
+ * @param destination_port destination port
+ * @param key set to the key to use for the service map
+ */
+static void
+hash_redirect (int proto,
+	       const struct GNUNET_HashCode *desc,
+	       uint16_t destination_port,
+	       struct GNUNET_HashCode *key)
+{
+  *key = *desc;
+  key->bits[0] ^= htonl (((uint32_t) proto << 16) | destination_port);
+}
+
+
 /**
  * Given a service descriptor and a destination port, find the
  * respective service entry.
  *
- * @param service_map map of services (TCP or UDP)
+ * @param proto IPPROTO_TCP or IPPROTO_UDP
  * @param desc service descriptor
  * @param destination_port destination port
  * @return NULL if we are not aware of such a service
  */
 static struct LocalService *
-find_service (struct GNUNET_CONTAINER_MultiHashMap *service_map,
+find_service (int proto,
 	      const struct GNUNET_HashCode *desc,
 	      uint16_t destination_port)
 {
-  char key[sizeof (struct GNUNET_HashCode) + sizeof (uint16_t)];
+  struct GNUNET_HashCode key;
 
-  memcpy (&key[0], &destination_port, sizeof (uint16_t));
-  memcpy (&key[sizeof(uint16_t)], desc, sizeof (struct GNUNET_HashCode));
-  return GNUNET_CONTAINER_multihashmap_get (service_map,
-					    (struct GNUNET_HashCode *) key);
+  hash_redirect (proto, desc, destination_port, &key);
+  return GNUNET_CONTAINER_multihashmap_get (services,
+					    &key);
 }
 
 
@@ -775,34 +801,33 @@ free_service_record (void *cls,
 
 
 /**
- * Given a service descriptor and a destination port, find the
- * respective service entry.
+ * Given a service name and a destination port, store the
+ * service entry in the service map.
  *
- * @param service_map map of services (TCP or UDP)
+ * @param proto IPPROTO_TCP or IPPROTO_UDP
  * @param name name of the service
  * @param destination_port destination port
  * @param service service information record to store (service->name will be set).
  */
 static void
-store_service (struct GNUNET_CONTAINER_MultiHashMap *service_map,
+store_service (int proto,
 	       const char *name,
 	       uint16_t destination_port,
 	       struct LocalService *service)
 {
-  char key[sizeof (struct GNUNET_HashCode) + sizeof (uint16_t)];
+  struct GNUNET_HashCode key;
   struct GNUNET_HashCode desc;
 
   GNUNET_TUN_service_name_to_hash (name, &desc);
   service->name = GNUNET_strdup (name);
-  memcpy (&key[0], &destination_port, sizeof (uint16_t));
-  memcpy (&key[sizeof(uint16_t)], &desc, sizeof (struct GNUNET_HashCode));
+  hash_redirect (proto, &desc, destination_port, &key);
   if (GNUNET_OK !=
-      GNUNET_CONTAINER_multihashmap_put (service_map,
-					 (struct GNUNET_HashCode *) key,
+      GNUNET_CONTAINER_multihashmap_put (services,
+					 &key,
 					 service,
 					 GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY))
   {
-    free_service_record (NULL, (struct GNUNET_HashCode *) key, service);
+    free_service_record (NULL, &key, service);
     GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
 		_("Got duplicate service records for `%s:%u'\n"),
 		name,
@@ -1542,6 +1567,14 @@ setup_state_record (struct ChannelState *state)
 			   buf, sizeof (buf)),
 		(unsigned int) state->specifics.tcp_udp.ri.local_address.port);
   }
+  if (AF_INET == state->specifics.tcp_udp.ri.remote_address.af)
+    state->specifics.tcp_udp.flow_sum
+      = GNUNET_TUN_flow_checksum_seed4 (&state->specifics.tcp_udp.ri.local_address.address.ipv4,
+					&state->specifics.tcp_udp.ri.remote_address.address.ipv4);
+  else
+    state->specifics.tcp_udp.flow_sum
+      = GNUNET_TUN_flow_checksum_seed6 (&state->specifics.tcp_udp.ri.local_address.address.ipv6,
+					&state->specifics.tcp_udp.ri.remote_address.address.ipv6);
   state->specifics.tcp_udp.state_key = key;
   GNUNET_assert (GNUNET_OK ==
 		 GNUNET_CONTAINER_multihashmap_put (connections_map,
@@ -1579,6 +1612,7 @@ setup_state_record (struct ChannelState *state)
  * @param tcp_header skeleton of the TCP header, NULL for UDP
  * @param src_address source address to use (IP and port)
  * @param dst_address destination address to use (IP and port)
+ * @param flow_sum cached partial checksum over the flow's addresses
  * @param pkt4 where to write the assembled packet; must
  *        contain enough space for the IP header, UDP/TCP header
  *        AND the payload
@@ -1589,6 +1623,7 @@ prepare_ipv4_packet (const void *payload, size_t payload_length,
 		     const struct GNUNET_TUN_TcpHeader *tcp_header,
 		     const struct SocketAddress *src_address,
 		     const struct SocketAddress *dst_address,
+		     uint32_t flow_sum,
 		     struct GNUNET_TUN_IPv4Header *pkt4)
 {
   size_t len;
@@ -1627,9 +1662,10 @@ prepare_ipv4_packet (const void *payload, size_t payload_length,
       pkt4_udp->source_port = htons (src_address->port);
       pkt4_udp->destination_port = htons (dst_address->port);
       pkt4_udp->len = htons ((uint16_t) payload_length);
-      GNUNET_TUN_calculate_udp4_checksum (pkt4,
-					  pkt4_udp,
-					  payload, payload_length);
+      GNUNET_TUN_calculate_udp4_checksum_seeded (pkt4,
+						 pkt4_udp,
+						 payload, payload_length,
+						 flow_sum);
       memcpy (&pkt4_udp[1], payload, payload_length);
     }
     break;
@@ -1640,10 +1676,11 @@ prepare_ipv4_packet (const void *payload, size_t payload_length,
       *pkt4_tcp = *tcp_header;
       pkt4_tcp->source_port = htons (src_address->port);
       pkt4_tcp->destination_port = htons (dst_address->port);
-      GNUNET_TUN_calculate_tcp4_checksum (pkt4,
-					  pkt4_tcp,
-					  payload,
-					  payload_length);
+      GNUNET_TUN_calculate_tcp4_checksum_seeded (pkt4,
+						 pkt4_tcp,
+						 payload,
+						 payload_length,
+						 flow_sum);
       memcpy (&pkt4_tcp[1], payload, payload_length);
     }
     break;
@@ -1667,6 +1704,7 @@ prepare_ipv4_packet (const void *payload, size_t payload_length,
  * @param tcp_header skeleton TCP header data to send, NULL for UDP
  * @param src_address source address to use (IP and port)
  * @param dst_address destination address to use (IP and port)
+ * @param flow_sum cached partial checksum over the flow's addresses
  * @param pkt6 where to write the assembled packet; must
  *        contain enough space for the IP header, UDP/TCP header
  *        AND the payload
@@ -1677,6 +1715,7 @@ prepare_ipv6_packet (const void *payload, size_t payload_length,
 		     const struct GNUNET_TUN_TcpHeader *tcp_header,
 		     const struct SocketAddress *src_address,
 		     const struct SocketAddress *dst_address,
+		     uint32_t flow_sum,
 		     struct GNUNET_TUN_IPv6Header *pkt6)
 {
   size_t len;
@@ -1715,10 +1754,11 @@ prepare_ipv6_packet (const void *payload, size_t payload_length,
       pkt6_udp->source_port = htons (src_address->port);
       pkt6_udp->destination_port = htons (dst_address->port);
       pkt6_udp->len = htons ((uint16_t) payload_length);
-      GNUNET_TUN_calculate_udp6_checksum (pkt6,
-					  pkt6_udp,
-					  payload,
-					  payload_length);
+      GNUNET_TUN_calculate_udp6_checksum_seeded (pkt6,
+						 pkt6_udp,
+						 payload,
+						 payload_length,
+						 flow_sum);
       memcpy (&pkt6_udp[1], payload, payload_length);
     }
     break;
@@ -1730,10 +1770,11 @@ prepare_ipv6_packet (const void *payload, size_t payload_length,
       *pkt6_tcp = *tcp_header;
       pkt6_tcp->source_port = htons (src_address->port);
       pkt6_tcp->destination_port = htons (dst_address->port);
-      GNUNET_TUN_calculate_tcp6_checksum (pkt6,
-					  pkt6_tcp,
-					  payload,
-					  payload_length);
+      GNUNET_TUN_calculate_tcp6_checksum_seeded (pkt6,
+						 pkt6_tcp,
+						 payload,
+						 payload_length,
+						 flow_sum);
       memcpy (&pkt6_tcp[1], payload, payload_length);
     }
     break;
@@ -1749,6 +1790,7 @@ prepare_ipv6_packet (const void *payload, size_t payload_length,
  *
  * @param destination_address IP and port to use for the TCP packet's destination
  * @param source_address IP and port to use for the TCP packet's source
+ * @param flow_sum cached partial checksum over the flow's addresses
  * @param tcp_header header template to use
  * @param payload payload of the TCP packet
  * @param payload_length number of bytes in @a payload
@@ -1756,6 +1798,7 @@ prepare_ipv6_packet (const void *payload, size_t payload_length,
 static void
 send_tcp_packet_via_tun (const struct SocketAddress *destination_address,
 			 const struct SocketAddress *source_address,
+			 uint32_t flow_sum,
 			 const struct GNUNET_TUN_TcpHeader *tcp_header,
 			 const void *payload, size_t payload_length)
 {
@@ -1809,6 +1852,7 @@ send_tcp_packet_via_tun (const struct SocketAddress *destination_address,
 			     tcp_header,
 			     source_address,
 			     destination_address,
+			     flow_sum,
 			     ipv4);
       }
       break;
@@ -1822,6 +1866,7 @@ send_tcp_packet_via_tun (const struct SocketAddress *destination_address,
 			     tcp_header,
 			     source_address,
 			     destination_address,
+			     flow_sum,
 			     ipv6);
       }
       break;
@@ -1907,7 +1952,7 @@ receive_tcp_service (void *cls,
 	      GNUNET_h2s (&start->service_descriptor),
 	      (unsigned int) ntohs (start->tcp_header.destination_port));
   if (NULL == (state->specifics.tcp_udp.serv =
-               find_service (tcp_services,
+               find_service (IPPROTO_TCP,
                              &start->service_descriptor,
                              ntohs (start->tcp_header.destination_port))))
   {
@@ -1925,6 +1970,7 @@ receive_tcp_service (void *cls,
   setup_state_record (state);
   send_tcp_packet_via_tun (&state->specifics.tcp_udp.ri.remote_address,
 			   &state->specifics.tcp_udp.ri.local_address,
+			   state->specifics.tcp_udp.flow_sum,
 			   &start->tcp_header,
 			   &start[1], pkt_len);
   GNUNET_CADET_receive_done (channel);
@@ -2050,6 +2096,7 @@ receive_tcp_remote (void *cls GNUNET_UNUSED,
   setup_state_record (state);
   send_tcp_packet_via_tun (&state->specifics.tcp_udp.ri.remote_address,
 			   &state->specifics.tcp_udp.ri.local_address,
+			   state->specifics.tcp_udp.flow_sum,
 			   &start->tcp_header,
 			   payload, pkt_len);
   GNUNET_CADET_receive_done (channel);
@@ -2132,6 +2179,7 @@ receive_tcp_data (void *cls GNUNET_UNUSED,
 
   send_tcp_packet_via_tun (&state->specifics.tcp_udp.ri.remote_address,
 			   &state->specifics.tcp_udp.ri.local_address,
+			   state->specifics.tcp_udp.flow_sum,
 			   &data->tcp_header,
 			   &data[1], pkt_len);
   GNUNET_CADET_receive_done (channel);
@@ -2747,12 +2795,14 @@ receive_icmp_service (void *cls,
  *
  * @param destination_address IP and port to use for the UDP packet's destination
  * @param source_address IP and port to use for the UDP packet's source
+ * @param flow_sum cached partial checksum over the flow's addresses
  * @param payload payload of the UDP packet (does NOT include UDP header)
  * @param payload_length number of bytes of data in @a payload
  */
 static void
 send_udp_packet_via_tun (const struct SocketAddress *destination_address,
 			 const struct SocketAddress *source_address,
+			 uint32_t flow_sum,
 			 const void *payload, size_t payload_length)
 {
   size_t len;
@@ -2805,6 +2855,7 @@ send_udp_packet_via_tun (const struct SocketAddress *destination_address,
 			     NULL,
 			     source_address,
 			     destination_address,
+			     flow_sum,
 			     ipv4);
       }
       break;
@@ -2818,6 +2869,7 @@ send_udp_packet_via_tun (const struct SocketAddress *destination_address,
 			     NULL,
 			     source_address,
 			     destination_address,
+			     flow_sum,
 			     ipv6);
       }
       break;
@@ -2939,6 +2991,7 @@ receive_udp_remote (void *cls,
     state->specifics.tcp_udp.ri.local_address.port = msg->source_port;
   send_udp_packet_via_tun (&state->specifics.tcp_udp.ri.remote_address,
 			   &state->specifics.tcp_udp.ri.local_address,
+			   state->specifics.tcp_udp.flow_sum,
 			   payload, pkt_len);
   GNUNET_CADET_receive_done (channel);
   return GNUNET_YES;
@@ -2996,7 +3049,7 @@ receive_udp_service (void *cls,
        GNUNET_h2s (&msg->service_descriptor),
        (unsigned int) ntohs (msg->destination_port));
   if (NULL == (state->specifics.tcp_udp.serv =
-               find_service (udp_services,
+               find_service (IPPROTO_UDP,
                              &msg->service_descriptor,
                              ntohs (msg->destination_port))))
   {
@@ -3016,6 +3069,7 @@ receive_udp_service (void *cls,
     state->specifics.tcp_udp.ri.local_address.port = msg->source_port;
   send_udp_packet_via_tun (&state->specifics.tcp_udp.ri.remote_address,
 			   &state->specifics.tcp_udp.ri.local_address,
+			   state->specifics.tcp_udp.flow_sum,
 			   &msg[1], pkt_len);
   GNUNET_CADET_receive_done (channel);
   return GNUNET_YES;
@@ -3192,17 +3246,11 @@ cleanup (void *cls,
     GNUNET_CONTAINER_heap_destroy (connections_heap);
     connections_heap = NULL;
   }
-  if (NULL != tcp_services)
-  {
-    GNUNET_CONTAINER_multihashmap_iterate (tcp_services, &free_service_record, NULL);
-    GNUNET_CONTAINER_multihashmap_destroy (tcp_services);
-    tcp_services = NULL;
-  }
-  if (NULL != udp_services)
+  if (NULL != services)
   {
-    GNUNET_CONTAINER_multihashmap_iterate (udp_services, &free_service_record, NULL);
-    GNUNET_CONTAINER_multihashmap_destroy (udp_services);
-    udp_services = NULL;
+    GNUNET_CONTAINER_multihashmap_iterate (services, &free_service_record, NULL);
+    GNUNET_CONTAINER_multihashmap_destroy (services);
+    services = NULL;
   }
   if (NULL != dnsstub)
   {
@@ -3378,7 +3426,7 @@ add_services (int proto,
       }
       freeaddrinfo (res);
     }
-    store_service ((IPPROTO_UDP == proto) ? udp_services : tcp_services,
+    store_service (proto,
 		   n,
 		   local_port,
 		   serv);
@@ -3388,7 +3436,7 @@ add_services (int proto,
 
 
 /**
- * Reads the configuration servicecfg and populates udp_services
+ * Reads the configuration and populates the service map
  *
  * @param cls unused
  * @param section name of section in config, equal to hostname
@@ -3751,8 +3799,7 @@ run (void *cls,
   }
   exit_argv[7] = NULL;
 
-  udp_services = GNUNET_CONTAINER_multihashmap_create (65536, GNUNET_NO);
-  tcp_services = GNUNET_CONTAINER_multihashmap_create (65536, GNUNET_NO);
+  services = GNUNET_CONTAINER_multihashmap_create (65536, GNUNET_NO);
   GNUNET_CONFIGURATION_iterate_sections (cfg, &read_service_conf, NULL);
 
   connections_map = GNUNET_CONTAINER_multihashmap_create (65536, GNUNET_NO);
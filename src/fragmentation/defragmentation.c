@@ -153,6 +153,13 @@ struct GNUNET_DEFRAGMENT_Context
    */
   struct MessageContext *tail;
 
+  /**
+   * Map from fragment IDs to the 'struct MessageContext'
+   * entries on the DLL, so arriving fragments can find their
+   * partial message without scanning the list.
+   */
+  struct GNUNET_CONTAINER_MultiHashMap32 *map;
+
   /**
    * Closure for @e proc and @e ackp.
    */
@@ -217,6 +224,7 @@ GNUNET_DEFRAGMENT_context_create (struct GNUNET_STATISTICS_Handle *stats,
   struct GNUNET_DEFRAGMENT_Context *dc;
 
   dc = GNUNET_new (struct GNUNET_DEFRAGMENT_Context);
+  dc->map = GNUNET_CONTAINER_multihashmap32_create (num_msgs + 1);
   dc->stats = stats;
   dc->cls = cls;
   dc->proc = proc;
@@ -241,6 +249,10 @@ GNUNET_DEFRAGMENT_context_destroy (struct GNUNET_DEFRAGMENT_Context *dc)
   while (NULL != (mc = dc->head))
   {
     GNUNET_CONTAINER_DLL_remove (dc->head, dc->tail, mc);
+    GNUNET_assert (GNUNET_YES ==
+                   GNUNET_CONTAINER_multihashmap32_remove (dc->map,
+                                                           mc->fragment_id,
+                                                           mc));
     dc->list_size--;
     if (NULL != mc->ack_task)
     {
@@ -250,6 +262,7 @@ GNUNET_DEFRAGMENT_context_destroy (struct GNUNET_DEFRAGMENT_Context *dc)
     GNUNET_free (mc);
   }
   GNUNET_assert (0 == dc->list_size);
+  GNUNET_CONTAINER_multihashmap32_destroy (dc->map);
   GNUNET_free (dc);
 }
 
@@ -398,6 +411,10 @@ discard_oldest_mc (struct GNUNET_DEFRAGMENT_Context *dc)
   }
   GNUNET_assert (NULL != old);
   GNUNET_CONTAINER_DLL_remove (dc->head, dc->tail, old);
+  GNUNET_assert (GNUNET_YES ==
+                 GNUNET_CONTAINER_multihashmap32_remove (dc->map,
+                                                         old->fragment_id,
+                                                         old));
   dc->list_size--;
   if (NULL != old->ack_task)
   {
@@ -476,9 +493,8 @@ GNUNET_DEFRAGMENT_process_fragment (struct GNUNET_DEFRAGMENT_Context *dc,
     if (mc->fragment_id > fid)
       last++;
 
-  mc = dc->head;
-  while ((NULL != mc) && (fid != mc->fragment_id))
-    mc = mc->next;
+  mc = GNUNET_CONTAINER_multihashmap32_get (dc->map,
+                                            fid);
   bit = foff / (dc->mtu - sizeof (struct FragmentHeader));
   if (bit * (dc->mtu - sizeof (struct FragmentHeader)) + ntohs (msg->size) -
       sizeof (struct FragmentHeader) > msize)
@@ -514,6 +530,11 @@ GNUNET_DEFRAGMENT_process_fragment (struct GNUNET_DEFRAGMENT_Context *dc,
     GNUNET_CONTAINER_DLL_insert (dc->head,
                                  dc->tail,
                                  mc);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multihashmap32_put (dc->map,
+                                                        fid,
+                                                        mc,
+                                                        GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
     dc->list_size++;
   }
 
@@ -33,12 +33,27 @@
  */
 #define MIN_ACK_DELAY GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MILLISECONDS, 1)
 
+/**
+ * Maximum number of fragmentation contexts we keep around for
+ * reuse.  The WLAN and UDP paths fragment nearly every (32k) FS
+ * block, so context allocation and the copy of the message are
+ * hot; since the workload is dominated by equal-sized blocks,
+ * a short free list gets a high hit rate.
+ */
+#define FRAG_POOL_MAX_FREE 16
+
 
 /**
  * Fragmentation context.
  */
 struct GNUNET_FRAGMENT_Context
 {
+  /**
+   * Next context in the pool of free contexts; only used while
+   * this context is on the free list.
+   */
+  struct GNUNET_FRAGMENT_Context *next_free;
+
   /**
    * Statistics to use.
    */
@@ -135,9 +150,27 @@ struct GNUNET_FRAGMENT_Context
    */
   uint16_t mtu;
 
+  /**
+   * Number of message bytes the buffer at the end of this
+   * struct can hold; used when recycling contexts through
+   * the pool.
+   */
+  uint16_t buf_size;
+
 };
 
 
+/**
+ * Head of the pool of free fragmentation contexts.
+ */
+static struct GNUNET_FRAGMENT_Context *pool_head;
+
+/**
+ * Number of contexts in the pool.
+ */
+static unsigned int pool_count;
+
+
 /**
  * Convert an ACK message to a printable format suitable for logging.
  *
@@ -329,7 +362,23 @@ GNUNET_FRAGMENT_context_create (struct GNUNET_STATISTICS_Handle *stats,
                             _("# total size of fragmented messages"),
                             size, GNUNET_NO);
   GNUNET_assert (size >= sizeof (struct GNUNET_MessageHeader));
-  fc = GNUNET_malloc (sizeof (struct GNUNET_FRAGMENT_Context) + size);
+  if ( (NULL != pool_head) &&
+       (pool_head->buf_size >= size) )
+  {
+    uint16_t buf_size;
+
+    fc = pool_head;
+    pool_head = fc->next_free;
+    pool_count--;
+    buf_size = fc->buf_size;
+    memset (fc, 0, sizeof (struct GNUNET_FRAGMENT_Context));
+    fc->buf_size = buf_size;
+  }
+  else
+  {
+    fc = GNUNET_malloc (sizeof (struct GNUNET_FRAGMENT_Context) + size);
+    fc->buf_size = (uint16_t) size;
+  }
   fc->stats = stats;
   fc->mtu = mtu;
   fc->tracker = tracker;
@@ -420,10 +469,10 @@ GNUNET_FRAGMENT_process_ack (struct GNUNET_FRAGMENT_Context *fc,
     snd_cnt = 0;
     for (i=0;i<64;i++)
     {
-      if (1 == (fc->acks_mask & (1 << i)))
+      if (0 != (fc->acks_mask & (1LL << i)))
       {
 	snd_cnt++;
-	if (0 == (abits & (1 << i)))
+	if (0 == (abits & (1LL << i)))
 	  ack_cnt++;
       }
     }
@@ -515,7 +564,16 @@ GNUNET_FRAGMENT_context_destroy (struct GNUNET_FRAGMENT_Context *fc,
   if (NULL != msg_delay)
     *msg_delay = GNUNET_TIME_relative_multiply (fc->msg_delay,
 						fc->num_rounds);
-  GNUNET_free (fc);
+  if (pool_count < FRAG_POOL_MAX_FREE)
+  {
+    fc->next_free = pool_head;
+    pool_head = fc;
+    pool_count++;
+  }
+  else
+  {
+    GNUNET_free (fc);
+  }
 }
 
 
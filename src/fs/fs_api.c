@@ -40,6 +40,18 @@
  */
 #define DEFAULT_MAX_PARALLEL_DOWNLOADS 16
 
+/**
+ * How many datastore PUT requests do we keep in flight per publish
+ * operation by default?
+ */
+#define DEFAULT_PUBLISH_PIPELINE_DEPTH 32
+
+/**
+ * How many availability probes do we run in parallel at most by
+ * default?
+ */
+#define DEFAULT_MAX_PARALLEL_PROBES 32
+
 /**
  * Start the given job (send signal, remove from pending queue, update
  * counters and state).
@@ -2661,6 +2673,8 @@ free_search_context (struct GNUNET_FS_SearchContext *sc)
                                            sc);
     GNUNET_CONTAINER_multihashmap_destroy (sc->master_result_map);
   }
+  if (NULL != sc->processed_blocks)
+    GNUNET_CONTAINER_multihashmap_destroy (sc->processed_blocks);
   GNUNET_free (sc);
 }
 
@@ -2921,6 +2935,7 @@ deserialize_search (struct GNUNET_FS_Handle *h,
   }
   sc->options = (enum GNUNET_FS_SearchOptions) options;
   sc->master_result_map = GNUNET_CONTAINER_multihashmap_create (16, GNUNET_NO);
+  sc->processed_blocks = GNUNET_CONTAINER_multihashmap_create (128, GNUNET_NO);
   dn = get_serialization_file_name_in_dir (h,
                                            (NULL == sc->psearch_result) ?
                                            GNUNET_FS_SYNC_PATH_MASTER_SEARCH :
@@ -3082,6 +3097,7 @@ GNUNET_FS_start (const struct GNUNET_CONFIGURATION_Handle *cfg,
 {
   struct GNUNET_FS_Handle *ret;
   enum GNUNET_FS_OPTIONS opt;
+  unsigned long long depth;
   va_list ap;
 
   ret = GNUNET_new (struct GNUNET_FS_Handle);
@@ -3092,6 +3108,22 @@ GNUNET_FS_start (const struct GNUNET_CONFIGURATION_Handle *cfg,
   ret->flags = flags;
   ret->max_parallel_downloads = DEFAULT_MAX_PARALLEL_DOWNLOADS;
   ret->max_parallel_requests = DEFAULT_MAX_PARALLEL_REQUESTS;
+  ret->publish_pipeline_depth = DEFAULT_PUBLISH_PIPELINE_DEPTH;
+  if (GNUNET_OK ==
+      GNUNET_CONFIGURATION_get_value_number (cfg, "fs",
+                                             "PUBLISH_PIPELINE_DEPTH",
+                                             &depth))
+    ret->publish_pipeline_depth = (unsigned int) depth;
+  if (0 == ret->publish_pipeline_depth)
+    ret->publish_pipeline_depth = 1;
+  ret->max_parallel_probes = DEFAULT_MAX_PARALLEL_PROBES;
+  if (GNUNET_OK ==
+      GNUNET_CONFIGURATION_get_value_number (cfg, "fs",
+                                             "MAX_PARALLEL_PROBES",
+                                             &depth))
+    ret->max_parallel_probes = (unsigned int) depth;
+  if (0 == ret->max_parallel_probes)
+    ret->max_parallel_probes = 1;
   ret->avg_block_latency = GNUNET_TIME_UNIT_MINUTES;    /* conservative starting point */
   va_start (ap, flags);
   while (GNUNET_FS_OPTIONS_END != (opt = va_arg (ap, enum GNUNET_FS_OPTIONS)))
@@ -221,6 +221,14 @@ struct GNUNET_FS_Uri
     struct Location loc;
   } data;
 
+  /**
+   * Reference counter for interned URIs (see
+   * #GNUNET_FS_uri_intern()), 0 for ordinary URIs.  Interned URIs
+   * are shared between all holders of a reference and must not be
+   * modified.
+   */
+  unsigned int rc;
+
 };
 
 
@@ -613,6 +621,12 @@ struct GNUNET_FS_SearchResult
    */
   struct GNUNET_TIME_Relative remaining_probe_time;
 
+  /**
+   * #GNUNET_YES if this result is in the 'pending_probes' DLL of
+   * the FS handle, waiting for a free probe slot.
+   */
+  int probe_pending;
+
   /**
    * Anonymity level to use for probes using this search result.
    */
@@ -1166,6 +1180,17 @@ struct GNUNET_FS_Handle
    */
   struct GNUNET_FS_SearchResult *probes_tail;
 
+  /**
+   * Head of DLL of search results waiting for a free probe slot
+   * (see @e max_parallel_probes).
+   */
+  struct GNUNET_FS_SearchResult *pending_probes_head;
+
+  /**
+   * Tail of DLL of search results waiting for a free probe slot.
+   */
+  struct GNUNET_FS_SearchResult *pending_probes_tail;
+
   /**
    * Task that processes the jobs in the running and pending queues
    * (and moves jobs around as needed).
@@ -1209,9 +1234,33 @@ struct GNUNET_FS_Handle
    */
   unsigned int max_parallel_requests;
 
+  /**
+   * How many datastore PUT requests do we keep in flight at the
+   * same time per publish operation?
+   */
+  unsigned int publish_pipeline_depth;
+
+  /**
+   * How many availability probes are currently running?
+   */
+  unsigned int active_probes;
+
+  /**
+   * Maximum number of availability probes to run in parallel;
+   * additional probes are queued in @e pending_probes_head.
+   */
+  unsigned int max_parallel_probes;
+
 };
 
 
+/**
+ * Information about a datastore PUT operation that is still in
+ * flight for a publish operation (defined in fs_publish.c).
+ */
+struct GNUNET_FS_PublishDataPut;
+
+
 /**
  * Handle for controlling a publication process.
  */
@@ -1284,6 +1333,18 @@ struct GNUNET_FS_PublishContext
    */
   struct GNUNET_DATASTORE_QueueEntry *qre;
 
+  /**
+   * Head of linked list of datastore PUT operations that are
+   * still in flight for the current tree encoding.
+   */
+  struct GNUNET_FS_PublishDataPut *pdp_head;
+
+  /**
+   * Tail of linked list of datastore PUT operations that are
+   * still in flight for the current tree encoding.
+   */
+  struct GNUNET_FS_PublishDataPut *pdp_tail;
+
   /**
    * Context for SKS publishing operation that is part of this publishing operation
    * (NULL if not active).
@@ -1318,6 +1379,12 @@ struct GNUNET_FS_PublishContext
    */
   enum GNUNET_FS_PublishOptions options;
 
+  /**
+   * Number of entries in the @e pdp_head list; bounded by
+   * the pipeline depth of the block upload.
+   */
+  unsigned int active_puts;
+
   /**
    * Space reservation ID with datastore service
    * for this upload.
@@ -1616,6 +1683,14 @@ struct GNUNET_FS_SearchContext
    */
   struct GNUNET_CONTAINER_MultiHashMap *master_result_map;
 
+  /**
+   * Map containing the hashes of all (encrypted) UBlocks we have
+   * already decrypted and parsed for this search (no values).  Used
+   * to skip the expensive key derivation and decryption when the
+   * same block is delivered again, i.e. from multiple peers.
+   */
+  struct GNUNET_CONTAINER_MultiHashMap *processed_blocks;
+
   /**
    * Per-keyword information for a keyword search.  This array will
    * have exactly as many entries as there were keywords.
@@ -2020,6 +2095,13 @@ struct GNUNET_FS_DownloadContext
    */
   unsigned int treedepth;
 
+  /**
+   * Number of requests that were still outstanding when we last
+   * re-issued the remaining queries near the end of the download
+   * (to cut tail latency); 0 if we have not done so yet.
+   */
+  unsigned int hedge_count;
+
   /**
    * Options for the download.
    */
@@ -42,6 +42,22 @@
  */
 #define GNUNET_DIRECTORY_MAGIC "\211GND\r\n\032\n"
 
+/**
+ * String (8 bytes) that marks the entry index appended to a GNUnet
+ * directory by #GNUNET_FS_directory_builder_finish().  The index
+ * is encoded such that old parsers skip over it (every DBLOCK-sized
+ * block of the index trailer starts with a '\0' byte).
+ */
+#define GNUNET_DIRECTORY_INDEX_MAGIC "\211GNDIDX\n"
+
+/**
+ * Number of bytes in the footer that concludes a directory with an
+ * embedded entry index: the absolute offset of the start of the
+ * index trailer (64-bit, big-endian) followed by
+ * #GNUNET_DIRECTORY_INDEX_MAGIC.
+ */
+#define INDEX_FOOTER_SIZE (sizeof (uint64_t) + 8)
+
 
 /**
  * Does the meta-data claim that this is a directory?
@@ -295,6 +311,434 @@ GNUNET_FS_directory_list_contents (size_t size, const void *data,
   return GNUNET_OK;
 }
 
+
+/**
+ * Write bytes of the index trailer, inserting a '\0' byte at the
+ * start of the trailer and at every DBLOCK boundary so that old
+ * directory parsers skip over the index (they treat a '\0' at the
+ * start of a block as padding and jump to the next block).
+ *
+ * @param data directory buffer to write to
+ * @param pos current write position (updated)
+ * @param start absolute offset at which the trailer begins
+ * @param src bytes to append
+ * @param len number of bytes in @a src
+ */
+static void
+trailer_put (char *data, size_t *pos, size_t start, const void *src,
+             size_t len)
+{
+  const char *s = src;
+
+  while (len > 0)
+  {
+    if ((*pos == start) || (0 == (*pos % DBLOCK_SIZE)))
+    {
+      data[(*pos)++] = '\0';
+      continue;
+    }
+    data[(*pos)++] = *s++;
+    len--;
+  }
+}
+
+
+/**
+ * Read bytes from the index trailer, skipping the '\0' bytes
+ * inserted by #trailer_put() and verifying that they are present
+ * (their absence means that this is not a valid index trailer).
+ *
+ * @param data directory buffer to read from
+ * @param size total number of bytes in @a data
+ * @param start absolute offset at which the trailer begins
+ * @param pos current read position (updated)
+ * @param dst buffer to fill
+ * @param len number of bytes to read
+ * @return #GNUNET_OK on success, #GNUNET_SYSERR if the trailer is malformed
+ */
+static int
+trailer_get (const char *data, size_t size, size_t start, size_t *pos,
+             void *dst, size_t len)
+{
+  char *d = dst;
+
+  while (len > 0)
+  {
+    if (*pos >= size)
+      return GNUNET_SYSERR;
+    if ((*pos == start) || (0 == (*pos % DBLOCK_SIZE)))
+    {
+      if ('\0' != data[*pos])
+        return GNUNET_SYSERR;
+      (*pos)++;
+      continue;
+    }
+    *d++ = data[(*pos)++];
+    len--;
+  }
+  return GNUNET_OK;
+}
+
+
+/**
+ * Compute the total number of bytes (including footer and possible
+ * padding) needed to append an index trailer with @a payload bytes
+ * of index data to a directory of @a start bytes.
+ *
+ * @param start size of the directory without the trailer
+ * @param payload number of index bytes to store
+ * @return number of bytes the trailer will occupy
+ */
+static size_t
+index_trailer_size (size_t start, size_t payload)
+{
+  size_t pos;
+  size_t chunk;
+
+  pos = start;
+  while (payload > 0)
+  {
+    if ((pos == start) || (0 == (pos % DBLOCK_SIZE)))
+    {
+      pos++;
+      continue;
+    }
+    chunk = DBLOCK_SIZE - (pos % DBLOCK_SIZE);
+    if (chunk > payload)
+      chunk = payload;
+    pos += chunk;
+    payload -= chunk;
+  }
+  pos += INDEX_FOOTER_SIZE;
+  if ((0 != (pos % DBLOCK_SIZE)) && (INDEX_FOOTER_SIZE >= (pos % DBLOCK_SIZE)))
+  {
+    /* footer would straddle a block boundary (where a '\0' byte must
+     * be placed for old parsers); pad so that it fits contiguously
+     * right after the boundary's padding byte */
+    pos = (pos / DBLOCK_SIZE) * DBLOCK_SIZE + 1 + INDEX_FOOTER_SIZE;
+  }
+  return pos - start;
+}
+
+
+/**
+ * Handle for iterating over a directory without eagerly
+ * decoding all entries.
+ */
+struct GNUNET_FS_DirectoryIterator
+{
+  /**
+   * Serialized directory (not copied, owned by the caller).
+   */
+  const char *data;
+
+  /**
+   * Total number of bytes in @e data.
+   */
+  size_t size;
+
+  /**
+   * End of the entry region (start of the index trailer if the
+   * directory has one, otherwise equal to @e size).
+   */
+  size_t end;
+
+  /**
+   * Where to continue scanning for the next entry.
+   */
+  size_t pos;
+
+  /**
+   * Entry offsets from the embedded index (host byte order),
+   * NULL if the directory has no index.
+   */
+  uint64_t *idx;
+
+  /**
+   * Number of entries in @e idx.
+   */
+  unsigned int count;
+
+  /**
+   * Offset of the URI of the current entry, 0 if the iterator
+   * does not point to an entry.
+   */
+  size_t uri_off;
+
+  /**
+   * Offset of the serialized meta data of the current entry.
+   */
+  size_t meta_off;
+
+  /**
+   * Number of bytes of serialized meta data of the current entry.
+   */
+  uint32_t meta_size;
+};
+
+
+/**
+ * Try to locate and load the embedded entry index of a directory.
+ *
+ * @param it iterator being initialized
+ * @return #GNUNET_OK if an index was found and loaded,
+ *         #GNUNET_SYSERR if the directory has no (valid) index
+ */
+static int
+load_index (struct GNUNET_FS_DirectoryIterator *it)
+{
+  char magic[8];
+  uint32_t big;
+  uint64_t istart;
+  uint64_t off;
+  size_t ipos;
+  unsigned int i;
+
+  if ((it->size < INDEX_FOOTER_SIZE) ||
+      (0 != memcmp (&it->data[it->size - 8],
+                    GNUNET_DIRECTORY_INDEX_MAGIC, 8)))
+    return GNUNET_SYSERR;
+  memcpy (&istart, &it->data[it->size - INDEX_FOOTER_SIZE],
+          sizeof (uint64_t));
+  istart = GNUNET_ntohll (istart);
+  if ((istart < it->pos) || (istart >= it->size - INDEX_FOOTER_SIZE))
+    return GNUNET_SYSERR;
+  ipos = (size_t) istart;
+  if ((GNUNET_OK !=
+       trailer_get (it->data, it->size, (size_t) istart, &ipos, magic, 8)) ||
+      (0 != memcmp (magic, GNUNET_DIRECTORY_INDEX_MAGIC, 8)) ||
+      (GNUNET_OK !=
+       trailer_get (it->data, it->size, (size_t) istart, &ipos, &big,
+                    sizeof (uint32_t))))
+    return GNUNET_SYSERR;
+  big = ntohl (big);
+  if ((0 == big) || (big > istart / sizeof (uint64_t)))
+    return GNUNET_SYSERR;       /* more entries than plausible */
+  it->idx = GNUNET_malloc_large (big * sizeof (uint64_t));
+  if (NULL == it->idx)
+    return GNUNET_SYSERR;
+  for (i = 0; i < big; i++)
+  {
+    if (GNUNET_OK !=
+        trailer_get (it->data, it->size, (size_t) istart, &ipos, &off,
+                     sizeof (uint64_t)))
+      break;
+    off = GNUNET_ntohll (off);
+    if ((off < it->pos) || (off >= istart))
+      break;
+    it->idx[i] = off;
+  }
+  if (i < big)
+  {
+    GNUNET_free (it->idx);
+    it->idx = NULL;
+    return GNUNET_SYSERR;
+  }
+  it->count = big;
+  it->end = (size_t) istart;
+  return GNUNET_OK;
+}
+
+
+/**
+ * Locate the entry starting at (or after) the iterator's current
+ * scan position.  Only determines the boundaries of the URI and
+ * the serialized meta data; neither is decoded.
+ *
+ * @param it iterator to advance
+ * @return #GNUNET_YES if an entry was found,
+ *         #GNUNET_NO if the end of the directory was reached
+ */
+static int
+parse_entry (struct GNUNET_FS_DirectoryIterator *it)
+{
+  const char *cdata = it->data;
+  size_t pos = it->pos;
+  size_t epos;
+  uint64_t align;
+  uint32_t mdSize;
+
+  it->uri_off = 0;
+  while (pos < it->end)
+  {
+    if ('\0' == cdata[pos])
+    {
+      /* URI is never empty, must be end of block,
+       * skip to next alignment */
+      align = ((pos / DBLOCK_SIZE) + 1) * DBLOCK_SIZE;
+      if (align == pos)
+        align += DBLOCK_SIZE;
+      pos = align;
+      continue;
+    }
+    epos = pos;
+    while ((epos < it->end) && (cdata[epos] != '\0'))
+      epos++;
+    if ((epos >= it->end) ||
+        (epos + 1 + sizeof (uint32_t) > it->end))
+      return GNUNET_NO;         /* malformed - or partial download */
+    memcpy (&mdSize, &cdata[epos + 1], sizeof (uint32_t));
+    mdSize = ntohl (mdSize);
+    if (epos + 1 + sizeof (uint32_t) + mdSize > it->end)
+      return GNUNET_NO;         /* malformed - or partial download */
+    it->uri_off = pos;
+    it->meta_off = epos + 1 + sizeof (uint32_t);
+    it->meta_size = mdSize;
+    it->pos = it->meta_off + mdSize;
+    return GNUNET_YES;
+  }
+  return GNUNET_NO;
+}
+
+
+/**
+ * Start iterating over the entries of a serialized directory.  In
+ * contrast to #GNUNET_FS_directory_list_contents(), this iterator
+ * only locates entry boundaries and defers parsing of URIs and
+ * deserialization of meta data until the respective accessor is
+ * called for an entry; this makes iteration over very large
+ * directories cheap.  Requires the complete directory in memory
+ * (not just individual blocks); @a data must remain valid (and
+ * unmodified) until #GNUNET_FS_directory_iterator_stop() is called.
+ *
+ * @param size number of bytes in @a data
+ * @param data pointer to the beginning of the directory
+ * @return iterator positioned before the first entry,
+ *         NULL if @a data does not represent a directory
+ */
+struct GNUNET_FS_DirectoryIterator *
+GNUNET_FS_directory_iterator_start (size_t size, const void *data)
+{
+  struct GNUNET_FS_DirectoryIterator *it;
+  const char *cdata = data;
+  uint32_t mdSize;
+
+  if ((size < 8 + sizeof (uint32_t)) ||
+      (0 != memcmp (cdata, GNUNET_FS_DIRECTORY_MAGIC, 8)))
+    return NULL;
+  memcpy (&mdSize, &cdata[8], sizeof (uint32_t));
+  mdSize = ntohl (mdSize);
+  if (mdSize > size - 8 - sizeof (uint32_t))
+    return NULL;
+  it = GNUNET_new (struct GNUNET_FS_DirectoryIterator);
+  it->data = cdata;
+  it->size = size;
+  it->end = size;
+  it->pos = 8 + sizeof (uint32_t) + mdSize;
+  (void) load_index (it);       /* directories without an index just
+                                 * cannot seek */
+  return it;
+}
+
+
+/**
+ * Advance the iterator to the next entry in the directory.
+ *
+ * @param it iterator to advance
+ * @return #GNUNET_YES if the iterator now points to an entry,
+ *         #GNUNET_NO if the end of the directory was reached
+ */
+int
+GNUNET_FS_directory_iterator_next (struct GNUNET_FS_DirectoryIterator *it)
+{
+  return parse_entry (it);
+}
+
+
+/**
+ * Position the iterator at the given entry using the embedded
+ * entry index.
+ *
+ * @param it iterator to position
+ * @param idx zero-based number of the desired entry
+ * @return #GNUNET_OK if the iterator now points to entry @a idx,
+ *         #GNUNET_SYSERR if there is no index or @a idx is out of bounds
+ */
+int
+GNUNET_FS_directory_iterator_seek (struct GNUNET_FS_DirectoryIterator *it,
+                                   unsigned int idx)
+{
+  if ((NULL == it->idx) || (idx >= it->count))
+    return GNUNET_SYSERR;
+  it->pos = (size_t) it->idx[idx];
+  if (GNUNET_YES != parse_entry (it))
+    return GNUNET_SYSERR;
+  return GNUNET_OK;
+}
+
+
+/**
+ * Get the number of entries in the directory according to the
+ * embedded entry index.
+ *
+ * @param it iterator to inspect
+ * @return number of entries, 0 if the directory has no index
+ */
+unsigned int
+GNUNET_FS_directory_iterator_get_count (const struct GNUNET_FS_DirectoryIterator *it)
+{
+  return it->count;
+}
+
+
+/**
+ * Parse the URI of the entry the iterator points to.
+ *
+ * @param it iterator to inspect
+ * @return the URI, NULL if the iterator points to no (valid) entry
+ */
+struct GNUNET_FS_Uri *
+GNUNET_FS_directory_iterator_get_uri (const struct GNUNET_FS_DirectoryIterator *it)
+{
+  struct GNUNET_FS_Uri *uri;
+  char *emsg;
+
+  if (0 == it->uri_off)
+    return NULL;
+  uri = GNUNET_FS_uri_parse (&it->data[it->uri_off], &emsg);
+  if (NULL == uri)
+  {
+    GNUNET_free_non_null (emsg);
+    return NULL;
+  }
+  if (GNUNET_FS_uri_test_ksk (uri))
+  {
+    GNUNET_FS_uri_destroy (uri);
+    return NULL;                /* illegal in directory! */
+  }
+  return uri;
+}
+
+
+/**
+ * Deserialize the meta data of the entry the iterator points to.
+ *
+ * @param it iterator to inspect
+ * @return the meta data, NULL if the iterator points to no (valid) entry
+ */
+struct GNUNET_CONTAINER_MetaData *
+GNUNET_FS_directory_iterator_get_meta (const struct GNUNET_FS_DirectoryIterator *it)
+{
+  if (0 == it->uri_off)
+    return NULL;
+  return GNUNET_CONTAINER_meta_data_deserialize (&it->data[it->meta_off],
+                                                 it->meta_size);
+}
+
+
+/**
+ * Release resources of a directory iterator.
+ *
+ * @param it iterator to destroy
+ */
+void
+GNUNET_FS_directory_iterator_stop (struct GNUNET_FS_DirectoryIterator *it)
+{
+  GNUNET_free_non_null (it->idx);
+  GNUNET_free (it);
+}
+
+
 /**
  * Entries in the directory (builder).
  */
@@ -562,17 +1006,23 @@ GNUNET_FS_directory_builder_finish (struct GNUNET_FS_DirectoryBuilder *bld,
   unsigned int j;
   struct BuilderEntry *pos;
   struct BuilderEntry **bes;
+  uint64_t *idxe;
   size_t size;
+  size_t isize;
+  size_t ipos;
   size_t psize;
   size_t off;
   ssize_t ret;
   uint32_t big;
+  uint64_t bigl;
 
   size = strlen (GNUNET_DIRECTORY_MAGIC) + sizeof (uint32_t);
   size += GNUNET_CONTAINER_meta_data_get_serialized_size (bld->meta);
   sizes = NULL;
   perm = NULL;
   bes = NULL;
+  idxe = NULL;
+  isize = 0;
   if (0 < bld->count)
   {
     sizes = GNUNET_malloc (bld->count * sizeof (size_t));
@@ -594,9 +1044,16 @@ GNUNET_FS_directory_builder_finish (struct GNUNET_FS_DirectoryBuilder *bld,
       size += sizes[perm[i]];
       size = do_align (psize, size);
     }
+    idxe = GNUNET_malloc (bld->count * sizeof (uint64_t));
+    /* append an entry index so that readers can seek to the n-th
+     * entry without scanning; old parsers skip over it */
+    isize =
+        index_trailer_size (size,
+                            8 + sizeof (uint32_t) +
+                            bld->count * sizeof (uint64_t));
   }
-  *rsize = size;
-  data = GNUNET_malloc_large (size);
+  *rsize = size + isize;
+  data = GNUNET_malloc_large (size + isize);
   if (data == NULL)
   {
     GNUNET_log_strerror (GNUNET_ERROR_TYPE_ERROR, "malloc");
@@ -605,6 +1062,7 @@ GNUNET_FS_directory_builder_finish (struct GNUNET_FS_DirectoryBuilder *bld,
     GNUNET_free_non_null (sizes);
     GNUNET_free_non_null (perm);
     GNUNET_free_non_null (bes);
+    GNUNET_free_non_null (idxe);
     return GNUNET_SYSERR;
   }
   *rdata = data;
@@ -627,12 +1085,27 @@ GNUNET_FS_directory_builder_finish (struct GNUNET_FS_DirectoryBuilder *bld,
     off += sizes[i];
     off = do_align (psize, off);
     memcpy (&data[off - sizes[i]], &(bes[i])[1], sizes[i]);
+    idxe[j] = GNUNET_htonll ((uint64_t) (off - sizes[i]));
     GNUNET_free (bes[i]);
   }
   GNUNET_free_non_null (sizes);
   GNUNET_free_non_null (perm);
   GNUNET_free_non_null (bes);
   GNUNET_assert (off == size);
+  if (0 < bld->count)
+  {
+    ipos = size;
+    trailer_put (data, &ipos, size, GNUNET_DIRECTORY_INDEX_MAGIC, 8);
+    big = htonl (bld->count);
+    trailer_put (data, &ipos, size, &big, sizeof (uint32_t));
+    trailer_put (data, &ipos, size, idxe, bld->count * sizeof (uint64_t));
+    GNUNET_assert (ipos <= size + isize - INDEX_FOOTER_SIZE);
+    bigl = GNUNET_htonll ((uint64_t) size);
+    memcpy (&data[size + isize - INDEX_FOOTER_SIZE], &bigl,
+            sizeof (uint64_t));
+    memcpy (&data[size + isize - 8], GNUNET_DIRECTORY_INDEX_MAGIC, 8);
+  }
+  GNUNET_free_non_null (idxe);
   GNUNET_CONTAINER_meta_data_destroy (bld->meta);
   GNUNET_free (bld);
   return GNUNET_OK;
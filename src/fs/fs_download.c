@@ -721,6 +721,51 @@ try_top_down_reconstruction (struct GNUNET_FS_DownloadContext *dc,
 }
 
 
+/**
+ * Number of outstanding block requests at or below which we
+ * re-issue the remaining queries to the FS service whenever
+ * another block completes.  Re-submitting a query makes the
+ * service try additional sources, which cuts the tail latency
+ * caused by a slow source holding the last few blocks.
+ */
+#define TAIL_HEDGE_THRESHOLD 8
+
+
+/**
+ * Ask for transmission of all pending requests (unless a
+ * transmission request is already scheduled).  Requests enough
+ * buffer space for the whole batch so that the queries go out
+ * together instead of paying one round-trip to the service per
+ * query.
+ *
+ * @param dc download with pending requests
+ */
+static void
+request_transmission (struct GNUNET_FS_DownloadContext *dc)
+{
+  struct DownloadRequest *dr;
+  size_t msize;
+
+  if (NULL != dc->th)
+    return;
+  msize = 0;
+  for (dr = dc->pending_head; NULL != dr; dr = dr->next)
+  {
+    if (msize + sizeof (struct SearchMessage) >= GNUNET_SERVER_MAX_MESSAGE_SIZE)
+      break;
+    msize += sizeof (struct SearchMessage);
+  }
+  if (0 == msize)
+    return;
+  dc->th =
+      GNUNET_CLIENT_notify_transmit_ready (dc->client, msize,
+                                           GNUNET_CONSTANTS_SERVICE_TIMEOUT,
+                                           GNUNET_NO,
+                                           &transmit_download_request, dc);
+  GNUNET_assert (NULL != dc->th);
+}
+
+
 /**
  * Schedule the download of the specified block in the tree.
  *
@@ -775,13 +820,7 @@ schedule_block_download (struct GNUNET_FS_DownloadContext *dc,
     return;                     /* download not active */
   GNUNET_CONTAINER_DLL_insert (dc->pending_head, dc->pending_tail, dr);
   dr->is_pending = GNUNET_YES;
-  if (NULL == dc->th)
-    dc->th =
-        GNUNET_CLIENT_notify_transmit_ready (dc->client,
-                                             sizeof (struct SearchMessage),
-                                             GNUNET_CONSTANTS_SERVICE_TIMEOUT,
-                                             GNUNET_NO,
-                                             &transmit_download_request, dc);
+  request_transmission (dc);
 }
 
 
@@ -1218,6 +1257,30 @@ signal_error:
 }
 
 
+/**
+ * Iterator re-adding an outstanding request to the pending list
+ * so that its query is transmitted to the FS service again.  Used
+ * to hedge the last few blocks of a download.
+ *
+ * @param cls our download context
+ * @param key unused
+ * @param entry entry of type `struct DownloadRequest`
+ * @return #GNUNET_OK
+ */
+static int
+hedge_entry (void *cls, const struct GNUNET_HashCode *key, void *entry)
+{
+  struct GNUNET_FS_DownloadContext *dc = cls;
+  struct DownloadRequest *dr = entry;
+
+  if (GNUNET_YES == dr->is_pending)
+    return GNUNET_OK;           /* not transmitted yet anyway */
+  GNUNET_CONTAINER_DLL_insert (dc->pending_head, dc->pending_tail, dr);
+  dr->is_pending = GNUNET_YES;
+  return GNUNET_OK;
+}
+
+
 /**
  * Process a download result.
  *
@@ -1238,6 +1301,7 @@ process_result (struct GNUNET_FS_DownloadContext *dc,
                 const void *data, size_t size)
 {
   struct ProcessResultClosure prc;
+  unsigned int num_active;
 
   prc.dc = dc;
   prc.data = data;
@@ -1254,6 +1318,22 @@ process_result (struct GNUNET_FS_DownloadContext *dc,
   GNUNET_CONTAINER_multihashmap_get_multiple (dc->active, &prc.query,
                                               &process_result_with_request,
                                               &prc);
+  if ((NULL == dc->active) || (NULL == dc->client))
+    return;                     /* fatal error during processing */
+  num_active = GNUNET_CONTAINER_multihashmap_size (dc->active);
+  if ((num_active > 0) && (num_active <= TAIL_HEDGE_THRESHOLD) &&
+      ((0 == dc->hedge_count) || (num_active < dc->hedge_count)))
+  {
+    /* near the end of the download; re-issue the remaining queries
+     * so that the service tries additional sources instead of
+     * waiting on whoever got the original requests */
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "Hedging %u remaining block requests\n",
+                num_active);
+    dc->hedge_count = num_active;
+    GNUNET_CONTAINER_multihashmap_iterate (dc->active, &hedge_entry, dc);
+    request_transmission (dc);
+  }
 }
 
 
@@ -1348,16 +1428,7 @@ transmit_download_request (void *cls, size_t size, void *buf)
     msize += sizeof (struct SearchMessage);
     sm++;
   }
-  if (NULL != dc->pending_head)
-  {
-    dc->th =
-        GNUNET_CLIENT_notify_transmit_ready (dc->client,
-                                             sizeof (struct SearchMessage),
-                                             GNUNET_CONSTANTS_SERVICE_TIMEOUT,
-                                             GNUNET_NO,
-                                             &transmit_download_request, dc);
-    GNUNET_assert (NULL != dc->th);
-  }
+  request_transmission (dc);
   if (GNUNET_NO == dc->in_receive)
   {
     dc->in_receive = GNUNET_YES;
@@ -1390,16 +1461,7 @@ do_reconnect (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
     return;
   }
   dc->client = client;
-  if (NULL != dc->pending_head)
-  {
-    dc->th =
-        GNUNET_CLIENT_notify_transmit_ready (client,
-                                             sizeof (struct SearchMessage),
-                                             GNUNET_CONSTANTS_SERVICE_TIMEOUT,
-                                             GNUNET_NO,
-                                             &transmit_download_request, dc);
-    GNUNET_assert (NULL != dc->th);
-  }
+  request_transmission (dc);
 }
 
 
@@ -1492,16 +1554,7 @@ activate_fs_download (void *cls, struct GNUNET_CLIENT_Connection *client)
   GNUNET_CONTAINER_multihashmap_iterate (dc->active, &retry_entry, dc);
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Asking for transmission to FS service\n");
-  if (NULL != dc->pending_head)
-  {
-    dc->th =
-        GNUNET_CLIENT_notify_transmit_ready (dc->client,
-                                             sizeof (struct SearchMessage),
-                                             GNUNET_CONSTANTS_SERVICE_TIMEOUT,
-                                             GNUNET_NO,
-                                             &transmit_download_request, dc);
-    GNUNET_assert (NULL != dc->th);
-  }
+  request_transmission (dc);
 }
 
 
@@ -32,6 +32,34 @@
 #include "fs_api.h"
 #include "fs_tree.h"
 
+/**
+ * Information about a datastore PUT operation that is still in
+ * flight; kept in a list in the publish context so that the
+ * operations can be cancelled on suspend/stop.
+ */
+struct GNUNET_FS_PublishDataPut
+{
+  /**
+   * This is a doubly-linked list.
+   */
+  struct GNUNET_FS_PublishDataPut *next;
+
+  /**
+   * This is a doubly-linked list.
+   */
+  struct GNUNET_FS_PublishDataPut *prev;
+
+  /**
+   * Publish context this operation belongs to.
+   */
+  struct GNUNET_FS_PublishContext *pc;
+
+  /**
+   * Queue entry for the PUT request with the datastore.
+   */
+  struct GNUNET_DATASTORE_QueueEntry *qe;
+};
+
 
 /**
  * Fill in all of the generic fields for
@@ -106,7 +134,7 @@ publish_cleanup (struct GNUNET_FS_PublishContext *pc)
  * Function called by the datastore API with
  * the result from the PUT request.
  *
- * @param cls the `struct GNUNET_FS_PublishContext *`
+ * @param cls the `struct GNUNET_FS_PublishDataPut *`
  * @param success #GNUNET_OK on success
  * @param min_expiration minimum expiration time required for content to be stored
  * @param msg error message (or NULL)
@@ -117,12 +145,20 @@ ds_put_cont (void *cls,
 	     struct GNUNET_TIME_Absolute min_expiration,
 	     const char *msg)
 {
-  struct GNUNET_FS_PublishContext *pc = cls;
+  struct GNUNET_FS_PublishDataPut *pdp = cls;
+  struct GNUNET_FS_PublishContext *pc = pdp->pc;
   struct GNUNET_FS_ProgressInfo pi;
 
-  pc->qre = NULL;
+  GNUNET_CONTAINER_DLL_remove (pc->pdp_head,
+			       pc->pdp_tail,
+			       pdp);
+  GNUNET_free (pdp);
+  GNUNET_assert (pc->active_puts > 0);
+  pc->active_puts--;
   if (GNUNET_SYSERR == success)
   {
+    if (NULL != pc->fi_pos->emsg)
+      return;                   /* error already reported for another block */
     GNUNET_asprintf (&pc->fi_pos->emsg,
                      _("Publishing failed: %s"),
                      msg);
@@ -144,10 +180,17 @@ ds_put_cont (void *cls,
     return;
   }
   pc->any_done = GNUNET_YES;
-  GNUNET_assert (NULL == pc->upload_task);
-  pc->upload_task =
-      GNUNET_SCHEDULER_add_with_priority (GNUNET_SCHEDULER_PRIORITY_BACKGROUND,
-                                          &GNUNET_FS_publish_main_, pc);
+  if (NULL != pc->upload_task)
+    return;                     /* tree encoder is already scheduled */
+  /* continue encoding if we were stalled on a full pipeline;
+     once the encoder is done, wait for the last PUT to drain
+     before moving on to the next file */
+  if ( ( (NULL != pc->fi_pos) &&
+	 (NULL != pc->fi_pos->te) ) ||
+       (0 == pc->active_puts) )
+    pc->upload_task =
+        GNUNET_SCHEDULER_add_with_priority (GNUNET_SCHEDULER_PRIORITY_BACKGROUND,
+                                            &GNUNET_FS_publish_main_, pc);
 }
 
 
@@ -458,6 +501,12 @@ encode_cont (void *cls,
     pi.value.publish.specifics.progress.depth = GNUNET_FS_compute_depth (flen);
     p->client_info = GNUNET_FS_publish_make_status_ (&pi, pc, p, flen);
   }
+  if (0 != pc->active_puts)
+  {
+    /* blocks are still being written by the datastore; the
+       continuation of the last PUT will resume the main loop */
+    return;
+  }
   /* continue with main */  /* continue with main */
   GNUNET_assert (NULL == pc->upload_task);
   pc->upload_task =
@@ -491,6 +540,7 @@ block_proc (void *cls,
 {
   struct GNUNET_FS_PublishContext *pc = cls;
   struct GNUNET_FS_FileInformation *p;
+  struct GNUNET_FS_PublishDataPut *pdp;
   struct OnDemandBlock odb;
 
   p = pc->fi_pos;
@@ -504,6 +554,8 @@ block_proc (void *cls,
     return;
   }
 
+  pdp = GNUNET_new (struct GNUNET_FS_PublishDataPut);
+  pdp->pc = pc;
   if ( (GNUNET_YES != p->is_directory) &&
        (GNUNET_YES == p->data.file.do_index) &&
        (GNUNET_BLOCK_TYPE_FS_DBLOCK == type) )
@@ -514,8 +566,7 @@ block_proc (void *cls,
                 sizeof (struct OnDemandBlock));
     odb.offset = GNUNET_htonll (offset);
     odb.file_id = p->data.file.file_id;
-    GNUNET_assert (pc->qre == NULL);
-    pc->qre =
+    pdp->qe =
         GNUNET_DATASTORE_put (pc->dsh,
                               (p->is_directory == GNUNET_YES) ? 0 : pc->rid,
                               &chk->query,
@@ -526,31 +577,51 @@ block_proc (void *cls,
                               p->bo.anonymity_level,
                               p->bo.replication_level,
                               p->bo.expiration_time,
-                              -2, 1,
+                              -2, pc->h->publish_pipeline_depth,
                               GNUNET_CONSTANTS_SERVICE_TIMEOUT,
-                              &ds_put_cont, pc);
+                              &ds_put_cont, pdp);
+  }
+  else
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+		"Publishing block `%s' for offset %llu with size %u\n",
+		GNUNET_h2s (&chk->query),
+		(unsigned long long) offset,
+		(unsigned int) block_size);
+    pdp->qe =
+	GNUNET_DATASTORE_put (pc->dsh, (p->is_directory == GNUNET_YES) ? 0 : pc->rid,
+			      &chk->query,
+			      block_size,
+			      block,
+			      type,
+			      p->bo.content_priority,
+			      p->bo.anonymity_level,
+			      p->bo.replication_level,
+			      p->bo.expiration_time,
+			      -2, pc->h->publish_pipeline_depth,
+			      GNUNET_CONSTANTS_SERVICE_TIMEOUT,
+			      &ds_put_cont,
+			      pdp);
+  }
+  GNUNET_CONTAINER_DLL_insert_tail (pc->pdp_head,
+				    pc->pdp_tail,
+				    pdp);
+  pc->active_puts++;
+  if (NULL == pdp->qe)
+  {
+    /* datastore queue full, treat like a failed request */
+    GNUNET_break (0);
+    ds_put_cont (pdp, GNUNET_SYSERR, GNUNET_TIME_UNIT_ZERO_ABS,
+		 _("datastore request queue full"));
     return;
   }
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "Publishing block `%s' for offset %llu with size %u\n",
-              GNUNET_h2s (&chk->query),
-              (unsigned long long) offset,
-              (unsigned int) block_size);
-  GNUNET_assert (pc->qre == NULL);
-  pc->qre =
-      GNUNET_DATASTORE_put (pc->dsh, (p->is_directory == GNUNET_YES) ? 0 : pc->rid,
-                            &chk->query,
-                            block_size,
-                            block,
-                            type,
-                            p->bo.content_priority,
-                            p->bo.anonymity_level,
-                            p->bo.replication_level,
-                            p->bo.expiration_time,
-                            -2, 1,
-                            GNUNET_CONSTANTS_SERVICE_TIMEOUT,
-                            &ds_put_cont,
-                            pc);
+  /* while the datastore is writing this block, already hash and
+     encrypt the next ones (bounded pipeline) */
+  if ( (pc->active_puts < pc->h->publish_pipeline_depth) &&
+       (NULL == pc->upload_task) )
+    pc->upload_task =
+        GNUNET_SCHEDULER_add_with_priority (GNUNET_SCHEDULER_PRIORITY_BACKGROUND,
+                                            &GNUNET_FS_publish_main_, pc);
 }
 
 
@@ -1171,6 +1242,7 @@ suspend_operation (struct GNUNET_FS_FileInformation *fi,
 		   struct GNUNET_FS_PublishContext *pc)
 {
   struct GNUNET_FS_ProgressInfo pi;
+  struct GNUNET_FS_PublishDataPut *pdp;
   uint64_t off;
 
   if (NULL != pc->ksk_pc)
@@ -1195,6 +1267,15 @@ suspend_operation (struct GNUNET_FS_FileInformation *fi,
     GNUNET_DATASTORE_cancel (pc->qre);
     pc->qre = NULL;
   }
+  while (NULL != (pdp = pc->pdp_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (pc->pdp_head,
+				 pc->pdp_tail,
+				 pdp);
+    GNUNET_DATASTORE_cancel (pdp->qe);
+    GNUNET_free (pdp);
+  }
+  pc->active_puts = 0;
   if (NULL != pc->dsh)
   {
     GNUNET_DATASTORE_disconnect (pc->dsh, GNUNET_NO);
@@ -1472,6 +1553,7 @@ void
 GNUNET_FS_publish_stop (struct GNUNET_FS_PublishContext *pc)
 {
   struct GNUNET_FS_ProgressInfo pi;
+  struct GNUNET_FS_PublishDataPut *pdp;
   uint64_t off;
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
@@ -1516,6 +1598,15 @@ GNUNET_FS_publish_stop (struct GNUNET_FS_PublishContext *pc)
     GNUNET_DATASTORE_cancel (pc->qre);
     pc->qre = NULL;
   }
+  while (NULL != (pdp = pc->pdp_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (pc->pdp_head,
+				 pc->pdp_tail,
+				 pdp);
+    GNUNET_DATASTORE_cancel (pdp->qe);
+    GNUNET_free (pdp);
+  }
+  pc->active_puts = 0;
   pi.status = GNUNET_FS_STATUS_PUBLISH_STOPPED;
   GNUNET_break (NULL == GNUNET_FS_publish_make_status_ (&pi, pc, pc->fi, off));
   publish_cleanup (pc);
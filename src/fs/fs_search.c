@@ -396,6 +396,7 @@ start_probe_ping_task (struct GNUNET_FS_SearchResult *sr)
   GNUNET_CONTAINER_DLL_insert (h->probes_head,
                                h->probes_tail,
                                sr);
+  h->active_probes++;
   if (NULL == h->probe_ping_task)
     h->probe_ping_task
       = GNUNET_SCHEDULER_add_now (&probe_ping_task_cb,
@@ -412,15 +413,29 @@ void
 GNUNET_FS_stop_probe_ping_task_ (struct GNUNET_FS_SearchResult *sr)
 {
   struct GNUNET_FS_Handle *h = sr->h;
+  struct GNUNET_FS_SearchResult *pos;
 
   GNUNET_CONTAINER_DLL_remove (h->probes_head,
                                h->probes_tail,
                                sr);
+  GNUNET_assert (h->active_probes > 0);
+  h->active_probes--;
   if (NULL == h->probes_head)
   {
     GNUNET_SCHEDULER_cancel (h->probe_ping_task);
     h->probe_ping_task = NULL;
   }
+  /* a probe slot became free, start the next queued probe (if any);
+     loop as popped entries may no longer be eligible for probing */
+  while ( (NULL != (pos = h->pending_probes_head)) &&
+          (h->active_probes < h->max_parallel_probes) )
+  {
+    GNUNET_CONTAINER_DLL_remove (h->pending_probes_head,
+                                 h->pending_probes_tail,
+                                 pos);
+    pos->probe_pending = GNUNET_NO;
+    GNUNET_FS_search_start_probe_ (pos);
+  }
 }
 
 
@@ -450,6 +465,25 @@ GNUNET_FS_search_start_probe_ (struct GNUNET_FS_SearchResult *sr)
     return;
   if ((len <= DBLOCK_SIZE) && (sr->availability_success > 0))
     return;
+  if (sr->h->active_probes >= sr->h->max_parallel_probes)
+  {
+    /* probe budget exhausted, wait for a slot to become free */
+    if (GNUNET_YES != sr->probe_pending)
+    {
+      sr->probe_pending = GNUNET_YES;
+      GNUNET_CONTAINER_DLL_insert_tail (sr->h->pending_probes_head,
+                                        sr->h->pending_probes_tail,
+                                        sr);
+    }
+    return;
+  }
+  if (GNUNET_YES == sr->probe_pending)
+  {
+    GNUNET_CONTAINER_DLL_remove (sr->h->pending_probes_head,
+                                 sr->h->pending_probes_tail,
+                                 sr);
+    sr->probe_pending = GNUNET_NO;
+  }
   off = len / DBLOCK_SIZE;
   if (off > 0)
     off = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, off);
@@ -497,7 +531,7 @@ GNUNET_FS_probe (struct GNUNET_FS_Handle *h,
   GNUNET_assert (NULL != h);
   sr = GNUNET_new (struct GNUNET_FS_SearchResult);
   sr->h = h;
-  sr->uri = GNUNET_FS_uri_dup (uri);
+  sr->uri = GNUNET_FS_uri_intern (GNUNET_FS_uri_dup (uri));
   sr->meta = GNUNET_CONTAINER_meta_data_duplicate (meta);
   sr->client_info = client_info;
   sr->anonymity = anonymity;
@@ -514,6 +548,13 @@ GNUNET_FS_probe (struct GNUNET_FS_Handle *h,
 static void
 GNUNET_FS_search_stop_probe_ (struct GNUNET_FS_SearchResult *sr)
 {
+  if (GNUNET_YES == sr->probe_pending)
+  {
+    GNUNET_CONTAINER_DLL_remove (sr->h->pending_probes_head,
+                                 sr->h->pending_probes_tail,
+                                 sr);
+    sr->probe_pending = GNUNET_NO;
+  }
   if (NULL != sr->probe_ctx)
   {
     GNUNET_FS_download_stop (sr->probe_ctx, GNUNET_YES);
@@ -595,7 +636,7 @@ process_ksk_result (struct GNUNET_FS_SearchContext *sc,
     sr->h = sc->h;
     sr->sc = sc;
     sr->anonymity = sc->anonymity;
-    sr->uri = GNUNET_FS_uri_dup (uri);
+    sr->uri = GNUNET_FS_uri_intern (GNUNET_FS_uri_dup (uri));
     sr->meta = GNUNET_CONTAINER_meta_data_duplicate (meta);
     sr->mandatory_missing = sc->mandatory_count;
     sr->key = key;
@@ -695,7 +736,7 @@ process_sks_result (struct GNUNET_FS_SearchContext *sc,
   sr->h = sc->h;
   sr->sc = sc;
   sr->anonymity = sc->anonymity;
-  sr->uri = GNUNET_FS_uri_dup (uri);
+  sr->uri = GNUNET_FS_uri_intern (GNUNET_FS_uri_dup (uri));
   sr->meta = GNUNET_CONTAINER_meta_data_duplicate (meta);
   sr->key = key;
   GNUNET_CONTAINER_multihashmap_put (sc->master_result_map, &key, sr,
@@ -910,6 +951,8 @@ process_result (struct GNUNET_FS_SearchContext *sc,
 		const void *data,
                 size_t size)
 {
+  struct GNUNET_HashCode bh;
+
   if (GNUNET_TIME_absolute_get_duration (expiration).rel_value_us > 0)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
@@ -919,6 +962,19 @@ process_result (struct GNUNET_FS_SearchContext *sc,
   switch (type)
   {
   case GNUNET_BLOCK_TYPE_FS_UBLOCK:
+    GNUNET_CRYPTO_hash (data, size, &bh);
+    if (GNUNET_YES ==
+        GNUNET_CONTAINER_multihashmap_contains (sc->processed_blocks,
+                                                &bh))
+    {
+      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                  "Block already decrypted and processed, skipping it.\n");
+      return;
+    }
+    GNUNET_break (GNUNET_OK ==
+                  GNUNET_CONTAINER_multihashmap_put (sc->processed_blocks,
+                                                     &bh, NULL,
+                                                     GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST));
     if (GNUNET_FS_URI_SKS == sc->uri->type)
       process_sblock (sc, data, size);
     else
@@ -1325,11 +1381,13 @@ search_start (struct GNUNET_FS_Handle *h,
     psearch->update_search = sc;
   }
   sc->master_result_map = GNUNET_CONTAINER_multihashmap_create (16, GNUNET_NO);
+  sc->processed_blocks = GNUNET_CONTAINER_multihashmap_create (128, GNUNET_NO);
   sc->client_info = cctx;
   if (GNUNET_OK != GNUNET_FS_search_start_searching_ (sc))
   {
     GNUNET_FS_uri_destroy (sc->uri);
     GNUNET_CONTAINER_multihashmap_destroy (sc->master_result_map);
+    GNUNET_CONTAINER_multihashmap_destroy (sc->processed_blocks);
     GNUNET_free (sc);
     return NULL;
   }
@@ -1440,6 +1498,13 @@ search_result_freeze_probes (void *cls,
 {
   struct GNUNET_FS_SearchResult *sr = value;
 
+  if (GNUNET_YES == sr->probe_pending)
+  {
+    GNUNET_CONTAINER_DLL_remove (sr->h->pending_probes_head,
+                                 sr->h->pending_probes_tail,
+                                 sr);
+    sr->probe_pending = GNUNET_NO;
+  }
   if (NULL != sr->probe_ctx)
   {
     GNUNET_FS_download_stop (sr->probe_ctx, GNUNET_YES);
@@ -1556,6 +1621,7 @@ GNUNET_FS_search_signal_suspend_ (void *cls)
     sc->client = NULL;
   }
   GNUNET_CONTAINER_multihashmap_destroy (sc->master_result_map);
+  GNUNET_CONTAINER_multihashmap_destroy (sc->processed_blocks);
   if (NULL != sc->requests)
   {
     GNUNET_assert (GNUNET_FS_uri_test_ksk (sc->uri));
@@ -1773,6 +1839,7 @@ GNUNET_FS_search_stop (struct GNUNET_FS_SearchContext *sc)
   GNUNET_CONTAINER_multihashmap_iterate (sc->master_result_map,
                                          &search_result_free, sc);
   GNUNET_CONTAINER_multihashmap_destroy (sc->master_result_map);
+  GNUNET_CONTAINER_multihashmap_destroy (sc->processed_blocks);
   if (NULL != sc->requests)
   {
     GNUNET_assert (GNUNET_FS_uri_test_ksk (sc->uri));
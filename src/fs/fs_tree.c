@@ -144,6 +144,23 @@ GNUNET_FS_compute_depth (uint64_t flen)
 }
 
 
+/**
+ * Number of depths for which we memoize subtree sizes.  With a
+ * #DBLOCK_SIZE of 32k and 256 CHKs per inner node, subtree sizes
+ * overflow 64 bits well before this depth is reached, so the table
+ * covers all trees we can actually encode.
+ */
+#define TREE_SIZE_MEMO_DEPTH 16
+
+/**
+ * Memoized subtree sizes by depth; computed on first use.  The
+ * geometry functions below are called a few times for every block of
+ * every file, so we avoid redoing the multiplication loop each time.
+ * Entry 0 is #DBLOCK_SIZE and thus never zero once initialized.
+ */
+static uint64_t tree_size_memo[TREE_SIZE_MEMO_DEPTH];
+
+
 /**
  * Calculate how many bytes of payload a block tree of the given
  * depth MAY correspond to at most (this function ignores the fact that
@@ -159,9 +176,13 @@ GNUNET_FS_tree_compute_tree_size (unsigned int depth)
   uint64_t rsize;
   unsigned int i;
 
+  if ((depth < TREE_SIZE_MEMO_DEPTH) && (0 != tree_size_memo[depth]))
+    return tree_size_memo[depth];
   rsize = DBLOCK_SIZE;
   for (i = 0; i < depth; i++)
     rsize *= CHK_PER_INODE;
+  if (depth < TREE_SIZE_MEMO_DEPTH)
+    tree_size_memo[depth] = rsize;
   return rsize;
 }
 
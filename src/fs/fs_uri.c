@@ -647,6 +647,130 @@ GNUNET_FS_uri_parse (const char *uri,
 }
 
 
+/**
+ * Map from the hash of the canonical string form of interned URIs to
+ * the respective shared `struct GNUNET_FS_Uri` instance; NULL if no
+ * URIs are interned right now.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap *intern_map;
+
+
+/**
+ * Helper for qsort: compare two keywords.
+ */
+static int
+cmp_keyword (const void *a, const void *b)
+{
+  return strcmp (*(const char *const *) a, *(const char *const *) b);
+}
+
+
+/**
+ * Compute the key under which a URI is interned.  For KSK URIs the
+ * keywords are sorted first so that URIs that are equal according to
+ * #GNUNET_FS_uri_test_equal() (where keyword order does not matter)
+ * obtain the same key.
+ *
+ * @param uri URI to hash
+ * @param key set to the intern key
+ * @return #GNUNET_OK on success,
+ *         #GNUNET_SYSERR if @a uri cannot be represented
+ */
+static int
+uri_intern_key (const struct GNUNET_FS_Uri *uri,
+                struct GNUNET_HashCode *key)
+{
+  char *s;
+
+  if (GNUNET_FS_URI_KSK == uri->type)
+  {
+    const char **kw;
+    char *buf;
+    char *wptr;
+    size_t n;
+    unsigned int i;
+
+    if (0 == uri->data.ksk.keywordCount)
+    {
+      GNUNET_CRYPTO_hash ("", 0, key);
+      return GNUNET_OK;
+    }
+    kw = GNUNET_malloc (uri->data.ksk.keywordCount * sizeof (const char *));
+    n = 0;
+    for (i = 0; i < uri->data.ksk.keywordCount; i++)
+    {
+      kw[i] = uri->data.ksk.keywords[i];
+      n += strlen (kw[i]) + 1;
+    }
+    qsort (kw, uri->data.ksk.keywordCount, sizeof (const char *),
+           &cmp_keyword);
+    buf = GNUNET_malloc (n);
+    wptr = buf;
+    for (i = 0; i < uri->data.ksk.keywordCount; i++)
+    {
+      strcpy (wptr, kw[i]);
+      wptr += strlen (kw[i]);
+      *wptr++ = '\n';
+    }
+    GNUNET_CRYPTO_hash (buf, n, key);
+    GNUNET_free (buf);
+    GNUNET_free (kw);
+    return GNUNET_OK;
+  }
+  s = GNUNET_FS_uri_to_string (uri);
+  if (NULL == s)
+    return GNUNET_SYSERR;
+  GNUNET_CRYPTO_hash (s, strlen (s), key);
+  GNUNET_free (s);
+  return GNUNET_OK;
+}
+
+
+/**
+ * Intern a URI: if an equal URI has been interned before, return the
+ * existing shared instance (and free @a uri), otherwise register
+ * @a uri as the shared instance.  Interned URIs are reference
+ * counted; #GNUNET_FS_uri_dup() on them merely increments the
+ * counter and #GNUNET_FS_uri_destroy() decrements it.  They must
+ * not be modified by any holder of a reference.  Code that handles
+ * many duplicate URIs (i.e. search result processing) should intern
+ * them to share one representation; then equal URIs also compare
+ * equal as pointers.
+ *
+ * @param uri URI to intern (ownership is taken over)
+ * @return the shared instance (possibly @a uri itself)
+ */
+struct GNUNET_FS_Uri *
+GNUNET_FS_uri_intern (struct GNUNET_FS_Uri *uri)
+{
+  struct GNUNET_HashCode key;
+  struct GNUNET_FS_Uri *ret;
+
+  if (NULL == uri)
+    return NULL;
+  if (0 < uri->rc)
+    return uri;                 /* already interned */
+  if (GNUNET_OK != uri_intern_key (uri, &key))
+    return uri;                 /* not representable, keep private copy */
+  if (NULL == intern_map)
+    intern_map = GNUNET_CONTAINER_multihashmap_create (128, GNUNET_NO);
+  ret = GNUNET_CONTAINER_multihashmap_get (intern_map, &key);
+  if (NULL != ret)
+  {
+    if (GNUNET_YES != GNUNET_FS_uri_test_equal (ret, uri))
+      return uri;               /* hash collision, keep private copy */
+    ret->rc++;
+    GNUNET_FS_uri_destroy (uri);
+    return ret;
+  }
+  uri->rc = 1;
+  GNUNET_break (GNUNET_OK ==
+                GNUNET_CONTAINER_multihashmap_put (intern_map, &key, uri,
+                                                   GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+  return uri;
+}
+
+
 /**
  * Free URI.
  *
@@ -657,6 +781,22 @@ GNUNET_FS_uri_destroy (struct GNUNET_FS_Uri *uri)
 {
   unsigned int i;
 
+  if (0 < uri->rc)
+  {
+    struct GNUNET_HashCode key;
+
+    if (0 < --uri->rc)
+      return;                   /* interned URI, other references remain */
+    if (GNUNET_OK == uri_intern_key (uri, &key))
+      GNUNET_break (GNUNET_YES ==
+                    GNUNET_CONTAINER_multihashmap_remove (intern_map, &key,
+                                                          uri));
+    if (0 == GNUNET_CONTAINER_multihashmap_size (intern_map))
+    {
+      GNUNET_CONTAINER_multihashmap_destroy (intern_map);
+      intern_map = NULL;
+    }
+  }
   switch (uri->type)
   {
   case GNUNET_FS_URI_KSK:
@@ -977,6 +1117,14 @@ GNUNET_FS_uri_dup (const struct GNUNET_FS_Uri *uri)
 
   if (uri == NULL)
     return NULL;
+  if (0 < uri->rc)
+  {
+    /* interned URI, just take another reference (interned URIs are
+     * immutable, so sharing the representation is safe) */
+    ret = (struct GNUNET_FS_Uri *) uri;
+    ret->rc++;
+    return ret;
+  }
   ret = GNUNET_new (struct GNUNET_FS_Uri);
   memcpy (ret, uri, sizeof (struct GNUNET_FS_Uri));
   switch (ret->type)
@@ -1192,6 +1340,8 @@ GNUNET_FS_uri_test_equal (const struct GNUNET_FS_Uri *u1,
 
   GNUNET_assert (u1 != NULL);
   GNUNET_assert (u2 != NULL);
+  if (u1 == u2)
+    return GNUNET_YES;          /* common case for interned URIs */
   if (u1->type != u2->type)
     return GNUNET_NO;
   switch (u1->type)
@@ -28,11 +28,22 @@
  */
 #include "platform.h"
 #include "gnunet_util_lib.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
 
 #define MIN_FREQUENCY GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_HOURS, 4)
 
 #define MAX_FREQUENCY GNUNET_TIME_UNIT_MINUTES
 
+#ifdef __linux__
+/**
+ * How long do we wait after a change notification before re-scanning
+ * (to batch bursts of changes into one scan)?
+ */
+#define NOTIFY_DELAY GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS, 5)
+#endif
+
 
 /**
  * Item in our work queue (or in the set of files/directories
@@ -162,6 +173,29 @@ static struct GNUNET_DISK_PipeHandle *sigpipe;
  */
 static struct GNUNET_OS_Process *publish_proc;
 
+/**
+ * When is the next scan of #dir_name scheduled to run?
+ */
+static struct GNUNET_TIME_Absolute next_scan;
+
+#ifdef __linux__
+/**
+ * File descriptor for inotify, -1 if change notifications are
+ * unavailable (we then rely on the periodic scans alone).
+ */
+static int inotify_fd = -1;
+
+/**
+ * Scheduler handle wrapping #inotify_fd.
+ */
+static struct GNUNET_DISK_FileHandle *inotify_fh;
+
+/**
+ * Task waiting for change notifications on #inotify_fd.
+ */
+static struct GNUNET_SCHEDULER_Task *notify_task;
+#endif
+
 
 /**
  * Compute the name of the state database file we will use.
@@ -325,6 +359,19 @@ do_stop_task (void *cls,
 {
   kill_task = NULL;
   do_shutdown = GNUNET_YES;
+#ifdef __linux__
+  if (NULL != notify_task)
+  {
+    GNUNET_SCHEDULER_cancel (notify_task);
+    notify_task = NULL;
+  }
+  if (NULL != inotify_fh)
+  {
+    GNUNET_DISK_file_close (inotify_fh);
+    inotify_fh = NULL;
+    inotify_fd = -1;
+  }
+#endif
   if (NULL != publish_proc)
   {
     GNUNET_OS_process_kill (publish_proc, 
@@ -530,6 +577,28 @@ work (void *cls,
 }
 
 
+#ifdef __linux__
+/**
+ * Start watching the given directory for changes so that
+ * modifications trigger a prompt re-scan instead of waiting for the
+ * next periodic one.
+ *
+ * @param filename directory to watch
+ */
+static void
+watch_directory (const char *filename)
+{
+  if (-1 == inotify_fd)
+    return;
+  /* failures (i.e. hitting the kernel's watch limit) are harmless,
+     the periodic scan will still pick up changes eventually */
+  (void) inotify_add_watch (inotify_fd, filename,
+                            IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE |
+                            IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+}
+#endif
+
+
 /**
  * Recursively scan the given file/directory structure to determine
  * a unique ID that represents the current state of the hierarchy.
@@ -562,7 +631,7 @@ determine_id (void *cls,
     uint64_t fattr[2];
 
     fattr[0] = GNUNET_htonll (sbuf.st_size);
-    fattr[0] = GNUNET_htonll (sbuf.st_mtime);
+    fattr[1] = GNUNET_htonll (sbuf.st_mtime);
 
     GNUNET_CRYPTO_hash (fattr, 
 			sizeof (fattr), 
@@ -570,6 +639,9 @@ determine_id (void *cls,
   }
   else
   {
+#ifdef __linux__
+    watch_directory (filename);
+#endif
     memset (&fx[1],
 	    1,
 	    sizeof (struct GNUNET_HashCode));
@@ -689,18 +761,60 @@ schedule_next_task ()
 								     100));
     delay = GNUNET_TIME_relative_max (delay,
 				      MAX_FREQUENCY);
+    next_scan = GNUNET_TIME_relative_to_absolute (delay);
     run_task = GNUNET_SCHEDULER_add_delayed (delay,
 					     &scan,
 					     NULL);
   }
   else
   {
-    run_task = GNUNET_SCHEDULER_add_now (&work, 
+    run_task = GNUNET_SCHEDULER_add_now (&work,
 					 NULL);
   }
 }
 
 
+#ifdef __linux__
+/**
+ * Task run whenever the watched directory tree changed.  Drains the
+ * notification queue and moves the next scan up; the events only
+ * tell us that "something" changed, the scan determines the details.
+ *
+ * @param cls NULL
+ * @param tc scheduler context
+ */
+static void
+handle_notify (void *cls,
+	       const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct GNUNET_TIME_Absolute target;
+  char buf[4096];
+
+  notify_task = NULL;
+  if (0 == (tc->reason & GNUNET_SCHEDULER_REASON_READ_READY))
+    return; /* shutdown */
+  while (0 < read (inotify_fd, buf, sizeof (buf)))
+    ; /* drain all queued events */
+  target = GNUNET_TIME_relative_to_absolute (NOTIFY_DELAY);
+  if ( (NULL != run_task) &&
+       (NULL == work_head) &&
+       (next_scan.abs_value_us > target.abs_value_us) )
+  {
+    /* the next scan is (possibly hours) away, move it up */
+    GNUNET_SCHEDULER_cancel (run_task);
+    next_scan = target;
+    run_task = GNUNET_SCHEDULER_add_delayed (NOTIFY_DELAY,
+					     &scan,
+					     NULL);
+  }
+  notify_task =
+    GNUNET_SCHEDULER_add_read_file (GNUNET_TIME_UNIT_FOREVER_REL,
+				    inotify_fh,
+				    &handle_notify, NULL);
+}
+#endif
+
+
 /**
  * Main function that will be run by the scheduler.
  *
@@ -732,8 +846,25 @@ run (void *cls,
   work_finished = GNUNET_CONTAINER_multihashmap_create (1024, 
 							GNUNET_NO);
   load_state ();
+#ifdef __linux__
+  inotify_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+  if (-1 == inotify_fd)
+  {
+    GNUNET_log_strerror (GNUNET_ERROR_TYPE_INFO,
+			 "inotify_init1");
+  }
+  else
+  {
+    inotify_fh = GNUNET_DISK_get_handle_from_int_fd (inotify_fd);
+    watch_directory (dir_name);
+    notify_task =
+      GNUNET_SCHEDULER_add_read_file (GNUNET_TIME_UNIT_FOREVER_REL,
+				      inotify_fh,
+				      &handle_notify, NULL);
+  }
+#endif
   run_task = GNUNET_SCHEDULER_add_with_priority (GNUNET_SCHEDULER_PRIORITY_IDLE,
-						 &scan, 
+						 &scan,
 						 NULL);
   kill_task =
       GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_UNIT_FOREVER_REL, 
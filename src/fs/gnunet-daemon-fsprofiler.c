@@ -27,6 +27,7 @@
  * - how to signal driver that we're done?
  */
 #include "platform.h"
+#include <math.h>
 #include "gnunet_fs_service.h"
 #include "gnunet_statistics_service.h"
 
@@ -85,6 +86,13 @@ struct Pattern
    * Y-value.
    */
   unsigned long long y;
+
+  /**
+   * #GNUNET_YES if this is a warm-cache phase operation of the
+   * synthetic workload (affects under which histogram the latency
+   * is recorded).
+   */
+  int warm;
 };
 
 
@@ -162,6 +170,238 @@ static struct Pattern *download_head;
  */
 static struct Pattern *download_tail;
 
+/**
+ * Seed for the deterministic synthetic workload; the same seed (and
+ * configuration) reproduces the exact same sequence of operations.
+ */
+static unsigned long long workload_seed;
+
+/**
+ * Number of synthetic files this peer publishes (keywords
+ * "my_peerid * count .. my_peerid * count + count - 1", so peers
+ * jointly cover a catalog without coordination).
+ */
+static unsigned long long random_publish_count;
+
+/**
+ * Number of synthetic download operations per phase.
+ */
+static unsigned long long random_download_count;
+
+/**
+ * Number of passes over the generated download sequence; the first
+ * pass is the cold-cache phase, all further passes repeat the
+ * identical sequence against warm caches.
+ */
+static unsigned long long random_download_passes;
+
+/**
+ * Size of the keyword catalog the synthetic downloads draw from
+ * (should equal the total number of files published by all peers).
+ */
+static unsigned long long catalog_size;
+
+/**
+ * Smallest synthetic file size (bytes).
+ */
+static unsigned long long file_size_min;
+
+/**
+ * Largest synthetic file size (bytes).
+ */
+static unsigned long long file_size_max;
+
+/**
+ * Exponent 's' of the zipfian popularity distribution of the
+ * synthetic downloads.
+ */
+static float zipf_exponent;
+
+/**
+ * Time between the starts of two synthetic downloads.
+ */
+static struct GNUNET_TIME_Relative random_download_delay;
+
+/**
+ * Delay before the first synthetic download (to give the publish
+ * operations time to complete).
+ */
+static struct GNUNET_TIME_Relative cold_start_delay;
+
+/**
+ * State of the deterministic PRNG (xorshift64*) used for the
+ * synthetic workload; not cryptographic, but reproducible.
+ */
+static uint64_t prng_state;
+
+
+/**
+ * Compute the next value of the given deterministic PRNG state.
+ *
+ * @param state PRNG state to evolve (must never be zero)
+ * @return next pseudo-random 64-bit value
+ */
+static uint64_t
+prng_next (uint64_t *state)
+{
+  uint64_t x = *state;
+
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * UINT64_C (2685821657736338717);
+}
+
+
+/**
+ * Convert a PRNG value to a uniform double in [0,1).
+ *
+ * @param v pseudo-random 64-bit value
+ * @return value in [0,1)
+ */
+static double
+prng_to_unit (uint64_t v)
+{
+  return (double) (v >> 11) / 9007199254740992.0; /* 53 bit mantissa */
+}
+
+
+/**
+ * Compute the (deterministic) size of the synthetic file published
+ * under the given keyword value.  Publisher and downloader must
+ * agree on this value (the downloader uses it to recognize the right
+ * search result), so it only depends on @a kval and the configured
+ * size range, not on the workload seed.  Sizes are log-uniform in
+ * [#file_size_min, #file_size_max].
+ *
+ * @param kval keyword value of the file
+ * @return size of the file in bytes
+ */
+static uint64_t
+size_for_keyword (uint64_t kval)
+{
+  uint64_t s;
+  double u;
+
+  s = kval + UINT64_C (0x9E3779B97F4A7C15); /* must not be zero */
+  (void) prng_next (&s);
+  u = prng_to_unit (prng_next (&s));
+  if (file_size_max <= file_size_min)
+    return file_size_min;
+  return (uint64_t) ((double) file_size_min *
+                     pow ((double) file_size_max / (double) file_size_min,
+                          u));
+}
+
+
+/**
+ * Draw a keyword value from the zipfian popularity distribution over
+ * the catalog (approximate inversion of the continuous CDF, which is
+ * plenty accurate for benchmarking purposes).
+ *
+ * @return keyword value in [0, #catalog_size)
+ */
+static uint64_t
+zipf_keyword ()
+{
+  double u;
+  double n = (double) catalog_size;
+  double x;
+
+  u = prng_to_unit (prng_next (&prng_state));
+  if (u < 1e-12)
+    u = 1e-12;
+  if (fabs (zipf_exponent - 1.0) < 1e-6)
+    x = pow (n, u);
+  else
+    x = pow (u * (pow (n, 1.0 - zipf_exponent) - 1.0) + 1.0,
+             1.0 / (1.0 - zipf_exponent));
+  if (x < 1.0)
+    x = 1.0;
+  if (x > n)
+    x = n;
+  return (uint64_t) x - 1;
+}
+
+
+/**
+ * Record the latency of a completed operation in a histogram
+ * published via statistics (buckets are powers of two milliseconds).
+ *
+ * @param op name of the operation (i.e. "download cold")
+ * @param latency observed latency
+ */
+static void
+record_latency (const char *op,
+                struct GNUNET_TIME_Relative latency)
+{
+  char name[128];
+  uint64_t ms;
+  uint64_t bucket;
+
+  ms = latency.rel_value_us / 1000LL;
+  bucket = 1;
+  while ((bucket < ms) && (bucket < (1LLU << 20)))
+    bucket <<= 1;
+  GNUNET_snprintf (name, sizeof (name),
+                   "# %s latency [<= %llu ms]",
+                   op,
+                   (unsigned long long) bucket);
+  GNUNET_STATISTICS_update (stats_handle, name, 1, GNUNET_NO);
+}
+
+
+/**
+ * Generate the synthetic workload (if configured): publish patterns
+ * for this peer's share of the catalog and a zipf-popularity
+ * download sequence that is executed once against cold caches and
+ * then repeated identically for each warm phase.
+ */
+static void
+generate_workload ()
+{
+  struct Pattern *p;
+  struct GNUNET_TIME_Relative off;
+  uint64_t *kvals;
+  unsigned long long i;
+  unsigned long long pass;
+  uint64_t kval;
+
+  prng_state = workload_seed + my_peerid;
+  if (0 == prng_state)
+    prng_state = 1;
+  for (i = 0; i < random_publish_count; i++)
+  {
+    kval = my_peerid * random_publish_count + i;
+    p = GNUNET_new (struct Pattern);
+    p->x = size_for_keyword (kval);
+    p->y = kval;
+    /* spread the publish operations out a bit */
+    p->delay = GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MILLISECONDS,
+                                              10 * i);
+    GNUNET_CONTAINER_DLL_insert (publish_head, publish_tail, p);
+  }
+  if ((0 == random_download_count) || (0 == catalog_size))
+    return;
+  kvals = GNUNET_malloc (random_download_count * sizeof (uint64_t));
+  for (i = 0; i < random_download_count; i++)
+    kvals[i] = zipf_keyword ();
+  off = cold_start_delay;
+  for (pass = 0; pass < random_download_passes; pass++)
+    for (i = 0; i < random_download_count; i++)
+    {
+      p = GNUNET_new (struct Pattern);
+      p->x = kvals[i];
+      p->y = size_for_keyword (kvals[i]);
+      p->warm = (0 == pass) ? GNUNET_NO : GNUNET_YES;
+      p->delay = off;
+      off = GNUNET_TIME_relative_add (off, random_download_delay);
+      GNUNET_CONTAINER_DLL_insert (download_head, download_tail, p);
+    }
+  GNUNET_free (kvals);
+}
+
 
 /**
  * Parse a pattern string and store the corresponding
@@ -402,6 +642,8 @@ progress_cb (void *cls,
 			      "# publishing time (ms)",
 			      (long long) GNUNET_TIME_absolute_get_duration (p->start_time).rel_value_us / 1000LL,
 			      GNUNET_NO);
+    record_latency ("publish",
+		    GNUNET_TIME_absolute_get_duration (p->start_time));
     p->task = GNUNET_SCHEDULER_add_now (&publish_stop_task, p);
     return p;
   case GNUNET_FS_STATUS_PUBLISH_STOPPED:
@@ -430,6 +672,10 @@ progress_cb (void *cls,
 			      "# download time (ms)",
 			      (long long) GNUNET_TIME_absolute_get_duration (p->start_time).rel_value_us / 1000LL,
 			      GNUNET_NO);
+    record_latency ((GNUNET_YES == p->warm)
+		    ? "download (warm)"
+		    : "download (cold)",
+		    GNUNET_TIME_absolute_get_duration (p->start_time));
     p->task = GNUNET_SCHEDULER_add_now (&download_stop_task, p);
     return p;
   case GNUNET_FS_STATUS_DOWNLOAD_STOPPED:
@@ -456,6 +702,10 @@ progress_cb (void *cls,
 			      "# search time (ms)",
 			      (long long) GNUNET_TIME_absolute_get_duration (p->start_time).rel_value_us / 1000LL,
 			      GNUNET_NO);
+    record_latency ((GNUNET_YES == p->warm)
+		    ? "search (warm)"
+		    : "search (cold)",
+		    GNUNET_TIME_absolute_get_duration (p->start_time));
     p->start_time = GNUNET_TIME_absolute_get ();
     p->ctx = GNUNET_FS_download_start (fs_handle, uri,
 				       NULL, NULL, NULL,
@@ -586,6 +836,56 @@ run (void *cls, char *const *args GNUNET_UNUSED,
 					     "FSPROFILER", "REPLICATION_LEVEL",
                                              &replication_level))
     replication_level = 1;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (cfg,
+					     "FSPROFILER", "SEED",
+                                             &workload_seed))
+    workload_seed = 42;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (cfg,
+					     "FSPROFILER", "RANDOM-PUBLISH-COUNT",
+                                             &random_publish_count))
+    random_publish_count = 0;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (cfg,
+					     "FSPROFILER", "RANDOM-DOWNLOAD-COUNT",
+                                             &random_download_count))
+    random_download_count = 0;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (cfg,
+					     "FSPROFILER", "RANDOM-DOWNLOAD-PASSES",
+                                             &random_download_passes))
+    random_download_passes = 1;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (cfg,
+					     "FSPROFILER", "RANDOM-CATALOG-SIZE",
+                                             &catalog_size))
+    catalog_size = random_publish_count;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (cfg,
+					     "FSPROFILER", "FILE-SIZE-MIN",
+                                             &file_size_min))
+    file_size_min = 1024;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (cfg,
+					     "FSPROFILER", "FILE-SIZE-MAX",
+                                             &file_size_max))
+    file_size_max = 1024 * 1024;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_float (cfg,
+					    "FSPROFILER", "ZIPF-EXPONENT",
+                                            &zipf_exponent))
+    zipf_exponent = 1.0;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_time (cfg,
+					   "FSPROFILER", "RANDOM-DOWNLOAD-DELAY",
+                                           &random_download_delay))
+    random_download_delay = GNUNET_TIME_UNIT_SECONDS;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_time (cfg,
+					   "FSPROFILER", "COLD-START-DELAY",
+                                           &cold_start_delay))
+    cold_start_delay = GNUNET_TIME_UNIT_MINUTES;
   GNUNET_snprintf (myoptname, sizeof (myoptname),
 		   "DOWNLOAD-PATTERN-%u", my_peerid);
   if (GNUNET_OK !=
@@ -612,6 +912,7 @@ run (void *cls, char *const *args GNUNET_UNUSED,
     GNUNET_SCHEDULER_shutdown ();
     return;
   }
+  generate_workload ();
 
   stats_handle = GNUNET_STATISTICS_create ("fsprofiler", cfg);
   fs_handle =
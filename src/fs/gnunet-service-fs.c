@@ -445,17 +445,16 @@ start_p2p_processing (void *cls,
 
 
 /**
- * Handle #GNUNET_MESSAGE_TYPE_FS_START_SEARCH-message (search request
- * from client).
+ * Start a client search using the full pending request machinery
+ * (creation of a `struct GSF_PendingRequest`, local lookup and
+ * eventually planning for P2P processing).
  *
- * @param cls closure
  * @param client identification of the client
- * @param message the actual message
+ * @param message the search request
  */
 static void
-handle_start_search (void *cls,
-                     struct GNUNET_SERVER_Client *client,
-                     const struct GNUNET_MessageHeader *message)
+start_local_query (struct GNUNET_SERVER_Client *client,
+                   const struct GNUNET_MessageHeader *message)
 {
   struct GSF_PendingRequest *pr;
   int ret;
@@ -486,6 +485,258 @@ handle_start_search (void *cls,
 }
 
 
+/**
+ * Context for a datastore probe issued for a client search before we
+ * commit to creating a full `struct GSF_PendingRequest`.  Downloads
+ * of locally available content (the common case for locally published
+ * files) are answered directly from the probe result and never touch
+ * the plan or peer machinery.
+ */
+struct QueryProbeContext
+{
+
+  /**
+   * This is a doubly-linked list.
+   */
+  struct QueryProbeContext *next;
+
+  /**
+   * This is a doubly-linked list.
+   */
+  struct QueryProbeContext *prev;
+
+  /**
+   * Client that issued the search (reference kept).
+   */
+  struct GNUNET_SERVER_Client *client;
+
+  /**
+   * Copy of the original search request, needed to fall back to
+   * #start_local_query() if the probe does not yield the answer.
+   * Points into the same allocation as this struct.
+   */
+  struct SearchMessage *sm;
+
+  /**
+   * Handle for the datastore request, NULL while the datum processor
+   * runs.
+   */
+  struct GNUNET_DATASTORE_QueueEntry *qe;
+
+};
+
+
+/**
+ * Head of linked list of active datastore probes.
+ */
+static struct QueryProbeContext *qpc_head;
+
+/**
+ * Tail of linked list of active datastore probes.
+ */
+static struct QueryProbeContext *qpc_tail;
+
+
+/**
+ * Free resources of a datastore probe and release the client
+ * reference.  Does not cancel a pending datastore request.
+ *
+ * @param qpc probe to free
+ */
+static void
+free_query_probe (struct QueryProbeContext *qpc)
+{
+  GNUNET_CONTAINER_DLL_remove (qpc_head,
+                               qpc_tail,
+                               qpc);
+  GNUNET_SERVER_client_drop (qpc->client);
+  GNUNET_free (qpc);
+}
+
+
+/**
+ * Process the result of a datastore probe for a client search.  If
+ * the datastore held the (unique) answer, transmit it to the client
+ * directly; otherwise fall back to the full request machinery.
+ *
+ * @param cls our `struct QueryProbeContext *`
+ * @param key key of the result, NULL if the datastore is empty for our query
+ * @param size number of bytes in @a data
+ * @param data the result data
+ * @param type type of the result
+ * @param priority priority of the result
+ * @param anonymity anonymity level of the result
+ * @param expiration when does the result expire?
+ * @param uid unique identifier of the result
+ */
+static void
+probe_proc (void *cls,
+            const struct GNUNET_HashCode *key,
+            size_t size,
+            const void *data,
+            enum GNUNET_BLOCK_Type type,
+            uint32_t priority,
+            uint32_t anonymity,
+            struct GNUNET_TIME_Absolute expiration,
+            uint64_t uid)
+{
+  struct QueryProbeContext *qpc = cls;
+  struct GSF_LocalClient *lc;
+  struct ClientPutMessage *pm;
+  size_t msize;
+
+  qpc->qe = NULL;
+  if (GNUNET_BLOCK_TYPE_FS_ONDEMAND == type)
+  {
+    if (GNUNET_OK ==
+        GNUNET_FS_handle_on_demand_block (key,
+                                          size,
+                                          data,
+                                          type,
+                                          priority,
+                                          anonymity,
+                                          expiration,
+                                          uid,
+                                          &probe_proc,
+                                          qpc))
+      return; /* calls us again with the decoded DBLOCK */
+    key = NULL; /* decoding failed, count as miss */
+  }
+  if ( (NULL == key) ||
+       (ntohl (qpc->sm->type) != type) )
+  {
+    /* miss (or unusable result); take the expensive path, which will
+       also handle replication from other peers */
+    start_local_query (qpc->client,
+                       &qpc->sm->header);
+    free_query_probe (qpc);
+    return;
+  }
+  GNUNET_STATISTICS_update (GSF_stats,
+                            gettext_noop
+                            ("# client searches satisfied by datastore probe"),
+                            1,
+                            GNUNET_NO);
+  lc = GSF_local_client_lookup_ (qpc->client);
+  msize = sizeof (struct ClientPutMessage) + size;
+  {
+    char buf[msize] GNUNET_ALIGN;
+
+    pm = (struct ClientPutMessage *) buf;
+    pm->header.type = htons (GNUNET_MESSAGE_TYPE_FS_PUT);
+    pm->header.size = htons (msize);
+    pm->type = htonl (type);
+    pm->expiration = GNUNET_TIME_absolute_hton (expiration);
+    pm->last_transmission = GNUNET_TIME_absolute_hton (GNUNET_TIME_UNIT_FOREVER_ABS);
+    pm->num_transmissions = htonl (0);
+    pm->respect_offered = htonl (0);
+    memcpy (&pm[1], data, size);
+    GSF_local_client_transmit_ (lc, &pm->header);
+  }
+  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+              "Answered query `%s' from datastore probe\n",
+              GNUNET_h2s (key));
+  GNUNET_SERVER_receive_done (qpc->client,
+                              GNUNET_OK);
+  free_query_probe (qpc);
+}
+
+
+/**
+ * A client disconnected from us.  Cancel datastore probes that are
+ * still running on its behalf.
+ *
+ * @param cls closure (NULL)
+ * @param client handle of the client
+ */
+static void
+probe_client_disconnect_handler (void *cls,
+                                 struct GNUNET_SERVER_Client *client)
+{
+  struct QueryProbeContext *qpc;
+  struct QueryProbeContext *nxt;
+
+  if (NULL == client)
+    return;
+  nxt = qpc_head;
+  while (NULL != (qpc = nxt))
+  {
+    nxt = qpc->next;
+    if (qpc->client != client)
+      continue;
+    if (NULL != qpc->qe)
+    {
+      GNUNET_DATASTORE_cancel (qpc->qe);
+      qpc->qe = NULL;
+    }
+    free_query_probe (qpc);
+  }
+}
+
+
+/**
+ * Handle #GNUNET_MESSAGE_TYPE_FS_START_SEARCH-message (search request
+ * from client).  DBLOCK and IBLOCK queries have at most one answer;
+ * for those we first probe the datastore and only instantiate the
+ * full request machinery if the probe comes up empty.  This way,
+ * downloads of locally available content run at disk speed.
+ *
+ * @param cls closure
+ * @param client identification of the client
+ * @param message the actual message
+ */
+static void
+handle_start_search (void *cls,
+                     struct GNUNET_SERVER_Client *client,
+                     const struct GNUNET_MessageHeader *message)
+{
+  const struct SearchMessage *sm;
+  struct QueryProbeContext *qpc;
+  enum GNUNET_BLOCK_Type type;
+
+  if ( (NULL != GSF_dsh) &&
+       (sizeof (struct SearchMessage) == ntohs (message->size)) )
+  {
+    sm = (const struct SearchMessage *) message;
+    type = ntohl (sm->type);
+    if ( (GNUNET_BLOCK_TYPE_FS_DBLOCK == type) ||
+         (GNUNET_BLOCK_TYPE_FS_IBLOCK == type) )
+    {
+#if INSANE_STATISTICS
+      GNUNET_STATISTICS_update (GSF_stats,
+                                gettext_noop ("# datastore probes initiated"),
+                                1,
+                                GNUNET_NO);
+#endif
+      qpc = GNUNET_malloc (sizeof (struct QueryProbeContext) +
+                           sizeof (struct SearchMessage));
+      qpc->sm = (struct SearchMessage *) &qpc[1];
+      memcpy (qpc->sm, sm, sizeof (struct SearchMessage));
+      qpc->client = client;
+      GNUNET_SERVER_client_keep (client);
+      GNUNET_CONTAINER_DLL_insert (qpc_head,
+                                   qpc_tail,
+                                   qpc);
+      qpc->qe = GNUNET_DATASTORE_get_key (GSF_dsh, 0,
+                                          &qpc->sm->query,
+                                          (GNUNET_BLOCK_TYPE_FS_DBLOCK == type)
+                                          ? GNUNET_BLOCK_TYPE_ANY /* to find ONDEMAND */
+                                          : type,
+                                          UINT_MAX /* queue priority */ ,
+                                          UINT_MAX /* max queue size */ ,
+                                          GNUNET_TIME_UNIT_FOREVER_REL,
+                                          &probe_proc, qpc);
+      if (NULL != qpc->qe)
+        return;
+      /* datastore unavailable, fall back immediately */
+      free_query_probe (qpc);
+    }
+  }
+  start_local_query (client,
+                     message);
+}
+
+
 /**
  * Handle request to sign a LOC URI (from client).
  *
@@ -551,6 +802,19 @@ shutdown_task (void *cls,
   }
   GSF_put_done_ ();
   GSF_push_done_ ();
+  {
+    struct QueryProbeContext *qpc;
+
+    while (NULL != (qpc = qpc_head))
+    {
+      if (NULL != qpc->qe)
+      {
+        GNUNET_DATASTORE_cancel (qpc->qe);
+        qpc->qe = NULL;
+      }
+      free_query_probe (qpc);
+    }
+  }
   GSF_pending_request_done_ ();
   GSF_plan_done ();
   GSF_connected_peer_done_ ();
@@ -761,6 +1025,8 @@ main_init (struct GNUNET_SERVER_Handle *server,
   }
   GNUNET_SERVER_disconnect_notify (server, &GSF_client_disconnect_handler_,
                                    NULL);
+  GNUNET_SERVER_disconnect_notify (server, &probe_client_disconnect_handler,
+                                   NULL);
   GNUNET_SERVER_add_handlers (server, handlers);
   cover_age_task =
       GNUNET_SCHEDULER_add_delayed (COVER_AGE_FREQUENCY, &age_cover_counters,
@@ -63,14 +63,9 @@ struct GSF_PeerTransmitHandle
 {
 
   /**
-   * Kept in a doubly-linked list.
-   */
-  struct GSF_PeerTransmitHandle *next;
-
-  /**
-   * Kept in a doubly-linked list.
+   * Node in the transmission heap of the respective peer.
    */
-  struct GSF_PeerTransmitHandle *prev;
+  struct GNUNET_CONTAINER_HeapNode *hn;
 
   /**
    * Time when this transmission request was issued.
@@ -212,15 +207,10 @@ struct GSF_ConnectedPeer
 
   /**
    * Messages (replies, queries, content migration) we would like to
-   * send to this peer in the near future.  Sorted by priority, head.
-   */
-  struct GSF_PeerTransmitHandle *pth_head;
-
-  /**
-   * Messages (replies, queries, content migration) we would like to
-   * send to this peer in the near future.  Sorted by priority, tail.
+   * send to this peer in the near future.  Heap with the message of
+   * the highest priority (ties broken by earliest timeout) on top.
    */
-  struct GSF_PeerTransmitHandle *pth_tail;
+  struct GNUNET_CONTAINER_Heap *pth_heap;
 
   /**
    * Messages (replies, queries, content migration) we would like to
@@ -400,6 +390,27 @@ ats_reserve_callback (void *cls,
                       struct GNUNET_TIME_Relative res_delay);
 
 
+/**
+ * Compute the heap cost for the given transmission handle such
+ * that a maximum-heap yields the message with the highest priority
+ * and, among messages of equal priority, the earliest timeout.
+ *
+ * @param pth transmission handle to compute the cost for
+ * @return cost for the transmission heap
+ */
+static GNUNET_CONTAINER_HeapCostType
+pth_cost (const struct GSF_PeerTransmitHandle *pth)
+{
+  uint64_t deadline;
+
+  deadline = pth->timeout.abs_value_us / 1000LL / 1000LL;
+  if (deadline > UINT32_MAX)
+    deadline = UINT32_MAX;
+  return (((uint64_t) pth->priority) << 32) |
+      (UINT32_MAX - (uint32_t) deadline);
+}
+
+
 /**
  * If ready (bandwidth reserved), try to schedule transmission via
  * core for the given handle.
@@ -473,11 +484,12 @@ peer_transmit_ready_cb (void *cls,
                         void *buf)
 {
   struct GSF_ConnectedPeer *cp = cls;
-  struct GSF_PeerTransmitHandle *pth = cp->pth_head;
+  struct GSF_PeerTransmitHandle *pth;
   struct GSF_PeerTransmitHandle *pos;
   size_t ret;
 
   cp->cth = NULL;
+  pth = GNUNET_CONTAINER_heap_peek (cp->pth_heap);
   if (NULL == pth)
     return 0;
   if (pth->size > size)
@@ -490,9 +502,8 @@ peer_transmit_ready_cb (void *cls,
     GNUNET_SCHEDULER_cancel (pth->timeout_task);
     pth->timeout_task = NULL;
   }
-  GNUNET_CONTAINER_DLL_remove (cp->pth_head,
-                               cp->pth_tail,
-                               pth);
+  GNUNET_assert (pth == GNUNET_CONTAINER_heap_remove_root (cp->pth_heap));
+  pth->hn = NULL;
   if (GNUNET_YES == pth->is_query)
   {
     cp->ppd.last_request_times[(cp->last_request_times_off++) %
@@ -508,7 +519,7 @@ peer_transmit_ready_cb (void *cls,
                       GNUNET_TIME_absolute_get_duration
                       (pth->transmission_request_start_time).rel_value_us);
   ret = pth->gmc (pth->gmc_cls, size, buf);
-  if (NULL != (pos = cp->pth_head))
+  if (NULL != (pos = GNUNET_CONTAINER_heap_peek (cp->pth_heap)))
   {
     GNUNET_assert (pos != pth);
     schedule_transmission (pos);
@@ -574,7 +585,7 @@ ats_reserve_callback (void *cls,
     return;
   }
   cp->did_reserve = GNUNET_YES;
-  pth = cp->pth_head;
+  pth = GNUNET_CONTAINER_heap_peek (cp->pth_heap);
   if ( (NULL != pth) &&
        (NULL == cp->cth) &&
        (0 == cp->cth_in_progress) )
@@ -643,6 +654,7 @@ GSF_peer_connect_handler_ (const struct GNUNET_PeerIdentity *peer,
   cp = GNUNET_new (struct GSF_ConnectedPeer);
   cp->ppd.pid = GNUNET_PEER_intern (peer);
   cp->ppd.transmission_delay = GNUNET_LOAD_value_init (GNUNET_TIME_UNIT_ZERO);
+  cp->pth_heap = GNUNET_CONTAINER_heap_create (GNUNET_CONTAINER_HEAP_ORDER_MAX);
   cp->rc =
       GNUNET_ATS_reserve_bandwidth (GSF_ats,
                                     peer,
@@ -1503,9 +1515,8 @@ peer_transmit_timeout (void *cls,
               "Timeout trying to transmit to other peer\n");
   pth->timeout_task = NULL;
   cp = pth->cp;
-  GNUNET_CONTAINER_DLL_remove (cp->pth_head,
-                               cp->pth_tail,
-                               pth);
+  GNUNET_CONTAINER_heap_remove_node (pth->hn);
+  pth->hn = NULL;
   if (GNUNET_YES == pth->is_query)
     GNUNET_assert (0 < cp->ppd.pending_queries--);
   else if (GNUNET_NO == pth->is_query)
@@ -1546,8 +1557,6 @@ GSF_peer_transmit_ (struct GSF_ConnectedPeer *cp,
                     GSF_GetMessageCallback gmc, void *gmc_cls)
 {
   struct GSF_PeerTransmitHandle *pth;
-  struct GSF_PeerTransmitHandle *pos;
-  struct GSF_PeerTransmitHandle *prev;
 
   pth = GNUNET_new (struct GSF_PeerTransmitHandle);
   pth->transmission_request_start_time = GNUNET_TIME_absolute_get ();
@@ -1558,18 +1567,9 @@ GSF_peer_transmit_ (struct GSF_ConnectedPeer *cp,
   pth->is_query = is_query;
   pth->priority = priority;
   pth->cp = cp;
-  /* insertion sort (by priority, descending) */
-  prev = NULL;
-  pos = cp->pth_head;
-  while ((NULL != pos) && (pos->priority > priority))
-  {
-    prev = pos;
-    pos = pos->next;
-  }
-  GNUNET_CONTAINER_DLL_insert_after (cp->pth_head,
-                                     cp->pth_tail,
-                                     prev,
-                                     pth);
+  pth->hn = GNUNET_CONTAINER_heap_insert (cp->pth_heap,
+                                          pth,
+                                          pth_cost (pth));
   if (GNUNET_YES == is_query)
     cp->ppd.pending_queries++;
   else if (GNUNET_NO == is_query)
@@ -1599,9 +1599,8 @@ GSF_peer_transmit_cancel_ (struct GSF_PeerTransmitHandle *pth)
     pth->timeout_task = NULL;
   }
   cp = pth->cp;
-  GNUNET_CONTAINER_DLL_remove (cp->pth_head,
-                               cp->pth_tail,
-                               pth);
+  GNUNET_CONTAINER_heap_remove_node (pth->hn);
+  pth->hn = NULL;
   if (GNUNET_YES == pth->is_query)
     GNUNET_assert (0 < cp->ppd.pending_queries--);
   else if (GNUNET_NO == pth->is_query)
@@ -1765,16 +1764,14 @@ GSF_peer_disconnect_handler_ (void *cls,
     cp->cth = NULL;
   }
   GNUNET_assert (0 == cp->cth_in_progress);
-  while (NULL != (pth = cp->pth_head))
+  while (NULL != (pth = GNUNET_CONTAINER_heap_remove_root (cp->pth_heap)))
   {
+    pth->hn = NULL;
     if (pth->timeout_task != NULL)
     {
       GNUNET_SCHEDULER_cancel (pth->timeout_task);
       pth->timeout_task = NULL;
     }
-    GNUNET_CONTAINER_DLL_remove (cp->pth_head,
-                                 cp->pth_tail,
-                                 pth);
     if (GNUNET_YES == pth->is_query)
       GNUNET_assert (0 < cp->ppd.pending_queries--);
     else if (GNUNET_NO == pth->is_query)
@@ -1782,6 +1779,8 @@ GSF_peer_disconnect_handler_ (void *cls,
     pth->gmc (pth->gmc_cls, 0, NULL);
     GNUNET_free (pth);
   }
+  GNUNET_CONTAINER_heap_destroy (cp->pth_heap);
+  cp->pth_heap = NULL;
   while (NULL != (dh = cp->delayed_head))
   {
     GNUNET_CONTAINER_DLL_remove (cp->delayed_head,
@@ -35,6 +35,18 @@
 #include "gnunet-service-fs_indexing.h"
 #include "fs.h"
 
+/**
+ * Maximum number of file handles we keep open for serving
+ * on-demand blocks from indexed files.
+ */
+#define MAX_OPEN_HANDLES 16
+
+/**
+ * How much data do we ask the kernel to read ahead when we detect
+ * sequential access to an indexed file?
+ */
+#define READAHEAD_WINDOW (8 * DBLOCK_SIZE)
+
 /**
  * In-memory information about indexed files (also available
  * on-disk).
@@ -69,6 +81,30 @@ struct IndexInfo
    */
   struct GNUNET_CRYPTO_FileHashContext *fhc;
 
+  /**
+   * Open file handle for serving on-demand blocks from this file,
+   * or NULL if the file is not currently open.  While non-NULL,
+   * this entry is kept in the LRU list.
+   */
+  struct GNUNET_DISK_FileHandle *fh;
+
+  /**
+   * MDLL of indexed files with an open file handle, in LRU order
+   * (head is most recently used).
+   */
+  struct IndexInfo *next_lru;
+
+  /**
+   * MDLL of indexed files with an open file handle, in LRU order.
+   */
+  struct IndexInfo *prev_lru;
+
+  /**
+   * Offset right after the last on-demand block we served from
+   * this file; used to detect sequential access for readahead.
+   */
+  uint64_t next_offset;
+
   /**
    * Hash of the contents of the file.
    */
@@ -94,6 +130,22 @@ static struct IndexInfo *indexed_files_tail;
  */
 static struct GNUNET_CONTAINER_MultiHashMap *ifm;
 
+/**
+ * Head of LRU list of indexed files with open file handles
+ * (most recently used first).
+ */
+static struct IndexInfo *lru_head;
+
+/**
+ * Tail of LRU list of indexed files with open file handles.
+ */
+static struct IndexInfo *lru_tail;
+
+/**
+ * Number of entries in the LRU list (number of open file handles).
+ */
+static unsigned int open_handle_count;
+
 /**
  * Our configuration.
  */
@@ -106,6 +158,24 @@ static const struct GNUNET_CONFIGURATION_Handle *cfg;
 static struct GNUNET_DATASTORE_Handle *dsh;
 
 
+/**
+ * Close the cached file handle of the given index info entry (if
+ * open) and remove the entry from the LRU list.
+ *
+ * @param ii entry whose file handle should be closed
+ */
+static void
+close_handle (struct IndexInfo *ii)
+{
+  if (NULL == ii->fh)
+    return;
+  GNUNET_CONTAINER_MDLL_remove (lru, lru_head, lru_tail, ii);
+  GNUNET_DISK_file_close (ii->fh);
+  ii->fh = NULL;
+  open_handle_count--;
+}
+
+
 /**
  * Write the current index information list to disk.
  */
@@ -441,6 +511,7 @@ GNUNET_FS_handle_unindex (void *cls, struct GNUNET_SERVER_Client *client,
       GNUNET_break (GNUNET_OK ==
                     GNUNET_CONTAINER_multihashmap_remove (ifm, &pos->file_id,
 							  pos));
+      close_handle (pos);
       GNUNET_free (pos);
       found = GNUNET_YES;
       break;
@@ -515,7 +586,6 @@ GNUNET_FS_handle_on_demand_block (const struct GNUNET_HashCode * key, uint32_t s
   char ndata[DBLOCK_SIZE];
   char edata[DBLOCK_SIZE];
   const char *fn;
-  struct GNUNET_DISK_FileHandle *fh;
   uint64_t off;
   struct IndexInfo *ii;
 
@@ -535,35 +605,58 @@ GNUNET_FS_handle_on_demand_block (const struct GNUNET_HashCode * key, uint32_t s
     return GNUNET_SYSERR;
   }
   fn = ii->filename;
-  if ((NULL == fn) || (0 != ACCESS (fn, R_OK)))
+  if (NULL == ii->fh)
   {
-    GNUNET_STATISTICS_update (GSF_stats,
-                              gettext_noop
-                              ("# index blocks removed: original file inaccessible"),
-                              1, GNUNET_YES);
-    GNUNET_DATASTORE_remove (dsh, key, size, data, -1, -1,
-                             GNUNET_TIME_UNIT_FOREVER_REL, &remove_cont, NULL);
-    return GNUNET_SYSERR;
-  }
-  if ((NULL ==
-       (fh =
+    if ((NULL == fn) || (0 != ACCESS (fn, R_OK)))
+    {
+      GNUNET_STATISTICS_update (GSF_stats,
+                                gettext_noop
+                                ("# index blocks removed: original file inaccessible"),
+                                1, GNUNET_YES);
+      GNUNET_DATASTORE_remove (dsh, key, size, data, -1, -1,
+                               GNUNET_TIME_UNIT_FOREVER_REL, &remove_cont, NULL);
+      return GNUNET_SYSERR;
+    }
+    ii->fh =
         GNUNET_DISK_file_open (fn, GNUNET_DISK_OPEN_READ,
-                               GNUNET_DISK_PERM_NONE))) ||
-      (off != GNUNET_DISK_file_seek (fh, off, GNUNET_DISK_SEEK_SET)) ||
-      (-1 == (nsize = GNUNET_DISK_file_read (fh, ndata, sizeof (ndata)))))
+                               GNUNET_DISK_PERM_NONE);
+    if (NULL != ii->fh)
+    {
+      GNUNET_CONTAINER_MDLL_insert (lru, lru_head, lru_tail, ii);
+      open_handle_count++;
+      ii->next_offset = 0;
+      while (open_handle_count > MAX_OPEN_HANDLES)
+        close_handle (lru_tail);
+    }
+  }
+  else if (ii != lru_head)
+  {
+    /* mark as most recently used */
+    GNUNET_CONTAINER_MDLL_remove (lru, lru_head, lru_tail, ii);
+    GNUNET_CONTAINER_MDLL_insert (lru, lru_head, lru_tail, ii);
+  }
+  if ((NULL == ii->fh) ||
+      (off != GNUNET_DISK_file_seek (ii->fh, off, GNUNET_DISK_SEEK_SET)) ||
+      (-1 ==
+       (nsize = GNUNET_DISK_file_read (ii->fh, ndata, sizeof (ndata)))))
   {
     GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
                 _
                 ("Could not access indexed file `%s' (%s) at offset %llu: %s\n"),
                 GNUNET_h2s (&odb->file_id), fn, (unsigned long long) off,
                 (fn == NULL) ? _("not indexed") : STRERROR (errno));
-    if (fh != NULL)
-      GNUNET_DISK_file_close (fh);
+    close_handle (ii);
     GNUNET_DATASTORE_remove (dsh, key, size, data, -1, -1,
                              GNUNET_TIME_UNIT_FOREVER_REL, &remove_cont, NULL);
     return GNUNET_SYSERR;
   }
-  GNUNET_DISK_file_close (fh);
+#if !defined(WINDOWS) && defined(POSIX_FADV_WILLNEED)
+  if (off == ii->next_offset)
+    /* sequential access, ask the kernel to read ahead */
+    (void) posix_fadvise (ii->fh->fd, off + nsize, READAHEAD_WINDOW,
+                          POSIX_FADV_WILLNEED);
+#endif
+  ii->next_offset = off + nsize;
   GNUNET_CRYPTO_hash (ndata, nsize, &nkey);
   GNUNET_CRYPTO_hash_to_aes_key (&nkey, &skey, &iv);
   GNUNET_CRYPTO_symmetric_encrypt (ndata, nsize, &skey, &iv, edata);
@@ -603,6 +696,7 @@ GNUNET_FS_indexing_done ()
     GNUNET_break (GNUNET_OK ==
 		  GNUNET_CONTAINER_multihashmap_remove (ifm,
 							&pos->file_id, pos));
+    close_handle (pos);
     GNUNET_free (pos);
   }
   GNUNET_CONTAINER_multihashmap_destroy (ifm);
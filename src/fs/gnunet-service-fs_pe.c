@@ -202,6 +202,13 @@ struct PeerPlan
    * Current task for executing the plan.
    */
   struct GNUNET_SCHEDULER_Task *task;
+
+  /**
+   * Time when the task in @e task is scheduled to run; kept so
+   * that adding further plan entries does not need to cancel and
+   * re-schedule the task unless an earlier run is required.
+   */
+  struct GNUNET_TIME_Absolute task_run_at;
 };
 
 
@@ -269,11 +276,14 @@ plan (struct PeerPlan *pp,
 
   struct GSF_PendingRequestData *prd;
   struct GNUNET_TIME_Relative delay;
+  struct GNUNET_TIME_Absolute run_at;
 
   GNUNET_assert (rp->pp == pp);
+#if INSANE_STATISTICS
   GNUNET_STATISTICS_set (GSF_stats,
                          gettext_noop ("# average retransmission delay (ms)"),
                          total_delay * 1000LL / plan_count, GNUNET_NO);
+#endif
   prd = GSF_pending_request_get_data_ (rp->pe_head->pr);
 
   if (rp->transmission_counter < 8)
@@ -334,17 +344,27 @@ plan (struct PeerPlan *pp,
               GNUNET_h2s (&prd->query), rp->transmission_counter);
   GNUNET_assert (rp->hn == NULL);
   if (0 == GNUNET_TIME_absolute_get_remaining (rp->earliest_transmission).rel_value_us)
+  {
     rp->hn = GNUNET_CONTAINER_heap_insert (pp->priority_heap, rp, rp->priority);
+    run_at = GNUNET_TIME_UNIT_ZERO_ABS;
+  }
   else
+  {
     rp->hn =
         GNUNET_CONTAINER_heap_insert (pp->delay_heap, rp,
                                       rp->earliest_transmission.abs_value_us);
+    run_at = rp->earliest_transmission;
+  }
   GNUNET_assert (GNUNET_YES ==
                  GNUNET_CONTAINER_multihashmap_contains_value (pp->plan_map,
                                                                get_rp_key (rp),
                                                                rp));
+  if ( (NULL != pp->task) &&
+       (pp->task_run_at.abs_value_us <= run_at.abs_value_us) )
+    return;                     /* plan already scheduled to run early enough */
   if (NULL != pp->task)
     GNUNET_SCHEDULER_cancel (pp->task);
+  pp->task_run_at = GNUNET_TIME_UNIT_ZERO_ABS;
   pp->task = GNUNET_SCHEDULER_add_now (&schedule_peer_transmission, pp);
 #undef N
 }
@@ -408,6 +428,7 @@ transmit_message_callback (void *cls,
     if (NULL != pp->task)
       GNUNET_SCHEDULER_cancel (pp->task);
 
+    pp->task_run_at = GNUNET_TIME_UNIT_ZERO_ABS;
     pp->task = GNUNET_SCHEDULER_add_now (&schedule_peer_transmission, pp);
     GNUNET_STATISTICS_update (GSF_stats,
                               gettext_noop
@@ -420,6 +441,7 @@ transmit_message_callback (void *cls,
   {
     if (NULL != pp->task)
       GNUNET_SCHEDULER_cancel (pp->task);
+    pp->task_run_at = GNUNET_TIME_UNIT_ZERO_ABS;
     pp->task = GNUNET_SCHEDULER_add_now (&schedule_peer_transmission, pp);
     return 0;
   }
@@ -431,6 +453,7 @@ transmit_message_callback (void *cls,
     if (NULL != pp->task)
       GNUNET_SCHEDULER_cancel (pp->task);
     /* buffer to small (message changed), try again */
+    pp->task_run_at = GNUNET_TIME_UNIT_ZERO_ABS;
     pp->task = GNUNET_SCHEDULER_add_now (&schedule_peer_transmission, pp);
     return 0;
   }
@@ -505,6 +528,7 @@ schedule_peer_transmission (void *cls,
                            gettext_noop ("# delay heap timeout (ms)"),
                            delay.rel_value_us / 1000LL, GNUNET_NO);
 
+    pp->task_run_at = GNUNET_TIME_relative_to_absolute (delay);
     pp->task =
         GNUNET_SCHEDULER_add_delayed (delay,
                                       &schedule_peer_transmission,
@@ -609,6 +633,15 @@ merge_pr (void *cls,
                               GNUNET_NO);
 #endif
     rp->transmission_counter = 0;       /* reset */
+    if (NULL != rp->hn)
+    {
+      /* re-position the plan entry in the heaps so that the refreshed
+         request is considered for transmission promptly instead of
+         waiting out the backoff of the old (merged) requests */
+      GNUNET_CONTAINER_heap_remove_node (rp->hn);
+      rp->hn = NULL;
+      plan (rp->pp, rp);
+    }
   }
   return GNUNET_NO;
 }
@@ -240,6 +240,61 @@ static struct GNUNET_CONTAINER_Heap *requests_by_expiration_heap;
 static unsigned long long max_pending_requests = (32 * 1024);
 
 
+/**
+ * Task that purges expired requests; runs when the request at the
+ * top of #requests_by_expiration_heap is due, NULL if the heap is
+ * empty.
+ */
+static struct GNUNET_SCHEDULER_Task *expire_task;
+
+
+/**
+ * Purge requests whose TTL has expired from the front of the
+ * expiration heap and wait for the next one to become due.  As the
+ * heap is ordered by TTL, this only ever touches requests that are
+ * actually due, regardless of how many requests are pending overall.
+ *
+ * @param cls NULL
+ * @param tc scheduler context
+ */
+static void
+purge_expired_requests (void *cls,
+                        const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct GSF_PendingRequest *dpr;
+
+  expire_task = NULL;
+  while ((NULL !=
+          (dpr = GNUNET_CONTAINER_heap_peek (requests_by_expiration_heap))) &&
+         (0 ==
+          GNUNET_TIME_absolute_get_remaining (dpr->public_data.ttl).rel_value_us))
+  {
+    GNUNET_STATISTICS_update (GSF_stats,
+                              gettext_noop ("# Pending requests expired"), 1,
+                              GNUNET_NO);
+    if (NULL != dpr->rh)
+      dpr->rh (dpr->rh_cls,
+               GNUNET_BLOCK_EVALUATION_REQUEST_VALID,
+               dpr,
+               UINT32_MAX,
+               GNUNET_TIME_UNIT_FOREVER_ABS,
+               GNUNET_TIME_UNIT_FOREVER_ABS,
+               GNUNET_BLOCK_TYPE_ANY,
+               NULL,
+               0);
+    GSF_pending_request_cancel_ (dpr,
+                                 GNUNET_YES);
+  }
+  if (NULL ==
+      (dpr = GNUNET_CONTAINER_heap_peek (requests_by_expiration_heap)))
+    return;
+  expire_task =
+      GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_absolute_get_remaining
+                                    (dpr->public_data.ttl),
+                                    &purge_expired_requests,
+                                    NULL);
+}
+
 
 /**
  * Recalculate our bloom filter for filtering replies.  This function
@@ -406,6 +461,17 @@ GSF_pending_request_create_ (enum GSF_PendingRequestOptions options,
       GSF_pending_request_cancel_ (dpr,
                                    GNUNET_YES);
     }
+    if (pr == GNUNET_CONTAINER_heap_peek (requests_by_expiration_heap))
+    {
+      /* new earliest expiration, wake up the purge task sooner */
+      if (NULL != expire_task)
+        GNUNET_SCHEDULER_cancel (expire_task);
+      expire_task =
+          GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_absolute_get_remaining
+                                        (pr->public_data.ttl),
+                                        &purge_expired_requests,
+                                        NULL);
+    }
   }
   GNUNET_STATISTICS_update (GSF_stats,
                             gettext_noop ("# Pending requests active"), 1,
@@ -493,7 +559,7 @@ GSF_pending_request_update_ (struct GSF_PendingRequest *pr,
     }
     else
     {
-      for (i = 0; i < pr->replies_seen_count; i++)
+      for (i = 0; i < replies_seen_count; i++)
       {
         GNUNET_BLOCK_mingle_hash (&replies_seen[i],
                                   pr->mingle,
@@ -799,6 +865,17 @@ struct ProcessReplyClosure
    */
   enum GNUNET_BLOCK_EvaluationResult eval;
 
+  /**
+   * Hash of @e data; computed lazily for the first matching request
+   * and then shared by all further requests matched for this reply.
+   */
+  struct GNUNET_HashCode data_hash;
+
+  /**
+   * #GNUNET_YES if @e data_hash has been computed.
+   */
+  int data_hash_set;
+
   /**
    * Did we find a matching request?
    */
@@ -839,7 +916,6 @@ process_reply (void *cls,
 {
   struct ProcessReplyClosure *prq = cls;
   struct GSF_PendingRequest *pr = value;
-  struct GNUNET_HashCode chash;
   struct GNUNET_TIME_Absolute last_transmission;
 
   if (NULL == pr->rh)
@@ -915,11 +991,15 @@ process_reply (void *cls,
     return GNUNET_NO;
   }
   /* update bloomfilter */
-  GNUNET_CRYPTO_hash (prq->data,
-                      prq->size,
-                      &chash);
+  if (GNUNET_NO == prq->data_hash_set)
+  {
+    GNUNET_CRYPTO_hash (prq->data,
+                        prq->size,
+                        &prq->data_hash);
+    prq->data_hash_set = GNUNET_YES;
+  }
   GSF_pending_request_update_ (pr,
-                               &chash,
+                               &prq->data_hash,
                                1);
   if (NULL == prq->sender)
   {
@@ -1767,6 +1847,7 @@ GSF_handle_p2p_content_ (struct GSF_ConnectedPeer *cp,
   prq.expiration = expiration;
   prq.priority = 0;
   prq.anonymity_level = UINT32_MAX;
+  prq.data_hash_set = GNUNET_NO;
   prq.request_found = GNUNET_NO;
   prq.eo = GNUNET_BLOCK_EO_NONE;
   GNUNET_CONTAINER_multihashmap_get_multiple (pr_map,
@@ -1884,6 +1965,11 @@ GSF_pending_request_init_ ()
 void
 GSF_pending_request_done_ ()
 {
+  if (NULL != expire_task)
+  {
+    GNUNET_SCHEDULER_cancel (expire_task);
+    expire_task = NULL;
+  }
   GNUNET_CONTAINER_multihashmap_iterate (pr_map,
                                          &clean_request,
                                          NULL);
@@ -36,6 +36,13 @@
  */
 #define MAX_MIGRATION_QUEUE 8
 
+/**
+ * Maximum number of push messages we queue towards a single peer
+ * at the same time.  The actual number used per peer starts at one
+ * and adapts to how well the peer keeps up (see `batch_size`).
+ */
+#define MAX_MIGRATION_BATCH 4
+
 /**
  * Blocks are at most migrated to this number of peers
  * plus one, each time they are fetched from the database.
@@ -101,6 +108,29 @@ struct MigrationReadyBlock
 };
 
 
+/**
+ * Push message that has been prepared for a peer but not
+ * yet handed to core for transmission.
+ */
+struct MigrationReadyMessage
+{
+  /**
+   * This is a doubly-linked list.
+   */
+  struct MigrationReadyMessage *next;
+
+  /**
+   * This is a doubly-linked list.
+   */
+  struct MigrationReadyMessage *prev;
+
+  /**
+   * The actual message.
+   */
+  struct PutMessage *msg;
+};
+
+
 /**
  * Information about a peer waiting for
  * migratable data.
@@ -129,9 +159,29 @@ struct MigrationReadyPeer
   struct GSF_PeerTransmitHandle *th;
 
   /**
-   * Message we are trying to push right now (or NULL)
+   * Head of queue of messages we are trying to push to this peer.
    */
-  struct PutMessage *msg;
+  struct MigrationReadyMessage *msg_head;
+
+  /**
+   * Tail of queue of messages we are trying to push to this peer.
+   */
+  struct MigrationReadyMessage *msg_tail;
+
+  /**
+   * Number of messages in the queue.
+   */
+  unsigned int msg_count;
+
+  /**
+   * How many push messages may we queue for this peer right now?
+   * Starts at one, is increased for every successful transmission
+   * and halved when a transmission fails, so peers that accept our
+   * content get larger batches while peers that keep dropping them
+   * (or that we were asked to stop pushing to) start over
+   * cautiously.  Bounded by #MAX_MIGRATION_BATCH.
+   */
+  unsigned int batch_size;
 };
 
 
@@ -223,17 +273,25 @@ transmit_message (void *cls,
                   void *buf)
 {
   struct MigrationReadyPeer *peer = cls;
+  struct MigrationReadyMessage *mrm;
   struct PutMessage *msg;
   uint16_t msize;
 
   peer->th = NULL;
-  msg = peer->msg;
-  peer->msg = NULL;
+  mrm = peer->msg_head;
+  GNUNET_assert (NULL != mrm);
+  GNUNET_CONTAINER_DLL_remove (peer->msg_head,
+                               peer->msg_tail,
+                               mrm);
+  peer->msg_count--;
+  msg = mrm->msg;
+  GNUNET_free (mrm);
   if (NULL == buf)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                 "Failed to migrate content to another peer (disconnect)\n");
     GNUNET_free (msg);
+    peer->batch_size = GNUNET_MAX (1, peer->batch_size / 2);
     return 0;
   }
   msize = ntohs (msg->header.size);
@@ -244,6 +302,15 @@ transmit_message (void *cls,
               "Pushing %u bytes to %s\n",
               msize,
               GNUNET_i2s (GSF_connected_peer_get_identity2_(peer->peer)));
+  if (peer->batch_size < MAX_MIGRATION_BATCH)
+    peer->batch_size++;
+  if (NULL != peer->msg_head)
+    peer->th =
+        GSF_peer_transmit_ (peer->peer,
+                            GNUNET_NO, 0 /* priority */ ,
+                            GNUNET_TIME_UNIT_FOREVER_REL,
+                            ntohs (peer->msg_head->msg->header.size),
+                            &transmit_message, peer);
   find_content (peer);
   return msize;
 }
@@ -262,12 +329,12 @@ transmit_content (struct MigrationReadyPeer *peer,
 {
   size_t msize;
   struct PutMessage *msg;
+  struct MigrationReadyMessage *mrm;
   unsigned int i;
   struct GSF_PeerPerformanceData *ppd;
   int ret;
 
   ppd = GSF_get_peer_performance_data_ (peer->peer);
-  GNUNET_assert (NULL == peer->th);
   msize = sizeof (struct PutMessage) + block->size;
   msg = GNUNET_malloc (msize);
   msg->header.type = htons (GNUNET_MESSAGE_TYPE_FS_PUT);
@@ -275,7 +342,12 @@ transmit_content (struct MigrationReadyPeer *peer,
   msg->type = htonl (block->type);
   msg->expiration = GNUNET_TIME_absolute_hton (block->expiration);
   memcpy (&msg[1], &block[1], block->size);
-  peer->msg = msg;
+  mrm = GNUNET_new (struct MigrationReadyMessage);
+  mrm->msg = msg;
+  GNUNET_CONTAINER_DLL_insert_tail (peer->msg_head,
+                                    peer->msg_tail,
+                                    mrm);
+  peer->msg_count++;
   for (i = 0; i < MIGRATION_LIST_SIZE; i++)
   {
     if (block->target_list[i] == 0)
@@ -298,11 +370,12 @@ transmit_content (struct MigrationReadyPeer *peer,
               "Asking for transmission of %u bytes to %s for migration\n",
               msize,
               GNUNET_i2s (GSF_connected_peer_get_identity2_(peer->peer)));
-  peer->th = GSF_peer_transmit_ (peer->peer,
-                                 GNUNET_NO, 0 /* priority */ ,
-                                 GNUNET_TIME_UNIT_FOREVER_REL,
-                                 msize,
-                                 &transmit_message, peer);
+  if (NULL == peer->th)
+    peer->th = GSF_peer_transmit_ (peer->peer,
+                                   GNUNET_NO, 0 /* priority */ ,
+                                   GNUNET_TIME_UNIT_FOREVER_REL,
+                                   ntohs (peer->msg_head->msg->header.size),
+                                   &transmit_message, peer);
   return ret;
 }
 
@@ -378,52 +451,58 @@ find_content (struct MigrationReadyPeer *mrp)
   long best_score;
   struct MigrationReadyBlock *best;
 
-  GNUNET_assert (NULL == mrp->th);
-  best = NULL;
-  best_score = -1;
-  pos = mig_head;
-  while (NULL != pos)
+  while (mrp->msg_count < mrp->batch_size)
   {
-    score = score_content (mrp, pos);
-    if (score > best_score)
-    {
-      best_score = score;
-      best = pos;
-    }
-    pos = pos->next;
-  }
-  if (NULL == best)
-  {
-    if (mig_size < MAX_MIGRATION_QUEUE)
-    {
-      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                  "No content found for pushing, waiting for queue to fill\n");
-      return;                   /* will fill up eventually... */
-    }
-    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                "No suitable content found, purging content from full queue\n");
-    /* failed to find migration target AND
-     * queue is full, purge most-forwarded
-     * block from queue to make room for more */
+    best = NULL;
+    best_score = -1;
     pos = mig_head;
     while (NULL != pos)
     {
-      score = count_targets (pos);
-      if (score >= best_score)
+      score = score_content (mrp, pos);
+      if (score > best_score)
       {
         best_score = score;
         best = pos;
       }
       pos = pos->next;
     }
-    GNUNET_assert (NULL != best);
-    delete_migration_block (best);
-    consider_gathering ();
-    return;
+    if (NULL == best)
+    {
+      if (mig_size < MAX_MIGRATION_QUEUE)
+      {
+        GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                    "No content found for pushing, waiting for queue to fill\n");
+        consider_gathering ();
+        return;                 /* will fill up eventually... */
+      }
+      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                  "No suitable content found, purging content from full queue\n");
+      /* failed to find migration target AND
+       * queue is full, purge most-forwarded
+       * block from queue to make room for more */
+      pos = mig_head;
+      while (NULL != pos)
+      {
+        score = count_targets (pos);
+        if (score >= best_score)
+        {
+          best_score = score;
+          best = pos;
+        }
+        pos = pos->next;
+      }
+      GNUNET_assert (NULL != best);
+      delete_migration_block (best);
+      consider_gathering ();
+      return;
+    }
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "Preparing to push best content to peer\n");
+    transmit_content (mrp, best);
   }
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "Preparing to push best content to peer\n");
-  transmit_content (mrp, best);
+  /* batch for this peer is full; fetch the next candidates from the
+   * datastore while the transmissions are in flight */
+  consider_gathering ();
 }
 
 
@@ -551,7 +630,7 @@ process_migration_content (void *cls,
   mig_size++;
   for (pos = peer_head; NULL != pos; pos = pos->next)
   {
-    if (NULL == pos->th)
+    if (pos->msg_count < pos->batch_size)
     {
       GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                   "Preparing to push best content to peer %s\n",
@@ -622,6 +701,7 @@ GSF_push_start_ (struct GSF_ConnectedPeer *peer)
 
   mrp = GNUNET_new (struct MigrationReadyPeer);
   mrp->peer = peer;
+  mrp->batch_size = 1;
   find_content (mrp);
   GNUNET_CONTAINER_DLL_insert (peer_head,
                                peer_tail,
@@ -639,6 +719,7 @@ void
 GSF_push_stop_ (struct GSF_ConnectedPeer *peer)
 {
   struct MigrationReadyPeer *pos;
+  struct MigrationReadyMessage *mrm;
 
   for (pos = peer_head; NULL != pos; pos = pos->next)
     if (pos->peer == peer)
@@ -653,10 +734,13 @@ GSF_push_stop_ (struct GSF_ConnectedPeer *peer)
     GSF_peer_transmit_cancel_ (pos->th);
     pos->th = NULL;
   }
-  if (NULL != pos->msg)
+  while (NULL != (mrm = pos->msg_head))
   {
-    GNUNET_free (pos->msg);
-    pos->msg = NULL;
+    GNUNET_CONTAINER_DLL_remove (pos->msg_head,
+                                 pos->msg_tail,
+                                 mrm);
+    GNUNET_free (mrm->msg);
+    GNUNET_free (mrm);
   }
   GNUNET_free (pos);
 }
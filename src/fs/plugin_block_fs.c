@@ -215,6 +215,7 @@ libgnunet_plugin_block_fs_init (void *cls)
   api->evaluate = &block_plugin_fs_evaluate;
   api->get_key = &block_plugin_fs_get_key;
   api->types = types;
+  api->crypto_cacheable = GNUNET_YES;
   return api;
 }
 
@@ -45,11 +45,32 @@
  */
 #define FCFS_SUFFIX "fcfs.zkey.eu"
 
+/**
+ * How many inbound datagrams do we process at most per read task?
+ * Under query bursts this saves one scheduler round trip per packet.
+ */
+#define MAX_DNS_READS_PER_TASK 16
+
+/**
+ * Maximum number of entries we keep in the answer cache.
+ */
+#define MAX_CACHE_ENTRIES 1024
+
 /**
  * Data kept per request.
  */
 struct Request
 {
+  /**
+   * Kept in the DLL of requests waiting on the same `struct ActiveLookup`.
+   */
+  struct Request *next;
+
+  /**
+   * Kept in the DLL of requests waiting on the same `struct ActiveLookup`.
+   */
+  struct Request *prev;
+
   /**
    * Socket to use for sending the reply.
    */
@@ -67,9 +88,10 @@ struct Request
   struct GNUNET_DNSPARSER_Packet *packet;
 
   /**
-   * Our GNS request handle.
+   * GNS lookup we are waiting on, NULL if this is a legacy
+   * DNS request.
    */
-  struct GNUNET_GNS_LookupRequest *lookup;
+  struct ActiveLookup *al;
 
   /**
    * Our DNS request handle
@@ -90,6 +112,92 @@ struct Request
 };
 
 
+/**
+ * A GNS lookup that is in flight.  Requests for the same name and
+ * record type that arrive while the lookup is pending are collapsed
+ * into the same upstream lookup and queue up here.
+ */
+struct ActiveLookup
+{
+  /**
+   * Kept in a DLL.
+   */
+  struct ActiveLookup *next;
+
+  /**
+   * Kept in a DLL.
+   */
+  struct ActiveLookup *prev;
+
+  /**
+   * Hash over the lowercased name and the record type.
+   */
+  struct GNUNET_HashCode key;
+
+  /**
+   * Our GNS request handle.
+   */
+  struct GNUNET_GNS_LookupRequest *lookup;
+
+  /**
+   * Head of DLL of requests waiting for the result.
+   */
+  struct Request *rq_head;
+
+  /**
+   * Tail of DLL of requests waiting for the result.
+   */
+  struct Request *rq_tail;
+
+};
+
+
+/**
+ * Entry in the answer cache, mapping the hash over (lowercased) name
+ * and record type to the GNS record set we got, so that repeated
+ * queries for hot names do not re-enter GNS at all.
+ */
+struct CachedAnswer
+{
+  /**
+   * Kept in a DLL ordered by recency of use; head is most recent.
+   */
+  struct CachedAnswer *next;
+
+  /**
+   * Kept in a DLL ordered by recency of use; head is most recent.
+   */
+  struct CachedAnswer *prev;
+
+  /**
+   * Hash over the lowercased name and the record type; key in #cache_map.
+   */
+  struct GNUNET_HashCode key;
+
+  /**
+   * When does the first record of the set expire?  The entry must
+   * not be used afterwards.
+   */
+  struct GNUNET_TIME_Absolute expiration;
+
+  /**
+   * Serialized records.
+   */
+  char *rd_data;
+
+  /**
+   * Number of bytes in @e rd_data.
+   */
+  size_t rd_data_size;
+
+  /**
+   * Number of records in @e rd_data.
+   */
+  uint32_t rd_count;
+
+};
+
+
 /**
  * Handle to GNS resolver.
  */
@@ -165,6 +273,190 @@ static struct GNUNET_IDENTITY_Handle *identity;
  */
 static struct GNUNET_IDENTITY_Operation *id_op;
 
+/**
+ * Head of DLL of active GNS lookups.
+ */
+static struct ActiveLookup *al_head;
+
+/**
+ * Tail of DLL of active GNS lookups.
+ */
+static struct ActiveLookup *al_tail;
+
+/**
+ * Map from lookup key to `struct CachedAnswer` entries.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap *cache_map;
+
+/**
+ * Head of DLL of cached answers, most recently used first.
+ */
+static struct CachedAnswer *cache_head;
+
+/**
+ * Tail of DLL of cached answers, least recently used last.
+ */
+static struct CachedAnswer *cache_tail;
+
+
+/**
+ * Compute the key for the answer cache and lookup deduplication from
+ * the name and the requested record type.  DNS names are
+ * case-insensitive (and some clients randomize the case), so we hash
+ * over the lowercased name.
+ *
+ * @param name name that is being looked up
+ * @param type requested record type
+ * @param key set to the lookup key
+ */
+static void
+compute_lookup_key (const char *name,
+		    int type,
+		    struct GNUNET_HashCode *key)
+{
+  size_t name_len = strlen (name);
+  uint32_t nbo_type = htonl ((uint32_t) type);
+  char key_material[sizeof (nbo_type) + name_len];
+  size_t i;
+
+  memcpy (key_material, &nbo_type, sizeof (nbo_type));
+  for (i = 0; i < name_len; i++)
+    key_material[sizeof (nbo_type) + i]
+      = (char) tolower ((unsigned char) name[i]);
+  GNUNET_CRYPTO_hash (key_material,
+		      sizeof (key_material),
+		      key);
+}
+
+
+/**
+ * Remove the given entry from the answer cache and release its
+ * resources.
+ *
+ * @param ca cache entry to free
+ */
+static void
+free_cached_answer (struct CachedAnswer *ca)
+{
+  GNUNET_assert (GNUNET_YES ==
+		 GNUNET_CONTAINER_multihashmap_remove (cache_map,
+						       &ca->key,
+						       ca));
+  GNUNET_CONTAINER_DLL_remove (cache_head,
+			       cache_tail,
+			       ca);
+  GNUNET_free_non_null (ca->rd_data);
+  GNUNET_free (ca);
+}
+
+
+/**
+ * Look up an entry in the answer cache, removing it if it has
+ * expired and moving it to the front of the LRU list on a hit.
+ *
+ * @param key lookup key for the (name, type) pair
+ * @return cache entry, or NULL if we have no (valid) answer
+ */
+static struct CachedAnswer *
+cache_lookup (const struct GNUNET_HashCode *key)
+{
+  struct CachedAnswer *ca;
+
+  ca = GNUNET_CONTAINER_multihashmap_get (cache_map,
+					  key);
+  if (NULL == ca)
+    return NULL;
+  if (0 == GNUNET_TIME_absolute_get_remaining (ca->expiration).rel_value_us)
+  {
+    free_cached_answer (ca);
+    return NULL;
+  }
+  GNUNET_CONTAINER_DLL_remove (cache_head,
+			       cache_tail,
+			       ca);
+  GNUNET_CONTAINER_DLL_insert (cache_head,
+			       cache_tail,
+			       ca);
+  return ca;
+}
+
+
+/**
+ * Store a GNS record set in the answer cache, evicting the least
+ * recently used entry if the cache is full.  Record sets that are
+ * (about to be) expired are not stored.
+ *
+ * @param key lookup key for the (name, type) pair
+ * @param rd_count number of records in @a rd
+ * @param rd records to cache
+ */
+static void
+cache_answer (const struct GNUNET_HashCode *key,
+	      uint32_t rd_count,
+	      const struct GNUNET_GNSRECORD_Data *rd)
+{
+  struct CachedAnswer *ca;
+  struct GNUNET_TIME_Absolute expiration;
+  uint32_t i;
+
+  if (0 == rd_count)
+    return; /* no TTL to go by, do not cache negative results */
+  expiration = GNUNET_TIME_UNIT_FOREVER_ABS;
+  for (i = 0; i < rd_count; i++)
+    if (rd[i].expiration_time < expiration.abs_value_us)
+      expiration.abs_value_us = rd[i].expiration_time;
+  if (0 == GNUNET_TIME_absolute_get_remaining (expiration).rel_value_us)
+    return;
+  ca = GNUNET_CONTAINER_multihashmap_get (cache_map,
+					  key);
+  if (NULL != ca)
+    free_cached_answer (ca);
+  ca = GNUNET_new (struct CachedAnswer);
+  ca->key = *key;
+  ca->expiration = expiration;
+  ca->rd_count = rd_count;
+  ca->rd_data_size = GNUNET_GNSRECORD_records_get_size (rd_count,
+							rd);
+  ca->rd_data = GNUNET_malloc (ca->rd_data_size);
+  GNUNET_assert (ca->rd_data_size ==
+		 GNUNET_GNSRECORD_records_serialize (rd_count,
+						     rd,
+						     ca->rd_data_size,
+						     ca->rd_data));
+  GNUNET_assert (GNUNET_OK ==
+		 GNUNET_CONTAINER_multihashmap_put (cache_map,
+						    &ca->key,
+						    ca,
+						    GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+  GNUNET_CONTAINER_DLL_insert (cache_head,
+			       cache_tail,
+			       ca);
+  while (GNUNET_CONTAINER_multihashmap_size (cache_map) > MAX_CACHE_ENTRIES)
+    free_cached_answer (cache_tail);
+}
+
+
+/**
+ * Release an active lookup (which must no longer have any waiting
+ * requests), cancelling the GNS lookup if it is still pending.
+ *
+ * @param al active lookup to free
+ */
+static void
+free_active_lookup (struct ActiveLookup *al)
+{
+  GNUNET_assert (NULL == al->rq_head);
+  if (NULL != al->lookup)
+  {
+    GNUNET_GNS_lookup_cancel (al->lookup);
+    al->lookup = NULL;
+  }
+  GNUNET_CONTAINER_DLL_remove (al_head,
+			       al_tail,
+			       al);
+  GNUNET_free (al);
+}
+
 
 /**
  * Task run on shutdown.  Cleans up everything.
@@ -176,6 +468,27 @@ static void
 do_shutdown (void *cls,
 	     const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
+  struct Request *request;
+
+  while (NULL != al_head)
+  {
+    while (NULL != (request = al_head->rq_head))
+    {
+      GNUNET_CONTAINER_DLL_remove (al_head->rq_head,
+				   al_head->rq_tail,
+				   request);
+      request->al = NULL;
+      /* 'request' itself is freed by its timeout task */
+    }
+    free_active_lookup (al_head);
+  }
+  while (NULL != cache_head)
+    free_cached_answer (cache_head);
+  if (NULL != cache_map)
+  {
+    GNUNET_CONTAINER_multihashmap_destroy (cache_map);
+    cache_map = NULL;
+  }
   if (NULL != t4)
     GNUNET_SCHEDULER_cancel (t4);
   if (NULL != t6)
@@ -260,11 +573,19 @@ do_timeout (void *cls,
 	    const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
   struct Request *request = cls;
+  struct ActiveLookup *al;
 
   if (NULL != request->packet)
     GNUNET_DNSPARSER_free_packet (request->packet);
-  if (NULL != request->lookup)
-    GNUNET_GNS_lookup_cancel (request->lookup);
+  if (NULL != (al = request->al))
+  {
+    GNUNET_CONTAINER_DLL_remove (al->rq_head,
+				 al->rq_tail,
+				 request);
+    request->al = NULL;
+    if (NULL == al->rq_head)
+      free_active_lookup (al); /* no other request is waiting */
+  }
   if (NULL != request->dns_lookup)
     GNUNET_DNSSTUB_resolve_cancel (request->dns_lookup);
   GNUNET_free (request);
@@ -293,23 +614,22 @@ dns_result_processor (void *cls,
 
 
 /**
- * Iterator called on obtained result for a GNS lookup.
+ * Convert a GNS record set into the DNS response for the given
+ * request and send it.
  *
- * @param cls closure
+ * @param request request to answer (and clean up)
  * @param rd_count number of records in @a rd
  * @param rd the records in reply
  */
 static void
-result_processor (void *cls,
-		  uint32_t rd_count,
-		  const struct GNUNET_GNSRECORD_Data *rd)
+send_gns_response (struct Request *request,
+		   uint32_t rd_count,
+		   const struct GNUNET_GNSRECORD_Data *rd)
 {
-  struct Request *request = cls;
   struct GNUNET_DNSPARSER_Packet *packet;
   uint32_t i;
   struct GNUNET_DNSPARSER_Record rec;
 
-  request->lookup = NULL;
   packet = request->packet;
   packet->flags.query_or_response = 1;
   packet->flags.return_code = GNUNET_TUN_DNS_RETURN_CODE_NO_ERROR;
@@ -376,6 +696,41 @@ result_processor (void *cls,
 }
 
 
+/**
+ * Iterator called on obtained result for a GNS lookup.  Stores the
+ * answer in the cache and responds to all requests that were waiting
+ * for it.
+ *
+ * @param cls closure with the `struct ActiveLookup`
+ * @param rd_count number of records in @a rd
+ * @param rd the records in reply
+ */
+static void
+result_processor (void *cls,
+		  uint32_t rd_count,
+		  const struct GNUNET_GNSRECORD_Data *rd)
+{
+  struct ActiveLookup *al = cls;
+  struct Request *request;
+
+  al->lookup = NULL;
+  cache_answer (&al->key,
+		rd_count,
+		rd);
+  while (NULL != (request = al->rq_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (al->rq_head,
+				 al->rq_tail,
+				 request);
+    request->al = NULL;
+    send_gns_response (request,
+		       rd_count,
+		       rd);
+  }
+  free_active_lookup (al);
+}
+
+
 /**
  * Handle DNS request.
  *
@@ -472,18 +827,68 @@ handle_request (struct GNUNET_NETWORK_Handle *lsock,
   }
   if (GNUNET_YES == use_gns)
   {
-    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-		"Calling GNS on `%s'\n",
-		name);
+    struct GNUNET_HashCode key;
+    struct CachedAnswer *ca;
+    struct ActiveLookup *al;
+
     type = packet->queries[0].type;
-    request->lookup = GNUNET_GNS_lookup (gns,
-					 name,
-					 &my_zone,
-					 type,
-					 GNUNET_NO,
-					 NULL /* no shorten */,
-					 &result_processor,
-					 request);
+    compute_lookup_key (name,
+			type,
+			&key);
+    if (NULL != (ca = cache_lookup (&key)))
+    {
+      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+		  "Answering query for `%s' from cache\n",
+		  name);
+      {
+	struct GNUNET_GNSRECORD_Data rd[ca->rd_count];
+
+	GNUNET_assert (GNUNET_OK ==
+		       GNUNET_GNSRECORD_records_deserialize (ca->rd_data_size,
+							     ca->rd_data,
+							     ca->rd_count,
+							     rd));
+	send_gns_response (request,
+			   ca->rd_count,
+			   rd);
+      }
+      GNUNET_free (name);
+      return;
+    }
+    for (al = al_head; NULL != al; al = al->next)
+      if (0 == memcmp (&al->key,
+		       &key,
+		       sizeof (key)))
+	break;
+    if (NULL == al)
+    {
+      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+		  "Calling GNS on `%s'\n",
+		  name);
+      al = GNUNET_new (struct ActiveLookup);
+      al->key = key;
+      GNUNET_CONTAINER_DLL_insert (al_head,
+				   al_tail,
+				   al);
+      al->lookup = GNUNET_GNS_lookup (gns,
+				      name,
+				      &my_zone,
+				      type,
+				      GNUNET_NO,
+				      NULL /* no shorten */,
+				      &result_processor,
+				      al);
+    }
+    else
+    {
+      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+		  "Attaching query for `%s' to GNS lookup already in flight\n",
+		  name);
+    }
+    request->al = al;
+    GNUNET_CONTAINER_DLL_insert_tail (al->rq_head,
+				      al->rq_tail,
+				      request);
   }
   else
   {
@@ -516,6 +921,7 @@ read_dns4 (void *cls,
   struct sockaddr_in v4;
   socklen_t addrlen;
   ssize_t size;
+  unsigned int i;
 
   GNUNET_assert (listen_socket4 == cls);
   t4 = GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
@@ -524,24 +930,29 @@ read_dns4 (void *cls,
 				      listen_socket4);
   if (0 == (GNUNET_SCHEDULER_REASON_READ_READY & tc->reason))
     return; /* shutdown? */
-  size = GNUNET_NETWORK_socket_recvfrom_amount (listen_socket4);
-  if (0 > size)
+  for (i = 0; i < MAX_DNS_READS_PER_TASK; i++)
+  {
+    size = GNUNET_NETWORK_socket_recvfrom_amount (listen_socket4);
+    if (0 > size)
+      {
+	GNUNET_break (0 < i);
+	return; /* read error!? */
+      }
+    if ( (0 == size) && (0 < i) )
+      return; /* drained all pending datagrams */
     {
-      GNUNET_break (0);
-      return; /* read error!? */
+      char buf[size];
+
+      addrlen = sizeof (v4);
+      GNUNET_break (size ==
+		    GNUNET_NETWORK_socket_recvfrom (listen_socket4,
+						    buf,
+						    size,
+						    (struct sockaddr *) &v4,
+						    &addrlen));
+      handle_request (listen_socket4, &v4, addrlen,
+		      buf, size);
     }
-  {
-    char buf[size];
-
-    addrlen = sizeof (v4);
-    GNUNET_break (size ==
-		  GNUNET_NETWORK_socket_recvfrom (listen_socket4,
-						  buf,
-						  size,
-						  (struct sockaddr *) &v4,
-						  &addrlen));
-    handle_request (listen_socket4, &v4, addrlen,
-		    buf, size);
   }
 }
 
@@ -559,6 +970,7 @@ read_dns6 (void *cls,
   struct sockaddr_in6 v6;
   socklen_t addrlen;
   ssize_t size;
+  unsigned int i;
 
   GNUNET_assert (listen_socket6 == cls);
   t6 = GNUNET_SCHEDULER_add_read_net (GNUNET_TIME_UNIT_FOREVER_REL,
@@ -567,24 +979,29 @@ read_dns6 (void *cls,
 				      listen_socket6);
   if (0 == (GNUNET_SCHEDULER_REASON_READ_READY & tc->reason))
     return; /* shutdown? */
-  size = GNUNET_NETWORK_socket_recvfrom_amount (listen_socket6);
-  if (0 > size)
+  for (i = 0; i < MAX_DNS_READS_PER_TASK; i++)
+  {
+    size = GNUNET_NETWORK_socket_recvfrom_amount (listen_socket6);
+    if (0 > size)
+      {
+	GNUNET_break (0 < i);
+	return; /* read error!? */
+      }
+    if ( (0 == size) && (0 < i) )
+      return; /* drained all pending datagrams */
     {
-      GNUNET_break (0);
-      return; /* read error!? */
+      char buf[size];
+
+      addrlen = sizeof (v6);
+      GNUNET_break (size ==
+		    GNUNET_NETWORK_socket_recvfrom (listen_socket6,
+						    buf,
+						    size,
+						    (struct sockaddr *) &v6,
+						    &addrlen));
+      handle_request (listen_socket6, &v6, addrlen,
+		      buf, size);
     }
-  {
-    char buf[size];
-
-    addrlen = sizeof (v6);
-    GNUNET_break (size ==
-		  GNUNET_NETWORK_socket_recvfrom (listen_socket6,
-						  buf,
-						  size,
-						  (struct sockaddr *) &v6,
-						  &addrlen));
-    handle_request (listen_socket6, &v6, addrlen,
-		    buf, size);
   }
 }
 
@@ -599,6 +1016,8 @@ run_dnsd ()
     dns_suffix = DNS_SUFFIX;
   if (NULL == fcfs_suffix)
     fcfs_suffix = FCFS_SUFFIX;
+  cache_map = GNUNET_CONTAINER_multihashmap_create (MAX_CACHE_ENTRIES,
+						    GNUNET_NO);
   if (NULL == (gns = GNUNET_GNS_connect (cfg)))
     return;
   if (NULL == (dns_stub = GNUNET_DNSSTUB_start (dns_ip)))
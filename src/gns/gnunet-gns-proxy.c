@@ -92,6 +92,12 @@
  */
 #define MHD_CACHE_TIMEOUT GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 5)
 
+/**
+ * How many idle connections should cURL keep around in its
+ * connection pool for reuse by later requests to the same origin?
+ */
+#define CURL_MAX_CONNECTIONS 32
+
 /**
  * After how long do we clean up Socks5 handles that failed to show any activity
  * with their respective MHD instance?
@@ -619,6 +625,21 @@ static struct GNUNET_SCHEDULER_Task * curl_download_task;
  */
 static CURLM *curl_multi;
 
+/**
+ * The cURL share handle; shares the DNS and TLS session caches
+ * between the per-request easy handles so that connections to the
+ * same origin can resume TLS sessions.
+ */
+static CURLSH *curl_share;
+
+/**
+ * Map from the hash over the domain name to `struct
+ * ProxyGNSCertificate` entries; certificates are generated once per
+ * domain and reused, even after their HTTPS MHD instance was cleaned
+ * up due to inactivity.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap *cert_cache;
+
 /**
  * Handle to the GNS service
  */
@@ -1567,6 +1588,7 @@ create_response (void *cls,
     curl_easy_setopt (s5r->curl, CURLOPT_HTTP_TRANSFER_DECODING, 0);
     curl_easy_setopt (s5r->curl, CURLOPT_NOSIGNAL, 1L);
     curl_easy_setopt (s5r->curl, CURLOPT_PRIVATE, s5r);
+    curl_easy_setopt (s5r->curl, CURLOPT_SHARE, curl_share);
     curl_easy_setopt (s5r->curl, CURLOPT_VERBOSE, 0);
     /**
      * Pre-populate cache to resolve Hostname.
@@ -1810,7 +1832,7 @@ kill_httpd (struct MhdHttpList *hd)
     GNUNET_SCHEDULER_cancel (hd->httpd_task);
     hd->httpd_task = NULL;
   }
-  GNUNET_free_non_null (hd->proxy_cert);
+  /* note: hd->proxy_cert is owned by the #cert_cache, not released here */
   if (hd == httpd)
     httpd = NULL;
   GNUNET_free (hd);
@@ -2123,6 +2145,7 @@ lookup_ssl_httpd (const char* domain)
 {
   struct MhdHttpList *hd;
   struct ProxyGNSCertificate *pgc;
+  struct GNUNET_HashCode hc;
 
   if (NULL == domain)
   {
@@ -2136,7 +2159,20 @@ lookup_ssl_httpd (const char* domain)
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
 	      "Starting fresh MHD HTTPS instance for domain `%s'\n",
 	      domain);
-  pgc = generate_gns_certificate (domain);
+  GNUNET_CRYPTO_hash (domain,
+		      strlen (domain),
+		      &hc);
+  pgc = GNUNET_CONTAINER_multihashmap_get (cert_cache,
+					   &hc);
+  if (NULL == pgc)
+  {
+    pgc = generate_gns_certificate (domain);
+    GNUNET_assert (GNUNET_OK ==
+		   GNUNET_CONTAINER_multihashmap_put (cert_cache,
+						      &hc,
+						      pgc,
+						      GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+  }
   hd = GNUNET_new (struct MhdHttpList);
   hd->is_ssl = GNUNET_YES;
   hd->domain = GNUNET_strdup (domain);
@@ -2154,7 +2190,7 @@ lookup_ssl_httpd (const char* domain)
 				 MHD_OPTION_END);
   if (NULL == hd->daemon)
   {
-    GNUNET_free (pgc);
+    /* cert stays in the #cert_cache for the next attempt */
     GNUNET_free (hd);
     return NULL;
   }
@@ -2765,6 +2801,27 @@ do_accept (void *cls,
 /* ******************* General / main code ********************* */
 
 
+/**
+ * Iterator called during shutdown to free the entries of the
+ * certificate cache.
+ *
+ * @param cls NULL
+ * @param key hash over the domain name (unused)
+ * @param value the `struct ProxyGNSCertificate` to free
+ * @return #GNUNET_YES (continue to iterate)
+ */
+static int
+free_cert_cache_entry (void *cls,
+		       const struct GNUNET_HashCode *key,
+		       void *value)
+{
+  struct ProxyGNSCertificate *pgc = value;
+
+  GNUNET_free (pgc);
+  return GNUNET_YES;
+}
+
+
 /**
  * Task run on shutdown
  *
@@ -2806,6 +2863,19 @@ do_shutdown (void *cls,
     curl_multi_cleanup (curl_multi);
     curl_multi = NULL;
   }
+  if (NULL != curl_share)
+  {
+    curl_share_cleanup (curl_share);
+    curl_share = NULL;
+  }
+  if (NULL != cert_cache)
+  {
+    GNUNET_CONTAINER_multihashmap_iterate (cert_cache,
+					   &free_cert_cache_entry,
+					   NULL);
+    GNUNET_CONTAINER_multihashmap_destroy (cert_cache);
+    cert_cache = NULL;
+  }
   if (NULL != gns_handle)
   {
     GNUNET_GNS_disconnect (gns_handle);
@@ -3091,6 +3161,24 @@ run (void *cls, char *const *args, const char *cfgfile,
                 "Failed to create cURL multi handle!\n");
     return;
   }
+  curl_multi_setopt (curl_multi,
+		     CURLMOPT_MAXCONNECTS,
+		     (long) CURL_MAX_CONNECTIONS);
+  if (NULL == (curl_share = curl_share_init ()))
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                "Failed to create cURL share handle!\n");
+    return;
+  }
+  /* we are single-threaded, so no lock functions are needed */
+  curl_share_setopt (curl_share,
+		     CURLSHOPT_SHARE,
+		     CURL_LOCK_DATA_SSL_SESSION);
+  curl_share_setopt (curl_share,
+		     CURLSHOPT_SHARE,
+		     CURL_LOCK_DATA_DNS);
+  cert_cache = GNUNET_CONTAINER_multihashmap_create (16,
+						     GNUNET_NO);
   cafile = cafile_opt;
   if (NULL == cafile)
   {
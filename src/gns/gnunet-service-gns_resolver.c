@@ -58,6 +58,19 @@
  */
 #define VPN_TIMEOUT GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 30)
 
+/**
+ * How long do we remember lookups that were abandoned without an
+ * answer (the NXDOMAIN-equivalent) in the in-process resolution
+ * cache?
+ */
+#define NEGATIVE_CACHE_TTL GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 5)
+
+/**
+ * Maximum number of entries we keep in the in-process resolution
+ * cache; if it is exceeded, we evict the entry closest to expiration.
+ */
+#define MAX_CACHE_ENTRIES 1024
+
 /**
  * DHT replication level
  */
@@ -111,6 +124,14 @@ struct AuthorityChain
    */
   int gns_authority;
 
+  /**
+   * Expiration of the delegation chain up to and including this
+   * authority; results obtained below this authority must not be
+   * cached beyond this time.  Set to "forever" for the start of
+   * the chain.
+   */
+  struct GNUNET_TIME_Absolute expiration;
+
   /**
    * Information about the resolver authority for this label.
    */
@@ -412,6 +433,51 @@ struct CacheOps
 };
 
 
+/**
+ * Entry in the in-process cache of GNS resolution results.  Maps the
+ * query hash of a (zone, label) pair to the decrypted record set, or
+ * to a negative result if a previous lookup was abandoned without an
+ * answer, so that hot names can be answered without namecache or DHT
+ * round trips.
+ */
+struct CachedResolution
+{
+
+  /**
+   * Query hash of the (zone, label) pair; key in #resolution_cache.
+   */
+  struct GNUNET_HashCode query;
+
+  /**
+   * Node in #cache_expiration_heap, ordered by @e expiration.
+   */
+  struct GNUNET_CONTAINER_HeapNode *heap_node;
+
+  /**
+   * How long is this cache entry valid?  Minimum of the record set's
+   * expiration and the expiration inherited along the delegation
+   * chain that produced the entry.
+   */
+  struct GNUNET_TIME_Absolute expiration;
+
+  /**
+   * Serialized record data, NULL for a negative entry.
+   */
+  char *rd_data;
+
+  /**
+   * Number of bytes in @e rd_data.
+   */
+  size_t rd_data_size;
+
+  /**
+   * Number of records in @e rd_data, 0 for a negative entry.
+   */
+  unsigned int rd_count;
+
+};
+
+
 /**
  * Our handle to the namecache service
  */
@@ -462,6 +528,18 @@ static struct CacheOps *co_head;
  */
 static struct CacheOps *co_tail;
 
+/**
+ * In-process cache mapping query hashes to `struct CachedResolution`
+ * entries.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap *resolution_cache;
+
+/**
+ * Heap with the entries of #resolution_cache ordered by expiration
+ * time, used for eviction.
+ */
+static struct GNUNET_CONTAINER_Heap *cache_expiration_heap;
+
 /**
  * Use namecache
  */
@@ -507,6 +585,106 @@ is_canonical (const char *name)
   return GNUNET_YES;
 }
 
+/* *************** In-process resolution cache ********************* */
+
+
+/**
+ * Remove the given entry from the in-process resolution cache and
+ * release its resources.
+ *
+ * @param cr cache entry to free
+ */
+static void
+cache_entry_free (struct CachedResolution *cr)
+{
+  GNUNET_assert (GNUNET_YES ==
+		 GNUNET_CONTAINER_multihashmap_remove (resolution_cache,
+						       &cr->query,
+						       cr));
+  GNUNET_CONTAINER_heap_remove_node (cr->heap_node);
+  GNUNET_free_non_null (cr->rd_data);
+  GNUNET_free (cr);
+}
+
+
+/**
+ * Look up an entry in the in-process resolution cache, removing it
+ * if it has expired.
+ *
+ * @param query query hash of the (zone, label) pair
+ * @return cache entry, or NULL if we have no (valid) entry
+ */
+static struct CachedResolution *
+cache_lookup (const struct GNUNET_HashCode *query)
+{
+  struct CachedResolution *cr;
+
+  cr = GNUNET_CONTAINER_multihashmap_get (resolution_cache,
+					  query);
+  if (NULL == cr)
+    return NULL;
+  if (0 == GNUNET_TIME_absolute_get_remaining (cr->expiration).rel_value_us)
+  {
+    cache_entry_free (cr);
+    return NULL;
+  }
+  return cr;
+}
+
+
+/**
+ * Store a resolution result (or, with @a rd_count zero, a negative
+ * result) in the in-process resolution cache, replacing any existing
+ * entry for the same query and evicting the entries closest to
+ * expiration if the cache grows too large.
+ *
+ * @param query query hash of the (zone, label) pair
+ * @param expiration how long is the entry valid?
+ * @param rd_count number of records in @a rd, 0 for a negative entry
+ * @param rd records to cache, NULL for a negative entry
+ */
+static void
+cache_resolution (const struct GNUNET_HashCode *query,
+		  struct GNUNET_TIME_Absolute expiration,
+		  unsigned int rd_count,
+		  const struct GNUNET_GNSRECORD_Data *rd)
+{
+  struct CachedResolution *cr;
+
+  if (0 == GNUNET_TIME_absolute_get_remaining (expiration).rel_value_us)
+    return; /* already expired, do not cache */
+  cr = GNUNET_CONTAINER_multihashmap_get (resolution_cache,
+					  query);
+  if (NULL != cr)
+    cache_entry_free (cr);
+  cr = GNUNET_new (struct CachedResolution);
+  cr->query = *query;
+  cr->expiration = expiration;
+  cr->rd_count = rd_count;
+  if (0 < rd_count)
+  {
+    cr->rd_data_size = GNUNET_GNSRECORD_records_get_size (rd_count,
+							  rd);
+    cr->rd_data = GNUNET_malloc (cr->rd_data_size);
+    GNUNET_assert (cr->rd_data_size ==
+		   GNUNET_GNSRECORD_records_serialize (rd_count,
+						       rd,
+						       cr->rd_data_size,
+						       cr->rd_data));
+  }
+  GNUNET_assert (GNUNET_OK ==
+		 GNUNET_CONTAINER_multihashmap_put (resolution_cache,
+						    &cr->query,
+						    cr,
+						    GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+  cr->heap_node = GNUNET_CONTAINER_heap_insert (cache_expiration_heap,
+						cr,
+						cr->expiration.abs_value_us);
+  while (GNUNET_CONTAINER_heap_get_size (cache_expiration_heap) > MAX_CACHE_ENTRIES)
+    cache_entry_free (GNUNET_CONTAINER_heap_peek (cache_expiration_heap));
+}
+
+
 /* ************************** Resolution **************************** */
 
 /**
@@ -1127,6 +1305,7 @@ handle_gns_cname_result (struct GNS_ResolverHandle *rh,
     ac->rh = rh;
     ac->gns_authority = GNUNET_YES;
     ac->authority_info.gns_authority = rh->ac_tail->authority_info.gns_authority;
+    ac->expiration = rh->ac_tail->expiration;
     ac->label = resolver_lookup_get_next_label (rh);
     ac->suggested_shortening_label = NULL;
     ac->shortening_started = GNUNET_NO;
@@ -1326,6 +1505,7 @@ handle_gns2dns_result (void *cls,
   /* expand authority chain */
   ac = GNUNET_new (struct AuthorityChain);
   ac->rh = rh;
+  ac->expiration = rh->ac_tail->expiration;
   strcpy (ac->authority_info.dns_authority.name,
           rh->g2dc->ns);
   memcpy (&ac->authority_info.dns_authority.dns_ip,
@@ -1695,6 +1875,10 @@ handle_gns_resolution_result (void *cls,
             ac->rh = rh;
             ac->gns_authority = GNUNET_YES;
             ac->authority_info.gns_authority = pub;
+            ac->expiration
+              = GNUNET_TIME_absolute_min (GNUNET_GNSRECORD_record_get_expiration_time (1,
+                                                                                       &rd[i]),
+                                          rh->ac_tail->expiration);
             ac->label = GNUNET_strdup (GNUNET_GNS_MASTERZONE_STR);
             ac->suggested_shortening_label = NULL;
             ac->shortening_started = GNUNET_NO;
@@ -1803,6 +1987,10 @@ handle_gns_resolution_result (void *cls,
       memcpy (&ac->authority_info.gns_authority,
 	      rd[i].data,
 	      sizeof (struct GNUNET_CRYPTO_EcdsaPublicKey));
+      ac->expiration
+	= GNUNET_TIME_absolute_min (GNUNET_GNSRECORD_record_get_expiration_time (1,
+										 &rd[i]),
+				    rh->ac_tail->expiration);
       ac->label = resolver_lookup_get_next_label (rh);
       /* add AC to tail */
       GNUNET_CONTAINER_DLL_insert_tail (rh->ac_head,
@@ -1921,6 +2109,64 @@ namecache_cache_continuation (void *cls,
 }
 
 
+/**
+ * Store the decrypted records for the current authority chain tail in
+ * the in-process resolution cache.  The entry's lifetime is the
+ * record set's expiration, capped by the expiration inherited along
+ * the delegation chain.
+ *
+ * @param rh resolution handle the records were decrypted for
+ * @param rd_count number of entries in @a rd array
+ * @param rd array of records to cache
+ */
+static void
+cache_records_for_authority (struct GNS_ResolverHandle *rh,
+			     unsigned int rd_count,
+			     const struct GNUNET_GNSRECORD_Data *rd)
+{
+  struct AuthorityChain *ac = rh->ac_tail;
+  struct GNUNET_HashCode query;
+  struct GNUNET_TIME_Absolute expiration;
+
+  expiration
+    = GNUNET_TIME_absolute_min (GNUNET_GNSRECORD_record_get_expiration_time (rd_count,
+									     rd),
+				ac->expiration);
+  GNUNET_GNSRECORD_query_from_public_key (&ac->authority_info.gns_authority,
+					  ac->label,
+					  &query);
+  cache_resolution (&query,
+		    expiration,
+		    rd_count,
+		    rd);
+}
+
+
+/**
+ * Process records that were decrypted from a block we got from the
+ * DHT.  Populates the in-process resolution cache and continues with
+ * #handle_gns_resolution_result().
+ *
+ * @param cls closure with the `struct GNS_ResolverHandle`
+ * @param rd_count number of entries in @a rd array
+ * @param rd array of records with data to store
+ */
+static void
+handle_gns_dht_resolution_result (void *cls,
+				  unsigned int rd_count,
+				  const struct GNUNET_GNSRECORD_Data *rd)
+{
+  struct GNS_ResolverHandle *rh = cls;
+
+  cache_records_for_authority (rh,
+			       rd_count,
+			       rd);
+  handle_gns_resolution_result (rh,
+				rd_count,
+				rd);
+}
+
+
 /**
  * Iterator called on each result obtained for a DHT
  * operation that expects a reply
@@ -1984,7 +2230,7 @@ handle_dht_response (void *cls,
       GNUNET_GNSRECORD_block_decrypt (block,
 				      &ac->authority_info.gns_authority,
 				      ac->label,
-				      &handle_gns_resolution_result,
+				      &handle_gns_dht_resolution_result,
 				      rh))
   {
     GNUNET_break_op (0); /* block was ill-formed */
@@ -2048,7 +2294,8 @@ start_dht_request (struct GNS_ResolverHandle *rh,
 
 /**
  * Process a records that were decrypted from a block that we got from
- * the namecache.  Simply calls #handle_gns_resolution_result().
+ * the namecache.  Populates the in-process resolution cache and then
+ * calls #handle_gns_resolution_result().
  *
  * @param cls closure with the `struct GNS_ResolverHandle`
  * @param rd_count number of entries in @a rd array
@@ -2061,6 +2308,9 @@ handle_gns_namecache_resolution_result (void *cls,
 {
   struct GNS_ResolverHandle *rh = cls;
 
+  cache_records_for_authority (rh,
+                               rd_count,
+                               rd);
   handle_gns_resolution_result (rh,
                                 rd_count,
                                 rd);
@@ -2153,6 +2403,7 @@ recursive_gns_resolution_namecache (struct GNS_ResolverHandle *rh)
 {
   struct AuthorityChain *ac = rh->ac_tail;
   struct GNUNET_HashCode query;
+  struct CachedResolution *cr;
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
 	      "Starting GNS resolution for `%s' in zone %s\n",
@@ -2161,6 +2412,33 @@ recursive_gns_resolution_namecache (struct GNS_ResolverHandle *rh)
   GNUNET_GNSRECORD_query_from_public_key (&ac->authority_info.gns_authority,
 					  ac->label,
 					  &query);
+  if (NULL != (cr = cache_lookup (&query)))
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+		"Answering lookup for `%s' from in-process cache (%u records)\n",
+		ac->label,
+		cr->rd_count);
+    if (0 == cr->rd_count)
+    {
+      /* cached negative result, fail immediately */
+      rh->proc (rh->proc_cls, 0, NULL);
+      GNS_resolver_lookup_cancel (rh);
+      return;
+    }
+    {
+      struct GNUNET_GNSRECORD_Data rd[cr->rd_count];
+
+      GNUNET_assert (GNUNET_OK ==
+		     GNUNET_GNSRECORD_records_deserialize (cr->rd_data_size,
+							   cr->rd_data,
+							   cr->rd_count,
+							   rd));
+      handle_gns_resolution_result (rh,
+				    cr->rd_count,
+				    rd);
+    }
+    return;
+  }
   if (GNUNET_YES == use_cache)
   {
     rh->namecache_qe
@@ -2363,6 +2641,7 @@ start_resolver_lookup (struct GNS_ResolverHandle *rh)
     ac->label = GNUNET_strdup (GNUNET_GNS_MASTERZONE_STR);
   ac->gns_authority = GNUNET_YES;
   ac->authority_info.gns_authority = rh->authority_zone;
+  ac->expiration = GNUNET_TIME_UNIT_FOREVER_ABS;
   GNUNET_CONTAINER_DLL_insert_tail (rh->ac_head,
 				    rh->ac_tail,
 				    ac);
@@ -2435,6 +2714,23 @@ GNS_resolver_lookup_cancel (struct GNS_ResolverHandle *rh)
   GNUNET_CONTAINER_DLL_remove (rlh_head,
 			       rlh_tail,
 			       rh);
+  if ( (NULL != rh->get_handle) &&
+       (NULL != rh->ac_tail) &&
+       (GNUNET_YES == rh->ac_tail->gns_authority) )
+  {
+    /* lookup was abandoned while waiting on the DHT; remember the
+       miss so that immediate retries for the same name fail fast */
+    struct GNUNET_HashCode query;
+
+    GNUNET_GNSRECORD_query_from_public_key (&rh->ac_tail->authority_info.gns_authority,
+					    rh->ac_tail->label,
+					    &query);
+    if (NULL == cache_lookup (&query))
+      cache_resolution (&query,
+			GNUNET_TIME_relative_to_absolute (NEGATIVE_CACHE_TTL),
+			0,
+			NULL);
+  }
   while (NULL != (ac = rh->ac_head))
   {
     GNUNET_CONTAINER_DLL_remove (rh->ac_head,
@@ -2542,6 +2838,11 @@ GNS_resolver_init (struct GNUNET_NAMECACHE_Handle *nc,
   dht_lookup_heap =
     GNUNET_CONTAINER_heap_create (GNUNET_CONTAINER_HEAP_ORDER_MIN);
   max_allowed_background_queries = max_bg_queries;
+  resolution_cache
+    = GNUNET_CONTAINER_multihashmap_create (MAX_CACHE_ENTRIES,
+					    GNUNET_NO);
+  cache_expiration_heap =
+    GNUNET_CONTAINER_heap_create (GNUNET_CONTAINER_HEAP_ORDER_MIN);
   if (GNUNET_SYSERR == (use_cache = GNUNET_CONFIGURATION_get_value_yesno (c,
                                              "gns",
                                              "USE_CACHE")))
@@ -2587,6 +2888,12 @@ GNS_resolver_done ()
     GNUNET_NAMECACHE_cancel (co->namecache_qe_cache);
     GNUNET_free (co);
   }
+  while (0 < GNUNET_CONTAINER_heap_get_size (cache_expiration_heap))
+    cache_entry_free (GNUNET_CONTAINER_heap_peek (cache_expiration_heap));
+  GNUNET_CONTAINER_heap_destroy (cache_expiration_heap);
+  cache_expiration_heap = NULL;
+  GNUNET_CONTAINER_multihashmap_destroy (resolution_cache);
+  resolution_cache = NULL;
   GNUNET_CONTAINER_heap_destroy (dht_lookup_heap);
   dht_lookup_heap = NULL;
   GNUNET_DNSSTUB_stop (dns_handle);
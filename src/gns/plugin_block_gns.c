@@ -104,8 +104,9 @@ block_plugin_gns_evaluate (void *cls,
       GNUNET_break_op (0);
       return GNUNET_BLOCK_EVALUATION_RESULT_INVALID;
     }
-  if (GNUNET_OK !=
-      GNUNET_GNSRECORD_block_verify (block))
+  if ( (0 == (eo & GNUNET_BLOCK_EO_LOCAL_SKIP_CRYPTO)) &&
+       (GNUNET_OK !=
+	GNUNET_GNSRECORD_block_verify (block)) )
     {
       GNUNET_break_op (0);
       return GNUNET_BLOCK_EVALUATION_RESULT_INVALID;
@@ -179,6 +180,7 @@ libgnunet_plugin_block_gns_init (void *cls)
   api->evaluate = &block_plugin_gns_evaluate;
   api->get_key = &block_plugin_gns_get_key;
   api->types = types;
+  api->crypto_cacheable = GNUNET_YES;
   return api;
 }
 
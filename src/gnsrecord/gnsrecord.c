@@ -68,6 +68,74 @@ static unsigned int num_plugins;
  */
 static int once;
 
+/**
+ * Number of slots in the type-to-plugin dispatch cache.
+ */
+#define PLUGIN_CACHE_SIZE 16
+
+
+/**
+ * Entry in the dispatch cache, remembering which plugin handled a
+ * record type last.  Conversions then do not have to probe every
+ * plugin for every record, which matters when converting thousands
+ * of records for a zone listing.
+ */
+struct PluginCacheEntry
+{
+  /**
+   * Record type this entry is about.
+   */
+  uint32_t type;
+
+  /**
+   * Plugin that handled @e type, NULL if the slot is unused.
+   */
+  struct Plugin *plugin;
+};
+
+
+/**
+ * Direct-mapped cache of which plugin handles which record type.
+ */
+static struct PluginCacheEntry plugin_cache[PLUGIN_CACHE_SIZE];
+
+
+/**
+ * Look up the plugin that last handled the given record type.
+ *
+ * @param type record type to look up
+ * @return the cached plugin, NULL for a cache miss
+ */
+static struct Plugin *
+cache_get (uint32_t type)
+{
+  struct PluginCacheEntry *ce;
+
+  ce = &plugin_cache[type % PLUGIN_CACHE_SIZE];
+  if ( (NULL != ce->plugin) &&
+       (type == ce->type) )
+    return ce->plugin;
+  return NULL;
+}
+
+
+/**
+ * Remember which plugin handled the given record type.
+ *
+ * @param type record type that was handled
+ * @param plugin plugin that handled it
+ */
+static void
+cache_put (uint32_t type,
+           struct Plugin *plugin)
+{
+  struct PluginCacheEntry *ce;
+
+  ce = &plugin_cache[type % PLUGIN_CACHE_SIZE];
+  ce->type = type;
+  ce->plugin = plugin;
+}
+
 
 /**
  * Add a plugin to the list managed by the block library.
@@ -128,6 +196,9 @@ GNSRECORD_fini ()
   }
   GNUNET_free_non_null (gns_plugins);
   gns_plugins = NULL;
+  memset (plugin_cache,
+          0,
+          sizeof (plugin_cache));
   once = 0;
   num_plugins = 0;
 }
@@ -151,6 +222,15 @@ GNUNET_GNSRECORD_value_to_string (uint32_t type,
   char *ret;
 
   init ();
+  if (NULL != (plugin = cache_get (type)))
+  {
+    if (NULL != (ret = plugin->api->value_to_string (plugin->api->cls,
+                                                     type,
+                                                     data,
+                                                     data_size)))
+      return ret;
+    /* cached plugin rejected the value, fall back to probing all */
+  }
   for (i = 0; i < num_plugins; i++)
   {
     plugin = gns_plugins[i];
@@ -158,7 +238,10 @@ GNUNET_GNSRECORD_value_to_string (uint32_t type,
                                                      type,
                                                      data,
                                                      data_size)))
+    {
+      cache_put (type, plugin);
       return ret;
+    }
   }
   return NULL;
 }
@@ -184,6 +267,16 @@ GNUNET_GNSRECORD_string_to_value (uint32_t type,
   struct Plugin *plugin;
 
   init ();
+  if (NULL != (plugin = cache_get (type)))
+  {
+    if (GNUNET_OK == plugin->api->string_to_value (plugin->api->cls,
+                                                   type,
+                                                   s,
+                                                   data,
+                                                   data_size))
+      return GNUNET_OK;
+    /* cached plugin rejected the value, fall back to probing all */
+  }
   for (i = 0; i < num_plugins; i++)
   {
     plugin = gns_plugins[i];
@@ -192,7 +285,10 @@ GNUNET_GNSRECORD_string_to_value (uint32_t type,
                                                    s,
                                                    data,
                                                    data_size))
+    {
+      cache_put (type, plugin);
       return GNUNET_OK;
+    }
   }
   return GNUNET_SYSERR;
 }
@@ -242,12 +338,21 @@ GNUNET_GNSRECORD_number_to_typename (uint32_t type)
   if (GNUNET_GNSRECORD_TYPE_ANY == type)
     return "ANY";
   init ();
+  if (NULL != (plugin = cache_get (type)))
+  {
+    if (NULL != (ret = plugin->api->number_to_typename (plugin->api->cls,
+                                                        type)))
+      return ret;
+  }
   for (i = 0; i < num_plugins; i++)
   {
     plugin = gns_plugins[i];
     if (NULL != (ret = plugin->api->number_to_typename (plugin->api->cls,
                                                         type)))
+    {
+      cache_put (type, plugin);
       return ret;
+    }
   }
   return NULL;
 }
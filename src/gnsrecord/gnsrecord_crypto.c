@@ -37,6 +37,43 @@
 
 #define LOG(kind,...) GNUNET_log_from (kind, "gnsrecord",__VA_ARGS__)
 
+/**
+ * Number of slots in the cache for derived zone keys.
+ */
+#define DERIVE_CACHE_SIZE 128
+
+
+/**
+ * Cache entry mapping a (zone key, label) pair to the derived public
+ * key.  The derivation performs an ECC point multiplication, which
+ * dominates the cost of computing queries; resolvers and the
+ * zonemaster ask for the same labels over and over again.
+ */
+struct DerivedKeyCacheEntry
+{
+  /**
+   * Hash over the zone key and the label.
+   */
+  struct GNUNET_HashCode key;
+
+  /**
+   * Public key derived for @e key.
+   */
+  struct GNUNET_CRYPTO_EcdsaPublicKey pd;
+
+  /**
+   * #GNUNET_YES if this slot holds a valid derivation.
+   */
+  int valid;
+};
+
+
+/**
+ * Direct-mapped cache of derived zone keys, indexed by the
+ * first bits of the hash over (zone key, label).
+ */
+static struct DerivedKeyCacheEntry derive_cache[DERIVE_CACHE_SIZE];
+
 
 /**
  * Derive session key and iv from label and public key.
@@ -322,8 +359,31 @@ GNUNET_GNSRECORD_query_from_public_key (const struct GNUNET_CRYPTO_EcdsaPublicKe
 					struct GNUNET_HashCode *query)
 {
   struct GNUNET_CRYPTO_EcdsaPublicKey pd;
+  struct GNUNET_HashCode hc;
+  struct DerivedKeyCacheEntry *ce;
+  size_t label_len;
+
+  label_len = strlen (label);
+  {
+    char key_material[sizeof (*pub) + label_len];
 
-  GNUNET_CRYPTO_ecdsa_public_key_derive (pub, label, "gns", &pd);
+    memcpy (key_material, pub, sizeof (*pub));
+    memcpy (&key_material[sizeof (*pub)], label, label_len);
+    GNUNET_CRYPTO_hash (key_material, sizeof (key_material), &hc);
+  }
+  ce = &derive_cache[hc.bits[0] % DERIVE_CACHE_SIZE];
+  if ( (GNUNET_YES == ce->valid) &&
+       (0 == memcmp (&ce->key, &hc, sizeof (hc))) )
+  {
+    pd = ce->pd;
+  }
+  else
+  {
+    GNUNET_CRYPTO_ecdsa_public_key_derive (pub, label, "gns", &pd);
+    ce->key = hc;
+    ce->pd = pd;
+    ce->valid = GNUNET_YES;
+  }
   GNUNET_CRYPTO_hash (&pd, sizeof (pd), query);
 }
 
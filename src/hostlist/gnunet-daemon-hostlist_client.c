@@ -63,6 +63,13 @@
  */
 #define WAITING_INTERVAL GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS, 1)
 
+/**
+ * Maximum number of valid HELLOs we process from a single download;
+ * with only #MIN_CONNECTIONS connections needed this is plenty of
+ * candidates, downloading more is wasted bandwidth
+ */
+#define MAX_HELLOS_PER_DOWNLOAD 100
+
 /**
  * Defines concerning the hostlist quality metric
  */
@@ -302,6 +309,13 @@ static int stat_learning;
  */
 static unsigned int stat_download_successful;
 
+/**
+ * Set to #GNUNET_YES if we aborted the current download on purpose
+ * after obtaining enough HELLOs; the write error CURL reports for
+ * the aborted transfer is then counted as a success
+ */
+static int stat_download_aborted;
+
 /**
  * Value saying how many valid HELLO messages were obtained during download
  */
@@ -342,6 +356,18 @@ callback_download (void *ptr,
   {
     return total;               /* ok, no data or bogus data */
   }
+  if (stat_hellos_obtained >= MAX_HELLOS_PER_DOWNLOAD)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_INFO,
+                _("Obtained %u HELLOs from `%s', aborting remainder of download\n"),
+                stat_hellos_obtained, current_url);
+    GNUNET_STATISTICS_update (stats,
+                              gettext_noop
+                              ("# hostlist downloads aborted early (enough HELLOs)"),
+                              1, GNUNET_NO);
+    stat_download_aborted = GNUNET_YES;
+    return 0;                   /* causes CURL to abort the transfer */
+  }
 
   GNUNET_STATISTICS_update (stats,
                             gettext_noop
@@ -896,7 +922,9 @@ task_download (void *cls,
         {
         case CURLMSG_DONE:
           if ((msg->data.result != CURLE_OK) &&
-              (msg->data.result != CURLE_GOT_NOTHING))
+              (msg->data.result != CURLE_GOT_NOTHING) &&
+              ( (GNUNET_YES != stat_download_aborted) ||
+                (msg->data.result != CURLE_WRITE_ERROR) ))
             GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
                         _("Download of hostlist from `%s' failed: `%s'\n"),
                         current_url,
@@ -969,6 +997,7 @@ download_hostlist ()
 
   stat_download_in_progress = GNUNET_YES;
   stat_download_successful = GNUNET_NO;
+  stat_download_aborted = GNUNET_NO;
   stat_hellos_obtained = 0;
   stat_bytes_downloaded = 0;
 
@@ -1018,6 +1047,10 @@ download_hostlist ()
     CURL_EASY_SETOPT (curl, CURLOPT_USERAGENT, "GNUnet");
   CURL_EASY_SETOPT (curl, CURLOPT_CONNECTTIMEOUT, 60L);
   CURL_EASY_SETOPT (curl, CURLOPT_TIMEOUT, 60L);
+  /* fail over quickly if a mirror stalls instead of waiting for the
+   * full timeout; the next attempt will likely pick another URL */
+  CURL_EASY_SETOPT (curl, CURLOPT_LOW_SPEED_LIMIT, 100L);
+  CURL_EASY_SETOPT (curl, CURLOPT_LOW_SPEED_TIME, 15L);
   multi = curl_multi_init ();
   if (multi == NULL)
   {
@@ -27,6 +27,7 @@
  */
 #include "platform.h"
 #include <microhttpd.h>
+#include <zlib.h>
 #include "gnunet-daemon-hostlist_server.h"
 #include "gnunet_hello_lib.h"
 #include "gnunet_peerinfo_service.h"
@@ -86,6 +87,19 @@ static struct GNUNET_SCHEDULER_Task * hostlist_task_v6;
  */
 static struct MHD_Response *response;
 
+/**
+ * Deflate-compressed version of our canonical response, NULL if
+ * compression failed or did not shrink the hostlist.
+ */
+static struct MHD_Response *response_deflate;
+
+/**
+ * Entity tag (quoted, derived from the hash of the hostlist) for
+ * the current #response; changes whenever the hostlist is rebuilt
+ * with different contents.
+ */
+static char response_etag[32];
+
 /**
  * Handle for accessing peerinfo service.
  */
@@ -164,20 +178,75 @@ add_cors_headers (struct MHD_Response *response)
 static void
 finish_response ()
 {
+  struct GNUNET_HashCode hc;
+  char *cbuf;
+  uLongf clen;
+
   if (NULL != response)
     MHD_destroy_response (response);
+  if (NULL != response_deflate)
+  {
+    MHD_destroy_response (response_deflate);
+    response_deflate = NULL;
+  }
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Creating hostlist response with %u bytes\n",
               (unsigned int) builder->size);
+  GNUNET_CRYPTO_hash (builder->data,
+                      builder->size,
+                      &hc);
+  GNUNET_snprintf (response_etag,
+                   sizeof (response_etag),
+                   "\"%08X%08X\"",
+                   (unsigned int) hc.bits[0],
+                   (unsigned int) hc.bits[1]);
+#ifdef compressBound
+  clen = compressBound (builder->size);
+#else
+  clen = builder->size + (builder->size / 100) + 20;
+  /* documentation says 100.1% oldSize + 12 bytes, but we
+   * should be able to overshoot by more to be safe */
+#endif
+  cbuf = GNUNET_malloc (clen);
+  if ( (Z_OK ==
+        compress2 ((Bytef *) cbuf, &clen,
+                   (const Bytef *) builder->data, builder->size, 9)) &&
+       (clen < builder->size) )
+  {
+    response_deflate =
+        MHD_create_response_from_buffer (clen,
+                                         cbuf,
+                                         MHD_RESPMEM_MUST_FREE);
+    add_cors_headers (response_deflate);
+    MHD_add_response_header (response_deflate,
+                             MHD_HTTP_HEADER_CONTENT_ENCODING,
+                             "deflate");
+    MHD_add_response_header (response_deflate,
+                             MHD_HTTP_HEADER_ETAG,
+                             response_etag);
+  }
+  else
+  {
+    /* compression failed or did not help, only serve uncompressed */
+    GNUNET_free (cbuf);
+  }
   response =
       MHD_create_response_from_buffer (builder->size,
                                        builder->data,
                                        MHD_RESPMEM_MUST_FREE);
   add_cors_headers (response);
+  MHD_add_response_header (response,
+                           MHD_HTTP_HEADER_ETAG,
+                           response_etag);
   if ((NULL == daemon_handle_v4) && (NULL == daemon_handle_v6))
   {
     MHD_destroy_response (response);
     response = NULL;
+    if (NULL != response_deflate)
+    {
+      MHD_destroy_response (response_deflate);
+      response_deflate = NULL;
+    }
   }
   GNUNET_STATISTICS_set (stats, gettext_noop ("bytes in hostlist"),
                          builder->size, GNUNET_YES);
@@ -368,6 +437,8 @@ access_handler_callback (void *cls,
                          void **con_cls)
 {
   static int dummy;
+  const char *if_none_match;
+  const char *accept_encoding;
 
   /* CORS pre-flight request */
   if (0 == strcmp (MHD_HTTP_METHOD_OPTIONS, method))
@@ -423,6 +494,48 @@ access_handler_callback (void *cls,
   GNUNET_STATISTICS_update (stats,
                             gettext_noop ("hostlist requests processed"),
                             1, GNUNET_YES);
+  if_none_match = MHD_lookup_connection_value (connection,
+                                               MHD_HEADER_KIND,
+                                               MHD_HTTP_HEADER_IF_NONE_MATCH);
+  if ( (NULL != if_none_match) &&
+       (0 == strcmp (if_none_match,
+                     response_etag)) )
+  {
+    struct MHD_Response *not_modified_response;
+    int rc;
+
+    /* client already has the current hostlist, spare the transfer */
+    GNUNET_STATISTICS_update (stats,
+                              gettext_noop
+                              ("hostlist requests answered with `not modified'"),
+                              1, GNUNET_YES);
+    not_modified_response =
+        MHD_create_response_from_buffer (0, NULL,
+                                         MHD_RESPMEM_PERSISTENT);
+    add_cors_headers (not_modified_response);
+    MHD_add_response_header (not_modified_response,
+                             MHD_HTTP_HEADER_ETAG,
+                             response_etag);
+    rc = MHD_queue_response (connection,
+                             MHD_HTTP_NOT_MODIFIED,
+                             not_modified_response);
+    MHD_destroy_response (not_modified_response);
+    return rc;
+  }
+  accept_encoding = MHD_lookup_connection_value (connection,
+                                                 MHD_HEADER_KIND,
+                                                 MHD_HTTP_HEADER_ACCEPT_ENCODING);
+  if ( (NULL != response_deflate) &&
+       (NULL != accept_encoding) &&
+       (NULL != strstr (accept_encoding,
+                        "deflate")) )
+  {
+    GNUNET_STATISTICS_update (stats,
+                              gettext_noop
+                              ("hostlist requests answered with compressed response"),
+                              1, GNUNET_YES);
+    return MHD_queue_response (connection, MHD_HTTP_OK, response_deflate);
+  }
   return MHD_queue_response (connection, MHD_HTTP_OK, response);
 }
 
@@ -942,6 +1055,11 @@ GNUNET_HOSTLIST_server_stop ()
     MHD_destroy_response (response);
     response = NULL;
   }
+  if (NULL != response_deflate)
+  {
+    MHD_destroy_response (response_deflate);
+    response_deflate = NULL;
+  }
   if (NULL != notify)
   {
     GNUNET_PEERINFO_notify_cancel (notify);
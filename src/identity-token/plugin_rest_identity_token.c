@@ -153,6 +153,16 @@ struct EgoEntry
 
 struct RequestHandle
 {
+  /**
+   * DLL of requests that arrived before the initial ego listing
+   */
+  struct RequestHandle *next;
+
+  /**
+   * DLL of requests that arrived before the initial ego listing
+   */
+  struct RequestHandle *prev;
+
   /**
    * Ego list
    */
@@ -172,27 +182,12 @@ struct RequestHandle
    * Handle to the rest connection
    */
   struct RestConnectionDataHandle *conndata_handle;
-  
-  /**
-   * The processing state
-   */
-  int state;
-
-  /**
-   * Handle to Identity service.
-   */
-  struct GNUNET_IDENTITY_Handle *identity_handle;
 
   /**
    * IDENTITY Operation
    */
   struct GNUNET_IDENTITY_Operation *op;
 
-  /**
-   * Handle to NS service
-   */
-  struct GNUNET_NAMESTORE_Handle *ns_handle;
-
   /**
    * NS iterator
    */
@@ -253,11 +248,6 @@ struct RequestHandle
    */
   char *emsg;
 
-  /**
-   * JSON header
-   */
-  json_t *header;
-
   /**
    * JSON payload
    */
@@ -277,6 +267,74 @@ struct RequestHandle
 };
 
 
+/**
+ * Handle to the identity service, kept for the lifetime of the
+ * plugin so that requests do not wait for a fresh ego listing.
+ */
+static struct GNUNET_IDENTITY_Handle *identity_handle;
+
+/**
+ * Handle to the namestore, shared by all requests.
+ */
+static struct GNUNET_NAMESTORE_Handle *ns_handle;
+
+/**
+ * Ego registry head; kept current by the identity service.
+ */
+static struct EgoEntry *ego_head;
+
+/**
+ * Ego registry tail
+ */
+static struct EgoEntry *ego_tail;
+
+/**
+ * State of the initial ego listing
+ */
+static int state;
+
+/**
+ * Head of requests that arrived before the initial ego listing finished
+ */
+static struct RequestHandle *requests_head;
+
+/**
+ * Tail of requests that arrived before the initial ego listing finished
+ */
+static struct RequestHandle *requests_tail;
+
+/**
+ * Base64 encoding of the constant token header; created on first
+ * use and reused for every issued token.
+ */
+static char *header_b64;
+
+/**
+ * Hash of the issuer url parameter name
+ */
+static struct GNUNET_HashCode hash_key_iss;
+
+/**
+ * Hash of the audience url parameter name
+ */
+static struct GNUNET_HashCode hash_key_aud;
+
+/**
+ * Hash of the expiration url parameter name
+ */
+static struct GNUNET_HashCode hash_key_exp;
+
+/**
+ * Hash of the renewal url parameter name
+ */
+static struct GNUNET_HashCode hash_key_renew;
+
+/**
+ * Hash of the attribute list url parameter name
+ */
+static struct GNUNET_HashCode hash_key_attrs;
+
+
 /**
  * Cleanup lookup handle
  * @param handle Handle to clean up
@@ -294,14 +352,10 @@ cleanup_handle (struct RequestHandle *handle)
     GNUNET_free (handle->name);
   if (NULL != handle->timeout_task)
     GNUNET_SCHEDULER_cancel (handle->timeout_task);
-  if (NULL != handle->identity_handle)
-    GNUNET_IDENTITY_disconnect (handle->identity_handle);
   if (NULL != handle->ns_it)
     GNUNET_NAMESTORE_zone_iteration_stop (handle->ns_it);
   if (NULL != handle->ns_qe)
     GNUNET_NAMESTORE_cancel (handle->ns_qe);
-  if (NULL != handle->ns_handle)
-    GNUNET_NAMESTORE_disconnect (handle->ns_handle);
   if (NULL != handle->attr_map)
     GNUNET_CONTAINER_multihashmap_destroy (handle->attr_map);
 
@@ -398,10 +452,9 @@ static void
 sign_and_return_token (void *cls,
                        const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
-  char *header_str;
   char *payload_str;
-  char *header_base64;
   char *payload_base64;
+  char *padding;
   char *sig_str;
   char *lbl_str;
   char *token;
@@ -418,7 +471,6 @@ sign_and_return_token (void *cls,
   struct JsonApiResource *json_resource;
   struct RequestHandle *handle = cls;
   struct GNUNET_GNSRECORD_Data token_record;
-  struct GNUNET_HashCode key;
   struct GNUNET_TIME_Relative etime_rel;
   int renew_token = GNUNET_NO;
 
@@ -426,17 +478,13 @@ sign_and_return_token (void *cls,
   lbl = GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_STRONG, UINT64_MAX);
   GNUNET_STRINGS_base64_encode ((char*)&lbl, sizeof (uint64_t), &lbl_str);
 
-  GNUNET_CRYPTO_hash (GNUNET_IDENTITY_TOKEN_EXP_STRING,
-                      strlen (GNUNET_IDENTITY_TOKEN_EXP_STRING),
-                      &key);
-
   //Get expiration for token from URL parameter
   exp_str = NULL;
   if (GNUNET_YES == GNUNET_CONTAINER_multihashmap_contains (handle->conndata_handle->url_param_map,
-                                                            &key))
+                                                            &hash_key_exp))
   {
     exp_str = GNUNET_CONTAINER_multihashmap_get (handle->conndata_handle->url_param_map,
-                                                   &key);
+                                                   &hash_key_exp);
   }
 
   if (NULL == exp_str) {
@@ -456,16 +504,11 @@ sign_and_return_token (void *cls,
   exp_time = time + etime_rel.rel_value_us;
   
   //Get renewal policy for token
-  GNUNET_CRYPTO_hash (GNUNET_IDENTITY_TOKEN_RENEW_TOKEN,
-                      strlen (GNUNET_IDENTITY_TOKEN_RENEW_TOKEN),
-                      &key);
-
-
   if (GNUNET_YES == GNUNET_CONTAINER_multihashmap_contains (handle->conndata_handle->url_param_map,
-                                                            &key))
+                                                            &hash_key_renew))
   {
     renew_str = GNUNET_CONTAINER_multihashmap_get (handle->conndata_handle->url_param_map,
-                                                   &key);
+                                                   &hash_key_renew);
     if (0 == strcmp (renew_str, "true"))
       renew_token = GNUNET_YES;
   }
@@ -480,13 +523,25 @@ sign_and_return_token (void *cls,
     json_object_set_new (handle->payload, "rnl", json_string ("yes"));
   }
 
-  header_str = json_dumps (handle->header, JSON_COMPACT);
-  GNUNET_STRINGS_base64_encode (header_str,
-                                strlen (header_str),
-                                &header_base64);
-  char* padding = strtok(header_base64, "=");
-  while (NULL != padding)
-    padding = strtok(NULL, "=");
+  if (NULL == header_b64)
+  {
+    //The token header is constant; encode it once
+    json_t *header;
+    char *header_str;
+
+    header = json_object ();
+    json_object_set_new (header, "alg", json_string ("ED512"));
+    json_object_set_new (header, "typ", json_string ("JWT"));
+    header_str = json_dumps (header, JSON_COMPACT);
+    GNUNET_STRINGS_base64_encode (header_str,
+                                  strlen (header_str),
+                                  &header_b64);
+    padding = strtok(header_b64, "=");
+    while (NULL != padding)
+      padding = strtok(NULL, "=");
+    GNUNET_free (header_str);
+    json_decref (header);
+  }
 
   payload_str = json_dumps (handle->payload, JSON_COMPACT);
   GNUNET_STRINGS_base64_encode (payload_str,
@@ -496,7 +551,7 @@ sign_and_return_token (void *cls,
   while (NULL != padding)
     padding = strtok(NULL, "=");
 
-  GNUNET_asprintf (&token, "%s,%s", header_base64, payload_base64);
+  GNUNET_asprintf (&token, "%s,%s", header_b64, payload_base64);
   priv_key = GNUNET_IDENTITY_ego_get_private_key (handle->ego_entry->ego);
   purpose = 
     GNUNET_malloc (sizeof (struct GNUNET_CRYPTO_EccSignaturePurpose) + 
@@ -513,14 +568,11 @@ sign_and_return_token (void *cls,
   sig_str = GNUNET_STRINGS_data_to_string_alloc (&sig,
                                                  sizeof (struct GNUNET_CRYPTO_EcdsaSignature));
   GNUNET_asprintf (&token, "%s.%s.%s",
-                   header_base64, payload_base64, sig_str);
+                   header_b64, payload_base64, sig_str);
   GNUNET_free (sig_str);
-  GNUNET_free (header_str);
-  GNUNET_free (header_base64);
   GNUNET_free (payload_str);
   GNUNET_free (payload_base64);
   GNUNET_free (purpose);
-  json_decref (handle->header);
   json_decref (handle->payload);
 
   handle->resp_object = GNUNET_REST_jsonapi_object_new ();
@@ -548,7 +600,7 @@ sign_and_return_token (void *cls,
   if (GNUNET_YES == renew_token)
     token_record.flags |= GNUNET_GNSRECORD_RF_RELATIVE_EXPIRATION;
   //Persist token
-  handle->ns_qe = GNUNET_NAMESTORE_records_store (handle->ns_handle,
+  handle->ns_qe = GNUNET_NAMESTORE_records_store (ns_handle,
                                                   priv_key,
                                                   lbl_str,
                                                   1,
@@ -658,7 +710,6 @@ issue_token_cont (struct RestConnectionDataHandle *con,
   char *audience;
   struct RequestHandle *handle = cls;
   struct EgoEntry *ego_entry;
-  struct GNUNET_HashCode key;
   struct MHD_Response *resp;
   const struct GNUNET_CRYPTO_EcdsaPrivateKey *priv_key;
 
@@ -674,15 +725,12 @@ issue_token_cont (struct RestConnectionDataHandle *con,
 
   egoname = NULL;
   ego_entry = NULL;
-  GNUNET_CRYPTO_hash (GNUNET_REST_JSONAPI_IDENTITY_ISS_REQUEST,
-                      strlen (GNUNET_REST_JSONAPI_IDENTITY_ISS_REQUEST),
-                      &key);
   if ( GNUNET_YES ==
        GNUNET_CONTAINER_multihashmap_contains (handle->conndata_handle->url_param_map,
-                                               &key) )
+                                               &hash_key_iss) )
   {
     ego_val = GNUNET_CONTAINER_multihashmap_get (handle->conndata_handle->url_param_map,
-                                                 &key);
+                                                 &hash_key_iss);
     if (NULL == ego_val)
       GNUNET_log (GNUNET_ERROR_TYPE_ERROR, "Ego invalid: %s\n", ego_val);
     if (NULL != ego_val)
@@ -707,15 +755,12 @@ issue_token_cont (struct RestConnectionDataHandle *con,
     }
   }
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Ego to issue token for: %s\n", egoname);
-  GNUNET_CRYPTO_hash (GNUNET_REST_JSONAPI_IDENTITY_AUD_REQUEST,
-                      strlen (GNUNET_REST_JSONAPI_IDENTITY_AUD_REQUEST),
-                      &key);
 
   //Token audience
   audience = NULL;
   if ( GNUNET_YES !=
        GNUNET_CONTAINER_multihashmap_contains (handle->conndata_handle->url_param_map,
-                                               &key) )
+                                               &hash_key_aud) )
   {
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR, "Audience missing!\n");
     resp = GNUNET_REST_create_json_response (NULL);
@@ -724,11 +769,8 @@ issue_token_cont (struct RestConnectionDataHandle *con,
     return;
   }
   audience = GNUNET_CONTAINER_multihashmap_get (handle->conndata_handle->url_param_map,
-                                                &key);
+                                                &hash_key_aud);
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Audience to issue token for: %s\n", audience);
-  handle->header = json_object ();
-  json_object_set_new (handle->header, "alg", json_string ("ED512"));
-  json_object_set_new (handle->header, "typ", json_string ("JWT"));
 
   handle->payload = json_object ();
   json_object_set_new (handle->payload, "iss", json_string (ego_entry->keystring));
@@ -736,10 +778,11 @@ issue_token_cont (struct RestConnectionDataHandle *con,
 
 
   //Get identity attributes
-  handle->ns_handle = GNUNET_NAMESTORE_connect (cfg);
+  if (NULL == ns_handle)
+    ns_handle = GNUNET_NAMESTORE_connect (cfg);
   priv_key = GNUNET_IDENTITY_ego_get_private_key (ego_entry->ego);
   handle->ego_entry = ego_entry;
-  handle->ns_it = GNUNET_NAMESTORE_zone_iteration_start (handle->ns_handle,
+  handle->ns_it = GNUNET_NAMESTORE_zone_iteration_start (ns_handle,
                                                          priv_key,
                                                          &attr_collect,
                                                          handle);
@@ -811,7 +854,7 @@ token_collect (void *cls,
 
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Next ego: %s\n", handle->ego_head->identifier);
     priv_key = GNUNET_IDENTITY_ego_get_private_key (handle->ego_head->ego);
-    handle->ns_it = GNUNET_NAMESTORE_zone_iteration_start (handle->ns_handle,
+    handle->ns_it = GNUNET_NAMESTORE_zone_iteration_start (ns_handle,
                                                            priv_key,
                                                            &token_collect,
                                                            handle);
@@ -862,22 +905,17 @@ list_token_cont (struct RestConnectionDataHandle *con_handle,
                  void *cls)
 {
   char* ego_val;
-  struct GNUNET_HashCode key;
   const struct GNUNET_CRYPTO_EcdsaPrivateKey *priv_key;
   struct RequestHandle *handle = cls;
   struct EgoEntry *ego_entry;
   struct EgoEntry *ego_tmp;
 
-  GNUNET_CRYPTO_hash (GNUNET_REST_JSONAPI_IDENTITY_ISS_REQUEST,
-                      strlen (GNUNET_REST_JSONAPI_IDENTITY_ISS_REQUEST),
-                      &key);
-
   if ( GNUNET_YES ==
        GNUNET_CONTAINER_multihashmap_contains (handle->conndata_handle->url_param_map,
-                                               &key) )
+                                               &hash_key_iss) )
   {
     ego_val = GNUNET_CONTAINER_multihashmap_get (handle->conndata_handle->url_param_map,
-                                                 &key);
+                                                 &hash_key_iss);
     //Remove non-matching egos
     for (ego_entry = handle->ego_head;
          NULL != ego_entry;)
@@ -904,8 +942,9 @@ list_token_cont (struct RestConnectionDataHandle *con_handle,
     return;
   }
   priv_key = GNUNET_IDENTITY_ego_get_private_key (handle->ego_head->ego);
-  handle->ns_handle = GNUNET_NAMESTORE_connect (cfg);
-  handle->ns_it = GNUNET_NAMESTORE_zone_iteration_start (handle->ns_handle,
+  if (NULL == ns_handle)
+    ns_handle = GNUNET_NAMESTORE_connect (cfg);
+  handle->ns_it = GNUNET_NAMESTORE_zone_iteration_start (ns_handle,
                                                          priv_key,
                                                          &token_collect,
                                                          handle);
@@ -961,6 +1000,34 @@ init_cont (struct RequestHandle *handle)
   }
 }
 
+
+/**
+ * Dispatch a request on a snapshot of the ego registry;
+ * the handlers consume their ego list destructively.
+ *
+ * @param handle the request to dispatch
+ */
+static void
+run_request (struct RequestHandle *handle)
+{
+  struct EgoEntry *ego_entry;
+  struct EgoEntry *copy;
+
+  for (ego_entry = ego_head;
+       NULL != ego_entry;
+       ego_entry = ego_entry->next)
+  {
+    copy = GNUNET_new (struct EgoEntry);
+    copy->identifier = GNUNET_strdup (ego_entry->identifier);
+    copy->keystring = GNUNET_strdup (ego_entry->keystring);
+    copy->ego = ego_entry->ego;
+    GNUNET_CONTAINER_DLL_insert_tail (handle->ego_head,
+                                      handle->ego_tail,
+                                      copy);
+  }
+  init_cont (handle);
+}
+
 /**
  * If listing is enabled, prints information about the egos.
  *
@@ -1000,26 +1067,57 @@ list_ego (void *cls,
           void **ctx,
           const char *identifier)
 {
-  struct RequestHandle *handle = cls;
+  struct RequestHandle *handle;
   struct EgoEntry *ego_entry;
   struct GNUNET_CRYPTO_EcdsaPublicKey pk;
 
-  if ((NULL == ego) && (ID_REST_STATE_INIT == handle->state))
+  if ((NULL == ego) && (ID_REST_STATE_INIT == state))
+  {
+    state = ID_REST_STATE_POST_INIT;
+    //Dispatch requests that arrived before the initial listing finished
+    while (NULL != (handle = requests_head))
+    {
+      GNUNET_CONTAINER_DLL_remove (requests_head,
+                                   requests_tail,
+                                   handle);
+      run_request (handle);
+    }
+    return;
+  }
+  if (NULL == ego)
+    return;
+  for (ego_entry = ego_head;
+       NULL != ego_entry;
+       ego_entry = ego_entry->next)
+    if (ego_entry->ego == ego)
+      break;
+  if (NULL == identifier)
   {
-    handle->state = ID_REST_STATE_POST_INIT;
-    init_cont (handle);
+    //Ego was deleted
+    if (NULL == ego_entry)
+      return;
+    GNUNET_CONTAINER_DLL_remove (ego_head,
+                                 ego_tail,
+                                 ego_entry);
+    GNUNET_free (ego_entry->identifier);
+    GNUNET_free (ego_entry->keystring);
+    GNUNET_free (ego_entry);
     return;
   }
-  if (ID_REST_STATE_INIT == handle->state) {
-    ego_entry = GNUNET_new (struct EgoEntry);
-    GNUNET_IDENTITY_ego_get_public_key (ego, &pk);
-    ego_entry->keystring = 
-      GNUNET_CRYPTO_ecdsa_public_key_to_string (&pk);
-    ego_entry->ego = ego;
+  if (NULL != ego_entry)
+  {
+    //Ego was renamed
+    GNUNET_free (ego_entry->identifier);
     GNUNET_asprintf (&ego_entry->identifier, "%s", identifier);
-    GNUNET_CONTAINER_DLL_insert_tail(handle->ego_head,handle->ego_tail, ego_entry);
+    return;
   }
-
+  ego_entry = GNUNET_new (struct EgoEntry);
+  GNUNET_IDENTITY_ego_get_public_key (ego, &pk);
+  ego_entry->keystring = 
+    GNUNET_CRYPTO_ecdsa_public_key_to_string (&pk);
+  ego_entry->ego = ego;
+  GNUNET_asprintf (&ego_entry->identifier, "%s", identifier);
+  GNUNET_CONTAINER_DLL_insert_tail(ego_head,ego_tail, ego_entry);
 }
 
 /**
@@ -1044,26 +1142,21 @@ rest_identity_process_request(struct RestConnectionDataHandle *conndata_handle,
   char* attr_list_tmp;
   char* attr;
 
-  GNUNET_CRYPTO_hash (GNUNET_IDENTITY_TOKEN_ATTR_LIST,
-                      strlen (GNUNET_IDENTITY_TOKEN_ATTR_LIST),
-                      &key);
-
   handle->timeout = GNUNET_TIME_UNIT_FOREVER_REL;
 
   handle->proc_cls = proc_cls;
   handle->proc = proc;
-  handle->state = ID_REST_STATE_INIT;
   handle->conndata_handle = conndata_handle;
   handle->data = conndata_handle->data;
   handle->data_size = conndata_handle->data_size;
   handle->method = conndata_handle->method;
   if (GNUNET_YES == GNUNET_CONTAINER_multihashmap_contains (handle->conndata_handle->url_param_map,
-                                                            &key))
+                                                            &hash_key_attrs))
   {
     handle->attr_map = GNUNET_CONTAINER_multihashmap_create (5,
                                                              GNUNET_NO);
     attr_list = GNUNET_CONTAINER_multihashmap_get (handle->conndata_handle->url_param_map,
-                                                   &key);
+                                                   &hash_key_attrs);
     if (NULL != attr_list)
     {
       attr_list_tmp = GNUNET_strdup (attr_list);
@@ -1086,19 +1179,19 @@ rest_identity_process_request(struct RestConnectionDataHandle *conndata_handle,
   GNUNET_asprintf (&handle->url, "%s", conndata_handle->url);
   if (handle->url[strlen (handle->url)-1] == '/')
     handle->url[strlen (handle->url)-1] = '\0';
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "Connecting...\n");
-  handle->identity_handle = GNUNET_IDENTITY_connect (cfg,
-                                                     &list_ego,
-                                                     handle);
   handle->timeout_task =
     GNUNET_SCHEDULER_add_delayed (handle->timeout,
                                   &do_error,
                                   handle);
-
-
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "Connected\n");
+  if (ID_REST_STATE_INIT == state)
+  {
+    //Initial ego listing not done yet; dispatch once it is
+    GNUNET_CONTAINER_DLL_insert_tail (requests_head,
+                                      requests_tail,
+                                      handle);
+    return;
+  }
+  run_request (handle);
 }
 
 /**
@@ -1122,6 +1215,25 @@ libgnunet_plugin_rest_identity_token_init (void *cls)
   api->cls = &plugin;
   api->name = GNUNET_REST_API_NS_IDENTITY_TOKEN;
   api->process_request = &rest_identity_process_request;
+  GNUNET_CRYPTO_hash (GNUNET_REST_JSONAPI_IDENTITY_ISS_REQUEST,
+                      strlen (GNUNET_REST_JSONAPI_IDENTITY_ISS_REQUEST),
+                      &hash_key_iss);
+  GNUNET_CRYPTO_hash (GNUNET_REST_JSONAPI_IDENTITY_AUD_REQUEST,
+                      strlen (GNUNET_REST_JSONAPI_IDENTITY_AUD_REQUEST),
+                      &hash_key_aud);
+  GNUNET_CRYPTO_hash (GNUNET_IDENTITY_TOKEN_EXP_STRING,
+                      strlen (GNUNET_IDENTITY_TOKEN_EXP_STRING),
+                      &hash_key_exp);
+  GNUNET_CRYPTO_hash (GNUNET_IDENTITY_TOKEN_RENEW_TOKEN,
+                      strlen (GNUNET_IDENTITY_TOKEN_RENEW_TOKEN),
+                      &hash_key_renew);
+  GNUNET_CRYPTO_hash (GNUNET_IDENTITY_TOKEN_ATTR_LIST,
+                      strlen (GNUNET_IDENTITY_TOKEN_ATTR_LIST),
+                      &hash_key_attrs);
+  state = ID_REST_STATE_INIT;
+  identity_handle = GNUNET_IDENTITY_connect (cfg,
+                                             &list_ego,
+                                             NULL);
   GNUNET_asprintf (&allow_methods,
                    "%s, %s, %s, %s, %s",
                    MHD_HTTP_METHOD_GET,
@@ -1147,8 +1259,33 @@ libgnunet_plugin_rest_identity_token_done (void *cls)
 {
   struct GNUNET_REST_Plugin *api = cls;
   struct Plugin *plugin = api->cls;
+  struct EgoEntry *ego_entry;
+  struct EgoEntry *ego_tmp;
 
   plugin->cfg = NULL;
+  if (NULL != identity_handle)
+  {
+    GNUNET_IDENTITY_disconnect (identity_handle);
+    identity_handle = NULL;
+  }
+  if (NULL != ns_handle)
+  {
+    GNUNET_NAMESTORE_disconnect (ns_handle);
+    ns_handle = NULL;
+  }
+  for (ego_entry = ego_head;
+       NULL != ego_entry;)
+  {
+    ego_tmp = ego_entry;
+    ego_entry = ego_entry->next;
+    GNUNET_free (ego_tmp->identifier);
+    GNUNET_free (ego_tmp->keystring);
+    GNUNET_free (ego_tmp);
+  }
+  ego_head = NULL;
+  ego_tail = NULL;
+  GNUNET_free_non_null (header_b64);
+  header_b64 = NULL;
   GNUNET_free_non_null (allow_methods);
   GNUNET_free (api);
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
@@ -65,6 +65,14 @@ struct Ego
    */
   char *identifier;
 
+  /**
+   * Cached serialized update message for the ego, created on demand
+   * by #get_update_message() and invalidated whenever the ego
+   * changes.  Avoids re-serializing every ego for every client
+   * that connects.
+   */
+  struct GNUNET_IDENTITY_UpdateMessage *update_msg;
+
 };
 
 
@@ -162,6 +170,7 @@ shutdown_task (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
     GNUNET_CONTAINER_DLL_remove (ego_head, ego_tail, e);
     GNUNET_free (e->pk);
     GNUNET_free (e->identifier);
+    GNUNET_free_non_null (e->update_msg);
     GNUNET_free (e);
   }
 }
@@ -202,17 +211,21 @@ send_result_code (struct GNUNET_SERVER_Client *client,
 
 
 /**
- * Create an update message with information about the current state of an ego.
+ * Obtain the update message with information about the current state
+ * of an ego.  The message is cached with the ego; callers must not
+ * free the result.
  *
- * @param ego ego to create message for
+ * @param ego ego to get the message for
  * @return corresponding update message
  */
-static struct GNUNET_IDENTITY_UpdateMessage *
-create_update_message (struct Ego *ego)
+static const struct GNUNET_IDENTITY_UpdateMessage *
+get_update_message (struct Ego *ego)
 {
   struct GNUNET_IDENTITY_UpdateMessage *um;
   size_t name_len;
 
+  if (NULL != ego->update_msg)
+    return ego->update_msg;
   name_len = (NULL == ego->identifier) ? 0 : (strlen (ego->identifier) + 1);
   um = GNUNET_malloc (sizeof (struct GNUNET_IDENTITY_UpdateMessage) + name_len);
   um->header.type = htons (GNUNET_MESSAGE_TYPE_IDENTITY_UPDATE);
@@ -221,6 +234,7 @@ create_update_message (struct Ego *ego)
   um->end_of_list = htons (GNUNET_NO);
   um->private_key = *ego->pk;
   memcpy (&um[1], ego->identifier, name_len);
+  ego->update_msg = um;
   return um;
 }
 
@@ -265,7 +279,7 @@ static void
 handle_start_message (void *cls, struct GNUNET_SERVER_Client *client,
                       const struct GNUNET_MessageHeader *message)
 {
-  struct GNUNET_IDENTITY_UpdateMessage *um;
+  const struct GNUNET_IDENTITY_UpdateMessage *um;
   struct GNUNET_IDENTITY_UpdateMessage ume;
   struct Ego *ego;
 
@@ -274,9 +288,8 @@ handle_start_message (void *cls, struct GNUNET_SERVER_Client *client,
   GNUNET_SERVER_notification_context_add (nc, client);
   for (ego = ego_head; NULL != ego; ego = ego->next)
   {
-    um = create_update_message (ego);
+    um = get_update_message (ego);
     GNUNET_SERVER_notification_context_unicast (nc, client, &um->header, GNUNET_NO);
-    GNUNET_free (um);
   }
   memset (&ume, 0, sizeof (ume));
   ume.header.type = htons (GNUNET_MESSAGE_TYPE_IDENTITY_UPDATE);
@@ -456,11 +469,10 @@ handle_set_default_message (void *cls, struct GNUNET_SERVER_Client *client,
 static void
 notify_listeners (struct Ego *ego)
 {
-  struct GNUNET_IDENTITY_UpdateMessage *um;
+  const struct GNUNET_IDENTITY_UpdateMessage *um;
 
-  um = create_update_message (ego);
+  um = get_update_message (ego);
   GNUNET_SERVER_notification_context_broadcast (nc, &um->header, GNUNET_NO);
-  GNUNET_free (um);
 }
 
 
@@ -658,6 +670,8 @@ handle_rename_message (void *cls, struct GNUNET_SERVER_Client *client,
     {
       fn_old = get_ego_filename (ego);
       GNUNET_free (ego->identifier);
+      GNUNET_free_non_null (ego->update_msg);
+      ego->update_msg = NULL;
       rename_ctx.old_name = old_name;
       rename_ctx.new_name = new_name;
       GNUNET_CONFIGURATION_iterate_sections (subsystem_cfg,
@@ -783,8 +797,11 @@ handle_delete_message (void *cls, struct GNUNET_SERVER_Client *client,
       GNUNET_free (fn);
       GNUNET_free (ego->identifier);
       ego->identifier = NULL;
+      GNUNET_free_non_null (ego->update_msg);
+      ego->update_msg = NULL;
       notify_listeners (ego);
       GNUNET_free (ego->pk);
+      GNUNET_free_non_null (ego->update_msg);
       GNUNET_free (ego);
       send_result_code (client, 0, NULL);
       GNUNET_SERVER_receive_done (client, GNUNET_OK);
@@ -821,9 +838,16 @@ process_ego_file (void *cls,
     return GNUNET_OK;
   }
   ego = GNUNET_new (struct Ego);
-  ego->pk = GNUNET_CRYPTO_ecdsa_key_create_from_file (filename);
-  if (NULL == ego->pk)
+  ego->pk = GNUNET_new (struct GNUNET_CRYPTO_EcdsaPrivateKey);
+  /* we are the only writer of the ego directory, so a plain read
+     suffices; GNUNET_CRYPTO_ecdsa_key_create_from_file() would take
+     and release a file lock for every single ego */
+  if (sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey) !=
+      GNUNET_DISK_fn_read (filename,
+			   ego->pk,
+			   sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey)))
   {
+    GNUNET_free (ego->pk);
     GNUNET_free (ego);
     GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
                 _("Failed to parse ego information in `%s'\n"),
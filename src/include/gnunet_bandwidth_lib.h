@@ -120,6 +120,13 @@ struct GNUNET_BANDWIDTH_Tracker
    */
   struct GNUNET_TIME_Absolute last_update__;
 
+  /**
+   * Maximum number of bytes that may accumulate, precomputed
+   * from @e available_bytes_per_s__ and @e max_carry_s__
+   * whenever the quota changes.
+   */
+  uint64_t max_carry_bytes__;
+
   /**
    * Bandwidth limit to enforce in bytes per s.
    */
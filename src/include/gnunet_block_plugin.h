@@ -115,6 +115,16 @@ struct GNUNET_BLOCK_PluginFunctions
    */
   GNUNET_BLOCK_GetKeyFunction get_key;
 
+  /**
+   * Set to #GNUNET_YES if the cryptographic checks performed by
+   * @e evaluate depend only on the bytes of the reply block and
+   * @e evaluate honors #GNUNET_BLOCK_EO_LOCAL_SKIP_CRYPTO.  The
+   * block library may then memoize positive verification results
+   * by block hash and skip the expensive checks when the same
+   * bytes are evaluated again.
+   */
+  int crypto_cacheable;
+
 };
 
 /** @} */ /* end of group block */
@@ -419,6 +419,22 @@ uint16_t
 GNUNET_CRYPTO_crc16_finish (uint32_t sum);
 
 
+/**
+ * Update an internet checksum after a 16-bit field in the covered
+ * data was rewritten, without re-summing the entire buffer
+ * (RFC 1624, Eqn. 3).  All values are in network byte order.
+ *
+ * @param sum current checksum (as stored in the header)
+ * @param old_val old value of the rewritten 16-bit field
+ * @param new_val new value of the rewritten 16-bit field
+ * @return updated checksum
+ */
+uint16_t
+GNUNET_CRYPTO_crc16_rewrite (uint16_t sum,
+                             uint16_t old_val,
+                             uint16_t new_val);
+
+
 /**
  * @ingroup hash
  * Calculate the checksum of a buffer in one step.
@@ -649,6 +665,23 @@ GNUNET_CRYPTO_hash (const void *block,
                     struct GNUNET_HashCode *ret);
 
 
+/**
+ * @ingroup hash
+ * Compute hashes of multiple independent blocks, amortizing the
+ * hash context setup across all of them.
+ *
+ * @param blocks array of @a count pointers to the data to hash
+ * @param sizes array of @a count lengths, one per entry in @a blocks
+ * @param count number of blocks to hash
+ * @param rets array of @a count hash codes to write the results to
+ */
+void
+GNUNET_CRYPTO_hash_batch (const void *const *blocks,
+                          const size_t *sizes,
+                          unsigned int count,
+                          struct GNUNET_HashCode *rets);
+
+
 /**
  * Context for cummulative hashing.
  */
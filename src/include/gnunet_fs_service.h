@@ -272,6 +272,24 @@ struct GNUNET_FS_Uri *
 GNUNET_FS_uri_dup (const struct GNUNET_FS_Uri *uri);
 
 
+/**
+ * Intern a URI: if an equal URI has been interned before, return the
+ * existing shared instance (and free @a uri), otherwise register
+ * @a uri as the shared instance.  Interned URIs are reference
+ * counted; #GNUNET_FS_uri_dup() on them merely increments the
+ * counter and #GNUNET_FS_uri_destroy() decrements it.  They must
+ * not be modified by any holder of a reference.  Code that handles
+ * many duplicate URIs (i.e. search result processing) should intern
+ * them to share one representation; then equal URIs also compare
+ * equal as pointers.
+ *
+ * @param uri URI to intern (ownership is taken over)
+ * @return the shared instance (possibly @a uri itself)
+ */
+struct GNUNET_FS_Uri *
+GNUNET_FS_uri_intern (struct GNUNET_FS_Uri *uri);
+
+
 /**
  * Create an FS URI from a single user-supplied string of keywords.
  * The string is broken up at spaces into individual keywords.
@@ -2576,6 +2594,105 @@ GNUNET_FS_directory_list_contents (size_t size, const void *data,
                                    void *dep_cls);
 
 
+/**
+ * Opaque handle for iterating over a directory without
+ * eagerly decoding all entries.
+ */
+struct GNUNET_FS_DirectoryIterator;
+
+
+/**
+ * Start iterating over the entries of a serialized directory.  In
+ * contrast to #GNUNET_FS_directory_list_contents(), this iterator
+ * only locates entry boundaries and defers parsing of URIs and
+ * deserialization of meta data until the respective accessor is
+ * called for an entry; this makes iteration over very large
+ * directories cheap.  Requires the complete directory in memory
+ * (not just individual blocks); @a data must remain valid (and
+ * unmodified) until #GNUNET_FS_directory_iterator_stop() is called.
+ *
+ * @param size number of bytes in @a data
+ * @param data pointer to the beginning of the directory
+ * @return iterator positioned before the first entry,
+ *         NULL if @a data does not represent a directory
+ */
+struct GNUNET_FS_DirectoryIterator *
+GNUNET_FS_directory_iterator_start (size_t size, const void *data);
+
+
+/**
+ * Advance the iterator to the next entry in the directory.  Only
+ * decodes the entry boundaries; use the accessor functions to
+ * obtain the URI and meta data of the current entry.
+ *
+ * @param it iterator to advance
+ * @return #GNUNET_YES if the iterator now points to an entry,
+ *         #GNUNET_NO if the end of the directory was reached
+ */
+int
+GNUNET_FS_directory_iterator_next (struct GNUNET_FS_DirectoryIterator *it);
+
+
+/**
+ * Position the iterator at the given entry.  Only works for
+ * directories that carry an embedded entry index (directories
+ * serialized with #GNUNET_FS_directory_builder_finish() of this
+ * version of the library); use
+ * #GNUNET_FS_directory_iterator_get_count() to test for one.
+ *
+ * @param it iterator to position
+ * @param idx zero-based number of the desired entry
+ * @return #GNUNET_OK if the iterator now points to entry @a idx,
+ *         #GNUNET_SYSERR if there is no index or @a idx is out of bounds
+ */
+int
+GNUNET_FS_directory_iterator_seek (struct GNUNET_FS_DirectoryIterator *it,
+                                   unsigned int idx);
+
+
+/**
+ * Get the number of entries in the directory according to the
+ * embedded entry index.
+ *
+ * @param it iterator to inspect
+ * @return number of entries, 0 if the directory has no index
+ */
+unsigned int
+GNUNET_FS_directory_iterator_get_count (const struct GNUNET_FS_DirectoryIterator *it);
+
+
+/**
+ * Parse the URI of the entry the iterator points to.
+ *
+ * @param it iterator to inspect
+ * @return the URI (caller must free with #GNUNET_FS_uri_destroy),
+ *         NULL if the iterator points to no (valid) entry
+ */
+struct GNUNET_FS_Uri *
+GNUNET_FS_directory_iterator_get_uri (const struct GNUNET_FS_DirectoryIterator *it);
+
+
+/**
+ * Deserialize the meta data of the entry the iterator points to.
+ *
+ * @param it iterator to inspect
+ * @return the meta data (caller must free with
+ *         #GNUNET_CONTAINER_meta_data_destroy),
+ *         NULL if the iterator points to no (valid) entry
+ */
+struct GNUNET_CONTAINER_MetaData *
+GNUNET_FS_directory_iterator_get_meta (const struct GNUNET_FS_DirectoryIterator *it);
+
+
+/**
+ * Release resources of a directory iterator.
+ *
+ * @param it iterator to destroy
+ */
+void
+GNUNET_FS_directory_iterator_stop (struct GNUNET_FS_DirectoryIterator *it);
+
+
 /**
  * Opaque handle to a directory builder.
  */
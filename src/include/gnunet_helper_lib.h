@@ -157,6 +157,32 @@ GNUNET_HELPER_send (struct GNUNET_HELPER_Handle *h,
 		    void *cont_cls);
 
 
+/**
+ * Send a message to the helper without copying it.  In contrast to
+ * #GNUNET_HELPER_send(), the message is borrowed from the caller, who
+ * must keep it valid until @a cont is called and may release it from
+ * there.  @a cont is invoked on every outcome (transmission, helper
+ * death, #GNUNET_HELPER_destroy), except if the message is dropped
+ * (NULL is returned) or the operation is cancelled via
+ * #GNUNET_HELPER_send_cancel().
+ *
+ * @param h helper to send message to
+ * @param msg message to send; must remain valid until @a cont is called
+ * @param can_drop can the message be dropped if there is already one in the queue?
+ * @param cont continuation to run once the message is out
+ * @param cont_cls closure for @a cont
+ * @return NULL if the message was dropped,
+ *         otherwise handle to cancel @a cont (actual transmission may
+ *         not be abortable)
+ */
+struct GNUNET_HELPER_SendHandle *
+GNUNET_HELPER_send_borrowed (struct GNUNET_HELPER_Handle *h,
+			     const struct GNUNET_MessageHeader *msg,
+			     int can_drop,
+			     GNUNET_HELPER_Continuation cont,
+			     void *cont_cls);
+
+
 /**
  * Cancel a #GNUNET_HELPER_send operation.  If possible, transmitting
  * the message is also aborted, but at least 'cont' won't be called.
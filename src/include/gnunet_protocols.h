@@ -453,6 +453,13 @@ extern "C"
  */
 #define GNUNET_MESSAGE_TYPE_DATASTORE_DROP 103
 
+/**
+ * Message sent by datastore client to check if content
+ * is already present (by key and content hash) before
+ * transmitting the full data.
+ */
+#define GNUNET_MESSAGE_TYPE_DATASTORE_PUT_PROBE 104
+
 
 /*******************************************************************************
  * FS message types
@@ -2545,6 +2552,12 @@ extern "C"
  */
 #define GNUNET_MESSAGE_TYPE_SENSOR_ANOMALY_REPORT_P2P 811
 
+/**
+ * Message carrying a summary of sensor readings aggregated over one
+ * reporting window
+ */
+#define GNUNET_MESSAGE_TYPE_SENSOR_READING_SUMMARY 812
+
 
 /*******************************************************************************
  * PEERSTORE message types
@@ -262,6 +262,18 @@ GNUNET_REST_namespace_match (const char *url, const char *namespace);
  struct MHD_Response*
 GNUNET_REST_create_json_response (const char *data);
 
+/**
+ * Create JSON API MHD response that streams the object
+ * resource-by-resource as the connection can accept data,
+ * instead of serializing it into one monolithic buffer.
+ * Takes ownership of @a resp.
+ *
+ * @param resp the JSON API object to serialize
+ * @retun MHD response, NULL on error (@a resp is deleted)
+ */
+struct MHD_Response*
+GNUNET_REST_create_jsonapi_response (struct JsonApiObject *resp);
+
 
 int
 GNUNET_REST_handle_request (struct RestConnectionDataHandle *conn,
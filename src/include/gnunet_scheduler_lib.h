@@ -537,6 +537,18 @@ GNUNET_SCHEDULER_set_select (GNUNET_SCHEDULER_select new_select,
                              void *new_select_cls);
 
 
+/**
+ * Notify the scheduler that a file descriptor is being closed, so
+ * that its kernel event backend can drop any state cached for the
+ * descriptor before the number is reused.  Internal to
+ * libgnunetutil, called by the socket and file close routines.
+ *
+ * @param fd descriptor that is being closed
+ */
+void
+GNUNET_SCHEDULER_notify_fd_closed_ (int fd);
+
+
 /** @} */ /* end of group scheduler */
 
 #if 0                           /* keep Emacsens' auto-indent happy */
@@ -315,6 +315,68 @@ struct GNUNET_SENSOR_ValueMessage
 
 };
 
+/**
+ * Used to communicate a summary of numeric sensor values collected over one
+ * reporting window to collection points (SENSORDASHBAORD service)
+ */
+struct GNUNET_SENSOR_SummaryMessage
+{
+
+  /**
+   * GNUNET general message header
+   */
+  struct GNUNET_MessageHeader header;
+
+  /**
+   * Hash of sensor name
+   */
+  struct GNUNET_HashCode sensorname_hash;
+
+  /**
+   * First part of sensor version number
+   */
+  uint16_t sensorversion_major;
+
+  /**
+   * Second part of sensor version number
+   */
+  uint16_t sensorversion_minor;
+
+  /**
+   * Number of readings aggregated into this summary
+   */
+  uint32_t count;
+
+  /**
+   * Timestamp of the last reading covered by this summary
+   */
+  struct GNUNET_TIME_Absolute end_time;
+
+  /**
+   * Smallest reading seen within the window (converted with
+   * #GNUNET_hton_double)
+   */
+  double min;
+
+  /**
+   * Largest reading seen within the window (converted with
+   * #GNUNET_hton_double)
+   */
+  double max;
+
+  /**
+   * Average of all readings within the window (converted with
+   * #GNUNET_hton_double)
+   */
+  double avg;
+
+  /**
+   * Last reading within the window (converted with #GNUNET_hton_double)
+   */
+  double last;
+
+};
+
 /**
  * Message carrying an anomaly status change report
  */
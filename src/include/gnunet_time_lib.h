@@ -244,6 +244,29 @@ struct GNUNET_TIME_Absolute
 GNUNET_TIME_absolute_get (void);
 
 
+/**
+ * Get the current time from the cache filled at the start of the
+ * current scheduler iteration; falls back to the precise clock while
+ * the cache is cold.  Internal to the scheduler, use
+ * #GNUNET_TIME_absolute_get() whenever a timestamp must reflect time
+ * spent in the current task.
+ *
+ * @return the (cached) current time
+ */
+struct GNUNET_TIME_Absolute
+GNUNET_TIME_absolute_get_cached_ (void);
+
+
+/**
+ * Refresh the time cache from the precise clock.  Called by the
+ * scheduler once per loop iteration, internal to the scheduler.
+ *
+ * @return the (fresh) current time
+ */
+struct GNUNET_TIME_Absolute
+GNUNET_TIME_absolute_update_cached_ (void);
+
+
 /**
  * Convert relative time to an absolute time in the
  * future.
@@ -255,6 +278,18 @@ struct GNUNET_TIME_Absolute
 GNUNET_TIME_relative_to_absolute (struct GNUNET_TIME_Relative rel);
 
 
+/**
+ * Convert relative time to an absolute time in the future, based on
+ * the time cache filled at the start of the current scheduler
+ * iteration.  Internal to the scheduler.
+ *
+ * @param rel relative time to convert
+ * @return timestamp that is "rel" in the future, or FOREVER if rel==FOREVER (or if we would overflow)
+ */
+struct GNUNET_TIME_Absolute
+GNUNET_TIME_relative_to_absolute_cached_ (struct GNUNET_TIME_Relative rel);
+
+
 /**
  * Return the minimum of two relative time values.
  *
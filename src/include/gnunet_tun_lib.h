@@ -774,6 +774,102 @@ GNUNET_TUN_initialize_ipv6_header (struct GNUNET_TUN_IPv6Header *ip,
 				   const struct in6_addr *src,
 				   const struct in6_addr *dst);
 
+/**
+ * Calculate the partial checksum over the IP addresses of a flow,
+ * for use as a seed with the "_seeded" checksum calculations below.
+ * As the one's complement sum is commutative, the same seed is valid
+ * for both directions of the flow; callers handling many packets per
+ * flow can thus compute it once and avoid re-summing the constant
+ * pseudo header fields for every packet.
+ *
+ * @param src source IP address of the flow
+ * @param dst destination IP address of the flow
+ * @return partial checksum covering both addresses
+ */
+uint32_t
+GNUNET_TUN_flow_checksum_seed4 (const struct in_addr *src,
+				const struct in_addr *dst);
+
+
+/**
+ * Calculate the partial checksum over the IP addresses of an IPv6
+ * flow, for use as a seed with the "_seeded" checksum calculations
+ * below.
+ *
+ * @param src source IP address of the flow
+ * @param dst destination IP address of the flow
+ * @return partial checksum covering both addresses
+ */
+uint32_t
+GNUNET_TUN_flow_checksum_seed6 (const struct in6_addr *src,
+				const struct in6_addr *dst);
+
+
+/**
+ * Calculate IPv4 TCP checksum, given the flow's checksum seed.
+ *
+ * @param ip ipv4 header fully initialized
+ * @param tcp TCP header (initialized except for CRC)
+ * @param payload the TCP payload
+ * @param payload_length number of bytes of TCP @a payload
+ * @param seed partial checksum over the flow's addresses
+ */
+void
+GNUNET_TUN_calculate_tcp4_checksum_seeded (const struct GNUNET_TUN_IPv4Header *ip,
+					   struct GNUNET_TUN_TcpHeader *tcp,
+					   const void *payload,
+					   uint16_t payload_length,
+					   uint32_t seed);
+
+/**
+ * Calculate IPv6 TCP checksum, given the flow's checksum seed.
+ *
+ * @param ip ipv6 header fully initialized
+ * @param tcp TCP header (initialized except for CRC)
+ * @param payload the TCP payload
+ * @param payload_length number of bytes of TCP payload
+ * @param seed partial checksum over the flow's addresses
+ */
+void
+GNUNET_TUN_calculate_tcp6_checksum_seeded (const struct GNUNET_TUN_IPv6Header *ip,
+					   struct GNUNET_TUN_TcpHeader *tcp,
+					   const void *payload,
+					   uint16_t payload_length,
+					   uint32_t seed);
+
+/**
+ * Calculate IPv4 UDP checksum, given the flow's checksum seed.
+ *
+ * @param ip ipv4 header fully initialized
+ * @param udp UDP header (initialized except for CRC)
+ * @param payload the UDP payload
+ * @param payload_length number of bytes of UDP @a payload
+ * @param seed partial checksum over the flow's addresses
+ */
+void
+GNUNET_TUN_calculate_udp4_checksum_seeded (const struct GNUNET_TUN_IPv4Header *ip,
+					   struct GNUNET_TUN_UdpHeader *udp,
+					   const void *payload,
+					   uint16_t payload_length,
+					   uint32_t seed);
+
+/**
+ * Calculate IPv6 UDP checksum, given the flow's checksum seed.
+ *
+ * @param ip ipv6 header fully initialized
+ * @param udp UDP header (initialized except for CRC)
+ * @param payload the UDP payload
+ * @param payload_length number of bytes of @a payload
+ * @param seed partial checksum over the flow's addresses
+ */
+void
+GNUNET_TUN_calculate_udp6_checksum_seeded (const struct GNUNET_TUN_IPv6Header *ip,
+					   struct GNUNET_TUN_UdpHeader *udp,
+					   const void *payload,
+					   uint16_t payload_length,
+					   uint32_t seed);
+
+
 /**
  * Calculate IPv4 TCP checksum.
  *
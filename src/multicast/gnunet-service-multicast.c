@@ -132,6 +132,21 @@ enum ChannelDirection
 };
 
 
+/**
+ * Entry in the per-channel transmit queue.
+ */
+struct TransmitQueueEntry
+{
+  struct TransmitQueueEntry *prev;
+  struct TransmitQueueEntry *next;
+
+  /**
+   * Copy of the message to transmit, allocated at the end of this struct.
+   */
+  const struct GNUNET_MessageHeader *msg;
+};
+
+
 /**
  * Context for a CADET channel.
  */
@@ -154,6 +169,16 @@ struct Channel
    */
   struct GNUNET_CADET_TransmitHandle *tmit_handle;
 
+  /**
+   * Head of messages queued for transmission on this channel.
+   */
+  struct TransmitQueueEntry *tmit_head;
+
+  /**
+   * Tail of messages queued for transmission on this channel.
+   */
+  struct TransmitQueueEntry *tmit_tail;
+
   /**
    * Public key of the target group.
    */
@@ -704,30 +729,27 @@ client_send_ack (struct GNUNET_HashCode *pub_key_hash)
 }
 
 
-struct CadetTransmitClosure
-{
-  struct Channel *chn;
-  const struct GNUNET_MessageHeader *msg;
-};
-
-
 /**
  * CADET is ready to transmit a message.
  */
 size_t
 cadet_notify_transmit_ready (void *cls, size_t buf_size, void *buf)
 {
+  struct Channel *chn = cls;
+  struct TransmitQueueEntry *tqe = chn->tmit_head;
+
+  chn->tmit_handle = NULL;
   if (0 == buf_size)
   {
     /* FIXME: connection closed */
     return 0;
   }
-  struct CadetTransmitClosure *tcls = cls;
-  struct Channel *chn = tcls->chn;
-  uint16_t msg_size = ntohs (tcls->msg->size);
+  GNUNET_assert (NULL != tqe);
+  uint16_t msg_size = ntohs (tqe->msg->size);
   GNUNET_assert (msg_size <= buf_size);
-  memcpy (buf, tcls->msg, msg_size);
-  GNUNET_free (tcls);
+  memcpy (buf, tqe->msg, msg_size);
+  GNUNET_CONTAINER_DLL_remove (chn->tmit_head, chn->tmit_tail, tqe);
+  GNUNET_free (tqe);
 
   if (0 == chn->msgs_pending)
   {
@@ -737,6 +759,15 @@ cadet_notify_transmit_ready (void *cls, size_t buf_size, void *buf)
   {
     client_send_ack (&chn->group_key_hash);
   }
+  if (NULL != chn->tmit_head)
+  { /* more messages queued: ask for the next transmission right away */
+    chn->tmit_handle
+      = GNUNET_CADET_notify_transmit_ready (chn->channel, GNUNET_NO,
+                                            GNUNET_TIME_UNIT_FOREVER_REL,
+                                            ntohs (chn->tmit_head->msg->size),
+                                            &cadet_notify_transmit_ready,
+                                            chn);
+  }
   return msg_size;
 }
 
@@ -744,23 +775,30 @@ cadet_notify_transmit_ready (void *cls, size_t buf_size, void *buf)
 /**
  * Send a message to a CADET channel.
  *
+ * The message is copied into the channel's transmit queue, so any
+ * number of messages can be pending per channel and the caller does
+ * not need to keep @a msg around.
+ *
  * @param chn  Channel.
  * @param msg  Message.
  */
 static void
 cadet_send_channel (struct Channel *chn, const struct GNUNET_MessageHeader *msg)
 {
-  struct CadetTransmitClosure *tcls = GNUNET_malloc (sizeof (*tcls));
-  tcls->chn = chn;
-  tcls->msg = msg;
+  uint16_t msg_size = ntohs (msg->size);
+  struct TransmitQueueEntry *tqe = GNUNET_malloc (sizeof (*tqe) + msg_size);
+  tqe->msg = (const struct GNUNET_MessageHeader *) &tqe[1];
+  memcpy (&tqe[1], msg, msg_size);
+  GNUNET_CONTAINER_DLL_insert_tail (chn->tmit_head, chn->tmit_tail, tqe);
 
   chn->msgs_pending++;
-  chn->tmit_handle
-    = GNUNET_CADET_notify_transmit_ready (chn->channel, GNUNET_NO,
-                                          GNUNET_TIME_UNIT_FOREVER_REL,
-                                          ntohs (msg->size),
-                                          &cadet_notify_transmit_ready,
-                                          (void *) msg);
+  if (NULL == chn->tmit_handle)
+    chn->tmit_handle
+      = GNUNET_CADET_notify_transmit_ready (chn->channel, GNUNET_NO,
+                                            GNUNET_TIME_UNIT_FOREVER_REL,
+                                            msg_size,
+                                            &cadet_notify_transmit_ready,
+                                            chn);
   GNUNET_assert (NULL != chn->tmit_handle);
 }
 
@@ -1514,6 +1552,12 @@ cadet_notify_channel_end (void *cls,
 
   while (GNUNET_YES == replay_req_remove_cadet (chn));
 
+  struct TransmitQueueEntry *tqe;
+  while (NULL != (tqe = chn->tmit_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (chn->tmit_head, chn->tmit_tail, tqe);
+    GNUNET_free (tqe);
+  }
   GNUNET_free (chn);
 }
 
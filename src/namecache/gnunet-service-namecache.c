@@ -34,6 +34,12 @@
 
 #define LOG_STRERROR_FILE(kind,syscall,filename) GNUNET_log_from_strerror_file (kind, "util", syscall, filename)
 
+/**
+ * Maximum number of blocks we keep in the in-memory cache in
+ * front of the database plugin.
+ */
+#define MAX_CACHE_ENTRIES 128
+
 
 /**
  * A namecache client
@@ -64,6 +70,34 @@ struct NamecacheClient
 };
 
 
+/**
+ * An entry in the in-memory block cache
+ */
+struct CacheEntry
+{
+  /**
+   * Kept in a DLL ordered by last use, most recently used first.
+   */
+  struct CacheEntry *next;
+
+  /**
+   * Kept in a DLL ordered by last use, most recently used first.
+   */
+  struct CacheEntry *prev;
+
+  /**
+   * Query the @e block is stored under.
+   */
+  struct GNUNET_HashCode query;
+
+  /**
+   * Cached copy of the block.
+   */
+  struct GNUNET_GNSRECORD_Block *block;
+
+};
+
+
 /**
  * Configuration handle.
  */
@@ -99,6 +133,124 @@ static struct NamecacheClient *client_tail;
  */
 static struct GNUNET_SERVER_NotificationContext *monitor_nc;
 
+/**
+ * In-memory cache of blocks, maps queries to `struct CacheEntry`
+ * entries; lets us answer hot lookups without going to the database.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap *cache_map;
+
+/**
+ * Head of the LRU list of cache entries, most recently used first.
+ */
+static struct CacheEntry *cache_head;
+
+/**
+ * Tail of the LRU list of cache entries.
+ */
+static struct CacheEntry *cache_tail;
+
+
+/**
+ * Release a cache entry and remove it from the cache.
+ *
+ * @param entry entry to free
+ */
+static void
+free_cache_entry (struct CacheEntry *entry)
+{
+  GNUNET_assert (GNUNET_YES ==
+		 GNUNET_CONTAINER_multihashmap_remove (cache_map,
+						       &entry->query,
+						       entry));
+  GNUNET_CONTAINER_DLL_remove (cache_head,
+			       cache_tail,
+			       entry);
+  GNUNET_free (entry->block);
+  GNUNET_free (entry);
+}
+
+
+/**
+ * Try to answer a query from the in-memory cache.
+ *
+ * @param query hash of public key derived from the zone and the label
+ * @return the cached block, or NULL if we have no (valid) entry
+ */
+static const struct GNUNET_GNSRECORD_Block *
+cache_get_block (const struct GNUNET_HashCode *query)
+{
+  struct CacheEntry *entry;
+
+  entry = GNUNET_CONTAINER_multihashmap_get (cache_map,
+					     query);
+  if (NULL == entry)
+    return NULL;
+  if (0 == GNUNET_TIME_absolute_get_remaining
+      (GNUNET_TIME_absolute_ntoh (entry->block->expiration_time)).rel_value_us)
+  {
+    free_cache_entry (entry);
+    return NULL;
+  }
+  /* move entry to the head of the LRU list */
+  GNUNET_CONTAINER_DLL_remove (cache_head,
+			       cache_tail,
+			       entry);
+  GNUNET_CONTAINER_DLL_insert (cache_head,
+			       cache_tail,
+			       entry);
+  return entry->block;
+}
+
+
+/**
+ * Keep a copy of @a block in the in-memory cache, evicting the
+ * least recently used entry if the cache is full.  Keeps the
+ * existing entry if it does not expire before @a block.
+ *
+ * @param block block to cache
+ */
+static void
+cache_put_block (const struct GNUNET_GNSRECORD_Block *block)
+{
+  struct CacheEntry *entry;
+  struct GNUNET_HashCode query;
+  size_t block_size;
+
+  if (0 == GNUNET_TIME_absolute_get_remaining
+      (GNUNET_TIME_absolute_ntoh (block->expiration_time)).rel_value_us)
+    return; /* block already expired */
+  GNUNET_CRYPTO_hash (&block->derived_key,
+		      sizeof (struct GNUNET_CRYPTO_EcdsaPublicKey),
+		      &query);
+  entry = GNUNET_CONTAINER_multihashmap_get (cache_map,
+					     &query);
+  if (NULL != entry)
+  {
+    if (GNUNET_TIME_absolute_ntoh (entry->block->expiration_time).abs_value_us >=
+	GNUNET_TIME_absolute_ntoh (block->expiration_time).abs_value_us)
+      return; /* cached block is at least as fresh, keep it */
+    free_cache_entry (entry);
+  }
+  block_size = ntohl (block->purpose.size)
+    + sizeof (struct GNUNET_CRYPTO_EcdsaPublicKey)
+    + sizeof (struct GNUNET_CRYPTO_EcdsaSignature);
+  entry = GNUNET_new (struct CacheEntry);
+  entry->query = query;
+  entry->block = GNUNET_malloc (block_size);
+  memcpy (entry->block,
+	  block,
+	  block_size);
+  GNUNET_assert (GNUNET_OK ==
+		 GNUNET_CONTAINER_multihashmap_put (cache_map,
+						    &entry->query,
+						    entry,
+						    GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+  GNUNET_CONTAINER_DLL_insert (cache_head,
+			       cache_tail,
+			       entry);
+  while (GNUNET_CONTAINER_multihashmap_size (cache_map) > MAX_CACHE_ENTRIES)
+    free_cache_entry (cache_tail);
+}
 
 
 /**
@@ -125,6 +277,13 @@ cleanup_task (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
     GNUNET_SERVER_client_set_user_context (nc->client, NULL);
     GNUNET_free (nc);
   }
+  while (NULL != cache_head)
+    free_cache_entry (cache_head);
+  if (NULL != cache_map)
+  {
+    GNUNET_CONTAINER_multihashmap_destroy (cache_map);
+    cache_map = NULL;
+  }
   GNUNET_break (NULL == GNUNET_PLUGIN_unload (db_lib_name, GSN_database));
   GNUNET_free (db_lib_name);
   db_lib_name = NULL;
@@ -241,6 +400,8 @@ handle_lookup_block_it (void *cls,
 					      &r->gns_header.header,
 					      GNUNET_NO);
   GNUNET_free (r);
+  /* also keep the block in memory; no-op if it came from the cache */
+  cache_put_block (block);
 }
 
 
@@ -260,6 +421,7 @@ handle_lookup_block (void *cls,
   struct LookupBlockContext lnc;
   struct NamecacheClient *nc;
   struct LookupBlockResponseMessage zir_end;
+  const struct GNUNET_GNSRECORD_Block *block;
   int ret;
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
@@ -269,6 +431,13 @@ handle_lookup_block (void *cls,
   ln_msg = (const struct LookupBlockMessage *) message;
   lnc.request_id = ntohl (ln_msg->gns_header.r_id);
   lnc.nc = nc;
+  if (NULL != (block = cache_get_block (&ln_msg->query)))
+  {
+    /* hot block, answer directly from the in-memory cache */
+    handle_lookup_block_it (&lnc, block);
+    GNUNET_SERVER_receive_done (client, GNUNET_OK);
+    return;
+  }
   if (GNUNET_SYSERR ==
       (ret = GSN_database->lookup_block (GSN_database->cls,
 					 &ln_msg->query,
@@ -341,6 +510,8 @@ handle_block_cache (void *cls,
 	      "NAMECACHE_BLOCK_CACHE",
               GNUNET_STRINGS_absolute_time_to_string (GNUNET_TIME_absolute_ntoh (block->expiration_time)));
   memcpy (&block[1], &rp_msg[1], esize);
+  /* write-through: keep a copy in the in-memory cache as well */
+  cache_put_block (block);
   res = GSN_database->cache_block (GSN_database->cls,
 				   block);
   GNUNET_free (block);
@@ -380,6 +551,8 @@ run (void *cls, struct GNUNET_SERVER_Handle *server,
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "Starting namecache service\n");
   GSN_cfg = cfg;
   monitor_nc = GNUNET_SERVER_notification_context_create (server, 1);
+  cache_map = GNUNET_CONTAINER_multihashmap_create (MAX_CACHE_ENTRIES,
+						    GNUNET_NO);
 
   /* Loading database plugin */
   if (GNUNET_OK !=
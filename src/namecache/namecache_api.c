@@ -461,6 +461,7 @@ static void
 do_transmit (struct GNUNET_NAMECACHE_Handle *h)
 {
   struct PendingMessage *p;
+  size_t size;
 
   if (NULL != h->th)
     return; /* transmission request already pending */
@@ -468,7 +469,16 @@ do_transmit (struct GNUNET_NAMECACHE_Handle *h)
     return; /* transmission queue empty */
   if (NULL == h->client)
     return;                     /* currently reconnecting */
-  h->th = GNUNET_CLIENT_notify_transmit_ready (h->client, p->size,
+  /* ask for enough buffer space to batch as many of the queued
+     messages as possible into one transmission */
+  size = 0;
+  while ( (NULL != p) &&
+	  (size + p->size < GNUNET_SERVER_MAX_MESSAGE_SIZE) )
+  {
+    size += p->size;
+    p = p->next;
+  }
+  h->th = GNUNET_CLIENT_notify_transmit_ready (h->client, size,
 					       GNUNET_TIME_UNIT_FOREVER_REL,
 					       GNUNET_NO, &transmit_message_to_namecache,
 					       h);
@@ -25,9 +25,6 @@
  * TODO:
  * - need to track active zone info requests so we can cancel them
  *   during shutdown, right?
- * - the code currently contains a 'race' between checking that the
- *   domain name is available and allocating it to the new public key
- *   (should this race be solved by namestore or by fcfsd?)
  * - nicer error reporting to browser
  */
 #include "platform.h"
@@ -153,6 +150,13 @@ struct Request
 
   struct GNUNET_CRYPTO_EcdsaPublicKey pub;
 
+  /**
+   * Did this request reserve its domain name in #taken_names?
+   * Set while the registration pipeline is running so that
+   * concurrent requests for the same name fail immediately.
+   */
+  int reserved;
+
 };
 
 /**
@@ -221,6 +225,20 @@ static struct GNUNET_IDENTITY_Operation *id_op;
  */
 static unsigned long long port;
 
+/**
+ * Map from the hash of a domain name to #taken_marker for all names
+ * that are known to be taken or that have a registration in flight.
+ * Lets us refuse duplicate registration attempts without involving
+ * the namestore, and closes the race between checking a name and
+ * storing the record for it.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap *taken_names;
+
+/**
+ * Marker value stored in #taken_names (the map needs a non-NULL value).
+ */
+static int taken_marker;
+
 
 /**
  * Task run whenever HTTP server operations are pending.
@@ -248,6 +266,75 @@ run_httpd_now ()
 }
 
 
+/**
+ * Check if the given domain name is known to be taken or reserved.
+ *
+ * @param name domain name to check
+ * @return #GNUNET_YES if the name is taken, #GNUNET_NO if not
+ */
+static int
+is_name_taken (const char *name)
+{
+  struct GNUNET_HashCode hc;
+
+  GNUNET_CRYPTO_hash (name,
+		      strlen (name),
+		      &hc);
+  return GNUNET_CONTAINER_multihashmap_contains (taken_names,
+						 &hc);
+}
+
+
+/**
+ * Reserve the domain name of the given request in #taken_names so
+ * that concurrent registration attempts for the same name fail
+ * right away.
+ *
+ * @param request request whose domain name should be reserved
+ */
+static void
+reserve_name (struct Request *request)
+{
+  struct GNUNET_HashCode hc;
+
+  GNUNET_CRYPTO_hash (request->domain_name,
+		      strlen (request->domain_name),
+		      &hc);
+  GNUNET_break (GNUNET_OK ==
+		GNUNET_CONTAINER_multihashmap_put (taken_names,
+						   &hc,
+						   &taken_marker,
+						   GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+  request->reserved = GNUNET_YES;
+}
+
+
+/**
+ * Release the name reservation of the given request, if it still
+ * holds one.  Called when a registration pipeline fails for a
+ * reason that does not mean the name is taken (or is aborted by
+ * the client), so that the name becomes available again.
+ *
+ * @param request request whose reservation should be dropped
+ */
+static void
+release_name (struct Request *request)
+{
+  struct GNUNET_HashCode hc;
+
+  if (GNUNET_YES != request->reserved)
+    return;
+  request->reserved = GNUNET_NO;
+  GNUNET_CRYPTO_hash (request->domain_name,
+		      strlen (request->domain_name),
+		      &hc);
+  GNUNET_break (GNUNET_YES ==
+		GNUNET_CONTAINER_multihashmap_remove (taken_names,
+						      &hc,
+						      &taken_marker));
+}
+
+
 /**
  * Process a record that was stored in the namestore, adding
  * the information to the HTML.
@@ -505,10 +592,15 @@ put_continuation (void *cls,
 		_("Failed to create record for domain `%s': %s\n"),
 		request->domain_name,
 		emsg);
+    release_name (request);
     request->phase = RP_FAIL;
   }
   else
+  {
+    /* name is now permanently taken, keep the #taken_names entry */
+    request->reserved = GNUNET_NO;
     request->phase = RP_SUCCESS;
+  }
   run_httpd_now ();
 }
 
@@ -538,6 +630,7 @@ zone_to_name_cb (void *cls,
     GNUNET_log (GNUNET_ERROR_TYPE_INFO,
 		_("Found existing name `%s' for the given key\n"),
 		name);
+    release_name (request);
     request->phase = RP_FAIL;
     run_httpd_now ();
     return;
@@ -546,6 +639,7 @@ zone_to_name_cb (void *cls,
   {
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
                 _("Error when mapping zone to name\n"));
+    release_name (request);
     request->phase = RP_FAIL;
     run_httpd_now ();
     return;
@@ -587,17 +681,6 @@ lookup_block_processor (void *cls,
   request->qe = NULL;
   if (0 == rd_count)
   {
-
-    if (GNUNET_OK !=
-        GNUNET_CRYPTO_ecdsa_public_key_from_string (request->public_key,
-                                                    strlen (request->public_key),
-                                                    &request->pub))
-    {
-      GNUNET_break (0);
-      request->phase = RP_FAIL;
-      run_httpd_now ();
-      return;
-    }
     request->qe = GNUNET_NAMESTORE_zone_to_name (ns,
                                                  &fcfs_zone_pkey,
                                                  &request->pub,
@@ -610,6 +693,9 @@ lookup_block_processor (void *cls,
               _("Found %u existing records for domain `%s'\n"),
               rd_count,
               request->domain_name);
+  /* name was taken before we ever saw it, keep the #taken_names
+     entry so future attempts are refused without a lookup */
+  request->reserved = GNUNET_NO;
   request->phase = RP_FAIL;
   run_httpd_now ();
   return;
@@ -651,7 +737,6 @@ create_response (void *cls,
 {
   struct MHD_Response *response;
   struct Request *request;
-  struct GNUNET_CRYPTO_EcdsaPublicKey pub;
   int ret;
 
   if ( (0 == strcmp (method, MHD_HTTP_METHOD_GET)) ||
@@ -700,18 +785,19 @@ create_response (void *cls,
 	MHD_destroy_post_processor (request->pp);
 	request->pp = NULL;
       }
-      if (GNUNET_OK !=
-	  GNUNET_CRYPTO_ecdsa_public_key_from_string (request->public_key,
-                                                      strlen (request->public_key),
-                                                      &pub))
-      {
-	/* parse error */
-	return fill_s_reply ("Failed to parse given public key",
-			     request, connection);
-      }
       switch (request->phase)
 	{
 	case RP_START:
+	  if (GNUNET_OK !=
+	      GNUNET_CRYPTO_ecdsa_public_key_from_string (request->public_key,
+							  strlen (request->public_key),
+							  &request->pub))
+	  {
+	    /* parse error */
+	    request->phase = RP_FAIL;
+	    return fill_s_reply ("Failed to parse given public key",
+				 request, connection);
+	  }
 	  if (NULL != strchr (request->domain_name, (int) '.'))
 	  {
 	    GNUNET_log (GNUNET_ERROR_TYPE_INFO,
@@ -728,6 +814,16 @@ create_response (void *cls,
 	    return fill_s_reply ("Domain name must not contain `+', sorry.",
 				 request, connection);
 	  }
+	  if (GNUNET_YES == is_name_taken (request->domain_name))
+	  {
+	    GNUNET_log (GNUNET_ERROR_TYPE_INFO,
+			_("Domain name `%s' is already taken\n"),
+			request->domain_name);
+	    request->phase = RP_FAIL;
+	    return fill_s_reply ("Domain name is already taken, sorry.",
+				 request, connection);
+	  }
+	  reserve_name (request);
 	  request->phase = RP_LOOKUP;
 	  request->qe = GNUNET_NAMESTORE_records_lookup (ns,
                                                        &fcfs_zone_pkey,
@@ -786,6 +882,7 @@ request_completed_callback (void *cls,
     MHD_destroy_post_processor (request->pp);
   if (NULL != request->qe)
     GNUNET_NAMESTORE_cancel (request->qe);
+  release_name (request);
   GNUNET_free (request);
 }
 
@@ -887,6 +984,11 @@ do_shutdown (void *cls,
     GNUNET_IDENTITY_disconnect (identity);
     identity = NULL;
   }
+  if (NULL != taken_names)
+  {
+    GNUNET_CONTAINER_multihashmap_destroy (taken_names);
+    taken_names = NULL;
+  }
 }
 
 
@@ -934,7 +1036,7 @@ identity_cb (void *cls,
 				NULL, NULL,
 				&create_response, NULL,
 				MHD_OPTION_CONNECTION_LIMIT, (unsigned int) 128,
-				MHD_OPTION_PER_IP_CONNECTION_LIMIT, (unsigned int) 1,
+				MHD_OPTION_PER_IP_CONNECTION_LIMIT, (unsigned int) 8,
 				MHD_OPTION_CONNECTION_TIMEOUT, (unsigned int) 16,
 				MHD_OPTION_CONNECTION_MEMORY_LIMIT, (size_t) (4 * 1024),
 				MHD_OPTION_NOTIFY_COMPLETED, &request_completed_callback, NULL,
@@ -984,6 +1086,8 @@ run (void *cls, char *const *args, const char *cfgfile,
 		  _("Failed to connect to namestore\n"));
       return;
     }
+  taken_names = GNUNET_CONTAINER_multihashmap_create (64,
+						      GNUNET_NO);
   identity = GNUNET_IDENTITY_connect (cfg,
 				      NULL, NULL);
   if (NULL == identity)
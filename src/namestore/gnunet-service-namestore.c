@@ -1587,7 +1587,7 @@ handle_monitor_start (void *cls,
 	      "ZONE_MONITOR_START");
   zis_msg = (const struct ZoneMonitorStartMessage *) message;
   zm = GNUNET_new (struct ZoneMonitor);
-  zm->offset = 0;
+  zm->offset = ntohl (zis_msg->offset);
   zm->nc = client_lookup (client);
   zm->zone = zis_msg->zone;
   GNUNET_CONTAINER_DLL_insert (monitor_head, monitor_tail, zm);
@@ -310,6 +310,14 @@ struct ZoneMonitorStartMessage
    */
   uint32_t iterate_first GNUNET_PACKED;
 
+  /**
+   * Offset in the zone iteration at which to resume the initial
+   * iteration, 0 to start from the beginning.  Lets a monitor
+   * continue where it left off after a reconnect instead of
+   * replaying the entire zone.
+   */
+  uint32_t offset GNUNET_PACKED;
+
   /**
    * Zone key.
    */
@@ -832,6 +832,7 @@ static void
 do_transmit (struct GNUNET_NAMESTORE_Handle *h)
 {
   struct PendingMessage *p;
+  size_t size;
 
   if (NULL != h->th)
     return; /* transmission request already pending */
@@ -839,7 +840,17 @@ do_transmit (struct GNUNET_NAMESTORE_Handle *h)
     return; /* transmission queue empty */
   if (NULL == h->client)
     return;                     /* currently reconnecting */
-  h->th = GNUNET_CLIENT_notify_transmit_ready (h->client, p->size,
+  /* ask for enough buffer space to batch as many of the queued
+     messages as possible into one transmission; this matters in
+     particular for bulk record stores */
+  size = 0;
+  while ( (NULL != p) &&
+	  (size + p->size < GNUNET_SERVER_MAX_MESSAGE_SIZE) )
+  {
+    size += p->size;
+    p = p->next;
+  }
+  h->th = GNUNET_CLIENT_notify_transmit_ready (h->client, size,
 					       GNUNET_TIME_UNIT_FOREVER_REL,
 					       GNUNET_NO, &transmit_message_to_namestore,
 					       h);
@@ -80,6 +80,15 @@ struct GNUNET_NAMESTORE_ZoneMonitor
    */
   int iterate_first;
 
+  /**
+   * Number of records received so far during the initial iteration;
+   * used to resume the iteration at that position if we have to
+   * reconnect.  Set to UINT32_MAX once we are in sync, as after that
+   * point we can no longer tell what changed and a reconnect must
+   * replay the zone from the beginning.
+   */
+  uint32_t offset;
+
 };
 
 
@@ -107,6 +116,8 @@ reconnect (struct GNUNET_NAMESTORE_ZoneMonitor *zm)
 {
   if (NULL != zm->h)
     GNUNET_CLIENT_disconnect (zm->h);
+  if (UINT32_MAX == zm->offset)
+    zm->offset = 0; /* we were in sync, must replay the full zone */
   zm->monitor (zm->cls,
 	       NULL,
 	       NULL, 0, NULL);
@@ -149,6 +160,7 @@ handle_updates (void *cls,
   if ( (ntohs (msg->size) == sizeof (struct GNUNET_MessageHeader)) &&
        (GNUNET_MESSAGE_TYPE_NAMESTORE_MONITOR_SYNC == ntohs (msg->type) ) )
   {
+    zm->offset = UINT32_MAX;
     GNUNET_CLIENT_receive (zm->h,
 			   &handle_updates,
 			   zm,
@@ -199,6 +211,8 @@ handle_updates (void *cls,
       reconnect (zm);
       return;
     }
+    if (UINT32_MAX != zm->offset)
+      zm->offset++; /* initial iteration advanced by one record */
     GNUNET_CLIENT_receive (zm->h,
 			   &handle_updates,
 			   zm,
@@ -236,6 +250,7 @@ transmit_monitor_message (void *cls,
   sm.header.type = htons (GNUNET_MESSAGE_TYPE_NAMESTORE_MONITOR_START);
   sm.header.size = htons (sizeof (struct ZoneMonitorStartMessage));
   sm.iterate_first = htonl (zm->iterate_first);
+  sm.offset = htonl (zm->offset);
   sm.zone = zm->zone;
   memcpy (buf, &sm, sizeof (sm));
   GNUNET_CLIENT_receive (zm->h,
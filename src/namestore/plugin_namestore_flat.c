@@ -48,6 +48,33 @@ struct Plugin
    */
   struct GNUNET_CONTAINER_MultiHashMap *hm;
 
+  /**
+   * File handle kept open for appending stores to the journal.
+   */
+  struct GNUNET_DISK_FileHandle *fh_append;
+
+  /**
+   * Cursor of an in-progress sequential iteration, NULL if none.
+   * Invalidated whenever the map is modified.
+   */
+  struct GNUNET_CONTAINER_MultiHashMapIterator *cursor;
+
+  /**
+   * Offset the next sequential call to iterate_records must use
+   * for @e cursor to remain valid.
+   */
+  uint64_t cursor_offset;
+
+  /**
+   * Zone @e cursor iterates over, only valid if @e cursor_has_zone.
+   */
+  struct GNUNET_CRYPTO_EcdsaPrivateKey cursor_zone;
+
+  /**
+   * #GNUNET_YES if @e cursor filters by @e cursor_zone.
+   */
+  int cursor_has_zone;
+
   /**
    * Offset
    */
@@ -76,7 +103,7 @@ struct Plugin
   /**
    * PKEY to look for in zone to name
    */
-  struct GNUNET_CRYPTO_EcdsaPublicKey *iter_pkey;
+  const struct GNUNET_CRYPTO_EcdsaPublicKey *iter_pkey;
 
   /**
    * Iteration result found
@@ -116,6 +143,103 @@ struct FlatFileEntry
 };
 
 
+/**
+ * Release all memory of the given entry.
+ *
+ * @param entry entry to free
+ */
+static void
+free_entry (struct FlatFileEntry *entry)
+{
+  unsigned int i;
+
+  for (i = 0; i < entry->record_count; i++)
+    GNUNET_free ((void *) entry->record_data[i].data);
+  GNUNET_free (entry->record_data);
+  GNUNET_free (entry->label);
+  GNUNET_free (entry->private_key);
+  GNUNET_free (entry);
+}
+
+
+/**
+ * Drop the iteration cursor, if any.  Must be called whenever
+ * the map is modified, as removals invalidate the iterator.
+ *
+ * @param plugin the plugin context
+ */
+static void
+invalidate_cursor (struct Plugin *plugin)
+{
+  if (NULL == plugin->cursor)
+    return;
+  GNUNET_CONTAINER_multihashmap_iterator_destroy (plugin->cursor);
+  plugin->cursor = NULL;
+}
+
+
+/**
+ * Serialize an entry into a journal line.  An entry with zero
+ * records is written as a deletion tombstone (with a placeholder
+ * in the record data column, as the format has no empty fields).
+ *
+ * @param private_key zone of the entry
+ * @param label label of the entry
+ * @param rvalue rvalue of the entry
+ * @param record_count number of records, 0 for a tombstone
+ * @param record_data the records themselves
+ * @return the line (with trailing newline), NULL on error
+ */
+static char *
+serialize_entry (const struct GNUNET_CRYPTO_EcdsaPrivateKey *private_key,
+                 const char *label,
+                 uint64_t rvalue,
+                 uint32_t record_count,
+                 const struct GNUNET_GNSRECORD_Data *record_data)
+{
+  char *line;
+  char *zone_private_key;
+  char *record_data_b64;
+  size_t data_size;
+
+  GNUNET_STRINGS_base64_encode ((char*)private_key,
+                                sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey),
+                                &zone_private_key);
+  if (0 == record_count)
+  {
+    record_data_b64 = GNUNET_strdup ("none");
+  }
+  else
+  {
+    data_size = GNUNET_GNSRECORD_records_get_size (record_count,
+                                                   record_data);
+    char data[data_size];
+    if (data_size != GNUNET_GNSRECORD_records_serialize (record_count,
+                                                         record_data,
+                                                         data_size,
+                                                         data))
+    {
+      GNUNET_break (0);
+      GNUNET_free (zone_private_key);
+      return NULL;
+    }
+    GNUNET_STRINGS_base64_encode (data,
+                                  data_size,
+                                  &record_data_b64);
+  }
+  GNUNET_asprintf (&line,
+                   "%s,%lu,%u,%s,%s\n",
+                   zone_private_key,
+                   rvalue,
+                   record_count,
+                   record_data_b64,
+                   label);
+  GNUNET_free (zone_private_key);
+  GNUNET_free (record_data_b64);
+  return line;
+}
+
+
 /**
  * Initialize the database connections and associated
  * data structures (create tables and indices
@@ -137,12 +261,15 @@ database_setup (struct Plugin *plugin)
   char *label;
   char *rvalue;
   char *record_count;
+  char *data_copy;
   size_t record_data_size;
   size_t size;
   size_t key_len;
+  unsigned int i;
   struct GNUNET_HashCode hkey;
   struct GNUNET_DISK_FileHandle *fh;
-  struct FlatFileEntry *entry; 
+  struct FlatFileEntry *entry;
+  struct FlatFileEntry *old;
 
   if (GNUNET_OK !=
       GNUNET_CONFIGURATION_get_value_filename (plugin->cfg, 
@@ -228,16 +355,6 @@ database_setup (struct Plugin *plugin)
       sscanf (rvalue, "%lu", &entry->rvalue);
       sscanf (record_count, "%u", &entry->record_count);
       entry->label = GNUNET_strdup (label);
-      record_data_size = GNUNET_STRINGS_base64_decode (record_data_b64,
-                                                       strlen (record_data_b64),
-                                                       &record_data);
-      entry->record_data = 
-        GNUNET_malloc (sizeof (struct GNUNET_GNSRECORD_Data) * entry->record_count);
-      GNUNET_GNSRECORD_records_deserialize (record_data_size,
-                                            record_data,
-                                            entry->record_count,
-                                            entry->record_data);
-      GNUNET_free (record_data);
       GNUNET_STRINGS_base64_decode (zone_private_key,
                                     strlen (zone_private_key),
                                     (char**)&entry->private_key);
@@ -251,18 +368,70 @@ database_setup (struct Plugin *plugin)
                           key_len,
                           &hkey);
       GNUNET_free (key);
-      if (GNUNET_OK != 
+      /* we replay the journal in order, so a later line for the
+         same (zone,label) supersedes earlier ones */
+      old = GNUNET_CONTAINER_multihashmap_get (plugin->hm,
+                                               &hkey);
+      if (NULL != old)
+      {
+        GNUNET_break (GNUNET_YES ==
+                      GNUNET_CONTAINER_multihashmap_remove (plugin->hm,
+                                                            &hkey,
+                                                            old));
+        free_entry (old);
+      }
+      if (0 == entry->record_count)
+      {
+        /* deletion tombstone, record data is a placeholder */
+        GNUNET_free (entry->label);
+        GNUNET_free (entry->private_key);
+        GNUNET_free (entry);
+        continue;
+      }
+      record_data_size = GNUNET_STRINGS_base64_decode (record_data_b64,
+                                                       strlen (record_data_b64),
+                                                       &record_data);
+      entry->record_data =
+        GNUNET_malloc (sizeof (struct GNUNET_GNSRECORD_Data) * entry->record_count);
+      GNUNET_GNSRECORD_records_deserialize (record_data_size,
+                                            record_data,
+                                            entry->record_count,
+                                            entry->record_data);
+      /* the deserialized 'data' pointers point into 'record_data',
+         which we free below; give each record its own copy */
+      for (i = 0; i < entry->record_count; i++)
+      {
+        data_copy = GNUNET_malloc (entry->record_data[i].data_size);
+        memcpy (data_copy,
+                entry->record_data[i].data,
+                entry->record_data[i].data_size);
+        entry->record_data[i].data = data_copy;
+      }
+      GNUNET_free (record_data);
+      if (GNUNET_OK !=
           GNUNET_CONTAINER_multihashmap_put (plugin->hm,
                                              &hkey,
                                              entry,
                                              GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY))
       {
-        GNUNET_free (entry);
+        free_entry (entry);
         GNUNET_break (0);
       }
     }
   }
   GNUNET_free (buffer);
+  plugin->fh_append = GNUNET_DISK_file_open (afsdir,
+                                             GNUNET_DISK_OPEN_WRITE |
+                                             GNUNET_DISK_OPEN_APPEND,
+                                             GNUNET_DISK_PERM_USER_WRITE |
+                                             GNUNET_DISK_PERM_USER_READ);
+  if (NULL == plugin->fh_append)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+         _("Unable to initialize file: %s.\n"),
+         afsdir);
+    return GNUNET_SYSERR;
+  }
   return GNUNET_OK;
 }
 
@@ -280,84 +449,76 @@ store_and_free_entries (void *cls,
   struct GNUNET_DISK_FileHandle *fh = cls;
   struct FlatFileEntry *entry = value;
   char *line;
-  char *zone_private_key;
-  char *rvalue;
-  char *record_count;
-  char *record_data_b64;
-  size_t data_size;
 
-  GNUNET_STRINGS_base64_encode ((char*)entry->private_key,
-                                sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey),
-                                &zone_private_key);
-  GNUNET_asprintf (&rvalue, "%lu", entry->rvalue);
-  GNUNET_asprintf (&record_count, "%u", entry->record_count);
-  
-  data_size = GNUNET_GNSRECORD_records_get_size (entry->record_count,
-                                                 entry->record_data);
-  char data[data_size];
-  if (data_size != GNUNET_GNSRECORD_records_serialize (entry->record_count,
-                                                       entry->record_data,
-                                                       data_size,
-                                                       data))
+  if (NULL != fh)
   {
-    GNUNET_break (0);
-    return GNUNET_SYSERR;
+    line = serialize_entry (entry->private_key,
+                            entry->label,
+                            entry->rvalue,
+                            entry->record_count,
+                            entry->record_data);
+    if (NULL != line)
+    {
+      GNUNET_DISK_file_write (fh,
+                              line,
+                              strlen (line));
+      GNUNET_free (line);
+    }
   }
-  GNUNET_STRINGS_base64_encode (data,
-                                data_size,
-                                &record_data_b64);
-
-  GNUNET_asprintf (&line,
-                   "%s,%s,%s,%s,%s\n",
-                   zone_private_key,
-                   rvalue,
-                   record_count,
-                   record_data_b64,
-                   entry->label);
-
-  GNUNET_free (rvalue);
-  GNUNET_free (record_count);
-  GNUNET_free (record_data_b64);
-
-  GNUNET_DISK_file_write (fh,
-                          line,
-                          strlen (line));
-
-  GNUNET_free (entry->private_key);
-  GNUNET_free (entry->label);
-  GNUNET_free (entry->record_data);
-  GNUNET_free (entry);
+  free_entry (entry);
   return GNUNET_YES;
 }
 
 /**
  * Shutdown database connection and associate data
- * structures.
+ * structures.  Compacts the journal: the live state is written
+ * to a temporary file which is then moved over the journal, so
+ * a crash during the rewrite cannot lose the database.
+ *
  * @param plugin the plugin context (state for this module)
  */
 static void
 database_shutdown (struct Plugin *plugin)
 {
   struct GNUNET_DISK_FileHandle *fh;
-  fh = GNUNET_DISK_file_open (plugin->fn,
+  char *tmp_fn;
+
+  invalidate_cursor (plugin);
+  if (NULL != plugin->fh_append)
+  {
+    GNUNET_DISK_file_close (plugin->fh_append);
+    plugin->fh_append = NULL;
+  }
+  if ( (NULL == plugin->hm) ||
+       (NULL == plugin->fn) )
+    return;
+  GNUNET_asprintf (&tmp_fn,
+                   "%s.tmp",
+                   plugin->fn);
+  fh = GNUNET_DISK_file_open (tmp_fn,
                               GNUNET_DISK_OPEN_CREATE |
                               GNUNET_DISK_OPEN_TRUNCATE |
                               GNUNET_DISK_OPEN_READWRITE,
                               GNUNET_DISK_PERM_USER_WRITE |
                               GNUNET_DISK_PERM_USER_READ);
   if (NULL == fh)
-  {
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
                 _("Unable to initialize file: %s.\n"),
-                plugin->fn);
-    return;
-  }
-
+                tmp_fn);
   GNUNET_CONTAINER_multihashmap_iterate (plugin->hm,
                                          &store_and_free_entries,
                                          fh);
   GNUNET_CONTAINER_multihashmap_destroy (plugin->hm);
-  GNUNET_DISK_file_close (fh);
+  if (NULL != fh)
+  {
+    GNUNET_DISK_file_sync (fh);
+    GNUNET_DISK_file_close (fh);
+    if (0 != RENAME (tmp_fn, plugin->fn))
+      GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_ERROR,
+                                "rename",
+                                tmp_fn);
+  }
+  GNUNET_free (tmp_fn);
 }
 
 
@@ -383,9 +544,12 @@ namestore_store_records (void *cls,
   uint64_t rvalue;
   size_t key_len;
   char *key;
+  char *line;
   struct GNUNET_HashCode hkey;
   struct FlatFileEntry *entry;
+  struct FlatFileEntry *old;
   int i;
+  int ret;
 
   rvalue = GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_WEAK, UINT64_MAX);
   key_len = strlen (label) + sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey);
@@ -397,16 +561,25 @@ namestore_store_records (void *cls,
   GNUNET_CRYPTO_hash (key,
                       key_len,
                       &hkey);
+  GNUNET_free (key);
 
-  GNUNET_CONTAINER_multihashmap_remove_all (plugin->hm, &hkey);
+  invalidate_cursor (plugin);
+  old = GNUNET_CONTAINER_multihashmap_get (plugin->hm, &hkey);
+  if (NULL != old)
+  {
+    GNUNET_break (GNUNET_YES ==
+                  GNUNET_CONTAINER_multihashmap_remove (plugin->hm,
+                                                        &hkey,
+                                                        old));
+    free_entry (old);
+  }
 
+  ret = GNUNET_NO;
   if (0 < rd_count)
   {
     entry = GNUNET_malloc (sizeof (struct FlatFileEntry));
     entry->private_key = GNUNET_malloc (sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey));
-    GNUNET_asprintf (&entry->label,
-                     label,
-                     strlen (label));
+    entry->label = GNUNET_strdup (label);
     memcpy (entry->private_key,
             zone_key,
             sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey));
@@ -422,12 +595,30 @@ namestore_store_records (void *cls,
       entry->record_data[i].data = GNUNET_malloc (rd[i].data_size);
       memcpy ((char*)entry->record_data[i].data, rd[i].data, rd[i].data_size);
     }
-    return GNUNET_CONTAINER_multihashmap_put (plugin->hm,
-                                              &hkey,
-                                              entry,
-                                              GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY);
+    ret = GNUNET_CONTAINER_multihashmap_put (plugin->hm,
+                                             &hkey,
+                                             entry,
+                                             GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY);
+    if (GNUNET_OK != ret)
+      return ret;
   }
-  return GNUNET_NO;
+  else if (NULL == old)
+    return GNUNET_NO; /* nothing existed, nothing to journal */
+  /* append the store (or a deletion tombstone) to the journal,
+     so that a crash does not lose it; the full rewrite only
+     happens as compaction on shutdown */
+  line = serialize_entry (zone_key,
+                          label,
+                          rvalue,
+                          rd_count,
+                          rd);
+  if (NULL == line)
+    return GNUNET_SYSERR;
+  GNUNET_DISK_file_write (plugin->fh_append,
+                          line,
+                          strlen (line));
+  GNUNET_free (line);
+  return (0 < rd_count) ? ret : GNUNET_NO;
 }
 
 
@@ -479,6 +670,54 @@ namestore_lookup_records (void *cls,
 }
 
 
+/**
+ * Deliver the next entry matching @a zone from the iteration
+ * cursor and remember the offset the follow-up call must use.
+ * Destroys the cursor once the map is exhausted.
+ *
+ * @param plugin the plugin context
+ * @param zone zone to match, NULL for all zones
+ * @param offset offset the current call was made with
+ * @param iter function to call with the result
+ * @param iter_cls closure for @a iter
+ * @return #GNUNET_YES if an entry was delivered, #GNUNET_NO if not
+ */
+static int
+cursor_step (struct Plugin *plugin,
+             const struct GNUNET_CRYPTO_EcdsaPrivateKey *zone,
+             uint64_t offset,
+             GNUNET_NAMESTORE_RecordIterator iter,
+             void *iter_cls)
+{
+  struct GNUNET_HashCode key;
+  const void *value;
+  struct FlatFileEntry *entry;
+
+  while (GNUNET_YES ==
+         GNUNET_CONTAINER_multihashmap_iterator_next (plugin->cursor,
+                                                      &key,
+                                                      &value))
+  {
+    entry = (struct FlatFileEntry *) value;
+    if ( (NULL != zone) &&
+         (0 != memcmp (entry->private_key,
+                       zone,
+                       sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey))) )
+      continue;
+    plugin->cursor_offset = offset + 1;
+    if (NULL != iter)
+      iter (iter_cls,
+            entry->private_key,
+            entry->label,
+            entry->record_count,
+            entry->record_data);
+    return GNUNET_YES;
+  }
+  invalidate_cursor (plugin);
+  return GNUNET_NO;
+}
+
+
 static int
 iterate_zones (void *cls,
                const struct GNUNET_HashCode *key,
@@ -522,6 +761,29 @@ namestore_iterate_records (void *cls,
                            GNUNET_NAMESTORE_RecordIterator iter, void *iter_cls)
 {
   struct Plugin *plugin = cls;
+
+  if ( (NULL != plugin->cursor) &&
+       (offset == plugin->cursor_offset) &&
+       (plugin->cursor_has_zone == (NULL != zone)) &&
+       ( (NULL == zone) ||
+         (0 == memcmp (zone,
+                       &plugin->cursor_zone,
+                       sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey))) ) )
+  {
+    /* sequential iteration, continue where the last call stopped
+       instead of rescanning the whole map for every offset */
+    return cursor_step (plugin, zone, offset, iter, iter_cls);
+  }
+  invalidate_cursor (plugin);
+  if (0 == offset)
+  {
+    plugin->cursor = GNUNET_CONTAINER_multihashmap_iterator_create (plugin->hm);
+    plugin->cursor_has_zone = (NULL != zone);
+    if (NULL != zone)
+      plugin->cursor_zone = *zone;
+    return cursor_step (plugin, zone, offset, iter, iter_cls);
+  }
+  /* out-of-order offset, fall back to a full scan */
   plugin->target_offset = offset;
   plugin->offset = 0;
   plugin->iter = iter;
@@ -561,7 +823,8 @@ zone_to_name (void *cls,
                     entry->record_count,
                     entry->record_data);
       plugin->iter_result_found = GNUNET_YES;
-
+      /* at most one result */
+      return GNUNET_NO;
     }
   }
 
@@ -590,12 +853,14 @@ namestore_zone_to_name (void *cls,
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Performing reverse lookup for `%s'\n",
               GNUNET_GNSRECORD_z2s (value_zone));
-
+  plugin->iter = iter;
+  plugin->iter_cls = iter_cls;
+  plugin->iter_zone = zone;
+  plugin->iter_pkey = value_zone;
+  plugin->iter_result_found = GNUNET_NO;
   GNUNET_CONTAINER_multihashmap_iterate (plugin->hm,
                                          &zone_to_name,
                                          plugin);
-
-
   return plugin->iter_result_found;
 }
 
@@ -101,6 +101,31 @@ struct Plugin
    * Precompiled SQL to lookup records based on label.
    */
   sqlite3_stmt *lookup_label;
+
+  /**
+   * Statement of the open iteration cursor (points to either
+   * #iterate_zone or #iterate_all_zones), or NULL if no cursor
+   * is open.  Kept stepping between sequential calls to
+   * #namestore_sqlite_iterate_records() so that we do not pay
+   * for an O(n) OFFSET scan on every single record.
+   */
+  sqlite3_stmt *iter_stmt;
+
+  /**
+   * Zone the open iteration cursor is scanning; only valid
+   * if @e iter_stmt is non-NULL and @e iter_all_zones is #GNUNET_NO.
+   */
+  struct GNUNET_CRYPTO_EcdsaPrivateKey iter_zone;
+
+  /**
+   * Offset the open iteration cursor will return next.
+   */
+  uint64_t iter_next_offset;
+
+  /**
+   * #GNUNET_YES if the open iteration cursor scans all zones.
+   */
+  int iter_all_zones;
 };
 
 
@@ -470,13 +495,17 @@ namestore_sqlite_store_records (void *cls,
  * @param zone_key private key of the zone
  * @param iter iterator to call with the result
  * @param iter_cls closure for @a iter
+ * @param keep_open #GNUNET_YES to leave the statement open (with the
+ *                  cursor positioned on the row) if a record was returned,
+ *                  #GNUNET_NO to always reset it
  * @return #GNUNET_OK on success, #GNUNET_NO if there were no results, #GNUNET_SYSERR on error
  */
 static int
 get_record_and_call_iterator (struct Plugin *plugin,
 			      sqlite3_stmt *stmt,
 			      const struct GNUNET_CRYPTO_EcdsaPrivateKey *zone_key,
-			      GNUNET_NAMESTORE_RecordIterator iter, void *iter_cls)
+			      GNUNET_NAMESTORE_RecordIterator iter, void *iter_cls,
+			      int keep_open)
 {
   unsigned int record_count;
   size_t data_size;
@@ -537,10 +566,14 @@ get_record_and_call_iterator (struct Plugin *plugin,
     if (SQLITE_DONE != sret)
       LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR, "sqlite_step");
   }
-  if (SQLITE_OK != sqlite3_reset (stmt))
-    LOG_SQLITE (plugin,
-		GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
-		"sqlite3_reset");
+  if ( (GNUNET_YES != keep_open) ||
+       (GNUNET_YES != ret) )
+  {
+    if (SQLITE_OK != sqlite3_reset (stmt))
+      LOG_SQLITE (plugin,
+		  GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+		  "sqlite3_reset");
+  }
   return ret;
 }
 
@@ -586,7 +619,8 @@ namestore_sqlite_lookup_records (void *cls,
                   "sqlite3_reset");
     return GNUNET_SYSERR;
   }
-  return get_record_and_call_iterator (plugin, stmt, zone, iter, iter_cls);
+  return get_record_and_call_iterator (plugin, stmt, zone, iter, iter_cls,
+				       GNUNET_NO);
 }
 
 
@@ -610,18 +644,56 @@ namestore_sqlite_iterate_records (void *cls,
   struct Plugin *plugin = cls;
   sqlite3_stmt *stmt;
   int err;
+  int ret;
 
+  /* The service walks a zone by asking for offset, offset+1, ...;
+     if the open cursor is positioned just before the requested
+     offset, simply step it instead of paying for the O(n) OFFSET
+     scan that a fresh statement would perform. */
+  if ( (NULL != plugin->iter_stmt) &&
+       (offset == plugin->iter_next_offset) &&
+       ( (NULL == zone)
+	 ? (GNUNET_YES == plugin->iter_all_zones)
+	 : ( (GNUNET_NO == plugin->iter_all_zones) &&
+	     (0 == memcmp (zone,
+			   &plugin->iter_zone,
+			   sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey))) ) ) )
+  {
+    plugin->iter_next_offset++;
+    ret = get_record_and_call_iterator (plugin, plugin->iter_stmt,
+					zone, iter, iter_cls,
+					GNUNET_YES);
+    if (GNUNET_YES != ret)
+      plugin->iter_stmt = NULL; /* cursor exhausted, statement was reset */
+    return ret;
+  }
+  /* different position or zone: abandon the open cursor (if any)
+     and seek using OFFSET */
+  if (NULL != plugin->iter_stmt)
+  {
+    if (SQLITE_OK != sqlite3_reset (plugin->iter_stmt))
+      LOG_SQLITE (plugin,
+		  GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+		  "sqlite3_reset");
+    plugin->iter_stmt = NULL;
+  }
   if (NULL == zone)
   {
     stmt = plugin->iterate_all_zones;
     err = (SQLITE_OK != sqlite3_bind_int64 (stmt, 1,
 					    offset));
+    plugin->iter_all_zones = GNUNET_YES;
   }
   else
   {
     stmt = plugin->iterate_zone;
+    plugin->iter_all_zones = GNUNET_NO;
+    /* bind our own copy of the key: the statement may stay open
+       after we return, while the caller's copy goes away */
+    plugin->iter_zone = *zone;
     err = ( (SQLITE_OK != sqlite3_bind_blob (stmt, 1,
-					     zone, sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey),
+					     &plugin->iter_zone,
+					     sizeof (struct GNUNET_CRYPTO_EcdsaPrivateKey),
 					     SQLITE_STATIC)) ||
 	    (SQLITE_OK != sqlite3_bind_int64 (stmt, 2,
 					      offset)) );
@@ -636,7 +708,12 @@ namestore_sqlite_iterate_records (void *cls,
 		  "sqlite3_reset");
     return GNUNET_SYSERR;
   }
-  return get_record_and_call_iterator (plugin, stmt, zone, iter, iter_cls);
+  plugin->iter_next_offset = offset + 1;
+  ret = get_record_and_call_iterator (plugin, stmt, zone, iter, iter_cls,
+				      GNUNET_YES);
+  if (GNUNET_YES == ret)
+    plugin->iter_stmt = stmt;
+  return ret;
 }
 
 
@@ -680,7 +757,8 @@ namestore_sqlite_zone_to_name (void *cls,
        "Performing reverse lookup for `%s'\n",
        GNUNET_GNSRECORD_z2s (value_zone));
 
-  return get_record_and_call_iterator (plugin, stmt, zone, iter, iter_cls);
+  return get_record_and_call_iterator (plugin, stmt, zone, iter, iter_cls,
+				       GNUNET_NO);
 }
 
 
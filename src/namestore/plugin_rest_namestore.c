@@ -372,7 +372,6 @@ namestore_list_response (void *cls,
   json_t *result_array;
   json_t *record_obj;
   int i;
-  char *result;
 
   if (NULL == handle->resp_object)
     handle->resp_object = GNUNET_REST_jsonapi_object_new ();
@@ -380,15 +379,15 @@ namestore_list_response (void *cls,
   if (NULL == rname)
   {
     handle->list_it = NULL;
-    //Handle response
-    if (GNUNET_SYSERR == GNUNET_REST_jsonapi_data_serialize (handle->resp_object, &result))
+    //Handle response; the stream takes over the resp_object
+    resp = GNUNET_REST_create_jsonapi_response (handle->resp_object);
+    handle->resp_object = NULL;
+    if (NULL == resp)
     {
       GNUNET_SCHEDULER_add_now (&do_error, handle);
       return;
     }
-    resp = GNUNET_REST_create_json_response (result);
     handle->proc (handle->proc_cls, resp, MHD_HTTP_OK);
-    GNUNET_free (result);
     GNUNET_SCHEDULER_add_now (&cleanup_handle_delayed, handle);
     return;
   }
@@ -135,6 +135,12 @@ struct LocalAddressList
    */
   struct LocalAddressList *prev;
 
+  /**
+   * Key of this entry in the handle's 'lal_map': hash over the
+   * bare IP address (without port), so lookups by IP are O(1).
+   */
+  struct GNUNET_HashCode key;
+
   /**
    * Number of bytes of address that follow.
    */
@@ -262,6 +268,13 @@ struct GNUNET_NAT_Handle
    */
   struct LocalAddressList *lal_tail;
 
+  /**
+   * Map of currently valid addresses, keyed by the hash of the bare
+   * IP address (see 'key' in `struct LocalAddressList`); used to
+   * answer #GNUNET_NAT_test_address() without scanning the list.
+   */
+  struct GNUNET_CONTAINER_MultiHashMap *lal_map;
+
   /**
    * How long do we wait for restarting a crashed gnunet-helper-nat-server?
    */
@@ -493,6 +506,10 @@ remove_from_address_list_by_source (struct GNUNET_NAT_Handle *h,
     GNUNET_CONTAINER_DLL_remove (h->lal_head,
                                  h->lal_tail,
                                  pos);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multihashmap_remove (h->lal_map,
+                                                         &pos->key,
+                                                         pos));
     if (NULL != h->address_callback)
       h->address_callback (h->callback_cls,
                            GNUNET_NO,
@@ -524,9 +541,22 @@ add_to_address_list_as_is (struct GNUNET_NAT_Handle *h,
   memcpy (&lal[1], arg, arg_size);
   lal->addrlen = arg_size;
   lal->source = src;
+  if (sizeof (struct sockaddr_in) == arg_size)
+    GNUNET_CRYPTO_hash (&((const struct sockaddr_in *) arg)->sin_addr,
+                        sizeof (struct in_addr),
+                        &lal->key);
+  else
+    GNUNET_CRYPTO_hash (&((const struct sockaddr_in6 *) arg)->sin6_addr,
+                        sizeof (struct in6_addr),
+                        &lal->key);
   GNUNET_CONTAINER_DLL_insert (h->lal_head,
                                h->lal_tail,
                                lal);
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_multihashmap_put (h->lal_map,
+                                                    &lal->key,
+                                                    lal,
+                                                    GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Adding address `%s' from source %d\n",
        GNUNET_a2s (arg, arg_size),
@@ -1360,6 +1390,10 @@ upnp_add (void *cls,
       GNUNET_CONTAINER_DLL_remove (h->lal_head,
                                    h->lal_tail,
                                    pos);
+      GNUNET_assert (GNUNET_OK ==
+                     GNUNET_CONTAINER_multihashmap_remove (h->lal_map,
+                                                           &pos->key,
+                                                           pos));
       if (NULL != h->address_callback)
         h->address_callback (h->callback_cls,
                              GNUNET_NO,
@@ -1520,6 +1554,8 @@ GNUNET_NAT_register (const struct GNUNET_CONFIGURATION_Handle *cfg,
        "Registered with NAT service at port %u with %u IP bound local addresses\n",
        (unsigned int) adv_port, num_addrs);
   h = GNUNET_new (struct GNUNET_NAT_Handle);
+  h->lal_map = GNUNET_CONTAINER_multihashmap_create (31,
+                                                     GNUNET_NO);
   h->server_retry_delay = GNUNET_TIME_UNIT_SECONDS;
   h->cfg = cfg;
   h->is_tcp = is_tcp;
@@ -1860,6 +1896,10 @@ GNUNET_NAT_unregister (struct GNUNET_NAT_Handle *h)
     GNUNET_CONTAINER_DLL_remove (h->lal_head,
                                  h->lal_tail,
                                  lal);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multihashmap_remove (h->lal_map,
+                                                         &lal->key,
+                                                         lal));
     if (NULL != h->address_callback)
       h->address_callback (h->callback_cls,
                            GNUNET_NO,
@@ -1867,6 +1907,8 @@ GNUNET_NAT_unregister (struct GNUNET_NAT_Handle *h)
                            lal->addrlen);
     GNUNET_free (lal);
   }
+  GNUNET_CONTAINER_multihashmap_destroy (h->lal_map);
+  h->lal_map = NULL;
   for (i = 0; i < h->num_local_addrs; i++)
     GNUNET_free (h->local_addrs[i]);
   GNUNET_free_non_null (h->local_addrs);
@@ -1957,9 +1999,7 @@ GNUNET_NAT_test_address (struct GNUNET_NAT_Handle *h,
                          const void *addr,
                          socklen_t addrlen)
 {
-  struct LocalAddressList *pos;
-  const struct sockaddr_in *in4;
-  const struct sockaddr_in6 *in6;
+  struct GNUNET_HashCode key;
   char pbuf[INET6_ADDRSTRLEN+1];
 
   if ((addrlen != sizeof (struct in_addr)) &&
@@ -1968,27 +2008,16 @@ GNUNET_NAT_test_address (struct GNUNET_NAT_Handle *h,
     GNUNET_break (0);
     return GNUNET_SYSERR;
   }
-  for (pos = h->lal_head; NULL != pos; pos = pos->next)
-  {
-    if (pos->addrlen == sizeof (struct sockaddr_in))
-    {
-      in4 = (struct sockaddr_in *) &pos[1];
-      if ((addrlen == sizeof (struct in_addr)) &&
-          (0 == memcmp (&in4->sin_addr, addr, sizeof (struct in_addr))))
-        return GNUNET_YES;
-    }
-    else if (pos->addrlen == sizeof (struct sockaddr_in6))
-    {
-      in6 = (struct sockaddr_in6 *) &pos[1];
-      if ((addrlen == sizeof (struct in6_addr)) &&
-          (0 == memcmp (&in6->sin6_addr, addr, sizeof (struct in6_addr))))
-        return GNUNET_YES;
-    }
-    else
-    {
-      GNUNET_assert (0);
-    }
-  }
+  /* entries are indexed by the hash of the bare IP (the port is
+     excluded from the key), so one lookup covers all entries that
+     were added for this address */
+  GNUNET_CRYPTO_hash (addr,
+                      addrlen,
+                      &key);
+  if (GNUNET_YES ==
+      GNUNET_CONTAINER_multihashmap_contains (h->lal_map,
+                                              &key))
+    return GNUNET_YES;
   LOG (GNUNET_ERROR_TYPE_WARNING,
        "Asked to validate one of my addresses (%s) and validation failed!\n",
        inet_ntop ((addrlen == sizeof(struct in_addr))
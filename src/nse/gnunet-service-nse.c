@@ -91,6 +91,12 @@ static struct GNUNET_TIME_Relative gnunet_nse_interval;
  */
 static struct GNUNET_TIME_Relative proof_find_delay;
 
+/**
+ * Maximum amount of CPU time we spend per proof find run before
+ * yielding back to the scheduler (CPU budget per slice).
+ */
+static struct GNUNET_TIME_Relative proof_slice_time;
+
 #if ENABLE_NSE_HISTOGRAM
 
 /**
@@ -235,6 +241,14 @@ static struct GNUNET_CORE_Handle *core_api;
  */
 static struct GNUNET_CONTAINER_MultiPeerMap *peers;
 
+/**
+ * Map from flood message origins to the last proof of work value
+ * (a `uint64_t` in NBO) that we fully verified for them.  Lets us
+ * skip the expensive proof-of-work hash when the same origin
+ * floods us again, which happens many times per round.
+ */
+static struct GNUNET_CONTAINER_MultiPeerMap *pow_cache;
+
 /**
  * The current network size estimate.  Number of bits matching on
  * average thus far.
@@ -929,14 +943,14 @@ find_proof (void *cls,
   char buf[sizeof (struct GNUNET_CRYPTO_EddsaPublicKey) +
            sizeof (uint64_t)] GNUNET_ALIGN;
   struct GNUNET_HashCode result;
-  unsigned int i;
+  struct GNUNET_TIME_Absolute timestamp;
 
   proof_task = NULL;
   memcpy (&buf[sizeof (uint64_t)], &my_identity,
           sizeof (struct GNUNET_PeerIdentity));
-  i = 0;
   counter = my_proof;
-  while ((counter != UINT64_MAX) && (i < ROUND_SIZE))
+  timestamp = GNUNET_TIME_absolute_get ();
+  while (counter != UINT64_MAX)
   {
     memcpy (buf, &counter, sizeof (uint64_t));
     pow_hash (buf, sizeof (buf), &result);
@@ -950,7 +964,10 @@ find_proof (void *cls,
       return;
     }
     counter++;
-    i++;
+    /* CPU budget for this slice used up? */
+    if (GNUNET_TIME_absolute_get_duration (timestamp).rel_value_us >=
+        proof_slice_time.rel_value_us)
+      break;
   }
   if (my_proof / (100 * ROUND_SIZE) < counter / (100 * ROUND_SIZE))
   {
@@ -984,9 +1001,21 @@ find_proof (void *cls,
 static int
 verify_message_crypto (const struct GNUNET_NSE_FloodMessage *incoming_flood)
 {
-  if (GNUNET_YES !=
-      check_proof_of_work (&incoming_flood->origin.public_key,
-                           incoming_flood->proof_of_work))
+  uint64_t *cached_pow;
+
+  cached_pow = GNUNET_CONTAINER_multipeermap_get (pow_cache,
+                                                  &incoming_flood->origin);
+  if ( (NULL != cached_pow) &&
+       (*cached_pow == incoming_flood->proof_of_work) )
+  {
+    /* we did the expensive check for this origin and value before */
+    GNUNET_STATISTICS_update (stats,
+                              "# proof of work checks skipped (cached)",
+                              1, GNUNET_NO);
+  }
+  else if (GNUNET_YES !=
+           check_proof_of_work (&incoming_flood->origin.public_key,
+                                incoming_flood->proof_of_work))
   {
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                 "Proof of work invalid: %llu!\n",
@@ -1005,6 +1034,18 @@ verify_message_crypto (const struct GNUNET_NSE_FloodMessage *incoming_flood)
     GNUNET_break_op (0);
     return GNUNET_NO;
   }
+  /* only remember fully verified messages, so an attacker cannot
+     populate the cache with bogus values cheaply */
+  if (NULL == cached_pow)
+  {
+    cached_pow = GNUNET_new (uint64_t);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multipeermap_put (pow_cache,
+                                                      &incoming_flood->origin,
+                                                      cached_pow,
+                                                      GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+  }
+  *cached_pow = incoming_flood->proof_of_work;
   return GNUNET_YES;
 }
 
@@ -1339,6 +1380,24 @@ flush_comp_cb (void *cls,
 #endif
 
 
+/**
+ * Iterator to free the cached proof of work values.
+ *
+ * @param cls unused
+ * @param key hash of peer identity (unused)
+ * @param value the cached `uint64_t` to free
+ * @return #GNUNET_OK (continue to iterate)
+ */
+static int
+free_pow_cache_entry (void *cls,
+                      const struct GNUNET_PeerIdentity *key,
+                      void *value)
+{
+  GNUNET_free (value);
+  return GNUNET_OK;
+}
+
+
 /**
  * Task run during shutdown.
  *
@@ -1380,6 +1439,13 @@ shutdown_task (void *cls,
     GNUNET_CONTAINER_multipeermap_destroy (peers);
     peers = NULL;
   }
+  if (NULL != pow_cache)
+  {
+    GNUNET_CONTAINER_multipeermap_iterate (pow_cache,
+                                           &free_pow_cache_entry, NULL);
+    GNUNET_CONTAINER_multipeermap_destroy (pow_cache);
+    pow_cache = NULL;
+  }
   if (NULL != my_private_key)
   {
     GNUNET_free (my_private_key);
@@ -1524,6 +1590,11 @@ run (void *cls,
     GNUNET_SCHEDULER_shutdown ();
     return;
   }
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_time (cfg, "NSE", "WORKSLICE",
+					   &proof_slice_time))
+    proof_slice_time =
+	GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MILLISECONDS, 5);
   if (GNUNET_OK !=
       GNUNET_CONFIGURATION_get_value_number (cfg, "NSE", "WORKBITS",
 					     &nse_work_required))
@@ -1594,6 +1665,7 @@ run (void *cls,
                                           &find_proof, NULL);
 
   peers = GNUNET_CONTAINER_multipeermap_create (128, GNUNET_NO);
+  pow_cache = GNUNET_CONTAINER_multipeermap_create (128, GNUNET_NO);
   GNUNET_SERVER_add_handlers (srv, handlers);
   nc = GNUNET_SERVER_notification_context_create (srv, 1);
   /* Connect to core service and register core handlers */
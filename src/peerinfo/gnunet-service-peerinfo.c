@@ -45,6 +45,12 @@
  */
 #define DATA_HOST_CLEAN_FREQ GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 60)
 
+/**
+ * How long do we delay writing updated HELLOs to disk?  Updates
+ * arriving in the meantime are batched into a single write.
+ */
+#define DATA_HOST_FLUSH_FREQ GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 5)
+
 
 /**
  * In-memory cache of known hosts.
@@ -67,6 +73,12 @@ struct HostEntry
    */
   struct GNUNET_HELLO_Message *friend_only_hello;
 
+  /**
+   * Set to #GNUNET_YES if the HELLOs changed since the entry
+   * was last written to disk.
+   */
+  int dirty;
+
 };
 
 /**
@@ -161,6 +173,11 @@ static struct NotificationContext *nc_head;
  */
 static struct NotificationContext *nc_tail;
 
+/**
+ * Task writing dirty host entries to disk, NULL if none is scheduled.
+ */
+static struct GNUNET_SCHEDULER_Task *flush_task;
+
 
 /**
  * Notify all clients in the notify list about the
@@ -273,8 +290,9 @@ notify_all (struct HostEntry *entry)
   struct InfoMessage *msg_friend;
   struct NotificationContext *cur;
 
-  msg_pub = make_info_message (entry, GNUNET_NO);
-  msg_friend = make_info_message (entry, GNUNET_YES);
+  /* serialize lazily, only for subscriber types that exist */
+  msg_pub = NULL;
+  msg_friend = NULL;
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
 	      "Notifying all clients about peer `%s'\n",
 	      GNUNET_i2s(&entry->identity));
@@ -282,6 +300,8 @@ notify_all (struct HostEntry *entry)
   {
     if (GNUNET_NO == cur->include_friend_only)
       {
+	if (NULL == msg_pub)
+	  msg_pub = make_info_message (entry, GNUNET_NO);
 	GNUNET_SERVER_notification_context_unicast (notify_list,
 						    cur->client,
 						    &msg_pub->header,
@@ -289,14 +309,16 @@ notify_all (struct HostEntry *entry)
       }
     if (GNUNET_YES == cur->include_friend_only)
     {
+      if (NULL == msg_friend)
+	msg_friend = make_info_message (entry, GNUNET_YES);
       GNUNET_SERVER_notification_context_unicast (notify_list,
 						  cur->client,
 						  &msg_friend->header,
 						  GNUNET_NO);
     }
   }
-  GNUNET_free (msg_pub);
-  GNUNET_free (msg_friend);
+  GNUNET_free_non_null (msg_pub);
+  GNUNET_free_non_null (msg_friend);
 }
 
 
@@ -727,88 +749,24 @@ update_friend_hello (const struct GNUNET_HELLO_Message *hello,
 
 
 /**
- * Bind a host address (hello) to a hostId.
+ * Write the HELLOs of the given host entry to disk; if no
+ * addresses are left to store, remove the file instead.
  *
- * @param peer the peer for which this is a hello
- * @param hello the verified (!) hello message
+ * @param host entry to write
  */
 static void
-update_hello (const struct GNUNET_PeerIdentity *peer,
-              const struct GNUNET_HELLO_Message *hello)
+flush_host_entry (struct HostEntry *host)
 {
   char *fn;
-  struct HostEntry *host;
-  struct GNUNET_HELLO_Message *mrg;
-  struct GNUNET_HELLO_Message **dest;
-  struct GNUNET_TIME_Absolute delta;
   unsigned int cnt;
   unsigned int size;
-  int friend_hello_type;
   int store_hello;
   int store_friend_hello;
   int pos;
   char *buffer;
 
-  host = GNUNET_CONTAINER_multipeermap_get (hostmap, peer);
-  GNUNET_assert (NULL != host);
-
-  friend_hello_type = GNUNET_HELLO_is_friend_only (hello);
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-              "Updating %s HELLO for `%s'\n",
-              (GNUNET_YES == friend_hello_type) ? "friend-only" : "public",
-              GNUNET_i2s (peer));
-
-  dest = NULL;
-  if (GNUNET_YES == friend_hello_type)
-  {
-    dest = &host->friend_only_hello;
-  }
-  else
-  {
-    dest = &host->hello;
-  }
-
-  if (NULL == (*dest))
-  {
-    (*dest) = GNUNET_malloc (GNUNET_HELLO_size (hello));
-    memcpy ((*dest), hello, GNUNET_HELLO_size (hello));
-  }
-  else
-  {
-    mrg = GNUNET_HELLO_merge ((*dest), hello);
-    delta = GNUNET_HELLO_equals (mrg, (*dest), GNUNET_TIME_absolute_get ());
-    if (delta.abs_value_us == GNUNET_TIME_UNIT_FOREVER_ABS.abs_value_us)
-    {
-      /* no differences, just ignore the update */
-      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                  "No change in %s HELLO for `%s'\n",
-                  (GNUNET_YES == friend_hello_type) ? "friend-only" : "public",
-                  GNUNET_i2s (peer));
-      GNUNET_free (mrg);
-      return;
-    }
-    GNUNET_free ((*dest));
-    (*dest) = mrg;
-  }
-
-  if ( (NULL != (host->hello)) &&
-       (GNUNET_NO == friend_hello_type) )
-  {
-    /* Update friend only hello */
-    mrg = update_friend_hello (host->hello, host->friend_only_hello);
-    if (NULL != host->friend_only_hello)
-      GNUNET_free (host->friend_only_hello);
-    host->friend_only_hello = mrg;
-  }
-
-  if (NULL != host->hello)
-    GNUNET_assert ((GNUNET_NO ==
-                    GNUNET_HELLO_is_friend_only (host->hello)));
-  if (NULL != host->friend_only_hello)
-    GNUNET_assert ((GNUNET_YES ==
-                    GNUNET_HELLO_is_friend_only (host->friend_only_hello)));
-
-  fn = get_host_filename (peer);
+  host->dirty = GNUNET_NO;
+  fn = get_host_filename (&host->identity);
   if ( (NULL != fn) &&
        (GNUNET_OK ==
         GNUNET_DISK_directory_create_for_file (fn)) )
@@ -883,6 +841,142 @@ update_hello (const struct GNUNET_PeerIdentity *peer,
     }
   }
   GNUNET_free_non_null (fn);
+}
+
+
+/**
+ * Write the given host entry to disk if it has pending changes.
+ *
+ * @param cls NULL
+ * @param key hostID
+ * @param value the `struct HostEntry` to flush
+ * @return #GNUNET_YES (continue to iterate)
+ */
+static int
+flush_host_entry_it (void *cls,
+                     const struct GNUNET_PeerIdentity *key,
+                     void *value)
+{
+  struct HostEntry *host = value;
+
+  if (GNUNET_YES == host->dirty)
+    flush_host_entry (host);
+  return GNUNET_YES;
+}
+
+
+/**
+ * Task writing all dirty host entries to disk, batching the
+ * updates that arrived since the last flush.
+ *
+ * @param cls unused
+ * @param tc scheduler context
+ */
+static void
+flush_all_hosts (void *cls,
+                 const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  flush_task = NULL;
+  GNUNET_CONTAINER_multipeermap_iterate (hostmap,
+                                         &flush_host_entry_it,
+                                         NULL);
+}
+
+
+/**
+ * Bind a host address (hello) to a hostId.
+ *
+ * @param peer the peer for which this is a hello
+ * @param hello the verified (!) hello message
+ */
+static void
+update_hello (const struct GNUNET_PeerIdentity *peer,
+              const struct GNUNET_HELLO_Message *hello)
+{
+  struct HostEntry *host;
+  struct GNUNET_HELLO_Message *mrg;
+  struct GNUNET_HELLO_Message **dest;
+  struct GNUNET_TIME_Absolute delta;
+  int friend_hello_type;
+
+  host = GNUNET_CONTAINER_multipeermap_get (hostmap, peer);
+  GNUNET_assert (NULL != host);
+
+  friend_hello_type = GNUNET_HELLO_is_friend_only (hello);
+  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+              "Updating %s HELLO for `%s'\n",
+              (GNUNET_YES == friend_hello_type) ? "friend-only" : "public",
+              GNUNET_i2s (peer));
+
+  dest = NULL;
+  if (GNUNET_YES == friend_hello_type)
+  {
+    dest = &host->friend_only_hello;
+  }
+  else
+  {
+    dest = &host->hello;
+  }
+
+  if ( (NULL != (*dest)) &&
+       (GNUNET_HELLO_size (*dest) == GNUNET_HELLO_size (hello)) &&
+       (0 == memcmp ((*dest), hello, GNUNET_HELLO_size (hello))) )
+  {
+    /* byte-identical to what we already have, skip the merge;
+       this is the common case for re-gossiped HELLOs */
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                "No change in %s HELLO for `%s'\n",
+                (GNUNET_YES == friend_hello_type) ? "friend-only" : "public",
+                GNUNET_i2s (peer));
+    return;
+  }
+
+  if (NULL == (*dest))
+  {
+    (*dest) = GNUNET_malloc (GNUNET_HELLO_size (hello));
+    memcpy ((*dest), hello, GNUNET_HELLO_size (hello));
+  }
+  else
+  {
+    mrg = GNUNET_HELLO_merge ((*dest), hello);
+    delta = GNUNET_HELLO_equals (mrg, (*dest), GNUNET_TIME_absolute_get ());
+    if (delta.abs_value_us == GNUNET_TIME_UNIT_FOREVER_ABS.abs_value_us)
+    {
+      /* no differences, just ignore the update */
+      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                  "No change in %s HELLO for `%s'\n",
+                  (GNUNET_YES == friend_hello_type) ? "friend-only" : "public",
+                  GNUNET_i2s (peer));
+      GNUNET_free (mrg);
+      return;
+    }
+    GNUNET_free ((*dest));
+    (*dest) = mrg;
+  }
+
+  if ( (NULL != (host->hello)) &&
+       (GNUNET_NO == friend_hello_type) )
+  {
+    /* Update friend only hello */
+    mrg = update_friend_hello (host->hello, host->friend_only_hello);
+    if (NULL != host->friend_only_hello)
+      GNUNET_free (host->friend_only_hello);
+    host->friend_only_hello = mrg;
+  }
+
+  if (NULL != host->hello)
+    GNUNET_assert ((GNUNET_NO ==
+                    GNUNET_HELLO_is_friend_only (host->hello)));
+  if (NULL != host->friend_only_hello)
+    GNUNET_assert ((GNUNET_YES ==
+                    GNUNET_HELLO_is_friend_only (host->friend_only_hello)));
+
+  host->dirty = GNUNET_YES;
+  if ( (NULL != networkIdDirectory) &&
+       (NULL == flush_task) )
+    flush_task = GNUNET_SCHEDULER_add_delayed (DATA_HOST_FLUSH_FREQ,
+                                               &flush_all_hosts,
+                                               NULL);
   notify_all (host);
 }
 
@@ -1289,6 +1383,14 @@ shutdown_task (void *cls,
   GNUNET_SERVER_notification_context_destroy (notify_list);
   notify_list = NULL;
 
+  if (NULL != flush_task)
+  {
+    GNUNET_SCHEDULER_cancel (flush_task);
+    flush_task = NULL;
+  }
+  GNUNET_CONTAINER_multipeermap_iterate (hostmap,
+                                         &flush_host_entry_it,
+                                         NULL);
   for (cur = nc_head; NULL != cur; cur = next)
   {
     next = cur->next;
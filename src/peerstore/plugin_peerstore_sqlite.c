@@ -42,6 +42,16 @@
  */
 #define BUSY_TIMEOUT_MS 1000
 
+/**
+ * How many records do we (at most) combine into a single transaction
+ * before committing?  Committing per INSERT makes sqlite pay the
+ * journal overhead for every record, which dominates the store path
+ * when transport writes its per-peer metrics at high rate.  Since all
+ * reads go through the same connection they see uncommitted records,
+ * so batching is invisible to iterate requests.
+ */
+#define BULK_COMMIT_LIMIT 64
+
 /**
  * Log an error message at log-level 'level' that indicates
  * a failure of the command 'cmd' on file 'filename'
@@ -109,8 +119,58 @@ struct Plugin
    */
   sqlite3_stmt *delete_peerstoredata;
 
+  /**
+   * #GNUNET_YES if a bulk transaction is currently open
+   */
+  int in_transaction;
+
+  /**
+   * Number of records stored in the currently open bulk transaction
+   */
+  unsigned int transaction_cnt;
+
 };
 
+/**
+ * Begin a bulk transaction, unless one is already open
+ *
+ * @param plugin the plugin context (state for this module)
+ */
+static void
+transaction_begin (struct Plugin *plugin)
+{
+  if (GNUNET_YES == plugin->in_transaction)
+    return;
+  if (SQLITE_OK !=
+      sqlite3_exec (plugin->dbh, "BEGIN TRANSACTION;", NULL, NULL, NULL))
+  {
+    LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+                "sqlite3_exec");
+    return;
+  }
+  plugin->in_transaction = GNUNET_YES;
+  plugin->transaction_cnt = 0;
+}
+
+
+/**
+ * Commit the currently open bulk transaction, if any
+ *
+ * @param plugin the plugin context (state for this module)
+ */
+static void
+transaction_commit (struct Plugin *plugin)
+{
+  if (GNUNET_YES != plugin->in_transaction)
+    return;
+  if (SQLITE_OK != sqlite3_exec (plugin->dbh, "COMMIT;", NULL, NULL, NULL))
+    LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
+                "sqlite3_exec");
+  plugin->in_transaction = GNUNET_NO;
+  plugin->transaction_cnt = 0;
+}
+
+
 /**
  * Delete records with the given key
  *
@@ -173,6 +233,9 @@ peerstore_sqlite_expire_records (void *cls, struct GNUNET_TIME_Absolute now,
   struct Plugin *plugin = cls;
   sqlite3_stmt *stmt = plugin->expire_peerstoredata;
 
+  /* the service expires on a regular interval, so committing here
+   * bounds how long combined records can stay uncommitted */
+  transaction_commit (plugin);
   if (SQLITE_OK !=
       sqlite3_bind_int64 (stmt, 1, (sqlite3_uint64) now.abs_value_us))
   {
@@ -344,6 +407,7 @@ peerstore_sqlite_store_record (void *cls, const char *sub_system,
   struct Plugin *plugin = cls;
   sqlite3_stmt *stmt = plugin->insert_peerstoredata;
 
+  transaction_begin (plugin);
   if (GNUNET_PEERSTORE_STOREOPTION_REPLACE == options)
   {
     peerstore_sqlite_delete_records (cls, sub_system, peer, key);
@@ -370,8 +434,12 @@ peerstore_sqlite_store_record (void *cls, const char *sub_system,
   {
     LOG_SQLITE (plugin, GNUNET_ERROR_TYPE_ERROR | GNUNET_ERROR_TYPE_BULK,
                 "sqlite3_reset");
+    transaction_commit (plugin);
     return GNUNET_SYSERR;
   }
+  plugin->transaction_cnt++;
+  if (plugin->transaction_cnt >= BULK_COMMIT_LIMIT)
+    transaction_commit (plugin);
   if (NULL != cont)
   {
     cont (cont_cls, GNUNET_OK);
@@ -545,6 +613,7 @@ database_shutdown (struct Plugin *plugin)
   int result;
   sqlite3_stmt *stmt;
 
+  transaction_commit (plugin);
   while (NULL != (stmt = sqlite3_next_stmt (plugin->dbh, NULL)))
   {
     result = sqlite3_finalize (stmt);
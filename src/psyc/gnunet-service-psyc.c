@@ -1380,7 +1380,19 @@ message_queue_run (struct Channel *chn)
         GNUNET_log (GNUNET_ERROR_TYPE_DEBUG, "%p state modified\n", chn);
         if (GNUNET_YES != fragq->state_is_modified)
         {
-          if (msg_id - fragq->state_delta != chn->max_state_message_id)
+          if (msg_id <= chn->max_state_message_id)
+          {
+            /* Modifiers of this message are already part of the state
+               in PSYCstore (e.g. we are replaying history after a
+               rejoin); no need for a store round trip, the stored
+               state is the snapshot and only newer messages carry
+               deltas still to apply. */
+            GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+                        "%p Modifiers of message %" PRIu64
+                        " already applied to state.\n", chn, msg_id);
+            fragq->state_is_modified = GNUNET_YES;
+          }
+          else if (msg_id - fragq->state_delta != chn->max_state_message_id)
           {
             GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
                         "%p Out of order stateful message. "
@@ -1390,17 +1402,19 @@ message_queue_run (struct Channel *chn)
             // FIXME: keep track of messages processed in this queue run,
             //        and only stop after reaching the end
           }
-
-          struct StateModifyClosure *mcls = GNUNET_malloc (sizeof (*mcls));
-          mcls->chn = chn;
-          mcls->msg_id = msg_id;
-          mcls->msg_id_hash = msg_id_hash;
-
-          /* Apply modifiers to state in PSYCstore */
-          GNUNET_PSYCSTORE_state_modify (store, &chn->pub_key, msg_id,
-                                         fragq->state_delta,
-                                         store_recv_state_modify_result, mcls);
-          break; // continue after asynchronous state modify result
+          else
+          {
+            struct StateModifyClosure *mcls = GNUNET_malloc (sizeof (*mcls));
+            mcls->chn = chn;
+            mcls->msg_id = msg_id;
+            mcls->msg_id_hash = msg_id_hash;
+
+            /* Apply modifiers to state in PSYCstore */
+            GNUNET_PSYCSTORE_state_modify (store, &chn->pub_key, msg_id,
+                                           fragq->state_delta,
+                                           store_recv_state_modify_result, mcls);
+            break; // continue after asynchronous state modify result
+          }
         }
       }
       chn->max_message_id = msg_id;
@@ -63,6 +63,64 @@ static struct GNUNET_PSYCSTORE_PluginFunctions *db;
  */
 static char *db_lib_name;
 
+/**
+ * Number of recent fragments to cache in memory per channel.  The
+ * cache answers typical rejoin replays of recent history without
+ * touching the database.
+ */
+#define RECENT_FRAGMENT_CACHE_SIZE 256
+
+/**
+ * Entry in the per-channel fragment cache.
+ */
+struct CachedFragment
+{
+  struct CachedFragment *prev;
+  struct CachedFragment *next;
+
+  /**
+   * Flags the fragment was stored with.
+   */
+  enum GNUNET_PSYCSTORE_MessageFlags flags;
+
+  /**
+   * Copy of the fragment, allocated at the end of this struct.
+   */
+  const struct GNUNET_MULTICAST_MessageHeader *msg;
+};
+
+
+/**
+ * Cache of the most recently stored fragments of one channel.
+ * Entries are kept in fragment ID order and are contiguous: the
+ * cache is flushed when a fragment arrives out of order, so when the
+ * oldest cached entry covers the start of a query, the cache is
+ * known to contain everything the database would return.
+ */
+struct ChannelCache
+{
+  /**
+   * Oldest cached fragment.
+   */
+  struct CachedFragment *head;
+
+  /**
+   * Newest cached fragment.
+   */
+  struct CachedFragment *tail;
+
+  /**
+   * Number of entries in the cache.
+   */
+  unsigned int count;
+};
+
+
+/**
+ * Map of H(channel_key) to `struct ChannelCache`.
+ */
+static struct GNUNET_CONTAINER_MultiHashMap *recent_cache;
+
 
 /**
  * Task run during shutdown.
@@ -70,9 +128,33 @@ static char *db_lib_name;
  * @param cls unused
  * @param tc unused
  */
+static int
+cleanup_channel_cache (void *cls, const struct GNUNET_HashCode *key,
+                       void *value)
+{
+  struct ChannelCache *cc = value;
+  struct CachedFragment *cf;
+
+  while (NULL != (cf = cc->head))
+  {
+    GNUNET_CONTAINER_DLL_remove (cc->head, cc->tail, cf);
+    GNUNET_free (cf);
+  }
+  GNUNET_free (cc);
+  return GNUNET_OK;
+}
+
+
 static void
 shutdown_task (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
+  if (NULL != recent_cache)
+  {
+    GNUNET_CONTAINER_multihashmap_iterate (recent_cache,
+                                           &cleanup_channel_cache, NULL);
+    GNUNET_CONTAINER_multihashmap_destroy (recent_cache);
+    recent_cache = NULL;
+  }
   if (NULL != nc)
   {
     GNUNET_SERVER_notification_context_destroy (nc);
@@ -215,6 +297,253 @@ send_fragment (void *cls, struct GNUNET_MULTICAST_MessageHeader *msg,
 }
 
 
+/**
+ * Find the fragment cache of a channel.
+ *
+ * @param channel_key
+ *        Public key of the channel.
+ * @param create
+ *        #GNUNET_YES to create the cache if it does not exist yet.
+ *
+ * @return Cache of the channel, or NULL.
+ */
+static struct ChannelCache *
+cache_get (const struct GNUNET_CRYPTO_EddsaPublicKey *channel_key, int create)
+{
+  struct GNUNET_HashCode key;
+  struct ChannelCache *cc;
+
+  GNUNET_CRYPTO_hash (channel_key, sizeof (*channel_key), &key);
+  cc = GNUNET_CONTAINER_multihashmap_get (recent_cache, &key);
+  if ( (NULL == cc) && (GNUNET_YES == create) )
+  {
+    cc = GNUNET_new (struct ChannelCache);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multihashmap_put (recent_cache, &key, cc,
+                                                      GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+  }
+  return cc;
+}
+
+
+/**
+ * Add a freshly stored fragment to the cache of its channel.
+ *
+ * @param channel_key
+ *        Public key of the channel.
+ * @param msg
+ *        Fragment that was stored.
+ * @param flags
+ *        Flags the fragment was stored with.
+ */
+static void
+cache_fragment_store (const struct GNUNET_CRYPTO_EddsaPublicKey *channel_key,
+                      const struct GNUNET_MULTICAST_MessageHeader *msg,
+                      enum GNUNET_PSYCSTORE_MessageFlags flags)
+{
+  struct ChannelCache *cc = cache_get (channel_key, GNUNET_YES);
+  struct CachedFragment *cf;
+  uint16_t msg_size = ntohs (msg->header.size);
+
+  if ( (NULL != cc->tail) &&
+       (GNUNET_ntohll (msg->fragment_id)
+        <= GNUNET_ntohll (cc->tail->msg->fragment_id)) )
+  { /* out of order: flush to keep the cached tail contiguous */
+    while (NULL != (cf = cc->head))
+    {
+      GNUNET_CONTAINER_DLL_remove (cc->head, cc->tail, cf);
+      GNUNET_free (cf);
+    }
+    cc->count = 0;
+  }
+  cf = GNUNET_malloc (sizeof (*cf) + msg_size);
+  cf->flags = flags;
+  cf->msg = (const struct GNUNET_MULTICAST_MessageHeader *) &cf[1];
+  memcpy (&cf[1], msg, msg_size);
+  GNUNET_CONTAINER_DLL_insert_tail (cc->head, cc->tail, cf);
+  if (++cc->count > RECENT_FRAGMENT_CACHE_SIZE)
+  {
+    cf = cc->head;
+    GNUNET_CONTAINER_DLL_remove (cc->head, cc->tail, cf);
+    GNUNET_free (cf);
+    cc->count--;
+  }
+}
+
+
+/**
+ * Send a cached fragment to the client.
+ *
+ * @return See send_fragment().
+ */
+static int
+send_cached_fragment (struct SendClosure *sc, const struct CachedFragment *cf)
+{
+  struct GNUNET_MULTICAST_MessageHeader *msg;
+  uint16_t msg_size = ntohs (cf->msg->header.size);
+
+  msg = GNUNET_malloc (msg_size);
+  memcpy (msg, cf->msg, msg_size);
+  return send_fragment (sc, msg, cf->flags);
+}
+
+
+/**
+ * Try to answer a fragment range query from the cache.
+ *
+ * @return #GNUNET_YES if the query was answered from the cache,
+ *         #GNUNET_NO if the database must be asked.
+ */
+static int
+cache_fragment_get (struct SendClosure *sc,
+                    uint64_t first_fragment_id,
+                    uint64_t last_fragment_id,
+                    uint64_t *ret_frags)
+{
+  struct ChannelCache *cc = cache_get (&sc->channel_key, GNUNET_NO);
+  struct CachedFragment *cf;
+  uint64_t fragment_id;
+
+  if ( (NULL == cc) || (NULL == cc->head) )
+    return GNUNET_NO;
+  if (GNUNET_ntohll (cc->head->msg->fragment_id) > first_fragment_id)
+    return GNUNET_NO; /* cache does not reach back far enough */
+  for (cf = cc->head; NULL != cf; cf = cf->next)
+  {
+    fragment_id = GNUNET_ntohll (cf->msg->fragment_id);
+    if (fragment_id < first_fragment_id)
+      continue;
+    if (fragment_id > last_fragment_id)
+      break;
+    if (GNUNET_YES != send_cached_fragment (sc, cf))
+      break;
+    (*ret_frags)++;
+  }
+  return GNUNET_YES;
+}
+
+
+/**
+ * Try to answer a query for the latest @a limit fragments from the
+ * cache.
+ *
+ * @return #GNUNET_YES if the query was answered from the cache,
+ *         #GNUNET_NO if the database must be asked.
+ */
+static int
+cache_fragment_get_latest (struct SendClosure *sc,
+                           uint64_t limit,
+                           uint64_t *ret_frags)
+{
+  struct ChannelCache *cc = cache_get (&sc->channel_key, GNUNET_NO);
+  struct CachedFragment *cf;
+  uint64_t skip;
+
+  if ( (NULL == cc) || (cc->count < limit) )
+    return GNUNET_NO;
+  for (cf = cc->head, skip = cc->count - limit; 0 < skip; skip--)
+    cf = cf->next;
+  for (; NULL != cf; cf = cf->next)
+  {
+    if (GNUNET_YES != send_cached_fragment (sc, cf))
+      break;
+    (*ret_frags)++;
+  }
+  return GNUNET_YES;
+}
+
+
+/**
+ * Try to answer a message range query from the cache.
+ *
+ * @return #GNUNET_YES if the query was answered from the cache,
+ *         #GNUNET_NO if the database must be asked.
+ */
+static int
+cache_message_get (struct SendClosure *sc,
+                   uint64_t first_message_id,
+                   uint64_t last_message_id,
+                   uint64_t fragment_limit,
+                   uint64_t *ret_frags)
+{
+  struct ChannelCache *cc = cache_get (&sc->channel_key, GNUNET_NO);
+  struct CachedFragment *cf;
+  uint64_t message_id;
+
+  if ( (NULL == cc) || (NULL == cc->head) )
+    return GNUNET_NO;
+  message_id = GNUNET_ntohll (cc->head->msg->message_id);
+  if ( (message_id > first_message_id) ||
+       ( (message_id == first_message_id) &&
+         (0 != GNUNET_ntohll (cc->head->msg->fragment_offset)) ) )
+    return GNUNET_NO; /* start of the requested range may be missing */
+  for (cf = cc->head; NULL != cf; cf = cf->next)
+  {
+    message_id = GNUNET_ntohll (cf->msg->message_id);
+    if (message_id < first_message_id)
+      continue;
+    if (message_id > last_message_id)
+      break;
+    if (GNUNET_YES != send_cached_fragment (sc, cf))
+      break;
+    if ( (0 != fragment_limit) && (++(*ret_frags) >= fragment_limit) )
+      break;
+    if (0 == fragment_limit)
+      (*ret_frags)++;
+  }
+  return GNUNET_YES;
+}
+
+
+/**
+ * Try to answer a query for the latest @a limit messages from the
+ * cache.
+ *
+ * @return #GNUNET_YES if the query was answered from the cache,
+ *         #GNUNET_NO if the database must be asked.
+ */
+static int
+cache_message_get_latest (struct SendClosure *sc,
+                          uint64_t limit,
+                          uint64_t *ret_frags)
+{
+  struct ChannelCache *cc = cache_get (&sc->channel_key, GNUNET_NO);
+  struct CachedFragment *cf;
+  struct CachedFragment *start = NULL;
+  uint64_t message_id;
+  uint64_t prev_message_id = 0;
+  uint64_t msg_count = 0;
+
+  if ( (NULL == cc) || (NULL == cc->tail) || (0 == limit) )
+    return GNUNET_NO;
+  for (cf = cc->tail; NULL != cf; cf = cf->prev)
+  {
+    message_id = GNUNET_ntohll (cf->msg->message_id);
+    if ( (0 == msg_count) || (message_id != prev_message_id) )
+    {
+      if (++msg_count > limit)
+        break;
+      prev_message_id = message_id;
+    }
+    if ( (msg_count == limit) &&
+         (0 == GNUNET_ntohll (cf->msg->fragment_offset)) )
+    {
+      start = cf;
+      break;
+    }
+  }
+  if (NULL == start)
+    return GNUNET_NO; /* not enough complete messages in the cache */
+  for (cf = start; NULL != cf; cf = cf->next)
+  {
+    if (GNUNET_YES != send_cached_fragment (sc, cf))
+      break;
+    (*ret_frags)++;
+  }
+  return GNUNET_YES;
+}
+
+
 static int
 send_state_var (void *cls, const char *name,
                 const void *value, uint32_t value_size)
@@ -305,6 +634,10 @@ handle_fragment_store (void *cls,
   if (ret != GNUNET_OK)
     GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
                 _("Failed to store fragment!\n"));
+  else
+    cache_fragment_store (&req->channel_key,
+                          (const struct GNUNET_MULTICAST_MessageHeader *)
+                          &req[1], ntohl (req->psycstore_flags));
 
   send_result_code (client, req->op_id, ret, NULL);
   GNUNET_SERVER_receive_done (client, GNUNET_OK);
@@ -332,12 +665,19 @@ handle_fragment_get (void *cls,
   uint64_t limit = GNUNET_ntohll (req->fragment_limit);
 
   if (0 == limit)
-    ret = db->fragment_get (db->cls, &req->channel_key,
-                            first_fragment_id, last_fragment_id,
-                            &ret_frags, send_fragment, &sc);
+    ret = (GNUNET_YES ==
+           cache_fragment_get (&sc, first_fragment_id, last_fragment_id,
+                               &ret_frags))
+      ? ((0 < ret_frags) ? GNUNET_YES : GNUNET_NO)
+      : db->fragment_get (db->cls, &req->channel_key,
+                          first_fragment_id, last_fragment_id,
+                          &ret_frags, send_fragment, &sc);
   else
-    ret = db->fragment_get_latest (db->cls, &req->channel_key, limit,
-                                   &ret_frags, send_fragment, &sc);
+    ret = (GNUNET_YES ==
+           cache_fragment_get_latest (&sc, limit, &ret_frags))
+      ? ((0 < ret_frags) ? GNUNET_YES : GNUNET_NO)
+      : db->fragment_get_latest (db->cls, &req->channel_key, limit,
+                                 &ret_frags, send_fragment, &sc);
 
   switch (ret)
   {
@@ -406,12 +746,19 @@ handle_message_get (void *cls,
 
   /** @todo method_prefix */
   if (0 == msg_limit)
-    ret = db->message_get (db->cls, &req->channel_key,
-                           first_message_id, last_message_id, frag_limit,
-                           &ret_frags, send_fragment, &sc);
+    ret = (GNUNET_YES ==
+           cache_message_get (&sc, first_message_id, last_message_id,
+                              frag_limit, &ret_frags))
+      ? ((0 < ret_frags) ? GNUNET_YES : GNUNET_NO)
+      : db->message_get (db->cls, &req->channel_key,
+                         first_message_id, last_message_id, frag_limit,
+                         &ret_frags, send_fragment, &sc);
   else
-    ret = db->message_get_latest (db->cls, &req->channel_key, msg_limit,
-                                  &ret_frags, send_fragment, &sc);
+    ret = (GNUNET_YES ==
+           cache_message_get_latest (&sc, msg_limit, &ret_frags))
+      ? ((0 < ret_frags) ? GNUNET_YES : GNUNET_NO)
+      : db->message_get_latest (db->cls, &req->channel_key, msg_limit,
+                                &ret_frags, send_fragment, &sc);
 
   switch (ret)
   {
@@ -964,6 +1311,7 @@ run (void *cls, struct GNUNET_SERVER_Handle *server,
   }
 
   stats = GNUNET_STATISTICS_create ("psycstore", cfg);
+  recent_cache = GNUNET_CONTAINER_multihashmap_create (16, GNUNET_NO);
   GNUNET_SERVER_add_handlers (server, handlers);
   nc = GNUNET_SERVER_notification_context_create (server, 1);
   GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_UNIT_FOREVER_REL, &shutdown_task,
@@ -55,6 +55,19 @@
  */
 #define MAX_OPEN_TUNNELS 4
 
+/**
+ * For how long do we cache DNS replies at most?  Kept deliberately
+ * short: the cache only exists to absorb bursts of identical queries
+ * (as browsers tend to generate under load); respecting the records'
+ * actual TTLs is left to the client's resolver.
+ */
+#define REPLY_CACHE_TTL GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS, 5)
+
+/**
+ * How many DNS replies do we cache at most?
+ */
+#define REPLY_CACHE_SIZE 32
+
 
 /**
  * Which group of DNS records are we currently processing?
@@ -249,6 +262,55 @@ struct RequestContext
 };
 
 
+/**
+ * Entry in the short-lived DNS reply cache.
+ */
+struct ReplyCacheEntry
+{
+  /**
+   * Kept in a DLL, most-recently used first.
+   */
+  struct ReplyCacheEntry *next;
+
+  /**
+   * Kept in a DLL.
+   */
+  struct ReplyCacheEntry *prev;
+
+  /**
+   * Name the query was for (0-terminated, UTF-8).
+   */
+  char *name;
+
+  /**
+   * Cached reply (starting with the DNS header), allocated
+   * at the end of this struct.
+   */
+  const char *reply;
+
+  /**
+   * Number of bytes in @e reply.
+   */
+  size_t reply_length;
+
+  /**
+   * When does this cache entry expire?
+   */
+  struct GNUNET_TIME_Absolute expiration;
+
+  /**
+   * Type of the query (i.e. A, AAAA), see GNUNET_DNSPARSER_TYPE_*.
+   */
+  uint16_t type;
+
+  /**
+   * Class of the query, see GNUNET_TUN_DNS_CLASS_*.
+   */
+  uint16_t dns_traffic_class;
+
+};
+
+
 /**
  * Head of DLL of cadet exits.  Cadet exits with an open channel are
  * always at the beginning (so we do not have to traverse the entire
@@ -261,6 +323,21 @@ static struct CadetExit *exit_head;
  */
 static struct CadetExit *exit_tail;
 
+/**
+ * Head of DLL of cached DNS replies, most-recently used first.
+ */
+static struct ReplyCacheEntry *cache_head;
+
+/**
+ * Tail of DLL of cached DNS replies.
+ */
+static struct ReplyCacheEntry *cache_tail;
+
+/**
+ * Number of entries in the reply cache.
+ */
+static unsigned int cache_size;
+
 /**
  * The handle to the configuration used throughout the process
  */
@@ -856,6 +933,126 @@ timeout_request (void *cls,
 }
 
 
+/**
+ * Free an entry in the reply cache.
+ *
+ * @param ce entry to free, must already be off the DLL
+ */
+static void
+free_cache_entry (struct ReplyCacheEntry *ce)
+{
+  GNUNET_free (ce->name);
+  GNUNET_free (ce);
+}
+
+
+/**
+ * Find a cached reply for the given query.  Expired entries
+ * encountered during the scan are discarded.
+ *
+ * @param name name the query is for
+ * @param type type of the query
+ * @param dns_traffic_class class of the query
+ * @return matching cache entry, or NULL for none
+ */
+static struct ReplyCacheEntry *
+reply_cache_lookup (const char *name,
+		    uint16_t type,
+		    uint16_t dns_traffic_class)
+{
+  struct ReplyCacheEntry *ce;
+  struct ReplyCacheEntry *nxt;
+
+  nxt = cache_head;
+  while (NULL != (ce = nxt))
+  {
+    nxt = ce->next;
+    if (0 == GNUNET_TIME_absolute_get_remaining (ce->expiration).rel_value_us)
+    {
+      GNUNET_CONTAINER_DLL_remove (cache_head,
+				   cache_tail,
+				   ce);
+      cache_size--;
+      free_cache_entry (ce);
+      continue;
+    }
+    if ( (type == ce->type) &&
+	 (dns_traffic_class == ce->dns_traffic_class) &&
+	 (0 == strcasecmp (name, ce->name)) )
+    {
+      /* move to head to keep the DLL in LRU order */
+      GNUNET_CONTAINER_DLL_remove (cache_head,
+				   cache_tail,
+				   ce);
+      GNUNET_CONTAINER_DLL_insert (cache_head,
+				   cache_tail,
+				   ce);
+      return ce;
+    }
+  }
+  return NULL;
+}
+
+
+/**
+ * Add a DNS reply to the reply cache (if it is cacheable).
+ *
+ * @param reply reply to cache, starting with the DNS header
+ * @param reply_length number of bytes in @a reply
+ */
+static void
+reply_cache_insert (const char *reply,
+		    size_t reply_length)
+{
+  struct GNUNET_DNSPARSER_Packet *p;
+  struct ReplyCacheEntry *ce;
+
+  p = GNUNET_DNSPARSER_parse (reply, reply_length);
+  if (NULL == p)
+    return;
+  if ( (1 != p->num_queries) ||
+       (0 == p->num_answers) ||
+       (GNUNET_TUN_DNS_RETURN_CODE_NO_ERROR != p->flags.return_code) )
+  {
+    GNUNET_DNSPARSER_free_packet (p);
+    return;
+  }
+  if (NULL != (ce = reply_cache_lookup (p->queries[0].name,
+					p->queries[0].type,
+					p->queries[0].dns_traffic_class)))
+  {
+    /* replace the existing (older) entry */
+    GNUNET_CONTAINER_DLL_remove (cache_head,
+				 cache_tail,
+				 ce);
+    cache_size--;
+    free_cache_entry (ce);
+  }
+  ce = GNUNET_malloc (sizeof (struct ReplyCacheEntry) + reply_length);
+  ce->name = GNUNET_strdup (p->queries[0].name);
+  ce->reply = (const char *) &ce[1];
+  memcpy (&ce[1], reply, reply_length);
+  ce->reply_length = reply_length;
+  ce->expiration = GNUNET_TIME_relative_to_absolute (REPLY_CACHE_TTL);
+  ce->type = p->queries[0].type;
+  ce->dns_traffic_class = p->queries[0].dns_traffic_class;
+  GNUNET_CONTAINER_DLL_insert (cache_head,
+			       cache_tail,
+			       ce);
+  cache_size++;
+  if (cache_size > REPLY_CACHE_SIZE)
+  {
+    ce = cache_tail;
+    GNUNET_CONTAINER_DLL_remove (cache_head,
+				 cache_tail,
+				 ce);
+    cache_size--;
+    free_cache_entry (ce);
+  }
+  GNUNET_DNSPARSER_free_packet (p);
+}
+
+
 /**
  * This function is called *before* the DNS request has been
  * given to a "local" DNS resolver.  Channeling for DNS requests
@@ -878,6 +1075,8 @@ dns_pre_request_handler (void *cls,
   struct GNUNET_MessageHeader hdr;
   struct GNUNET_TUN_DnsHeader dns;
   struct CadetExit *exit;
+  struct GNUNET_DNSPARSER_Packet *p;
+  struct ReplyCacheEntry *ce;
 
   GNUNET_STATISTICS_update (stats,
 			    gettext_noop ("# DNS requests intercepted"),
@@ -899,6 +1098,30 @@ dns_pre_request_handler (void *cls,
     return;
   }
   memcpy (&dns, request, sizeof (dns));
+  if (NULL != (p = GNUNET_DNSPARSER_parse (request, request_length)))
+  {
+    ce = (1 == p->num_queries)
+      ? reply_cache_lookup (p->queries[0].name,
+			    p->queries[0].type,
+			    p->queries[0].dns_traffic_class)
+      : NULL;
+    GNUNET_DNSPARSER_free_packet (p);
+    if (NULL != ce)
+    {
+      char buf[ce->reply_length];
+
+      /* answer from the cache, patching in the request's DNS ID */
+      memcpy (buf, ce->reply, ce->reply_length);
+      memcpy (buf, &dns.id, sizeof (uint16_t));
+      GNUNET_STATISTICS_update (stats,
+				gettext_noop ("# DNS requests answered from reply cache"),
+				1, GNUNET_NO);
+      GNUNET_DNS_request_answer (rh,
+				 ce->reply_length,
+				 buf);
+      return;
+    }
+  }
   mlen = sizeof (struct GNUNET_MessageHeader) + request_length;
   exit = choose_exit ();
   GNUNET_assert (NULL != exit);
@@ -971,6 +1194,8 @@ receive_dns_response (void *cls,
       GNUNET_DNS_request_answer (rc->rh,
 				 mlen,
 				 (const void*) &message[1]);
+      reply_cache_insert ((const char *) &message[1],
+			  mlen);
       GNUNET_CONTAINER_DLL_remove (exit->receive_queue_head,
 				   exit->receive_queue_tail,
 				   rc);
@@ -1031,8 +1256,18 @@ cleanup (void *cls,
 {
   struct CadetExit *exit;
 
+  struct ReplyCacheEntry *ce;
+
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
 	      "Protocol translation daemon is shutting down now\n");
+  while (NULL != (ce = cache_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (cache_head,
+				 cache_tail,
+				 ce);
+    cache_size--;
+    free_cache_entry (ce);
+  }
   if (NULL != vpn_handle)
   {
     GNUNET_VPN_disconnect (vpn_handle);
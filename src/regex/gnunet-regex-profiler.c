@@ -167,6 +167,12 @@ struct RegexPeer
    */
   struct GNUNET_TIME_Absolute prof_start_time;
 
+  /**
+   * How long searching for @e search_str took; only valid if
+   * @e search_str_matched is #GNUNET_YES.
+   */
+  struct GNUNET_TIME_Relative search_duration;
+
   /**
    * Operation timeout
    */
@@ -313,6 +319,16 @@ static struct GNUNET_DISK_FileHandle *data_file;
  */
 static char *data_filename;
 
+/**
+ * File to write per-string search latencies and their percentiles to.
+ */
+static struct GNUNET_DISK_FileHandle *csv_file;
+
+/**
+ * Filename for the latency CSV output.
+ */
+static char *csv_filename;
+
 /**
  * Prefix used for regex announcing. We need to prefix the search
  * strings with it, in order to find something.
@@ -395,6 +411,117 @@ announce_next_regex (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc);
 /******************************************************************************/
 
 
+/**
+ * Comparator for uint64_t latency values, used with qsort.
+ *
+ * @param a pointer to first latency
+ * @param b pointer to second latency
+ * @return negative, zero or positive if *a is smaller, equal or larger
+ */
+static int
+latency_cmp (const void *a, const void *b)
+{
+  const uint64_t *l1 = a;
+  const uint64_t *l2 = b;
+
+  if (*l1 < *l2)
+    return -1;
+  if (*l1 > *l2)
+    return 1;
+  return 0;
+}
+
+
+/**
+ * Write one line per search string with its matching latency to
+ * 'csv_file', followed by the latency percentiles over all matched
+ * strings.  The run parameters go into a leading comment so runs
+ * with different fan-out / compression / replication settings can
+ * be told apart when collecting the files.
+ */
+static void
+write_csv_summary ()
+{
+  struct RegexPeer *peer;
+  uint64_t *latencies;
+  uint64_t sum;
+  unsigned long long max_path_compression;
+  unsigned int peer_cnt;
+  unsigned int n;
+  char output_buffer[512];
+  size_t size;
+
+  if (NULL == csv_file)
+    return;
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (cfg, "REGEXPROFILER",
+                                             "MAX_PATH_COMPRESSION",
+                                             &max_path_compression))
+    max_path_compression = 0;
+  size =
+    GNUNET_snprintf (output_buffer,
+                     sizeof (output_buffer),
+                     "# peers=%u parallel_searches=%llu max_path_compression=%llu\n"
+                     "peer,search_string,matched,latency_us\n",
+                     num_peers,
+                     init_parallel_searches,
+                     max_path_compression);
+  if (size != GNUNET_DISK_file_write (csv_file, output_buffer, size))
+    GNUNET_log (GNUNET_ERROR_TYPE_WARNING, "Unable to write to file!\n");
+  latencies = GNUNET_malloc (sizeof (uint64_t) * num_peers);
+  n = 0;
+  sum = 0;
+  for (peer_cnt = 0; peer_cnt < num_peers; peer_cnt++)
+  {
+    peer = &peers[peer_cnt];
+    if (NULL == peer->search_str)
+      continue;
+    if (GNUNET_YES == peer->search_str_matched)
+    {
+      size =
+        GNUNET_snprintf (output_buffer,
+                         sizeof (output_buffer),
+                         "%u,%s,1,%llu\n",
+                         peer->id,
+                         peer->search_str,
+                         (unsigned long long) peer->search_duration.rel_value_us);
+      latencies[n++] = peer->search_duration.rel_value_us;
+      sum += peer->search_duration.rel_value_us;
+    }
+    else
+    {
+      size =
+        GNUNET_snprintf (output_buffer,
+                         sizeof (output_buffer),
+                         "%u,%s,0,\n",
+                         peer->id,
+                         peer->search_str);
+    }
+    if (size != GNUNET_DISK_file_write (csv_file, output_buffer, size))
+      GNUNET_log (GNUNET_ERROR_TYPE_WARNING, "Unable to write to file!\n");
+  }
+  if (0 < n)
+  {
+    qsort (latencies, n, sizeof (uint64_t), &latency_cmp);
+    size =
+      GNUNET_snprintf (output_buffer,
+                       sizeof (output_buffer),
+                       "# latency_us n=%u min=%llu p50=%llu p90=%llu p95=%llu max=%llu mean=%llu\n",
+                       n,
+                       (unsigned long long) latencies[0],
+                       (unsigned long long) latencies[(n * 50) / 100],
+                       (unsigned long long) latencies[GNUNET_MIN (n - 1, (n * 90) / 100)],
+                       (unsigned long long) latencies[GNUNET_MIN (n - 1, (n * 95) / 100)],
+                       (unsigned long long) latencies[n - 1],
+                       (unsigned long long) (sum / n));
+    if (size != GNUNET_DISK_file_write (csv_file, output_buffer, size))
+      GNUNET_log (GNUNET_ERROR_TYPE_WARNING, "Unable to write to file!\n");
+    GNUNET_log (GNUNET_ERROR_TYPE_INFO, "%s", output_buffer);
+  }
+  GNUNET_free (latencies);
+}
+
+
 /**
  * Shutdown nicely
  *
@@ -445,6 +572,10 @@ do_shutdown (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
   if (NULL != data_file)
     GNUNET_DISK_file_close (data_file);
 
+  write_csv_summary ();
+  if (NULL != csv_file)
+    GNUNET_DISK_file_close (csv_file);
+
   for (search_str_cnt = 0;
        search_str_cnt < num_peers && NULL != search_strings;
        search_str_cnt++)
@@ -761,6 +892,7 @@ regex_found_handler (void *cls,
                 strings_found, num_peers, parallel_searches);
 
     peer->search_str_matched = GNUNET_YES;
+    peer->search_duration = prof_time;
 
     if (NULL != data_file)
     {
@@ -1391,6 +1523,20 @@ run (void *cls, char *const *args, const char *cfgfile,
                               data_filename);
     return;
   }
+  if ( (NULL != csv_filename) &&
+       (NULL == (csv_file =
+                 GNUNET_DISK_file_open (csv_filename,
+                                        GNUNET_DISK_OPEN_READWRITE |
+                                        GNUNET_DISK_OPEN_TRUNCATE |
+                                        GNUNET_DISK_OPEN_CREATE,
+                                        GNUNET_DISK_PERM_USER_READ |
+                                        GNUNET_DISK_PERM_USER_WRITE))) )
+  {
+    GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_ERROR,
+                              "open",
+                              csv_filename);
+    return;
+  }
 
   /* Initialize peers */
   peers = GNUNET_malloc (sizeof (struct RegexPeer) * num_peers);
@@ -1454,6 +1600,9 @@ main (int argc, char *const *argv)
     {'o', "output-file", "FILENAME",
      gettext_noop ("name of the file for writing statistics"),
      GNUNET_YES, &GNUNET_GETOPT_set_string, &data_filename},
+    {'c', "csv-file", "FILENAME",
+     gettext_noop ("name of the file for writing search latencies as CSV"),
+     GNUNET_YES, &GNUNET_GETOPT_set_string, &csv_filename},
     {'t', "matching-timeout", "TIMEOUT",
       gettext_noop ("wait TIMEOUT before ending the experiment"),
       GNUNET_YES, &GNUNET_GETOPT_set_relative_time, &search_timeout_time},
@@ -2004,11 +2004,15 @@ dfa_merge_nondistinguishable_states (struct REGEX_INTERNAL_Context *ctx,
   for (i = 0, s1 = a->states_head; NULL != s1; s1 = s1->next)
     s1->marked = i++;
 
-  /* Mark all pairs of accepting/!accepting states */
+  /* Mark all pairs of accepting/!accepting states, and all pairs
+     with a different number of outgoing transitions: those can
+     never be equal, and marking them here keeps them out of the
+     expensive pairwise transition comparison below */
   for (s1 = a->states_head; NULL != s1; s1 = s1->next)
     for (s2 = a->states_head; NULL != s2; s2 = s2->next)
       if ( (s1->accepting && !s2->accepting) ||
-	   (!s1->accepting && s2->accepting) )
+	   (!s1->accepting && s2->accepting) ||
+	   (s1->transition_count != s2->transition_count) )
       {
 	idx = s1->marked * state_cnt + s2->marked;
         table[idx / 32] |= (1 << (idx % 32));
@@ -2044,12 +2048,16 @@ dfa_merge_nondistinguishable_states (struct REGEX_INTERNAL_Context *ctx,
 	      {
 		table[idx / 32] |= (1 << (idx % 32));
 		change = 1; /* changed a marker, need to run again */
+		break; /* pair is marked, skip the remaining edges */
 	      }
 	    }
 	  }
+	  if (0 != (table[idx / 32] & (1 << (idx % 32))))
+	    break;
         }
-        if ( (num_equal_edges != s1->transition_count) ||
-	     (num_equal_edges != s2->transition_count) )
+        if ( (0 == (table[idx / 32] & (1 << (idx % 32)))) &&
+	     ( (num_equal_edges != s1->transition_count) ||
+	       (num_equal_edges != s2->transition_count) ) )
         {
           /* Make sure ALL edges of possible equal states are the same */
 	  table[idx / 32] |= (1 << (idx % 32));
@@ -79,6 +79,14 @@ struct REGEX_INTERNAL_Announcement
    * Optional statistics handle to report usage. Can be NULL.
    */
   struct GNUNET_STATISTICS_Handle *stats;
+
+  /**
+   * Map from state keys to the `struct GNUNET_TIME_Absolute` of the
+   * last DHT PUT for the respective blocks.  As the blocks only
+   * depend on the (fixed) regex, a re-announcement can skip all
+   * blocks whose DHT records are still fresh.
+   */
+  struct GNUNET_CONTAINER_MultiHashMap *last_put;
 };
 
 
@@ -102,9 +110,23 @@ regex_iterator (void *cls,
 {
   struct REGEX_INTERNAL_Announcement *h = cls;
   struct RegexBlock *block;
+  struct GNUNET_TIME_Absolute *put_time;
   size_t size;
   unsigned int i;
 
+  put_time = GNUNET_CONTAINER_multihashmap_get (h->last_put,
+                                                key);
+  if ( (NULL != put_time) &&
+       (GNUNET_TIME_absolute_get_duration (*put_time).rel_value_us <
+        DHT_TTL.rel_value_us / 2) )
+  {
+    /* Block is unchanged and its DHT record still has more than half
+       of its lifetime left, no need to re-PUT it yet. */
+    GNUNET_STATISTICS_update (h->stats,
+                              "# regex blocks not re-announced (fresh)",
+                              1, GNUNET_NO);
+    return;
+  }
   LOG (GNUNET_ERROR_TYPE_INFO,
        "DHT PUT for state %s with proof `%s' and %u edges:\n",
        GNUNET_h2s (key),
@@ -174,6 +196,16 @@ regex_iterator (void *cls,
                             "# regex block bytes stored",
                             size, GNUNET_NO);
   GNUNET_free (block);
+  if (NULL == put_time)
+  {
+    put_time = GNUNET_new (struct GNUNET_TIME_Absolute);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multihashmap_put (h->last_put,
+                                                      key,
+                                                      put_time,
+                                                      GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+  }
+  *put_time = GNUNET_TIME_absolute_get ();
 }
 
 
@@ -205,6 +237,7 @@ REGEX_INTERNAL_announce (struct GNUNET_DHT_Handle *dht,
   h->stats = stats;
   h->priv = priv;
   h->dfa = REGEX_INTERNAL_construct_dfa (regex, strlen (regex), compression);
+  h->last_put = GNUNET_CONTAINER_multihashmap_create (32, GNUNET_NO);
   REGEX_INTERNAL_reannounce (h);
   return h;
 }
@@ -229,6 +262,25 @@ REGEX_INTERNAL_reannounce (struct REGEX_INTERNAL_Announcement *h)
 }
 
 
+/**
+ * Iterator over hash map entries to free the cached PUT times.
+ *
+ * @param cls Closure (unused).
+ * @param key Current key code (unused).
+ * @param value `struct GNUNET_TIME_Absolute` in the hash map.
+ * @return #GNUNET_YES if we should continue to iterate,
+ *         #GNUNET_NO if not.
+ */
+static int
+regex_free_put_time (void *cls,
+                     const struct GNUNET_HashCode *key,
+                     void *value)
+{
+  GNUNET_free (value);
+  return GNUNET_YES;
+}
+
+
 /**
  * Clear all cached data used by a regex announce.
  * Does not close DHT connection.
@@ -239,6 +291,9 @@ void
 REGEX_INTERNAL_announce_cancel (struct REGEX_INTERNAL_Announcement *h)
 {
   REGEX_INTERNAL_automaton_destroy (h->dfa);
+  GNUNET_CONTAINER_multihashmap_iterate (h->last_put,
+                                         &regex_free_put_time, NULL);
+  GNUNET_CONTAINER_multihashmap_destroy (h->last_put);
   GNUNET_free (h);
 }
 
@@ -421,6 +421,222 @@ GNUNET_REST_jsonapi_data_serialize (const struct JsonApiObject *resp,
   return GNUNET_OK;
 }
 
+/**
+ * State for streaming out a JSON API object resource-by-resource
+ * as the connection can accept more data.
+ */
+struct JsonApiStream
+{
+  /**
+   * The object we are serializing; owned by the stream.
+   */
+  struct JsonApiObject *resp;
+
+  /**
+   * Next resource to serialize.
+   */
+  struct JsonApiResource *pos;
+
+  /**
+   * Serialization buffer, reused for each resource.
+   */
+  char *buf;
+
+  /**
+   * Allocated size of @e buf.
+   */
+  size_t buf_size;
+
+  /**
+   * Number of bytes used in @e buf.
+   */
+  size_t buf_len;
+
+  /**
+   * Number of bytes of @e buf already handed to MHD.
+   */
+  size_t buf_off;
+
+  /**
+   * #GNUNET_YES once the object prefix was emitted.
+   */
+  int started;
+
+  /**
+   * #GNUNET_YES once the object suffix was emitted.
+   */
+  int finished;
+};
+
+
+/**
+ * Append serialized data to the stream buffer, growing it as needed.
+ * The buffer is kept across resources so a listing only allocates
+ * up to the size of its largest resource.
+ *
+ * @param data bytes to append
+ * @param len number of bytes in @a data
+ * @param cls the `struct JsonApiStream`
+ * @return 0 (jansson dump callback convention for success)
+ */
+static int
+stream_append (const char *data,
+               size_t len,
+               void *cls)
+{
+  struct JsonApiStream *st = cls;
+  size_t need;
+
+  need = st->buf_len + len;
+  if (need > st->buf_size)
+  {
+    st->buf_size = GNUNET_MAX (need, 2 * st->buf_size);
+    st->buf = GNUNET_realloc (st->buf, st->buf_size);
+  }
+  memcpy (&st->buf[st->buf_len], data, len);
+  st->buf_len = need;
+  return 0;
+}
+
+
+/**
+ * Serialize the next piece of the object (prefix, one resource,
+ * or suffix) into the stream buffer.
+ *
+ * @param st the stream state
+ * @return #GNUNET_YES if the buffer was refilled,
+ *         #GNUNET_NO if the object is fully serialized
+ */
+static int
+stream_next_chunk (struct JsonApiStream *st)
+{
+  st->buf_len = 0;
+  st->buf_off = 0;
+  if (GNUNET_NO == st->started)
+  {
+    st->started = GNUNET_YES;
+    stream_append ("{\"" GNUNET_REST_JSONAPI_KEY_DATA "\":[",
+                   strlen ("{\"" GNUNET_REST_JSONAPI_KEY_DATA "\":["),
+                   st);
+    return GNUNET_YES;
+  }
+  if (NULL != st->pos)
+  {
+    if (st->resp->res_list_head != st->pos)
+      stream_append (",", 1, st);
+    if (0 != json_dump_callback (st->pos->res_obj,
+                                 &stream_append,
+                                 st,
+                                 JSON_INDENT(2)))
+      GNUNET_break (0);
+    st->pos = st->pos->next;
+    return GNUNET_YES;
+  }
+  if (GNUNET_NO == st->finished)
+  {
+    st->finished = GNUNET_YES;
+    stream_append ("]}", 2, st);
+    return GNUNET_YES;
+  }
+  return GNUNET_NO;
+}
+
+
+/**
+ * Content reader callback for MHD.  Called whenever the connection
+ * can accept more data, so slow clients throttle serialization
+ * instead of forcing us to buffer the full response.
+ *
+ * @param cls the `struct JsonApiStream`
+ * @param pos position in the datastream (ignored, we are sequential)
+ * @param buf where to copy the data
+ * @param max number of bytes available in @a buf
+ * @return number of bytes written to @a buf,
+ *         #MHD_CONTENT_READER_END_OF_STREAM when done
+ */
+static ssize_t
+stream_reader_cb (void *cls,
+                  uint64_t pos,
+                  char *buf,
+                  size_t max)
+{
+  struct JsonApiStream *st = cls;
+  size_t avail;
+  size_t total;
+
+  total = 0;
+  while (total < max)
+  {
+    if (st->buf_off == st->buf_len)
+    {
+      if (GNUNET_NO == stream_next_chunk (st))
+        break;
+    }
+    avail = st->buf_len - st->buf_off;
+    if (avail > max - total)
+      avail = max - total;
+    memcpy (&buf[total], &st->buf[st->buf_off], avail);
+    st->buf_off += avail;
+    total += avail;
+  }
+  if (0 == total)
+    return MHD_CONTENT_READER_END_OF_STREAM;
+  return total;
+}
+
+
+/**
+ * Free callback for MHD, called once the response is fully sent
+ * (or the connection died).
+ *
+ * @param cls the `struct JsonApiStream`
+ */
+static void
+stream_free_cb (void *cls)
+{
+  struct JsonApiStream *st = cls;
+
+  GNUNET_REST_jsonapi_object_delete (st->resp);
+  GNUNET_free_non_null (st->buf);
+  GNUNET_free (st);
+}
+
+
+/**
+ * Create JSON API MHD response that streams the object
+ * resource-by-resource instead of serializing it into one
+ * monolithic buffer.  Takes ownership of @a resp.
+ *
+ * @param resp the JSON API object to serialize
+ * @return MHD response, NULL on error (@a resp is deleted)
+ */
+struct MHD_Response*
+GNUNET_REST_create_jsonapi_response (struct JsonApiObject *resp)
+{
+  struct JsonApiStream *st;
+  struct MHD_Response *mhd_resp;
+
+  if (NULL == resp)
+    return NULL;
+  st = GNUNET_new (struct JsonApiStream);
+  st->resp = resp;
+  st->pos = resp->res_list_head;
+  st->started = GNUNET_NO;
+  st->finished = GNUNET_NO;
+  mhd_resp = MHD_create_response_from_callback (MHD_SIZE_UNKNOWN,
+                                                32 * 1024,
+                                                &stream_reader_cb,
+                                                st,
+                                                &stream_free_cb);
+  if (NULL == mhd_resp)
+  {
+    stream_free_cb (st);
+    return NULL;
+  }
+  MHD_add_response_header (mhd_resp,MHD_HTTP_HEADER_CONTENT_TYPE,"application/json");
+  return mhd_resp;
+}
+
 /**
  * REST Utilities
  */
@@ -470,27 +686,25 @@ GNUNET_REST_handle_request (struct RestConnectionDataHandle *conn,
                             const struct GNUNET_REST_RestConnectionHandler *handlers,
                             void *cls)
 {
-  int count;
-  int i;
+  const struct GNUNET_REST_RestConnectionHandler *h;
+  size_t url_len;
   char *url;
 
-  count = 0;
-  while (NULL != handlers[count].method)
-    count++;
-
-  GNUNET_asprintf (&url, "%s", conn->url);
-  if (url[strlen (url)-1] == '/')
-    url[strlen (url)-1] = '\0';
-  for (i = 0; i < count; i++)
+  url = GNUNET_strdup (conn->url);
+  url_len = strlen (url);
+  if ( (0 < url_len) &&
+       ('/' == url[url_len - 1]) )
+    url[--url_len] = '\0';
+  for (h = handlers; NULL != h->method; h++)
   {
-    if (0 != strcasecmp (conn->method, handlers[i].method))
+    if (0 != strcasecmp (conn->method, h->method))
       continue;
-    if (strlen (url) < strlen (handlers[i].namespace))
+    if (url_len < strlen (h->namespace))
       continue;
-    if (GNUNET_NO == GNUNET_REST_namespace_match (url, handlers[i].namespace))
+    if (GNUNET_NO == GNUNET_REST_namespace_match (url, h->namespace))
       continue;
     //Match
-    handlers[i].proc (conn, (const char*)url, cls);
+    h->proc (conn, (const char*)url, cls);
     GNUNET_free (url);
     return GNUNET_YES;
   }
@@ -227,6 +227,14 @@ perform_revocation (const struct RevocationData *rd)
 }
 
 
+/**
+ * Number of proof-of-work nonces we try per scheduler task.
+ * Balances the scheduler overhead per nonce against keeping the
+ * tool responsive to CTRL-C (for checkpointing on shutdown).
+ */
+#define POW_ROUND_SIZE 1024
+
+
 /**
  * Perform the proof-of-work calculation.
  *
@@ -238,66 +246,66 @@ calculate_pow (void *cls,
                const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
   struct RevocationData *rd = cls;
+  unsigned int i;
 
   /* store temporary results */
-  if ( (0 != (GNUNET_SCHEDULER_REASON_SHUTDOWN & tc->reason)) ||
-       (0 == (rd->pow % 128) ) )
-  {
-    if ( (NULL != filename) &&
-         (sizeof (struct RevocationData) ==
-          GNUNET_DISK_fn_write (filename,
-                                &rd,
-                                sizeof (rd),
-                                GNUNET_DISK_PERM_USER_READ |
-                                GNUNET_DISK_PERM_USER_WRITE)) )
-      GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_ERROR,
-                                "write",
-                                filename);
-  }
-  /* display progress estimate */
-  if ( (0 == ((1 << matching_bits) / 100 / 50)) ||
-       (0 == (rd->pow % ((1 << matching_bits) / 100 / 50))) )
-    FPRINTF (stderr, "%s", ".");
-  if ( (0 != rd->pow) &&
-       ( (0 == ((1 << matching_bits) / 100)) ||
-         (0 == (rd->pow % ((1 << matching_bits) / 100))) ) )
-    FPRINTF (stderr, " - @ %3u%% (estimate)\n",
-             (unsigned int) (rd->pow * 100) / (1 << matching_bits));
+  if ( (NULL != filename) &&
+       (sizeof (struct RevocationData) !=
+        GNUNET_DISK_fn_write (filename,
+                              rd,
+                              sizeof (struct RevocationData),
+                              GNUNET_DISK_PERM_USER_READ |
+                              GNUNET_DISK_PERM_USER_WRITE)) )
+    GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_ERROR,
+                              "write",
+                              filename);
   if (0 != (GNUNET_SCHEDULER_REASON_SHUTDOWN & tc->reason))
   {
     GNUNET_free (rd);
     return;
   }
-  /* actually do POW calculation */
-  rd->pow++;
-  if (GNUNET_OK ==
-      GNUNET_REVOCATION_check_pow (&rd->key,
-                                   rd->pow,
-                                   (unsigned int) matching_bits))
+  /* actually do POW calculation, one round per task */
+  for (i = 0; i < POW_ROUND_SIZE; i++)
   {
-    if ( (NULL != filename) &&
-         (sizeof (struct RevocationData) !=
-          GNUNET_DISK_fn_write (filename,
-                                rd,
-                                sizeof (struct RevocationData),
-                                GNUNET_DISK_PERM_USER_READ |
-                                GNUNET_DISK_PERM_USER_WRITE)) )
-      GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_ERROR,
-                                "write",
-                                filename);
-    if (perform)
-      perform_revocation (rd);
-    else
+    /* display progress estimate */
+    if ( (0 == ((1 << matching_bits) / 100 / 50)) ||
+         (0 == (rd->pow % ((1 << matching_bits) / 100 / 50))) )
+      FPRINTF (stderr, "%s", ".");
+    if ( (0 != rd->pow) &&
+         ( (0 == ((1 << matching_bits) / 100)) ||
+           (0 == (rd->pow % ((1 << matching_bits) / 100))) ) )
+      FPRINTF (stderr, " - @ %3u%% (estimate)\n",
+               (unsigned int) (rd->pow * 100) / (1 << matching_bits));
+    rd->pow++;
+    if (GNUNET_OK ==
+        GNUNET_REVOCATION_check_pow (&rd->key,
+                                     rd->pow,
+                                     (unsigned int) matching_bits))
     {
-      FPRINTF (stderr, "%s", "\n");
-      FPRINTF (stderr,
-               _("Revocation certificate for `%s' stored in `%s'\n"),
-               revoke_ego,
-               filename);
-      GNUNET_SCHEDULER_shutdown ();
+      if ( (NULL != filename) &&
+           (sizeof (struct RevocationData) !=
+            GNUNET_DISK_fn_write (filename,
+                                  rd,
+                                  sizeof (struct RevocationData),
+                                  GNUNET_DISK_PERM_USER_READ |
+                                  GNUNET_DISK_PERM_USER_WRITE)) )
+        GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_ERROR,
+                                  "write",
+                                  filename);
+      if (perform)
+        perform_revocation (rd);
+      else
+      {
+        FPRINTF (stderr, "%s", "\n");
+        FPRINTF (stderr,
+                 _("Revocation certificate for `%s' stored in `%s'\n"),
+                 revoke_ego,
+                 filename);
+        GNUNET_SCHEDULER_shutdown ();
+      }
+      GNUNET_free (rd);
+      return;
     }
-    GNUNET_free (rd);
-    return;
   }
   GNUNET_SCHEDULER_add_now (&calculate_pow,
                             rd);
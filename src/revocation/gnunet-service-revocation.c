@@ -129,6 +129,12 @@ static struct GNUNET_SERVER_NotificationContext *nc;
  */
 static struct GNUNET_DISK_FileHandle *revocation_db;
 
+/**
+ * Set to #GNUNET_YES if the revocation database has writes that
+ * have not been synced to disk yet.
+ */
+static int revocation_db_dirty;
+
 /**
  * Handle for us listening to incoming revocation set union requests.
  */
@@ -234,6 +240,30 @@ verify_revoke_message (const struct RevokeMessage *rm)
 }
 
 
+/**
+ * Sync the revocation database to disk if it has pending writes.
+ * Called once per client request and once per completed set union,
+ * so that bursts of revocations share a single sync.
+ *
+ * @return #GNUNET_OK on success, #GNUNET_NO if the sync failed
+ */
+static int
+sync_db (void)
+{
+  if (GNUNET_YES != revocation_db_dirty)
+    return GNUNET_OK;
+  if (GNUNET_OK !=
+      GNUNET_DISK_file_sync (revocation_db))
+  {
+    GNUNET_log_strerror (GNUNET_ERROR_TYPE_ERROR,
+                         "sync");
+    return GNUNET_NO;
+  }
+  revocation_db_dirty = GNUNET_NO;
+  return GNUNET_OK;
+}
+
+
 /**
  * Handle QUERY message from client.
  *
@@ -348,13 +378,7 @@ publicize_rm (const struct RevokeMessage *rm)
                          "write");
     return GNUNET_NO;
   }
-  if (GNUNET_OK !=
-      GNUNET_DISK_file_sync (revocation_db))
-  {
-    GNUNET_log_strerror (GNUNET_ERROR_TYPE_ERROR,
-                         "sync");
-    return GNUNET_NO;
-  }
+  revocation_db_dirty = GNUNET_YES;
   /* keep copy in memory */
   cp = (struct RevokeMessage *) GNUNET_copy_message (&rm->header);
   GNUNET_break (GNUNET_OK ==
@@ -414,6 +438,9 @@ handle_revoke_message (void *cls,
                                 GNUNET_SYSERR);
     return;
   }
+  if ( (GNUNET_OK == ret) &&
+       (GNUNET_OK != sync_db ()) )
+    ret = GNUNET_NO;
   rrm.header.size = htons (sizeof (struct RevocationResponseMessage));
   rrm.header.type = htons (GNUNET_MESSAGE_TYPE_REVOCATION_REVOKE_RESPONSE);
   rrm.is_valid = htonl ((GNUNET_OK == ret) ? GNUNET_NO : GNUNET_YES);
@@ -446,6 +473,7 @@ handle_p2p_revoke_message (void *cls,
 	      "Received REVOKE message from peer\n");
   rm = (const struct RevokeMessage *) message;
   GNUNET_break_op (GNUNET_SYSERR != publicize_rm (rm));
+  (void) sync_db ();
   return GNUNET_OK;
 }
 
@@ -483,9 +511,9 @@ add_revocation (void *cls,
       return;
     }
     rm = element->data;
-    (void) handle_p2p_revoke_message (NULL,
-                                      &peer_entry->id,
-                                      &rm->header);
+    /* sync to disk only once the whole union is done,
+       not once per element */
+    GNUNET_break_op (GNUNET_SYSERR != publicize_rm (rm));
     GNUNET_STATISTICS_update (stats,
                               gettext_noop ("# revocation messages received via set union"),
                               1, GNUNET_NO);
@@ -495,15 +523,18 @@ add_revocation (void *cls,
                 _("Error computing revocation set union with %s\n"),
                 GNUNET_i2s (&peer_entry->id));
     peer_entry->so = NULL;
+    (void) sync_db ();
     GNUNET_STATISTICS_update (stats,
                               gettext_noop ("# revocation set unions failed"),
                               1,
                               GNUNET_NO);
     break;
   case GNUNET_SET_STATUS_HALF_DONE:
+    (void) sync_db ();
     break;
   case GNUNET_SET_STATUS_DONE:
     peer_entry->so = NULL;
+    (void) sync_db ();
     GNUNET_STATISTICS_update (stats,
                               gettext_noop ("# revocation set unions completed"),
                               1,
@@ -28,6 +28,7 @@
 #include "gnunet_cadet_service.h"
 #include "gnunet_peerinfo_service.h"
 #include "gnunet_nse_service.h"
+#include "gnunet_statistics_service.h"
 #include "rps.h"
 #include "rps-test_util.h"
 
@@ -406,6 +407,11 @@ static struct GNUNET_CADET_Handle *cadet_handle;
  */
 static struct GNUNET_PEERINFO_Handle *peerinfo_handle;
 
+/**
+ * Handle for the statistics service.
+ */
+static struct GNUNET_STATISTICS_Handle *stats;
+
 /**
  * Handle for cancellation of iteration over peers.
  */
@@ -1013,11 +1019,21 @@ insert_in_view_scheduled (const struct PeerContext *peer_ctx)
   void
 insert_in_sampler (void *cls, const struct GNUNET_PeerIdentity *peer)
 {
+  struct GNUNET_TIME_Absolute update_start;
+
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Updating samplers with peer %s from insert_in_sampler()\n",
        GNUNET_i2s (peer));
+  update_start = GNUNET_TIME_absolute_get ();
   RPS_sampler_update (prot_sampler,   peer);
   RPS_sampler_update (client_sampler, peer);
+  GNUNET_STATISTICS_update (stats,
+                            "# sampler updates",
+                            1, GNUNET_NO);
+  GNUNET_STATISTICS_update (stats,
+                            "# time spent updating samplers (in us)",
+                            GNUNET_TIME_absolute_get_duration (update_start).rel_value_us,
+                            GNUNET_NO);
   if (0 < RPS_sampler_count_id (prot_sampler, peer))
   {
     if (GNUNET_NO == GNUNET_CONTAINER_multipeermap_contains (peer_map, peer))
@@ -2781,6 +2797,11 @@ shutdown_task (void *cls,
   GNUNET_NSE_disconnect (nse);
   RPS_sampler_destroy (prot_sampler);
   RPS_sampler_destroy (client_sampler);
+  if (NULL != stats)
+  {
+    GNUNET_STATISTICS_destroy (stats, GNUNET_NO);
+    stats = NULL;
+  }
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Size of the peermap: %u\n",
        GNUNET_CONTAINER_multipeermap_size (peer_map));
@@ -3118,6 +3139,8 @@ run (void *cls,
 
   peerinfo_handle = GNUNET_PEERINFO_connect (cfg);
 
+  stats = GNUNET_STATISTICS_create ("rps", cfg);
+
   /* Initialise sampler */
   struct GNUNET_TIME_Relative half_round_interval;
   struct GNUNET_TIME_Relative  max_round_interval;
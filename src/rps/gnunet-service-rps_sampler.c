@@ -144,9 +144,12 @@ struct RPS_Sampler
   //size_t size;
 
   /**
-   * All sampler elements in one array.
+   * All sampler elements in one contiguous array.
+   *
+   * Keeping the elements themselves (not pointers) together is
+   * friendlier to the cache, as every update walks all of them.
    */
-  struct RPS_SamplerElement **sampler_elements;
+  struct RPS_SamplerElement *sampler_elements;
 
   /**
    * Maximum time a round takes
@@ -328,7 +331,7 @@ sampler_resize (struct RPS_Sampler *sampler, unsigned int new_size)
       to_file (sampler->file_name,
                "-%" PRIu32 ": %s",
                i,
-               sampler->sampler_elements[i]->file_name);
+               sampler->sampler_elements[i].file_name);
     }
 
     GNUNET_array_grow (sampler->sampler_elements,
@@ -357,12 +360,12 @@ sampler_resize (struct RPS_Sampler *sampler, unsigned int new_size)
 
     for (i = old_size ; i < new_size ; i++)
     { /* Add new sampler elements */
-      sampler->sampler_elements[i] = RPS_sampler_elem_create ();
+      RPS_sampler_elem_reinit (&sampler->sampler_elements[i]);
 
       to_file (sampler->file_name,
                "+%" PRIu32 ": %s",
                i,
-               sampler->sampler_elements[i]->file_name);
+               sampler->sampler_elements[i].file_name);
     }
   }
   else
@@ -485,7 +488,7 @@ RPS_sampler_update (struct RPS_Sampler *sampler,
 
   for (i = 0 ; i < sampler->sampler_size ; i++)
   {
-    RPS_sampler_elem_next (sampler->sampler_elements[i],
+    RPS_sampler_elem_next (&sampler->sampler_elements[i],
                            id);
   }
 
@@ -509,14 +512,14 @@ RPS_sampler_reinitialise_by_value (struct RPS_Sampler *sampler,
 
   for ( i = 0 ; i < sampler->sampler_size ; i++ )
   {
-    if ( 0 == GNUNET_CRYPTO_cmp_peer_identity(id, &(sampler->sampler_elements[i]->peer_id)) )
+    if ( 0 == GNUNET_CRYPTO_cmp_peer_identity(id, &(sampler->sampler_elements[i].peer_id)) )
     {
       LOG (GNUNET_ERROR_TYPE_DEBUG, "Reinitialising sampler\n");
       trash_entry = GNUNET_new (struct RPS_SamplerElement);
-      *trash_entry = *(sampler->sampler_elements[i]);
+      *trash_entry = sampler->sampler_elements[i];
       to_file (trash_entry->file_name,
                "--- non-active");
-      RPS_sampler_elem_reinit (sampler->sampler_elements[i]);
+      RPS_sampler_elem_reinit (&sampler->sampler_elements[i]);
     }
   }
 }
@@ -549,7 +552,7 @@ sampler_get_rand_peer (void *cls,
   r_index = GNUNET_CRYPTO_random_u64 (GNUNET_CRYPTO_QUALITY_STRONG,
       sampler->sampler_size);
 
-  if (EMPTY == sampler->sampler_elements[r_index]->is_empty)
+  if (EMPTY == sampler->sampler_elements[r_index].is_empty)
   {
     //LOG (GNUNET_ERROR_TYPE_DEBUG,
     //     "Not returning randomly selected, empty PeerID. - Rescheduling.\n");
@@ -569,7 +572,7 @@ sampler_get_rand_peer (void *cls,
   GNUNET_CONTAINER_DLL_remove (gpc->req_handle->gpc_head,
                                gpc->req_handle->gpc_tail,
                                gpc);
-  *gpc->id = sampler->sampler_elements[r_index]->peer_id;
+  *gpc->id = sampler->sampler_elements[r_index].peer_id;
   gpc->cont (gpc->cont_cls, gpc->id);
 
   GNUNET_free (gpc);
@@ -601,7 +604,7 @@ sampler_mod_get_rand_peer (void *cls,
   /* Cycle the #client_get_index one step further */
   client_get_index = (client_get_index + 1) % sampler->sampler_size;
 
-  s_elem = sampler->sampler_elements[client_get_index];
+  s_elem = &sampler->sampler_elements[client_get_index];
   *gpc->id = s_elem->peer_id;
   GNUNET_assert (NULL != s_elem);
 
@@ -757,8 +760,8 @@ RPS_sampler_count_id (struct RPS_Sampler *sampler,
   count = 0;
   for ( i = 0 ; i < sampler->sampler_size ; i++ )
   {
-    if ( 0 == GNUNET_CRYPTO_cmp_peer_identity (&sampler->sampler_elements[i]->peer_id, id)
-        && EMPTY != sampler->sampler_elements[i]->is_empty)
+    if ( 0 == GNUNET_CRYPTO_cmp_peer_identity (&sampler->sampler_elements[i].peer_id, id)
+        && EMPTY != sampler->sampler_elements[i].is_empty)
       count++;
   }
   return count;
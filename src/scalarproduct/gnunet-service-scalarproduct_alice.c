@@ -122,6 +122,13 @@ struct AliceServiceSession
    */
   struct MpiElement *sorted_elements;
 
+  /**
+   * Task that incrementally encrypts our elements and queues
+   * them for transmission to Bob, NULL if encryption is not
+   * (or no longer) in progress.
+   */
+  struct GNUNET_SCHEDULER_Task *cryptodata_task;
+
   /**
    * Bob's permutation p of R
    */
@@ -160,6 +167,12 @@ struct AliceServiceSession
    */
   uint32_t used_element_count;
 
+  /**
+   * How many of our elements have already been encrypted
+   * and queued for transmission to Bob.
+   */
+  uint32_t cryptodata_offset;
+
   /**
    * Already transferred elements from client to us.
    * Less or equal than @e total.
@@ -278,6 +291,11 @@ destroy_service_session (struct AliceServiceSession *s)
     GNUNET_CONTAINER_multihashmap_destroy (s->intersected_elements);
     s->intersected_elements = NULL;
   }
+  if (NULL != s->cryptodata_task)
+  {
+    GNUNET_SCHEDULER_cancel (s->cryptodata_task);
+    s->cryptodata_task = NULL;
+  }
   if (NULL != s->intersection_listen)
   {
     GNUNET_SET_listen_cancel (s->intersection_listen);
@@ -865,14 +883,19 @@ element_cmp (const void *a,
 
 
 /**
- * Send the cryptographic data from Alice to Bob.
- * Does nothing if we already transferred all elements.
+ * Encrypt the next chunk of our elements and queue it for
+ * transmission to Bob.  Reschedules itself until all elements
+ * have been queued, so that encrypting a large vector does not
+ * block the service's main loop for other sessions.
  *
- * @param s the associated service session
+ * @param cls the `struct AliceServiceSession *`
+ * @param tc scheduler context
  */
 static void
-send_alices_cryptodata_message (struct AliceServiceSession *s)
+send_alices_cryptodata_task (void *cls,
+                             const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
+  struct AliceServiceSession *s = cls;
   struct AliceCryptodataMessage *msg;
   struct GNUNET_MQ_Envelope *e;
   struct GNUNET_CRYPTO_PaillierCiphertext *payload;
@@ -881,6 +904,53 @@ send_alices_cryptodata_message (struct AliceServiceSession *s)
   gcry_mpi_t a;
   uint32_t off;
 
+  s->cryptodata_task = NULL;
+  off = s->cryptodata_offset;
+  todo_count = s->used_element_count - off;
+  if (todo_count > ELEMENT_CAPACITY)
+    todo_count = ELEMENT_CAPACITY;
+  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+              "Sending %u/%u crypto values to Bob\n",
+              (unsigned int) todo_count,
+              (unsigned int) s->used_element_count);
+
+  e = GNUNET_MQ_msg_extra (msg,
+                           todo_count * sizeof (struct GNUNET_CRYPTO_PaillierCiphertext),
+                           GNUNET_MESSAGE_TYPE_SCALARPRODUCT_ALICE_CRYPTODATA);
+  msg->contained_element_count = htonl (todo_count);
+  payload = (struct GNUNET_CRYPTO_PaillierCiphertext *) &msg[1];
+  a = gcry_mpi_new (0);
+  for (i = off; i < off + todo_count; i++)
+  {
+    gcry_mpi_add (a,
+                  s->sorted_elements[i].value,
+                  my_offset);
+    GNUNET_assert (3 ==
+                   GNUNET_CRYPTO_paillier_encrypt (&my_pubkey,
+                                                   a,
+                                                   3,
+                                                   &payload[i - off]));
+  }
+  gcry_mpi_release (a);
+  s->cryptodata_offset = off + todo_count;
+  GNUNET_MQ_send (s->cadet_mq,
+                  e);
+  if (s->cryptodata_offset < s->used_element_count)
+    s->cryptodata_task
+      = GNUNET_SCHEDULER_add_now (&send_alices_cryptodata_task,
+                                  s);
+}
+
+
+/**
+ * Send the cryptographic data from Alice to Bob.
+ * Does nothing if we already transferred all elements.
+ *
+ * @param s the associated service session
+ */
+static void
+send_alices_cryptodata_message (struct AliceServiceSession *s)
+{
   s->sorted_elements
     = GNUNET_malloc (GNUNET_CONTAINER_multihashmap_size (s->intersected_elements) *
                      sizeof (struct MpiElement));
@@ -895,39 +965,12 @@ send_alices_cryptodata_message (struct AliceServiceSession *s)
          s->used_element_count,
          sizeof (struct MpiElement),
          &element_cmp);
-  off = 0;
-  while (off < s->used_element_count)
-  {
-    todo_count = s->used_element_count - off;
-    if (todo_count > ELEMENT_CAPACITY)
-      todo_count = ELEMENT_CAPACITY;
-    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-                "Sending %u/%u crypto values to Bob\n",
-                (unsigned int) todo_count,
-                (unsigned int) s->used_element_count);
-
-    e = GNUNET_MQ_msg_extra (msg,
-                             todo_count * sizeof (struct GNUNET_CRYPTO_PaillierCiphertext),
-                             GNUNET_MESSAGE_TYPE_SCALARPRODUCT_ALICE_CRYPTODATA);
-    msg->contained_element_count = htonl (todo_count);
-    payload = (struct GNUNET_CRYPTO_PaillierCiphertext *) &msg[1];
-    a = gcry_mpi_new (0);
-    for (i = off; i < off + todo_count; i++)
-    {
-      gcry_mpi_add (a,
-                    s->sorted_elements[i].value,
-                    my_offset);
-      GNUNET_assert (3 ==
-                     GNUNET_CRYPTO_paillier_encrypt (&my_pubkey,
-                                                     a,
-                                                     3,
-                                                     &payload[i - off]));
-    }
-    gcry_mpi_release (a);
-    off += todo_count;
-    GNUNET_MQ_send (s->cadet_mq,
-                    e);
-  }
+  s->cryptodata_offset = 0;
+  if (0 == s->used_element_count)
+    return;
+  s->cryptodata_task
+    = GNUNET_SCHEDULER_add_now (&send_alices_cryptodata_task,
+                                s);
 }
 
 
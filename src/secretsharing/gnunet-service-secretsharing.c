@@ -1098,8 +1098,9 @@ verify_fair (const struct GNUNET_CRYPTO_PaillierPublicKey *ppub, const struct GN
   gcry_mpi_powm (big_y, big_y, e, n_sq);
   gcry_mpi_invm (big_y, big_y, n_sq);
 
-  gcry_mpi_add_ui (tmp1, n, 1);
-  gcry_mpi_powm (tmp1, tmp1, z, n_sq);
+  /* (n+1)^z = 1 + z*n (mod n^2) by the binomial theorem */
+  gcry_mpi_mulm (tmp1, z, n, n_sq);
+  gcry_mpi_add_ui (tmp1, tmp1, 1);
 
   gcry_mpi_powm (tmp2, w, n, n_sq);
 
@@ -1153,7 +1154,6 @@ encrypt_fair (gcry_mpi_t v, const struct GNUNET_CRYPTO_PaillierPublicKey *ppub,
   gcry_mpi_t n_sq;
   gcry_mpi_t u;
   gcry_mpi_t Y;
-  gcry_mpi_t G;
   gcry_mpi_t h;
   GNUNET_assert (NULL != (r = gcry_mpi_new (0)));
   GNUNET_assert (NULL != (s = gcry_mpi_new (0)));
@@ -1165,19 +1165,20 @@ encrypt_fair (gcry_mpi_t v, const struct GNUNET_CRYPTO_PaillierPublicKey *ppub,
   GNUNET_assert (NULL != (e = gcry_mpi_new (0)));
   GNUNET_assert (NULL != (u = gcry_mpi_new (0)));
   GNUNET_assert (NULL != (Y = gcry_mpi_new (0)));
-  GNUNET_assert (NULL != (G = gcry_mpi_new (0)));
   GNUNET_assert (NULL != (h = gcry_mpi_new (0)));
 
   GNUNET_CRYPTO_mpi_scan_unsigned (&n, ppub, sizeof (struct GNUNET_CRYPTO_PaillierPublicKey));
   gcry_mpi_mul (n_sq, n, n);
-  gcry_mpi_add_ui (G, n, 1);
 
   do {
     gcry_mpi_randomize (u, GNUNET_CRYPTO_PAILLIER_BITS, GCRY_WEAK_RANDOM);
   }
   while (gcry_mpi_cmp (u, n) >= 0);
 
-  gcry_mpi_powm (t1, G, v, n_sq);
+  /* t1 = G^v mod n^2 for the fixed generator G = n + 1; by the
+     binomial theorem this is 1 + v*n (mod n^2), no powm needed */
+  gcry_mpi_mulm (t1, v, n, n_sq);
+  gcry_mpi_add_ui (t1, t1, 1);
   gcry_mpi_powm (t2, u, n, n_sq);
   gcry_mpi_mulm (Y, t1, t2, n_sq);
 
@@ -1194,8 +1195,9 @@ encrypt_fair (gcry_mpi_t v, const struct GNUNET_CRYPTO_PaillierPublicKey *ppub,
 
   // compute t1
   gcry_mpi_mulm (t1, elgamal_g, r, elgamal_p);
-  // compute t2 (use z and w as temp)
-  gcry_mpi_powm (z, G, r, n_sq);
+  // compute t2 (use z and w as temp); G^r = 1 + r*n (mod n^2)
+  gcry_mpi_mulm (z, r, n, n_sq);
+  gcry_mpi_add_ui (z, z, 1);
   gcry_mpi_powm (w, s, n, n_sq);
   gcry_mpi_mulm (t2, z, w, n_sq);
 
@@ -1243,7 +1245,6 @@ encrypt_fair (gcry_mpi_t v, const struct GNUNET_CRYPTO_PaillierPublicKey *ppub,
   gcry_mpi_release (n_sq);
   gcry_mpi_release (u);
   gcry_mpi_release (Y);
-  gcry_mpi_release (G);
   gcry_mpi_release (h);
 }
 
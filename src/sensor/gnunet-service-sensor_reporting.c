@@ -156,6 +156,37 @@ struct ValueInfo
    */
   int last_value_reported;
 
+  /**
+   * Number of readings aggregated in the current reporting window
+   * (numeric sensors only)
+   */
+  uint32_t agg_count;
+
+  /**
+   * Sum of all readings in the current reporting window
+   */
+  double agg_sum;
+
+  /**
+   * Smallest reading in the current reporting window
+   */
+  double agg_min;
+
+  /**
+   * Largest reading in the current reporting window
+   */
+  double agg_max;
+
+  /**
+   * Copy of the value sent with the previous report (or NULL)
+   */
+  void *reported_value;
+
+  /**
+   * Size of @e reported_value
+   */
+  size_t reported_value_size;
+
   /**
    * Watcher of sensor values
    */
@@ -410,6 +441,11 @@ destroy_value_info (struct ValueInfo *vi)
     GNUNET_free (vi->last_value);
     vi->last_value = NULL;
   }
+  if (NULL != vi->reported_value)
+  {
+    GNUNET_free (vi->reported_value);
+    vi->reported_value = NULL;
+  }
   GNUNET_free (vi);
 }
 
@@ -927,6 +963,35 @@ create_value_message (struct ValueInfo *vi)
 }
 
 
+/**
+ * Create a summary message covering all readings aggregated within the
+ * current reporting window of the given value info struct inside a MQ
+ * envelope.
+ *
+ * @param vi Value info struct to use
+ * @return Envelope with message
+ */
+static struct GNUNET_MQ_Envelope *
+create_summary_message (struct ValueInfo *vi)
+{
+  struct GNUNET_SENSOR_SummaryMessage *sm;
+  struct GNUNET_MQ_Envelope *ev;
+
+  ev = GNUNET_MQ_msg (sm, GNUNET_MESSAGE_TYPE_SENSOR_READING_SUMMARY);
+  GNUNET_CRYPTO_hash (vi->sensor->name, strlen (vi->sensor->name) + 1,
+                      &sm->sensorname_hash);
+  sm->sensorversion_major = htons (vi->sensor->version_major);
+  sm->sensorversion_minor = htons (vi->sensor->version_minor);
+  sm->count = htonl (vi->agg_count);
+  sm->end_time = vi->last_value_timestamp;
+  sm->min = GNUNET_hton_double (vi->agg_min);
+  sm->max = GNUNET_hton_double (vi->agg_max);
+  sm->avg = GNUNET_hton_double (vi->agg_sum / vi->agg_count);
+  sm->last = GNUNET_hton_double (*(double *) vi->last_value);
+  return ev;
+}
+
+
 /******************************************************************************/
 /***************************      CORE Handlers     ***************************/
 /******************************************************************************/
@@ -1040,6 +1105,7 @@ value_watch_cb (void *cls,
                 const char *emsg)
 {
   struct ValueInfo *vi = cls;
+  double val;
 
   if (NULL != emsg)
   {
@@ -1055,6 +1121,18 @@ value_watch_cb (void *cls,
   vi->last_value_size = record->value_size;
   vi->last_value_timestamp = GNUNET_TIME_absolute_get ();
   vi->last_value_reported = GNUNET_NO;
+  /* Aggregate numeric readings within the current reporting window */
+  if (0 == strcmp ("numeric", vi->sensor->expected_datatype) &&
+      sizeof (double) == record->value_size)
+  {
+    val = *(double *) record->value;
+    if (0 == vi->agg_count || val < vi->agg_min)
+      vi->agg_min = val;
+    if (0 == vi->agg_count || val > vi->agg_max)
+      vi->agg_max = val;
+    vi->agg_sum += val;
+    vi->agg_count++;
+  }
   return GNUNET_YES;
 }
 
@@ -1286,9 +1364,39 @@ report_value (void *cls, const struct GNUNET_SCHEDULER_TaskContext *tc)
          "Trying to send value to collection point but connection failed, discarding.\n");
     return;
   }
-  ev = create_value_message (vi);
+  if (1 < vi->agg_count)
+  {
+    /* Multiple readings within this window, send one summary instead of
+     * only the last raw value */
+    LOG (GNUNET_ERROR_TYPE_DEBUG,
+         "Reporting a summary of %u readings of `%s' to collection point.\n",
+         (unsigned int) vi->agg_count, sensor->name);
+    ev = create_summary_message (vi);
+  }
+  else
+  {
+    if ((vi->last_value_size == vi->reported_value_size) &&
+        (0 == memcmp (vi->last_value, vi->reported_value,
+                      vi->last_value_size)))
+    {
+      LOG (GNUNET_ERROR_TYPE_DEBUG,
+           "Value of `%s' unchanged since last report, skipping.\n",
+           sensor->name);
+      vi->last_value_reported = GNUNET_YES;
+      vi->agg_count = 0;
+      vi->agg_sum = 0;
+      return;
+    }
+    ev = create_value_message (vi);
+  }
   GNUNET_MQ_send (cadetp->mq, ev);
   vi->last_value_reported = GNUNET_YES;
+  if (NULL != vi->reported_value)
+    GNUNET_free (vi->reported_value);
+  vi->reported_value = GNUNET_memdup (vi->last_value, vi->last_value_size);
+  vi->reported_value_size = vi->last_value_size;
+  vi->agg_count = 0;
+  vi->agg_sum = 0;
 }
 
 
@@ -32,6 +32,12 @@
 #include "gnunet_sensor_util_lib.h"
 #include "gnunet_peerstore_service.h"
 
+/**
+ * How long to keep received sensor values in PEERSTORE if not configured
+ * otherwise
+ */
+#define DEFAULT_VALUES_EXPIRY GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_WEEKS, 1)
+
 
 /**
  * Context of a connected client peer
@@ -180,6 +186,11 @@ static struct ClientPeerContext *cp_tail;
  */
 static long long unsigned int pow_matching_bits;
 
+/**
+ * How long to keep received sensor values in PEERSTORE
+ */
+static struct GNUNET_TIME_Relative values_expiry;
+
 
 /**
  * Trigger sending next pending message to the given client peer if any.
@@ -639,7 +650,8 @@ handle_sensor_reading (void *cls, struct GNUNET_CADET_Channel *channel,
               reading->sensor->name, reading->timestamp, reading->value_size);
   GNUNET_PEERSTORE_store (peerstore, values_subsystem, &cp->peerid,
                           reading->sensor->name, reading->value,
-                          reading->value_size, GNUNET_TIME_UNIT_FOREVER_ABS,
+                          reading->value_size,
+                          GNUNET_TIME_relative_to_absolute (values_expiry),
                           GNUNET_PEERSTORE_STOREOPTION_MULTIPLE, NULL, NULL);
   GNUNET_free (reading->value);
   GNUNET_free (reading);
@@ -648,6 +660,60 @@ handle_sensor_reading (void *cls, struct GNUNET_CADET_Channel *channel,
 }
 
 
+/**
+ * Called with any sensor reading summary messages received from CADET.
+ *
+ * Each time the function must call #GNUNET_CADET_receive_done on the channel
+ * in order to receive the next message. This doesn't need to be immediate:
+ * can be delayed if some processing is done on the message.
+ *
+ * @param cls Closure (set from #GNUNET_CADET_connect).
+ * @param channel Connection to the other end.
+ * @param channel_ctx Place to store local state associated with the channel.
+ * @param message The actual message.
+ * @return #GNUNET_OK to keep the channel open,
+ *         #GNUNET_SYSERR to close it (signal serious error).
+ */
+static int
+handle_sensor_reading_summary (void *cls, struct GNUNET_CADET_Channel *channel,
+                               void **channel_ctx,
+                               const struct GNUNET_MessageHeader *message)
+{
+  struct ClientPeerContext *cp = *channel_ctx;
+  struct GNUNET_SENSOR_SummaryMessage *sm;
+  struct GNUNET_SENSOR_SensorInfo *sensor;
+  double avg;
+
+  sm = (struct GNUNET_SENSOR_SummaryMessage *) message;
+  sensor = GNUNET_CONTAINER_multihashmap_get (sensors, &sm->sensorname_hash);
+  if (NULL == sensor ||
+      sensor->version_major != ntohs (sm->sensorversion_major) ||
+      sensor->version_minor != ntohs (sm->sensorversion_minor) ||
+      0 != strcmp (sensor->expected_datatype, "numeric"))
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
+                "Received an invalid sensor reading summary from peer `%s'.\n",
+                GNUNET_i2s (&cp->peerid));
+    return GNUNET_SYSERR;
+  }
+  avg = GNUNET_ntoh_double (sm->avg);
+  GNUNET_log (GNUNET_ERROR_TYPE_INFO,
+              "Received a sensor reading summary from peer `%s':\n"
+              "# Sensor name: `%s'\n" "# Readings: %u\n"
+              "# Min: %f\n" "# Max: %f\n" "# Avg: %f.\n",
+              GNUNET_i2s (&cp->peerid), sensor->name,
+              (unsigned int) ntohl (sm->count),
+              GNUNET_ntoh_double (sm->min), GNUNET_ntoh_double (sm->max),
+              avg);
+  GNUNET_PEERSTORE_store (peerstore, values_subsystem, &cp->peerid,
+                          sensor->name, &avg, sizeof (double),
+                          GNUNET_TIME_relative_to_absolute (values_expiry),
+                          GNUNET_PEERSTORE_STOREOPTION_MULTIPLE, NULL, NULL);
+  GNUNET_CADET_receive_done (channel);
+  return GNUNET_OK;
+}
+
+
 /**
  * Create a message with full information about sensor
  *
@@ -809,6 +875,9 @@ run (void *cls, struct GNUNET_SERVER_Handle *server,
   static struct GNUNET_CADET_MessageHandler cadet_handlers[] = {
     {&handle_sensor_reading,
      GNUNET_MESSAGE_TYPE_SENSOR_READING, 0},
+    {&handle_sensor_reading_summary,
+     GNUNET_MESSAGE_TYPE_SENSOR_READING_SUMMARY,
+     sizeof (struct GNUNET_SENSOR_SummaryMessage)},
     {&handle_sensor_list_req,
      GNUNET_MESSAGE_TYPE_SENSOR_LIST_REQ,
      sizeof (struct GNUNET_MessageHeader)},
@@ -853,6 +922,10 @@ run (void *cls, struct GNUNET_SERVER_Handle *server,
     GNUNET_SCHEDULER_add_now (&cleanup_task, NULL);
     return;
   }
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_time (cfg, "sensordashboard",
+                                           "VALUES_EXPIRY", &values_expiry))
+    values_expiry = DEFAULT_VALUES_EXPIRY;
 
   cadet =
       GNUNET_CADET_connect (cfg, NULL, &cadet_channel_created,
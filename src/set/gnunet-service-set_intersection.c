@@ -25,12 +25,24 @@
  */
 #include "platform.h"
 #include "gnunet_util_lib.h"
+#include "gnunet_statistics_service.h"
 #include "gnunet-service-set.h"
 #include "gnunet_block_lib.h"
 #include "gnunet-service-set_protocol.h"
 #include <gcrypt.h>
 
 
+/**
+ * Maximum number of bits per element we will use in a Bloom
+ * filter.  Caps the per-round cost for extremely imbalanced
+ * sets (i.e. intersecting a million elements against a
+ * thousand); past this point, additional bits reduce the
+ * false-positive rate less than another (much smaller)
+ * round would.
+ */
+#define MAX_BF_BITS_PER_ELEMENT 16
+
+
 /**
  * Current phase we are in for a intersection operation.
  */
@@ -264,6 +276,10 @@ filtered_map_initialization (void *cls,
     /* remove this element */
     send_client_removed_element (op,
                                  &ee->element);
+    GNUNET_STATISTICS_update (_GSS_statistics,
+                              "# intersection elements removed",
+                              1,
+                              GNUNET_NO);
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                 "Reduced initialization, not starting with %s:%u\n",
                 GNUNET_h2s (&ee->element_hash),
@@ -332,6 +348,10 @@ iterator_bf_reduce (void *cls,
                                                          ee));
     send_client_removed_element (op,
                                  &ee->element);
+    GNUNET_STATISTICS_update (_GSS_statistics,
+                              "# intersection elements removed",
+                              1,
+                              GNUNET_NO);
   }
   else
   {
@@ -417,7 +437,7 @@ send_bloomfilter (struct Operation *op)
   struct GNUNET_MQ_Envelope *ev;
   struct BFMessage *msg;
   uint32_t bf_size;
-  uint32_t bf_elementbits;
+  int bf_elementbits;
   uint32_t chunk_size;
   char *bf_data;
   uint32_t offset;
@@ -426,11 +446,13 @@ send_bloomfilter (struct Operation *op)
      the number of bits per element, as the smaller set
      should use more bits to maximize its set reduction
      potential and minimize overall bandwidth consumption. */
-  bf_elementbits = 2 + ceil (log2((double)
-                             (op->spec->remote_element_count /
-                                   (double) op->state->my_element_count)));
+  bf_elementbits = 2 + ceil (log2((double) op->spec->remote_element_count /
+                                  (double) op->state->my_element_count));
   if (bf_elementbits < 1)
-    bf_elementbits = 1; /* make sure k is not 0 */
+    bf_elementbits = 1; /* make sure k is not 0; the ratio is below 1
+                           whenever our set is the larger one */
+  if (bf_elementbits > MAX_BF_BITS_PER_ELEMENT)
+    bf_elementbits = MAX_BF_BITS_PER_ELEMENT;
   /* optimize BF-size to ~50% of bits set */
   bf_size = ceil ((double) (op->state->my_element_count
                             * bf_elementbits / log(2)));
@@ -446,6 +468,14 @@ send_bloomfilter (struct Operation *op)
   GNUNET_CONTAINER_multihashmap_iterate (op->state->my_elements,
                                          &iterator_bf_create,
                                          op);
+  GNUNET_STATISTICS_update (_GSS_statistics,
+                            "# intersection Bloom filter rounds",
+                            1,
+                            GNUNET_NO);
+  GNUNET_STATISTICS_update (_GSS_statistics,
+                            "# bytes of Bloom filters sent",
+                            bf_size,
+                            GNUNET_NO);
 
   /* send our Bloom filter */
   chunk_size = 60 * 1024 - sizeof (struct BFMessage);
@@ -1025,6 +1055,10 @@ intersection_evaluate (struct Operation *op,
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Initiating intersection operation evaluation\n");
+  GNUNET_STATISTICS_update (_GSS_statistics,
+                            "# of initiated intersection operations",
+                            1,
+                            GNUNET_NO);
   ev = GNUNET_MQ_msg_nested_mh (msg,
                                 GNUNET_MESSAGE_TYPE_SET_P2P_OPERATION_REQUEST,
                                 opaque_context);
@@ -1061,6 +1095,10 @@ intersection_accept (struct Operation *op)
 {
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Accepting set intersection operation\n");
+  GNUNET_STATISTICS_update (_GSS_statistics,
+                            "# of accepted intersection operations",
+                            1,
+                            GNUNET_NO);
   op->state = GNUNET_new (struct OperationState);
   op->state->phase = PHASE_INITIAL;
   op->state->my_element_count
@@ -55,6 +55,17 @@
  */
 #define MAX_BUCKETS_PER_MESSAGE ((1<<15) / IBF_BUCKET_SIZE)
 
+/**
+ * Maximum number of hashes in a single OFFER or DEMAND message,
+ * keeps messages below the same bound as IBF slices.
+ */
+#define MAX_HASHES_PER_MESSAGE ((1<<15) / sizeof (struct GNUNET_HashCode))
+
+/**
+ * Maximum number of IBF keys in a single INQUIRY message.
+ */
+#define MAX_KEYS_PER_MESSAGE ((1<<15) / sizeof (struct IBF_Key))
+
 /**
  * The maximum size of an ibf we use is 2^(MAX_IBF_ORDER).
  * Choose this value so that computing the IBF is still cheaper
@@ -212,6 +223,17 @@ struct SendElementClosure
    * should be sent.
    */
   struct Operation *op;
+
+  /**
+   * Hashes of the matching elements, appended to
+   * by the iterator and sent in batches.
+   */
+  struct GNUNET_HashCode *hashes;
+
+  /**
+   * Number of hashes in @e hashes.
+   */
+  unsigned int num_hashes;
 };
 
 
@@ -438,6 +460,11 @@ op_register_element (struct Operation *op,
                                                       (uint32_t) ibf_key.key_val,
                                                       k,
                                                       GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE));
+  /* also insert into an already prepared local IBF, so that
+   * prepare_ibf() can keep re-using it after remote elements
+   * have been registered */
+  if (NULL != op->state->local_ibf)
+    ibf_insert (op->state->local_ibf, ibf_key);
 }
 
 
@@ -518,7 +545,17 @@ prepare_ibf (struct Operation *op,
                                            init_key_to_element_iterator, op);
   }
   if (NULL != op->state->local_ibf)
+  {
+    if (size == op->state->local_ibf->size)
+    {
+      /* key_to_element is fixed for the lifetime of the operation,
+       * so an already prepared IBF of the right size is still
+       * valid; re-use it instead of re-inserting every element */
+      op->state->local_ibf->scan_pos = 0;
+      return GNUNET_OK;
+    }
     ibf_destroy (op->state->local_ibf);
+  }
   op->state->local_ibf = ibf_create (size, SE_IBF_HASH_NUM);
   if (NULL == op->state->local_ibf)
   {
@@ -753,46 +790,125 @@ send_offers_iterator (void *cls,
   struct SendElementClosure *sec = cls;
   struct Operation *op = sec->op;
   struct KeyEntry *ke = value;
-  struct GNUNET_MQ_Envelope *ev;
-  struct GNUNET_MessageHeader *mh;
 
   /* Detect 32-bit key collision for the 64-bit IBF keys. */
   if (ke->ibf_key.key_val != sec->ibf_key.key_val)
     return GNUNET_YES;
 
-  ev = GNUNET_MQ_msg_header_extra (mh,
-                                   sizeof (struct GNUNET_HashCode),
-                                   GNUNET_MESSAGE_TYPE_SET_UNION_P2P_OFFER);
-
-  GNUNET_assert (NULL != ev);
-  *(struct GNUNET_HashCode *) &mh[1] = ke->element->element_hash;
   LOG (GNUNET_ERROR_TYPE_DEBUG,
-       "[OP %x] sending element offer (%s) to peer\n",
+       "[OP %x] offering element (%s) to peer\n",
        (void *) op,
        GNUNET_h2s (&ke->element->element_hash));
-  GNUNET_MQ_send (op->mq, ev);
+  GNUNET_array_append (sec->hashes,
+                       sec->num_hashes,
+                       ke->element->element_hash);
   return GNUNET_YES;
 }
 
 
 /**
- * Send offers (in the form of GNUNET_Hash-es) to the remote peer for the given IBF key.
+ * Collect offers (in the form of GNUNET_Hash-es) for the remote
+ * peer for the given IBF key.  The hashes are appended to the
+ * given array; the caller transmits them in batches with
+ * #send_hashes().
  *
  * @param op union operation
  * @param ibf_key IBF key of interest
+ * @param[in,out] hashes array to append the offered hashes to
+ * @param[in,out] num_hashes number of hashes in @a hashes
  */
 static void
 send_offers_for_key (struct Operation *op,
-                     struct IBF_Key ibf_key)
+                     struct IBF_Key ibf_key,
+                     struct GNUNET_HashCode **hashes,
+                     unsigned int *num_hashes)
 {
   struct SendElementClosure send_cls;
 
   send_cls.ibf_key = ibf_key;
   send_cls.op = op;
+  send_cls.hashes = *hashes;
+  send_cls.num_hashes = *num_hashes;
   (void) GNUNET_CONTAINER_multihashmap32_get_multiple (op->state->key_to_element,
                                                        (uint32_t) ibf_key.key_val,
                                                        &send_offers_iterator,
                                                        &send_cls);
+  *hashes = send_cls.hashes;
+  *num_hashes = send_cls.num_hashes;
+}
+
+
+/**
+ * Send the given hashes to the peer, batched into as few
+ * messages of the given type as possible.  Used for both
+ * offers and demands, which are plain lists of hashes on
+ * the wire and have always been parsed as such.
+ *
+ * @param op union operation
+ * @param type message type, OFFER or DEMAND
+ * @param hashes hashes to transmit
+ * @param num_hashes number of hashes in @a hashes
+ */
+static void
+send_hashes (struct Operation *op,
+             uint16_t type,
+             const struct GNUNET_HashCode *hashes,
+             unsigned int num_hashes)
+{
+  struct GNUNET_MQ_Envelope *ev;
+  struct GNUNET_MessageHeader *mh;
+  unsigned int batch;
+  unsigned int off;
+
+  for (off = 0; off < num_hashes; off += batch)
+  {
+    batch = num_hashes - off;
+    if (batch > MAX_HASHES_PER_MESSAGE)
+      batch = MAX_HASHES_PER_MESSAGE;
+    ev = GNUNET_MQ_msg_header_extra (mh,
+                                     batch * sizeof (struct GNUNET_HashCode),
+                                     type);
+    GNUNET_assert (NULL != ev);
+    memcpy (&mh[1],
+            &hashes[off],
+            batch * sizeof (struct GNUNET_HashCode));
+    GNUNET_MQ_send (op->mq, ev);
+  }
+}
+
+
+/**
+ * Send the given IBF keys to the peer as inquiries, batched
+ * into as few messages as possible.
+ *
+ * @param op union operation
+ * @param keys IBF keys to inquire about
+ * @param num_keys number of keys in @a keys
+ */
+static void
+send_inquiries (struct Operation *op,
+                const struct IBF_Key *keys,
+                unsigned int num_keys)
+{
+  struct GNUNET_MQ_Envelope *ev;
+  struct GNUNET_MessageHeader *msg;
+  unsigned int batch;
+  unsigned int off;
+
+  for (off = 0; off < num_keys; off += batch)
+  {
+    batch = num_keys - off;
+    if (batch > MAX_KEYS_PER_MESSAGE)
+      batch = MAX_KEYS_PER_MESSAGE;
+    ev = GNUNET_MQ_msg_header_extra (msg,
+                                     batch * sizeof (struct IBF_Key),
+                                     GNUNET_MESSAGE_TYPE_SET_UNION_P2P_INQUIRY);
+    GNUNET_assert (NULL != ev);
+    memcpy (&msg[1],
+            &keys[off],
+            batch * sizeof (struct IBF_Key));
+    GNUNET_MQ_send (op->mq, ev);
+  }
 }
 
 
@@ -809,7 +925,12 @@ decode_and_send (struct Operation *op)
   struct IBF_Key key;
   struct IBF_Key last_key;
   int side;
+  int send_done;
   unsigned int num_decoded;
+  struct GNUNET_HashCode *offers;
+  unsigned int num_offers;
+  struct IBF_Key *inquiries;
+  unsigned int num_inquiries;
   struct InvertibleBloomFilter *diff_ibf;
 
   GNUNET_assert (PHASE_INVENTORY_ACTIVE == op->state->phase);
@@ -832,6 +953,11 @@ decode_and_send (struct Operation *op)
 
   num_decoded = 0;
   last_key.key_val = 0;
+  send_done = GNUNET_NO;
+  offers = NULL;
+  num_offers = 0;
+  inquiries = NULL;
+  num_inquiries = 0;
 
   while (1)
   {
@@ -882,6 +1008,8 @@ decode_and_send (struct Operation *op)
                       "Failed to send IBF, closing connection\n");
           fail_union_operation (op);
           ibf_destroy (diff_ibf);
+          GNUNET_free_non_null (offers);
+          GNUNET_free_non_null (inquiries);
           return GNUNET_SYSERR;
         }
       }
@@ -896,51 +1024,56 @@ decode_and_send (struct Operation *op)
              "set union failed: reached ibf limit\n");
         fail_union_operation (op);
         ibf_destroy (diff_ibf);
+        GNUNET_free_non_null (offers);
+        GNUNET_free_non_null (inquiries);
         return GNUNET_SYSERR;
       }
       break;
     }
     if (GNUNET_NO == res)
     {
-      struct GNUNET_MQ_Envelope *ev;
-
       LOG (GNUNET_ERROR_TYPE_DEBUG,
            "transmitted all values, sending DONE\n");
-      ev = GNUNET_MQ_msg_header (GNUNET_MESSAGE_TYPE_SET_UNION_P2P_DONE);
-      GNUNET_MQ_send (op->mq, ev);
-      /* We now wait until we get a DONE message back
-       * and then wait for our MQ to be flushed and all our
-       * demands be delivered. */
+      send_done = GNUNET_YES;
       break;
     }
     if (1 == side)
     {
-      send_offers_for_key (op, key);
+      send_offers_for_key (op, key, &offers, &num_offers);
     }
     else if (-1 == side)
     {
-      struct GNUNET_MQ_Envelope *ev;
-      struct GNUNET_MessageHeader *msg;
-
-      /* It may be nice to merge multiple requests, but with CADET's corking it is not worth
-       * the effort additional complexity. */
-      ev = GNUNET_MQ_msg_header_extra (msg,
-                                       sizeof (struct IBF_Key),
-                                       GNUNET_MESSAGE_TYPE_SET_UNION_P2P_INQUIRY);
-
-      memcpy (&msg[1],
-              &key,
-              sizeof (struct IBF_Key));
       LOG (GNUNET_ERROR_TYPE_DEBUG,
-           "sending element inquiry for IBF key %lx\n",
+           "queuing element inquiry for IBF key %lx\n",
            (unsigned long) key.key_val);
-      GNUNET_MQ_send (op->mq, ev);
+      GNUNET_array_append (inquiries, num_inquiries, key);
     }
     else
     {
       GNUNET_assert (0);
     }
   }
+  /* transmit all offers and inquiries of this round in large
+   * batches instead of one tiny message per element */
+  send_hashes (op,
+               GNUNET_MESSAGE_TYPE_SET_UNION_P2P_OFFER,
+               offers,
+               num_offers);
+  send_inquiries (op,
+                  inquiries,
+                  num_inquiries);
+  GNUNET_free_non_null (offers);
+  GNUNET_free_non_null (inquiries);
+  if (GNUNET_YES == send_done)
+  {
+    struct GNUNET_MQ_Envelope *ev;
+
+    ev = GNUNET_MQ_msg_header (GNUNET_MESSAGE_TYPE_SET_UNION_P2P_DONE);
+    GNUNET_MQ_send (op->mq, ev);
+    /* We now wait until we get a DONE message back
+     * and then wait for our MQ to be flushed and all our
+     * demands be delivered. */
+  }
   ibf_destroy (diff_ibf);
   return GNUNET_OK;
 }
@@ -1162,6 +1295,8 @@ handle_p2p_elements (void *cls,
   struct Operation *op = cls;
   struct ElementEntry *ee;
   const struct GNUNET_SET_ElementMessage *emsg;
+  struct GNUNET_SET_Element el;
+  struct GNUNET_HashCode hash;
   uint16_t element_size;
 
   if (0 == GNUNET_CONTAINER_multihashmap_size (op->state->demanded_hashes))
@@ -1179,23 +1314,21 @@ handle_p2p_elements (void *cls,
 
   emsg = (const struct GNUNET_SET_ElementMessage *) mh;
 
+  /* hash the element in place in the message; we only copy
+   * it into an entry of our own once we know we keep it */
   element_size = ntohs (mh->size) - sizeof (struct GNUNET_SET_ElementMessage);
-  ee = GNUNET_malloc (sizeof (struct ElementEntry) + element_size);
-  memcpy (&ee[1], &emsg[1], element_size);
-  ee->element.size = element_size;
-  ee->element.data = &ee[1];
-  ee->element.element_type = ntohs (emsg->element_type);
-  ee->remote = GNUNET_YES;
-  GNUNET_SET_element_hash (&ee->element, &ee->element_hash);
+  el.size = element_size;
+  el.data = &emsg[1];
+  el.element_type = ntohs (emsg->element_type);
+  GNUNET_SET_element_hash (&el, &hash);
 
   if (GNUNET_NO ==
       GNUNET_CONTAINER_multihashmap_remove (op->state->demanded_hashes,
-                                            &ee->element_hash,
+                                            &hash,
                                             NULL))
   {
     /* We got something we didn't demand, since it's not in our map. */
     GNUNET_break_op (0);
-    GNUNET_free (ee);
     fail_union_operation (op);
     return;
   }
@@ -1203,14 +1336,14 @@ handle_p2p_elements (void *cls,
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Got element (size %u, hash %s) from peer\n",
        (unsigned int) element_size,
-       GNUNET_h2s (&ee->element_hash));
+       GNUNET_h2s (&hash));
 
   GNUNET_STATISTICS_update (_GSS_statistics,
                             "# received elements",
                             1,
                             GNUNET_NO);
 
-  if (GNUNET_YES == op_has_element (op, &ee->element_hash))
+  if (GNUNET_YES == op_has_element (op, &hash))
   {
     /* Got repeated element.  Should not happen since
      * we track demands. */
@@ -1218,12 +1351,18 @@ handle_p2p_elements (void *cls,
                               "# repeated elements",
                               1,
                               GNUNET_NO);
-    GNUNET_free (ee);
   }
   else
   {
     LOG (GNUNET_ERROR_TYPE_DEBUG,
          "Registering new element from remote peer\n");
+    ee = GNUNET_malloc (sizeof (struct ElementEntry) + element_size);
+    memcpy (&ee[1], &emsg[1], element_size);
+    ee->element.size = element_size;
+    ee->element.data = &ee[1];
+    ee->element.element_type = el.element_type;
+    ee->remote = GNUNET_YES;
+    ee->element_hash = hash;
     op_register_element (op, ee);
     /* only send results immediately if the client wants it */
     switch (op->spec->result_mode)
@@ -1259,6 +1398,8 @@ handle_p2p_inquiry (void *cls,
   struct Operation *op = cls;
   const struct IBF_Key *ibf_key;
   unsigned int num_keys;
+  struct GNUNET_HashCode *offers;
+  unsigned int num_offers;
 
   /* look up elements and send them */
   if (op->state->phase != PHASE_INVENTORY_PASSIVE)
@@ -1278,11 +1419,18 @@ handle_p2p_inquiry (void *cls,
   }
 
   ibf_key = (const struct IBF_Key *) &mh[1];
+  offers = NULL;
+  num_offers = 0;
   while (0 != num_keys--)
   {
-    send_offers_for_key (op, *ibf_key);
+    send_offers_for_key (op, *ibf_key, &offers, &num_offers);
     ibf_key++;
   }
+  send_hashes (op,
+               GNUNET_MESSAGE_TYPE_SET_UNION_P2P_OFFER,
+               offers,
+               num_offers);
+  GNUNET_free_non_null (offers);
 }
 
 
@@ -1371,6 +1519,8 @@ handle_p2p_offer (void *cls,
   struct Operation *op = cls;
   const struct GNUNET_HashCode *hash;
   unsigned int num_hashes;
+  struct GNUNET_HashCode *demands;
+  unsigned int num_demands;
 
   /* look up elements and send them */
   if ( (op->state->phase != PHASE_INVENTORY_PASSIVE) &&
@@ -1390,13 +1540,13 @@ handle_p2p_offer (void *cls,
     return;
   }
 
+  demands = NULL;
+  num_demands = 0;
   for (hash = (const struct GNUNET_HashCode *) &mh[1];
        num_hashes > 0;
        hash++, num_hashes--)
   {
     struct ElementEntry *ee;
-    struct GNUNET_MessageHeader *demands;
-    struct GNUNET_MQ_Envelope *ev;
 
     ee = GNUNET_CONTAINER_multihashmap_get (op->spec->set->content->elements,
                                             hash);
@@ -1422,12 +1572,13 @@ handle_p2p_offer (void *cls,
     LOG (GNUNET_ERROR_TYPE_DEBUG,
          "[OP %x] Requesting element (hash %s)\n",
          (void *) op, GNUNET_h2s (hash));
-    ev = GNUNET_MQ_msg_header_extra (demands,
-                                     sizeof (struct GNUNET_HashCode),
-                                     GNUNET_MESSAGE_TYPE_SET_UNION_P2P_DEMAND);
-    *(struct GNUNET_HashCode *) &demands[1] = *hash;
-    GNUNET_MQ_send (op->mq, ev);
+    GNUNET_array_append (demands, num_demands, *hash);
   }
+  send_hashes (op,
+               GNUNET_MESSAGE_TYPE_SET_UNION_P2P_DEMAND,
+               demands,
+               num_demands);
+  GNUNET_free_non_null (demands);
 }
 
 
@@ -206,7 +206,8 @@ strata_estimator_create (unsigned int strata_count,
       GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
                   "Failed to allocate memory for strata estimator\n");
       for (j = 0; j < i; j++)
-        ibf_destroy (se->strata[i]);
+        ibf_destroy (se->strata[j]);
+      GNUNET_free (se->strata);
       GNUNET_free (se);
       return NULL;
     }
@@ -230,17 +231,22 @@ strata_estimator_difference (const struct StrataEstimator *se1,
 {
   int i;
   unsigned int count;
+  struct InvertibleBloomFilter *diff;
 
   GNUNET_assert (se1->strata_count == se2->strata_count);
+  /* use a single scratch IBF for all strata instead of
+     duplicating (and allocating) each stratum just to
+     subtract and decode it */
+  diff = ibf_create (se1->ibf_size,
+                     se1->strata[0]->hash_num);
+  GNUNET_assert (NULL != diff);
   count = 0;
   for (i = se1->strata_count - 1; i >= 0; i--)
   {
-    struct InvertibleBloomFilter *diff;
     /* number of keys decoded from the ibf */
     int ibf_count;
 
-    /* FIXME: implement this without always allocating new IBFs */
-    diff = ibf_dup (se1->strata[i]);
+    ibf_copy (diff, se1->strata[i]);
     ibf_subtract (diff, se2->strata[i]);
     for (ibf_count = 0; GNUNET_YES; ibf_count++)
     {
@@ -259,8 +265,8 @@ strata_estimator_difference (const struct StrataEstimator *se1,
         return count * (1 << (i + 1));
       }
     }
-    ibf_destroy (diff);
   }
+  ibf_destroy (diff);
   return count;
 }
 
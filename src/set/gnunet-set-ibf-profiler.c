@@ -34,6 +34,7 @@ static unsigned int bsize = 10;
 static unsigned int csize = 10;
 static unsigned int hash_num = 4;
 static unsigned int ibf_size = 80;
+static int csv_output;
 
 /* FIXME: add parameter for this */
 static enum GNUNET_CRYPTO_Quality random_quality = GNUNET_CRYPTO_QUALITY_WEAK;
@@ -114,6 +115,8 @@ run (void *cls,
   int res;
   struct GNUNET_TIME_Absolute start_time;
   struct GNUNET_TIME_Relative delta_time;
+  struct GNUNET_TIME_Relative encode_time;
+  const char *status;
 
   set_a = GNUNET_CONTAINER_multihashmap_create (((asize == 0) ? 1 : (asize + csize)),
                                                  GNUNET_NO);
@@ -125,8 +128,9 @@ run (void *cls,
   key_to_hashcode = GNUNET_CONTAINER_multihashmap_create (((asize+bsize+csize == 0) ? 1 : (asize+bsize+csize)),
                                                           GNUNET_NO);
 
-  printf ("hash-num=%u, size=%u, #(A-B)=%u, #(B-A)=%u, #(A&B)=%u\n",
-          hash_num, ibf_size, asize, bsize, csize);
+  if (! csv_output)
+    printf ("hash-num=%u, size=%u, #(A-B)=%u, #(B-A)=%u, #(A&B)=%u\n",
+            hash_num, ibf_size, asize, bsize, csize);
 
   i = 0;
   while (i < asize)
@@ -183,7 +187,8 @@ run (void *cls,
   }
 
 
-  printf ("generated sets\n");
+  if (! csv_output)
+    printf ("generated sets\n");
 
   start_time = GNUNET_TIME_absolute_get ();
 
@@ -192,15 +197,17 @@ run (void *cls,
   GNUNET_CONTAINER_multihashmap_iterate (set_c, &insert_iterator, ibf_a);
   GNUNET_CONTAINER_multihashmap_iterate (set_c, &insert_iterator, ibf_b);
 
-  delta_time = GNUNET_TIME_absolute_get_duration (start_time);
+  encode_time = GNUNET_TIME_absolute_get_duration (start_time);
 
-  printf ("encoded in: %s\n",
-          GNUNET_STRINGS_relative_time_to_string (delta_time,
-                                                  GNUNET_NO));
+  if (! csv_output)
+    printf ("encoded in: %s\n",
+            GNUNET_STRINGS_relative_time_to_string (encode_time,
+                                                    GNUNET_NO));
 
   ibf_subtract (ibf_a, ibf_b);
 
 
+  status = "cyclic";
   start_time = GNUNET_TIME_absolute_get ();
 
   for (i = 0; i <= asize + bsize; i++)
@@ -208,26 +215,32 @@ run (void *cls,
     res = ibf_decode (ibf_a, &side, &ibf_key);
     if (GNUNET_SYSERR == res)
     {
-      printf ("decode failed, %u/%u elements left\n",
-         GNUNET_CONTAINER_multihashmap_size (set_a) + GNUNET_CONTAINER_multihashmap_size (set_b),
-         asize + bsize);
-      return;
+      status = "decode_failed";
+      if (! csv_output)
+        printf ("decode failed, %u/%u elements left\n",
+           GNUNET_CONTAINER_multihashmap_size (set_a) + GNUNET_CONTAINER_multihashmap_size (set_b),
+           asize + bsize);
+      goto done;
     }
     if (GNUNET_NO == res)
     {
       if ((0 == GNUNET_CONTAINER_multihashmap_size (set_b)) &&
           (0 == GNUNET_CONTAINER_multihashmap_size (set_a)))
       {
+        status = "ok";
         delta_time = GNUNET_TIME_absolute_get_duration (start_time);
-        printf ("decoded successfully in: %s\n",
-                GNUNET_STRINGS_relative_time_to_string (delta_time,
-                                                        GNUNET_NO));
+        if (! csv_output)
+          printf ("decoded successfully in: %s\n",
+                  GNUNET_STRINGS_relative_time_to_string (delta_time,
+                                                          GNUNET_NO));
       }
       else
       {
-        printf ("decode missed elements (should never happen)\n");
+        status = "missed";
+        if (! csv_output)
+          printf ("decode missed elements (should never happen)\n");
       }
-      return;
+      goto done;
     }
 
     if (side == 1)
@@ -235,9 +248,20 @@ run (void *cls,
     if (side == -1)
       iter_hashcodes (ibf_key, remove_iterator, set_b);
   }
-  printf("cyclic IBF, %u/%u elements left\n",
-         GNUNET_CONTAINER_multihashmap_size (set_a) + GNUNET_CONTAINER_multihashmap_size (set_b),
-         asize + bsize);
+  if (! csv_output)
+    printf("cyclic IBF, %u/%u elements left\n",
+           GNUNET_CONTAINER_multihashmap_size (set_a) + GNUNET_CONTAINER_multihashmap_size (set_b),
+           asize + bsize);
+done:
+  delta_time = GNUNET_TIME_absolute_get_duration (start_time);
+  if (csv_output)
+    printf ("%u,%u,%u,%u,%u,%llu,%llu,%llu,%llu,%s\n",
+            asize, bsize, csize, hash_num, ibf_size,
+            (unsigned long long) ibf_size * IBF_BUCKET_SIZE,
+            (unsigned long long) (asize + csize) * sizeof (struct GNUNET_HashCode),
+            (unsigned long long) encode_time.rel_value_us,
+            (unsigned long long) delta_time.rel_value_us,
+            status);
 }
 
 
@@ -260,6 +284,9 @@ main (int argc, char **argv)
     {'s', "ibf-size", NULL,
      gettext_noop ("ibf size"), 1,
      &GNUNET_GETOPT_set_uint, &ibf_size},
+    {'o', "csv", NULL,
+     gettext_noop ("output a single CSV line (for perf_set.sh)"), 0,
+     &GNUNET_GETOPT_set_one, &csv_output},
     GNUNET_GETOPT_OPTION_END
   };
   GNUNET_PROGRAM_run2 (argc, argv, "gnunet-consensus-ibf",
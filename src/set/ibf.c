@@ -223,16 +223,22 @@ ibf_decode (struct InvertibleBloomFilter *ibf,
             int *ret_side, struct IBF_Key *ret_id)
 {
   struct IBF_KeyHash hash;
-  int i;
+  uint32_t n;
+  uint32_t i;
   int buckets[ibf->hash_num];
 
   GNUNET_assert (NULL != ibf);
 
-  for (i = 0; i < ibf->size; i++)
+  /* start scanning where the last decode stopped: removing a
+   * decoded element only touches hash_num buckets, so the next
+   * pure bucket is usually close behind the previous one */
+  for (n = 0; n < ibf->size; n++)
   {
     int j;
     int hit;
 
+    i = (ibf->scan_pos + n) % ibf->size;
+
     /* we can only decode from pure buckets */
     if ((1 != ibf->count[i].count_val) && (-1 != ibf->count[i].count_val))
       continue;
@@ -248,7 +254,7 @@ ibf_decode (struct InvertibleBloomFilter *ibf,
     hit = GNUNET_NO;
     ibf_get_indices (ibf, ibf->key_sum[i], buckets);
     for (j = 0; j < ibf->hash_num; j++)
-      if (buckets[j] == i)
+      if (buckets[j] == (int) i)
         hit = GNUNET_YES;
 
     if (GNUNET_NO == hit)
@@ -262,6 +268,7 @@ ibf_decode (struct InvertibleBloomFilter *ibf,
     /* insert on the opposite side, effectively removing the element */
     ibf_insert_into (ibf, ibf->key_sum[i], buckets, -ibf->count[i].count_val);
 
+    ibf->scan_pos = i;
     return GNUNET_YES;
   }
 
@@ -345,17 +352,41 @@ ibf_read_slice (const void *buf, uint32_t start, uint32_t count, struct Invertib
 void
 ibf_subtract (struct InvertibleBloomFilter *ibf1, const struct InvertibleBloomFilter *ibf2)
 {
-  int i;
+  uint32_t i;
 
   GNUNET_assert (ibf1->size == ibf2->size);
   GNUNET_assert (ibf1->hash_num == ibf2->hash_num);
 
+  /* process each bucket array on its own; the loops then run over
+   * contiguous arrays of one element type each, which compilers
+   * turn into vectorized XOR/SUB over whole cache lines */
   for (i = 0; i < ibf1->size; i++)
-  {
     ibf1->count[i].count_val -= ibf2->count[i].count_val;
+  for (i = 0; i < ibf1->size; i++)
     ibf1->key_hash_sum[i].key_hash_val ^= ibf2->key_hash_sum[i].key_hash_val;
+  for (i = 0; i < ibf1->size; i++)
     ibf1->key_sum[i].key_val ^= ibf2->key_sum[i].key_val;
-  }
+  ibf1->scan_pos = 0;
+}
+
+
+/**
+ * Copy the contents of an IBF into an existing IBF of the
+ * same dimensions, avoiding the allocations of #ibf_dup().
+ *
+ * @param dst IBF to overwrite
+ * @param src IBF to copy from
+ */
+void
+ibf_copy (struct InvertibleBloomFilter *dst,
+          const struct InvertibleBloomFilter *src)
+{
+  GNUNET_assert (dst->size == src->size);
+  GNUNET_assert (dst->hash_num == src->hash_num);
+  memcpy (dst->key_sum, src->key_sum, src->size * sizeof (struct IBF_Key));
+  memcpy (dst->key_hash_sum, src->key_hash_sum, src->size * sizeof (struct IBF_KeyHash));
+  memcpy (dst->count, src->count, src->size * sizeof (struct IBF_Count));
+  dst->scan_pos = 0;
 }
 
 
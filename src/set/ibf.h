@@ -110,6 +110,15 @@ struct InvertibleBloomFilter
    * Array of 'size' elements.
    */
   struct IBF_Count *count;
+
+  /**
+   * Bucket at which #ibf_decode() starts scanning for
+   * pure buckets.  Decoding modifies only a few buckets,
+   * so continuing after the last decoded bucket (with
+   * wrap-around) avoids rescanning the whole array for
+   * every recovered element.
+   */
+  uint32_t scan_pos;
 };
 
 
@@ -226,6 +235,18 @@ ibf_decode (struct InvertibleBloomFilter *ibf,
             struct IBF_Key *ret_id);
 
 
+/**
+ * Copy the contents of an IBF into an existing IBF of the
+ * same dimensions, avoiding the allocations of #ibf_dup().
+ *
+ * @param dst IBF to overwrite
+ * @param src IBF to copy from
+ */
+void
+ibf_copy (struct InvertibleBloomFilter *dst,
+          const struct InvertibleBloomFilter *src);
+
+
 /**
  * Create a copy of an IBF, the copy has to be destroyed properly.
  *
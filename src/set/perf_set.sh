@@ -0,0 +1,49 @@
+#!/bin/bash
+# Sweep set sizes and difference fractions over the IBF-based
+# reconciliation core and report the cost of each configuration as
+# CSV, comparing against the cost of simply transferring the full
+# set.  Intended to guide the choice of the force_full/byzantine
+# thresholds in gnunet-service-set_union.c for a given workload.
+#
+# Invoke via 'make perf-set' (or directly from the build directory).
+#
+# Columns:
+#   set_size       total number of elements per side
+#   diff_fraction  fraction of elements differing between the sides
+#   asize,bsize    elements only in A resp. only in B
+#   csize          common elements
+#   hash_num       buckets each element is hashed into
+#   ibf_size       number of IBF buckets
+#   ibf_bytes      bytes on the wire for one IBF of that size
+#   full_bytes     bytes to transfer one side's element hashes in full
+#   encode_us      time to encode both sides into IBFs (microseconds)
+#   decode_us      time to decode the difference (microseconds)
+#   status         ok / decode_failed / missed / cyclic
+
+PROFILER=${PROFILER:-./gnunet-set-ibf-profiler}
+
+if ! test -x "$PROFILER"
+then
+  echo "$PROFILER not found, run make first" >&2
+  exit 1
+fi
+
+echo "set_size,diff_fraction,asize,bsize,csize,hash_num,ibf_size,ibf_bytes,full_bytes,encode_us,decode_us,status"
+for SIZE in 1000 10000 100000 1000000
+do
+  for FRAC in 0.001 0.01 0.1 0.5
+  do
+    DIFF=`echo "$SIZE $FRAC" | awk '{ d = int ($1 * $2); if (d < 2) d = 2; print d }'`
+    HALF=$(($DIFF / 2))
+    COMMON=$(($SIZE - $HALF))
+    # mirror the service's initial sizing: twice the
+    # (estimated) difference, which it doubles on failure
+    IBFSIZE=$((2 * $DIFF))
+    if test $IBFSIZE -lt 16
+    then
+      IBFSIZE=16
+    fi
+    LINE=`$PROFILER --csv -A $HALF -B $HALF -C $COMMON -s $IBFSIZE`
+    echo "$SIZE,$FRAC,$LINE"
+  done
+done
@@ -667,7 +667,9 @@ place_init (struct Place *plc)
  * @param msg
  *        Entry message.
  *
- * @return Return value of GNUNET_CONTAINER_multihashmap_put ()
+ * @return #GNUNET_YES if the entry is new or changed,
+ *         #GNUNET_NO if an identical entry was already in the map,
+ *         #GNUNET_SYSERR on failure.
  */
 static int
 place_add (const struct GNUNET_HashCode *ego_pub_hash,
@@ -690,21 +692,27 @@ place_add (const struct GNUNET_HashCode *ego_pub_hash,
                                        GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST);
   }
 
+  uint16_t msg_size = ntohs (msg->size);
   struct GNUNET_MessageHeader *msg_old, *msg_new;
   if (NULL != (msg_old = GNUNET_CONTAINER_multihashmap_get (ego_places, place_pub_hash)))
   {
+    if (ntohs (msg_old->size) == msg_size
+        && 0 == memcmp (msg_old, msg, msg_size))
+      return GNUNET_NO; /* identical entry already cached */
     GNUNET_free (msg_old);
     GNUNET_CONTAINER_multihashmap_remove_all (ego_places, place_pub_hash);
   }
 
-  uint16_t msg_size = ntohs (msg->size);
   msg_new = GNUNET_malloc (msg_size);
   memcpy (msg_new, msg, msg_size);
-  int ret = GNUNET_CONTAINER_multihashmap_put (ego_places, place_pub_hash, msg_new,
-                                               GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST);
-  if (GNUNET_OK != ret)
+  if (GNUNET_OK !=
+      GNUNET_CONTAINER_multihashmap_put (ego_places, place_pub_hash, msg_new,
+                                         GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST))
+  {
     GNUNET_break (0);
-  return ret;
+    return GNUNET_SYSERR;
+  }
+  return GNUNET_YES;
 }
 
 
@@ -734,16 +742,15 @@ place_save (const struct GNUNET_CRYPTO_EcdsaPrivateKey *ego_key,
   GNUNET_CRYPTO_ecdsa_key_get_public (ego_key, &ego_pub);
   GNUNET_CRYPTO_hash (&ego_pub, sizeof (ego_pub), &ego_pub_hash);
 
-  place_add (&ego_pub_hash, &place_pub_hash, msg);
+  if (GNUNET_YES != place_add (&ego_pub_hash, &place_pub_hash, msg))
+    return; /* identical entry already saved to disk earlier */
 
   char *ego_pub_hash_str = GNUNET_malloc (sizeof (struct GNUNET_CRYPTO_HashAsciiEncoded) + 1);
   char *place_pub_hash_str = GNUNET_malloc (sizeof (struct GNUNET_CRYPTO_HashAsciiEncoded) + 1);
   memcpy (ego_pub_hash_str, GNUNET_h2s_full (&ego_pub_hash), sizeof (struct GNUNET_CRYPTO_HashAsciiEncoded));
   memcpy (place_pub_hash_str, GNUNET_h2s_full (&place_pub_hash), sizeof (struct GNUNET_CRYPTO_HashAsciiEncoded));
 
-  char *filename = GNUNET_malloc (strlen (dir_places) + 1
-                                  + sizeof (struct GNUNET_CRYPTO_HashAsciiEncoded) + 1
-                                  + sizeof (struct GNUNET_CRYPTO_HashAsciiEncoded) + 1);
+  char *filename;
   GNUNET_asprintf (&filename,
                    "%s%s%s%s%s",
                    dir_places, DIR_SEPARATOR_STR,
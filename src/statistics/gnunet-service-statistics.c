@@ -139,6 +139,19 @@ struct StatsEntry
    */
   int set;
 
+  /**
+   * Next entry in the list of values with pending watch
+   * notifications, or NULL.
+   */
+  struct StatsEntry *notify_next;
+
+  /**
+   * Is this entry in the pending notification list?  Used to
+   * coalesce bursts of updates to the same value into a single
+   * notification per watcher.
+   */
+  int notify_pending;
+
 };
 
 
@@ -235,6 +248,17 @@ static struct GNUNET_SERVER_NotificationContext *nc;
  */
 static uint32_t uidgen;
 
+/**
+ * Head of the list of values with pending watch notifications
+ * (chained via `notify_next`).
+ */
+static struct StatsEntry *pending_head;
+
+/**
+ * Task that flushes the pending watch notifications.
+ */
+static struct GNUNET_SCHEDULER_Task *notify_task;
+
 /**
  * Set to #GNUNET_YES if we are shutting down as soon as possible.
  */
@@ -616,6 +640,52 @@ notify_change (struct StatsEntry *se)
 }
 
 
+/**
+ * Task that sends out the notifications for all values changed since
+ * it was scheduled.
+ *
+ * @param cls NULL
+ * @param tc scheduler context
+ */
+static void
+flush_notifications (void *cls,
+                     const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct StatsEntry *se;
+
+  notify_task = NULL;
+  while (NULL != (se = pending_head))
+  {
+    pending_head = se->notify_next;
+    se->notify_next = NULL;
+    se->notify_pending = GNUNET_NO;
+    notify_change (se);
+  }
+}
+
+
+/**
+ * Queue a change notification for the given value.  Watchers are not
+ * notified right away but from a separate task, so that a burst of
+ * updates to the same value yields only one message per watcher
+ * (with the latest value) instead of one per update.
+ *
+ * @param se value that changed
+ */
+static void
+schedule_notify_change (struct StatsEntry *se)
+{
+  if (GNUNET_YES == se->notify_pending)
+    return;
+  se->notify_pending = GNUNET_YES;
+  se->notify_next = pending_head;
+  pending_head = se;
+  if (NULL == notify_task)
+    notify_task = GNUNET_SCHEDULER_add_now (&flush_notifications,
+                                            NULL);
+}
+
+
 /**
  * Find the subsystem entry of the given name for the specified client.
  *
@@ -797,7 +867,7 @@ handle_set (void *cls,
                 pos->persistent);
     if ( (changed) ||
          (1 == initial_set) )
-      notify_change (pos);
+      schedule_notify_change (pos);
     GNUNET_SERVER_receive_done (client,
                                 GNUNET_OK);
     return;
@@ -934,6 +1004,12 @@ do_shutdown ()
 
   if (NULL == nc)
     return;
+  if (NULL != notify_task)
+  {
+    GNUNET_SCHEDULER_cancel (notify_task);
+    notify_task = NULL;
+    pending_head = NULL;
+  }
   save ();
   GNUNET_SERVER_notification_context_destroy (nc);
   nc = NULL;
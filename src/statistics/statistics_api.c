@@ -37,6 +37,15 @@
  */
 #define SET_TRANSMIT_TIMEOUT GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS, 2)
 
+/**
+ * How long do we hold back SET/UPDATE actions before transmitting
+ * them to the service?  Within this window, further changes to the
+ * same counter are coalesced into the pending action, so services
+ * generating hundreds of updates per second cause only a few
+ * transmissions (and wakeups) per second.
+ */
+#define UPDATE_FLUSH_DELAY GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MILLISECONDS, 100)
+
 #define LOG(kind,...) GNUNET_log_from (kind, "statistics-api",__VA_ARGS__)
 
 /**
@@ -232,6 +241,12 @@ struct GNUNET_STATISTICS_Handle
    */
   struct GNUNET_SCHEDULER_Task * backoff_task;
 
+  /**
+   * Task delaying the transmission of queued SET/UPDATE actions
+   * so that rapid counter changes coalesce.
+   */
+  struct GNUNET_SCHEDULER_Task * flush_task;
+
   /**
    * Time for next connect retry.
    */
@@ -320,6 +335,42 @@ static void
 schedule_action (struct GNUNET_STATISTICS_Handle *h);
 
 
+/**
+ * The flush delay for coalescing SET/UPDATE actions is over,
+ * start transmitting the queue.
+ *
+ * @param cls the `struct GNUNET_STATISTICS_Handle`
+ * @param tc scheduler context (unused)
+ */
+static void
+flush_action_queue (void *cls,
+                    const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct GNUNET_STATISTICS_Handle *h = cls;
+
+  h->flush_task = NULL;
+  schedule_action (h);
+}
+
+
+/**
+ * Make sure the queued SET/UPDATE actions will be transmitted
+ * once the flush delay is over.  While the delay is pending,
+ * further changes to the same counters merge into the queue.
+ *
+ * @param h statistics handle
+ */
+static void
+schedule_flush (struct GNUNET_STATISTICS_Handle *h)
+{
+  if (NULL != h->flush_task)
+    return;
+  h->flush_task = GNUNET_SCHEDULER_add_delayed (UPDATE_FLUSH_DELAY,
+                                                &flush_action_queue,
+                                                h);
+}
+
+
 /**
  * Transmit request to service that we want to watch
  * the development of a particular value.
@@ -995,6 +1046,11 @@ GNUNET_STATISTICS_destroy (struct GNUNET_STATISTICS_Handle *h,
     GNUNET_SCHEDULER_cancel (h->backoff_task);
     h->backoff_task = NULL;
   }
+  if (NULL != h->flush_task)
+  {
+    GNUNET_SCHEDULER_cancel (h->flush_task);
+    h->flush_task = NULL;
+  }
   if (sync_first)
   {
     if (NULL != h->current)
@@ -1430,7 +1486,7 @@ add_setter_action (struct GNUNET_STATISTICS_Handle *h,
   ai->type = type;
   GNUNET_CONTAINER_DLL_insert_tail (h->action_head, h->action_tail,
 				    ai);
-  schedule_action (h);
+  schedule_flush (h);
 }
 
 
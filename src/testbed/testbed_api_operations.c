@@ -733,7 +733,7 @@ merge_ops (struct GNUNET_TESTBED_Operation ***old,
     }
     if (j < *n_old)
       continue;
-    GNUNET_array_append (cur, n_cur, new[j]);
+    GNUNET_array_append (cur, n_cur, new[i]);
   }
   *old = cur;
   *n_old = n_cur;
@@ -1127,7 +1127,11 @@ GNUNET_TESTBED_operation_queue_destroy_empty_ (struct OperationQueue *queue)
 
 /**
  * Rechecks if any of the operations in the given operation queue's waiting list
- * can be made active
+ * can be made active.  One capacity change can free up room for several
+ * waiting operations, so we keep scanning past waiters which are blocked on
+ * one of their _other_ queues for as long as this queue still has capacity
+ * to hand out; once this queue itself is saturated no further waiter can be
+ * helped and we stop.
  *
  * @param opq the operation queue
  */
@@ -1141,7 +1145,8 @@ recheck_waiting (struct OperationQueue *opq)
   while (NULL != entry)
   {
     entry2 = entry->next;
-    if (GNUNET_NO == check_readiness (entry->op))
+    if ( (GNUNET_NO == check_readiness (entry->op)) &&
+         (opq->active >= opq->max_active) )
       break;
     entry = entry2;
   }
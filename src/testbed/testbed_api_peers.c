@@ -86,6 +86,30 @@ GNUNET_TESTBED_cleanup_peers_ (void)
 
 
 
+/**
+ * Serialized form of the configuration template used by the last
+ * peer create operation; experiments create hundreds of peers from
+ * the same template, so the (expensive) compression of it is done
+ * only when the template actually changed.
+ */
+static char *cached_config;
+
+/**
+ * Number of bytes in @e cached_config.
+ */
+static size_t cached_config_size;
+
+/**
+ * Compressed form of @e cached_config.
+ */
+static char *cached_xconfig;
+
+/**
+ * Number of bytes in @e cached_xconfig.
+ */
+static size_t cached_xc_size;
+
+
 /**
  * Function to call to start a peer_create type operation once all
  * queues the operation is part of declare that the
@@ -100,9 +124,7 @@ opstart_peer_create (void *cls)
   struct PeerCreateData *data = opc->data;
   struct GNUNET_TESTBED_PeerCreateMessage *msg;
   char *config;
-  char *xconfig;
   size_t c_size;
-  size_t xc_size;
   uint16_t msize;
 
   GNUNET_assert (OP_PEER_CREATE == opc->type);
@@ -110,17 +132,32 @@ opstart_peer_create (void *cls)
   GNUNET_assert (NULL != data->peer);
   opc->state = OPC_STATE_STARTED;
   config = GNUNET_CONFIGURATION_serialize (data->cfg, &c_size);
-  xc_size = GNUNET_TESTBED_compress_config_ (config, c_size, &xconfig);
-  GNUNET_free (config);
-  msize = xc_size + sizeof (struct GNUNET_TESTBED_PeerCreateMessage);
-  msg = GNUNET_realloc (xconfig, msize);
-  memmove (&msg[1], msg, xc_size);
+  if ((c_size == cached_config_size) &&
+      (NULL != cached_config) &&
+      (0 == memcmp (config, cached_config, c_size)))
+  {
+    /* same template as the last peer created; reuse its
+       compressed form */
+    GNUNET_free (config);
+  }
+  else
+  {
+    GNUNET_free_non_null (cached_config);
+    GNUNET_free_non_null (cached_xconfig);
+    cached_config = config;
+    cached_config_size = c_size;
+    cached_xc_size =
+        GNUNET_TESTBED_compress_config_ (config, c_size, &cached_xconfig);
+  }
+  msize = cached_xc_size + sizeof (struct GNUNET_TESTBED_PeerCreateMessage);
+  msg = GNUNET_malloc (msize);
+  memcpy (&msg[1], cached_xconfig, cached_xc_size);
   msg->header.size = htons (msize);
   msg->header.type = htons (GNUNET_MESSAGE_TYPE_TESTBED_CREATE_PEER);
   msg->operation_id = GNUNET_htonll (opc->id);
   msg->host_id = htonl (GNUNET_TESTBED_host_get_id_ (data->peer->host));
   msg->peer_id = htonl (data->peer->unique_id);
-  msg->config_size = htons ((uint16_t) c_size);
+  msg->config_size = htons ((uint16_t) cached_config_size);
   GNUNET_TESTBED_insert_opc_ (opc->c, opc);
   GNUNET_TESTBED_queue_message_ (opc->c, &msg->header);
 }
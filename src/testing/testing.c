@@ -132,6 +132,13 @@ struct GNUNET_TESTING_System
 
   unsigned int n_shared_services;
 
+  /**
+   * Pristine default configuration of this installation; loaded
+   * lazily and used to write only the per-peer differences to disk
+   * in #GNUNET_TESTING_peer_configure().
+   */
+  struct GNUNET_CONFIGURATION_Handle *cfg_defaults;
+
   /**
    * Bitmap where each port that has already been reserved for some GNUnet peer
    * is recorded.  Note that we make no distinction between TCP and UDP ports
@@ -555,6 +562,8 @@ GNUNET_TESTING_system_destroy (struct GNUNET_TESTING_System *system,
     GNUNET_free (ss);
   }
   GNUNET_free_non_null (system->shared_services);
+  if (NULL != system->cfg_defaults)
+    GNUNET_CONFIGURATION_destroy (system->cfg_defaults);
   if (GNUNET_YES == remove_paths)
     GNUNET_DISK_directory_remove (system->tmppath);
   GNUNET_free (system->tmppath);
@@ -1240,7 +1249,20 @@ GNUNET_TESTING_peer_configure (struct GNUNET_TESTING_System *system,
   GNUNET_assert (GNUNET_OK ==
                  GNUNET_CONFIGURATION_get_value_filename
                  (cfg, "PATHS", "DEFAULTCONFIG", &config_filename));
-  if (GNUNET_OK != GNUNET_CONFIGURATION_write (cfg, config_filename))
+  if (NULL == system->cfg_defaults)
+  {
+    system->cfg_defaults = GNUNET_CONFIGURATION_create ();
+    /* if loading the installation defaults fails, the diff below
+       degenerates to writing the full configuration */
+    (void) GNUNET_CONFIGURATION_load (system->cfg_defaults, NULL);
+  }
+  /* Services load the installation defaults before parsing this
+     file, so writing only the difference yields the identical
+     configuration while keeping the file -- and every service's
+     parse of it -- small */
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_write_diffs (system->cfg_defaults, cfg,
+                                        config_filename))
   {
     GNUNET_asprintf (&emsg_,
 		     _("Failed to write configuration file `%s' for peer %u: %s\n"),
@@ -58,6 +58,12 @@
  */
 #define HELLO_ADVERTISEMENT_MIN_REPEAT_FREQUENCY GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_HOURS, 4)
 
+/**
+ * How long must a connection last for us to consider the peer
+ * reliable and reset its greylisting backoff?
+ */
+#define STABLE_CONNECTION_TIME GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 5)
+
 
 /**
  * Record for neighbours, friends and blacklisted peers.
@@ -112,6 +118,31 @@ struct Peer
    */
   uint32_t strength;
 
+  /**
+   * How often have we seen this peer connect successfully?
+   * Used to prefer peers with a good track record after restarts.
+   */
+  uint32_t num_connects;
+
+  /**
+   * Current length of the greylisting backoff for this peer;
+   * grows with every short-lived connection and is reset once
+   * a connection proved stable.
+   */
+  struct GNUNET_TIME_Relative greylist_backoff;
+
+  /**
+   * Time until which we refrain from asking ATS to connect
+   * to this peer (greylisting).
+   */
+  struct GNUNET_TIME_Absolute greylisted_until;
+
+  /**
+   * When did the current connection start?  Only valid while
+   * @e is_connected is #GNUNET_YES.
+   */
+  struct GNUNET_TIME_Absolute connect_time;
+
   /**
    * Is this peer listed here because he is a friend?
    */
@@ -327,10 +358,18 @@ attempt_connect (struct Peer *pos)
     else
       strength = 0; /* disallowed */
   }
+  if (0 != strength)
+    strength += GNUNET_MIN (pos->num_connects,
+			    8); /* prefer peers that worked before */
   if (pos->is_friend)
     strength *= 2; /* friends always count more */
   if (pos->is_connected)
     strength *= 2; /* existing connections preferred */
+  if ( (0 != strength) &&
+       (GNUNET_YES != pos->is_friend) &&
+       (GNUNET_YES != pos->is_connected) &&
+       (0 != GNUNET_TIME_absolute_get_remaining (pos->greylisted_until).rel_value_us) )
+    strength = 0; /* greylisted: wait for the backoff to expire */
   if (strength == pos->strength)
     return; /* nothing to do */
   if (NULL != pos->sh)
@@ -628,6 +667,8 @@ connect_notify (void *cls,
     GNUNET_assert (GNUNET_NO == pos->is_connected);
   }
   pos->is_connected = GNUNET_YES;
+  pos->connect_time = GNUNET_TIME_absolute_get ();
+  pos->num_connects++;
   if (pos->is_friend)
   {
     friend_count++;
@@ -715,6 +756,20 @@ disconnect_notify (void *cls,
   }
   pos->is_connected = GNUNET_NO;
   connection_count--;
+  if (GNUNET_TIME_absolute_get_duration (pos->connect_time).rel_value_us >=
+      STABLE_CONNECTION_TIME.rel_value_us)
+  {
+    /* connection held, peer has proven itself reliable */
+    pos->greylist_backoff = GNUNET_TIME_UNIT_ZERO;
+  }
+  else
+  {
+    /* short-lived connection, greylist with growing backoff so we
+       do not waste our dials on flapping peers */
+    pos->greylist_backoff = GNUNET_TIME_STD_BACKOFF (pos->greylist_backoff);
+    pos->greylisted_until =
+        GNUNET_TIME_relative_to_absolute (pos->greylist_backoff);
+  }
   if (NULL != pos->hello_req)
   {
     GNUNET_CORE_notify_transmit_ready_cancel (pos->hello_req);
@@ -1013,6 +1068,135 @@ read_friends_file (const struct GNUNET_CONFIGURATION_Handle *cfg)
 }
 
 
+/**
+ * Read the peer quality file (if configured) and restore what we
+ * learned about our peers before the last restart.
+ */
+static void
+read_quality_file ()
+{
+  struct GNUNET_BIO_ReadHandle *rh;
+  struct GNUNET_PeerIdentity pid;
+  struct Peer *pos;
+  char *fn;
+  int32_t num_connects;
+  int64_t backoff_us;
+  unsigned int entries_found;
+
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_filename (cfg,
+                                               "TOPOLOGY",
+                                               "QUALITYFILE",
+                                               &fn))
+    return; /* persistence not configured */
+  if (GNUNET_YES != GNUNET_DISK_file_test (fn))
+  {
+    GNUNET_free (fn);
+    return; /* fresh start */
+  }
+  rh = GNUNET_BIO_read_open (fn);
+  if (NULL == rh)
+  {
+    GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_WARNING,
+                              "open",
+                              fn);
+    GNUNET_free (fn);
+    return;
+  }
+  entries_found = 0;
+  while ( (GNUNET_OK ==
+           GNUNET_BIO_read (rh,
+                            "peer",
+                            &pid,
+                            sizeof (struct GNUNET_PeerIdentity))) &&
+          (GNUNET_OK == GNUNET_BIO_read_int32 (rh, &num_connects)) &&
+          (GNUNET_OK == GNUNET_BIO_read_int64 (rh, &backoff_us)) )
+  {
+    pos = GNUNET_CONTAINER_multipeermap_get (peers, &pid);
+    if (NULL == pos)
+      pos = make_peer (&pid, NULL, GNUNET_NO);
+    pos->num_connects = (uint32_t) num_connects;
+    pos->greylist_backoff.rel_value_us = (uint64_t) backoff_us;
+    entries_found++;
+  }
+  GNUNET_BIO_read_close (rh, NULL);
+  GNUNET_free (fn);
+  GNUNET_STATISTICS_update (stats,
+                            gettext_noop ("# peer quality records loaded"),
+                            entries_found,
+                            GNUNET_NO);
+}
+
+
+/**
+ * Write the quality record of one peer to the quality file.
+ *
+ * @param cls the `struct GNUNET_BIO_WriteHandle` to write to
+ * @param pid identity of the peer
+ * @param value the `struct Peer` to persist
+ * @return #GNUNET_YES to continue iteration, #GNUNET_NO on write errors
+ */
+static int
+write_quality_entry (void *cls,
+                     const struct GNUNET_PeerIdentity *pid,
+                     void *value)
+{
+  struct GNUNET_BIO_WriteHandle *wh = cls;
+  struct Peer *pos = value;
+
+  if ( (0 == pos->num_connects) &&
+       (0 == pos->greylist_backoff.rel_value_us) )
+    return GNUNET_YES; /* nothing learned about this peer */
+  if ( (GNUNET_OK !=
+        GNUNET_BIO_write (wh,
+                          pid,
+                          sizeof (struct GNUNET_PeerIdentity))) ||
+       (GNUNET_OK !=
+        GNUNET_BIO_write_int32 (wh, (int32_t) pos->num_connects)) ||
+       (GNUNET_OK !=
+        GNUNET_BIO_write_int64 (wh,
+                                (int64_t) pos->greylist_backoff.rel_value_us)) )
+    return GNUNET_NO;
+  return GNUNET_YES;
+}
+
+
+/**
+ * Write what we learned about our peers to the quality file
+ * (if configured), so that it survives the next restart.
+ */
+static void
+write_quality_file ()
+{
+  struct GNUNET_BIO_WriteHandle *wh;
+  char *fn;
+
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_filename (cfg,
+                                               "TOPOLOGY",
+                                               "QUALITYFILE",
+                                               &fn))
+    return; /* persistence not configured */
+  wh = GNUNET_BIO_write_open (fn);
+  if (NULL == wh)
+  {
+    GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_WARNING,
+                              "open",
+                              fn);
+    GNUNET_free (fn);
+    return;
+  }
+  GNUNET_CONTAINER_multipeermap_iterate (peers,
+                                         &write_quality_entry,
+                                         wh);
+  if (GNUNET_OK != GNUNET_BIO_write_close (wh))
+    GNUNET_log_strerror_file (GNUNET_ERROR_TYPE_WARNING,
+                              "write",
+                              fn);
+  GNUNET_free (fn);
+}
+
+
 /**
  * This function is called whenever an encrypted HELLO message is
  * received.
@@ -1160,6 +1344,7 @@ cleaning_task (void *cls,
     GNUNET_SCHEDULER_cancel (add_task);
     add_task = NULL;
   }
+  write_quality_file ();
   GNUNET_CONTAINER_multipeermap_iterate (peers,
                                          &free_peer,
                                          NULL);
@@ -1221,6 +1406,7 @@ run (void *cls,
   peers = GNUNET_CONTAINER_multipeermap_create (target_connection_count * 2,
                                                 GNUNET_NO);
   read_friends_file (cfg);
+  read_quality_file ();
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "Topology would like %u connections with at least %u friends\n",
               target_connection_count,
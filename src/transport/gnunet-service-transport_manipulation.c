@@ -166,6 +166,29 @@ static struct DelayQueueEntry *generic_dqe_tail;
  */
 static struct GNUNET_SCHEDULER_Task *generic_send_delay_task;
 
+/**
+ * #GNUNET_YES if any manipulation is configured at all.  While this
+ * is #GNUNET_NO (the common case outside of testing), the
+ * interposition functions pass messages through without even doing
+ * the peer map lookup.
+ */
+static int manipulation_active;
+
+
+/**
+ * Update #manipulation_active after the settings changed.
+ */
+static void
+update_manipulation_active ()
+{
+  manipulation_active
+    = ( (0 != delay_in.rel_value_us) ||
+        (0 != delay_out.rel_value_us) ||
+        (0 < GNUNET_CONTAINER_multipeermap_size (peers)) )
+    ? GNUNET_YES
+    : GNUNET_NO;
+}
+
 
 /**
  * Set traffic metric to manipulate
@@ -192,6 +215,7 @@ GST_manipulation_set_metric (void *cls,
                 "Received traffic metrics for all peers\n");
     delay_in = GNUNET_TIME_relative_ntoh (tm->delay_in);
     delay_out = GNUNET_TIME_relative_ntoh (tm->delay_out);
+    update_manipulation_active ();
     GNUNET_SERVER_receive_done (client,
                                 GNUNET_OK);
     return;
@@ -214,6 +238,7 @@ GST_manipulation_set_metric (void *cls,
                               &tm->properties);
   tmp->delay_in = GNUNET_TIME_relative_ntoh (tm->delay_in);
   tmp->delay_out = GNUNET_TIME_relative_ntoh (tm->delay_out);
+  update_manipulation_active ();
   GNUNET_SERVER_receive_done (client,
                               GNUNET_OK);
 }
@@ -302,6 +327,16 @@ GST_manipulation_send (const struct GNUNET_PeerIdentity *target,
   struct DelayQueueEntry *dqe;
   struct GNUNET_TIME_Relative delay;
 
+  if (GNUNET_NO == manipulation_active)
+  {
+    /* Fast path: nothing is manipulated */
+    GST_neighbours_send (target,
+                         msg,
+                         msg_size,
+                         timeout,
+                         cont, cont_cls);
+    return;
+  }
   if (NULL != (tmp =
                GNUNET_CONTAINER_multipeermap_get (peers,
                                                   target)))
@@ -375,6 +410,8 @@ GST_manipulation_manipulate_metrics (const struct GNUNET_HELLO_Address *address,
   const struct GNUNET_PeerIdentity *peer = &address->peer;
   struct TM_Peer *tmp;
 
+  if (GNUNET_NO == manipulation_active)
+    return;
   tmp = GNUNET_CONTAINER_multipeermap_get (peers,
                                            peer);
   if (NULL != tmp)
@@ -402,6 +439,11 @@ GST_manipulation_recv (void *cls,
   struct GNUNET_TIME_Relative quota_delay;
   struct GNUNET_TIME_Relative m_delay;
 
+  if (GNUNET_NO == manipulation_active)
+    return GST_receive_callback (cls,
+                                 address,
+                                 session,
+                                 message);
   if (NULL !=
       (tmp = GNUNET_CONTAINER_multipeermap_get (peers,
                                                 &address->peer)))
@@ -460,6 +502,7 @@ GST_manipulation_init ()
   }
   peers = GNUNET_CONTAINER_multipeermap_create (4,
                                                 GNUNET_NO);
+  update_manipulation_active ();
 }
 
 
@@ -326,6 +326,19 @@ struct NeighbourAddress
 struct NeighbourMapEntry
 {
 
+  /**
+   * DLL of connected neighbours; we are in this list exactly
+   * while our state satisfies #GNUNET_TRANSPORT_is_connected(),
+   * so periodic maintenance can visit connected peers without
+   * scanning the full neighbour map.
+   */
+  struct NeighbourMapEntry *next;
+
+  /**
+   * DLL of connected neighbours.
+   */
+  struct NeighbourMapEntry *prev;
+
   /**
    * Head of list of messages we would like to send to this peer;
    * must contain at most one message per client.
@@ -481,6 +494,16 @@ static struct BlacklistCheckSwitchContext *pending_bc_tail;
  */
 static unsigned int neighbours_connected;
 
+/**
+ * Head of DLL of connected neighbours.
+ */
+static struct NeighbourMapEntry *connected_n_head;
+
+/**
+ * Tail of DLL of connected neighbours.
+ */
+static struct NeighbourMapEntry *connected_n_tail;
+
 /**
  * Number of bytes we have currently queued for transmission.
  */
@@ -717,6 +740,9 @@ set_state_and_timeout (struct NeighbourMapEntry *n,
   if (GNUNET_TRANSPORT_is_connected (s) &&
       ! GNUNET_TRANSPORT_is_connected (n->state) )
   {
+    GNUNET_CONTAINER_DLL_insert (connected_n_head,
+                                 connected_n_tail,
+                                 n);
     neighbours_connect_notification (n);
     GNUNET_STATISTICS_set (GST_stats,
 			   gettext_noop ("# peers connected"),
@@ -726,6 +752,9 @@ set_state_and_timeout (struct NeighbourMapEntry *n,
   if (! GNUNET_TRANSPORT_is_connected (s) &&
         GNUNET_TRANSPORT_is_connected (n->state) )
   {
+    GNUNET_CONTAINER_DLL_remove (connected_n_head,
+                                 connected_n_tail,
+                                 n);
     GNUNET_STATISTICS_set (GST_stats,
 			   gettext_noop ("# peers connected"),
 			   --neighbours_connected,
@@ -2766,26 +2795,19 @@ GST_neighbours_switch_to_address (const struct GNUNET_HELLO_Address *address,
 
 /**
  * Function called to send network utilization data to ATS for
- * each active connection.
+ * one active connection.
  *
- * @param cls NULL
- * @param key peer we send utilization data for
- * @param value the `struct NeighbourMapEntry *` with data to send
- * @return #GNUNET_OK (continue to iterate)
+ * @param n the connected neighbour to send utilization data for
  */
-static int
-send_utilization_data (void *cls,
-                       const struct GNUNET_PeerIdentity *key,
-                       void *value)
+static void
+send_utilization_data (struct NeighbourMapEntry *n)
 {
-  struct NeighbourMapEntry *n = value;
   uint32_t bps_in;
   uint32_t bps_out;
   struct GNUNET_TIME_Relative delta;
 
-  if ( (GNUNET_YES != test_connected (n)) ||
-       (NULL == n->primary_address.address) )
-    return GNUNET_OK;
+  if (NULL == n->primary_address.address)
+    return;
   delta = GNUNET_TIME_absolute_get_difference (n->last_util_transmission,
                                                GNUNET_TIME_absolute_get ());
   bps_in = 0;
@@ -2797,7 +2819,7 @@ send_utilization_data (void *cls,
 
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
               "`%s' total: received %u Bytes/s, sent %u Bytes/s\n",
-              GNUNET_i2s (key),
+              GNUNET_i2s (&n->id),
               bps_in,
               bps_out);
   GST_ats_update_utilization (n->primary_address.address,
@@ -2806,12 +2828,14 @@ send_utilization_data (void *cls,
   n->util_total_bytes_recv = 0;
   n->util_total_bytes_sent = 0;
   n->last_util_transmission = GNUNET_TIME_absolute_get ();
-  return GNUNET_OK;
 }
 
 
 /**
- * Task transmitting utilization in a regular interval
+ * Task transmitting utilization in a regular interval.
+ * Only walks the list of connected neighbours, so the cost
+ * is proportional to the number of active connections and
+ * not to the total size of the neighbour map.
  *
  * @param cls the 'struct NeighbourMapEntry' for which we are running
  * @param tc scheduler context (unused)
@@ -2820,10 +2844,11 @@ static void
 utilization_transmission (void *cls,
                           const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
+  struct NeighbourMapEntry *n;
+
   util_transmission_tk = NULL;
-  GNUNET_CONTAINER_multipeermap_iterate (neighbours,
-                                         &send_utilization_data,
-                                         NULL);
+  for (n = connected_n_head; NULL != n; n = n->next)
+    send_utilization_data (n);
   util_transmission_tk
     = GNUNET_SCHEDULER_add_delayed (UTIL_TRANSMISSION_INTERVAL,
                                     &utilization_transmission,
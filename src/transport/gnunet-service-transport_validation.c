@@ -69,6 +69,14 @@
  */
 #define VALIDATED_PING_FREQUENCY GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 15)
 
+/**
+ * Upper bound on the PING frequency for addresses that keep
+ * re-validating successfully; we exponentially back off stable
+ * addresses from #VALIDATED_PING_FREQUENCY up to this value.
+ * Must still be (significantly) smaller than HELLO_ADDRESS_EXPIRATION.
+ */
+#define VALIDATED_PING_FREQUENCY_MAX GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_HOURS, 2)
+
 /**
  * How often do we PING an address that we are currently using?
  */
@@ -200,9 +208,11 @@ struct ValidationEntry
   struct GNUNET_SCHEDULER_Task *timeout_task;
 
   /**
-   * ID of task that will trigger address revalidation.
+   * Our position in the revalidation heap (ordered by
+   * @e next_validation), NULL if we are not scheduled for
+   * revalidation.
    */
-  struct GNUNET_SCHEDULER_Task *revalidation_task;
+  struct GNUNET_CONTAINER_HeapNode *rev_hn;
 
   /**
    * At what time did we send the latest validation request (PING)?
@@ -271,6 +281,14 @@ struct ValidationEntry
    */
   int known_to_ats;
 
+  /**
+   * How often in a row did we successfully re-validate this
+   * address without it changing?  Used to exponentially back
+   * off PINGs to stable addresses; reset when we start using
+   * the address.
+   */
+  unsigned int successful_validations;
+
   /**
    * Which network type does our address belong to?
    */
@@ -312,6 +330,18 @@ static unsigned int validations_fast_start_threshold;
  */
 static struct GNUNET_TIME_Absolute validation_next;
 
+/**
+ * Heap with all validation entries that are scheduled for
+ * revalidation, ordered by their next validation deadline.
+ */
+static struct GNUNET_CONTAINER_Heap *revalidation_heap;
+
+/**
+ * Single task driving all revalidations; runs every entry
+ * from the #revalidation_heap whose deadline has passed.
+ */
+static struct GNUNET_SCHEDULER_Task *revalidation_task;
+
 
 /**
  * Context for the validation entry match function.
@@ -439,10 +469,10 @@ cleanup_validation_entry (void *cls,
     GNUNET_SCHEDULER_cancel (ve->timeout_task);
     ve->timeout_task = NULL;
   }
-  if (NULL != ve->revalidation_task)
+  if (NULL != ve->rev_hn)
   {
-    GNUNET_SCHEDULER_cancel (ve->revalidation_task);
-    ve->revalidation_task = NULL;
+    GNUNET_CONTAINER_heap_remove_node (ve->rev_hn);
+    ve->rev_hn = NULL;
   }
   if ( (GNUNET_YES == ve->expecting_pong) &&
        (validations_running > 0) )
@@ -649,30 +679,94 @@ transmit_ping_if_allowed (void *cls,
 
 
 /**
- * Do address validation again to keep address valid.
+ * Task running all revalidations whose deadline has passed.
  *
- * @param cls the `struct ValidationEntry`
+ * @param cls NULL
  * @param tc scheduler context (unused)
  */
 static void
-revalidate_address (void *cls,
-                    const struct GNUNET_SCHEDULER_TaskContext *tc)
+revalidation_run (void *cls,
+                  const struct GNUNET_SCHEDULER_TaskContext *tc);
+
+
+/**
+ * (Re)arm the #revalidation_task for the earliest deadline
+ * on the #revalidation_heap (if any).
+ */
+static void
+update_revalidation_task ()
+{
+  struct ValidationEntry *ve;
+
+  if (NULL != revalidation_task)
+  {
+    GNUNET_SCHEDULER_cancel (revalidation_task);
+    revalidation_task = NULL;
+  }
+  ve = GNUNET_CONTAINER_heap_peek (revalidation_heap);
+  if (NULL == ve)
+    return;
+  revalidation_task =
+      GNUNET_SCHEDULER_add_delayed (GNUNET_TIME_absolute_get_remaining (ve->next_validation),
+                                    &revalidation_run,
+                                    NULL);
+}
+
+
+/**
+ * Schedule the next validation of the given entry in @a delay,
+ * (re)positioning it on the #revalidation_heap.  Entries with the
+ * same deadline share a single wakeup of the #revalidation_task
+ * this way.
+ *
+ * @param ve validation entry to schedule
+ * @param delay delay until the next validation
+ */
+static void
+schedule_revalidation (struct ValidationEntry *ve,
+                       struct GNUNET_TIME_Relative delay)
+{
+  ve->next_validation = GNUNET_TIME_relative_to_absolute (delay);
+  if (NULL == ve->rev_hn)
+    ve->rev_hn = GNUNET_CONTAINER_heap_insert (revalidation_heap,
+                                               ve,
+                                               ve->next_validation.abs_value_us);
+  else
+    GNUNET_CONTAINER_heap_update_cost (revalidation_heap,
+                                       ve->rev_hn,
+                                       ve->next_validation.abs_value_us);
+  update_revalidation_task ();
+}
+
+
+/**
+ * Do address validation again to keep address valid.
+ *
+ * @param ve the `struct ValidationEntry` to revalidate
+ */
+static void
+revalidate_address (struct ValidationEntry *ve)
 {
-  struct ValidationEntry *ve = cls;
   struct GNUNET_TIME_Relative canonical_delay;
   struct GNUNET_TIME_Relative delay;
   struct GNUNET_TIME_Relative blocked_for;
   struct GST_BlacklistCheck *bc;
   uint32_t rdelay;
 
-  ve->revalidation_task = NULL;
   delay = GNUNET_TIME_absolute_get_remaining (ve->revalidation_block);
   /* Considering current connectivity situation, what is the maximum
      block period permitted? */
   if (GNUNET_YES == ve->in_use)
     canonical_delay = CONNECTED_PING_FREQUENCY;
   else if (GNUNET_TIME_absolute_get_remaining (ve->valid_until).rel_value_us > 0)
-    canonical_delay = VALIDATED_PING_FREQUENCY;
+    /* exponentially back off addresses that keep re-validating
+       without change; most of them remain stable for weeks and
+       do not need a PING every #VALIDATED_PING_FREQUENCY */
+    canonical_delay
+        = GNUNET_TIME_relative_min (GNUNET_TIME_relative_multiply (VALIDATED_PING_FREQUENCY,
+                                                                   1 << GNUNET_MIN (ve->successful_validations,
+                                                                                    8)),
+                                    VALIDATED_PING_FREQUENCY_MAX);
   else
     canonical_delay = UNVALIDATED_PING_KEEPALIVE;
   /* Use delay that is MIN of original delay and possibly adjusted
@@ -691,10 +785,8 @@ revalidate_address (void *cls,
                 GNUNET_STRINGS_relative_time_to_string (delay,
                                                         GNUNET_YES),
                 GST_plugins_a2s (ve->address));
-    ve->revalidation_task =
-        GNUNET_SCHEDULER_add_delayed (delay,
-                                      &revalidate_address, ve);
-    ve->next_validation = GNUNET_TIME_relative_to_absolute (delay);
+    schedule_revalidation (ve,
+                           delay);
     return;
   }
   /* check if globally we have too many active validations at a
@@ -713,11 +805,8 @@ revalidate_address (void *cls,
                               gettext_noop ("# validations delayed by global throttle"),
                               1,
                               GNUNET_NO);
-    ve->revalidation_task =
-      GNUNET_SCHEDULER_add_delayed (blocked_for,
-                                    &revalidate_address,
-                                    ve);
-    ve->next_validation = GNUNET_TIME_relative_to_absolute (blocked_for);
+    schedule_revalidation (ve,
+                           blocked_for);
     return;
   }
 
@@ -739,11 +828,8 @@ revalidate_address (void *cls,
               GNUNET_STRINGS_relative_time_to_string (blocked_for,
                                                       GNUNET_YES),
               GST_plugins_a2s (ve->address));
-  ve->revalidation_task =
-      GNUNET_SCHEDULER_add_delayed (delay,
-                                    &revalidate_address,
-                                    ve);
-  ve->next_validation = GNUNET_TIME_relative_to_absolute (delay);
+  schedule_revalidation (ve,
+                         delay);
 
   /* start PINGing by checking blacklist */
   GNUNET_STATISTICS_update (GST_stats,
@@ -761,6 +847,31 @@ revalidate_address (void *cls,
 }
 
 
+/**
+ * Task running all revalidations whose deadline has passed.
+ * Batches all same-deadline validations into this one wakeup.
+ *
+ * @param cls NULL
+ * @param tc scheduler context (unused)
+ */
+static void
+revalidation_run (void *cls,
+                  const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  struct ValidationEntry *ve;
+
+  revalidation_task = NULL;
+  while ( (NULL != (ve = GNUNET_CONTAINER_heap_peek (revalidation_heap))) &&
+          (0 == GNUNET_TIME_absolute_get_remaining (ve->next_validation).rel_value_us) )
+  {
+    GNUNET_assert (ve == GNUNET_CONTAINER_heap_remove_root (revalidation_heap));
+    ve->rev_hn = NULL;
+    revalidate_address (ve);
+  }
+  update_revalidation_task ();
+}
+
+
 /**
  * Find a ValidationEntry entry for the given neighbour that matches
  * the given address and transport.  If none exists, create one (but
@@ -866,13 +977,13 @@ add_valid_address (void *cls,
   GNUNET_break (GNUNET_ATS_NET_UNSPECIFIED != ve->network);
   ve->valid_until = GNUNET_TIME_absolute_max (ve->valid_until,
                                               expiration);
-  if (NULL == ve->revalidation_task)
+  if (NULL == ve->rev_hn)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
                 "Starting revalidations for valid address `%s'\n",
                 GST_plugins_a2s (ve->address));
-    ve->next_validation = GNUNET_TIME_absolute_get();
-    ve->revalidation_task = GNUNET_SCHEDULER_add_now (&revalidate_address, ve);
+    schedule_revalidation (ve,
+                           GNUNET_TIME_UNIT_ZERO);
   }
   validation_entry_changed (ve,
                             GNUNET_TRANSPORT_VS_UPDATE);
@@ -961,6 +1072,7 @@ GST_validation_start (unsigned int max_fds)
                                                       GNUNET_YES));
   validation_map = GNUNET_CONTAINER_multipeermap_create (VALIDATION_MAP_SIZE,
 							 GNUNET_NO);
+  revalidation_heap = GNUNET_CONTAINER_heap_create (GNUNET_CONTAINER_HEAP_ORDER_MIN);
   pnc = GNUNET_PEERINFO_notify (GST_cfg, GNUNET_YES,
                                 &process_peerinfo_hello, NULL);
 }
@@ -972,11 +1084,18 @@ GST_validation_start (unsigned int max_fds)
 void
 GST_validation_stop ()
 {
+  if (NULL != revalidation_task)
+  {
+    GNUNET_SCHEDULER_cancel (revalidation_task);
+    revalidation_task = NULL;
+  }
   GNUNET_CONTAINER_multipeermap_iterate (validation_map,
                                          &cleanup_validation_entry,
                                          NULL);
   GNUNET_CONTAINER_multipeermap_destroy (validation_map);
   validation_map = NULL;
+  GNUNET_CONTAINER_heap_destroy (revalidation_heap);
+  revalidation_heap = NULL;
   GNUNET_PEERINFO_notify_cancel (pnc);
 }
 
@@ -1307,13 +1426,14 @@ GST_validation_handle_address (const struct GNUNET_HELLO_Address *address)
     return;
   }
   ve = find_validation_entry (address);
-  if (NULL == ve->revalidation_task)
+  if (NULL == ve->rev_hn)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_INFO,
                 "Validation process started for fresh address `%s' of %s\n",
                 GST_plugins_a2s (ve->address),
                 GNUNET_i2s (&ve->address->peer));
-    ve->revalidation_task = GNUNET_SCHEDULER_add_now (&revalidate_address, ve);
+    schedule_revalidation (ve,
+                           GNUNET_TIME_UNIT_ZERO);
   }
 }
 
@@ -1525,6 +1645,7 @@ GST_validation_handle_pong (const struct GNUNET_PeerIdentity *sender,
   ve->pong_sig_cache = pong->signature;
   ve->pong_sig_valid_until = GNUNET_TIME_absolute_ntoh (pong->expiration);
   ve->latency = GNUNET_TIME_absolute_get_duration (ve->send_time);
+  ve->successful_validations++;
   {
     if (GNUNET_YES == ve->known_to_ats)
     {
@@ -1730,10 +1851,9 @@ GST_validation_set_address_use (const struct GNUNET_HELLO_Address *address,
   if (GNUNET_YES == in_use)
   {
     /* from now on, higher frequeny, so reschedule now */
-    if (NULL != ve->revalidation_task)
-      GNUNET_SCHEDULER_cancel (ve->revalidation_task);
-    ve->revalidation_task = GNUNET_SCHEDULER_add_now (&revalidate_address,
-                                                      ve);
+    ve->successful_validations = 0;
+    schedule_revalidation (ve,
+                           GNUNET_TIME_UNIT_ZERO);
   }
 }
 
@@ -0,0 +1,706 @@
+/*
+ This file is part of GNUnet.
+ Copyright (C) 2015 Christian Grothoff (and other contributing authors)
+
+ GNUnet is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published
+ by the Free Software Foundation; either version 3, or (at your
+ option) any later version.
+
+ GNUnet is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with GNUnet; see the file COPYING.  If not, write to the
+ Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+ */
+/**
+ * @file transport/perf_plugin_transport.c
+ * @brief benchmark for a single transport plugin in isolation
+ *
+ * Loads one transport plugin twice within this process, with two
+ * distinct peer identities, and sends message bursts of increasing
+ * sizes from the first instance to the second over the plugin's
+ * own loopback connection.  This measures the cost of the plugin
+ * alone - framing, socket handling, tokenizing - without neighbour
+ * management, ATS or core in the way, which the end-to-end
+ * gnunet-transport-profiler cannot separate out.
+ *
+ * Reported per message size: wall clock per message, user and
+ * system CPU per message (both endpoints combined, as they share
+ * this process) and bytes on the wire versus payload bytes.
+ */
+#include "platform.h"
+#include "gnunet_util_lib.h"
+#include "gnunet_hello_lib.h"
+#include "gnunet_statistics_service.h"
+#include "gnunet_protocols.h"
+#include "gnunet_transport_plugin.h"
+#include "transport.h"
+
+/**
+ * How long until we give up on the whole benchmark?
+ */
+#define TIMEOUT GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_SECONDS, 120)
+
+/**
+ * Message type used for the benchmark payload.
+ */
+#define PERF_MESSAGE_TYPE 12345
+
+/**
+ * How many messages to send per message size.
+ */
+#define MESSAGES_PER_SIZE 1024
+
+/**
+ * Payload sizes to sweep, including the message header.
+ */
+static const uint16_t perf_sizes[] = { 64, 256, 1024, 4096, 16384 };
+
+
+/**
+ * One endpoint of the benchmark: a plugin instance with
+ * its own identity and configuration.
+ */
+struct PerfEndpoint
+{
+  /**
+   * Identity of this endpoint.
+   */
+  struct GNUNET_PeerIdentity identity;
+
+  /**
+   * Private key of this endpoint.
+   */
+  struct GNUNET_CRYPTO_EddsaPrivateKey *private_key;
+
+  /**
+   * Configuration for this endpoint's plugin instance.
+   */
+  struct GNUNET_CONFIGURATION_Handle *cfg;
+
+  /**
+   * Plugin environment for this endpoint.
+   */
+  struct GNUNET_TRANSPORT_PluginEnvironment env;
+
+  /**
+   * API of the loaded plugin instance.
+   */
+  struct GNUNET_TRANSPORT_PluginFunctions *api;
+};
+
+/**
+ * The sending endpoint.
+ */
+static struct PerfEndpoint sender;
+
+/**
+ * The receiving endpoint.
+ */
+static struct PerfEndpoint receiver;
+
+/**
+ * Empty HELLO handed to the plugins on request.
+ */
+static struct GNUNET_HELLO_Message *hello;
+
+/**
+ * Handle for statistics (shared by both endpoints).
+ */
+static struct GNUNET_STATISTICS_Handle *stats;
+
+/**
+ * Library name of the plugin under test.
+ */
+static char *libname;
+
+/**
+ * Address under which the receiver is reachable.
+ */
+static struct GNUNET_HELLO_Address *receiver_address;
+
+/**
+ * Session from the sender to the receiver.
+ */
+static struct GNUNET_ATS_Session *session;
+
+/**
+ * Global timeout task.
+ */
+static struct GNUNET_SCHEDULER_Task *timeout_task;
+
+/**
+ * Task to start the benchmark once the receiver has an address.
+ */
+static struct GNUNET_SCHEDULER_Task *start_task;
+
+/**
+ * Index into #perf_sizes of the current round.
+ */
+static unsigned int size_idx;
+
+/**
+ * Number of messages received in the current round.
+ */
+static unsigned int msgs_recv;
+
+/**
+ * Number of failed transmissions in the current round.
+ */
+static unsigned int msgs_failed;
+
+/**
+ * Sum of bytes put on the wire in the current round.
+ */
+static unsigned long long wire_bytes;
+
+/**
+ * Wall clock at the start of the current round.
+ */
+static struct GNUNET_TIME_Absolute round_start;
+
+/**
+ * Resource usage at the start of the current round.
+ */
+static struct rusage round_rusage;
+
+/**
+ * Buffer holding the message we transmit.
+ */
+static char perf_buf[65536];
+
+/**
+ * Did the benchmark pass?
+ */
+static int ok;
+
+
+static void
+start_round (void);
+
+
+/**
+ * Shut down cleanly.
+ */
+static void
+end ()
+{
+  if (NULL != timeout_task)
+  {
+    GNUNET_SCHEDULER_cancel (timeout_task);
+    timeout_task = NULL;
+  }
+  if (NULL != start_task)
+  {
+    GNUNET_SCHEDULER_cancel (start_task);
+    start_task = NULL;
+  }
+  if ( (NULL != session) &&
+       (NULL != sender.api) )
+    sender.api->disconnect_session (sender.api->cls,
+                                    session);
+  session = NULL;
+  if (NULL != sender.api)
+  {
+    GNUNET_PLUGIN_unload (libname, sender.api);
+    sender.api = NULL;
+  }
+  if (NULL != receiver.api)
+  {
+    GNUNET_PLUGIN_unload (libname, receiver.api);
+    receiver.api = NULL;
+  }
+  if (NULL != receiver_address)
+  {
+    GNUNET_HELLO_address_free (receiver_address);
+    receiver_address = NULL;
+  }
+  if (NULL != receiver.cfg)
+  {
+    GNUNET_CONFIGURATION_destroy (receiver.cfg);
+    receiver.cfg = NULL;
+  }
+  GNUNET_free_non_null (sender.private_key);
+  GNUNET_free_non_null (receiver.private_key);
+  GNUNET_free_non_null (hello);
+  GNUNET_free_non_null (libname);
+  libname = NULL;
+  if (NULL != stats)
+  {
+    GNUNET_STATISTICS_destroy (stats, GNUNET_NO);
+    stats = NULL;
+  }
+}
+
+
+/**
+ * Abort the benchmark.
+ *
+ * @param cls NULL
+ * @param tc scheduler context
+ */
+static void
+end_badly (void *cls,
+           const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  timeout_task = NULL;
+  GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+              "Benchmark did not complete, aborting\n");
+  ok = 1;
+  end ();
+}
+
+
+/**
+ * Report the results of the completed round and start the
+ * next one (or finish).
+ */
+static void
+finish_round ()
+{
+  struct rusage ru;
+  struct GNUNET_TIME_Relative wall;
+  unsigned long long cpu_us;
+  uint16_t size = perf_sizes[size_idx];
+
+  wall = GNUNET_TIME_absolute_get_duration (round_start);
+  if (0 != getrusage (RUSAGE_SELF, &ru))
+    memset (&ru, 0, sizeof (ru));
+  cpu_us = 1000000LL * (ru.ru_utime.tv_sec - round_rusage.ru_utime.tv_sec)
+      + (ru.ru_utime.tv_usec - round_rusage.ru_utime.tv_usec)
+      + 1000000LL * (ru.ru_stime.tv_sec - round_rusage.ru_stime.tv_sec)
+      + (ru.ru_stime.tv_usec - round_rusage.ru_stime.tv_usec);
+
+  FPRINTF (stdout,
+           "%u byte messages: %u sent, %u failed, "
+           "%.2f us wall/msg, %.2f us cpu/msg, %.2f bytes wire/msg\n",
+           (unsigned int) size,
+           msgs_recv,
+           msgs_failed,
+           (double) wall.rel_value_us / MESSAGES_PER_SIZE,
+           (double) cpu_us / MESSAGES_PER_SIZE,
+           (double) wire_bytes / MESSAGES_PER_SIZE);
+  size_idx++;
+  if (size_idx < (sizeof (perf_sizes) / sizeof (perf_sizes[0])))
+  {
+    start_round ();
+    return;
+  }
+  ok = 0;
+  end ();
+}
+
+
+/**
+ * Continuation called by the plugin once a message was
+ * transmitted (or failed).
+ *
+ * @param cls NULL
+ * @param target recipient of the message
+ * @param result #GNUNET_OK on success
+ * @param size_payload bytes of payload transmitted
+ * @param size_on_wire bytes used on the wire
+ */
+static void
+send_cont (void *cls,
+           const struct GNUNET_PeerIdentity *target,
+           int result,
+           size_t size_payload,
+           size_t size_on_wire)
+{
+  if (GNUNET_OK != result)
+  {
+    msgs_failed++;
+    if (MESSAGES_PER_SIZE == msgs_recv + msgs_failed)
+      finish_round ();
+    return;
+  }
+  wire_bytes += size_on_wire;
+}
+
+
+/**
+ * Start the next round: send #MESSAGES_PER_SIZE messages of
+ * the current size.
+ */
+static void
+start_round ()
+{
+  struct GNUNET_MessageHeader *hdr;
+  uint16_t size = perf_sizes[size_idx];
+  unsigned int i;
+
+  msgs_recv = 0;
+  msgs_failed = 0;
+  wire_bytes = 0;
+  hdr = (struct GNUNET_MessageHeader *) perf_buf;
+  hdr->size = htons (size);
+  hdr->type = htons (PERF_MESSAGE_TYPE);
+  round_start = GNUNET_TIME_absolute_get ();
+  if (0 != getrusage (RUSAGE_SELF, &round_rusage))
+    memset (&round_rusage, 0, sizeof (round_rusage));
+  for (i = 0; i < MESSAGES_PER_SIZE; i++)
+  {
+    if (-1 == sender.api->send (sender.api->cls,
+                                session,
+                                perf_buf,
+                                size,
+                                0,
+                                TIMEOUT,
+                                &send_cont,
+                                NULL))
+    {
+      GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                  "Plugin rejected transmission\n");
+      ok = 1;
+      end ();
+      return;
+    }
+  }
+}
+
+
+/**
+ * The receiver's address is known; open the loopback session
+ * and start the first round.
+ *
+ * @param cls NULL
+ * @param tc scheduler context
+ */
+static void
+start_benchmark (void *cls,
+                 const struct GNUNET_SCHEDULER_TaskContext *tc)
+{
+  start_task = NULL;
+  session = sender.api->get_session (sender.api->cls,
+                                     receiver_address);
+  if (NULL == session)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                "Failed to create loopback session\n");
+    ok = 1;
+    end ();
+    return;
+  }
+  FPRINTF (stdout,
+           "Benchmarking `%s' with %u messages per size\n",
+           libname,
+           MESSAGES_PER_SIZE);
+  start_round ();
+}
+
+
+/**
+ * Message arrived at the receiving endpoint.
+ *
+ * @param cls the receiving `struct PerfEndpoint`
+ * @param address address the message came from
+ * @param session session the message arrived on
+ * @param message the message
+ * @return time to wait before receiving more
+ */
+static struct GNUNET_TIME_Relative
+env_receive (void *cls,
+             const struct GNUNET_HELLO_Address *address,
+             struct GNUNET_ATS_Session *session,
+             const struct GNUNET_MessageHeader *message)
+{
+  if (PERF_MESSAGE_TYPE == ntohs (message->type))
+  {
+    msgs_recv++;
+    if (MESSAGES_PER_SIZE == msgs_recv + msgs_failed)
+      finish_round ();
+  }
+  return GNUNET_TIME_relative_get_zero_ ();
+}
+
+
+/**
+ * Plugin reported an address.  We only care about the
+ * receiver's addresses, the first of which starts the benchmark.
+ *
+ * @param cls the `struct PerfEndpoint` reporting
+ * @param add_remove #GNUNET_YES to add, #GNUNET_NO to remove
+ * @param address the address
+ */
+static void
+env_notify_address (void *cls,
+                    int add_remove,
+                    const struct GNUNET_HELLO_Address *address)
+{
+  struct PerfEndpoint *ep = cls;
+
+  if (GNUNET_YES != add_remove)
+    return;
+  if (ep != &receiver)
+    return;
+  if (NULL != receiver_address)
+    return;
+  receiver_address = GNUNET_HELLO_address_copy (address);
+  start_task = GNUNET_SCHEDULER_add_now (&start_benchmark,
+                                         NULL);
+}
+
+
+/**
+ * Provide the network type for an address.
+ *
+ * @param cls the `struct PerfEndpoint`
+ * @param addr the address
+ * @param addrlen length of @a addr
+ * @return loopback, always
+ */
+static enum GNUNET_ATS_Network_Type
+env_get_address_type (void *cls,
+                      const struct sockaddr *addr,
+                      size_t addrlen)
+{
+  return GNUNET_ATS_NET_LOOPBACK;
+}
+
+
+/**
+ * Provide our HELLO to the plugin.
+ *
+ * @return the (empty) HELLO
+ */
+static const struct GNUNET_MessageHeader *
+env_get_our_hello ()
+{
+  return (const struct GNUNET_MessageHeader *) hello;
+}
+
+
+/**
+ * A session ended.  If it was our benchmark session, abort.
+ *
+ * @param cls the `struct PerfEndpoint`
+ * @param address address of the session
+ * @param s the session
+ */
+static void
+env_session_end (void *cls,
+                 const struct GNUNET_HELLO_Address *address,
+                 struct GNUNET_ATS_Session *s)
+{
+  if (s == session)
+  {
+    session = NULL;
+    GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                "Benchmark session died unexpectedly\n");
+    ok = 1;
+    end ();
+  }
+}
+
+
+/**
+ * An incoming session started; nothing to do.
+ *
+ * @param cls the `struct PerfEndpoint`
+ * @param address address of the session
+ * @param s the session
+ * @param net network type
+ */
+static void
+env_session_start (void *cls,
+                   const struct GNUNET_HELLO_Address *address,
+                   struct GNUNET_ATS_Session *s,
+                   enum GNUNET_ATS_Network_Type net)
+{
+}
+
+
+/**
+ * Distance update; nothing to do.
+ *
+ * @param cls the `struct PerfEndpoint`
+ * @param address the address
+ * @param distance new distance
+ */
+static void
+env_update_distance (void *cls,
+                     const struct GNUNET_HELLO_Address *address,
+                     uint32_t distance)
+{
+}
+
+
+/**
+ * Fill in the plugin environment of @a ep.
+ *
+ * @param ep endpoint to set up
+ * @param cfg configuration for this endpoint
+ */
+static void
+setup_endpoint (struct PerfEndpoint *ep,
+                const struct GNUNET_CONFIGURATION_Handle *cfg)
+{
+  ep->private_key = GNUNET_CRYPTO_eddsa_key_create ();
+  GNUNET_assert (NULL != ep->private_key);
+  GNUNET_CRYPTO_eddsa_key_get_public (ep->private_key,
+                                      &ep->identity.public_key);
+  ep->env.cfg = cfg;
+  ep->env.cls = ep;
+  ep->env.my_identity = &ep->identity;
+  ep->env.max_connections = 10;
+  ep->env.stats = stats;
+  ep->env.receive = &env_receive;
+  ep->env.notify_address = &env_notify_address;
+  ep->env.get_address_type = &env_get_address_type;
+  ep->env.update_address_distance = &env_update_distance;
+  ep->env.get_our_hello = &env_get_our_hello;
+  ep->env.session_end = &env_session_end;
+  ep->env.session_start = &env_session_start;
+}
+
+
+/**
+ * Runs the benchmark.
+ *
+ * @param cls closure with the original argv
+ * @param args remaining arguments
+ * @param cfgfile configuration file name
+ * @param c configuration
+ */
+static void
+run (void *cls,
+     char * const *args,
+     const char *cfgfile,
+     const struct GNUNET_CONFIGURATION_Handle *c)
+{
+  char * const *argv = cls;
+  char *plugin;
+  char *sep;
+  char *section;
+  char *unixpath;
+  unsigned long long port;
+
+  timeout_task = GNUNET_SCHEDULER_add_delayed (TIMEOUT,
+                                               &end_badly,
+                                               NULL);
+  stats = GNUNET_STATISTICS_create ("transport", c);
+
+  GNUNET_assert (strlen (argv[0]) > strlen ("perf_plugin_"));
+  plugin = strstr (argv[0], "perf_plugin_");
+  sep = strrchr (argv[0], '.');
+  if (NULL == plugin)
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                "Not a valid benchmark name\n");
+    ok = 1;
+    end ();
+    return;
+  }
+  plugin += strlen ("perf_plugin_");
+  if (NULL != sep)
+    sep[0] = '\0';
+
+  setup_endpoint (&sender, c);
+  /* the receiver runs with a modified configuration so that both
+     plugin instances can bind within the same process */
+  receiver.cfg = GNUNET_CONFIGURATION_dup (c);
+  GNUNET_asprintf (&section,
+                   "transport-%s",
+                   plugin);
+  if (GNUNET_OK ==
+      GNUNET_CONFIGURATION_get_value_number (c,
+                                             section,
+                                             "PORT",
+                                             &port))
+    GNUNET_CONFIGURATION_set_value_number (receiver.cfg,
+                                           section,
+                                           "PORT",
+                                           port + 10);
+  if (GNUNET_OK ==
+      GNUNET_CONFIGURATION_get_value_string (c,
+                                             section,
+                                             "UNIXPATH",
+                                             &unixpath))
+  {
+    char *unixpath2;
+
+    GNUNET_asprintf (&unixpath2,
+                     "%s.2",
+                     unixpath);
+    GNUNET_CONFIGURATION_set_value_string (receiver.cfg,
+                                           section,
+                                           "UNIXPATH",
+                                           unixpath2);
+    GNUNET_free (unixpath2);
+    GNUNET_free (unixpath);
+  }
+  GNUNET_free (section);
+  setup_endpoint (&receiver, receiver.cfg);
+
+  hello = GNUNET_HELLO_create (&sender.identity.public_key,
+                               NULL,
+                               NULL,
+                               GNUNET_NO);
+
+  GNUNET_asprintf (&libname,
+                   "libgnunet_plugin_transport_%s",
+                   plugin);
+  sender.api = GNUNET_PLUGIN_load (libname,
+                                   &sender.env);
+  receiver.api = GNUNET_PLUGIN_load (libname,
+                                     &receiver.env);
+  if ( (NULL == sender.api) ||
+       (NULL == receiver.api) )
+  {
+    GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+                "Failed to load transport plugin for %s\n",
+                plugin);
+    ok = 1;
+    end ();
+    return;
+  }
+  /* benchmark starts once the receiver reports its address */
+}
+
+
+/**
+ * The main function of the benchmark.
+ *
+ * @param argc number of arguments from the command line
+ * @param argv command line arguments
+ * @return 0 ok, 1 on error
+ */
+int
+main (int argc,
+      char * const *argv)
+{
+  static struct GNUNET_GETOPT_CommandLineOption options[] = {
+    GNUNET_GETOPT_OPTION_END
+  };
+  char * const argv_prog[] = {
+    "perf_plugin_transport",
+    "-c",
+    "test_plugin_transport_data.conf",
+    NULL
+  };
+  int ret;
+
+  GNUNET_DISK_directory_remove ("/tmp/test-gnunetd-plugin-transport");
+  GNUNET_log_setup ("perf-plugin-transport",
+                    "WARNING",
+                    NULL);
+  ok = 1; /* set to fail */
+  ret = (GNUNET_OK ==
+         GNUNET_PROGRAM_run (3,
+                             argv_prog,
+                             "perf-plugin-transport",
+                             "benchmark",
+                             options,
+                             &run,
+                             (void *) argv)) ? ok : 1;
+  GNUNET_DISK_directory_remove ("/tmp/test-gnunetd-plugin-transport");
+  return ret;
+}
+
+/* end of perf_plugin_transport.c */
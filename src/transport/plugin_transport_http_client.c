@@ -146,9 +146,86 @@ struct HTTP_Message
    */
   size_t size;
 
+  /**
+   * Number of bytes the buffer following this struct can hold;
+   * used when recycling messages through the pool.
+   */
+  size_t buf_size;
+
 };
 
 
+/**
+ * Maximum number of retired messages we keep around for reuse;
+ * we allocate one (plus a payload copy) per send.
+ */
+#define MSG_POOL_MAX_FREE 64
+
+/**
+ * Head of the pool of free messages.
+ */
+static struct HTTP_Message *msg_pool_head;
+
+/**
+ * Number of messages in the pool.
+ */
+static unsigned int msg_pool_count;
+
+
+/**
+ * Get a message able to hold @a msgbuf_size payload bytes,
+ * from the pool if possible.
+ *
+ * @param msgbuf_size number of payload bytes required
+ * @return a zero'ed out message with @e buf set up
+ */
+static struct HTTP_Message *
+msg_alloc (size_t msgbuf_size)
+{
+  struct HTTP_Message *msg;
+
+  if ( (NULL != msg_pool_head) &&
+       (msg_pool_head->buf_size >= msgbuf_size) )
+  {
+    size_t buf_size;
+
+    msg = msg_pool_head;
+    msg_pool_head = msg->next;
+    msg_pool_count--;
+    buf_size = msg->buf_size;
+    memset (msg, 0, sizeof (struct HTTP_Message));
+    msg->buf_size = buf_size;
+  }
+  else
+  {
+    msg = GNUNET_malloc (sizeof (struct HTTP_Message) + msgbuf_size);
+    msg->buf_size = msgbuf_size;
+  }
+  msg->buf = (char *) &msg[1];
+  return msg;
+}
+
+
+/**
+ * Release a message, putting it back into the pool unless
+ * the pool is full.
+ *
+ * @param msg message to release
+ */
+static void
+msg_free (struct HTTP_Message *msg)
+{
+  if (msg_pool_count < MSG_POOL_MAX_FREE)
+  {
+    msg->next = msg_pool_head;
+    msg_pool_head = msg;
+    msg_pool_count++;
+    return;
+  }
+  GNUNET_free (msg);
+}
+
+
 /**
  * Session handle for HTTP(S) connections.
  */
@@ -519,7 +596,7 @@ client_delete_session (struct GNUNET_ATS_Session *s)
                           pos->size,
                           pos->pos + s->overhead);
     s->overhead = 0;
-    GNUNET_free (pos);
+    msg_free (pos);
   }
   GNUNET_assert (0 == s->msgs_in_queue);
   GNUNET_assert (0 == s->bytes_in_queue);
@@ -770,9 +847,8 @@ http_client_plugin_send (void *cls,
        GNUNET_i2s (&s->address->peer));
 
   /* create new message and schedule */
-  msg = GNUNET_malloc (sizeof (struct HTTP_Message) + msgbuf_size);
+  msg = msg_alloc (msgbuf_size);
   msg->size = msgbuf_size;
-  msg->buf = (char *) &msg[1];
   msg->transmit_cont = cont;
   msg->transmit_cont_cls = cont_cls;
   memcpy (msg->buf,
@@ -1099,7 +1175,7 @@ client_send_cb (void *stream,
                           msg->size,
                           msg->size + s->overhead);
     s->overhead = 0;
-    GNUNET_free (msg);
+    msg_free (msg);
   }
   notify_session_monitor (plugin,
                           s,
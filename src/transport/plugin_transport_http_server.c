@@ -2168,6 +2168,51 @@ server_load_certificate (struct HTTP_Server_Plugin *plugin)
 #endif
 
 
+/**
+ * Invoke `MHD_start_daemon` with the given flags and the
+ * various options we always need.
+ *
+ * @param plugin our plugin
+ * @param flags MHD daemon flags to use
+ * @param addr listen address to use
+ * @param timeout connection timeout to use (in seconds)
+ * @return NULL on error
+ */
+static struct MHD_Daemon *
+run_mhd_start_daemon_with_flags (struct HTTP_Server_Plugin *plugin,
+                                 unsigned int flags,
+                                 const struct sockaddr_in *addr,
+                                 unsigned int timeout)
+{
+  return MHD_start_daemon (flags,
+                           plugin->port,
+                           &server_accept_cb, plugin,
+                           &server_access_cb, plugin,
+                           MHD_OPTION_SOCK_ADDR,
+                           addr,
+                           MHD_OPTION_CONNECTION_LIMIT,
+                           (unsigned int) plugin->max_request,
+#if BUILD_HTTPS
+                           MHD_OPTION_HTTPS_PRIORITIES,
+                           plugin->crypto_init,
+                           MHD_OPTION_HTTPS_MEM_KEY,
+                           plugin->key,
+                           MHD_OPTION_HTTPS_MEM_CERT,
+                           plugin->cert,
+#endif
+                           MHD_OPTION_CONNECTION_TIMEOUT,
+                           timeout,
+                           MHD_OPTION_CONNECTION_MEMORY_LIMIT,
+                           (size_t) (2 *
+                                     GNUNET_SERVER_MAX_MESSAGE_SIZE),
+                           MHD_OPTION_NOTIFY_COMPLETED,
+                           &server_disconnect_cb, plugin,
+                           MHD_OPTION_EXTERNAL_LOGGER,
+                           &server_log, NULL,
+                           MHD_OPTION_END);
+}
+
+
 /**
  * Invoke `MHD_start_daemon` with the various options we need to
  * setup the HTTP server with the given listen address.
@@ -2183,6 +2228,7 @@ run_mhd_start_daemon (struct HTTP_Server_Plugin *plugin,
                       int v6)
 {
   struct MHD_Daemon *server;
+  unsigned int flags;
   unsigned int timeout;
 
 #if MHD_VERSION >= 0x00090E00
@@ -2196,40 +2242,35 @@ run_mhd_start_daemon (struct HTTP_Server_Plugin *plugin,
        "MHD cannot set timeout per connection! Default time out %u sec.\n",
        timeout);
 #endif
-  server = MHD_start_daemon (
+  flags =
 #if VERBOSE_SERVER
-                             MHD_USE_DEBUG |
+      MHD_USE_DEBUG |
 #endif
 #if BUILD_HTTPS
-                             MHD_USE_SSL |
+      MHD_USE_SSL |
 #endif
-                             MHD_USE_SUSPEND_RESUME |
-                             v6,
-                             plugin->port,
-                             &server_accept_cb, plugin,
-                             &server_access_cb, plugin,
-                             MHD_OPTION_SOCK_ADDR,
-                             addr,
-                             MHD_OPTION_CONNECTION_LIMIT,
-                             (unsigned int) plugin->max_request,
-#if BUILD_HTTPS
-                             MHD_OPTION_HTTPS_PRIORITIES,
-                             plugin->crypto_init,
-                             MHD_OPTION_HTTPS_MEM_KEY,
-                             plugin->key,
-                             MHD_OPTION_HTTPS_MEM_CERT,
-                             plugin->cert,
+      MHD_USE_SUSPEND_RESUME |
+      v6;
+  server = NULL;
+#if MHD_VERSION >= 0x00093400
+  /* With epoll, MHD_get_fdset() gives us a single FD to watch
+     instead of one per connection, so #server_schedule() no longer
+     rebuilds select sets proportional to the number of neighbours
+     on every wakeup.  Not available on all platforms, so fall back
+     to plain select if starting with epoll fails. */
+  server = run_mhd_start_daemon_with_flags (plugin,
+                                            flags | MHD_USE_EPOLL_LINUX_ONLY,
+                                            addr,
+                                            timeout);
+  if (NULL == server)
+    LOG (GNUNET_ERROR_TYPE_DEBUG,
+         "MHD refused to start with epoll, falling back to select\n");
 #endif
-                             MHD_OPTION_CONNECTION_TIMEOUT,
-                             timeout,
-                             MHD_OPTION_CONNECTION_MEMORY_LIMIT,
-                             (size_t) (2 *
-                                       GNUNET_SERVER_MAX_MESSAGE_SIZE),
-                             MHD_OPTION_NOTIFY_COMPLETED,
-                             &server_disconnect_cb, plugin,
-                             MHD_OPTION_EXTERNAL_LOGGER,
-                             &server_log, NULL,
-                             MHD_OPTION_END);
+  if (NULL == server)
+    server = run_mhd_start_daemon_with_flags (plugin,
+                                              flags,
+                                              addr,
+                                              timeout);
 #ifdef TCP_STEALTH
   if ( (NULL != server) &&
        (0 != (plugin->options & HTTP_OPTIONS_TCP_STEALTH)) )
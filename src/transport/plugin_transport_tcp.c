@@ -243,8 +243,86 @@ struct PendingMessage
    */
   size_t message_size;
 
+  /**
+   * Number of payload bytes the buffer following this struct can
+   * hold; used when recycling pending messages through the pool.
+   */
+  size_t buf_size;
+
 };
 
+
+/**
+ * Maximum number of retired pending messages we keep around for
+ * reuse; we allocate one (plus a payload copy) per send, which
+ * makes this a top allocation site at high message rates.
+ */
+#define PM_POOL_MAX_FREE 64
+
+/**
+ * Head of the pool of free pending messages.
+ */
+static struct PendingMessage *pm_pool_head;
+
+/**
+ * Number of pending messages in the pool.
+ */
+static unsigned int pm_pool_count;
+
+
+/**
+ * Get a pending message able to hold @a msgbuf_size payload
+ * bytes, from the pool if possible.
+ *
+ * @param msgbuf_size number of payload bytes required
+ * @return a zero'ed out pending message with @e msg set up
+ */
+static struct PendingMessage *
+pm_alloc (size_t msgbuf_size)
+{
+  struct PendingMessage *pm;
+
+  if ( (NULL != pm_pool_head) &&
+       (pm_pool_head->buf_size >= msgbuf_size) )
+  {
+    size_t buf_size;
+
+    pm = pm_pool_head;
+    pm_pool_head = pm->next;
+    pm_pool_count--;
+    buf_size = pm->buf_size;
+    memset (pm, 0, sizeof (struct PendingMessage));
+    pm->buf_size = buf_size;
+  }
+  else
+  {
+    pm = GNUNET_malloc (sizeof (struct PendingMessage) + msgbuf_size);
+    pm->buf_size = msgbuf_size;
+  }
+  pm->msg = (const char *) &pm[1];
+  return pm;
+}
+
+
+/**
+ * Release a pending message, putting it back into the pool
+ * unless the pool is full.
+ *
+ * @param pm pending message to release
+ */
+static void
+pm_free (struct PendingMessage *pm)
+{
+  if (pm_pool_count < PM_POOL_MAX_FREE)
+  {
+    pm->next = pm_pool_head;
+    pm_pool_head = pm;
+    pm_pool_count++;
+    return;
+  }
+  GNUNET_free (pm);
+}
+
 /**
  * Session handle for TCP connections.
  */
@@ -913,7 +991,7 @@ tcp_plugin_disconnect_session (void *cls,
                          GNUNET_SYSERR,
                          pm->message_size,
                          0);
-    GNUNET_free (pm);
+    pm_free (pm);
   }
   GNUNET_assert (0 == session->msgs_in_queue);
   GNUNET_assert (0 == session->bytes_in_queue);
@@ -1051,9 +1129,7 @@ create_session (struct Plugin *plugin,
   session->target = address->peer;
   session->expecting_welcome = GNUNET_YES;
   session->scope = scope;
-  pm = GNUNET_malloc (sizeof (struct PendingMessage) +
-		      sizeof (struct WelcomeMessage));
-  pm->msg = (const char *) &pm[1];
+  pm = pm_alloc (sizeof (struct WelcomeMessage));
   pm->message_size = sizeof(struct WelcomeMessage);
   memcpy (&pm[1],
           &plugin->my_welcome,
@@ -1181,7 +1257,7 @@ do_transmit (void *cls,
                             GNUNET_SYSERR,
                             pos->message_size,
                             0);
-      GNUNET_free (pos);
+      pm_free (pos);
     }
     GNUNET_STATISTICS_update (plugin->env->stats,
                               gettext_noop ("# bytes currently in TCP buffers"), -(int64_t) ret,
@@ -1252,7 +1328,7 @@ do_transmit (void *cls,
                           GNUNET_OK,
                           pos->message_size,
                           pos->message_size); /* FIXME: include TCP overhead */
-    GNUNET_free (pos);
+    pm_free (pos);
   }
   GNUNET_assert (NULL == hd);
   GNUNET_assert (NULL == tl);
@@ -1278,16 +1354,24 @@ static void
 process_pending_messages (struct GNUNET_ATS_Session *session)
 {
   struct PendingMessage *pm;
+  size_t total;
 
   GNUNET_assert (NULL != session->client);
   if (NULL != session->transmit_handle)
     return;
   if (NULL == (pm = session->pending_messages_head))
     return;
-
+  /* ask for buffer space covering the entire queue (capped at what
+     the connection layer accepts), so a single wakeup of do_transmit
+     drains as many pending messages as possible */
+  total = session->bytes_in_queue;
+  if (total > GNUNET_SERVER_MAX_MESSAGE_SIZE - 1)
+    total = GNUNET_SERVER_MAX_MESSAGE_SIZE - 1;
+  if (total < pm->message_size)
+    total = pm->message_size;
   session->transmit_handle
     = GNUNET_SERVER_notify_transmit_ready (session->client,
-                                           pm->message_size,
+                                           total,
                                            GNUNET_TIME_absolute_get_remaining (pm->timeout),
                                            &do_transmit,
                                            session);
@@ -1335,8 +1419,7 @@ tcp_plugin_send (void *cls,
   struct PendingMessage *pm;
 
   /* create new message entry */
-  pm = GNUNET_malloc (sizeof (struct PendingMessage) + msgbuf_size);
-  pm->msg = (const char *) &pm[1];
+  pm = pm_alloc (msgbuf_size);
   memcpy (&pm[1], msgbuf, msgbuf_size);
   pm->message_size = msgbuf_size;
   pm->timeout = GNUNET_TIME_relative_to_absolute (to);
@@ -1405,7 +1488,7 @@ tcp_plugin_send (void *cls,
           pm->message_size,
           0);
   GNUNET_break (0);
-  GNUNET_free (pm);
+  pm_free (pm);
   return GNUNET_SYSERR; /* session does not exist here */
 }
 
@@ -66,6 +66,12 @@
  */
 #define UDP_MAX_SENDER_ADDRESSES_WITH_DEFRAG 128
 
+/**
+ * How many datagrams do we drain from a socket per wakeup by
+ * default?  Can be overridden with the RECEIVE_BATCH_SIZE option.
+ */
+#define UDP_DEFAULT_RECEIVE_BATCH 32
+
 
 /**
  * UDP Message-Packet header (after defragmentation).
@@ -3063,8 +3069,11 @@ read_process_fragment (struct Plugin *plugin,
  *
  * @param plugin the overall plugin
  * @param rsock socket to read from
+ * @return #GNUNET_YES if a datagram was consumed and the caller
+ *         may keep draining the (non-blocking) socket,
+ *         #GNUNET_NO if the socket has nothing more to read
  */
-static void
+static int
 udp_select_read (struct Plugin *plugin,
                  struct GNUNET_NETWORK_Handle *rsock)
 {
@@ -3105,7 +3114,7 @@ udp_select_read (struct Plugin *plugin,
    */
   if ( (-1 == size) &&
        (ECONNRESET == errno) )
-    return;
+    return GNUNET_YES;
 #endif
   if (-1 == size)
   {
@@ -3113,14 +3122,14 @@ udp_select_read (struct Plugin *plugin,
          "UDP failed to receive data: %s\n",
          STRERROR (errno));
     /* Connection failure or something. Not a protocol violation. */
-    return;
+    return GNUNET_NO;
   }
 
   /* Check if this is a STUN packet */
   if (GNUNET_NAT_is_valid_stun_packet (plugin->nat,
                                        (uint8_t *)buf,
                                        size))
-    return; /* was STUN, do not process further */
+    return GNUNET_YES; /* was STUN, do not process further */
 
   if (size < sizeof(struct GNUNET_MessageHeader))
   {
@@ -3132,7 +3141,7 @@ udp_select_read (struct Plugin *plugin,
     /* _MAY_ be a connection failure (got partial message) */
     /* But it _MAY_ also be that the other side uses non-GNUnet protocol. */
     GNUNET_break_op (0);
-    return;
+    return GNUNET_YES;
   }
 
   msg = (const struct GNUNET_MessageHeader *) buf;
@@ -3150,7 +3159,7 @@ udp_select_read (struct Plugin *plugin,
          GNUNET_a2s (sa,
                      fromlen));
     GNUNET_break_op (0);
-    return;
+    return GNUNET_YES;
   }
   GNUNET_STATISTICS_update (plugin->env->stats,
                             "# UDP, total bytes received",
@@ -3179,7 +3188,7 @@ udp_select_read (struct Plugin *plugin,
     break;
   default:
     GNUNET_break (0);
-    return;
+    return GNUNET_YES;
   }
 
   switch (ntohs (msg->type))
@@ -3192,35 +3201,35 @@ udp_select_read (struct Plugin *plugin,
                              int_addr,
                              int_addr_len,
                              network_type);
-    return;
+    return GNUNET_YES;
   case GNUNET_MESSAGE_TYPE_TRANSPORT_UDP_MESSAGE:
     if (ntohs (msg->size) < sizeof(struct UDPMessage))
     {
       GNUNET_break_op(0);
-      return;
+      return GNUNET_YES;
     }
     process_udp_message (plugin,
                          (const struct UDPMessage *) msg,
                          int_addr,
                          int_addr_len,
                          network_type);
-    return;
+    return GNUNET_YES;
   case GNUNET_MESSAGE_TYPE_TRANSPORT_UDP_ACK:
     read_process_ack (plugin,
                       msg,
                       int_addr,
                       int_addr_len);
-    return;
+    return GNUNET_YES;
   case GNUNET_MESSAGE_TYPE_FRAGMENT:
     read_process_fragment (plugin,
                            msg,
                            int_addr,
                            int_addr_len,
                            network_type);
-    return;
+    return GNUNET_YES;
   default:
     GNUNET_break_op(0);
-    return;
+    return GNUNET_YES;
   }
 }
 
@@ -3523,6 +3532,7 @@ udp_plugin_select_v4 (void *cls,
                       const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
   struct Plugin *plugin = cls;
+  unsigned int i;
 
   plugin->select_task_v4 = NULL;
   if (0 != (tc->reason & GNUNET_SCHEDULER_REASON_SHUTDOWN))
@@ -3532,8 +3542,15 @@ udp_plugin_select_v4 (void *cls,
   if ((0 != (tc->reason & GNUNET_SCHEDULER_REASON_READ_READY)) &&
       (GNUNET_NETWORK_fdset_isset (tc->read_ready,
                                    plugin->sockv4)))
-    udp_select_read (plugin,
-                     plugin->sockv4);
+  {
+    /* drain a whole batch of datagrams from the non-blocking
+       socket, amortizing the wakeup over many packets */
+    for (i = 0; i < plugin->max_receive_batch; i++)
+      if (GNUNET_YES !=
+          udp_select_read (plugin,
+                           plugin->sockv4))
+        break;
+  }
   udp_select_send (plugin,
                    plugin->sockv4);
   schedule_select_v4 (plugin);
@@ -3553,6 +3570,7 @@ udp_plugin_select_v6 (void *cls,
                       const struct GNUNET_SCHEDULER_TaskContext *tc)
 {
   struct Plugin *plugin = cls;
+  unsigned int i;
 
   plugin->select_task_v6 = NULL;
   if (0 != (tc->reason & GNUNET_SCHEDULER_REASON_SHUTDOWN))
@@ -3562,9 +3580,13 @@ udp_plugin_select_v6 (void *cls,
   if ( (0 != (tc->reason & GNUNET_SCHEDULER_REASON_READ_READY)) &&
        (GNUNET_NETWORK_fdset_isset (tc->read_ready,
                                     plugin->sockv6)) )
-    udp_select_read (plugin,
-                     plugin->sockv6);
-
+  {
+    for (i = 0; i < plugin->max_receive_batch; i++)
+      if (GNUNET_YES !=
+          udp_select_read (plugin,
+                           plugin->sockv6))
+        break;
+  }
   udp_select_send (plugin,
                    plugin->sockv6);
   schedule_select_v6 (plugin);
@@ -3827,6 +3849,7 @@ libgnunet_plugin_transport_udp_init (void *cls)
   unsigned long long port;
   unsigned long long aport;
   unsigned long long udp_max_bps;
+  unsigned long long receive_batch;
   unsigned long long enable_v6;
   unsigned long long enable_broadcasting;
   unsigned long long enable_broadcasting_recv;
@@ -3975,6 +3998,14 @@ libgnunet_plugin_transport_udp_init (void *cls)
     /* 50 MB/s == infinity for practical purposes */
     udp_max_bps = 1024 * 1024 * 50;
   }
+  if (GNUNET_OK !=
+      GNUNET_CONFIGURATION_get_value_number (env->cfg,
+                                             "transport-udp",
+                                             "RECEIVE_BATCH_SIZE",
+                                             &receive_batch))
+    receive_batch = UDP_DEFAULT_RECEIVE_BATCH;
+  if (0 == receive_batch)
+    receive_batch = 1;
 
   p = GNUNET_new (struct Plugin);
   p->port = port;
@@ -3984,6 +4015,7 @@ libgnunet_plugin_transport_udp_init (void *cls)
   p->enable_ipv4 = GNUNET_YES; /* default */
   p->enable_broadcasting = enable_broadcasting;
   p->enable_broadcasting_receiving = enable_broadcasting_recv;
+  p->max_receive_batch = (unsigned int) receive_batch;
   p->env = env;
   p->sessions = GNUNET_CONTAINER_multipeermap_create (16,
                                                       GNUNET_NO);
@@ -279,6 +279,11 @@ struct Plugin
    */
   uint32_t myoptions;
 
+  /**
+   * Maximum number of datagrams we process per socket wakeup.
+   */
+  unsigned int max_receive_batch;
+
   /**
    * Is IPv6 enabled: #GNUNET_YES or #GNUNET_NO
    */
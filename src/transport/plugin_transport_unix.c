@@ -48,6 +48,22 @@
  */
 #define PLUGIN_NAME "unix"
 
+/**
+ * How many queued messages do we transmit (at most) per write-ready
+ * notification?  Draining several datagrams per wakeup avoids going
+ * through the scheduler for every single message when many peers on
+ * the same host exchange traffic.
+ */
+#define UNIX_MAX_MSGS_PER_WRITE 16
+
+/**
+ * Socket send and receive buffer size we request at startup; with
+ * dozens of peers on one host the kernel default is quickly
+ * exhausted and senders drop into the retry path.  Requests beyond
+ * the system maximum are silently capped by the kernel.
+ */
+#define UNIX_SOCKET_BUFFER_SIZE (1024 * 1024)
+
 /**
  * Options for UNIX Domain addresses.
  */
@@ -130,7 +146,7 @@ struct UNIXMessageWrapper
   struct UNIXMessageWrapper *prev;
 
   /**
-   * The actual payload (allocated separately right now).
+   * The actual payload (allocated at the end of this struct).
    */
   struct UNIXMessage *msg;
 
@@ -168,9 +184,86 @@ struct UNIXMessageWrapper
    * Priority of the message (ignored, just dragged along in UNIX).
    */
   unsigned int priority;
+
+  /**
+   * Number of bytes the buffer at @e msg can hold; used when
+   * recycling wrappers through the pool.
+   */
+  size_t buf_size;
 };
 
 
+/**
+ * Maximum number of retired message wrappers we keep around for
+ * reuse; we allocate one (plus a payload copy) per send.
+ */
+#define MSGW_POOL_MAX_FREE 64
+
+/**
+ * Head of the pool of free message wrappers.
+ */
+static struct UNIXMessageWrapper *msgw_pool_head;
+
+/**
+ * Number of message wrappers in the pool.
+ */
+static unsigned int msgw_pool_count;
+
+
+/**
+ * Get a message wrapper whose message buffer can hold @a msgsize
+ * bytes, from the pool if possible.
+ *
+ * @param msgsize number of message bytes required
+ * @return a zero'ed out wrapper with @e msg set up
+ */
+static struct UNIXMessageWrapper *
+msgw_alloc (size_t msgsize)
+{
+  struct UNIXMessageWrapper *msgw;
+
+  if ( (NULL != msgw_pool_head) &&
+       (msgw_pool_head->buf_size >= msgsize) )
+  {
+    size_t buf_size;
+
+    msgw = msgw_pool_head;
+    msgw_pool_head = msgw->next;
+    msgw_pool_count--;
+    buf_size = msgw->buf_size;
+    memset (msgw, 0, sizeof (struct UNIXMessageWrapper));
+    msgw->buf_size = buf_size;
+  }
+  else
+  {
+    msgw = GNUNET_malloc (sizeof (struct UNIXMessageWrapper) + msgsize);
+    msgw->buf_size = msgsize;
+  }
+  msgw->msg = (struct UNIXMessage *) &msgw[1];
+  return msgw;
+}
+
+
+/**
+ * Release a message wrapper, putting it back into the pool
+ * unless the pool is full.
+ *
+ * @param msgw message wrapper to release
+ */
+static void
+msgw_free (struct UNIXMessageWrapper *msgw)
+{
+  if (msgw_pool_count < MSGW_POOL_MAX_FREE)
+  {
+    msgw->next = msgw_pool_head;
+    msgw_pool_head = msgw;
+    msgw_pool_count++;
+    return;
+  }
+  GNUNET_free (msgw);
+}
+
+
 /**
  * Handle for a session.
  */
@@ -466,8 +559,7 @@ unix_plugin_session_disconnect (void *cls,
                   &msgw->session->target,
                   GNUNET_SYSERR,
                   msgw->payload, 0);
-    GNUNET_free (msgw->msg);
-    GNUNET_free (msgw);
+    msgw_free (msgw);
   }
   GNUNET_assert (GNUNET_YES ==
                  GNUNET_CONTAINER_multipeermap_remove (plugin->session_map,
@@ -1105,6 +1197,7 @@ unix_plugin_do_write (struct Plugin *plugin)
   struct UNIXMessageWrapper *msgw;
   struct GNUNET_ATS_Session *session;
   int did_delete;
+  unsigned int sends_left = UNIX_MAX_MSGS_PER_WRITE;
 
   session = NULL;
   did_delete = GNUNET_NO;
@@ -1140,8 +1233,7 @@ unix_plugin_do_write (struct Plugin *plugin)
 		  GNUNET_SYSERR,
 		  msgw->payload,
 		  0);
-    GNUNET_free (msgw->msg);
-    GNUNET_free (msgw);
+    msgw_free (msgw);
   }
   if (NULL == msgw)
   {
@@ -1151,72 +1243,74 @@ unix_plugin_do_write (struct Plugin *plugin)
                               GNUNET_TRANSPORT_SS_UPDATE);
     return; /* Nothing to send at the moment */
   }
-  session = msgw->session;
-  sent = unix_real_send (plugin,
-                         plugin->unix_sock.desc,
-                         &session->target,
-                         (const char *) msgw->msg,
-                         msgw->msgsize,
-                         msgw->priority,
-                         msgw->timeout,
-                         msgw->session->address->address,
-                         msgw->session->address->address_length,
-                         msgw->payload,
-                         msgw->cont, msgw->cont_cls);
-  if (RETRY == sent)
+  while ( (0 < sends_left--) &&
+          (NULL != (msgw = plugin->msg_head)) )
   {
-    GNUNET_STATISTICS_update (plugin->env->stats,
-			      "# UNIX retry attempts",
-			      1, GNUNET_NO);
+    session = msgw->session;
+    sent = unix_real_send (plugin,
+                           plugin->unix_sock.desc,
+                           &session->target,
+                           (const char *) msgw->msg,
+                           msgw->msgsize,
+                           msgw->priority,
+                           msgw->timeout,
+                           msgw->session->address->address,
+                           msgw->session->address->address_length,
+                           msgw->payload,
+                           msgw->cont, msgw->cont_cls);
+    if (RETRY == sent)
+    {
+      GNUNET_STATISTICS_update (plugin->env->stats,
+                                "# UNIX retry attempts",
+                                1, GNUNET_NO);
+      notify_session_monitor (plugin,
+                              session,
+                              GNUNET_TRANSPORT_SS_UPDATE);
+      return;
+    }
+    GNUNET_CONTAINER_DLL_remove (plugin->msg_head,
+                                 plugin->msg_tail,
+                                 msgw);
+    session->msgs_in_queue--;
+    GNUNET_assert (session->bytes_in_queue >= msgw->msgsize);
+    session->bytes_in_queue -= msgw->msgsize;
+    GNUNET_assert (plugin->bytes_in_queue >= msgw->msgsize);
+    plugin->bytes_in_queue -= msgw->msgsize;
+    GNUNET_STATISTICS_set (plugin->env->stats,
+                           "# bytes currently in UNIX buffers",
+                           plugin->bytes_in_queue, GNUNET_NO);
     notify_session_monitor (plugin,
                             session,
                             GNUNET_TRANSPORT_SS_UPDATE);
-    return;
-  }
-  GNUNET_CONTAINER_DLL_remove (plugin->msg_head,
-                               plugin->msg_tail,
-                               msgw);
-  session->msgs_in_queue--;
-  GNUNET_assert (session->bytes_in_queue >= msgw->msgsize);
-  session->bytes_in_queue -= msgw->msgsize;
-  GNUNET_assert (plugin->bytes_in_queue >= msgw->msgsize);
-  plugin->bytes_in_queue -= msgw->msgsize;
-  GNUNET_STATISTICS_set (plugin->env->stats,
-                         "# bytes currently in UNIX buffers",
-                         plugin->bytes_in_queue, GNUNET_NO);
-  notify_session_monitor (plugin,
-                          session,
-                          GNUNET_TRANSPORT_SS_UPDATE);
-  if (GNUNET_SYSERR == sent)
-  {
-    /* failed and no retry */
+    if (GNUNET_SYSERR == sent)
+    {
+      /* failed and no retry */
+      if (NULL != msgw->cont)
+        msgw->cont (msgw->cont_cls,
+                    &msgw->session->target,
+                    GNUNET_SYSERR,
+                    msgw->payload, 0);
+      GNUNET_STATISTICS_update (plugin->env->stats,
+                                "# UNIX bytes discarded",
+                                msgw->msgsize,
+                                GNUNET_NO);
+      msgw_free (msgw);
+      return;
+    }
+    /* successfully sent bytes */
+    GNUNET_break (sent > 0);
+    GNUNET_STATISTICS_update (plugin->env->stats,
+                              "# bytes transmitted via UNIX",
+                              msgw->msgsize,
+                              GNUNET_NO);
     if (NULL != msgw->cont)
       msgw->cont (msgw->cont_cls,
                   &msgw->session->target,
-                  GNUNET_SYSERR,
-                  msgw->payload, 0);
-    GNUNET_STATISTICS_update (plugin->env->stats,
-			      "# UNIX bytes discarded",
-			      msgw->msgsize,
-			      GNUNET_NO);
-    GNUNET_free (msgw->msg);
-    GNUNET_free (msgw);
-    return;
+                  GNUNET_OK,
+                  msgw->payload,
+                  msgw->msgsize);
+    msgw_free (msgw);
   }
-  /* successfully sent bytes */
-  GNUNET_break (sent > 0);
-  GNUNET_STATISTICS_update (plugin->env->stats,
-			    "# bytes transmitted via UNIX",
-			    msgw->msgsize,
-			    GNUNET_NO);
-  if (NULL != msgw->cont)
-    msgw->cont (msgw->cont_cls,
-                &msgw->session->target,
-		GNUNET_OK,
-		msgw->payload,
-		msgw->msgsize);
-  GNUNET_free (msgw->msg);
-  GNUNET_free (msgw);
 }
 
 
@@ -1336,14 +1430,13 @@ unix_plugin_send (void *cls,
                                       session->address->address,
                                       session->address->address_length));
   ssize = sizeof (struct UNIXMessage) + msgbuf_size;
-  message = GNUNET_malloc (sizeof (struct UNIXMessage) + msgbuf_size);
+  wrapper = msgw_alloc (ssize);
+  message = wrapper->msg;
   message->header.size = htons (ssize);
   message->header.type = htons (0);
   memcpy (&message->sender, plugin->env->my_identity,
           sizeof (struct GNUNET_PeerIdentity));
   memcpy (&message[1], msgbuf, msgbuf_size);
-  wrapper = GNUNET_new (struct UNIXMessageWrapper);
-  wrapper->msg = message;
   wrapper->msgsize = ssize;
   wrapper->payload = msgbuf_size;
   wrapper->priority = priority;
@@ -1402,6 +1495,22 @@ unix_transport_server_start (void *cls)
     GNUNET_free (un);
     return GNUNET_SYSERR;
   }
+  {
+    int size = UNIX_SOCKET_BUFFER_SIZE;
+
+    /* Ask for large buffers up front; failure is harmless, we then
+       just hit the EAGAIN retry path more often under load. */
+    if (GNUNET_OK !=
+        GNUNET_NETWORK_socket_setsockopt (plugin->unix_sock.desc,
+                                          SOL_SOCKET, SO_SNDBUF,
+                                          &size, sizeof (size)))
+      GNUNET_log_strerror (GNUNET_ERROR_TYPE_WARNING, "setsockopt");
+    if (GNUNET_OK !=
+        GNUNET_NETWORK_socket_setsockopt (plugin->unix_sock.desc,
+                                          SOL_SOCKET, SO_RCVBUF,
+                                          &size, sizeof (size)))
+      GNUNET_log_strerror (GNUNET_ERROR_TYPE_WARNING, "setsockopt");
+  }
   if ('\0' != un->sun_path[0])
   {
     if (GNUNET_OK != GNUNET_DISK_directory_create_for_file (un->sun_path))
@@ -1890,8 +1999,7 @@ libgnunet_plugin_transport_unix_done (void *cls)
                   &msgw->session->target,
                   GNUNET_SYSERR,
                   msgw->payload, 0);
-    GNUNET_free (msgw->msg);
-    GNUNET_free (msgw);
+    msgw_free (msgw);
   }
 
   if (NULL != plugin->read_task)
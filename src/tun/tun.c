@@ -94,18 +94,64 @@ GNUNET_TUN_initialize_ipv6_header (struct GNUNET_TUN_IPv6Header *ip,
 
 
 /**
- * Calculate IPv4 TCP checksum.
+ * Calculate the checksum seed of an IPv4 flow.
+ *
+ * @param src source IP address of the flow
+ * @param dst destination IP address of the flow
+ * @return partial checksum covering both addresses
+ */
+uint32_t
+GNUNET_TUN_flow_checksum_seed4 (const struct in_addr *src,
+				const struct in_addr *dst)
+{
+  uint32_t sum;
+
+  sum = GNUNET_CRYPTO_crc16_step (0,
+				  src,
+				  sizeof (struct in_addr));
+  return GNUNET_CRYPTO_crc16_step (sum,
+				   dst,
+				   sizeof (struct in_addr));
+}
+
+
+/**
+ * Calculate the checksum seed of an IPv6 flow.
+ *
+ * @param src source IP address of the flow
+ * @param dst destination IP address of the flow
+ * @return partial checksum covering both addresses
+ */
+uint32_t
+GNUNET_TUN_flow_checksum_seed6 (const struct in6_addr *src,
+				const struct in6_addr *dst)
+{
+  uint32_t sum;
+
+  sum = GNUNET_CRYPTO_crc16_step (0,
+				  src,
+				  sizeof (struct in6_addr));
+  return GNUNET_CRYPTO_crc16_step (sum,
+				   dst,
+				   sizeof (struct in6_addr));
+}
+
+
+/**
+ * Calculate IPv4 TCP checksum, given the flow's checksum seed.
  *
  * @param ip ipv4 header fully initialized
  * @param tcp TCP header (initialized except for CRC)
  * @param payload the TCP payload
  * @param payload_length number of bytes of TCP payload
+ * @param seed partial checksum over the flow's addresses
  */
 void
-GNUNET_TUN_calculate_tcp4_checksum (const struct GNUNET_TUN_IPv4Header *ip,
-				    struct GNUNET_TUN_TcpHeader *tcp,
-				    const void *payload,
-				    uint16_t payload_length)
+GNUNET_TUN_calculate_tcp4_checksum_seeded (const struct GNUNET_TUN_IPv4Header *ip,
+					   struct GNUNET_TUN_TcpHeader *tcp,
+					   const void *payload,
+					   uint16_t payload_length,
+					   uint32_t seed)
 {
   uint32_t sum;
   uint16_t tmp;
@@ -116,9 +162,7 @@ GNUNET_TUN_calculate_tcp4_checksum (const struct GNUNET_TUN_IPv4Header *ip,
   GNUNET_assert (IPPROTO_TCP == ip->protocol);
 
   tcp->crc = 0;
-  sum = GNUNET_CRYPTO_crc16_step (0,
-				  &ip->source_address,
-				  sizeof (struct in_addr) * 2);
+  sum = seed;
   tmp = htons (IPPROTO_TCP);
   sum = GNUNET_CRYPTO_crc16_step (sum, &tmp, sizeof (uint16_t));
   tmp = htons (payload_length + sizeof (struct GNUNET_TUN_TcpHeader));
@@ -130,18 +174,42 @@ GNUNET_TUN_calculate_tcp4_checksum (const struct GNUNET_TUN_IPv4Header *ip,
 
 
 /**
- * Calculate IPv6 TCP checksum.
+ * Calculate IPv4 TCP checksum.
  *
- * @param ip ipv6 header fully initialized
- * @param tcp header (initialized except for CRC)
+ * @param ip ipv4 header fully initialized
+ * @param tcp TCP header (initialized except for CRC)
  * @param payload the TCP payload
  * @param payload_length number of bytes of TCP payload
  */
 void
-GNUNET_TUN_calculate_tcp6_checksum (const struct GNUNET_TUN_IPv6Header *ip,
+GNUNET_TUN_calculate_tcp4_checksum (const struct GNUNET_TUN_IPv4Header *ip,
 				    struct GNUNET_TUN_TcpHeader *tcp,
 				    const void *payload,
 				    uint16_t payload_length)
+{
+  GNUNET_TUN_calculate_tcp4_checksum_seeded (ip, tcp,
+					     payload, payload_length,
+					     GNUNET_CRYPTO_crc16_step (0,
+								       &ip->source_address,
+								       2 * sizeof (struct in_addr)));
+}
+
+
+/**
+ * Calculate IPv6 TCP checksum, given the flow's checksum seed.
+ *
+ * @param ip ipv6 header fully initialized
+ * @param tcp header (initialized except for CRC)
+ * @param payload the TCP payload
+ * @param payload_length number of bytes of TCP payload
+ * @param seed partial checksum over the flow's addresses
+ */
+void
+GNUNET_TUN_calculate_tcp6_checksum_seeded (const struct GNUNET_TUN_IPv6Header *ip,
+					   struct GNUNET_TUN_TcpHeader *tcp,
+					   const void *payload,
+					   uint16_t payload_length,
+					   uint32_t seed)
 {
   uint32_t sum;
   uint32_t tmp;
@@ -151,7 +219,7 @@ GNUNET_TUN_calculate_tcp6_checksum (const struct GNUNET_TUN_IPv6Header *ip,
 		 ntohs (ip->payload_length));
   GNUNET_assert (IPPROTO_TCP == ip->next_header);
   tcp->crc = 0;
-  sum = GNUNET_CRYPTO_crc16_step (0, &ip->source_address, 2 * sizeof (struct in6_addr));
+  sum = seed;
   tmp = htonl (sizeof (struct GNUNET_TUN_TcpHeader) + payload_length);
   sum = GNUNET_CRYPTO_crc16_step (sum, &tmp, sizeof (uint32_t));
   tmp = htonl (IPPROTO_TCP);
@@ -164,18 +232,42 @@ GNUNET_TUN_calculate_tcp6_checksum (const struct GNUNET_TUN_IPv6Header *ip,
 
 
 /**
- * Calculate IPv4 UDP checksum.
+ * Calculate IPv6 TCP checksum.
+ *
+ * @param ip ipv6 header fully initialized
+ * @param tcp header (initialized except for CRC)
+ * @param payload the TCP payload
+ * @param payload_length number of bytes of TCP payload
+ */
+void
+GNUNET_TUN_calculate_tcp6_checksum (const struct GNUNET_TUN_IPv6Header *ip,
+				    struct GNUNET_TUN_TcpHeader *tcp,
+				    const void *payload,
+				    uint16_t payload_length)
+{
+  GNUNET_TUN_calculate_tcp6_checksum_seeded (ip, tcp,
+					     payload, payload_length,
+					     GNUNET_CRYPTO_crc16_step (0,
+								       &ip->source_address,
+								       2 * sizeof (struct in6_addr)));
+}
+
+
+/**
+ * Calculate IPv4 UDP checksum, given the flow's checksum seed.
  *
  * @param ip ipv4 header fully initialized
  * @param udp UDP header (initialized except for CRC)
  * @param payload the UDP payload
  * @param payload_length number of bytes of UDP payload
+ * @param seed partial checksum over the flow's addresses
  */
 void
-GNUNET_TUN_calculate_udp4_checksum (const struct GNUNET_TUN_IPv4Header *ip,
-				    struct GNUNET_TUN_UdpHeader *udp,
-				    const void *payload,
-				    uint16_t payload_length)
+GNUNET_TUN_calculate_udp4_checksum_seeded (const struct GNUNET_TUN_IPv4Header *ip,
+					   struct GNUNET_TUN_UdpHeader *udp,
+					   const void *payload,
+					   uint16_t payload_length,
+					   uint32_t seed)
 {
   uint32_t sum;
   uint16_t tmp;
@@ -186,9 +278,7 @@ GNUNET_TUN_calculate_udp4_checksum (const struct GNUNET_TUN_IPv4Header *ip,
   GNUNET_assert (IPPROTO_UDP == ip->protocol);
 
   udp->crc = 0; /* technically optional, but we calculate it anyway, just to be sure */
-  sum = GNUNET_CRYPTO_crc16_step (0,
-				  &ip->source_address,
-				  sizeof (struct in_addr) * 2);
+  sum = seed;
   tmp = htons (IPPROTO_UDP);
   sum = GNUNET_CRYPTO_crc16_step (sum,
 				  &tmp,
@@ -208,18 +298,42 @@ GNUNET_TUN_calculate_udp4_checksum (const struct GNUNET_TUN_IPv4Header *ip,
 
 
 /**
- * Calculate IPv6 UDP checksum.
+ * Calculate IPv4 UDP checksum.
  *
- * @param ip ipv6 header fully initialized
+ * @param ip ipv4 header fully initialized
  * @param udp UDP header (initialized except for CRC)
  * @param payload the UDP payload
  * @param payload_length number of bytes of UDP payload
  */
 void
-GNUNET_TUN_calculate_udp6_checksum (const struct GNUNET_TUN_IPv6Header *ip,
+GNUNET_TUN_calculate_udp4_checksum (const struct GNUNET_TUN_IPv4Header *ip,
 				    struct GNUNET_TUN_UdpHeader *udp,
 				    const void *payload,
 				    uint16_t payload_length)
+{
+  GNUNET_TUN_calculate_udp4_checksum_seeded (ip, udp,
+					     payload, payload_length,
+					     GNUNET_CRYPTO_crc16_step (0,
+								       &ip->source_address,
+								       2 * sizeof (struct in_addr)));
+}
+
+
+/**
+ * Calculate IPv6 UDP checksum, given the flow's checksum seed.
+ *
+ * @param ip ipv6 header fully initialized
+ * @param udp UDP header (initialized except for CRC)
+ * @param payload the UDP payload
+ * @param payload_length number of bytes of UDP payload
+ * @param seed partial checksum over the flow's addresses
+ */
+void
+GNUNET_TUN_calculate_udp6_checksum_seeded (const struct GNUNET_TUN_IPv6Header *ip,
+					   struct GNUNET_TUN_UdpHeader *udp,
+					   const void *payload,
+					   uint16_t payload_length,
+					   uint32_t seed)
 {
   uint32_t sum;
   uint32_t tmp;
@@ -231,9 +345,7 @@ GNUNET_TUN_calculate_udp6_checksum (const struct GNUNET_TUN_IPv6Header *ip,
   GNUNET_assert (IPPROTO_UDP == ip->next_header);
 
   udp->crc = 0;
-  sum = GNUNET_CRYPTO_crc16_step (0,
-				  &ip->source_address,
-				  sizeof (struct in6_addr) * 2);
+  sum = seed;
   tmp = htons (sizeof (struct GNUNET_TUN_UdpHeader) + payload_length); /* aka udp->len */
   sum = GNUNET_CRYPTO_crc16_step (sum, &tmp, sizeof (uint32_t));
   tmp = htons (ip->next_header);
@@ -244,6 +356,28 @@ GNUNET_TUN_calculate_udp6_checksum (const struct GNUNET_TUN_IPv6Header *ip,
 }
 
 
+/**
+ * Calculate IPv6 UDP checksum.
+ *
+ * @param ip ipv6 header fully initialized
+ * @param udp UDP header (initialized except for CRC)
+ * @param payload the UDP payload
+ * @param payload_length number of bytes of UDP payload
+ */
+void
+GNUNET_TUN_calculate_udp6_checksum (const struct GNUNET_TUN_IPv6Header *ip,
+				    struct GNUNET_TUN_UdpHeader *udp,
+				    const void *payload,
+				    uint16_t payload_length)
+{
+  GNUNET_TUN_calculate_udp6_checksum_seeded (ip, udp,
+					     payload, payload_length,
+					     GNUNET_CRYPTO_crc16_step (0,
+								       &ip->source_address,
+								       2 * sizeof (struct in6_addr)));
+}
+
+
 /**
  * Calculate ICMP checksum.
  *
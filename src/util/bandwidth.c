@@ -138,6 +138,31 @@ GNUNET_BANDWIDTH_value_get_delay_for (struct GNUNET_BANDWIDTH_Value32NBO bps,
 }
 
 
+/**
+ * Recompute the cached maximum number of bytes the tracker
+ * may accumulate.  Called whenever the quota changes.
+ *
+ * @param av tracker to update
+ */
+static void
+update_max_carry (struct GNUNET_BANDWIDTH_Tracker *av)
+{
+  uint64_t max_carry;
+
+  max_carry = (uint64_t) av->available_bytes_per_s__ * av->max_carry_s__;
+  if (max_carry < GNUNET_SERVER_MAX_MESSAGE_SIZE)
+    max_carry = GNUNET_SERVER_MAX_MESSAGE_SIZE;
+  av->max_carry_bytes__ = max_carry;
+}
+
+
+static void
+update_tracker (struct GNUNET_BANDWIDTH_Tracker *av);
+
+static void
+update_excess (struct GNUNET_BANDWIDTH_Tracker *av);
+
+
 /**
  * Task run whenever we hit the bandwidth limit for a tracker.
  *
@@ -151,7 +176,15 @@ excess_trigger (void *cls,
   struct GNUNET_BANDWIDTH_Tracker *av = cls;
 
   av->excess_task = NULL;
-
+  /* the fast consumption path does not reschedule this task, so
+     bandwidth may have been consumed since we were scheduled;
+     re-check before notifying */
+  update_tracker (av);
+  if (av->consumption_since_last_update__ + (int64_t) av->max_carry_bytes__ > 0)
+  {
+    update_excess (av);
+    return;
+  }
   if (NULL != av->excess_cb)
     av->excess_cb (av->excess_cb_cls);
 }
@@ -168,7 +201,6 @@ update_excess (struct GNUNET_BANDWIDTH_Tracker *av)
   uint64_t delta_time;
   uint64_t delta_avail;
   int64_t left_bytes;
-  uint64_t max_carry;
   int64_t current_consumption;
 
   if (NULL == av->excess_cb)
@@ -180,10 +212,7 @@ update_excess (struct GNUNET_BANDWIDTH_Tracker *av)
        500000LL) / 1000000LL;
   current_consumption = av->consumption_since_last_update__ - delta_avail;
   /* negative current_consumption means that we have savings */
-  max_carry = av->available_bytes_per_s__ * av->max_carry_s__;
-  if (max_carry < GNUNET_SERVER_MAX_MESSAGE_SIZE)
-    max_carry = GNUNET_SERVER_MAX_MESSAGE_SIZE;
-  left_bytes = max_carry + current_consumption;
+  left_bytes = av->max_carry_bytes__ + current_consumption;
   /* left_bytes now contains the number of bytes needed until
      we have more savings than allowed */
   if (left_bytes < 0)
@@ -242,6 +271,7 @@ GNUNET_BANDWIDTH_tracker_init2 (struct GNUNET_BANDWIDTH_Tracker *av,
   av->last_update__ = GNUNET_TIME_absolute_get ();
   av->available_bytes_per_s__ = ntohl (bytes_per_second_limit.value__);
   av->max_carry_s__ = max_carry_s;
+  update_max_carry (av);
   av->excess_cb = excess_cb;
   av->excess_cb_cls = excess_cb_cls;
   LOG (GNUNET_ERROR_TYPE_DEBUG,
@@ -317,7 +347,6 @@ update_tracker (struct GNUNET_BANDWIDTH_Tracker *av)
   uint64_t delta_time;
   uint64_t delta_avail;
   uint64_t left_bytes;
-  uint64_t max_carry;
 
   now = GNUNET_TIME_absolute_get ();
   delta_time = now.abs_value_us - av->last_update__.abs_value_us;
@@ -329,13 +358,10 @@ update_tracker (struct GNUNET_BANDWIDTH_Tracker *av)
   if (av->consumption_since_last_update__ < 0)
   {
     left_bytes = -av->consumption_since_last_update__;
-    max_carry = av->available_bytes_per_s__ * av->max_carry_s__;
-    if (max_carry < GNUNET_SERVER_MAX_MESSAGE_SIZE)
-      max_carry = GNUNET_SERVER_MAX_MESSAGE_SIZE;
-    if (max_carry > left_bytes)
+    if (av->max_carry_bytes__ > left_bytes)
       av->consumption_since_last_update__ = -left_bytes;
     else
-      av->consumption_since_last_update__ = -max_carry;
+      av->consumption_since_last_update__ = -av->max_carry_bytes__;
   }
   delta.rel_value_us = delta_time;
   LOG (GNUNET_ERROR_TYPE_DEBUG,
@@ -375,6 +401,13 @@ GNUNET_BANDWIDTH_tracker_consume (struct GNUNET_BANDWIDTH_Tracker *av,
       return GNUNET_SYSERR;
     }
     av->consumption_since_last_update__ = nc;
+    if (nc <= 0)
+    {
+      /* fast path: still within the bytes carried over from the
+         last update, so the packet is covered without recomputing
+         availability; the excess task re-checks on its own */
+      return GNUNET_NO;
+    }
     update_tracker (av);
     update_excess (av);
     if (av->consumption_since_last_update__ > 0)
@@ -484,6 +517,7 @@ GNUNET_BANDWIDTH_tracker_update_quota (struct GNUNET_BANDWIDTH_Tracker *av,
   update_tracker (av);
   old_limit = av->available_bytes_per_s__;
   av->available_bytes_per_s__ = new_limit;
+  update_max_carry (av);
   if (NULL != av->update_cb)
     av->update_cb (av->update_cb_cls);
   if (old_limit > new_limit)
@@ -50,13 +50,20 @@ struct GNUNET_BIO_ReadHandle
    */
   struct GNUNET_DISK_FileHandle *fd;
 
+  /**
+   * Memory map of the entire file, NULL if we
+   * are reading with the I/O buffer instead.
+   */
+  struct GNUNET_DISK_MapHandle *mh;
+
   /**
    * Error message, NULL if there were no errors.
    */
   char *emsg;
 
   /**
-   * I/O buffer.  Allocated at the end of the struct, do not free!
+   * I/O buffer.  Allocated at the end of the struct
+   * (do not free!), or the mapped file contents.
    */
   char *buffer;
 
@@ -88,10 +95,29 @@ GNUNET_BIO_read_open (const char *fn)
 {
   struct GNUNET_DISK_FileHandle *fd;
   struct GNUNET_BIO_ReadHandle *h;
+  struct GNUNET_DISK_MapHandle *mh;
+  off_t fsize;
+  void *map;
 
   fd = GNUNET_DISK_file_open (fn, GNUNET_DISK_OPEN_READ, GNUNET_DISK_PERM_NONE);
   if (NULL == fd)
     return NULL;
+  if ( (GNUNET_OK == GNUNET_DISK_file_handle_size (fd, &fsize)) &&
+       (fsize > 0) &&
+       ((uint64_t) fsize <= SIZE_MAX) &&
+       (NULL != (map = GNUNET_DISK_file_map (fd, &mh,
+                                             GNUNET_DISK_MAP_TYPE_READ,
+                                             (size_t) fsize))) )
+  {
+    /* serve all reads straight from the mapping */
+    h = GNUNET_new (struct GNUNET_BIO_ReadHandle);
+    h->buffer = map;
+    h->size = (size_t) fsize;
+    h->have = (size_t) fsize;
+    h->mh = mh;
+    h->fd = fd;
+    return h;
+  }
   h = GNUNET_malloc (sizeof (struct GNUNET_BIO_ReadHandle) + BIO_BUFFER_SIZE);
   h->buffer = (char *) &h[1];
   h->size = BIO_BUFFER_SIZE;
@@ -119,6 +145,8 @@ GNUNET_BIO_read_close (struct GNUNET_BIO_ReadHandle *h,
     *emsg = h->emsg;
   else
     GNUNET_free_non_null (h->emsg);
+  if (NULL != h->mh)
+    GNUNET_DISK_file_unmap (h->mh);
   GNUNET_DISK_file_close (h->fd);
   GNUNET_free (h);
   return err;
@@ -162,8 +190,11 @@ GNUNET_BIO_read (struct GNUNET_BIO_ReadHandle *h,
     if (pos == len)
       return GNUNET_OK;         /* done! */
     GNUNET_assert (h->have == h->pos);
-    /* fill buffer */
-    ret = GNUNET_DISK_file_read (h->fd, h->buffer, h->size);
+    /* fill buffer; a mapped file cannot be refilled, so running
+       out of mapped bytes is simply the end of the file */
+    ret = (NULL == h->mh)
+      ? GNUNET_DISK_file_read (h->fd, h->buffer, h->size)
+      : 0;
     if (-1 == ret)
     {
       GNUNET_asprintf (&h->emsg,
@@ -426,7 +457,13 @@ GNUNET_BIO_write_close (struct GNUNET_BIO_WriteHandle *h)
 
   ret = GNUNET_SYSERR;
   if ( (NULL != h->fd) && (GNUNET_OK == (ret = GNUNET_BIO_flush (h))) )
+  {
+    /* all data was batched in memory (or at most flushed in
+       buffer-sized chunks); sync it to disk exactly once */
+    if (GNUNET_OK != GNUNET_DISK_file_sync (h->fd))
+      ret = GNUNET_SYSERR;
     GNUNET_DISK_file_close (h->fd);
+  }
   GNUNET_free (h);
   return ret;
 }
@@ -125,6 +125,11 @@ struct GNUNET_CLIENT_MANAGER_Connection
    */
   struct OperationListItem *op_tail;
 
+  /**
+   * Map of operation IDs to operations for fast lookup.
+   */
+  struct GNUNET_CONTAINER_MultiHashMap *op_map;
+
   /**
    * Last operation ID used.
    */
@@ -383,6 +388,7 @@ GNUNET_CLIENT_MANAGER_connect (const struct GNUNET_CONFIGURATION_Handle *cfg,
   mgr->cfg = cfg;
   mgr->service_name = service_name;
   mgr->handlers = handlers;
+  mgr->op_map = GNUNET_CONTAINER_multihashmap_create (8, GNUNET_NO);
   mgr->reconnect_delay = GNUNET_TIME_UNIT_ZERO;
   mgr->reconnect_task = GNUNET_SCHEDULER_add_now (&schedule_reconnect, mgr);
   return mgr;
@@ -441,6 +447,13 @@ GNUNET_CLIENT_MANAGER_disconnect (struct GNUNET_CLIENT_MANAGER_Connection *mgr,
     GNUNET_CLIENT_disconnect (mgr->client);
     mgr->client = NULL;
   }
+  while (NULL != mgr->op_head)
+  {
+    struct OperationListItem *op = mgr->op_head;
+    GNUNET_CONTAINER_DLL_remove (mgr->op_head, mgr->op_tail, op);
+    GNUNET_free (op);
+  }
+  GNUNET_CONTAINER_multihashmap_destroy (mgr->op_map);
   if (NULL != mgr->disconnect_cb)
     mgr->disconnect_cb (mgr->disconnect_cls);
   GNUNET_free (mgr);
@@ -620,6 +633,22 @@ GNUNET_CLIENT_MANAGER_op_get_next_id (struct GNUNET_CLIENT_MANAGER_Connection *m
 }
 
 
+/**
+ * Calculate the hash map key of an operation ID.
+ *
+ * @param op_id
+ *        Operation ID.
+ * @param[out] key
+ *        Where to store the key.
+ */
+static void
+op_hash (uint64_t op_id, struct GNUNET_HashCode *key)
+{
+  memset (key, 0, sizeof (*key));
+  memcpy (key, &op_id, sizeof (op_id));
+}
+
+
 /**
  * Find operation by ID.
  *
@@ -633,14 +662,10 @@ GNUNET_CLIENT_MANAGER_op_get_next_id (struct GNUNET_CLIENT_MANAGER_Connection *m
 static struct OperationListItem *
 op_find (struct GNUNET_CLIENT_MANAGER_Connection *mgr, uint64_t op_id)
 {
-  struct OperationListItem *op = mgr->op_head;
-  while (NULL != op)
-  {
-    if (op->op_id == op_id)
-      return op;
-    op = op->next;
-  }
-  return NULL;
+  struct GNUNET_HashCode key;
+
+  op_hash (op_id, &key);
+  return GNUNET_CONTAINER_multihashmap_get (mgr->op_map, &key);
 }
 
 
@@ -697,10 +722,16 @@ GNUNET_CLIENT_MANAGER_op_add (struct GNUNET_CLIENT_MANAGER_Connection *mgr,
     return 0;
 
   struct OperationListItem *op = GNUNET_malloc (sizeof (*op));
+  struct GNUNET_HashCode key;
+
   op->op_id = GNUNET_CLIENT_MANAGER_op_get_next_id (mgr);
   op->result_cb = result_cb;
   op->cls = cls;
   GNUNET_CONTAINER_DLL_insert_tail (mgr->op_head, mgr->op_tail, op);
+  op_hash (op->op_id, &key);
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_multihashmap_put (mgr->op_map, &key, op,
+                                                    GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST));
 
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "%p Added operation #%" PRIu64 "\n", mgr, op->op_id);
@@ -739,6 +770,8 @@ op_result (struct GNUNET_CLIENT_MANAGER_Connection *mgr,
     return GNUNET_NO;
 
   struct OperationListItem *op = op_find (mgr, op_id);
+  struct GNUNET_HashCode key;
+
   if (NULL == op)
   {
     LOG (GNUNET_ERROR_TYPE_WARNING,
@@ -747,6 +780,9 @@ op_result (struct GNUNET_CLIENT_MANAGER_Connection *mgr,
   }
 
   GNUNET_CONTAINER_DLL_remove (mgr->op_head, mgr->op_tail, op);
+  op_hash (op_id, &key);
+  GNUNET_assert (GNUNET_YES ==
+                 GNUNET_CONTAINER_multihashmap_remove (mgr->op_map, &key, op));
 
   if (GNUNET_YES != cancel && NULL != op->result_cb)
     op->result_cb (op->cls, result_code, data, data_size);
@@ -858,6 +858,82 @@ GNUNET_get_log_skip ()
 }
 
 
+/**
+ * Format the current date/time for use in a log line.
+ *
+ * @param date buffer of #DATE_STR_SIZE bytes to write the date to
+ * @return broken down local time, or NULL if it was not available
+ */
+static struct tm *
+format_date (char *date)
+{
+  char date2[DATE_STR_SIZE];
+  struct tm *tmptr;
+  long long offset;
+#ifdef WINDOWS
+  LARGE_INTEGER pc;
+  time_t timetmp;
+
+  offset = GNUNET_TIME_get_offset ();
+  time (&timetmp);
+  timetmp += offset / 1000;
+  tmptr = localtime (&timetmp);
+  pc.QuadPart = 0;
+  QueryPerformanceCounter (&pc);
+  if (NULL == tmptr)
+  {
+    strcpy (date, "localtime error");
+  }
+  else
+  {
+    strftime (date2, DATE_STR_SIZE, "%b %d %H:%M:%S-%%020llu", tmptr);
+    snprintf (date, DATE_STR_SIZE, date2,
+	      (long long) (pc.QuadPart /
+			   (performance_frequency.QuadPart / 1000)));
+  }
+#else
+  struct timeval timeofday;
+
+  gettimeofday (&timeofday, NULL);
+  offset = GNUNET_TIME_get_offset ();
+  if (offset > 0)
+  {
+    timeofday.tv_sec += offset / 1000LL;
+    timeofday.tv_usec += (offset % 1000LL) * 1000LL;
+    if (timeofday.tv_usec > 1000000LL)
+    {
+      timeofday.tv_usec -= 1000000LL;
+      timeofday.tv_sec++;
+    }
+  }
+  else
+  {
+    timeofday.tv_sec += offset / 1000LL;
+    if (timeofday.tv_usec > - (offset % 1000LL) * 1000LL)
+    {
+      timeofday.tv_usec += (offset % 1000LL) * 1000LL;
+    }
+    else
+    {
+      timeofday.tv_usec += 1000000LL + (offset % 1000LL) * 1000LL;
+      timeofday.tv_sec--;
+    }
+  }
+  tmptr = localtime (&timeofday.tv_sec);
+  if (NULL == tmptr)
+  {
+    strcpy (date, "localtime error");
+  }
+  else
+  {
+    strftime (date2, DATE_STR_SIZE, "%b %d %H:%M:%S-%%06u", tmptr);
+    snprintf (date, DATE_STR_SIZE, date2, timeofday.tv_usec);
+  }
+#endif
+  return tmptr;
+}
+
+
 /**
  * Output a log message using the default mechanism.
  *
@@ -873,7 +949,6 @@ mylog (enum GNUNET_ErrorType kind,
        va_list va)
 {
   char date[DATE_STR_SIZE];
-  char date2[DATE_STR_SIZE];
   struct tm *tmptr;
   size_t size;
   va_list vacp;
@@ -885,81 +960,30 @@ mylog (enum GNUNET_ErrorType kind,
   memset (date, 0, DATE_STR_SIZE);
   {
     char buf[size];
-    long long offset;
-#ifdef WINDOWS
-    LARGE_INTEGER pc;
-    time_t timetmp;
-
-    offset = GNUNET_TIME_get_offset ();
-    time (&timetmp);
-    timetmp += offset / 1000;
-    tmptr = localtime (&timetmp);
-    pc.QuadPart = 0;
-    QueryPerformanceCounter (&pc);
-    if (NULL == tmptr)
-    {
-      strcpy (date, "localtime error");
-    }
-    else
-    {
-      strftime (date2, DATE_STR_SIZE, "%b %d %H:%M:%S-%%020llu", tmptr);
-      snprintf (date, sizeof (date), date2,
-		(long long) (pc.QuadPart /
-			     (performance_frequency.QuadPart / 1000)));
-    }
-#else
-    struct timeval timeofday;
 
-    gettimeofday (&timeofday, NULL);
-    offset = GNUNET_TIME_get_offset ();
-    if (offset > 0)
-    {
-      timeofday.tv_sec += offset / 1000LL;
-      timeofday.tv_usec += (offset % 1000LL) * 1000LL;
-      if (timeofday.tv_usec > 1000000LL)
-      {
-	timeofday.tv_usec -= 1000000LL;
-	timeofday.tv_sec++;
-      }
-    }
-    else
-    {
-      timeofday.tv_sec += offset / 1000LL;
-      if (timeofday.tv_usec > - (offset % 1000LL) * 1000LL)
-      {
-	timeofday.tv_usec += (offset % 1000LL) * 1000LL;
-      }
-      else
-      {
-	timeofday.tv_usec += 1000000LL + (offset % 1000LL) * 1000LL;
-	timeofday.tv_sec--;
-      }
-    }
-    tmptr = localtime (&timeofday.tv_sec);
-    if (NULL == tmptr)
-    {
-      strcpy (date, "localtime error");
-    }
-    else
-    {
-      strftime (date2, DATE_STR_SIZE, "%b %d %H:%M:%S-%%06u", tmptr);
-      snprintf (date, sizeof (date), date2, timeofday.tv_usec);
-    }
-#endif
     VSNPRINTF (buf, size, message, va);
-    if (NULL != tmptr)
-      (void) setup_log_file (tmptr);
     if ((0 != (kind & GNUNET_ERROR_TYPE_BULK)) &&
         (0 != last_bulk_time.abs_value_us) &&
         (0 == strncmp (buf, last_bulk, sizeof (last_bulk))))
     {
+      /* suppressed repetition of the last bulk message; only
+	 format the date and touch the log file if we actually
+	 need to report the repetition count now */
       last_bulk_repeat++;
       if ( (GNUNET_TIME_absolute_get_duration (last_bulk_time).rel_value_us >
 	    BULK_DELAY_THRESHOLD) ||
 	   (last_bulk_repeat > BULK_REPEAT_THRESHOLD) )
+      {
+	tmptr = format_date (date);
+	if (NULL != tmptr)
+	  (void) setup_log_file (tmptr);
         flush_bulk (date);
+      }
       return;
     }
+    tmptr = format_date (date);
+    if (NULL != tmptr)
+      (void) setup_log_file (tmptr);
     flush_bulk (date);
     strncpy (last_bulk, buf, sizeof (last_bulk));
     last_bulk_repeat = 0;
@@ -1004,13 +1028,27 @@ GNUNET_log_from_nocheck (enum GNUNET_ErrorType kind, const char *comp,
                          const char *message, ...)
 {
   va_list va;
-  char comp_w_pid[128];
-
-  if (comp == NULL)
-    comp = component_nopid;
+  static char comp_w_pid[128];
+  static const char *last_comp;
 
   va_start (va, message);
-  GNUNET_snprintf (comp_w_pid, sizeof (comp_w_pid), "%s-%d", comp, getpid ());
+  if (comp == NULL)
+  {
+    /* #GNUNET_log_setup() may reallocate the default component,
+       so never cache it by pointer */
+    GNUNET_snprintf (comp_w_pid, sizeof (comp_w_pid), "%s-%d",
+		     component_nopid, getpid ());
+    last_comp = NULL;
+  }
+  else if (comp != last_comp)
+  {
+    /* callers pass string literals here, so the same pointer is
+       given on every call from a component; only re-format the
+       component-pid string when it actually changes */
+    GNUNET_snprintf (comp_w_pid, sizeof (comp_w_pid), "%s-%d", comp,
+		     getpid ());
+    last_comp = comp;
+  }
   mylog (kind, comp_w_pid, message, va);
   va_end (va);
 }
@@ -28,6 +28,7 @@
 #include "gnunet_crypto_lib.h"
 #include "gnunet_strings_lib.h"
 #include "gnunet_configuration_lib.h"
+#include "gnunet_container_lib.h"
 #include "gnunet_disk_lib.h"
 
 #define LOG(kind,...) GNUNET_log_from (kind, "util", __VA_ARGS__)
@@ -72,6 +73,11 @@ struct ConfigSection
    */
   struct ConfigEntry *entries;
 
+  /**
+   * map of entry keys to entries for fast lookup
+   */
+  struct GNUNET_CONTAINER_MultiHashMap *entry_map;
+
   /**
    * name of the section
    */
@@ -89,6 +95,11 @@ struct GNUNET_CONFIGURATION_Handle
    */
   struct ConfigSection *sections;
 
+  /**
+   * Map of section names to sections for fast lookup.
+   */
+  struct GNUNET_CONTAINER_MultiHashMap *section_map;
+
   /**
    * Modification indication since last save
    * #GNUNET_NO if clean, #GNUNET_YES if dirty,
@@ -99,6 +110,28 @@ struct GNUNET_CONFIGURATION_Handle
 };
 
 
+/**
+ * Calculate the hash map key for a section or option name.
+ * Names are case-insensitive, so the name is lowercased before hashing.
+ *
+ * @param name section or option name
+ * @param[out] key where to store the key
+ */
+static void
+config_name_hash (const char *name,
+                  struct GNUNET_HashCode *key)
+{
+  char *lc;
+  char *p;
+
+  lc = GNUNET_strdup (name);
+  for (p = lc; '\0' != *p; p++)
+    *p = (char) tolower ((unsigned char) *p);
+  GNUNET_CRYPTO_hash (lc, strlen (lc), key);
+  GNUNET_free (lc);
+}
+
+
 /**
  * Used for diffing a configuration object against
  * the default one
@@ -119,7 +152,11 @@ struct DiffHandle
 struct GNUNET_CONFIGURATION_Handle *
 GNUNET_CONFIGURATION_create ()
 {
-  return GNUNET_new (struct GNUNET_CONFIGURATION_Handle);
+  struct GNUNET_CONFIGURATION_Handle *cfg;
+
+  cfg = GNUNET_new (struct GNUNET_CONFIGURATION_Handle);
+  cfg->section_map = GNUNET_CONTAINER_multihashmap_create (32, GNUNET_NO);
+  return cfg;
 }
 
 
@@ -135,6 +172,7 @@ GNUNET_CONFIGURATION_destroy (struct GNUNET_CONFIGURATION_Handle *cfg)
 
   while (NULL != (sec = cfg->sections))
     GNUNET_CONFIGURATION_remove_section (cfg, sec->name);
+  GNUNET_CONTAINER_multihashmap_destroy (cfg->section_map);
   GNUNET_free (cfg);
 }
 
@@ -605,6 +643,7 @@ GNUNET_CONFIGURATION_remove_section (struct GNUNET_CONFIGURATION_Handle *cfg,
   struct ConfigSection *spos;
   struct ConfigSection *prev;
   struct ConfigEntry *ent;
+  struct GNUNET_HashCode key;
 
   prev = NULL;
   spos = cfg->sections;
@@ -616,6 +655,10 @@ GNUNET_CONFIGURATION_remove_section (struct GNUNET_CONFIGURATION_Handle *cfg,
         cfg->sections = spos->next;
       else
         prev->next = spos->next;
+      config_name_hash (spos->name, &key);
+      GNUNET_assert (GNUNET_YES ==
+                     GNUNET_CONTAINER_multihashmap_remove (cfg->section_map,
+                                                           &key, spos));
       while (NULL != (ent = spos->entries))
       {
         spos->entries = ent->next;
@@ -624,6 +667,7 @@ GNUNET_CONFIGURATION_remove_section (struct GNUNET_CONFIGURATION_Handle *cfg,
         GNUNET_free (ent);
         cfg->dirty = GNUNET_YES;
       }
+      GNUNET_CONTAINER_multihashmap_destroy (spos->entry_map);
       GNUNET_free (spos->name);
       GNUNET_free (spos);
       return;
@@ -683,12 +727,10 @@ static struct ConfigSection *
 find_section (const struct GNUNET_CONFIGURATION_Handle *cfg,
              const char *section)
 {
-  struct ConfigSection *pos;
+  struct GNUNET_HashCode key;
 
-  pos = cfg->sections;
-  while ((pos != NULL) && (0 != strcasecmp (section, pos->name)))
-    pos = pos->next;
-  return pos;
+  config_name_hash (section, &key);
+  return GNUNET_CONTAINER_multihashmap_get (cfg->section_map, &key);
 }
 
 
@@ -706,14 +748,12 @@ find_entry (const struct GNUNET_CONFIGURATION_Handle *cfg,
            const char *key)
 {
   struct ConfigSection *sec;
-  struct ConfigEntry *pos;
+  struct GNUNET_HashCode map_key;
 
   if (NULL == (sec = find_section (cfg, section)))
     return NULL;
-  pos = sec->entries;
-  while ((pos != NULL) && (0 != strcasecmp (key, pos->key)))
-    pos = pos->next;
-  return pos;
+  config_name_hash (key, &map_key);
+  return GNUNET_CONTAINER_multihashmap_get (sec->entry_map, &map_key);
 }
 
 
@@ -804,6 +844,7 @@ GNUNET_CONFIGURATION_set_value_string (struct GNUNET_CONFIGURATION_Handle *cfg,
 {
   struct ConfigSection *sec;
   struct ConfigEntry *e;
+  struct GNUNET_HashCode key;
   char *nv;
 
   e = find_entry (cfg, section, option);
@@ -827,14 +868,24 @@ GNUNET_CONFIGURATION_set_value_string (struct GNUNET_CONFIGURATION_Handle *cfg,
   {
     sec = GNUNET_new (struct ConfigSection);
     sec->name = GNUNET_strdup (section);
+    sec->entry_map = GNUNET_CONTAINER_multihashmap_create (16, GNUNET_NO);
     sec->next = cfg->sections;
     cfg->sections = sec;
+    config_name_hash (sec->name, &key);
+    GNUNET_assert (GNUNET_OK ==
+                   GNUNET_CONTAINER_multihashmap_put (cfg->section_map, &key,
+                                                      sec,
+                                                      GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST));
   }
   e = GNUNET_new (struct ConfigEntry);
   e->key = GNUNET_strdup (option);
   e->val = GNUNET_strdup (value);
   e->next = sec->entries;
   sec->entries = e;
+  config_name_hash (e->key, &key);
+  GNUNET_assert (GNUNET_OK ==
+                 GNUNET_CONTAINER_multihashmap_put (sec->entry_map, &key, e,
+                                                    GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST));
 }
 
 
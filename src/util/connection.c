@@ -1421,10 +1421,33 @@ transmit_ready (void *cls,
         GNUNET_realloc (connection->write_buffer, connection->nth.notify_size);
     connection->write_buffer_size = connection->nth.notify_size;
   }
-  process_notify (connection);
+  if (GNUNET_YES == process_notify (connection))
+  {
+    /* Completing the notify typically causes the next queued message
+       to be registered right away (i.e. by the client library).  As
+       long as that is the case and the data fits into the remaining
+       buffer space, consume it as well, so that a single send() below
+       flushes all of them.  The transmissions are consumed on a
+       writable socket, so coalescing adds no latency. */
+    while (NULL != connection->nth.notify_ready)
+    {
+      if (NULL != connection->write_task)
+      {
+        /* registering the next transmission scheduled a write task;
+           we are in the write loop already, so take it back */
+        GNUNET_SCHEDULER_cancel (connection->write_task);
+        connection->write_task = NULL;
+      }
+      if (GNUNET_NO == process_notify (connection))
+        break;                  /* out of buffer space */
+    }
+  }
   have = connection->write_buffer_off - connection->write_buffer_pos;
   if (0 == have)
   {
+    if (NULL != connection->nth.notify_ready)
+      goto SCHEDULE_WRITE;      /* pending message did not fit into the
+                                   current buffer, write loop must go on */
     /* no data ready for writing, terminate write loop */
     return;
   }
@@ -32,6 +32,22 @@
 
 #define EXTRA_CHECKS 0
 
+/**
+ * Number of children per node.  The heap is stored as an implicit
+ * d-ary tree in an array: the children of the node at offset i are
+ * at offsets i * HEAP_ARITY + 1 through i * HEAP_ARITY + HEAP_ARITY.
+ * A higher arity makes the tree shallower, so cost updates (which
+ * mostly sift up) touch fewer array entries.
+ */
+#define HEAP_ARITY 4
+
+/**
+ * Maximum number of removed nodes kept for reuse.  Heaps that churn
+ * (remove and re-insert constantly) then serve node allocations from
+ * the pool instead of malloc.
+ */
+#define NODE_POOL_MAX 128
+
 /**
  * Node in the heap.
  */
@@ -42,21 +58,6 @@ struct GNUNET_CONTAINER_HeapNode
    */
   struct GNUNET_CONTAINER_Heap *heap;
 
-  /**
-   * Parent node.
-   */
-  struct GNUNET_CONTAINER_HeapNode *parent;
-
-  /**
-   * Left child.
-   */
-  struct GNUNET_CONTAINER_HeapNode *left_child;
-
-  /**
-   * Right child.
-   */
-  struct GNUNET_CONTAINER_HeapNode *right_child;
-
   /**
    * Our element.
    */
@@ -68,10 +69,15 @@ struct GNUNET_CONTAINER_HeapNode
   GNUNET_CONTAINER_HeapCostType cost;
 
   /**
-   * Number of elements below this node in the heap
-   * (excluding this node itself).
+   * Current offset of this node in the heap's node array.
    */
-  unsigned int tree_size;
+  unsigned int index;
+
+  /**
+   * Link for the heap's node pool; only valid while the node
+   * is not in the heap.
+   */
+  struct GNUNET_CONTAINER_HeapNode *pool_next;
 
 };
 
@@ -82,20 +88,35 @@ struct GNUNET_CONTAINER_Heap
 {
 
   /**
-   * Root of the heap.
+   * Array of the nodes in the heap, in implicit d-ary tree order.
    */
-  struct GNUNET_CONTAINER_HeapNode *root;
+  struct GNUNET_CONTAINER_HeapNode **nodes;
 
   /**
-   * Current position of our random walk.
+   * Removed nodes kept for reuse.
    */
-  struct GNUNET_CONTAINER_HeapNode *walk_pos;
+  struct GNUNET_CONTAINER_HeapNode *pool;
 
   /**
    * Number of elements in the heap.
    */
   unsigned int size;
 
+  /**
+   * Allocated length of the @e nodes array.
+   */
+  unsigned int nodes_length;
+
+  /**
+   * Number of nodes in the @e pool.
+   */
+  unsigned int pool_size;
+
+  /**
+   * Current offset of our random walk.
+   */
+  unsigned int walk_off;
+
   /**
    * How is the heap sorted?
    */
@@ -104,30 +125,52 @@ struct GNUNET_CONTAINER_Heap
 };
 
 
+/**
+ * Check if node 'a' belongs above node 'b' given the
+ * ordering of the heap.
+ *
+ * @param heap heap the nodes belong to
+ * @param a first node
+ * @param b second node
+ * @return GNUNET_YES if 'a' may be an ancestor of 'b'
+ */
+static int
+is_above (const struct GNUNET_CONTAINER_Heap *heap,
+          const struct GNUNET_CONTAINER_HeapNode *a,
+          const struct GNUNET_CONTAINER_HeapNode *b)
+{
+  if (heap->order == GNUNET_CONTAINER_HEAP_ORDER_MAX)
+    return (a->cost >= b->cost) ? GNUNET_YES : GNUNET_NO;
+  return (a->cost <= b->cost) ? GNUNET_YES : GNUNET_NO;
+}
+
+
 #if EXTRA_CHECKS
 /**
- * Check if internal invariants hold for the given node.
+ * Check if internal invariants hold for the given heap.
  *
- * @param node subtree to check
+ * @param heap heap to check
  */
 static void
-check (const struct GNUNET_CONTAINER_HeapNode *node)
+check (const struct GNUNET_CONTAINER_Heap *heap)
 {
-  if (NULL == node)
-    return;
-  GNUNET_assert (node->tree_size ==
-                 ((node->left_child ==
-                   NULL) ? 0 : 1 + node->left_child->tree_size) +
-                 ((node->right_child ==
-                   NULL) ? 0 : 1 + node->right_child->tree_size));
-  check (node->left_child);
-  check (node->right_child);
+  unsigned int i;
+
+  for (i = 0; i < heap->size; i++)
+  {
+    GNUNET_assert (i == heap->nodes[i]->index);
+    if (i > 0)
+      GNUNET_assert (GNUNET_YES ==
+                     is_above (heap,
+                               heap->nodes[(i - 1) / HEAP_ARITY],
+                               heap->nodes[i]));
+  }
 }
 
 
-#define CHECK(n) check(n)
+#define CHECK(h) check(h)
 #else
-#define CHECK(n) do {} while (0)
+#define CHECK(h) do {} while (0)
 #endif
 
 
@@ -157,7 +200,15 @@ GNUNET_CONTAINER_heap_create (enum GNUNET_CONTAINER_HeapOrder order)
 void
 GNUNET_CONTAINER_heap_destroy (struct GNUNET_CONTAINER_Heap *heap)
 {
+  struct GNUNET_CONTAINER_HeapNode *node;
+
   GNUNET_break (heap->size == 0);
+  while (NULL != (node = heap->pool))
+  {
+    heap->pool = node->pool_next;
+    GNUNET_free (node);
+  }
+  GNUNET_array_grow (heap->nodes, heap->nodes_length, 0);
   GNUNET_free (heap);
 }
 
@@ -171,9 +222,9 @@ GNUNET_CONTAINER_heap_destroy (struct GNUNET_CONTAINER_Heap *heap)
 void *
 GNUNET_CONTAINER_heap_peek (const struct GNUNET_CONTAINER_Heap *heap)
 {
-  if (heap->root == NULL)
+  if (0 == heap->size)
     return NULL;
-  return heap->root->element;
+  return heap->nodes[0]->element;
 }
 
 
@@ -191,12 +242,12 @@ GNUNET_CONTAINER_heap_peek2 (const struct GNUNET_CONTAINER_Heap *heap,
                              void **element,
                              GNUNET_CONTAINER_HeapCostType *cost)
 {
-  if (NULL == heap->root)
+  if (0 == heap->size)
     return GNUNET_NO;
   if (NULL != element)
-    *element = heap->root->element;
+    *element = heap->nodes[0]->element;
   if (NULL != cost)
-    *cost = heap->root->cost;
+    *cost = heap->nodes[0]->cost;
   return GNUNET_YES;
 }
 
@@ -228,32 +279,6 @@ GNUNET_CONTAINER_heap_node_get_cost (const struct GNUNET_CONTAINER_HeapNode
 }
 
 
-/**
- * Iterate over the children of the given node.
- *
- * @param heap argument to give to iterator
- * @param node node to iterate over
- * @param iterator function to call on each node
- * @param iterator_cls closure for iterator
- * @return GNUNET_YES to continue to iterate
- */
-static int
-node_iterator (const struct GNUNET_CONTAINER_Heap *heap,
-               struct GNUNET_CONTAINER_HeapNode *node,
-               GNUNET_CONTAINER_HeapIterator iterator, void *iterator_cls)
-{
-  if (node == NULL)
-    return GNUNET_YES;
-  if (GNUNET_YES !=
-      node_iterator (heap, node->left_child, iterator, iterator_cls))
-    return GNUNET_NO;
-  if (GNUNET_YES !=
-      node_iterator (heap, node->right_child, iterator, iterator_cls))
-    return GNUNET_NO;
-  return iterator (iterator_cls, node, node->element, node->cost);
-}
-
-
 /**
  * Iterate over all entries in the heap.
  *
@@ -266,7 +291,17 @@ GNUNET_CONTAINER_heap_iterate (const struct GNUNET_CONTAINER_Heap *heap,
                                GNUNET_CONTAINER_HeapIterator iterator,
                                void *iterator_cls)
 {
-  (void) node_iterator (heap, heap->root, iterator, iterator_cls);
+  struct GNUNET_CONTAINER_HeapNode *node;
+  unsigned int i;
+
+  /* iterate backwards so that the iterator may remove the current
+     node (which swaps in an already-visited node from the end) */
+  for (i = heap->size; i > 0; i--)
+  {
+    node = heap->nodes[i - 1];
+    if (GNUNET_YES != iterator (iterator_cls, node, node->element, node->cost))
+      return;
+  }
 }
 
 
@@ -284,81 +319,83 @@ GNUNET_CONTAINER_heap_iterate (const struct GNUNET_CONTAINER_Heap *heap,
 void *
 GNUNET_CONTAINER_heap_walk_get_next (struct GNUNET_CONTAINER_Heap *heap)
 {
-  struct GNUNET_CONTAINER_HeapNode *pos;
+  unsigned int pos;
   void *element;
 
-  if (heap->root == NULL)
+  if (0 == heap->size)
     return NULL;
-  pos = heap->walk_pos;
-  if (pos == NULL)
-    pos = heap->root;
-  element = pos->element;
-  heap->walk_pos =
-      (0 ==
-       GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK,
-                                 2)) ? pos->right_child : pos->left_child;
+  pos = heap->walk_off;
+  if (pos >= heap->size)
+    pos = 0;
+  element = heap->nodes[pos]->element;
+  /* descend to a random child; walking past a leaf makes the
+     next call start over at the root */
+  heap->walk_off =
+      pos * HEAP_ARITY + 1 +
+      GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_WEAK, HEAP_ARITY);
   return element;
 }
 
 
 /**
- * Insert the given node 'node' into the subtree starting
- * at 'pos' (while keeping the tree somewhat balanced).
+ * Move the node at offset 'idx' towards the root until
+ * the heap invariant is restored.
  *
  * @param heap heap to modify
- * @param pos existing tree
- * @param node node to insert (which may be a subtree itself)
+ * @param idx offset of the node to move
  */
 static void
-insert_node (struct GNUNET_CONTAINER_Heap *heap,
-             struct GNUNET_CONTAINER_HeapNode *pos,
-             struct GNUNET_CONTAINER_HeapNode *node)
+sift_up (struct GNUNET_CONTAINER_Heap *heap, unsigned int idx)
 {
-  struct GNUNET_CONTAINER_HeapNode *parent;
+  struct GNUNET_CONTAINER_HeapNode *node = heap->nodes[idx];
+  unsigned int parent;
 
-  GNUNET_assert (node->parent == NULL);
-  while ((heap->order == GNUNET_CONTAINER_HEAP_ORDER_MAX) ? (pos->cost >=
-                                                             node->cost)
-         : (pos->cost <= node->cost))
-  {
-    /* node is descendent of pos */
-    pos->tree_size += (1 + node->tree_size);
-    if (pos->left_child == NULL)
-    {
-      pos->left_child = node;
-      node->parent = pos;
-      return;
-    }
-    if (pos->right_child == NULL)
-    {
-      pos->right_child = node;
-      node->parent = pos;
-      return;
-    }
-    /* keep it balanced by descending into smaller subtree */
-    if (pos->left_child->tree_size < pos->right_child->tree_size)
-      pos = pos->left_child;
-    else
-      pos = pos->right_child;
-  }
-  /* make 'node' parent of 'pos' */
-  parent = pos->parent;
-  pos->parent = NULL;
-  node->parent = parent;
-  if (NULL == parent)
+  while (idx > 0)
   {
-    heap->root = node;
+    parent = (idx - 1) / HEAP_ARITY;
+    if (GNUNET_YES == is_above (heap, heap->nodes[parent], node))
+      break;
+    heap->nodes[idx] = heap->nodes[parent];
+    heap->nodes[idx]->index = idx;
+    idx = parent;
   }
-  else
+  heap->nodes[idx] = node;
+  node->index = idx;
+}
+
+
+/**
+ * Move the node at offset 'idx' towards the leaves until
+ * the heap invariant is restored.
+ *
+ * @param heap heap to modify
+ * @param idx offset of the node to move
+ */
+static void
+sift_down (struct GNUNET_CONTAINER_Heap *heap, unsigned int idx)
+{
+  struct GNUNET_CONTAINER_HeapNode *node = heap->nodes[idx];
+  unsigned int child;
+  unsigned int best;
+  unsigned int k;
+
+  while (1)
   {
-    if (parent->left_child == pos)
-      parent->left_child = node;
-    else
-      parent->right_child = node;
+    child = idx * HEAP_ARITY + 1;
+    if (child >= heap->size)
+      break;
+    best = child;
+    for (k = child + 1; (k < child + HEAP_ARITY) && (k < heap->size); k++)
+      if (GNUNET_YES != is_above (heap, heap->nodes[best], heap->nodes[k]))
+	best = k;
+    if (GNUNET_YES == is_above (heap, node, heap->nodes[best]))
+      break;
+    heap->nodes[idx] = heap->nodes[best];
+    heap->nodes[idx]->index = idx;
+    idx = best;
   }
-  /* insert 'pos' below 'node' */
-  insert_node (heap, node, pos);
-  CHECK (pos);
+  heap->nodes[idx] = node;
+  node->index = idx;
 }
 
 
@@ -376,21 +413,55 @@ GNUNET_CONTAINER_heap_insert (struct GNUNET_CONTAINER_Heap *heap, void *element,
 {
   struct GNUNET_CONTAINER_HeapNode *node;
 
-  node = GNUNET_new (struct GNUNET_CONTAINER_HeapNode);
-  node->heap = heap;
+  if (NULL != heap->pool)
+  {
+    node = heap->pool;
+    heap->pool = node->pool_next;
+    heap->pool_size--;
+    node->pool_next = NULL;
+  }
+  else
+  {
+    node = GNUNET_new (struct GNUNET_CONTAINER_HeapNode);
+    node->heap = heap;
+  }
   node->element = element;
   node->cost = cost;
+  if (heap->size == heap->nodes_length)
+    GNUNET_array_grow (heap->nodes, heap->nodes_length,
+		       (0 == heap->nodes_length) ? 16 : heap->nodes_length * 2);
+  heap->nodes[heap->size] = node;
+  node->index = heap->size;
   heap->size++;
-  if (NULL == heap->root)
-    heap->root = node;
-  else
-    insert_node (heap, heap->root, node);
-  GNUNET_assert (heap->size == heap->root->tree_size + 1);
-  CHECK (heap->root);
+  sift_up (heap, node->index);
+  CHECK (heap);
   return node;
 }
 
 
+/**
+ * Release the given node back into the heap's node pool (or
+ * free it if the pool is full).
+ *
+ * @param heap heap the node belonged to
+ * @param node node to release
+ */
+static void
+release_node (struct GNUNET_CONTAINER_Heap *heap,
+              struct GNUNET_CONTAINER_HeapNode *node)
+{
+  if (heap->pool_size >= NODE_POOL_MAX)
+  {
+    GNUNET_free (node);
+    return;
+  }
+  node->element = NULL;
+  node->pool_next = heap->pool;
+  heap->pool = node;
+  heap->pool_size++;
+}
+
+
 /**
  * Remove root of the heap.
  *
@@ -400,113 +471,26 @@ GNUNET_CONTAINER_heap_insert (struct GNUNET_CONTAINER_Heap *heap, void *element,
 void *
 GNUNET_CONTAINER_heap_remove_root (struct GNUNET_CONTAINER_Heap *heap)
 {
-  void *ret;
   struct GNUNET_CONTAINER_HeapNode *root;
+  void *ret;
 
-  if (NULL == (root = heap->root))
+  if (0 == heap->size)
     return NULL;
-  heap->size--;
+  root = heap->nodes[0];
   ret = root->element;
-  if (root->left_child == NULL)
-  {
-    heap->root = root->right_child;
-    if (root->right_child != NULL)
-      root->right_child->parent = NULL;
-  }
-  else if (root->right_child == NULL)
-  {
-    heap->root = root->left_child;
-    root->left_child->parent = NULL;
-  }
-  else
+  heap->size--;
+  if (heap->size > 0)
   {
-    root->left_child->parent = NULL;
-    root->right_child->parent = NULL;
-    heap->root = root->left_child;
-    insert_node (heap, heap->root, root->right_child);
+    heap->nodes[0] = heap->nodes[heap->size];
+    heap->nodes[0]->index = 0;
+    sift_down (heap, 0);
   }
-  if (heap->walk_pos == root)
-    heap->walk_pos = heap->root;
-  GNUNET_free (root);
-#if EXTRA_CHECKS
-  GNUNET_assert (((heap->size == 0) && (heap->root == NULL)) ||
-                 (heap->size == heap->root->tree_size + 1));
-  CHECK (heap->root);
-#endif
+  release_node (heap, root);
+  CHECK (heap);
   return ret;
 }
 
 
-/**
- * Remove the given node 'node' from the tree and update
- * the 'tree_size' fields accordingly.  Preserves the
- * children of 'node' and does NOT change the overall
- * 'size' field of the tree.
- */
-static void
-remove_node (struct GNUNET_CONTAINER_HeapNode *node)
-{
-  struct GNUNET_CONTAINER_HeapNode *ancestor;
-  struct GNUNET_CONTAINER_Heap *heap = node->heap;
-
-  /* update 'size' of the ancestors */
-  ancestor = node;
-  while (NULL != (ancestor = ancestor->parent))
-    ancestor->tree_size--;
-
-  /* update 'size' of node itself */
-  if (node->left_child != NULL)
-    node->tree_size -= (1 + node->left_child->tree_size);
-  if (node->right_child != NULL)
-    node->tree_size -= (1 + node->right_child->tree_size);
-
-  /* unlink 'node' itself and insert children in its place */
-  if (node->parent == NULL)
-  {
-    if (node->left_child != NULL)
-    {
-      heap->root = node->left_child;
-      node->left_child->parent = NULL;
-      if (node->right_child != NULL)
-      {
-        node->right_child->parent = NULL;
-        insert_node (heap, heap->root, node->right_child);
-      }
-    }
-    else
-    {
-      heap->root = node->right_child;
-      if (node->right_child != NULL)
-        node->right_child->parent = NULL;
-    }
-  }
-  else
-  {
-    if (node->parent->left_child == node)
-      node->parent->left_child = NULL;
-    else
-      node->parent->right_child = NULL;
-    if (node->left_child != NULL)
-    {
-      node->left_child->parent = NULL;
-      node->parent->tree_size -= (1 + node->left_child->tree_size);
-      insert_node (heap, node->parent, node->left_child);
-    }
-    if (node->right_child != NULL)
-    {
-      node->right_child->parent = NULL;
-      node->parent->tree_size -= (1 + node->right_child->tree_size);
-      insert_node (heap, node->parent, node->right_child);
-    }
-  }
-  node->parent = NULL;
-  node->left_child = NULL;
-  node->right_child = NULL;
-  GNUNET_assert (node->tree_size == 0);
-  CHECK (heap->root);
-}
-
-
 /**
  * Removes a node from the heap.
  *
@@ -516,24 +500,25 @@ remove_node (struct GNUNET_CONTAINER_HeapNode *node)
 void *
 GNUNET_CONTAINER_heap_remove_node (struct GNUNET_CONTAINER_HeapNode *node)
 {
-  void *ret;
   struct GNUNET_CONTAINER_Heap *heap;
+  unsigned int idx;
+  void *ret;
 
   heap = node->heap;
-  CHECK (heap->root);
-  if (heap->walk_pos == node)
-    (void) GNUNET_CONTAINER_heap_walk_get_next (heap);
-  remove_node (node);
-  heap->size--;
+  idx = node->index;
   ret = node->element;
-  if (heap->walk_pos == node)
-    heap->walk_pos = NULL;
-  GNUNET_free (node);
-#if EXTRA_CHECKS
-  CHECK (heap->root);
-  GNUNET_assert (((heap->size == 0) && (heap->root == NULL)) ||
-                 (heap->size == heap->root->tree_size + 1));
-#endif
+  heap->size--;
+  if (idx < heap->size)
+  {
+    heap->nodes[idx] = heap->nodes[heap->size];
+    heap->nodes[idx]->index = idx;
+    /* the node swapped in from the end may belong either
+       above or below its new position */
+    sift_down (heap, idx);
+    sift_up (heap, idx);
+  }
+  release_node (heap, node);
+  CHECK (heap);
   return ret;
 }
 
@@ -550,27 +535,10 @@ GNUNET_CONTAINER_heap_update_cost (struct GNUNET_CONTAINER_Heap *heap,
                                    struct GNUNET_CONTAINER_HeapNode *node,
                                    GNUNET_CONTAINER_HeapCostType new_cost)
 {
-#if EXTRA_CHECKS
-  GNUNET_assert (((heap->size == 0) && (heap->root == NULL)) ||
-                 (heap->size == heap->root->tree_size + 1));
-  CHECK (heap->root);
-#endif
-  remove_node (node);
-#if EXTRA_CHECKS
-  CHECK (heap->root);
-  GNUNET_assert (((heap->size == 1) && (heap->root == NULL)) ||
-                 (heap->size == heap->root->tree_size + 2));
-#endif
   node->cost = new_cost;
-  if (heap->root == NULL)
-    heap->root = node;
-  else
-    insert_node (heap, heap->root, node);
-#if EXTRA_CHECKS
-  CHECK (heap->root);
-  GNUNET_assert (((heap->size == 0) && (heap->root == NULL)) ||
-                 (heap->size == heap->root->tree_size + 1));
-#endif
+  sift_up (heap, node->index);
+  sift_down (heap, node->index);
+  CHECK (heap);
 }
 
 
@@ -196,9 +196,25 @@ struct GNUNET_CONTAINER_MetaData
    */
   unsigned int item_count;
 
+  /**
+   * #GNUNET_YES if 'sbuf' came from deserialization and has not
+   * been parsed into the item list yet.
+   */
+  int sbuf_unparsed;
+
 };
 
 
+/**
+ * Decompress and parse the serialization buffer of @a md into the
+ * list of meta data items, if that has not happened yet.
+ *
+ * @param md meta data to materialize
+ */
+static void
+materialize (const struct GNUNET_CONTAINER_MetaData *md);
+
+
 /**
  * Create a fresh struct CONTAINER_MetaData token.
  *
@@ -240,6 +256,7 @@ invalidate_sbuf (struct GNUNET_CONTAINER_MetaData *md)
   GNUNET_free (md->sbuf);
   md->sbuf = NULL;
   md->sbuf_size = 0;
+  md->sbuf_unparsed = GNUNET_NO;
 }
 
 
@@ -309,6 +326,8 @@ GNUNET_CONTAINER_meta_data_test_equal (const struct GNUNET_CONTAINER_MetaData
 
   if (md1 == md2)
     return GNUNET_YES;
+  materialize (md1);
+  materialize (md2);
   if (md1->item_count != md2->item_count)
     return GNUNET_NO;
   for (i = md1->items_head; NULL != i; i = i->next)
@@ -367,6 +386,7 @@ GNUNET_CONTAINER_meta_data_insert (struct GNUNET_CONTAINER_MetaData *md,
       (EXTRACTOR_METAFORMAT_C_STRING == format))
     GNUNET_break ('\0' == data[data_size - 1]);
 
+  materialize (md);
   for (pos = md->items_head; NULL != pos; pos = pos->next)
   {
     if (pos->data_size < data_size)
@@ -485,6 +505,7 @@ GNUNET_CONTAINER_meta_data_delete (struct GNUNET_CONTAINER_MetaData *md,
 {
   struct MetaItem *pos;
 
+  materialize (md);
   for (pos = md->items_head; NULL != pos; pos = pos->next)
   {
     if (pos->data_size < data_size)
@@ -547,6 +568,7 @@ GNUNET_CONTAINER_meta_data_iterate (const struct GNUNET_CONTAINER_MetaData *md,
 
   if (NULL == md)
     return 0;
+  materialize (md);
   if (NULL == iter)
     return md->item_count;
   for (pos = md->items_head; NULL != pos; pos = pos->next)
@@ -576,6 +598,7 @@ GNUNET_CONTAINER_meta_data_get_by_type (const struct GNUNET_CONTAINER_MetaData *
 
   if (NULL == md)
     return NULL;
+  materialize (md);
   for (pos = md->items_head; NULL != pos; pos = pos->next)
     if ((type == pos->type) &&
         ((pos->format == EXTRACTOR_METAFORMAT_UTF8) ||
@@ -639,6 +662,7 @@ GNUNET_CONTAINER_meta_data_get_thumbnail (const struct GNUNET_CONTAINER_MetaData
 
   if (NULL == md)
     return 0;
+  materialize (md);
   match = NULL;
   for (pos = md->items_head; NULL != pos; pos = pos->next)
   {
@@ -676,6 +700,10 @@ GNUNET_CONTAINER_meta_data_duplicate (const struct GNUNET_CONTAINER_MetaData
 
   if (NULL == md)
     return NULL;
+  if (GNUNET_YES == md->sbuf_unparsed)
+    /* only copy the serialization; the duplicate stays lazy */
+    return GNUNET_CONTAINER_meta_data_deserialize (md->sbuf,
+                                                   md->sbuf_size);
   ret = GNUNET_CONTAINER_meta_data_create ();
   for (pos = md->items_tail; NULL != pos; pos = pos->prev)
     GNUNET_CONTAINER_meta_data_insert (ret, pos->plugin_name, pos->type,
@@ -823,6 +851,7 @@ GNUNET_CONTAINER_meta_data_serialize (const struct GNUNET_CONTAINER_MetaData
       return GNUNET_SYSERR;     /* can say that this will fail */
     /* need to compute a partial serialization, sbuf useless ... */
   }
+  materialize (md);
   dst = NULL;
   msize = 0;
   for (pos = md->items_tail; NULL != pos; pos = pos->prev)
@@ -1022,26 +1051,32 @@ GNUNET_CONTAINER_meta_data_get_serialized_size (const struct
 
 
 /**
- * Deserialize meta-data.  Initializes md.
+ * Decompress and parse the serialization buffer of @a md into the
+ * list of meta data items, if that has not happened yet.
+ * #GNUNET_CONTAINER_meta_data_deserialize() keeps the (usually
+ * compressed) serialized form and defers this work, as most meta
+ * data is only passed along and never inspected.  As with filling
+ * the serialization cache, this "modifies" md only in its internal
+ * representation, so we cast away the 'const' instead of making
+ * the API look strange.
  *
- * @param input buffer with the serialized metadata
- * @param size number of bytes available in input
- * @return MD on success, NULL on error (i.e.
- *         bad format)
+ * @param md meta data to materialize
  */
-struct GNUNET_CONTAINER_MetaData *
-GNUNET_CONTAINER_meta_data_deserialize (const char *input, size_t size)
+static void
+materialize (const struct GNUNET_CONTAINER_MetaData *md)
 {
-  struct GNUNET_CONTAINER_MetaData *md;
+  struct GNUNET_CONTAINER_MetaData *vmd;
   struct MetaDataHeader hdr;
   struct MetaDataEntry ent;
   uint32_t ic;
   uint32_t i;
+  char *sbuf;
+  size_t sbuf_size;
   char *data;
   const char *cdata;
-  uint32_t version;
   uint32_t dataSize;
   int compressed;
+  int complete;
   size_t left;
   uint32_t mlen;
   uint32_t plen;
@@ -1052,62 +1087,42 @@ GNUNET_CONTAINER_meta_data_deserialize (const char *input, size_t size)
   const char *mime_type;
   enum EXTRACTOR_MetaFormat format;
 
-  if (size < sizeof (struct MetaDataHeader))
-    return NULL;
-  memcpy (&hdr, input, sizeof (struct MetaDataHeader));
-  version = ntohl (hdr.version) & HEADER_VERSION_MASK;
+  if ((NULL == md) || (GNUNET_YES != md->sbuf_unparsed))
+    return;
+  vmd = (struct GNUNET_CONTAINER_MetaData *) md;
+  /* detach the serialization so that the inserts below do not
+   * invalidate the buffer while we are parsing it */
+  sbuf = vmd->sbuf;
+  sbuf_size = vmd->sbuf_size;
+  vmd->sbuf = NULL;
+  vmd->sbuf_size = 0;
+  vmd->sbuf_unparsed = GNUNET_NO;
+
+  memcpy (&hdr, sbuf, sizeof (struct MetaDataHeader));
   compressed = (ntohl (hdr.version) & HEADER_COMPRESSED) != 0;
-
-  if (1 == version)
-    return NULL;                /* null pointer */
-  if (2 != version)
-  {
-    GNUNET_break_op (0);        /* unsupported version */
-    return NULL;
-  }
-
   ic = ntohl (hdr.entries);
   dataSize = ntohl (hdr.size);
-  if ( ((sizeof (struct MetaDataEntry) * ic) > dataSize) ||
-       ( (0 != ic) &&
-         (dataSize / ic < sizeof (struct MetaDataEntry)) ) )
-  {
-    GNUNET_break_op (0);
-    return NULL;
-  }
-
   if (compressed)
   {
-    if (dataSize >= GNUNET_MAX_MALLOC_CHECKED)
-    {
-      /* make sure we don't blow our memory limit because of a mal-formed
-       * message... */
-      GNUNET_break_op (0);
-      return NULL;
-    }
     data =
-      GNUNET_decompress ((const char *) &input[sizeof (struct MetaDataHeader)],
-                         size - sizeof (struct MetaDataHeader),
+      GNUNET_decompress (&sbuf[sizeof (struct MetaDataHeader)],
+                         sbuf_size - sizeof (struct MetaDataHeader),
                          dataSize);
     if (NULL == data)
     {
       GNUNET_break_op (0);
-      return NULL;
+      GNUNET_free (sbuf);
+      return;
     }
     cdata = data;
   }
   else
   {
     data = NULL;
-    cdata = (const char *) &input[sizeof (struct MetaDataHeader)];
-    if (dataSize != size - sizeof (struct MetaDataHeader))
-    {
-      GNUNET_break_op (0);
-      return NULL;
-    }
+    cdata = &sbuf[sizeof (struct MetaDataHeader)];
   }
 
-  md = GNUNET_CONTAINER_meta_data_create ();
+  complete = GNUNET_YES;
   left = dataSize - ic * sizeof (struct MetaDataEntry);
   mdata = &cdata[ic * sizeof (struct MetaDataEntry)];
   for (i = 0; i < ic; i++)
@@ -1120,6 +1135,7 @@ GNUNET_CONTAINER_meta_data_deserialize (const char *input, size_t size)
         (EXTRACTOR_METAFORMAT_BINARY != format))
     {
       GNUNET_break_op (0);
+      complete = GNUNET_NO;
       break;
     }
     dlen = ntohl (ent.data_size);
@@ -1128,6 +1144,7 @@ GNUNET_CONTAINER_meta_data_deserialize (const char *input, size_t size)
     if (dlen > left)
     {
       GNUNET_break_op (0);
+      complete = GNUNET_NO;
       break;
     }
     left -= dlen;
@@ -1138,23 +1155,27 @@ GNUNET_CONTAINER_meta_data_deserialize (const char *input, size_t size)
       if (0 == dlen)
       {
         GNUNET_break_op (0);
+        complete = GNUNET_NO;
         break;
       }
       if ('\0' != meta_data[dlen - 1])
       {
         GNUNET_break_op (0);
+        complete = GNUNET_NO;
         break;
       }
     }
     if (plen > left)
     {
       GNUNET_break_op (0);
+      complete = GNUNET_NO;
       break;
     }
     left -= plen;
     if ((plen > 0) && ('\0' != mdata[left + plen - 1]))
     {
       GNUNET_break_op (0);
+      complete = GNUNET_NO;
       break;
     }
     if (0 == plen)
@@ -1165,24 +1186,111 @@ GNUNET_CONTAINER_meta_data_deserialize (const char *input, size_t size)
     if (mlen > left)
     {
       GNUNET_break_op (0);
+      complete = GNUNET_NO;
       break;
     }
     left -= mlen;
     if ((mlen > 0) && ('\0' != mdata[left + mlen - 1]))
     {
       GNUNET_break_op (0);
+      complete = GNUNET_NO;
       break;
     }
     if (0 == mlen)
       mime_type = NULL;
     else
       mime_type = &mdata[left];
-    GNUNET_CONTAINER_meta_data_insert (md, plugin_name,
+    GNUNET_CONTAINER_meta_data_insert (vmd, plugin_name,
                                        (enum EXTRACTOR_MetaType)
                                        ntohl (ent.type), format, mime_type,
                                        meta_data, dlen);
   }
   GNUNET_free_non_null (data);
+  if (GNUNET_YES == complete)
+  {
+    /* the serialization still matches the items, re-attach it
+     * as the serialization cache */
+    vmd->sbuf = sbuf;
+    vmd->sbuf_size = sbuf_size;
+  }
+  else
+  {
+    GNUNET_free (sbuf);
+  }
+}
+
+
+/**
+ * Deserialize meta-data.  Initializes md.  Note that the format of
+ * the serialized data is validated, but decompressing and parsing
+ * the individual items is deferred until the first access.
+ *
+ * @param input buffer with the serialized metadata
+ * @param size number of bytes available in input
+ * @return MD on success, NULL on error (i.e.
+ *         bad format)
+ */
+struct GNUNET_CONTAINER_MetaData *
+GNUNET_CONTAINER_meta_data_deserialize (const char *input, size_t size)
+{
+  struct GNUNET_CONTAINER_MetaData *md;
+  struct MetaDataHeader hdr;
+  uint32_t ic;
+  uint32_t version;
+  uint32_t dataSize;
+  int compressed;
+
+  if (size < sizeof (struct MetaDataHeader))
+    return NULL;
+  memcpy (&hdr, input, sizeof (struct MetaDataHeader));
+  version = ntohl (hdr.version) & HEADER_VERSION_MASK;
+  compressed = (ntohl (hdr.version) & HEADER_COMPRESSED) != 0;
+
+  if (1 == version)
+    return NULL;                /* null pointer */
+  if (2 != version)
+  {
+    GNUNET_break_op (0);        /* unsupported version */
+    return NULL;
+  }
+
+  ic = ntohl (hdr.entries);
+  dataSize = ntohl (hdr.size);
+  if ( ((sizeof (struct MetaDataEntry) * ic) > dataSize) ||
+       ( (0 != ic) &&
+         (dataSize / ic < sizeof (struct MetaDataEntry)) ) )
+  {
+    GNUNET_break_op (0);
+    return NULL;
+  }
+
+  if (compressed)
+  {
+    if (dataSize >= GNUNET_MAX_MALLOC_CHECKED)
+    {
+      /* make sure we don't blow our memory limit because of a mal-formed
+       * message... */
+      GNUNET_break_op (0);
+      return NULL;
+    }
+  }
+  else
+  {
+    if (dataSize != size - sizeof (struct MetaDataHeader))
+    {
+      GNUNET_break_op (0);
+      return NULL;
+    }
+  }
+
+  /* defer decompression and parsing until the items are accessed;
+   * most meta data is only stored or forwarded and the serialized
+   * form is all that is needed for that */
+  md = GNUNET_CONTAINER_meta_data_create ();
+  md->sbuf = GNUNET_malloc (size);
+  memcpy (md->sbuf, input, size);
+  md->sbuf_size = size;
+  md->sbuf_unparsed = GNUNET_YES;
   return md;
 }
 
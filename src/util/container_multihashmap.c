@@ -28,6 +28,14 @@
 
 #define LOG(kind,...) GNUNET_log_from (kind, "util", __VA_ARGS__)
 
+/**
+ * Maximum number of buckets of the old bucket array that are migrated
+ * per modifying operation while an incremental resize is in progress.
+ * Bounds the latency added to any single put/remove, in contrast to
+ * rehashing the entire map in one go.
+ */
+#define SPLIT_BATCH_SIZE 8
+
 /**
  * An entry in the hash map with the full key.
  */
@@ -103,6 +111,13 @@ struct GNUNET_CONTAINER_MultiHashMap
    */
   union MapEntry *map;
 
+  /**
+   * Previous (smaller) bucket array; non-NULL only while an
+   * incremental resize is in progress.  Buckets below @e split_idx
+   * have already been migrated to @e map.
+   */
+  union MapEntry *old_map;
+
   /**
    * Number of entries in the map.
    */
@@ -113,6 +128,18 @@ struct GNUNET_CONTAINER_MultiHashMap
    */
   unsigned int map_length;
 
+  /**
+   * Length of the @e old_map array, only valid while @e old_map
+   * is non-NULL.
+   */
+  unsigned int old_map_length;
+
+  /**
+   * Next bucket of @e old_map to migrate to @e map, only valid
+   * while @e old_map is non-NULL.
+   */
+  unsigned int split_idx;
+
   /**
    * #GNUNET_NO if the map entries are of type 'struct BigMapEntry',
    * #GNUNET_YES if the map entries are of type 'struct SmallMapEntry'.
@@ -143,6 +170,12 @@ struct GNUNET_CONTAINER_MultiHashMapIterator
    */
   unsigned int idx;
 
+  /**
+   * #GNUNET_YES while we are iterating over the not-yet migrated
+   * buckets of the map's old bucket array.
+   */
+  int in_old;
+
   /**
    * Modification counter as observed on the map when the iterator
    * was created.
@@ -156,6 +189,19 @@ struct GNUNET_CONTAINER_MultiHashMapIterator
 };
 
 
+/**
+ * Migrate up to @a limit buckets of the old bucket array into the
+ * (larger) current bucket array.  Releases the old array once the
+ * last bucket has been migrated.
+ *
+ * @param map hash map with an incremental resize in progress
+ * @param limit maximum number of buckets to migrate
+ */
+static void
+split_step (struct GNUNET_CONTAINER_MultiHashMap *map,
+            unsigned int limit);
+
+
 /**
  * Create a multi hash map.
  *
@@ -199,6 +245,12 @@ GNUNET_CONTAINER_multihashmap_destroy (struct GNUNET_CONTAINER_MultiHashMap
   unsigned int i;
   union MapEntry me;
 
+  if (NULL != map->old_map)
+  {
+    /* finish pending incremental resize so we only
+       have to free one bucket array below */
+    split_step (map, map->old_map_length);
+  }
   for (i = 0; i < map->map_length; i++)
   {
     me = map->map[i];
@@ -250,6 +302,84 @@ idx_of (const struct GNUNET_CONTAINER_MultiHashMap *map,
 }
 
 
+/**
+ * Find the bucket the given key currently lives in, taking an
+ * in-progress incremental resize into account: keys whose old bucket
+ * has not been migrated yet are still in the old bucket array.
+ *
+ * @param map hash map to look in
+ * @param key key to locate the bucket for
+ * @return pointer to the bucket for @a key
+ */
+static union MapEntry *
+bucket_of (const struct GNUNET_CONTAINER_MultiHashMap *map,
+           const struct GNUNET_HashCode *key)
+{
+  unsigned int idx;
+
+  if (NULL != map->old_map)
+  {
+    idx = (*(unsigned int *) key) % map->old_map_length;
+    if (idx >= map->split_idx)
+      return &map->old_map[idx];
+  }
+  return &map->map[idx_of (map, key)];
+}
+
+
+/**
+ * Migrate up to @a limit buckets of the old bucket array into the
+ * (larger) current bucket array.  Releases the old array once the
+ * last bucket has been migrated.
+ *
+ * @param map hash map with an incremental resize in progress
+ * @param limit maximum number of buckets to migrate
+ */
+static void
+split_step (struct GNUNET_CONTAINER_MultiHashMap *map,
+            unsigned int limit)
+{
+  union MapEntry *bucket;
+  unsigned int idx;
+  unsigned int k;
+
+  for (k = 0; (k < limit) && (NULL != map->old_map); k++)
+  {
+    bucket = &map->old_map[map->split_idx];
+    if (map->use_small_entries)
+    {
+      struct SmallMapEntry *sme;
+
+      while (NULL != (sme = bucket->sme))
+      {
+	bucket->sme = sme->next;
+	idx = idx_of (map, sme->key);
+	sme->next = map->map[idx].sme;
+	map->map[idx].sme = sme;
+      }
+    }
+    else
+    {
+      struct BigMapEntry *bme;
+
+      while (NULL != (bme = bucket->bme))
+      {
+	bucket->bme = bme->next;
+	idx = idx_of (map, &bme->key);
+	bme->next = map->map[idx].bme;
+	map->map[idx].bme = bme;
+      }
+    }
+    map->split_idx++;
+    if (map->split_idx == map->old_map_length)
+    {
+      GNUNET_free (map->old_map);
+      map->old_map = NULL;
+    }
+  }
+}
+
+
 /**
  * Get the number of key-value pairs in the map.
  *
@@ -280,7 +410,7 @@ GNUNET_CONTAINER_multihashmap_get (const struct GNUNET_CONTAINER_MultiHashMap *m
 {
   union MapEntry me;
 
-  me = map->map[idx_of (map, key)];
+  me = *bucket_of (map, key);
   if (map->use_small_entries)
   {
     struct SmallMapEntry *sme;
@@ -318,47 +448,67 @@ GNUNET_CONTAINER_multihashmap_iterate (const struct
 {
   int count;
   unsigned int i;
+  unsigned int len;
+  union MapEntry *buckets;
   union MapEntry me;
   struct GNUNET_HashCode kc;
+  int pass;
 
   count = 0;
   GNUNET_assert (NULL != map);
-  for (i = 0; i < map->map_length; i++)
+  for (pass = 0; pass < 2; pass++)
   {
-    me = map->map[i];
-    if (map->use_small_entries)
+    /* first pass covers the not-yet migrated buckets of the old
+       bucket array (if any), second pass the current one */
+    if (0 == pass)
     {
-      struct SmallMapEntry *sme;
-      struct SmallMapEntry *nxt;
-
-      nxt = me.sme;
-      while (NULL != (sme = nxt))
-      {
-	nxt = sme->next;
-	if (NULL != it)
-	{
-	  if (GNUNET_OK != it (it_cls, sme->key, sme->value))
-	    return GNUNET_SYSERR;
-	}
-	count++;
-      }
+      if (NULL == map->old_map)
+	continue;
+      buckets = &map->old_map[map->split_idx];
+      len = map->old_map_length - map->split_idx;
     }
     else
     {
-      struct BigMapEntry *bme;
-      struct BigMapEntry *nxt;
+      buckets = map->map;
+      len = map->map_length;
+    }
+    for (i = 0; i < len; i++)
+    {
+      me = buckets[i];
+      if (map->use_small_entries)
+      {
+	struct SmallMapEntry *sme;
+	struct SmallMapEntry *nxt;
 
-      nxt = me.bme;
-      while (NULL != (bme = nxt))
+	nxt = me.sme;
+	while (NULL != (sme = nxt))
+	{
+	  nxt = sme->next;
+	  if (NULL != it)
+	  {
+	    if (GNUNET_OK != it (it_cls, sme->key, sme->value))
+	      return GNUNET_SYSERR;
+	  }
+	  count++;
+	}
+      }
+      else
       {
-	nxt = bme->next;
-	if (NULL != it)
+	struct BigMapEntry *bme;
+	struct BigMapEntry *nxt;
+
+	nxt = me.bme;
+	while (NULL != (bme = nxt))
 	{
-	  kc = bme->key;
-	  if (GNUNET_OK != it (it_cls, &kc, bme->value))
-	    return GNUNET_SYSERR;
+	  nxt = bme->next;
+	  if (NULL != it)
+	  {
+	    kc = bme->key;
+	    if (GNUNET_OK != it (it_cls, &kc, bme->value))
+	      return GNUNET_SYSERR;
+	  }
+	  count++;
 	}
-	count++;
       }
     }
   }
@@ -382,26 +532,24 @@ GNUNET_CONTAINER_multihashmap_remove (struct GNUNET_CONTAINER_MultiHashMap *map,
                                       const struct GNUNET_HashCode *key,
 				      const void *value)
 {
-  union MapEntry me;
-  unsigned int i;
+  union MapEntry *bucket;
 
   map->modification_counter++;
 
-  i = idx_of (map, key);
-  me = map->map[i];
+  bucket = bucket_of (map, key);
   if (map->use_small_entries)
   {
     struct SmallMapEntry *sme;
     struct SmallMapEntry *p;
 
     p = NULL;
-    for (sme = me.sme; NULL != sme; sme = sme->next)
+    for (sme = bucket->sme; NULL != sme; sme = sme->next)
     {
       if ((0 == memcmp (key, sme->key, sizeof (struct GNUNET_HashCode))) &&
 	  (value == sme->value))
       {
 	if (NULL == p)
-	  map->map[i].sme = sme->next;
+	  bucket->sme = sme->next;
 	else
 	  p->next = sme->next;
 	GNUNET_free (sme);
@@ -417,13 +565,13 @@ GNUNET_CONTAINER_multihashmap_remove (struct GNUNET_CONTAINER_MultiHashMap *map,
     struct BigMapEntry *p;
 
     p = NULL;
-    for (bme = me.bme; NULL != bme; bme = bme->next)
+    for (bme = bucket->bme; NULL != bme; bme = bme->next)
     {
       if ((0 == memcmp (key, &bme->key, sizeof (struct GNUNET_HashCode))) &&
 	  (value == bme->value))
       {
 	if (NULL == p)
-	  map->map[i].bme = bme->next;
+	  bucket->bme = bme->next;
 	else
 	  p->next = bme->next;
 	GNUNET_free (bme);
@@ -449,34 +597,32 @@ int
 GNUNET_CONTAINER_multihashmap_remove_all (struct GNUNET_CONTAINER_MultiHashMap *map,
                                           const struct GNUNET_HashCode *key)
 {
-  union MapEntry me;
-  unsigned int i;
+  union MapEntry *bucket;
   int ret;
 
   map->modification_counter++;
 
   ret = 0;
-  i = idx_of (map, key);
-  me = map->map[i];
+  bucket = bucket_of (map, key);
   if (map->use_small_entries)
   {
     struct SmallMapEntry *sme;
     struct SmallMapEntry *p;
 
     p = NULL;
-    sme = me.sme;
+    sme = bucket->sme;
     while (NULL != sme)
     {
       if (0 == memcmp (key, sme->key, sizeof (struct GNUNET_HashCode)))
       {
 	if (NULL == p)
-	  map->map[i].sme = sme->next;
+	  bucket->sme = sme->next;
 	else
 	  p->next = sme->next;
 	GNUNET_free (sme);
 	map->size--;
 	if (NULL == p)
-	  sme = map->map[i].sme;
+	  sme = bucket->sme;
 	else
 	  sme = p->next;
 	ret++;
@@ -494,19 +640,19 @@ GNUNET_CONTAINER_multihashmap_remove_all (struct GNUNET_CONTAINER_MultiHashMap *
     struct BigMapEntry *p;
 
     p = NULL;
-    bme = me.bme;
+    bme = bucket->bme;
     while (NULL != bme)
     {
       if (0 == memcmp (key, &bme->key, sizeof (struct GNUNET_HashCode)))
       {
 	if (NULL == p)
-	  map->map[i].bme = bme->next;
+	  bucket->bme = bme->next;
 	else
 	  p->next = bme->next;
 	GNUNET_free (bme);
 	map->size--;
 	if (NULL == p)
-	  bme = map->map[i].bme;
+	  bme = bucket->bme;
 	else
 	  bme = p->next;
 	ret++;
@@ -581,7 +727,7 @@ GNUNET_CONTAINER_multihashmap_contains (const struct
 {
   union MapEntry me;
 
-  me = map->map[idx_of (map, key)];
+  me = *bucket_of (map, key);
   if (map->use_small_entries)
   {
     struct SmallMapEntry *sme;
@@ -620,7 +766,7 @@ GNUNET_CONTAINER_multihashmap_contains_value (const struct
 {
   union MapEntry me;
 
-  me = map->map[idx_of (map, key)];
+  me = *bucket_of (map, key);
   if (map->use_small_entries)
   {
     struct SmallMapEntry *sme;
@@ -644,56 +790,28 @@ GNUNET_CONTAINER_multihashmap_contains_value (const struct
 
 
 /**
- * Grow the given map to a more appropriate size.
+ * Begin growing the given map to a more appropriate size.  The
+ * entries are not rehashed right away; instead, modifying operations
+ * each migrate a small batch of buckets (see split_step()) until the
+ * old bucket array is drained, so no single operation stalls on a
+ * full rehash.
  *
  * @param map the hash map to grow
  */
 static void
 grow (struct GNUNET_CONTAINER_MultiHashMap *map)
 {
-  union MapEntry *old_map;
-  union MapEntry *new_map;
-  unsigned int old_len;
-  unsigned int new_len;
-  unsigned int idx;
-  unsigned int i;
-
   map->modification_counter++;
-
-  old_map = map->map;
-  old_len = map->map_length;
-  new_len = old_len * 2;
-  new_map = GNUNET_malloc (sizeof (union MapEntry) * new_len);
-  map->map_length = new_len;
-  map->map = new_map;
-  for (i = 0; i < old_len; i++)
+  if (NULL != map->old_map)
   {
-    if (map->use_small_entries)
-    {
-      struct SmallMapEntry *sme;
-
-      while (NULL != (sme = old_map[i].sme))
-      {
-	old_map[i].sme = sme->next;
-	idx = idx_of (map, sme->key);
-	sme->next = new_map[idx].sme;
-	new_map[idx].sme = sme;
-      }
-    }
-    else
-    {
-      struct BigMapEntry *bme;
-
-      while (NULL != (bme = old_map[i].bme))
-      {
-	old_map[i].bme = bme->next;
-	idx = idx_of (map, &bme->key);
-	bme->next = new_map[idx].bme;
-	new_map[idx].bme = bme;
-      }
-    }
+    /* previous resize still in progress; finish it first */
+    split_step (map, map->old_map_length);
   }
-  GNUNET_free (old_map);
+  map->old_map = map->map;
+  map->old_map_length = map->map_length;
+  map->split_idx = 0;
+  map->map_length = map->map_length * 2;
+  map->map = GNUNET_malloc (sizeof (union MapEntry) * map->map_length);
 }
 
 
@@ -715,14 +833,16 @@ GNUNET_CONTAINER_multihashmap_put (struct GNUNET_CONTAINER_MultiHashMap *map,
 				   void *value,
                                    enum GNUNET_CONTAINER_MultiHashMapOption opt)
 {
+  union MapEntry *bucket;
   union MapEntry me;
-  unsigned int i;
 
-  i = idx_of (map, key);
+  if (NULL != map->old_map)
+    split_step (map, SPLIT_BATCH_SIZE);
+  bucket = bucket_of (map, key);
   if ((opt != GNUNET_CONTAINER_MULTIHASHMAPOPTION_MULTIPLE) &&
       (opt != GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_FAST))
   {
-    me = map->map[i];
+    me = *bucket;
     if (map->use_small_entries)
     {
       struct SmallMapEntry *sme;
@@ -753,7 +873,8 @@ GNUNET_CONTAINER_multihashmap_put (struct GNUNET_CONTAINER_MultiHashMap *map,
   if (map->size / 3 >= map->map_length / 4)
   {
     grow (map);
-    i = idx_of (map, key);
+    split_step (map, SPLIT_BATCH_SIZE);
+    bucket = bucket_of (map, key);
   }
   if (map->use_small_entries)
   {
@@ -762,8 +883,8 @@ GNUNET_CONTAINER_multihashmap_put (struct GNUNET_CONTAINER_MultiHashMap *map,
     sme = GNUNET_new (struct SmallMapEntry);
     sme->key = key;
     sme->value = value;
-    sme->next = map->map[i].sme;
-    map->map[i].sme = sme;
+    sme->next = bucket->sme;
+    bucket->sme = sme;
   }
   else
   {
@@ -772,8 +893,8 @@ GNUNET_CONTAINER_multihashmap_put (struct GNUNET_CONTAINER_MultiHashMap *map,
     bme = GNUNET_new (struct BigMapEntry);
     bme->key = *key;
     bme->value = value;
-    bme->next = map->map[i].bme;
-    map->map[i].bme = bme;
+    bme->next = bucket->bme;
+    bucket->bme = bme;
   }
   map->size++;
   return GNUNET_OK;
@@ -801,7 +922,7 @@ GNUNET_CONTAINER_multihashmap_get_multiple (const struct
   union MapEntry me;
 
   count = 0;
-  me = map->map[idx_of (map, key)];
+  me = *bucket_of (map, key);
   if (map->use_small_entries)
   {
     struct SmallMapEntry *sme;
@@ -856,7 +977,10 @@ GNUNET_CONTAINER_multihashmap_get_random (const struct GNUNET_CONTAINER_MultiHas
 {
   unsigned int off;
   unsigned int idx;
+  unsigned int len;
+  union MapEntry *buckets;
   union MapEntry me;
+  int pass;
 
   if (0 == map->size)
     return 0;
@@ -864,46 +988,61 @@ GNUNET_CONTAINER_multihashmap_get_random (const struct GNUNET_CONTAINER_MultiHas
     return 1;
   off = GNUNET_CRYPTO_random_u32 (GNUNET_CRYPTO_QUALITY_NONCE,
                                   map->size);
-  for (idx = 0; idx < map->map_length; idx++)
+  for (pass = 0; pass < 2; pass++)
   {
-    me = map->map[idx];
-    if (map->use_small_entries)
+    if (0 == pass)
     {
-      struct SmallMapEntry *sme;
-      struct SmallMapEntry *nxt;
-
-      nxt = me.sme;
-      while (NULL != (sme = nxt))
-      {
-        nxt = sme->next;
-        if (0 == off)
-        {
-          if (GNUNET_OK != it (it_cls,
-                               sme->key,
-                               sme->value))
-            return GNUNET_SYSERR;
-          return 1;
-        }
-        off--;
-      }
+      if (NULL == map->old_map)
+	continue;
+      buckets = &map->old_map[map->split_idx];
+      len = map->old_map_length - map->split_idx;
     }
     else
     {
-      struct BigMapEntry *bme;
-      struct BigMapEntry *nxt;
+      buckets = map->map;
+      len = map->map_length;
+    }
+    for (idx = 0; idx < len; idx++)
+    {
+      me = buckets[idx];
+      if (map->use_small_entries)
+      {
+        struct SmallMapEntry *sme;
+        struct SmallMapEntry *nxt;
 
-      nxt = me.bme;
-      while (NULL != (bme = nxt))
+        nxt = me.sme;
+        while (NULL != (sme = nxt))
+        {
+          nxt = sme->next;
+          if (0 == off)
+          {
+            if (GNUNET_OK != it (it_cls,
+                                 sme->key,
+                                 sme->value))
+              return GNUNET_SYSERR;
+            return 1;
+          }
+          off--;
+        }
+      }
+      else
       {
-        nxt = bme->next;
-        if (0 == off)
+        struct BigMapEntry *bme;
+        struct BigMapEntry *nxt;
+
+        nxt = me.bme;
+        while (NULL != (bme = nxt))
         {
-          if (GNUNET_OK != it (it_cls,
-                               &bme->key, bme->value))
-            return GNUNET_SYSERR;
-          return 1;
+          nxt = bme->next;
+          if (0 == off)
+          {
+            if (GNUNET_OK != it (it_cls,
+                                 &bme->key, bme->value))
+              return GNUNET_SYSERR;
+            return 1;
+          }
+          off--;
         }
-        off--;
       }
     }
   }
@@ -932,7 +1071,16 @@ GNUNET_CONTAINER_multihashmap_iterator_create (const struct GNUNET_CONTAINER_Mul
   iter = GNUNET_new (struct GNUNET_CONTAINER_MultiHashMapIterator);
   iter->map = map;
   iter->modification_counter = map->modification_counter;
-  iter->me = map->map[0];
+  if (NULL != map->old_map)
+  {
+    iter->in_old = GNUNET_YES;
+    iter->idx = map->split_idx;
+    iter->me = map->old_map[iter->idx];
+  }
+  else
+  {
+    iter->me = map->map[0];
+  }
   return iter;
 }
 
@@ -962,8 +1110,6 @@ GNUNET_CONTAINER_multihashmap_iterator_next (struct GNUNET_CONTAINER_MultiHashMa
   /* look for the next entry, skipping empty buckets */
   while (1)
   {
-    if (iter->idx >= iter->map->map_length)
-      return GNUNET_NO;
     if (GNUNET_YES == iter->map->use_small_entries)
     {
       if (NULL != iter->me.sme)
@@ -989,8 +1135,26 @@ GNUNET_CONTAINER_multihashmap_iterator_next (struct GNUNET_CONTAINER_MultiHashMa
       }
     }
     iter->idx += 1;
-    if (iter->idx < iter->map->map_length)
-      iter->me = iter->map->map[iter->idx];
+    if (GNUNET_YES == iter->in_old)
+    {
+      /* switch to the current bucket array once the old one is
+         exhausted (or was released by a concurrent migration) */
+      if ( (NULL == iter->map->old_map) ||
+           (iter->idx >= iter->map->old_map_length) )
+      {
+        iter->in_old = GNUNET_NO;
+        iter->idx = 0;
+        iter->me = iter->map->map[0];
+      }
+      else
+      {
+        iter->me = iter->map->old_map[iter->idx];
+      }
+      continue;
+    }
+    if (iter->idx >= iter->map->map_length)
+      return GNUNET_NO;
+    iter->me = iter->map->map[iter->idx];
   }
 }
 
@@ -45,7 +45,14 @@ typedef unsigned long GNUNET_uLong;
 
 
 #define POLYNOMIAL (GNUNET_uLong)0xedb88320
-static GNUNET_uLong crc_table[256];
+
+/**
+ * Lookup tables for "slice-by-8": crc_table[0] is the classic
+ * byte-at-a-time table, crc_table[k] gives the effect of a byte
+ * processed k bytes earlier, so eight bytes can be folded into the
+ * CRC with eight independent table lookups per iteration.
+ */
+static GNUNET_uLong crc_table[8][256];
 
 /*
  * This routine writes each crc_table entry exactly once,
@@ -57,19 +64,27 @@ crc_init ()
 {
   static int once;
   unsigned int i, j;
+  unsigned int k;
   GNUNET_uLong h = 1;
+  GNUNET_uLong c;
 
   if (once)
     return;
   once = 1;
-  crc_table[0] = 0;
+  crc_table[0][0] = 0;
   for (i = 128; i; i >>= 1)
   {
     h = (h >> 1) ^ ((h & 1) ? POLYNOMIAL : 0);
-    /* h is now crc_table[i] */
+    /* h is now crc_table[0][i] */
     for (j = 0; j < 256; j += 2 * i)
-      crc_table[i + j] = crc_table[j] ^ h;
+      crc_table[0][i + j] = crc_table[0][j] ^ h;
   }
+  for (k = 1; k < 8; k++)
+    for (i = 0; i < 256; i++)
+    {
+      c = crc_table[k - 1][i];
+      crc_table[k][i] = (c >> 8) ^ crc_table[0][c & 0xff];
+    }
 }
 
 /*
@@ -85,11 +100,33 @@ crc_init ()
 static GNUNET_uLong
 crc32 (GNUNET_uLong crc, const char *buf, size_t len)
 {
+  const unsigned char *p = (const unsigned char *) buf;
+
   crc_init ();
-  GNUNET_assert (crc_table[255] != 0);
+  GNUNET_assert (crc_table[0][255] != 0);
   crc ^= 0xffffffff;
+  /* process eight bytes per iteration; the bytes are combined into
+     the CRC via per-position tables, so this computes the same CRC
+     as the byte-wise loop regardless of host byte order */
+  while (len >= 8)
+  {
+    crc ^= (GNUNET_uLong) p[0]
+         | ((GNUNET_uLong) p[1] << 8)
+         | ((GNUNET_uLong) p[2] << 16)
+         | ((GNUNET_uLong) p[3] << 24);
+    crc = crc_table[7][crc & 0xff]
+        ^ crc_table[6][(crc >> 8) & 0xff]
+        ^ crc_table[5][(crc >> 16) & 0xff]
+        ^ crc_table[4][(crc >> 24) & 0xff]
+        ^ crc_table[3][p[4]]
+        ^ crc_table[2][p[5]]
+        ^ crc_table[1][p[6]]
+        ^ crc_table[0][p[7]];
+    p += 8;
+    len -= 8;
+  }
   while (len--)
-    crc = (crc >> 8) ^ crc_table[(crc ^ *buf++) & 0xff];
+    crc = (crc >> 8) ^ crc_table[0][(crc ^ *p++) & 0xff];
   return crc ^ 0xffffffff;
 }
 
@@ -123,12 +160,43 @@ GNUNET_CRYPTO_crc32_n (const void *buf, size_t len)
 uint32_t
 GNUNET_CRYPTO_crc16_step (uint32_t sum, const void *buf, size_t len)
 {
-  const uint16_t *hdr = buf;
-  for (; len >= 2; len -= 2)
-    sum += *(hdr++);
-  if (len == 1)
-    sum += (*hdr) & ntohs(0xFF00);
-  return sum;
+  const uint8_t *pos = buf;
+  uint64_t wsum = sum;
+
+  /* Sum 64 bits at a time; as carries are folded back into the
+     accumulator below, this computes the same one's complement sum
+     as the 16-bit word loop, but gives the compiler a loop it can
+     unroll and vectorize. */
+  while (len >= sizeof (uint64_t))
+  {
+    uint64_t w;
+
+    memcpy (&w, pos, sizeof (w));
+    wsum += w & 0xFFFFFFFFULL;
+    wsum += w >> 32;
+    pos += sizeof (uint64_t);
+    len -= sizeof (uint64_t);
+  }
+  while (len >= sizeof (uint16_t))
+  {
+    uint16_t w;
+
+    memcpy (&w, pos, sizeof (w));
+    wsum += w;
+    pos += sizeof (uint16_t);
+    len -= sizeof (uint16_t);
+  }
+  if (1 == len)
+  {
+    uint16_t w = 0;
+
+    /* equivalent to padding the odd trailing byte with a zero */
+    memcpy (&w, pos, 1);
+    wsum += w;
+  }
+  wsum = (wsum >> 32) + (wsum & 0xFFFFFFFFULL);
+  wsum = (wsum >> 32) + (wsum & 0xFFFFFFFFULL);
+  return (uint32_t) wsum;
 }
 
 
@@ -148,6 +216,32 @@ GNUNET_CRYPTO_crc16_finish (uint32_t sum)
 }
 
 
+/**
+ * Update an internet checksum after a 16-bit field in the covered
+ * data was rewritten, without re-summing the entire buffer
+ * (RFC 1624, Eqn. 3).  All values are in network byte order.
+ *
+ * @param sum current checksum (as stored in the header)
+ * @param old_val old value of the rewritten 16-bit field
+ * @param new_val new value of the rewritten 16-bit field
+ * @return updated checksum
+ */
+uint16_t
+GNUNET_CRYPTO_crc16_rewrite (uint16_t sum,
+			     uint16_t old_val,
+			     uint16_t new_val)
+{
+  uint32_t s;
+
+  s = (uint32_t) (uint16_t) ~sum;
+  s += (uint32_t) (uint16_t) ~old_val;
+  s += (uint32_t) new_val;
+  s = (s >> 16) + (s & 0xFFFF);
+  s += (s >> 16);
+  return (uint16_t) ~s;
+}
+
+
 /**
  * Calculate the checksum of a buffer in one step.
  *
@@ -675,6 +675,103 @@ GNUNET_CRYPTO_cmp_peer_identity (const struct GNUNET_PeerIdentity *first,
 }
 
 
+/**
+ * Number of slots in the cache of converted public keys used
+ * for signature verification.
+ */
+#define PUBKEY_SEXP_CACHE_SIZE 16
+
+
+/**
+ * Cache slot for a public key converted to a libgcrypt s-expression.
+ *
+ * Verification-heavy callers (validating blocks, HELLOs, revocations)
+ * typically check many signatures from few distinct signers, so the
+ * conversion result is kept for reuse instead of being rebuilt per call.
+ */
+struct PublicKeySexpCacheEntry
+{
+
+  /**
+   * Raw public key bytes the entry was converted from.
+   */
+  unsigned char q_y[256 / 8];
+
+  /**
+   * Converted public key, or NULL if the slot is empty.
+   */
+  gcry_sexp_t sexp;
+
+};
+
+
+/**
+ * Cache of converted EdDSA public keys.
+ */
+static struct PublicKeySexpCacheEntry eddsa_pub_cache[PUBKEY_SEXP_CACHE_SIZE];
+
+/**
+ * Next slot of #eddsa_pub_cache to evict on a miss.
+ */
+static unsigned int eddsa_pub_cache_off;
+
+/**
+ * Cache of converted ECDSA public keys.
+ */
+static struct PublicKeySexpCacheEntry ecdsa_pub_cache[PUBKEY_SEXP_CACHE_SIZE];
+
+/**
+ * Next slot of #ecdsa_pub_cache to evict on a miss.
+ */
+static unsigned int ecdsa_pub_cache_off;
+
+
+/**
+ * Look up a converted public key in a cache.
+ *
+ * @param cache the cache to search
+ * @param q_y raw public key bytes, 256/8 bytes long
+ * @return the cached s-expression (owned by the cache), or NULL on miss
+ */
+static gcry_sexp_t
+pubkey_sexp_cache_get (const struct PublicKeySexpCacheEntry *cache,
+                       const unsigned char *q_y)
+{
+  unsigned int i;
+
+  for (i = 0; i < PUBKEY_SEXP_CACHE_SIZE; i++)
+    if ( (NULL != cache[i].sexp) &&
+         (0 == memcmp (q_y, cache[i].q_y, sizeof (cache[i].q_y))) )
+      return cache[i].sexp;
+  return NULL;
+}
+
+
+/**
+ * Store a converted public key in a cache, evicting the entry in the
+ * given slot if occupied.
+ *
+ * @param cache the cache to store in
+ * @param[in,out] off round-robin eviction offset of the cache
+ * @param q_y raw public key bytes, 256/8 bytes long
+ * @param sexp converted public key; the cache takes ownership
+ */
+static void
+pubkey_sexp_cache_put (struct PublicKeySexpCacheEntry *cache,
+                       unsigned int *off,
+                       const unsigned char *q_y,
+                       gcry_sexp_t sexp)
+{
+  struct PublicKeySexpCacheEntry *entry = &cache[*off];
+
+  if (NULL != entry->sexp)
+    gcry_sexp_release (entry->sexp);
+  memcpy (entry->q_y, q_y, sizeof (entry->q_y));
+  entry->sexp = sexp;
+  *off = (*off + 1) % PUBKEY_SEXP_CACHE_SIZE;
+}
+
+
 /**
  * Convert the data specified in the given purpose argument to an
  * S-expression suitable for signature operations.
@@ -862,16 +959,21 @@ GNUNET_CRYPTO_ecdsa_verify (uint32_t purpose,
     return GNUNET_SYSERR;
   }
   data = data_to_ecdsa_value (validate);
-  if (0 != (rc = gcry_sexp_build (&pub_sexpr, NULL,
-                                  "(public-key(ecc(curve " CURVE ")(q %b)))",
-                                  (int) sizeof (pub->q_y), pub->q_y)))
+  pub_sexpr = pubkey_sexp_cache_get (ecdsa_pub_cache, pub->q_y);
+  if (NULL == pub_sexpr)
   {
-    gcry_sexp_release (data);
-    gcry_sexp_release (sig_sexpr);
-    return GNUNET_SYSERR;
+    if (0 != (rc = gcry_sexp_build (&pub_sexpr, NULL,
+                                    "(public-key(ecc(curve " CURVE ")(q %b)))",
+                                    (int) sizeof (pub->q_y), pub->q_y)))
+    {
+      gcry_sexp_release (data);
+      gcry_sexp_release (sig_sexpr);
+      return GNUNET_SYSERR;
+    }
+    pubkey_sexp_cache_put (ecdsa_pub_cache, &ecdsa_pub_cache_off,
+                           pub->q_y, pub_sexpr);
   }
   rc = gcry_pk_verify (sig_sexpr, data, pub_sexpr);
-  gcry_sexp_release (pub_sexpr);
   gcry_sexp_release (data);
   gcry_sexp_release (sig_sexpr);
   if (0 != rc)
@@ -919,16 +1021,21 @@ GNUNET_CRYPTO_eddsa_verify (uint32_t purpose,
     return GNUNET_SYSERR;
   }
   data = data_to_eddsa_value (validate);
-  if (0 != (rc = gcry_sexp_build (&pub_sexpr, NULL,
-                                  "(public-key(ecc(curve " CURVE ")(flags eddsa)(q %b)))",
-                                  (int)sizeof (pub->q_y), pub->q_y)))
+  pub_sexpr = pubkey_sexp_cache_get (eddsa_pub_cache, pub->q_y);
+  if (NULL == pub_sexpr)
   {
-    gcry_sexp_release (data);
-    gcry_sexp_release (sig_sexpr);
-    return GNUNET_SYSERR;
+    if (0 != (rc = gcry_sexp_build (&pub_sexpr, NULL,
+                                    "(public-key(ecc(curve " CURVE ")(flags eddsa)(q %b)))",
+                                    (int)sizeof (pub->q_y), pub->q_y)))
+    {
+      gcry_sexp_release (data);
+      gcry_sexp_release (sig_sexpr);
+      return GNUNET_SYSERR;
+    }
+    pubkey_sexp_cache_put (eddsa_pub_cache, &eddsa_pub_cache_off,
+                           pub->q_y, pub_sexpr);
   }
   rc = gcry_pk_verify (sig_sexpr, data, pub_sexpr);
-  gcry_sexp_release (pub_sexpr);
   gcry_sexp_release (data);
   gcry_sexp_release (sig_sexpr);
   if (0 != rc)
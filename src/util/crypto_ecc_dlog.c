@@ -161,6 +161,7 @@ GNUNET_CRYPTO_ecc_dlog_prepare (unsigned int max,
   unsigned int K = ((max + (mem-1)) / mem);
   gcry_mpi_point_t g;
   struct GNUNET_PeerIdentity key;
+  gcry_mpi_point_t gK;
   gcry_mpi_point_t gKi;
   gcry_mpi_t fact;
   gcry_mpi_t n;
@@ -180,25 +181,38 @@ GNUNET_CRYPTO_ecc_dlog_prepare (unsigned int max,
   g = gcry_mpi_ec_get_point ("g", edc->ctx, 0);
   GNUNET_assert (NULL != g);
   fact = gcry_mpi_new (0);
+  gK = gcry_mpi_point_new (0);
   gKi = gcry_mpi_point_new (0);
+  /* Compute gK = K*g once; the table entries are consecutive
+     multiples of it, so all further entries follow by point
+     addition, which is vastly cheaper than one full scalar
+     multiplication per entry. */
+  gcry_mpi_set_ui (fact, K);
+  gcry_mpi_ec_mul (gK, fact, g, edc->ctx);
+  gcry_mpi_set_ui (fact, 0);
+  gcry_mpi_ec_mul (gKi, fact, g, edc->ctx);
   for (i=0;i<=mem;i++)
   {
-    gcry_mpi_set_ui (fact, i * K);
-    gcry_mpi_ec_mul (gKi, fact, g, edc->ctx);
     extract_pk (gKi, edc->ctx, &key);
     GNUNET_assert (GNUNET_OK ==
 		   GNUNET_CONTAINER_multipeermap_put (edc->map,
 						      &key,
 						      (void*) (long) i + max,
 						      GNUNET_CONTAINER_MULTIHASHMAPOPTION_UNIQUE_ONLY));
+    /* gKi = (i+1) * K * g */
+    gcry_mpi_ec_add (gKi, gKi, gK, edc->ctx);
   }
-  /* negative values */
+  /* negative values, using gK = -K*g as the increment */
   n = gcry_mpi_ec_get_mpi ("n", edc->ctx, 1);
+  gcry_mpi_set_ui (fact, K);
+  gcry_mpi_sub (fact, n, fact);
+  gcry_mpi_ec_mul (gK, fact, g, edc->ctx);
+  gcry_mpi_set_ui (fact, 0);
+  gcry_mpi_ec_mul (gKi, fact, g, edc->ctx);
   for (i=1;i<mem;i++)
   {
-    gcry_mpi_set_ui (fact, i * K);
-    gcry_mpi_sub (fact, n, fact);
-    gcry_mpi_ec_mul (gKi, fact, g, edc->ctx);
+    /* gKi = - i * K * g */
+    gcry_mpi_ec_add (gKi, gKi, gK, edc->ctx);
     extract_pk (gKi, edc->ctx, &key);
     GNUNET_assert (GNUNET_OK ==
 		   GNUNET_CONTAINER_multipeermap_put (edc->map,
@@ -208,6 +222,7 @@ GNUNET_CRYPTO_ecc_dlog_prepare (unsigned int max,
   }
   gcry_mpi_release (fact);
   gcry_mpi_release (n);
+  gcry_mpi_point_release (gK);
   gcry_mpi_point_release (gKi);
   gcry_mpi_point_release (g);
   return edc;
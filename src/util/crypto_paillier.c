@@ -174,11 +174,12 @@ GNUNET_CRYPTO_paillier_encrypt1 (const struct GNUNET_CRYPTO_PaillierPublicKey *p
   }
   while (gcry_mpi_cmp (r, n) >= 0);
 
-  /* c = (n+1)^m mod n^2 */
-  /* c = n + 1 */
-  gcry_mpi_add_ui (c, n, 1);
-  /* c = (n+1)^m mod n^2 */
-  gcry_mpi_powm (c, c, m, n_square);
+  /* c = (n+1)^m mod n^2; by the binomial theorem all terms
+     of (n+1)^m except the last two are divisible by n^2,
+     so c = 1 + m*n (mod n^2) and we can skip the modular
+     exponentiation for the fixed base n+1 entirely */
+  gcry_mpi_mulm (c, m, n, n_square);
+  gcry_mpi_add_ui (c, c, 1);
   /* r <- r^n mod n^2 */
   gcry_mpi_powm (r, r, n, n_square);
   /* c <- r*c mod n^2 */
@@ -218,7 +219,6 @@ GNUNET_CRYPTO_paillier_encrypt (const struct GNUNET_CRYPTO_PaillierPublicKey *pu
   gcry_mpi_t n_square;
   gcry_mpi_t r;
   gcry_mpi_t rn;
-  gcry_mpi_t g;
   gcry_mpi_t gm;
   gcry_mpi_t c;
   gcry_mpi_t n;
@@ -275,20 +275,19 @@ GNUNET_CRYPTO_paillier_encrypt (const struct GNUNET_CRYPTO_PaillierPublicKey *pu
   }
   while (gcry_mpi_cmp (r, n) >= 0);
 
-  /* g = n + 1 */
-  GNUNET_assert (0 != (g = gcry_mpi_new (0)));
-  gcry_mpi_add_ui (g, n, 1);
-
   /* n_square = n^2 */
   GNUNET_assert (0 != (n_square = gcry_mpi_new (0)));
   gcry_mpi_mul (n_square,
                 n,
                 n);
 
-  /* gm = g^m mod n^2 */
+  /* gm = g^m mod n^2 for g = n + 1; by the binomial theorem
+     all terms of (n+1)^m except the last two are divisible
+     by n^2, so gm = 1 + m*n (mod n^2) and the fixed-base
+     exponentiation reduces to one modular multiplication */
   GNUNET_assert (0 != (gm = gcry_mpi_new (0)));
-  gcry_mpi_powm (gm, g, m, n_square);
-  gcry_mpi_release (g);
+  gcry_mpi_mulm (gm, m, n, n_square);
+  gcry_mpi_add_ui (gm, gm, 1);
 
   /* rn <- r^n mod n^2 */
   GNUNET_assert (0 != (rn = gcry_mpi_new (0)));
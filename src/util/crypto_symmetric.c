@@ -31,6 +31,81 @@
 
 #define LOG(kind,...) GNUNET_log_from (kind, "util", __VA_ARGS__)
 
+/**
+ * Cached cipher handle, kept open across calls.  Opening a handle and
+ * scheduling the key are the dominant cost when encrypting small
+ * messages; as long as consecutive calls use the same session key
+ * (the common case for FS blocks and CADET messages), we only reset
+ * the handle and set the fresh IV.
+ */
+struct CipherCache
+{
+  /**
+   * The open cipher handle, valid if @e ready is #GNUNET_YES.
+   */
+  gcry_cipher_hd_t handle;
+
+  /**
+   * Copy of the key currently scheduled in @e handle.
+   */
+  char key[GNUNET_CRYPTO_AES_KEY_LENGTH];
+
+  /**
+   * #GNUNET_YES if @e handle has been opened.
+   */
+  int ready;
+};
+
+/**
+ * Cache for the AES256 handle.
+ */
+static struct CipherCache aes_cache;
+
+/**
+ * Cache for the TWOFISH handle.
+ */
+static struct CipherCache twofish_cache;
+
+
+/**
+ * Obtain a cipher handle for the given algorithm with the given key
+ * scheduled, reusing the cached handle if possible.
+ *
+ * @param cache cache slot for the algorithm
+ * @param algo gcrypt cipher algorithm to use
+ * @param key key to schedule
+ * @param key_len number of bytes in @a key
+ * @return the cipher handle, with only the IV left to set
+ */
+static gcry_cipher_hd_t
+get_cipher (struct CipherCache *cache,
+            int algo,
+            const void *key,
+            size_t key_len)
+{
+  int rc;
+
+  GNUNET_assert (GNUNET_CRYPTO_AES_KEY_LENGTH == key_len);
+  if (GNUNET_YES != cache->ready)
+  {
+    GNUNET_assert (0 ==
+                   gcry_cipher_open (&cache->handle, algo,
+                                     GCRY_CIPHER_MODE_CFB, 0));
+    cache->ready = GNUNET_YES;
+  }
+  else if (0 == memcmp (cache->key, key, key_len))
+  {
+    /* same key as last time, just clear the cipher state */
+    GNUNET_assert (0 == gcry_cipher_reset (cache->handle));
+    return cache->handle;
+  }
+  rc = gcry_cipher_setkey (cache->handle, key, key_len);
+  GNUNET_assert ((0 == rc) || ((char) rc == GPG_ERR_WEAK_KEY));
+  memcpy (cache->key, key, key_len);
+  return cache->handle;
+}
+
+
 /**
  * Create a new SessionKey (for symmetric encryption).
  *
@@ -63,13 +138,10 @@ setup_cipher_aes (gcry_cipher_hd_t *handle,
 {
   int rc;
 
-  GNUNET_assert (0 ==
-                 gcry_cipher_open (handle, GCRY_CIPHER_AES256,
-                                   GCRY_CIPHER_MODE_CFB, 0));
-  rc = gcry_cipher_setkey (*handle,
-                           sessionkey->aes_key,
-                           sizeof (sessionkey->aes_key));
-  GNUNET_assert ((0 == rc) || ((char) rc == GPG_ERR_WEAK_KEY));
+  *handle = get_cipher (&aes_cache,
+                        GCRY_CIPHER_AES256,
+                        sessionkey->aes_key,
+                        sizeof (sessionkey->aes_key));
   rc = gcry_cipher_setiv (*handle,
                           iv->aes_iv,
                           sizeof (iv->aes_iv));
@@ -93,13 +165,10 @@ setup_cipher_twofish (gcry_cipher_hd_t *handle,
 {
   int rc;
 
-  GNUNET_assert (0 ==
-                 gcry_cipher_open (handle, GCRY_CIPHER_TWOFISH,
-                                   GCRY_CIPHER_MODE_CFB, 0));
-  rc = gcry_cipher_setkey (*handle,
-                           sessionkey->twofish_key,
-                           sizeof (sessionkey->twofish_key));
-  GNUNET_assert ((0 == rc) || ((char) rc == GPG_ERR_WEAK_KEY));
+  *handle = get_cipher (&twofish_cache,
+                        GCRY_CIPHER_TWOFISH,
+                        sessionkey->twofish_key,
+                        sizeof (sessionkey->twofish_key));
   rc = gcry_cipher_setiv (*handle,
                           iv->twofish_iv,
                           sizeof (iv->twofish_iv));
@@ -134,11 +203,9 @@ GNUNET_CRYPTO_symmetric_encrypt (const void *block,
   if (GNUNET_OK != setup_cipher_aes (&handle, sessionkey, iv))
     return -1;
   GNUNET_assert (0 == gcry_cipher_encrypt (handle, tmp, size, block, size));
-  gcry_cipher_close (handle);
   if (GNUNET_OK != setup_cipher_twofish (&handle, sessionkey, iv))
     return -1;
   GNUNET_assert (0 == gcry_cipher_encrypt (handle, result, size, tmp, size));
-  gcry_cipher_close (handle);
   memset (tmp, 0, sizeof (tmp));
   return size;
 }
@@ -169,11 +236,9 @@ GNUNET_CRYPTO_symmetric_decrypt (const void *block, size_t size,
   if (GNUNET_OK != setup_cipher_twofish (&handle, sessionkey, iv))
     return -1;
   GNUNET_assert (0 == gcry_cipher_decrypt (handle, tmp, size, block, size));
-  gcry_cipher_close (handle);
   if (GNUNET_OK != setup_cipher_aes (&handle, sessionkey, iv))
     return -1;
   GNUNET_assert (0 == gcry_cipher_decrypt (handle, result, size, tmp, size));
-  gcry_cipher_close (handle);
   memset (tmp, 0, sizeof (tmp));
   return size;
 }
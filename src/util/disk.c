@@ -1207,6 +1207,7 @@ GNUNET_DISK_directory_scan (const char *dir_name,
   int ret;
   char *name;
   char *dname;
+  size_t dlen;
   unsigned int name_len;
   unsigned int n_size;
 
@@ -1241,8 +1242,15 @@ GNUNET_DISK_directory_scan (const char *dir_name,
     return GNUNET_SYSERR;
   }
   name_len = 256;
-  n_size = strlen (dname) + name_len + 2;
+  dlen = strlen (dname);
+  n_size = dlen + name_len + 2;
   name = GNUNET_malloc (n_size);
+  /* dname can end in "/" only if dname == "/";
+   * if dname does not end in "/", we need to add
+   * a "/" (otherwise, we must not!) */
+  memcpy (name, dname, dlen);
+  if (0 != strcmp (dname, DIR_SEPARATOR_STR))
+    name[dlen++] = DIR_SEPARATOR;
   while (NULL != (finfo = READDIR (dinfo)))
   {
     if ((0 == strcmp (finfo->d_name, ".")) ||
@@ -1252,17 +1260,13 @@ GNUNET_DISK_directory_scan (const char *dir_name,
     {
       if (name_len < strlen (finfo->d_name))
       {
-        GNUNET_free (name);
         name_len = strlen (finfo->d_name);
-        n_size = strlen (dname) + name_len + 2;
-        name = GNUNET_malloc (n_size);
+        n_size = dlen + name_len + 1;
+        name = GNUNET_realloc (name, n_size);
       }
-      /* dname can end in "/" only if dname == "/";
-       * if dname does not end in "/", we need to add
-       * a "/" (otherwise, we must not!) */
-      GNUNET_snprintf (name, n_size, "%s%s%s", dname,
-                       (strcmp (dname, DIR_SEPARATOR_STR) ==
-                        0) ? "" : DIR_SEPARATOR_STR, finfo->d_name);
+      /* the base path (including trailing separator) stays in
+       * place; only the entry name changes between iterations */
+      strcpy (&name[dlen], finfo->d_name);
       ret = callback (callback_cls, name);
       if (GNUNET_OK != ret)
       {
@@ -1309,18 +1313,24 @@ remove_helper (void *unused, const char *fn)
 int
 GNUNET_DISK_directory_remove (const char *filename)
 {
-  struct stat istat;
-
   if (NULL == filename)
   {
     GNUNET_break (0);
     return GNUNET_SYSERR;
   }
-  if (0 != LSTAT (filename, &istat))
-    return GNUNET_NO;           /* file may not exist... */
-  (void) CHMOD (filename, S_IWUSR | S_IRUSR | S_IXUSR);
-  if (UNLINK (filename) == 0)
+  /* common case: plain file, removable with a single syscall */
+  if (0 == UNLINK (filename))
     return GNUNET_OK;
+  if (ENOENT == errno)
+    return GNUNET_NO;           /* file may not exist... */
+  if ( (EACCES == errno) ||
+       (EPERM == errno) )
+  {
+    /* may be read-only; make it ours and try again */
+    (void) CHMOD (filename, S_IWUSR | S_IRUSR | S_IXUSR);
+    if (0 == UNLINK (filename))
+      return GNUNET_OK;
+  }
   if ((errno != EISDIR) &&
       /* EISDIR is not sufficient in all cases, e.g.
        * sticky /tmp directory may result in EPERM on BSD.
@@ -1330,6 +1340,8 @@ GNUNET_DISK_directory_remove (const char *filename)
     LOG_STRERROR_FILE (GNUNET_ERROR_TYPE_WARNING, "rmdir", filename);
     return GNUNET_SYSERR;
   }
+  /* ensure we can traverse and modify the directory */
+  (void) CHMOD (filename, S_IWUSR | S_IRUSR | S_IXUSR);
   if (GNUNET_SYSERR ==
       GNUNET_DISK_directory_scan (filename, &remove_helper, NULL))
     return GNUNET_SYSERR;
@@ -1752,6 +1764,7 @@ GNUNET_DISK_file_close (struct GNUNET_DISK_FileHandle *h)
     GNUNET_free (h->oOverlapWrite);
   }
 #else
+  GNUNET_SCHEDULER_notify_fd_closed_ (h->fd);
   if (close (h->fd) != 0)
   {
     LOG_STRERROR (GNUNET_ERROR_TYPE_WARNING, "close");
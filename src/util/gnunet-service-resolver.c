@@ -29,6 +29,17 @@
 #include "gnunet_statistics_service.h"
 #include "resolver.h"
 
+/**
+ * How long do we consider a DNS answer valid before we evict
+ * the cache entry (if nobody asks for it again earlier)?
+ */
+#define CACHE_VALIDITY (60 * 60 * 1000 * 1000LL)
+
+/**
+ * How long do we wait before we retry a lookup that failed?
+ */
+#define RETRY_VALIDITY (120 * 1000 * 1000LL)
+
 /**
  * A cached DNS lookup result (for reverse lookup).
  */
@@ -76,6 +87,76 @@ struct IPCache
 };
 
 
+/**
+ * An address found for a cached forward lookup.
+ */
+struct AddressEntry
+{
+  /**
+   * This is a doubly linked list.
+   */
+  struct AddressEntry *next;
+
+  /**
+   * This is a doubly linked list.
+   */
+  struct AddressEntry *prev;
+
+  /**
+   * Binary address (`struct in_addr` or `struct in6_addr`),
+   * allocated at the end of this struct.
+   */
+  const void *addr;
+
+  /**
+   * Number of bytes in @e addr.
+   */
+  size_t addr_len;
+};
+
+
+/**
+ * A cached DNS lookup result (for forward lookup).
+ */
+struct HostCache
+{
+  /**
+   * This is a doubly linked list.
+   */
+  struct HostCache *next;
+
+  /**
+   * This is a doubly linked list.
+   */
+  struct HostCache *prev;
+
+  /**
+   * Hostname that was resolved, allocated at the end of this struct.
+   */
+  const char *hostname;
+
+  /**
+   * Head of the addresses found for @e hostname.
+   */
+  struct AddressEntry *ae_head;
+
+  /**
+   * Tail of the addresses found for @e hostname.
+   */
+  struct AddressEntry *ae_tail;
+
+  /**
+   * Last time this entry was refreshed from DNS.
+   */
+  struct GNUNET_TIME_Absolute last_refresh;
+
+  /**
+   * Address family the lookup was performed for.
+   */
+  int af;
+};
+
+
 /**
  * Start of the linked list of cached DNS lookup results.
  */
@@ -86,6 +167,16 @@ static struct IPCache *cache_head;
  */
 static struct IPCache *cache_tail;
 
+/**
+ * Start of the linked list of cached forward lookup results.
+ */
+static struct HostCache *hosts_head;
+
+/**
+ * Tail of the linked list of cached forward lookup results.
+ */
+static struct HostCache *hosts_tail;
+
 
 #if HAVE_GETNAMEINFO
 /**
@@ -216,7 +307,6 @@ get_ip_as_string (struct GNUNET_SERVER_Client *client,
   struct GNUNET_TIME_Absolute now;
   struct GNUNET_SERVER_TransmitContext *tc;
   size_t ip_len;
-  struct in6_addr ix;
 
   switch (af)
   {
@@ -237,9 +327,10 @@ get_ip_as_string (struct GNUNET_SERVER_Client *client,
 	    (0 != memcmp (pos->ip, ip, ip_len))) )
   {
     next = pos->next;
-    if (GNUNET_TIME_absolute_get_duration (pos->last_request).rel_value_us <
-        60 * 60 * 1000 * 1000LL)
+    if (GNUNET_TIME_absolute_get_duration (pos->last_request).rel_value_us >
+        CACHE_VALIDITY)
     {
+      /* nobody asked about this IP for too long, evict */
       GNUNET_CONTAINER_DLL_remove (cache_head,
 				   cache_tail,
 				   pos);
@@ -250,18 +341,15 @@ get_ip_as_string (struct GNUNET_SERVER_Client *client,
   }
   if (NULL != pos)
   {
-    if ( (1 == inet_pton (af,
-                          pos->ip,
-                          &ix)) &&
-         (GNUNET_TIME_absolute_get_duration (pos->last_request).rel_value_us >
-          120 * 1000 * 1000LL) )
+    if ( (NULL == pos->addr) &&
+         (GNUNET_TIME_absolute_get_duration (pos->last_refresh).rel_value_us >
+          RETRY_VALIDITY) )
     {
-      /* try again if still numeric AND 2 minutes have expired */
-      GNUNET_free_non_null (pos->addr);
-      pos->addr = NULL;
+      /* try again if the lookup failed AND 2 minutes have expired */
       cache_resolve (pos);
-      pos->last_request = now;
+      pos->last_refresh = now;
     }
+    pos->last_request = now;
   }
   else
   {
@@ -291,10 +379,60 @@ get_ip_as_string (struct GNUNET_SERVER_Client *client,
 }
 
 
+/**
+ * Add an address to the list of addresses found for
+ * the given forward lookup cache entry.
+ *
+ * @param hc cache entry to extend
+ * @param addr binary address to add
+ * @param addr_len number of bytes in @a addr
+ */
+static void
+cache_append_address (struct HostCache *hc,
+                      const void *addr,
+                      size_t addr_len)
+{
+  struct AddressEntry *ae;
+
+  ae = GNUNET_malloc (sizeof (struct AddressEntry) + addr_len);
+  ae->addr = &ae[1];
+  memcpy (&ae[1], addr, addr_len);
+  ae->addr_len = addr_len;
+  GNUNET_CONTAINER_DLL_insert_tail (hc->ae_head,
+                                    hc->ae_tail,
+                                    ae);
+}
+
+
+/**
+ * Remove a forward lookup cache entry and free all
+ * associated resources.
+ *
+ * @param hc cache entry to free
+ */
+static void
+free_host_entry (struct HostCache *hc)
+{
+  struct AddressEntry *ae;
+
+  while (NULL != (ae = hc->ae_head))
+  {
+    GNUNET_CONTAINER_DLL_remove (hc->ae_head,
+                                 hc->ae_tail,
+                                 ae);
+    GNUNET_free (ae);
+  }
+  GNUNET_CONTAINER_DLL_remove (hosts_head,
+                               hosts_tail,
+                               hc);
+  GNUNET_free (hc);
+}
+
+
 #if HAVE_GETADDRINFO
 static int
-getaddrinfo_resolve (struct GNUNET_SERVER_TransmitContext *tc,
-                     const char *hostname, int af)
+getaddrinfo_resolve (struct HostCache *hc,
+                     int af)
 {
   int s;
   struct addrinfo hints;
@@ -307,8 +445,8 @@ getaddrinfo_resolve (struct GNUNET_SERVER_TransmitContext *tc,
   {
     int ret1;
     int ret2;
-    ret1 = getaddrinfo_resolve (tc, hostname, AF_INET);
-    ret2 = getaddrinfo_resolve (tc, hostname, AF_INET6);
+    ret1 = getaddrinfo_resolve (hc, AF_INET);
+    ret2 = getaddrinfo_resolve (hc, AF_INET6);
     if ((ret1 == GNUNET_OK) || (ret2 == GNUNET_OK))
       return GNUNET_OK;
     if ((ret1 == GNUNET_SYSERR) || (ret2 == GNUNET_SYSERR))
@@ -321,11 +459,11 @@ getaddrinfo_resolve (struct GNUNET_SERVER_TransmitContext *tc,
   hints.ai_family = af;
   hints.ai_socktype = SOCK_STREAM;      /* go for TCP */
 
-  if (0 != (s = getaddrinfo (hostname, NULL, &hints, &result)))
+  if (0 != (s = getaddrinfo (hc->hostname, NULL, &hints, &result)))
   {
     GNUNET_log (GNUNET_ERROR_TYPE_INFO,
                 _("Could not resolve `%s' (%s): %s\n"),
-                hostname,
+                hc->hostname,
                 (af ==
                  AF_INET) ? "IPv4" : ((af == AF_INET6) ? "IPv6" : "any"),
                 gai_strerror (s));
@@ -346,16 +484,14 @@ getaddrinfo_resolve (struct GNUNET_SERVER_TransmitContext *tc,
     switch (pos->ai_family)
     {
     case AF_INET:
-      GNUNET_SERVER_transmit_context_append_data (tc,
-						  &((struct sockaddr_in*) pos->ai_addr)->sin_addr,
-						  sizeof (struct in_addr),
-						  GNUNET_MESSAGE_TYPE_RESOLVER_RESPONSE);
+      cache_append_address (hc,
+			    &((struct sockaddr_in*) pos->ai_addr)->sin_addr,
+			    sizeof (struct in_addr));
       break;
     case AF_INET6:
-      GNUNET_SERVER_transmit_context_append_data (tc,
-						  &((struct sockaddr_in6*) pos->ai_addr)->sin6_addr,
-						  sizeof (struct in6_addr),
-						  GNUNET_MESSAGE_TYPE_RESOLVER_RESPONSE);
+      cache_append_address (hc,
+			    &((struct sockaddr_in6*) pos->ai_addr)->sin6_addr,
+			    sizeof (struct in6_addr));
       break;
     default:
       /* unsupported, skip */
@@ -371,8 +507,7 @@ getaddrinfo_resolve (struct GNUNET_SERVER_TransmitContext *tc,
 
 
 static int
-gethostbyname2_resolve (struct GNUNET_SERVER_TransmitContext *tc,
-                        const char *hostname,
+gethostbyname2_resolve (struct HostCache *hc,
                         int af)
 {
   struct hostent *hp;
@@ -386,19 +521,19 @@ gethostbyname2_resolve (struct GNUNET_SERVER_TransmitContext *tc,
 
   if (af == AF_UNSPEC)
   {
-    ret1 = gethostbyname2_resolve (tc, hostname, AF_INET);
-    ret2 = gethostbyname2_resolve (tc, hostname, AF_INET6);
+    ret1 = gethostbyname2_resolve (hc, AF_INET);
+    ret2 = gethostbyname2_resolve (hc, AF_INET6);
     if ((ret1 == GNUNET_OK) || (ret2 == GNUNET_OK))
       return GNUNET_OK;
     if ((ret1 == GNUNET_SYSERR) || (ret2 == GNUNET_SYSERR))
       return GNUNET_SYSERR;
     return GNUNET_NO;
   }
-  hp = gethostbyname2 (hostname, af);
+  hp = gethostbyname2 (hc->hostname, af);
   if (hp == NULL)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_INFO,
-                _("Could not find IP of host `%s': %s\n"), hostname,
+                _("Could not find IP of host `%s': %s\n"), hc->hostname,
                 hstrerror (h_errno));
     return GNUNET_SYSERR;
   }
@@ -407,17 +542,15 @@ gethostbyname2_resolve (struct GNUNET_SERVER_TransmitContext *tc,
   {
   case AF_INET:
     GNUNET_assert (hp->h_length == sizeof (struct in_addr));
-    GNUNET_SERVER_transmit_context_append_data (tc,
-						hp->h_addr_list[0],
-						hp->h_length,
-                                                GNUNET_MESSAGE_TYPE_RESOLVER_RESPONSE);
+    cache_append_address (hc,
+			  hp->h_addr_list[0],
+			  hp->h_length);
     break;
   case AF_INET6:
     GNUNET_assert (hp->h_length == sizeof (struct in6_addr));
-    GNUNET_SERVER_transmit_context_append_data (tc,
-						hp->h_addr_list[0],
-						hp->h_length,
-                                                GNUNET_MESSAGE_TYPE_RESOLVER_RESPONSE);
+    cache_append_address (hc,
+			  hp->h_addr_list[0],
+			  hp->h_length);
     break;
   default:
     GNUNET_break (0);
@@ -430,17 +563,16 @@ gethostbyname2_resolve (struct GNUNET_SERVER_TransmitContext *tc,
 
 
 static int
-gethostbyname_resolve (struct GNUNET_SERVER_TransmitContext *tc,
-                       const char *hostname)
+gethostbyname_resolve (struct HostCache *hc)
 {
   struct hostent *hp;
 
-  hp = GETHOSTBYNAME (hostname);
+  hp = GETHOSTBYNAME (hc->hostname);
   if (NULL == hp)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_INFO,
                 _("Could not find IP of host `%s': %s\n"),
-                hostname,
+                hc->hostname,
                 hstrerror (h_errno));
     return GNUNET_SYSERR;
   }
@@ -450,17 +582,38 @@ gethostbyname_resolve (struct GNUNET_SERVER_TransmitContext *tc,
     return GNUNET_SYSERR;
   }
   GNUNET_assert (hp->h_length == sizeof (struct in_addr));
-  GNUNET_SERVER_transmit_context_append_data (tc,
-					      hp->h_addr_list[0],
-					      hp->h_length,
-                                              GNUNET_MESSAGE_TYPE_RESOLVER_RESPONSE);
+  cache_append_address (hc,
+			hp->h_addr_list[0],
+			hp->h_length);
   return GNUNET_OK;
 }
 #endif
 
 
 /**
- * Convert a string to an IP address.
+ * Resolve the hostname of the given cache entry using the
+ * available methods, storing the addresses found in the entry.
+ *
+ * @param hc the entry to resolve (and where to store the result)
+ */
+static void
+host_resolve (struct HostCache *hc)
+{
+#if HAVE_GETADDRINFO
+  (void) getaddrinfo_resolve (hc, hc->af);
+#elif HAVE_GETHOSTBYNAME2
+  (void) gethostbyname2_resolve (hc, hc->af);
+#elif HAVE_GETHOSTBYNAME
+  if ((hc->af == AF_UNSPEC) || (hc->af == PF_INET))
+    (void) gethostbyname_resolve (hc);
+#endif
+}
+
+
+/**
+ * Convert a string to an IP address.  Responses are served from
+ * the forward lookup cache when possible, so only the first
+ * request for a hostname blocks on the actual DNS lookup.
  *
  * @param client where to send the IP address
  * @param hostname the hostname to resolve
@@ -471,21 +624,58 @@ get_ip_from_hostname (struct GNUNET_SERVER_Client *client,
                       const char *hostname,
                       int af)
 {
-  int ret;
+  struct HostCache *pos;
+  struct HostCache *next;
+  struct GNUNET_TIME_Absolute now;
   struct GNUNET_SERVER_TransmitContext *tc;
+  struct AddressEntry *ae;
+  size_t hlen;
 
+  now = GNUNET_TIME_absolute_get ();
+  next = hosts_head;
+  while (NULL != (pos = next))
+  {
+    next = pos->next;
+    if (GNUNET_TIME_absolute_get_duration (pos->last_refresh).rel_value_us >
+        CACHE_VALIDITY)
+    {
+      /* answer too old to serve, DNS may have changed, evict */
+      free_host_entry (pos);
+      continue;
+    }
+    if ( (pos->af == af) &&
+	 (0 == strcasecmp (pos->hostname, hostname)) )
+      break;
+  }
+  if (NULL != pos)
+  {
+    if ( (NULL == pos->ae_head) &&
+         (GNUNET_TIME_absolute_get_duration (pos->last_refresh).rel_value_us >
+          RETRY_VALIDITY) )
+    {
+      /* try again if the lookup failed AND 2 minutes have expired */
+      host_resolve (pos);
+      pos->last_refresh = now;
+    }
+  }
+  else
+  {
+    hlen = strlen (hostname) + 1;
+    pos = GNUNET_malloc (sizeof (struct HostCache) + hlen);
+    pos->hostname = (const char *) &pos[1];
+    memcpy (&pos[1], hostname, hlen);
+    pos->af = af;
+    pos->last_refresh = now;
+    GNUNET_CONTAINER_DLL_insert (hosts_head,
+				 hosts_tail,
+				 pos);
+    host_resolve (pos);
+  }
   tc = GNUNET_SERVER_transmit_context_create (client);
-  ret = GNUNET_NO;
-#if HAVE_GETADDRINFO
-  if (ret == GNUNET_NO)
-    ret = getaddrinfo_resolve (tc, hostname, af);
-#elif HAVE_GETHOSTBYNAME2
-  if (ret == GNUNET_NO)
-    ret = gethostbyname2_resolve (tc, hostname, af);
-#elif HAVE_GETHOSTBYNAME
-  if ((ret == GNUNET_NO) && ((af == AF_UNSPEC) || (af == PF_INET)))
-    gethostbyname_resolve (tc, hostname);
-#endif
+  for (ae = pos->ae_head; NULL != ae; ae = ae->next)
+    GNUNET_SERVER_transmit_context_append_data (tc, ae->addr,
+                                                ae->addr_len,
+                                                GNUNET_MESSAGE_TYPE_RESOLVER_RESPONSE);
   GNUNET_SERVER_transmit_context_append_data (tc, NULL, 0,
                                               GNUNET_MESSAGE_TYPE_RESOLVER_RESPONSE);
   GNUNET_SERVER_transmit_context_run (tc, GNUNET_TIME_UNIT_FOREVER_REL);
@@ -626,6 +816,8 @@ main (int argc, char *const *argv)
     GNUNET_free_non_null (pos->addr);
     GNUNET_free (pos);
   }
+  while (NULL != hosts_head)
+    free_host_entry (hosts_head);
   return ret;
 }
 
@@ -603,45 +603,51 @@ helper_write (void *cls,
 						     h->fh_to_helper, &helper_write, h);
     return;
   }
-  if (NULL == (sh = h->sh_head))
+  if (NULL == h->sh_head)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
 		"Helper write had no work!\n");
     return; /* how did this happen? */
   }
-  buf = (const char*) sh->msg;
-  t = GNUNET_DISK_file_write (h->fh_to_helper,
-			      &buf[sh->wpos],
-			      ntohs (sh->msg->size) - sh->wpos);
-  if (-1 == t)
+  /* drain the entire queue while the pipe accepts data; this way a
+     single wakeup can flush many queued messages */
+  while (NULL != (sh = h->sh_head))
   {
-    /* On write-error, restart the helper */
-    GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
-		_("Error writing to `%s': %s\n"),
-		h->binary_name,
-		STRERROR (errno));
-    if (NULL != h->exp_cb)
+    buf = (const char*) sh->msg;
+    t = GNUNET_DISK_file_write (h->fh_to_helper,
+				&buf[sh->wpos],
+				ntohs (sh->msg->size) - sh->wpos);
+    if (-1 == t)
     {
-      h->exp_cb (h->cb_cls);
-      GNUNET_HELPER_stop (h, GNUNET_NO);
-      return;
-    }
-    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-		"Stopping and restarting helper task!\n");
-    stop_helper (h, GNUNET_NO);
-    /* Restart the helper */
+      if ( (EAGAIN == errno) || (EWOULDBLOCK == errno) )
+	break; /* pipe full, wait for it to drain */
+      /* On write-error, restart the helper */
+      GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
+		  _("Error writing to `%s': %s\n"),
+		  h->binary_name,
+		  STRERROR (errno));
+      if (NULL != h->exp_cb)
+      {
+	h->exp_cb (h->cb_cls);
+	GNUNET_HELPER_stop (h, GNUNET_NO);
+	return;
+      }
+      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+		  "Stopping and restarting helper task!\n");
+      stop_helper (h, GNUNET_NO);
+      /* Restart the helper */
       h->restart_task = GNUNET_SCHEDULER_add_delayed(
           GNUNET_TIME_relative_multiply(GNUNET_TIME_UNIT_SECONDS,
               h->retry_back_off), &restart_task, h);
-    return;
-  }
-  GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
-	      "Transmitted %u bytes to %s\n",
-	      (unsigned int) t,
-	      h->binary_name);
-  sh->wpos += t;
-  if (sh->wpos == ntohs (sh->msg->size))
-  {
+      return;
+    }
+    GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+		"Transmitted %u bytes to %s\n",
+		(unsigned int) t,
+		h->binary_name);
+    sh->wpos += t;
+    if (sh->wpos != ntohs (sh->msg->size))
+      break; /* partial write, wait for the pipe to drain */
     GNUNET_CONTAINER_DLL_remove (h->sh_head,
 				 h->sh_tail,
 				 sh);
@@ -704,6 +710,57 @@ GNUNET_HELPER_send (struct GNUNET_HELPER_Handle *h,
   return sh;
 }
 
+
+/**
+ * Send a message to the helper without copying it.  In contrast to
+ * #GNUNET_HELPER_send(), the message is borrowed from the caller, who
+ * must keep it valid until @a cont is called and may release it from
+ * there.  @a cont is invoked on every outcome (transmission, helper
+ * death, #GNUNET_HELPER_destroy), except if the message is dropped
+ * (NULL is returned) or the operation is cancelled via
+ * #GNUNET_HELPER_send_cancel().
+ *
+ * @param h helper to send message to
+ * @param msg message to send; must remain valid until @a cont is called
+ * @param can_drop can the message be dropped if there is already one in the queue?
+ * @param cont continuation to run once the message is out (#GNUNET_OK on succees, #GNUNET_NO
+ *             if the helper process died, #GNUNET_SYSERR during #GNUNET_HELPER_destroy).
+ * @param cont_cls closure for @a cont
+ * @return NULL if the message was dropped,
+ *         otherwise handle to cancel *cont* (actual transmission may
+ *         not be abortable)
+ */
+struct GNUNET_HELPER_SendHandle *
+GNUNET_HELPER_send_borrowed (struct GNUNET_HELPER_Handle *h,
+			     const struct GNUNET_MessageHeader *msg,
+			     int can_drop,
+			     GNUNET_HELPER_Continuation cont,
+			     void *cont_cls)
+{
+  struct GNUNET_HELPER_SendHandle *sh;
+
+  if (NULL == h->fh_to_helper)
+    return NULL;
+  if ( (GNUNET_YES == can_drop) &&
+       (NULL != h->sh_head) )
+    return NULL;
+  sh = GNUNET_new (struct GNUNET_HELPER_SendHandle);
+  sh->msg = msg;
+  sh->h = h;
+  sh->cont = cont;
+  sh->cont_cls = cont_cls;
+  GNUNET_CONTAINER_DLL_insert_tail (h->sh_head,
+				    h->sh_tail,
+				    sh);
+  if (NULL == h->write_task)
+    h->write_task = GNUNET_SCHEDULER_add_write_file (GNUNET_TIME_UNIT_FOREVER_REL,
+						     h->fh_to_helper,
+						     &helper_write,
+						     h);
+  return sh;
+}
+
+
 /**
  * Cancel a #GNUNET_HELPER_send operation.  If possible, transmitting the
  * message is also aborted, but at least 'cont' won't be
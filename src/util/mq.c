@@ -28,6 +28,18 @@
 
 #define LOG(kind,...) GNUNET_log_from (kind, "mq",__VA_ARGS__)
 
+/**
+ * Maximum payload size (in bytes) for envelopes served from the
+ * envelope arena.  Larger messages fall back to plain allocation.
+ */
+#define MQ_ARENA_PAYLOAD 256
+
+/**
+ * Maximum number of free arena envelopes we cache before returning
+ * memory to the allocator.
+ */
+#define MQ_ARENA_MAX_FREE 256
+
 
 struct GNUNET_MQ_Envelope
 {
@@ -63,9 +75,78 @@ struct GNUNET_MQ_Envelope
    * Closure for @e send_cb
    */
   void *sent_cls;
+
+  /**
+   * #GNUNET_YES if the envelope was allocated from the
+   * envelope arena and should be returned to it on free.
+   */
+  int arena;
 };
 
 
+/**
+ * Singly-linked list (via @e next) of free arena envelopes.
+ */
+static struct GNUNET_MQ_Envelope *arena_free_head;
+
+/**
+ * Number of envelopes in the @e arena_free_head list.
+ */
+static unsigned int arena_free_count;
+
+
+/**
+ * Allocate an envelope with @a size bytes of payload, preferably
+ * from the envelope arena.
+ *
+ * @param size number of payload bytes following the envelope
+ * @return the (zeroed out) envelope
+ */
+static struct GNUNET_MQ_Envelope *
+env_alloc (uint16_t size)
+{
+  struct GNUNET_MQ_Envelope *env;
+
+  if ( (size > MQ_ARENA_PAYLOAD) ||
+       (NULL == arena_free_head) )
+  {
+    env = GNUNET_malloc (sizeof (struct GNUNET_MQ_Envelope) +
+                         ((size > MQ_ARENA_PAYLOAD)
+                          ? size
+                          : MQ_ARENA_PAYLOAD));
+    env->arena = (size <= MQ_ARENA_PAYLOAD) ? GNUNET_YES : GNUNET_NO;
+    return env;
+  }
+  env = arena_free_head;
+  arena_free_head = env->next;
+  arena_free_count--;
+  memset (env, 0, sizeof (struct GNUNET_MQ_Envelope) + MQ_ARENA_PAYLOAD);
+  env->arena = GNUNET_YES;
+  return env;
+}
+
+
+/**
+ * Free an envelope, returning arena envelopes to the
+ * free list (unless it is already full).
+ *
+ * @param env envelope to free
+ */
+static void
+env_free (struct GNUNET_MQ_Envelope *env)
+{
+  if ( (GNUNET_YES != env->arena) ||
+       (arena_free_count >= MQ_ARENA_MAX_FREE) )
+  {
+    GNUNET_free (env);
+    return;
+  }
+  env->next = arena_free_head;
+  arena_free_head = env;
+  arena_free_count++;
+}
+
+
 /**
  * Handle to a message queue.
  */
@@ -125,6 +206,13 @@ struct GNUNET_MQ_Handle
    */
   struct GNUNET_MQ_Envelope *current_envelope;
 
+  /**
+   * Number of message bytes in the envelope list (not
+   * counting @e current_envelope); used to size vectored
+   * transmission requests.
+   */
+  size_t queue_size;
+
   /**
    * Map of associations, lazily allocated
    */
@@ -259,7 +347,7 @@ void
 GNUNET_MQ_discard (struct GNUNET_MQ_Envelope *mqm)
 {
   GNUNET_assert (NULL == mqm->parent_queue);
-  GNUNET_free (mqm);
+  env_free (mqm);
 }
 
 
@@ -284,6 +372,7 @@ GNUNET_MQ_send (struct GNUNET_MQ_Handle *mq,
     GNUNET_CONTAINER_DLL_insert_tail (mq->envelope_head,
                                       mq->envelope_tail,
                                       ev);
+    mq->queue_size += ntohs (ev->mh->size);
     return;
   }
   mq->current_envelope = ev;
@@ -325,11 +414,12 @@ impl_send_continue (void *cls,
     GNUNET_CONTAINER_DLL_remove (mq->envelope_head,
                                  mq->envelope_tail,
                                  mq->current_envelope);
+    mq->queue_size -= ntohs (mq->current_envelope->mh->size);
     mq->send_impl (mq, mq->current_envelope->mh, mq->impl_state);
   }
   if (NULL != current_envelope->sent_cb)
     current_envelope->sent_cb (current_envelope->sent_cls);
-  GNUNET_free (current_envelope);
+  env_free (current_envelope);
 }
 
 
@@ -433,7 +523,7 @@ GNUNET_MQ_msg_ (struct GNUNET_MessageHeader **mhp,
 {
   struct GNUNET_MQ_Envelope *mqm;
 
-  mqm = GNUNET_malloc (sizeof *mqm + size);
+  mqm = env_alloc (size);
   mqm->mh = (struct GNUNET_MessageHeader *) &mqm[1];
   mqm->mh->size = htons (size);
   mqm->mh->type = htons (type);
@@ -477,6 +567,63 @@ GNUNET_MQ_msg_nested_mh_ (struct GNUNET_MessageHeader **mhp,
 }
 
 
+/**
+ * Compute the number of bytes to ask the transmission layer
+ * for, coalescing the current message with as much of the
+ * envelope queue as the connection permits.
+ *
+ * @param mq queue with pending envelopes
+ * @param msg message at the head of the queue
+ * @return number of bytes to request
+ */
+static size_t
+transmit_request_size (struct GNUNET_MQ_Handle *mq,
+                       const struct GNUNET_MessageHeader *msg)
+{
+  return GNUNET_MIN (ntohs (msg->size) + mq->queue_size,
+                     GNUNET_SERVER_MAX_MESSAGE_SIZE - 1);
+}
+
+
+/**
+ * Append as many queued envelopes as fit into the transmission
+ * buffer behind the current message, notifying and freeing each
+ * envelope as it is copied out.
+ *
+ * @param mq queue to drain
+ * @param buf transmission buffer
+ * @param size number of bytes available in @a buf
+ * @param off offset of the first free byte in @a buf
+ * @return offset after the last message written to @a buf
+ */
+static size_t
+transmit_batch (struct GNUNET_MQ_Handle *mq,
+                void *buf,
+                size_t size,
+                size_t off)
+{
+  struct GNUNET_MQ_Envelope *ev;
+  uint16_t msize;
+
+  while ( (NULL != (ev = mq->envelope_head)) &&
+          (off + ntohs (ev->mh->size) <= size) )
+  {
+    msize = ntohs (ev->mh->size);
+    GNUNET_CONTAINER_DLL_remove (mq->envelope_head,
+                                 mq->envelope_tail,
+                                 ev);
+    mq->queue_size -= msize;
+    memcpy (&((char *) buf)[off], ev->mh, msize);
+    off += msize;
+    ev->parent_queue = NULL;
+    if (NULL != ev->sent_cb)
+      ev->sent_cb (ev->sent_cls);
+    env_free (ev);
+  }
+  return off;
+}
+
+
 /**
  * Transmit a queued message to the session's client.
  *
@@ -499,6 +646,7 @@ transmit_queued (void *cls, size_t size,
   msg_size = ntohs (msg->size);
   GNUNET_assert (size >= msg_size);
   memcpy (buf, msg, msg_size);
+  msg_size = transmit_batch (mq, buf, size, msg_size);
   state->th = NULL;
 
   GNUNET_MQ_impl_send_continue (mq);
@@ -536,7 +684,8 @@ server_client_send_impl (struct GNUNET_MQ_Handle *mq,
   GNUNET_assert (NULL != mq);
   GNUNET_assert (NULL != state);
   state->th =
-      GNUNET_SERVER_notify_transmit_ready (state->client, ntohs (msg->size),
+      GNUNET_SERVER_notify_transmit_ready (state->client,
+                                           transmit_request_size (mq, msg),
                                            GNUNET_TIME_UNIT_FOREVER_REL,
                                            &transmit_queued, mq);
 }
@@ -626,6 +775,7 @@ connection_client_transmit_queued (void *cls,
   msg_size = ntohs (msg->size);
   GNUNET_assert (size >= msg_size);
   memcpy (buf, msg, msg_size);
+  msg_size = transmit_batch (mq, buf, size, msg_size);
   state->th = NULL;
 
   GNUNET_MQ_impl_send_continue (mq);
@@ -652,7 +802,8 @@ connection_client_send_impl (struct GNUNET_MQ_Handle *mq,
   GNUNET_assert (NULL != state);
   GNUNET_assert (NULL == state->th);
   state->th =
-      GNUNET_CLIENT_notify_transmit_ready (state->connection, ntohs (msg->size),
+      GNUNET_CLIENT_notify_transmit_ready (state->connection,
+                                           transmit_request_size (mq, msg),
                                            GNUNET_TIME_UNIT_FOREVER_REL, GNUNET_NO,
                                            &connection_client_transmit_queued, mq);
   GNUNET_assert (NULL != state->th);
@@ -866,16 +1017,18 @@ GNUNET_MQ_send_cancel (struct GNUNET_MQ_Envelope *ev)
       GNUNET_CONTAINER_DLL_remove (mq->envelope_head,
                                    mq->envelope_tail,
                                    mq->current_envelope);
+      mq->queue_size -= ntohs (mq->current_envelope->mh->size);
       mq->send_impl (mq, mq->current_envelope->mh, mq->impl_state);
     }
   } else {
     // simple case, message is still waiting in the queue
     GNUNET_CONTAINER_DLL_remove (mq->envelope_head, mq->envelope_tail, ev);
+    mq->queue_size -= ntohs (ev->mh->size);
   }
 
   ev->parent_queue = NULL;
   ev->mh = NULL;
-  GNUNET_free (ev);
+  env_free (ev);
 }
 
 /* end of mq.c */
@@ -571,6 +571,7 @@ GNUNET_NETWORK_socket_close (struct GNUNET_NETWORK_Handle *desc)
        ret,
        error);
 #else
+  GNUNET_SCHEDULER_notify_fd_closed_ (desc->fd);
   ret = close (desc->fd);
 #endif
 #ifndef WINDOWS
@@ -49,9 +49,26 @@ struct PluginList
    * System handle.
    */
   void *handle;
+
+  /**
+   * Resolved initialization function of the plugin.
+   */
+  GNUNET_PLUGIN_Callback init;
+
+  /**
+   * Resolved shutdown function of the plugin, resolved
+   * together with @e init so unloading (and reloading)
+   * does not have to search symbols again.
+   */
+  GNUNET_PLUGIN_Callback done;
 };
 
 
+/**
+ * Maximum number of unloaded plugins we keep resident for reuse.
+ */
+#define PLUGIN_CACHE_MAX 16
+
 /**
  * Have we been initialized?
  */
@@ -67,6 +84,19 @@ static char *old_dlsearchpath;
  */
 static struct PluginList *plugins;
 
+/**
+ * List of plugins that were unloaded, but whose library and resolved
+ * symbols we keep around: tests and service restarts load and unload
+ * the same plugin repeatedly, and re-running the dynamic linker for
+ * each cycle dominates their startup time.
+ */
+static struct PluginList *plugin_cache;
+
+/**
+ * Number of entries in the #plugin_cache list.
+ */
+static unsigned int plugin_cache_size;
+
 
 /**
  * Setup libtool paths.
@@ -171,12 +201,16 @@ GNUNET_PLUGIN_test (const char *library_name)
   void *libhandle;
   GNUNET_PLUGIN_Callback init;
   struct PluginList plug;
+  struct PluginList *pos;
 
   if (! initialized)
   {
     initialized = GNUNET_YES;
     plugin_init ();
   }
+  for (pos = plugin_cache; NULL != pos; pos = pos->next)
+    if (0 == strcmp (pos->name, library_name))
+      return GNUNET_YES;
   libhandle = lt_dlopenext (library_name);
   if (NULL == libhandle)
     return GNUNET_NO;
@@ -211,7 +245,7 @@ GNUNET_PLUGIN_load (const char *library_name, void *arg)
 {
   void *libhandle;
   struct PluginList *plug;
-  GNUNET_PLUGIN_Callback init;
+  struct PluginList *prev;
   void *ret;
 
   if (!initialized)
@@ -219,24 +253,45 @@ GNUNET_PLUGIN_load (const char *library_name, void *arg)
     initialized = GNUNET_YES;
     plugin_init ();
   }
-  libhandle = lt_dlopenext (library_name);
-  if (libhandle == NULL)
+  /* check if we still have this plugin resident from an earlier
+     load/unload cycle; if so, skip the dynamic linker entirely */
+  prev = NULL;
+  for (plug = plugin_cache; NULL != plug; plug = plug->next)
   {
-    LOG (GNUNET_ERROR_TYPE_ERROR,
-         _("`%s' failed for library `%s' with error: %s\n"),
-         "lt_dlopenext",
-         library_name, lt_dlerror ());
-    return NULL;
+    if (0 == strcmp (plug->name, library_name))
+      break;
+    prev = plug;
+  }
+  if (NULL != plug)
+  {
+    if (NULL == prev)
+      plugin_cache = plug->next;
+    else
+      prev->next = plug->next;
+    plugin_cache_size--;
+  }
+  else
+  {
+    libhandle = lt_dlopenext (library_name);
+    if (libhandle == NULL)
+    {
+      LOG (GNUNET_ERROR_TYPE_ERROR,
+           _("`%s' failed for library `%s' with error: %s\n"),
+           "lt_dlopenext",
+           library_name, lt_dlerror ());
+      return NULL;
+    }
+    plug = GNUNET_new (struct PluginList);
+    plug->handle = libhandle;
+    plug->name = GNUNET_strdup (library_name);
+    plug->init = resolve_function (plug, "init");
+    plug->done = resolve_function (plug, "done");
   }
-  plug = GNUNET_new (struct PluginList);
-  plug->handle = libhandle;
-  plug->name = GNUNET_strdup (library_name);
   plug->next = plugins;
   plugins = plug;
-  init = resolve_function (plug, "init");
-  if ((init == NULL) || (NULL == (ret = init (arg))))
+  if ((plug->init == NULL) || (NULL == (ret = plug->init (arg))))
   {
-    lt_dlclose (libhandle);
+    lt_dlclose (plug->handle);
     GNUNET_free (plug->name);
     plugins = plug->next;
     GNUNET_free (plug);
@@ -260,7 +315,6 @@ GNUNET_PLUGIN_unload (const char *library_name,
 {
   struct PluginList *pos;
   struct PluginList *prev;
-  GNUNET_PLUGIN_Callback done;
   void *ret;
 
   prev = NULL;
@@ -273,18 +327,27 @@ GNUNET_PLUGIN_unload (const char *library_name,
   if (NULL == pos)
     return NULL;
 
-  done = resolve_function (pos, "done");
   ret = NULL;
-  if (NULL != done)
-    ret = done (arg);
+  if (NULL != pos->done)
+    ret = pos->done (arg);
   if (NULL == prev)
     plugins = pos->next;
   else
     prev->next = pos->next;
+  if (plugin_cache_size < PLUGIN_CACHE_MAX)
+  {
+    /* keep the library and its resolved symbols resident
+       for a possible later reload */
+    pos->next = plugin_cache;
+    plugin_cache = pos;
+    plugin_cache_size++;
+    return ret;
+  }
   lt_dlclose (pos->handle);
   GNUNET_free (pos->name);
   GNUNET_free (pos);
-  if (NULL == plugins)
+  if ( (NULL == plugins) &&
+       (NULL == plugin_cache) )
   {
     plugin_fini ();
     initialized = GNUNET_NO;
@@ -70,6 +70,51 @@
 #define DELAY_THRESHOLD GNUNET_TIME_UNIT_SECONDS
 
 
+/**
+ * Number of bits of the timeout tick counter resolved per level of
+ * the hierarchical timer wheel.
+ */
+#define WHEEL_BITS 8
+
+/**
+ * Number of slots per level of the timer wheel.
+ */
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+
+/**
+ * Number of levels of the timer wheel.  With 8 bits per level and
+ * about 1 ms per tick, four levels cover roughly 50 days; timeouts
+ * further in the future (including "forever") are clamped to the
+ * last slot and re-cascaded when the wheel gets there.
+ */
+#define WHEEL_LEVELS 4
+
+/**
+ * Duration of one tick of the timer wheel in microseconds.  This is
+ * the granularity at which delayed tasks are expired; tasks scheduled
+ * with #GNUNET_TIME_UNIT_ZERO bypass the wheel entirely.
+ */
+#define WHEEL_GRANULARITY_US 1024LLU
+
+
+/**
+ * Slot of the hierarchical timer wheel, a doubly-linked list of
+ * tasks expiring within the range of ticks covered by the slot.
+ */
+struct WheelSlot
+{
+  /**
+   * Head of the list of tasks in this slot.
+   */
+  struct GNUNET_SCHEDULER_Task *head;
+
+  /**
+   * Tail of the list of tasks in this slot.
+   */
+  struct GNUNET_SCHEDULER_Task *tail;
+};
+
+
 /**
  * Entry in list of pending tasks.
  */
@@ -156,6 +201,12 @@ struct GNUNET_SCHEDULER_Task
    */
   int in_ready_list;
 
+  /**
+   * Slot of the timer wheel this task is queued in, NULL if
+   * the task is not waiting (only) for a timeout.
+   */
+  struct WheelSlot *wheel_slot;
+
 #if EXECINFO
   /**
    * Array of strings which make up a backtrace from the point when this
@@ -184,28 +235,82 @@ static struct GNUNET_SCHEDULER_Task *pending_head;
 static struct GNUNET_SCHEDULER_Task *pending_tail;
 
 /**
- * List of tasks waiting ONLY for a timeout event.
- * Sorted by timeout (earliest first).  Used so that
- * we do not traverse the list of these tasks when
- * building select sets (we just look at the head
- * to determine the respective timeout ONCE).
+ * Slots of the hierarchical timer wheel holding tasks waiting ONLY
+ * for a timeout event.  Insertion and cancellation are O(1); the
+ * wheel is advanced once per scheduler iteration.  Level @a l spans
+ * slots <tt>[l * WHEEL_SLOTS, (l+1) * WHEEL_SLOTS)</tt>.
+ */
+static struct WheelSlot wheel[WHEEL_LEVELS * WHEEL_SLOTS];
+
+/**
+ * Bitmap with one bit per slot of #wheel, set while the respective
+ * slot is non-empty.  Used to find the next expiring slot without
+ * touching the task lists themselves.
+ */
+static uint64_t wheel_occupancy[(WHEEL_LEVELS * WHEEL_SLOTS) / 64];
+
+/**
+ * Pseudo-slot holding timeout tasks that are due (or flagged with a
+ * reason, i.e. shutdown) and merely wait for check_ready() to move
+ * them to the ready queues.
+ */
+static struct WheelSlot wheel_expired;
+
+/**
+ * Tick the timer wheel has been advanced to, zero if the wheel has
+ * not been used yet.
+ */
+static uint64_t wheel_now;
+
+/**
+ * Number of tasks queued in the timer wheel (including #wheel_expired).
+ */
+static unsigned int timeout_task_count;
+
+/**
+ * Maximum number of released task structs kept for reuse.  Virtually
+ * every operation in the system schedules tasks, so recycling the
+ * structs avoids a malloc/free pair per task in steady state.
  */
-static struct GNUNET_SCHEDULER_Task *pending_timeout_head;
+#define TASK_POOL_MAX 64
 
 /**
- * List of tasks waiting ONLY for a timeout event.
- * Sorted by timeout (earliest first).  Used so that
- * we do not traverse the list of these tasks when
- * building select sets (we just look at the head
- * to determine the respective timeout ONCE).
+ * Singly-linked list (via 'next') of released task structs
+ * available for reuse.
  */
-static struct GNUNET_SCHEDULER_Task *pending_timeout_tail;
+static struct GNUNET_SCHEDULER_Task *task_pool_head;
 
 /**
- * Last inserted task waiting ONLY for a timeout event.
- * Used to (heuristically) speed up insertion.
+ * Number of task structs in the #task_pool_head list.
  */
-static struct GNUNET_SCHEDULER_Task *pending_timeout_last;
+static unsigned int task_pool_size;
+
+
+/**
+ * Allocate a task struct, preferably from the task pool.
+ *
+ * @return zero-initialized task struct
+ */
+static struct GNUNET_SCHEDULER_Task *
+alloc_task ()
+{
+  struct GNUNET_SCHEDULER_Task *t;
+
+  if (NULL != task_pool_head)
+  {
+    t = task_pool_head;
+    task_pool_head = t->next;
+    task_pool_size--;
+    memset (t, 0, sizeof (struct GNUNET_SCHEDULER_Task));
+    return t;
+  }
+  return GNUNET_new (struct GNUNET_SCHEDULER_Task);
+}
+
+/**
+ * Number of tasks in the timer wheel with the lifeness flag set.
+ */
+static unsigned int timeout_lifeness_count;
 
 /**
  * ID of the task that is running right now.
@@ -227,6 +332,11 @@ static struct GNUNET_SCHEDULER_Task *ready_tail[GNUNET_SCHEDULER_PRIORITY_COUNT]
  */
 static unsigned int ready_count;
 
+/**
+ * Number of tasks on the ready list, per priority.
+ */
+static unsigned int ready_counts[GNUNET_SCHEDULER_PRIORITY_COUNT];
+
 /**
  * How many tasks have we run so far?
  */
@@ -261,6 +371,402 @@ static GNUNET_SCHEDULER_select scheduler_select;
 static void *scheduler_select_cls;
 
 
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#define HAVE_EVENT_BACKEND 1
+#elif HAVE_SYS_EVENT_H
+#include <sys/event.h>
+#define HAVE_EVENT_BACKEND 1
+#endif
+
+#if HAVE_EVENT_BACKEND
+
+/**
+ * We would like to be notified when the descriptor is readable.
+ */
+#define BACKEND_WANT_READ 1
+
+/**
+ * We would like to be notified when the descriptor is writable.
+ */
+#define BACKEND_WANT_WRITE 2
+
+/**
+ * The kernel refused to queue the descriptor (i.e. a regular file);
+ * treat it as permanently ready, matching select() semantics.
+ */
+#define BACKEND_ALWAYS_READY 4
+
+/**
+ * Maximum number of kernel events we dequeue per iteration.
+ */
+#define BACKEND_MAX_EVENTS 128
+
+/**
+ * File descriptor of the epoll/kqueue instance, -1 if the
+ * backend is not initialized.
+ */
+static int backend_fd = -1;
+
+/**
+ * Interest currently registered with the kernel, one set of
+ * BACKEND_WANT_* flags per file descriptor.
+ */
+static uint8_t *backend_state;
+
+/**
+ * Allocated length of #backend_state.
+ */
+static unsigned int backend_state_len;
+
+/**
+ * Highest file descriptor (plus one) with a non-zero entry
+ * in #backend_state.
+ */
+static int backend_nsds;
+
+/**
+ * Number of descriptors currently in always-ready fallback mode.
+ */
+static unsigned int backend_always_ready;
+
+/**
+ * #GNUNET_YES if the scheduler installed the kernel event backend
+ * as its select function (and thus must clean it up again).
+ */
+static int backend_active;
+
+
+/**
+ * Tell the kernel about a change in interest for one descriptor.
+ *
+ * @param fd descriptor to update
+ * @param want desired BACKEND_WANT_* flags
+ * @param have currently registered BACKEND_WANT_* flags
+ * @return 0 on success, -1 on error (with errno set)
+ */
+static int
+backend_apply (int fd,
+               uint8_t want,
+               uint8_t have)
+{
+#if HAVE_SYS_EPOLL_H
+  struct epoll_event ev;
+
+  memset (&ev, 0, sizeof (ev));
+  ev.data.fd = fd;
+  if (0 != (want & BACKEND_WANT_READ))
+    ev.events |= EPOLLIN;
+  if (0 != (want & BACKEND_WANT_WRITE))
+    ev.events |= EPOLLOUT;
+  if (0 == want)
+    return epoll_ctl (backend_fd, EPOLL_CTL_DEL, fd, NULL);
+  if (0 == have)
+    return epoll_ctl (backend_fd, EPOLL_CTL_ADD, fd, &ev);
+  return epoll_ctl (backend_fd, EPOLL_CTL_MOD, fd, &ev);
+#else
+  struct kevent kev;
+  int ret;
+
+  ret = 0;
+  if ( (0 == (want & BACKEND_WANT_READ)) !=
+       (0 == (have & BACKEND_WANT_READ)) )
+  {
+    EV_SET (&kev, fd, EVFILT_READ,
+            (0 != (want & BACKEND_WANT_READ)) ? EV_ADD : EV_DELETE,
+            0, 0, NULL);
+    ret = kevent (backend_fd, &kev, 1, NULL, 0, NULL);
+  }
+  if ( (0 == ret) &&
+       ( (0 == (want & BACKEND_WANT_WRITE)) !=
+         (0 == (have & BACKEND_WANT_WRITE)) ) )
+  {
+    EV_SET (&kev, fd, EVFILT_WRITE,
+            (0 != (want & BACKEND_WANT_WRITE)) ? EV_ADD : EV_DELETE,
+            0, 0, NULL);
+    ret = kevent (backend_fd, &kev, 1, NULL, 0, NULL);
+  }
+  return ret;
+#endif
+}
+
+
+/**
+ * Wait for kernel events, filling @a rready and @a wready with the
+ * descriptors that became ready for reading respectively writing.
+ *
+ * @param timeout how long to wait at most
+ * @param rready set to fill with read-ready descriptors
+ * @param wready set to fill with write-ready descriptors
+ * @return number of events on success, -1 on error (with errno set)
+ */
+static int
+backend_wait (struct GNUNET_TIME_Relative timeout,
+              fd_set *rready,
+              fd_set *wready)
+{
+  int i;
+  int fd;
+  int ret;
+#if HAVE_SYS_EPOLL_H
+  struct epoll_event events[BACKEND_MAX_EVENTS];
+  int timeout_ms;
+
+  if (0 != backend_always_ready)
+    timeout_ms = 0;
+  else if (timeout.rel_value_us ==
+           GNUNET_TIME_UNIT_FOREVER_REL.rel_value_us)
+    timeout_ms = -1;
+  else if (timeout.rel_value_us / 1000LL > INT_MAX)
+    timeout_ms = INT_MAX;
+  else
+    timeout_ms = (int) ((timeout.rel_value_us + 999) / 1000LL);
+  ret = epoll_wait (backend_fd, events, BACKEND_MAX_EVENTS, timeout_ms);
+  if (-1 == ret)
+    return -1;
+  for (i = 0; i < ret; i++)
+  {
+    fd = events[i].data.fd;
+    if (0 != (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+      FD_SET (fd, rready);
+    if (0 != (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)))
+      FD_SET (fd, wready);
+  }
+#else
+  struct kevent events[BACKEND_MAX_EVENTS];
+  struct timespec ts;
+  struct timespec *tsp;
+
+  if (0 != backend_always_ready)
+  {
+    ts.tv_sec = 0;
+    ts.tv_nsec = 0;
+    tsp = &ts;
+  }
+  else if (timeout.rel_value_us ==
+           GNUNET_TIME_UNIT_FOREVER_REL.rel_value_us)
+  {
+    tsp = NULL;
+  }
+  else
+  {
+    ts.tv_sec = timeout.rel_value_us / 1000000LL;
+    ts.tv_nsec = (timeout.rel_value_us % 1000000LL) * 1000LL;
+    tsp = &ts;
+  }
+  ret = kevent (backend_fd, NULL, 0, events, BACKEND_MAX_EVENTS, tsp);
+  if (-1 == ret)
+    return -1;
+  for (i = 0; i < ret; i++)
+  {
+    fd = (int) events[i].ident;
+    if (EVFILT_READ == events[i].filter)
+      FD_SET (fd, rready);
+    if (EVFILT_WRITE == events[i].filter)
+      FD_SET (fd, wready);
+  }
+#endif
+  return ret;
+}
+
+
+/**
+ * select()-compatible entry point of the kernel event backend.
+ * Diffs the given fd sets against the interest registered with the
+ * kernel (so steady-state cost is proportional to the number of
+ * *changed* descriptors, not the total), waits for events and
+ * translates them back into the fd sets.
+ *
+ * @param cls NULL
+ * @param rfds set of sockets to be checked for readability
+ * @param wfds set of sockets to be checked for writability
+ * @param efds set of sockets to be checked for exceptions, must be NULL
+ * @param timeout relative value when to return
+ * @return number of selected sockets, #GNUNET_SYSERR on error
+ */
+static int
+backend_select (void *cls,
+                struct GNUNET_NETWORK_FDSet *rfds,
+                struct GNUNET_NETWORK_FDSet *wfds,
+                struct GNUNET_NETWORK_FDSet *efds,
+                struct GNUNET_TIME_Relative timeout)
+{
+  fd_set rready;
+  fd_set wready;
+  int nfds;
+  int fd;
+  int count;
+  uint8_t want;
+  uint8_t have;
+
+  if (NULL != efds)
+    return GNUNET_NETWORK_socket_select (rfds, wfds, efds, timeout);
+  nfds = backend_nsds;
+  if ( (NULL != rfds) && (rfds->nsds > nfds) )
+    nfds = rfds->nsds;
+  if ( (NULL != wfds) && (wfds->nsds > nfds) )
+    nfds = wfds->nsds;
+  if (nfds > (int) backend_state_len)
+  {
+    backend_state = GNUNET_realloc (backend_state, nfds);
+    memset (&backend_state[backend_state_len],
+            0,
+            nfds - backend_state_len);
+    backend_state_len = nfds;
+  }
+  for (fd = 0; fd < nfds; fd++)
+  {
+    want = 0;
+    if ( (NULL != rfds) && (fd < rfds->nsds) &&
+         (FD_ISSET (fd, &rfds->sds)) )
+      want |= BACKEND_WANT_READ;
+    if ( (NULL != wfds) && (fd < wfds->nsds) &&
+         (FD_ISSET (fd, &wfds->sds)) )
+      want |= BACKEND_WANT_WRITE;
+    have = backend_state[fd];
+    if (0 != (have & BACKEND_ALWAYS_READY))
+    {
+      if (0 == want)
+      {
+        backend_state[fd] = 0;
+        GNUNET_assert (backend_always_ready > 0);
+        backend_always_ready--;
+      }
+      continue;
+    }
+    if (want == have)
+      continue;
+    if (0 != backend_apply (fd, want, have))
+    {
+      if ( (EPERM == errno) && (0 != want) )
+      {
+        /* i.e. a regular file; select() considers those always ready */
+        backend_state[fd] = BACKEND_ALWAYS_READY;
+        backend_always_ready++;
+        continue;
+      }
+      if (0 == want)
+      {
+        /* descriptor was closed and thus auto-deregistered; forget it */
+        backend_state[fd] = 0;
+        continue;
+      }
+      LOG_STRERROR (GNUNET_ERROR_TYPE_ERROR, "backend_apply");
+      return GNUNET_SYSERR;
+    }
+    backend_state[fd] = want;
+  }
+  backend_nsds = nfds;
+  FD_ZERO (&rready);
+  FD_ZERO (&wready);
+  if (-1 == backend_wait (timeout, &rready, &wready))
+  {
+    if (EINTR != errno)
+      LOG_STRERROR (GNUNET_ERROR_TYPE_ERROR, "backend_wait");
+    return GNUNET_SYSERR;
+  }
+  count = 0;
+  if (NULL != rfds)
+  {
+    for (fd = 0; fd < rfds->nsds; fd++)
+    {
+      if (! FD_ISSET (fd, &rfds->sds))
+        continue;
+      if ( (FD_ISSET (fd, &rready)) ||
+           (0 != (backend_state[fd] & BACKEND_ALWAYS_READY)) )
+        count++;
+      else
+        FD_CLR (fd, &rfds->sds);
+    }
+  }
+  if (NULL != wfds)
+  {
+    for (fd = 0; fd < wfds->nsds; fd++)
+    {
+      if (! FD_ISSET (fd, &wfds->sds))
+        continue;
+      if ( (FD_ISSET (fd, &wready)) ||
+           (0 != (backend_state[fd] & BACKEND_ALWAYS_READY)) )
+        count++;
+      else
+        FD_CLR (fd, &wfds->sds);
+    }
+  }
+  return count;
+}
+
+
+/**
+ * Initialize the kernel event backend.
+ *
+ * @return #GNUNET_OK on success, #GNUNET_SYSERR if the backend is
+ *         unavailable (caller should stick to plain select())
+ */
+static int
+backend_init ()
+{
+#if HAVE_SYS_EPOLL_H
+  backend_fd = epoll_create1 (EPOLL_CLOEXEC);
+#else
+  backend_fd = kqueue ();
+#endif
+  if (-1 == backend_fd)
+  {
+    LOG_STRERROR (GNUNET_ERROR_TYPE_WARNING, "backend_init");
+    return GNUNET_SYSERR;
+  }
+  return GNUNET_OK;
+}
+
+
+/**
+ * Shut down the kernel event backend and release its state.
+ */
+static void
+backend_done ()
+{
+  if (-1 == backend_fd)
+    return;
+  GNUNET_break (0 == close (backend_fd));
+  backend_fd = -1;
+  GNUNET_free_non_null (backend_state);
+  backend_state = NULL;
+  backend_state_len = 0;
+  backend_nsds = 0;
+  backend_always_ready = 0;
+}
+
+#endif /* HAVE_EVENT_BACKEND */
+
+
+/**
+ * Notify the scheduler that a file descriptor is being closed.
+ * Internal to libgnunetutil: called by the socket and file close
+ * routines so that the kernel event backend forgets the interest it
+ * has registered for the descriptor.  The kernel drops closed
+ * descriptors from the event set on its own; without this, a new
+ * descriptor reusing the same number with the same interest would
+ * compare equal to the stale cache entry and never be registered.
+ *
+ * @param fd descriptor that is being closed
+ */
+void
+GNUNET_SCHEDULER_notify_fd_closed_ (int fd)
+{
+#if HAVE_EVENT_BACKEND
+  if ( (fd < 0) ||
+       (fd >= (int) backend_state_len) )
+    return;
+  if (0 != (backend_state[fd] & BACKEND_ALWAYS_READY))
+  {
+    GNUNET_assert (backend_always_ready > 0);
+    backend_always_ready--;
+  }
+  backend_state[fd] = 0;
+#endif
+}
+
+
 /**
  * Sets the select function to use in the scheduler (scheduler_select).
  *
@@ -293,6 +799,246 @@ check_priority (enum GNUNET_SCHEDULER_Priority p)
 }
 
 
+/**
+ * Convert an absolute timeout to a tick of the timer wheel,
+ * rounding up so that tasks never expire before their deadline.
+ *
+ * @param timeout absolute timeout to convert
+ * @return tick number of @a timeout
+ */
+static uint64_t
+wheel_tick (struct GNUNET_TIME_Absolute timeout)
+{
+  if (timeout.abs_value_us == GNUNET_TIME_UNIT_FOREVER_ABS.abs_value_us)
+    return UINT64_MAX;
+  return (timeout.abs_value_us + WHEEL_GRANULARITY_US - 1) / WHEEL_GRANULARITY_US;
+}
+
+
+/**
+ * Link a timeout task into the slot of the timer wheel matching its
+ * deadline.  Tasks that are already due (or that have a reason set)
+ * go to #wheel_expired instead.  Does not touch the task counters.
+ *
+ * @param t task to link
+ */
+static void
+wheel_link (struct GNUNET_SCHEDULER_Task *t)
+{
+  uint64_t tick;
+  uint64_t delta;
+  unsigned int level;
+  unsigned int slot;
+
+  if (0 == wheel_now)
+    wheel_now = GNUNET_TIME_absolute_get_cached_ ().abs_value_us / WHEEL_GRANULARITY_US;
+  tick = wheel_tick (t->timeout);
+  if ( (tick <= wheel_now) ||
+       (0 != t->reason) )
+  {
+    t->wheel_slot = &wheel_expired;
+    GNUNET_CONTAINER_DLL_insert_tail (wheel_expired.head,
+                                      wheel_expired.tail,
+                                      t);
+    return;
+  }
+  delta = tick - wheel_now;
+  if (delta >= (1LLU << (WHEEL_BITS * WHEEL_LEVELS)) -
+      (1LLU << (WHEEL_BITS * (WHEEL_LEVELS - 1))))
+  {
+    /* Cap the horizon one top-level slot short of a full revolution
+       so the index computed below can never wrap onto the slot the
+       wheel currently occupies; capped tasks are re-linked from their
+       true timeout on every cascade, so they still expire on time. */
+    delta = (1LLU << (WHEEL_BITS * WHEEL_LEVELS)) -
+      (1LLU << (WHEEL_BITS * (WHEEL_LEVELS - 1))) - 1;
+    tick = wheel_now + delta;
+  }
+  for (level = 0; level < WHEEL_LEVELS - 1; level++)
+    if (delta < (1LLU << (WHEEL_BITS * (level + 1))))
+      break;
+  if ( (level < WHEEL_LEVELS - 1) &&
+       (((tick >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)) ==
+        ((wheel_now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1))) )
+  {
+    /* A delta of exactly WHEEL_SLOTS slots of this level wraps onto
+       the slot the wheel currently occupies, which wheel_advance()
+       only revisits after a full revolution (and which
+       wheel_next_deadline() hence does not scan); park the task one
+       level up, right next to the current slot there. */
+    level++;
+  }
+  slot = level * WHEEL_SLOTS
+    + (unsigned int) ((tick >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+  t->wheel_slot = &wheel[slot];
+  GNUNET_CONTAINER_DLL_insert (wheel[slot].head,
+                               wheel[slot].tail,
+                               t);
+  wheel_occupancy[slot / 64] |= (1LLU << (slot % 64));
+}
+
+
+/**
+ * Unlink a timeout task from its slot of the timer wheel,
+ * updating the occupancy bitmap.  Does not touch the task counters.
+ *
+ * @param t task to unlink
+ */
+static void
+wheel_unlink (struct GNUNET_SCHEDULER_Task *t)
+{
+  struct WheelSlot *ws = t->wheel_slot;
+  size_t slot;
+
+  GNUNET_CONTAINER_DLL_remove (ws->head,
+                               ws->tail,
+                               t);
+  if ( (ws != &wheel_expired) &&
+       (NULL == ws->head) )
+  {
+    slot = ws - wheel;
+    wheel_occupancy[slot / 64] &= ~(1LLU << (slot % 64));
+  }
+  t->wheel_slot = NULL;
+}
+
+
+/**
+ * Add a task waiting only for a timeout to the timer wheel.
+ *
+ * @param t task to add
+ */
+static void
+wheel_insert (struct GNUNET_SCHEDULER_Task *t)
+{
+  wheel_link (t);
+  timeout_task_count++;
+  if (GNUNET_YES == t->lifeness)
+    timeout_lifeness_count++;
+}
+
+
+/**
+ * Remove a task from the timer wheel for good (cancellation or
+ * promotion to the ready queue).
+ *
+ * @param t task to remove
+ */
+static void
+wheel_delete (struct GNUNET_SCHEDULER_Task *t)
+{
+  wheel_unlink (t);
+  GNUNET_assert (timeout_task_count > 0);
+  timeout_task_count--;
+  if (GNUNET_YES == t->lifeness)
+    timeout_lifeness_count--;
+}
+
+
+/**
+ * Redistribute the tasks of the slot of @a level that covers the
+ * window of ticks the wheel is just entering into the lower levels
+ * (or into #wheel_expired, if due).
+ *
+ * @param level level to cascade, must be at least 1
+ */
+static void
+wheel_cascade (unsigned int level)
+{
+  struct WheelSlot *ws;
+  struct GNUNET_SCHEDULER_Task *t;
+
+  ws = &wheel[level * WHEEL_SLOTS
+              + (unsigned int) ((wheel_now >> (WHEEL_BITS * level))
+                                & (WHEEL_SLOTS - 1))];
+  while (NULL != (t = ws->head))
+  {
+    wheel_unlink (t);
+    wheel_link (t);
+  }
+}
+
+
+/**
+ * Advance the timer wheel to the tick corresponding to @a now,
+ * moving all tasks that became due to #wheel_expired.
+ *
+ * @param now the current time
+ */
+static void
+wheel_advance (struct GNUNET_TIME_Absolute now)
+{
+  uint64_t now_tick = now.abs_value_us / WHEEL_GRANULARITY_US;
+  struct WheelSlot *ws;
+  struct GNUNET_SCHEDULER_Task *t;
+  unsigned int level;
+
+  if (0 == wheel_now)
+    wheel_now = now_tick;
+  while (wheel_now < now_tick)
+  {
+    wheel_now++;
+    for (level = 1; level < WHEEL_LEVELS; level++)
+    {
+      if (0 != (wheel_now & ((1LLU << (WHEEL_BITS * level)) - 1)))
+        break;
+      wheel_cascade (level);
+    }
+    ws = &wheel[wheel_now & (WHEEL_SLOTS - 1)];
+    while (NULL != (t = ws->head))
+    {
+      wheel_unlink (t);
+      t->reason |= GNUNET_SCHEDULER_REASON_TIMEOUT;
+      t->wheel_slot = &wheel_expired;
+      GNUNET_CONTAINER_DLL_insert_tail (wheel_expired.head,
+                                        wheel_expired.tail,
+                                        t);
+    }
+  }
+}
+
+
+/**
+ * Determine the tick at which the next timeout task becomes due.
+ * For tasks parked in the higher levels of the wheel this is the
+ * (conservative) start of their slot's window, so the scheduler may
+ * wake up early and go back to sleep, but never oversleeps.  The
+ * scan may skip each level's current slot: wheel_link() guarantees
+ * it is empty.
+ *
+ * @return tick of the next deadline, UINT64_MAX if the wheel is empty
+ */
+static uint64_t
+wheel_next_deadline ()
+{
+  uint64_t best = UINT64_MAX;
+  uint64_t base;
+  uint64_t tick;
+  unsigned int level;
+  unsigned int i;
+  unsigned int slot;
+
+  if (NULL != wheel_expired.head)
+    return 0;
+  for (level = 0; level < WHEEL_LEVELS; level++)
+  {
+    base = wheel_now >> (WHEEL_BITS * level);
+    for (i = 1; i < WHEEL_SLOTS; i++)
+    {
+      slot = level * WHEEL_SLOTS
+        + (unsigned int) ((base + i) & (WHEEL_SLOTS - 1));
+      if (0 == (wheel_occupancy[slot / 64] & (1LLU << (slot % 64))))
+        continue;
+      tick = (base + i) << (WHEEL_BITS * level);
+      if (tick < best)
+        best = tick;
+      break;
+    }
+  }
+  return best;
+}
+
+
 /**
  * Update all sets and timeout for select.
  *
@@ -307,17 +1053,21 @@ update_sets (struct GNUNET_NETWORK_FDSet *rs,
 {
   struct GNUNET_SCHEDULER_Task *pos;
   struct GNUNET_TIME_Absolute now;
+  struct GNUNET_TIME_Absolute deadline;
   struct GNUNET_TIME_Relative to;
+  uint64_t tick;
 
-  now = GNUNET_TIME_absolute_get ();
-  pos = pending_timeout_head;
-  if (NULL != pos)
+  now = GNUNET_TIME_absolute_update_cached_ ();
+  if (NULL != wheel_expired.head)
+  {
+    *timeout = GNUNET_TIME_UNIT_ZERO;
+  }
+  else if (UINT64_MAX != (tick = wheel_next_deadline ()))
   {
-    to = GNUNET_TIME_absolute_get_difference (now, pos->timeout);
+    deadline.abs_value_us = tick * WHEEL_GRANULARITY_US;
+    to = GNUNET_TIME_absolute_get_difference (now, deadline);
     if (timeout->rel_value_us > to.rel_value_us)
       *timeout = to;
-    if (0 != pos->reason)
-      *timeout = GNUNET_TIME_UNIT_ZERO;
   }
   for (pos = pending_head; NULL != pos; pos = pos->next)
   {
@@ -423,6 +1173,7 @@ queue_ready_task (struct GNUNET_SCHEDULER_Task *task)
                                task);
   task->in_ready_list = GNUNET_YES;
   ready_count++;
+  ready_counts[p]++;
 }
 
 
@@ -441,18 +1192,13 @@ check_ready (const struct GNUNET_NETWORK_FDSet *rs,
   struct GNUNET_SCHEDULER_Task *next;
   struct GNUNET_TIME_Absolute now;
 
-  now = GNUNET_TIME_absolute_get ();
-  while (NULL != (pos = pending_timeout_head))
+  now = GNUNET_TIME_absolute_update_cached_ ();
+  wheel_advance (now);
+  while (NULL != (pos = wheel_expired.head))
   {
+    wheel_delete (pos);
     if (now.abs_value_us >= pos->timeout.abs_value_us)
       pos->reason |= GNUNET_SCHEDULER_REASON_TIMEOUT;
-    if (0 == pos->reason)
-      break;
-    GNUNET_CONTAINER_DLL_remove (pending_timeout_head,
-                                 pending_timeout_tail,
-                                 pos);
-    if (pending_timeout_last == pos)
-      pending_timeout_last = NULL;
     queue_ready_task (pos);
   }
   pos = pending_head;
@@ -486,9 +1232,21 @@ void
 GNUNET_SCHEDULER_shutdown ()
 {
   struct GNUNET_SCHEDULER_Task *pos;
+  unsigned int slot;
   int i;
 
-  for (pos = pending_timeout_head; NULL != pos; pos = pos->next)
+  for (slot = 0; slot < WHEEL_LEVELS * WHEEL_SLOTS; slot++)
+  {
+    while (NULL != (pos = wheel[slot].head))
+    {
+      wheel_unlink (pos);
+      pos->wheel_slot = &wheel_expired;
+      GNUNET_CONTAINER_DLL_insert_tail (wheel_expired.head,
+                                        wheel_expired.tail,
+                                        pos);
+    }
+  }
+  for (pos = wheel_expired.head; NULL != pos; pos = pos->next)
     pos->reason |= GNUNET_SCHEDULER_REASON_SHUTDOWN;
   for (pos = pending_head; NULL != pos; pos = pos->next)
     pos->reason |= GNUNET_SCHEDULER_REASON_SHUTDOWN;
@@ -513,6 +1271,13 @@ destroy_task (struct GNUNET_SCHEDULER_Task *t)
 #if EXECINFO
   GNUNET_free (t->backtrace_strings);
 #endif
+  if (task_pool_size < TASK_POOL_MAX)
+  {
+    t->next = task_pool_head;
+    task_pool_head = t;
+    task_pool_size++;
+    return;
+  }
   GNUNET_free (t);
 }
 
@@ -554,6 +1319,7 @@ run_ready (struct GNUNET_NETWORK_FDSet *rs,
                                  ready_tail[p],
                                  pos);
     ready_count--;
+    ready_counts[p]--;
     current_priority = pos->priority;
     current_lifeness = pos->lifeness;
     active_task = pos;
@@ -677,13 +1443,12 @@ check_lifeness ()
 
   if (ready_count > 0)
     return GNUNET_OK;
+  if (timeout_lifeness_count > 0)
+    return GNUNET_OK;
   for (t = pending_head; NULL != t; t = t->next)
     if (t->lifeness == GNUNET_YES)
       return GNUNET_OK;
-  for (t = pending_timeout_head; NULL != t; t = t->next)
-    if (t->lifeness == GNUNET_YES)
-      return GNUNET_OK;
-  if ((NULL != pending_head) || (NULL != pending_timeout_head))
+  if ((NULL != pending_head) || (0 < timeout_task_count))
   {
     GNUNET_SCHEDULER_shutdown ();
     return GNUNET_OK;
@@ -754,6 +1519,15 @@ GNUNET_SCHEDULER_run (GNUNET_SCHEDULER_TaskCallback task,
   shc_pipe = GNUNET_SIGNAL_handler_install (SIGPIPE, &sighandler_pipe);
   shc_quit = GNUNET_SIGNAL_handler_install (SIGQUIT, &sighandler_shutdown);
   shc_hup = GNUNET_SIGNAL_handler_install (SIGHUP, &sighandler_shutdown);
+#endif
+#if HAVE_EVENT_BACKEND
+  if ( (NULL == scheduler_select) &&
+       (NULL == getenv ("GNUNET_SCHEDULER_FORCE_SELECT")) &&
+       (GNUNET_OK == backend_init ()) )
+  {
+    scheduler_select = &backend_select;
+    backend_active = GNUNET_YES;
+  }
 #endif
   current_priority = GNUNET_SCHEDULER_PRIORITY_DEFAULT;
   current_lifeness = GNUNET_YES;
@@ -896,6 +1670,14 @@ GNUNET_SCHEDULER_run (GNUNET_SCHEDULER_TaskCallback task,
 #endif
   GNUNET_DISK_pipe_close (shutdown_pipe_handle);
   shutdown_pipe_handle = NULL;
+#if HAVE_EVENT_BACKEND
+  if (GNUNET_YES == backend_active)
+  {
+    scheduler_select = NULL;
+    backend_active = GNUNET_NO;
+    backend_done ();
+  }
+#endif
   GNUNET_NETWORK_fdset_destroy (rs);
   GNUNET_NETWORK_fdset_destroy (ws);
 }
@@ -928,18 +1710,12 @@ GNUNET_SCHEDULER_get_reason ()
 unsigned int
 GNUNET_SCHEDULER_get_load (enum GNUNET_SCHEDULER_Priority p)
 {
-  struct GNUNET_SCHEDULER_Task *pos;
-  unsigned int ret;
-
   GNUNET_assert (NULL != active_task);
   if (p == GNUNET_SCHEDULER_PRIORITY_COUNT)
     return ready_count;
   if (p == GNUNET_SCHEDULER_PRIORITY_KEEP)
     p = current_priority;
-  ret = 0;
-  for (pos = ready_head[check_priority (p)]; NULL != pos; pos = pos->next)
-    ret++;
-  return ret;
+  return ready_counts[check_priority (p)];
 }
 
 
@@ -959,16 +1735,9 @@ GNUNET_SCHEDULER_cancel (struct GNUNET_SCHEDULER_Task *task)
   GNUNET_assert (NULL != active_task);
   if (! task->in_ready_list)
   {
-    if ( (-1 == task->read_fd) &&
-         (-1 == task->write_fd) &&
-         (NULL == task->read_set) &&
-         (NULL == task->write_set) )
+    if (NULL != task->wheel_slot)
     {
-      GNUNET_CONTAINER_DLL_remove (pending_timeout_head,
-                                   pending_timeout_tail,
-                                   task);
-      if (task == pending_timeout_last)
-        pending_timeout_last = NULL;
+      wheel_delete (task);
     }
     else
     {
@@ -984,6 +1753,7 @@ GNUNET_SCHEDULER_cancel (struct GNUNET_SCHEDULER_Task *task)
                                  ready_tail[p],
                                  task);
     ready_count--;
+    ready_counts[p]--;
   }
   ret = task->callback_cls;
   LOG (GNUNET_ERROR_TYPE_DEBUG,
@@ -1019,7 +1789,7 @@ GNUNET_SCHEDULER_add_with_reason_and_priority (GNUNET_SCHEDULER_TaskCallback tas
   GNUNET_assert (NULL != task);
   GNUNET_assert ((NULL != active_task) ||
                  (GNUNET_SCHEDULER_REASON_STARTUP == reason));
-  t = GNUNET_new (struct GNUNET_SCHEDULER_Task);
+  t = alloc_task ();
 #if EXECINFO
   t->num_backtrace_strings = backtrace (backtrace_array, 50);
   t->backtrace_strings =
@@ -1030,7 +1800,7 @@ GNUNET_SCHEDULER_add_with_reason_and_priority (GNUNET_SCHEDULER_TaskCallback tas
   t->callback = task;
   t->callback_cls = task_cls;
 #if PROFILE_DELAYS
-  t->start_time = GNUNET_TIME_absolute_get ();
+  t->start_time = GNUNET_TIME_absolute_get_cached_ ();
 #endif
   t->reason = reason;
   t->priority = priority;
@@ -1061,8 +1831,6 @@ GNUNET_SCHEDULER_add_delayed_with_priority (struct GNUNET_TIME_Relative delay,
                                             void *task_cls)
 {
   struct GNUNET_SCHEDULER_Task *t;
-  struct GNUNET_SCHEDULER_Task *pos;
-  struct GNUNET_SCHEDULER_Task *prev;
 
 #if EXECINFO
   void *backtrace_array[MAX_TRACE_DEPTH];
@@ -1070,7 +1838,7 @@ GNUNET_SCHEDULER_add_delayed_with_priority (struct GNUNET_TIME_Relative delay,
 
   GNUNET_assert (NULL != active_task);
   GNUNET_assert (NULL != task);
-  t = GNUNET_new (struct GNUNET_SCHEDULER_Task);
+  t = alloc_task ();
   t->callback = task;
   t->callback_cls = task_cls;
 #if EXECINFO
@@ -1081,44 +1849,25 @@ GNUNET_SCHEDULER_add_delayed_with_priority (struct GNUNET_TIME_Relative delay,
   t->read_fd = -1;
   t->write_fd = -1;
 #if PROFILE_DELAYS
-  t->start_time = GNUNET_TIME_absolute_get ();
+  t->start_time = GNUNET_TIME_absolute_get_cached_ ();
 #endif
-  t->timeout = GNUNET_TIME_relative_to_absolute (delay);
+  t->timeout = GNUNET_TIME_relative_to_absolute_cached_ (delay);
   t->priority = priority;
   t->lifeness = current_lifeness;
-  /* try tail first (optimization in case we are
-   * appending to a long list of tasks with timeouts) */
   if (0 == delay.rel_value_us)
   {
-    GNUNET_CONTAINER_DLL_insert (pending_timeout_head,
-                                 pending_timeout_tail,
-                                 t);
+    /* bypass the wheel, the task is due right away */
+    t->wheel_slot = &wheel_expired;
+    GNUNET_CONTAINER_DLL_insert_tail (wheel_expired.head,
+                                      wheel_expired.tail,
+                                      t);
+    timeout_task_count++;
+    if (GNUNET_YES == t->lifeness)
+      timeout_lifeness_count++;
   }
   else
   {
-    /* first move from heuristic start backwards to before start time */
-    prev = pending_timeout_last;
-    while ( (NULL != prev) &&
-            (prev->timeout.abs_value_us > t->timeout.abs_value_us) )
-      prev = prev->prev;
-    /* now, move from heuristic start (or head of list) forward to insertion point */
-    if (NULL == prev)
-      pos = pending_timeout_head;
-    else
-      pos = prev->next;
-    while ( (NULL != pos) &&
-            ( (pos->timeout.abs_value_us <= t->timeout.abs_value_us) ||
-              (0 != pos->reason) ) )
-    {
-      prev = pos;
-      pos = pos->next;
-    }
-    GNUNET_CONTAINER_DLL_insert_after (pending_timeout_head,
-                                       pending_timeout_tail,
-                                       prev,
-                                       t);
-    /* finally, update heuristic insertion point to last insertion... */
-    pending_timeout_last = t;
+    wheel_insert (t);
   }
 
   LOG (GNUNET_ERROR_TYPE_DEBUG,
@@ -1225,6 +1974,14 @@ GNUNET_SCHEDULER_add_now_with_lifeness (int lifeness,
   struct GNUNET_SCHEDULER_Task *ret;
 
   ret = GNUNET_SCHEDULER_add_now (task, task_cls);
+  if ( (NULL != ret->wheel_slot) &&
+       (lifeness != ret->lifeness) )
+  {
+    if (GNUNET_YES == lifeness)
+      timeout_lifeness_count++;
+    else
+      timeout_lifeness_count--;
+  }
   ret->lifeness = lifeness;
   return ret;
 }
@@ -1274,7 +2031,7 @@ add_without_sets (struct GNUNET_TIME_Relative delay,
 
   GNUNET_assert (NULL != active_task);
   GNUNET_assert (NULL != task);
-  t = GNUNET_new (struct GNUNET_SCHEDULER_Task);
+  t = alloc_task ();
   t->callback = task;
   t->callback_cls = task_cls;
 #if EXECINFO
@@ -1328,9 +2085,9 @@ add_without_sets (struct GNUNET_TIME_Relative delay,
   GNUNET_assert (wfd >= -1);
   t->write_fd = wfd;
 #if PROFILE_DELAYS
-  t->start_time = GNUNET_TIME_absolute_get ();
+  t->start_time = GNUNET_TIME_absolute_get_cached_ ();
 #endif
-  t->timeout = GNUNET_TIME_relative_to_absolute (delay);
+  t->timeout = GNUNET_TIME_relative_to_absolute_cached_ (delay);
   t->priority = check_priority ((priority == GNUNET_SCHEDULER_PRIORITY_KEEP) ? current_priority : priority);
   t->lifeness = current_lifeness;
   GNUNET_CONTAINER_DLL_insert (pending_head,
@@ -1650,7 +2407,7 @@ GNUNET_SCHEDULER_add_select (enum GNUNET_SCHEDULER_Priority prio,
                                                        task_cls);
   GNUNET_assert (NULL != active_task);
   GNUNET_assert (NULL != task);
-  t = GNUNET_new (struct GNUNET_SCHEDULER_Task);
+  t = alloc_task ();
   t->callback = task;
   t->callback_cls = task_cls;
 #if EXECINFO
@@ -1671,9 +2428,9 @@ GNUNET_SCHEDULER_add_select (enum GNUNET_SCHEDULER_Priority prio,
     GNUNET_NETWORK_fdset_copy (t->write_set, ws);
   }
 #if PROFILE_DELAYS
-  t->start_time = GNUNET_TIME_absolute_get ();
+  t->start_time = GNUNET_TIME_absolute_get_cached_ ();
 #endif
-  t->timeout = GNUNET_TIME_relative_to_absolute (delay);
+  t->timeout = GNUNET_TIME_relative_to_absolute_cached_ (delay);
   t->priority =
       check_priority ((prio ==
                        GNUNET_SCHEDULER_PRIORITY_KEEP) ? current_priority :
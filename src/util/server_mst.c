@@ -137,7 +137,6 @@ GNUNET_SERVER_mst_receive (struct GNUNET_SERVER_MessageStreamTokenizer *mst,
   ibuf = (char *) mst->hdr;
   while (mst->pos > 0)
   {
-do_align:
     GNUNET_assert (mst->pos >= mst->off);
     if ((mst->curr_buf - mst->off < sizeof (struct GNUNET_MessageHeader)) ||
         (0 != (mst->off % ALIGN_FACTOR)))
@@ -266,9 +265,41 @@ do_align:
     }
     else
     {
-      /* need to copy to private buffer to align;
-       * yes, we go a bit more spagetti than usual here */
-      goto do_align;
+      /* misaligned message: bounce just this message through the
+       * (aligned) private buffer, then resume in-place delivery
+       * for whatever follows it */
+      struct GNUNET_MessageHeader mhdr;
+
+      memcpy (&mhdr, buf, sizeof (struct GNUNET_MessageHeader));
+      want = ntohs (mhdr.size);
+      if (want < sizeof (struct GNUNET_MessageHeader))
+      {
+        GNUNET_break_op (0);
+        mst->off = 0;
+        return GNUNET_SYSERR;
+      }
+      if (size < want)
+        break;                  /* buffer incomplete, so copy to private buffer... */
+      if (one_shot == GNUNET_SYSERR)
+      {
+        /* cannot call callback again, but return value saying that
+         * we have another full message in the buffer */
+        ret = GNUNET_NO;
+        goto copy;
+      }
+      if (one_shot == GNUNET_YES)
+        one_shot = GNUNET_SYSERR;
+      if (mst->curr_buf < want)
+      {
+        mst->hdr = GNUNET_realloc (mst->hdr, want);
+        ibuf = (char *) mst->hdr;
+        mst->curr_buf = want;
+      }
+      memcpy (ibuf, buf, want);
+      if (GNUNET_SYSERR == mst->cb (mst->cb_cls, client_identity, mst->hdr))
+        return GNUNET_SYSERR;
+      buf += want;
+      size -= want;
     }
   }
 copy:
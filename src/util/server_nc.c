@@ -31,6 +31,25 @@
 #define LOG(kind,...) GNUNET_log_from (kind, "util-server-nc", __VA_ARGS__)
 
 
+/**
+ * Reference-counted message buffer.  A broadcast allocates the
+ * message once and all subscribed clients share the same buffer;
+ * it is freed once the last client has transmitted (or dropped)
+ * the message.
+ */
+struct SharedMessage
+{
+
+  /**
+   * Number of `struct PendingMessageList` entries referring
+   * to this message.
+   */
+  unsigned int ref_count;
+
+  /* followed by the actual message */
+};
+
+
 /**
  * Entry in list of messages pending to be transmitted.
  */
@@ -48,8 +67,13 @@ struct PendingMessageList
   struct PendingMessageList *prev;
 
   /**
-   * Message to transmit (allocated at the end of this
-   * struct, do not free)
+   * Shared buffer holding the message (one reference counted
+   * for this entry).
+   */
+  struct SharedMessage *sm;
+
+  /**
+   * Message to transmit (points into @e sm, do not free)
    */
   const struct GNUNET_MessageHeader *msg;
 
@@ -144,6 +168,43 @@ struct GNUNET_SERVER_NotificationContext
 };
 
 
+/**
+ * Allocate a shared message buffer holding a copy of @a msg.
+ * The caller holds the initial reference.
+ *
+ * @param msg message to copy
+ * @return shared buffer with reference count one
+ */
+static struct SharedMessage *
+shared_msg_create (const struct GNUNET_MessageHeader *msg)
+{
+  struct SharedMessage *sm;
+  uint16_t size;
+
+  size = ntohs (msg->size);
+  sm = GNUNET_malloc (sizeof (struct SharedMessage) + size);
+  sm->ref_count = 1;
+  memcpy (&sm[1], msg, size);
+  return sm;
+}
+
+
+/**
+ * Release one reference to a shared message buffer,
+ * freeing it if this was the last one.
+ *
+ * @param sm shared buffer to release
+ */
+static void
+shared_msg_unref (struct SharedMessage *sm)
+{
+  GNUNET_assert (0 < sm->ref_count);
+  sm->ref_count--;
+  if (0 == sm->ref_count)
+    GNUNET_free (sm);
+}
+
+
 /**
  * Client has disconnected, clean up.
  *
@@ -179,6 +240,7 @@ handle_client_disconnect (void *cls,
     GNUNET_CONTAINER_DLL_remove (pos->pending_head,
                                  pos->pending_tail,
                                  pml);
+    shared_msg_unref (pml->sm);
     GNUNET_free (pml);
     pos->num_pending--;
   }
@@ -245,6 +307,7 @@ GNUNET_SERVER_notification_context_destroy (struct GNUNET_SERVER_NotificationCon
       GNUNET_CONTAINER_DLL_remove (pos->pending_head,
                                    pos->pending_tail,
                                    pml);
+      shared_msg_unref (pml->sm);
       GNUNET_free (pml);
       pos->num_pending--;
     }
@@ -329,6 +392,7 @@ transmit_message (void *cls,
     memcpy (&cbuf[ret], pml->msg, msize);
     ret += msize;
     size -= msize;
+    shared_msg_unref (pml->sm);
     GNUNET_free (pml);
     cl->num_pending--;
   }
@@ -356,42 +420,63 @@ transmit_message (void *cls,
  *
  * @param nc context to modify
  * @param client client to transmit to
- * @param msg message to send
+ * @param sm shared buffer with the message to send
  * @param can_drop can this message be dropped due to queue length limitations
  */
 static void
 do_unicast (struct GNUNET_SERVER_NotificationContext *nc,
             struct ClientList *client,
-            const struct GNUNET_MessageHeader *msg,
+            struct SharedMessage *sm,
             int can_drop)
 {
   struct PendingMessageList *pml;
-  uint16_t size;
+  const struct GNUNET_MessageHeader *msg;
 
-  if ( (client->num_pending > nc->queue_length) &&
-       (GNUNET_YES == can_drop) )
-  {
-    LOG (GNUNET_ERROR_TYPE_INFO,
-         "Dropping message of type %u and size %u due to full queue (%u entries)\n",
-         ntohs (msg->type), ntohs (msg->size), (unsigned int) nc->queue_length);
-    return;                     /* drop! */
-  }
+  msg = (const struct GNUNET_MessageHeader *) &sm[1];
   if (client->num_pending > nc->queue_length)
   {
-    /* FIXME: consider checking for other messages in the
-     * queue that are 'droppable' */
+    /* drop the oldest droppable message so that the most recent
+     * data is what survives the overflow; skip the head of the
+     * queue if its transmission may already be in progress */
+    pml = client->pending_head;
+    if ( (NULL != client->th) &&
+         (NULL != pml) )
+      pml = pml->next;
+    while ( (NULL != pml) &&
+            (GNUNET_YES != pml->can_drop) )
+      pml = pml->next;
+    if (NULL != pml)
+    {
+      LOG (GNUNET_ERROR_TYPE_INFO,
+           "Dropping oldest message of type %u due to full queue (%u entries)\n",
+           ntohs (pml->msg->type), (unsigned int) nc->queue_length);
+      GNUNET_CONTAINER_DLL_remove (client->pending_head,
+                                   client->pending_tail,
+                                   pml);
+      shared_msg_unref (pml->sm);
+      GNUNET_free (pml);
+      client->num_pending--;
+    }
+    else if (GNUNET_YES == can_drop)
+    {
+      LOG (GNUNET_ERROR_TYPE_INFO,
+           "Dropping message of type %u and size %u due to full queue (%u entries)\n",
+           ntohs (msg->type), ntohs (msg->size),
+           (unsigned int) nc->queue_length);
+      return;                   /* drop! */
+    }
   }
   client->num_pending++;
-  size = ntohs (msg->size);
-  pml = GNUNET_malloc (sizeof (struct PendingMessageList) + size);
-  pml->msg = (const struct GNUNET_MessageHeader *) &pml[1];
+  pml = GNUNET_new (struct PendingMessageList);
+  pml->sm = sm;
+  sm->ref_count++;
+  pml->msg = msg;
   pml->can_drop = can_drop;
   LOG (GNUNET_ERROR_TYPE_DEBUG,
        "Adding message of type %u and size %u to pending queue (which has %u entries)\n",
        ntohs (msg->type),
        ntohs (msg->size),
        (unsigned int) nc->queue_length);
-  memcpy (&pml[1], msg, size);
   /* append */
   GNUNET_CONTAINER_DLL_insert_tail (client->pending_head,
                                     client->pending_tail,
@@ -422,17 +507,23 @@ GNUNET_SERVER_notification_context_unicast (struct GNUNET_SERVER_NotificationCon
                                             int can_drop)
 {
   struct ClientList *pos;
+  struct SharedMessage *sm;
 
   for (pos = nc->clients_head; NULL != pos; pos = pos->next)
     if (pos->client == client)
       break;
   GNUNET_assert (NULL != pos);
-  do_unicast (nc, pos, msg, can_drop);
+  sm = shared_msg_create (msg);
+  do_unicast (nc, pos, sm, can_drop);
+  shared_msg_unref (sm);
 }
 
 
 /**
- * Send a message to all clients of this context.
+ * Send a message to all clients of this context.  The message is
+ * serialized into a single shared buffer that all per-client queue
+ * entries reference, so the cost of a broadcast does not grow with
+ * the size of the message times the number of subscribers.
  *
  * @param nc context to modify
  * @param msg message to send
@@ -445,9 +536,14 @@ GNUNET_SERVER_notification_context_broadcast (struct
                                               int can_drop)
 {
   struct ClientList *pos;
+  struct SharedMessage *sm;
 
+  if (NULL == nc->clients_head)
+    return;
+  sm = shared_msg_create (msg);
   for (pos = nc->clients_head; NULL != pos; pos = pos->next)
-    do_unicast (nc, pos, msg, can_drop);
+    do_unicast (nc, pos, sm, can_drop);
+  shared_msg_unref (sm);
 }
 
 
@@ -57,6 +57,11 @@ struct GNUNET_SERVER_TransmitContext
    */
   size_t total;
 
+  /**
+   * Number of bytes allocated for buf.
+   */
+  size_t alloc;
+
   /**
    * Offset for writing in buf.
    */
@@ -69,6 +74,31 @@ struct GNUNET_SERVER_TransmitContext
 };
 
 
+/**
+ * Grow the transmission buffer of @a tc so that it has room for at
+ * least @a size additional bytes.  The buffer is grown geometrically
+ * to avoid quadratic copying when many messages are appended, as is
+ * common when dumping large data sets to a client.
+ *
+ * @param tc context whose buffer to grow
+ * @param size number of additional bytes needed
+ */
+static void
+ensure_space (struct GNUNET_SERVER_TransmitContext *tc,
+              size_t size)
+{
+  size_t need;
+
+  need = tc->total + size;
+  if (need <= tc->alloc)
+    return;
+  if (need < 2 * tc->alloc)
+    need = 2 * tc->alloc;
+  tc->buf = GNUNET_realloc (tc->buf, need);
+  tc->alloc = need;
+}
+
+
 /**
  * Helper function for incremental transmission of the response.
  */
@@ -155,7 +185,7 @@ GNUNET_SERVER_transmit_context_append_data (struct GNUNET_SERVER_TransmitContext
   GNUNET_assert (length < GNUNET_SERVER_MAX_MESSAGE_SIZE);
   size = length + sizeof (struct GNUNET_MessageHeader);
   GNUNET_assert (size > length);
-  tc->buf = GNUNET_realloc (tc->buf, tc->total + size);
+  ensure_space (tc, size);
   msg = (struct GNUNET_MessageHeader *) &tc->buf[tc->total];
   tc->total += size;
   msg->size = htons (size);
@@ -183,7 +213,7 @@ GNUNET_SERVER_transmit_context_append_message (struct
   uint16_t size;
 
   size = ntohs (msg->size);
-  tc->buf = GNUNET_realloc (tc->buf, tc->total + size);
+  ensure_space (tc, size);
   m = (struct GNUNET_MessageHeader *) &tc->buf[tc->total];
   tc->total += size;
   memcpy (m, msg, size);
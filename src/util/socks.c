@@ -148,6 +148,19 @@ struct GNUNET_SOCKS_Handshake
    */
   unsigned char * instart;
   unsigned char * inend;
+
+  /**
+   * GNUNET_YES if only NOAUTH is offered, so the server's method
+   * choice is known in advance and the connect request can be sent
+   * speculatively together with the greeting.
+   */
+  int pipeline;
+
+  /**
+   * GNUNET_YES if the connect request was already sent pipelined
+   * with the greeting, so it must not be sent again.
+   */
+  int cmd_sent;
 };
 
 
@@ -177,6 +190,8 @@ void
 SOCKS5_handshake_done(struct GNUNET_SOCKS_Handshake *ih)
 {
   GNUNET_CONNECTION_acivate_proxied (ih->target_connection);
+  /* nothing references the handshake state anymore */
+  GNUNET_free (ih);
 }
 
 
@@ -210,6 +225,14 @@ SOCKS5_handshake_step (struct GNUNET_SOCKS_Handshake *ih)
           ih->step=SOCKS5_step_cmd;  /* no authentication to do */
           break;
         case SOCKS5_AUTH_USERPASS:
+          if (GNUNET_YES == ih->cmd_sent)
+          {
+            /* server picked a method we did not offer and would
+             * misread the pipelined connect request */
+            LOG (GNUNET_ERROR_TYPE_ERROR,
+                 "SOCKS5 server demands authentication we did not offer\n");
+            return;
+          }
           ih->step=SOCKS5_step_auth;
           break;
         case SOCKS5_AUTH_REJECT:
@@ -275,7 +298,15 @@ SOCKS5_handshake_step (struct GNUNET_SOCKS_Handshake *ih)
       GNUNET_assert (0);
   }
   ih->instart = b;
-  /* Do not reschedule the sender unless we're done reading. 
+  if ( (GNUNET_YES == ih->cmd_sent) &&
+       (SOCKS5_step_cmd == ih->step) )
+  {
+    /* the connect request went out pipelined with the greeting;
+     * nothing more to send, just process the server's reply */
+    SOCKS5_handshake_step (ih);
+    return;
+  }
+  /* Do not reschedule the sender unless we're done reading.
    * I imagine this lets us avoid ever cancelling the transmit handle. */
   register_sender (ih);
 }
@@ -382,6 +413,19 @@ transmit_ready (void *cls,
   unsigned l = e - b;
   GNUNET_assert (size >= l && l >= 0);
   memcpy(buf, b, l);
+  if ( (GNUNET_YES == ih->pipeline) &&
+       (SOCKS5_step_greet == ih->step) )
+  {
+    /* speculatively append the connect request, skipping the
+     * authentication segment in between; the server's method
+     * choice is known since we only offered NOAUTH */
+    unsigned char * b2 = ih->outstep[SOCKS5_step_cmd];
+    unsigned char * e2 = ih->outstep[SOCKS5_step_done];
+    GNUNET_assert (size >= l + (e2 - b2));
+    memcpy(&((char *)buf)[l], b2, e2 - b2);
+    l += e2 - b2;
+    ih->cmd_sent = GNUNET_YES;
+  }
   register_reciever (ih, register_reciever_wants(ih));
   return l;
 }
@@ -405,9 +449,14 @@ register_sender (struct GNUNET_SOCKS_Handshake *ih)
     timeout = GNUNET_TIME_relative_multiply (GNUNET_TIME_UNIT_MINUTES, 3);
   unsigned char * b = ih->outstep[ih->step];
   unsigned char * e = ih->outstep[ih->step+1];
+  size_t l = e - b;
   GNUNET_assert (ih->outbuf <= b && b < e && e < &ih->outbuf[1024]);
+  if ( (GNUNET_YES == ih->pipeline) &&
+       (SOCKS5_step_greet == ih->step) )
+    /* greeting and connect request go out in a single write */
+    l += ih->outstep[SOCKS5_step_done] - ih->outstep[SOCKS5_step_cmd];
   ih->th = GNUNET_CONNECTION_notify_transmit_ready (ih->socks5_connection,
-                                                    e - b,
+                                                    l,
                                                     timeout,
                                                     &transmit_ready,
                                                     ih);
@@ -442,6 +491,10 @@ GNUNET_SOCKS_init_handshake (const char *user, const char *pass)
     *(b++) = SOCKS5_AUTH_USERPASS;
     (*n)++;
   }
+  /* With only NOAUTH offered, the server's method choice is known
+   * in advance, so the connect request can be pipelined with the
+   * greeting, saving a round trip through the proxy. */
+  ih->pipeline = (NULL == user) ? GNUNET_YES : GNUNET_NO;
   /* There is no apperent reason to support authentication methods beyond
    * username and password since afaik Tor does not support them. */
 
@@ -206,25 +206,36 @@ convert_with_table (const char *input,
 		    unsigned long long *output)
 {
   unsigned long long ret;
-  char *in;
   const char *tok;
+  size_t tlen;
   unsigned long long last;
   unsigned int i;
 
   ret = 0;
   last = 0;
-  in = GNUNET_strdup (input);
-  for (tok = strtok (in, " "); tok != NULL; tok = strtok (NULL, " "))
+  tok = input;
+  while (1)
   {
-    do
+    while (' ' == *tok)
+      tok++;
+    if ('\0' == *tok)
+      break;
+    /* the token runs up to the next space (or the end) */
+    tlen = 0;
+    while (('\0' != tok[tlen]) && (' ' != tok[tlen]))
+      tlen++;
+    while (tlen > 0)
     {
       i = 0;
-      while ((table[i].name != NULL) && (0 != strcasecmp (table[i].name, tok)))
+      while ((table[i].name != NULL) &&
+	     ((strlen (table[i].name) != tlen) ||
+	      (0 != strncasecmp (table[i].name, tok, tlen))))
         i++;
       if (table[i].name != NULL)
       {
         last *= table[i].value;
-        break; /* next tok */
+        tok += tlen;
+        tlen = 0; /* next tok */
       }
       else
       {
@@ -233,20 +244,14 @@ convert_with_table (const char *input,
         errno = 0;
         last = strtoull (tok, &endptr, 10);
         if ((0 != errno) || (endptr == tok))
-        {
-          GNUNET_free (in);
           return GNUNET_SYSERR;   /* expected number */
-        }
-        if ('\0' == endptr[0])
-          break; /* next tok */
-        else
-          tok = endptr; /* and re-check (handles times like "10s") */
+        tlen -= (endptr - tok);
+        tok = endptr; /* and re-check (handles times like "10s") */
       }
-    } while (GNUNET_YES);
+    }
   }
   ret += last;
   *output = ret;
-  GNUNET_free (in);
   return GNUNET_OK;
 }
 
@@ -294,10 +299,37 @@ GNUNET_STRINGS_fancy_size_to_bytes (const char *fancy_size,
  * @param rtime set to the relative time
  * @return #GNUNET_OK on success, #GNUNET_SYSERR on error
  */
+/**
+ * Number of recently parsed time expressions we remember.
+ * Configurations contain only a handful of distinct expressions
+ * ("5 s", "1 h", ...), but they are parsed over and over when
+ * many sections are processed.
+ */
+#define TIME_EXPR_CACHE_SIZE 8
+
+/**
+ * Cache entry mapping a time expression to its parsed value.
+ */
+struct TimeExprCacheEntry
+{
+  /**
+   * The expression (empty string if the slot is unused).
+   */
+  char expr[32];
+
+  /**
+   * Parsed value of @e expr.
+   */
+  struct GNUNET_TIME_Relative value;
+};
+
+
 int
 GNUNET_STRINGS_fancy_time_to_relative (const char *fancy_time,
                                        struct GNUNET_TIME_Relative *rtime)
 {
+  static struct TimeExprCacheEntry cache[TIME_EXPR_CACHE_SIZE];
+  static unsigned int cache_off;
   static const struct ConversionTable table[] =
   {
     { "us", 1},
@@ -321,16 +353,33 @@ GNUNET_STRINGS_fancy_time_to_relative (const char *fancy_time,
   };
   int ret;
   unsigned long long val;
+  unsigned int i;
 
   if (0 == strcasecmp ("forever", fancy_time))
   {
     *rtime = GNUNET_TIME_UNIT_FOREVER_REL;
     return GNUNET_OK;
   }
+  if (strlen (fancy_time) < sizeof (cache[0].expr))
+  {
+    for (i = 0; i < TIME_EXPR_CACHE_SIZE; i++)
+      if (0 == strcmp (cache[i].expr, fancy_time))
+      {
+	*rtime = cache[i].value;
+	return GNUNET_OK;
+      }
+  }
   ret = convert_with_table (fancy_time,
 			    table,
 			    &val);
   rtime->rel_value_us = (uint64_t) val;
+  if ((GNUNET_OK == ret) &&
+      (strlen (fancy_time) < sizeof (cache[0].expr)))
+  {
+    strcpy (cache[cache_off].expr, fancy_time);
+    cache[cache_off].value = *rtime;
+    cache_off = (cache_off + 1) % TIME_EXPR_CACHE_SIZE;
+  }
   return ret;
 }
 
@@ -1198,6 +1247,35 @@ GNUNET_STRINGS_check_filename (const char *filename,
 }
 
 
+/**
+ * Parse an unsigned decimal number at the start of the given string.
+ *
+ * @param s string to parse
+ * @param val set to the parsed number
+ * @return pointer to the first character after the number,
+ *         NULL if @a s does not start with a digit (or on overflow)
+ */
+static const char *
+parse_decimal (const char *s,
+	       unsigned int *val)
+{
+  unsigned int v;
+
+  if (('0' > *s) || ('9' < *s))
+    return NULL;
+  v = 0;
+  while (('0' <= *s) && ('9' >= *s))
+  {
+    if (v > ((UINT_MAX - 9) / 10))
+      return NULL;              /* overflow */
+    v = v * 10 + (unsigned int) (*s - '0');
+    s++;
+  }
+  *val = v;
+  return s;
+}
+
+
 /**
  * Tries to convert 'zt_addr' string to an IPv6 address.
  * The string is expected to have the format "[ABCD::01]:80".
@@ -1243,8 +1321,8 @@ GNUNET_STRINGS_to_address_ipv6 (const char *zt_addr,
 		_("IPv6 address did contain ']' before ':' to separate port number\n"));
     return GNUNET_SYSERR;
   }
-  ret = SSCANF (port_colon, ":%u", &port);
-  if ( (1 != ret) || (port > 65535) )
+  if ( (NULL == parse_decimal (port_colon + 1, &port)) ||
+       (port > 65535) )
   {
     GNUNET_log (GNUNET_ERROR_TYPE_WARNING,
 		_("IPv6 address did contain a valid port number after the last ':'\n"));
@@ -1288,15 +1366,24 @@ GNUNET_STRINGS_to_address_ipv4 (const char *zt_addr, uint16_t addrlen,
   unsigned int temps[4];
   unsigned int port;
   unsigned int cnt;
+  const char *pos;
 
   if (addrlen < 9)
     return GNUNET_SYSERR;
-  cnt = SSCANF (zt_addr, "%u.%u.%u.%u:%u", &temps[0], &temps[1], &temps[2], &temps[3], &port);
-  if (5 != cnt)
-    return GNUNET_SYSERR;
+  pos = zt_addr;
   for (cnt = 0; cnt < 4; cnt++)
+  {
+    if (NULL == (pos = parse_decimal (pos, &temps[cnt])))
+      return GNUNET_SYSERR;
     if (temps[cnt] > 0xFF)
       return GNUNET_SYSERR;
+    if ((cnt < 3) && ('.' != *pos++))
+      return GNUNET_SYSERR;
+  }
+  if (':' != *pos++)
+    return GNUNET_SYSERR;
+  if (NULL == parse_decimal (pos, &port))
+    return GNUNET_SYSERR;
   if (port > 65535)
     return GNUNET_SYSERR;
   r_buf->sin_family = AF_INET;
@@ -34,6 +34,14 @@
  */
 static long long timestamp_offset;
 
+/**
+ * Time obtained at the start of the current scheduler iteration;
+ * zero while the cache is cold.  Refreshed by the scheduler via
+ * #GNUNET_TIME_absolute_update_cached_().
+ */
+static struct GNUNET_TIME_Absolute cached_now;
+
+
 /**
  * Set the timestamp offset for this instance.
  *
@@ -43,6 +51,7 @@ void
 GNUNET_TIME_set_offset (long long offset)
 {
   timestamp_offset = offset;
+  cached_now.abs_value_us = 0; /* cache holds the old offset, invalidate */
 }
 
 
@@ -78,6 +87,66 @@ GNUNET_TIME_absolute_get ()
 }
 
 
+/**
+ * Get the current time from the cache filled at the start of the
+ * current scheduler iteration.  Falls back to the precise clock
+ * while the cache is cold, i.e. in processes that do not run the
+ * scheduler loop.  Use #GNUNET_TIME_absolute_get() whenever a
+ * timestamp must reflect time spent in the current task.
+ *
+ * @return the (cached) current time
+ */
+struct GNUNET_TIME_Absolute
+GNUNET_TIME_absolute_get_cached_ ()
+{
+  if (0 == cached_now.abs_value_us)
+    return GNUNET_TIME_absolute_get ();
+  return cached_now;
+}
+
+
+/**
+ * Refresh the time cache from the precise clock.  Called by the
+ * scheduler once per loop iteration; everyone else should use
+ * #GNUNET_TIME_absolute_get_cached_() or #GNUNET_TIME_absolute_get().
+ *
+ * @return the (fresh) current time
+ */
+struct GNUNET_TIME_Absolute
+GNUNET_TIME_absolute_update_cached_ ()
+{
+  cached_now = GNUNET_TIME_absolute_get ();
+  return cached_now;
+}
+
+
+/**
+ * Convert relative time to an absolute time in the future, based on
+ * the time cache filled at the start of the current scheduler
+ * iteration.
+ *
+ * @param rel relative time to convert
+ * @return timestamp that is "rel" in the future, or FOREVER if rel==FOREVER (or if we would overflow)
+ */
+struct GNUNET_TIME_Absolute
+GNUNET_TIME_relative_to_absolute_cached_ (struct GNUNET_TIME_Relative rel)
+{
+  struct GNUNET_TIME_Absolute ret;
+  struct GNUNET_TIME_Absolute now;
+
+  if (rel.rel_value_us == UINT64_MAX)
+    return GNUNET_TIME_UNIT_FOREVER_ABS;
+  now = GNUNET_TIME_absolute_get_cached_ ();
+  if (rel.rel_value_us + now.abs_value_us < rel.rel_value_us)
+  {
+    GNUNET_break (0);           /* overflow... */
+    return GNUNET_TIME_UNIT_FOREVER_ABS;
+  }
+  ret.abs_value_us = rel.rel_value_us + now.abs_value_us;
+  return ret;
+}
+
+
 /**
  * Return relative time of 0ms.
  */
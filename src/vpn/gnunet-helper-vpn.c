@@ -57,6 +57,15 @@
  */
 #define MAX_SIZE 65536
 
+/**
+ * How many frames do we batch (at most) into a single write towards
+ * the service?  Draining the TUN device into a larger buffer before
+ * writing cuts the number of syscalls per packet roughly by this
+ * factor under load; the service-side tokenizer handles the framing
+ * transparently.
+ */
+#define TUN_BATCH_FRAMES 8
+
 #ifndef _LINUX_IN6_H
 /**
  * This is in linux/include/net/ipv6.h, but not always exported...
@@ -337,9 +346,10 @@ static void
 run (int fd_tun)
 {
   /*
-   * The buffer filled by reading from fd_tun
+   * The buffer filled by reading from fd_tun; holds a batch of
+   * individually framed messages
    */
-  unsigned char buftun[MAX_SIZE];
+  unsigned char buftun[TUN_BATCH_FRAMES * MAX_SIZE];
   ssize_t buftun_size = 0;
   unsigned char *buftun_read = NULL;
 
@@ -360,6 +370,18 @@ run (int fd_tun)
   /* write refers to reading from stdin, writing to fd_tun */
   int write_open = 1;
 
+  /* we batch reads from the tun device, so both the device and our
+     stdout must be non-blocking; the message pump below already
+     handles partial writes */
+  if ( (-1 == fcntl (fd_tun, F_SETFL,
+                     O_NONBLOCK | fcntl (fd_tun, F_GETFL))) ||
+       (-1 == fcntl (1, F_SETFL,
+                     O_NONBLOCK | fcntl (1, F_GETFL))) )
+  {
+    fprintf (stderr, "fcntl failed: %s\n", strerror (errno));
+    exit (1);
+  }
+
   while ((1 == read_open) && (1 == write_open))
   {
     FD_ZERO (&fds_w);
@@ -407,42 +429,57 @@ run (int fd_tun)
     {
       if (FD_ISSET (fd_tun, &fds_r))
       {
-        buftun_size =
-            read (fd_tun, buftun + sizeof (struct GNUNET_MessageHeader),
-                  MAX_SIZE - sizeof (struct GNUNET_MessageHeader));
-        if (-1 == buftun_size)
-        {
-          fprintf (stderr,
-                   "read-error: %s\n",
-                   strerror (errno));
-          shutdown (fd_tun, SHUT_RD);
-          shutdown (1, SHUT_WR);
-          read_open = 0;
-          buftun_size = 0;
-        }
-        else if (0 == buftun_size)
+        /* pull as many frames as the device has ready (and as fit
+           into our buffer) before writing, framing each one */
+        while (buftun_size + MAX_SIZE <= (ssize_t) sizeof (buftun))
         {
-          fprintf (stderr, "EOF on tun\n");
-          shutdown (fd_tun, SHUT_RD);
-          shutdown (1, SHUT_WR);
-          read_open = 0;
-          buftun_size = 0;
-        }
-        else
-        {
-          buftun_read = buftun;
-          struct GNUNET_MessageHeader *hdr =
-              (struct GNUNET_MessageHeader *) buftun;
-          buftun_size += sizeof (struct GNUNET_MessageHeader);
+          struct GNUNET_MessageHeader *hdr;
+          ssize_t ret;
+
+          ret =
+              read (fd_tun,
+                    buftun + buftun_size + sizeof (struct GNUNET_MessageHeader),
+                    MAX_SIZE - sizeof (struct GNUNET_MessageHeader));
+          if (-1 == ret)
+          {
+            if ( (EAGAIN == errno) || (EWOULDBLOCK == errno) )
+              break;            /* batch complete */
+            fprintf (stderr,
+                     "read-error: %s\n",
+                     strerror (errno));
+            shutdown (fd_tun, SHUT_RD);
+            shutdown (1, SHUT_WR);
+            read_open = 0;
+            buftun_size = 0;
+            break;
+          }
+          if (0 == ret)
+          {
+            fprintf (stderr, "EOF on tun\n");
+            shutdown (fd_tun, SHUT_RD);
+            shutdown (1, SHUT_WR);
+            read_open = 0;
+            buftun_size = 0;
+            break;
+          }
+          hdr = (struct GNUNET_MessageHeader *) &buftun[buftun_size];
           hdr->type = htons (GNUNET_MESSAGE_TYPE_VPN_HELPER);
-          hdr->size = htons (buftun_size);
+          hdr->size = htons (ret + sizeof (struct GNUNET_MessageHeader));
+          buftun_size += ret + sizeof (struct GNUNET_MessageHeader);
         }
+        if (0 != buftun_size)
+          buftun_read = buftun;
       }
       else if (FD_ISSET (1, &fds_w))
       {
         ssize_t written = write (1, buftun_read, buftun_size);
 
-        if (-1 == written)
+        if ( (-1 == written) &&
+             ( (EAGAIN == errno) || (EWOULDBLOCK == errno) ) )
+        {
+          /* pipe full; keep the batch and try again later */
+        }
+        else if (-1 == written)
         {
 #if !DEBUG
 	  if (errno != EPIPE)
@@ -88,6 +88,20 @@ struct DestinationChannel
    */
   uint16_t destination_port;
 
+  /**
+   * Exit peer that last answered our REGEX search for this
+   * destination and port; only valid if @e have_exit_peer is
+   * #GNUNET_YES.
+   */
+  struct GNUNET_PeerIdentity exit_peer;
+
+  /**
+   * #GNUNET_YES if @e exit_peer is known, allowing us to resume
+   * channels to this destination without repeating the REGEX
+   * search in the DHT.
+   */
+  int have_exit_peer;
+
 };
 
 
@@ -393,6 +407,27 @@ static unsigned long long max_destination_mappings;
  */
 static unsigned long long max_channel_mappings;
 
+/**
+ * Destination entry of the most recent lookup from #message_token(),
+ * used to avoid hashing the destination IP for every packet of a
+ * flow.  Set to NULL whenever a destination entry is freed.
+ */
+static struct DestinationEntry *last_destination;
+
+/**
+ * Address family of the #last_destination lookup.
+ */
+static int last_destination_af;
+
+/**
+ * Destination IP of the #last_destination lookup.
+ */
+static union
+{
+  struct in_addr v4;
+  struct in6_addr v6;
+} last_destination_ip;
+
 
 /**
  * Compute the key under which we would store an entry in the
@@ -712,6 +747,33 @@ print_channel_destination (const struct DestinationEntry *de)
 }
 
 
+/**
+ * Find the `struct DestinationChannel` in the active destination map
+ * that matches the destination (copy) and destination port of the
+ * given channel state.
+ *
+ * @param ts channel state to find the destination channel for
+ * @return NULL if the destination is a service or no longer in the map
+ */
+static struct DestinationChannel *
+lookup_destination_channel (struct ChannelState *ts)
+{
+  struct DestinationEntry *de;
+  struct DestinationChannel *dt;
+
+  if (ts->destination.is_service)
+    return NULL;
+  de = GNUNET_CONTAINER_multihashmap_get (destination_map,
+					  &ts->destination.key);
+  if (NULL == de)
+    return NULL; /* destination expired */
+  for (dt = de->dt_head; NULL != dt; dt = dt->next)
+    if (dt->destination_port == ts->destination_port)
+      return dt;
+  return NULL;
+}
+
+
 /**
  * Regex has found a potential exit peer for us; consider using it.
  *
@@ -731,6 +793,7 @@ handle_regex_result (void *cls,
 		     unsigned int put_path_length)
 {
   struct ChannelState *ts = cls;
+  struct DestinationChannel *dt;
   unsigned int apptype;
 
   GNUNET_log (GNUNET_ERROR_TYPE_INFO,
@@ -760,6 +823,13 @@ handle_regex_result (void *cls,
                                              id,
                                              apptype,
                                              GNUNET_CADET_OPTION_DEFAULT);
+  /* remember the exit, so later channels to this destination can
+     skip the REGEX search and connect to it directly */
+  if (NULL != (dt = lookup_destination_channel (ts)))
+  {
+    dt->exit_peer = *id;
+    dt->have_exit_peer = GNUNET_YES;
+  }
 }
 
 
@@ -820,6 +890,30 @@ create_channel_to_destination (struct DestinationChannel *dt,
   {
     char *policy;
 
+    if (GNUNET_YES == dt->have_exit_peer)
+    {
+      /* we remember which exit served this destination last time;
+	 connect to it directly instead of searching again */
+      GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
+		  "Resuming channel to known exit %s\n",
+		  GNUNET_i2s (&dt->exit_peer));
+      GNUNET_STATISTICS_update (stats,
+				gettext_noop ("# Channels resumed to cached exit"),
+				1, GNUNET_NO);
+      ts->channel = GNUNET_CADET_channel_create (cadet_handle,
+						 ts,
+						 &dt->exit_peer,
+						 apptype,
+						 GNUNET_CADET_OPTION_DEFAULT);
+      if (NULL == ts->channel)
+      {
+	GNUNET_log (GNUNET_ERROR_TYPE_ERROR,
+		    _("Failed to setup cadet channel!\n"));
+	GNUNET_free (ts);
+	return NULL;
+      }
+      return ts;
+    }
     switch (dt->destination->details.exit_destination.af)
     {
     case AF_INET:
@@ -1009,6 +1103,11 @@ route_packet (struct DestinationEntry *destination,
 		(unsigned int) protocol);
     return;
   }
+  /* see if we have an existing channel for this flow; if so, we can
+     skip the destination channel resolution below entirely */
+  ts = GNUNET_CONTAINER_multihashmap_get (channel_map,
+					  &key);
+  dt = NULL;
   alen = 0;
   if (! destination->is_service)
   {
@@ -1023,7 +1122,10 @@ route_packet (struct DestinationEntry *destination,
     default:
       GNUNET_assert (0);
     }
-
+  }
+  if ( (NULL == ts) &&
+       (! destination->is_service) )
+  {
     {
       char sbuf[INET6_ADDRSTRLEN];
       char dbuf[INET6_ADDRSTRLEN];
@@ -1045,7 +1147,7 @@ route_packet (struct DestinationEntry *destination,
       if (dt->destination_port == destination_port)
 	break;
   }
-  else
+  else if (NULL == ts)
   {
     {
       char sbuf[INET6_ADDRSTRLEN];
@@ -1063,7 +1165,8 @@ route_packet (struct DestinationEntry *destination,
     }
     dt = destination->dt_head;
   }
-  if (NULL == dt)
+  if ( (NULL == ts) &&
+       (NULL == dt) )
   {
     dt = GNUNET_new (struct DestinationChannel);
     dt->destination = destination;
@@ -1073,9 +1176,6 @@ route_packet (struct DestinationEntry *destination,
     dt->destination_port = destination_port;
   }
 
-  /* see if we have an existing channel for this destination */
-  ts = GNUNET_CONTAINER_multihashmap_get (channel_map,
-					  &key);
   if (NULL == ts)
   {
     GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
@@ -1592,10 +1692,27 @@ message_token (void *cls,
         return GNUNET_OK;
       }
       pkt6 = (const struct GNUNET_TUN_IPv6Header *) &tun[1];
-      get_destination_key_from_ip (AF_INET6,
-				   &pkt6->destination_address,
-				   &key);
-      de = GNUNET_CONTAINER_multihashmap_get (destination_map, &key);
+      if ( (NULL != last_destination) &&
+	   (AF_INET6 == last_destination_af) &&
+	   (0 == memcmp (&pkt6->destination_address,
+			 &last_destination_ip.v6,
+			 sizeof (struct in6_addr))) )
+      {
+	de = last_destination;
+      }
+      else
+      {
+	get_destination_key_from_ip (AF_INET6,
+				     &pkt6->destination_address,
+				     &key);
+	de = GNUNET_CONTAINER_multihashmap_get (destination_map, &key);
+	if (NULL != de)
+	{
+	  last_destination = de;
+	  last_destination_af = AF_INET6;
+	  last_destination_ip.v6 = pkt6->destination_address;
+	}
+      }
       if (NULL == de)
       {
 	char buf[INET6_ADDRSTRLEN];
@@ -1628,10 +1745,26 @@ message_token (void *cls,
 	return GNUNET_OK;
       }
       pkt4 = (struct GNUNET_TUN_IPv4Header *) &tun[1];
-      get_destination_key_from_ip (AF_INET,
-				   &pkt4->destination_address,
-				   &key);
-      de = GNUNET_CONTAINER_multihashmap_get (destination_map, &key);
+      if ( (NULL != last_destination) &&
+	   (AF_INET == last_destination_af) &&
+	   (pkt4->destination_address.s_addr ==
+	    last_destination_ip.v4.s_addr) )
+      {
+	de = last_destination;
+      }
+      else
+      {
+	get_destination_key_from_ip (AF_INET,
+				     &pkt4->destination_address,
+				     &key);
+	de = GNUNET_CONTAINER_multihashmap_get (destination_map, &key);
+	if (NULL != de)
+	{
+	  last_destination = de;
+	  last_destination_af = AF_INET;
+	  last_destination_ip.v4 = pkt4->destination_address;
+	}
+      }
       if (NULL == de)
       {
 	char buf[INET_ADDRSTRLEN];
@@ -2487,6 +2620,8 @@ free_destination_entry (struct DestinationEntry *de)
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
 	      "Cleaning up destination entry `%s'\n",
               print_channel_destination (de));
+  if (de == last_destination)
+    last_destination = NULL;
   GNUNET_STATISTICS_update (stats,
 			    gettext_noop ("# Active destinations"),
 			    -1, GNUNET_NO);
@@ -2810,11 +2945,15 @@ channel_cleaner (void *cls,
                  void *channel_ctx)
 {
   struct ChannelState *ts = channel_ctx;
+  struct DestinationChannel *dt;
 
   ts->channel = NULL; /* we must not call GNUNET_CADET_channel_destroy() anymore */
   GNUNET_log (GNUNET_ERROR_TYPE_DEBUG,
 	      "CADET notified us about death of channel to `%s'\n",
               print_channel_destination (&ts->destination));
+  if ( (GNUNET_NO == ts->is_established) &&
+       (NULL != (dt = lookup_destination_channel (ts))) )
+    dt->have_exit_peer = GNUNET_NO; /* exit may be gone, search again next time */
   free_channel_state (ts);
 }
 